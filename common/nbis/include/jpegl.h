@@ -61,6 +61,12 @@ of the software.
 #include <nistcom.h>
 #endif
 
+/* Coder state kept between calls is per thread, so that different */
+/* images may be coded concurrently.                               */
+#ifndef NBIS_THREAD_LOCAL
+#define NBIS_THREAD_LOCAL __thread
+#endif
+
 /* JPEGL Marker Definitions */
 #define SOF3 0xffc3
 #define DHT  0xffc4
@@ -126,6 +126,8 @@ typedef struct wavlet_tree {
    int inv_cl;
 } W_TREE;
 #define W_TREELEN 20
+/* Largest reduction (1/2^n of each dimension) of wsq_decode_mem_reduced */
+#define WSQ_MAX_REDUCTION 4
 
 typedef struct quant_tree {
    short x;     /* UL corner of block */
@@ -186,13 +188,13 @@ typedef struct header_frm {
 
 /* External global variables. */
 extern int debug;
-extern QUANT_VALS quant_vals;
-extern W_TREE w_tree[];
-extern Q_TREE q_tree[];
-extern DTT_TABLE dtt_table;
-extern DQT_TABLE dqt_table;
-extern DHT_TABLE dht_table[];
-extern FRM_HEADER_WSQ frm_header_wsq;
+extern NBIS_THREAD_LOCAL QUANT_VALS quant_vals;
+extern NBIS_THREAD_LOCAL W_TREE w_tree[];
+extern NBIS_THREAD_LOCAL Q_TREE q_tree[];
+extern NBIS_THREAD_LOCAL DTT_TABLE dtt_table;
+extern NBIS_THREAD_LOCAL DQT_TABLE dqt_table;
+extern NBIS_THREAD_LOCAL DHT_TABLE dht_table[];
+extern NBIS_THREAD_LOCAL FRM_HEADER_WSQ frm_header_wsq;
 extern float hifilt[];
 extern float lofilt[];
 
@@ -216,6 +218,8 @@ extern int read_wsq_frame_header(unsigned char *, const int, int *, int *,
 /* decoder.c */
 extern int wsq_decode_mem(unsigned char **, int *, int *, int *, int *, int *,
                  unsigned char *, const int);
+extern int wsq_decode_mem_reduced(unsigned char **, int *, int *, int *,
+                 int *, int *, unsigned char *, const int, const int);
 extern int wsq_decode_file(unsigned char **, int *, int *, int *, int *,
                  int *, FILE *);
 extern int huffman_decode_data_mem(short *, DTT_TABLE *, DQT_TABLE *,
@@ -327,6 +331,8 @@ extern void get_lets(float *, float *, const int, const int, const int,
                  const int, float *, const int, float *, const int, const int);
 extern int wsq_reconstruct(float *, const int, const int,
                  W_TREE w_tree[], const int, const DTT_TABLE *);
+extern int wsq_reconstruct_node(float *, const int, const int,
+                 W_TREE w_tree[], const int, const DTT_TABLE *, const int);
 extern void  join_lets(float *, float *, const int, const int,
                  const int, const int, float *, const int,
                  float *, const int, const int);
@@ -348,7 +348,7 @@ int nextbits_jpegl(unsigned short *obits, FILE *infp,
                   int *bit_count, const int bits_req)
 {
    int ret;
-   static unsigned char code;    /*next byte of data*/
+   static NBIS_THREAD_LOCAL unsigned char code;    /*next byte of data*/
    unsigned char code2;
    unsigned short bits, tbits;   /*bits of current data byte requested*/
    int bits_needed;      /*additional bits required to finish request*/
@@ -400,7 +400,7 @@ int getc_nextbits_jpegl(unsigned short *obits, unsigned char **cbufptr,
                   unsigned char *ebufptr, int *bit_count, const int bits_req)
 {
    int ret;
-   static unsigned char code;    /*next byte of data*/
+   static NBIS_THREAD_LOCAL unsigned char code;    /*next byte of data*/
    unsigned char code2;
    unsigned short bits, tbits;   /*bits of current data byte requested*/
    int bits_needed;      /*additional bits required to finish request*/
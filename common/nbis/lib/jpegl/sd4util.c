@@ -335,7 +335,7 @@ static int getc_nextbits_jpegl_sd4(unsigned short *obits,
                   int *bit_count, const int bits_req)
 {
    int ret;
-   static unsigned char code;    /*next byte of data*/
+   static NBIS_THREAD_LOCAL unsigned char code;    /*next byte of data*/
    unsigned short bits, tbits;   /*bits of current data byte requested*/
    int bits_needed;      /*additional bits required to finish request*/
 
@@ -58,6 +58,9 @@ of the software.
 #cat: wsq_decode_mem - Decodes a datastream of WSQ compressed bytes
 #cat:                  from a memory buffer, returning a lossy
 #cat:                  reconstructed pixmap.
+#cat: wsq_decode_mem_reduced - Decodes a datastream of WSQ compressed
+#cat:                  bytes from a memory buffer, returning a lossy
+#cat:                  pixmap reconstructed at a reduced resolution.
 #cat: wsq_decode_file - Decodes a datastream of WSQ compressed bytes
 #cat:                  from an open file, returning a lossy
 #cat:                  reconstructed pixmap.
@@ -77,6 +80,7 @@ of the software.
 ***********************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 #include <wsq.h>
 #include <dataio.h>
 
@@ -92,7 +96,25 @@ of the software.
 int wsq_decode_mem(unsigned char **odata, int *ow, int *oh, int *od, int *oppi,
                    int *lossyflag, unsigned char *idata, const int ilen)
 {
+   return(wsq_decode_mem_reduced(odata, ow, oh, od, oppi, lossyflag,
+                                 idata, ilen, 0));
+}
+
+/***************************************************************************/
+/* WSQ reduced resolution decoder routine.  Takes an WSQ compressed memory */
+/* buffer and decodes it at 1/2^reduction of its size in each dimension    */
+/* (rounded up), by reconstructing only the lowpass subbands needed.       */
+/* reduction may be 0 (full size) through WSQ_MAX_REDUCTION.               */
+/***************************************************************************/
+int wsq_decode_mem_reduced(unsigned char **odata, int *ow, int *oh, int *od,
+                   int *oppi, int *lossyflag, unsigned char *idata,
+                   const int ilen, const int reduction)
+{
+   /* w_tree nodes whose regions hold the lowpass image at each reduction */
+   static const int lowpass_node[WSQ_MAX_REDUCTION + 1] = {0, 1, 14, 15, 19};
    int ret, i;
+   int node, rwidth, rheight, y;  /* reduced image parameters */
+   float lo_gain, scale;          /* lowpass DC gain of one 2D level */
    unsigned short marker;         /* WSQ marker */
    int num_pix;                   /* image size and counter */
    int width, height, ppi;        /* image parameters */
@@ -102,6 +124,13 @@ int wsq_decode_mem(unsigned char **odata, int *ow, int *oh, int *od, int *oppi,
    unsigned char *cbufptr;        /* points to current byte in buffer */
    unsigned char *ebufptr;        /* points to end of buffer */
 
+   if((reduction < 0) || (reduction > WSQ_MAX_REDUCTION)){
+      fprintf(stderr, "ERROR: wsq_decode_mem_reduced : ");
+      fprintf(stderr, "reduction %d not in [0..%d]\n", reduction,
+              WSQ_MAX_REDUCTION);
+      return(-22);
+   }
+
    /* Added by MDG on 02-24-05 */
    init_wsq_decoder_resources();
 
@@ -192,8 +221,9 @@ int wsq_decode_mem(unsigned char **odata, int *ow, int *oh, int *od, int *oppi,
    /* Done with quantized wavelet subband data. */
    free(qdata);
 
-   if((ret = wsq_reconstruct(fdata, width, height, w_tree, W_TREELEN,
-                              &dtt_table))){
+   node = lowpass_node[reduction];
+   if((ret = wsq_reconstruct_node(fdata, width, height, w_tree, W_TREELEN,
+                              &dtt_table, node))){
       free(fdata);
       free_wsq_decoder_resources();
       return(ret);
@@ -202,6 +232,30 @@ int wsq_decode_mem(unsigned char **odata, int *ow, int *oh, int *od, int *oppi,
    if(debug > 0)
       fprintf(stderr, "WSQ reconstruction of image finished\n\n");
 
+   if(reduction > 0){
+      /* Lowpass region is at the origin; pack its rows together. */
+      rwidth = w_tree[node].lenx;
+      rheight = w_tree[node].leny;
+      for(y = 1; y < rheight; y++)
+         memmove(fdata + (y * rwidth), fdata + (y * width),
+                 rwidth * sizeof(float));
+
+      /* Undo the DC gain of the lowpass filter at each level. */
+      lo_gain = 0.0;
+      for(i = 0; i < dtt_table.losz; i++)
+         lo_gain += dtt_table.lofilt[i];
+      lo_gain *= lo_gain;
+      scale = 1.0;
+      for(i = 0; i < reduction; i++)
+         scale /= lo_gain;
+      for(i = 0; i < rwidth * rheight; i++)
+         fdata[i] *= scale;
+
+      width = rwidth;
+      height = rheight;
+      num_pix = width * height;
+   }
+
    cdata = (unsigned char *)malloc(num_pix * sizeof(unsigned char));
    if(cdata == (unsigned char *)NULL) {
       free(fdata);
@@ -812,8 +866,8 @@ int nextbits_wsq(
    const int bits_req)  /* number of bits requested */
 {
    int ret;
-   static unsigned char code;   /*next byte of data*/
-   static unsigned char code2;  /*stuffed byte of data*/
+   static NBIS_THREAD_LOCAL unsigned char code;   /*next byte of data*/
+   static NBIS_THREAD_LOCAL unsigned char code2;  /*stuffed byte of data*/
    unsigned short bits, tbits;  /*bits of current data byte requested*/
    int bits_needed;     /*additional bits required to finish request*/
 
@@ -868,8 +922,8 @@ int getc_nextbits_wsq(
    const int bits_req)  /* number of bits requested */
 {
    int ret;
-   static unsigned char code;   /*next byte of data*/
-   static unsigned char code2;  /*stuffed byte of data*/
+   static NBIS_THREAD_LOCAL unsigned char code;   /*next byte of data*/
+   static NBIS_THREAD_LOCAL unsigned char code2;  /*stuffed byte of data*/
    unsigned short bits, tbits;  /*bits of current data byte requested*/
    int bits_needed;     /*additional bits required to finish request*/
 
@@ -62,33 +62,33 @@ of the software.
 int debug;
 */
 #ifdef TARGET_OS
-   QUANT_VALS quant_vals;
+   NBIS_THREAD_LOCAL QUANT_VALS quant_vals;
 
-   W_TREE w_tree[W_TREELEN];
+   NBIS_THREAD_LOCAL W_TREE w_tree[W_TREELEN];
 
-   Q_TREE q_tree[Q_TREELEN];
+   NBIS_THREAD_LOCAL Q_TREE q_tree[Q_TREELEN];
 
-   DTT_TABLE dtt_table;
+   NBIS_THREAD_LOCAL DTT_TABLE dtt_table;
 
-   DQT_TABLE dqt_table;
+   NBIS_THREAD_LOCAL DQT_TABLE dqt_table;
 
-   DHT_TABLE dht_table[MAX_DHT_TABLES];
+   NBIS_THREAD_LOCAL DHT_TABLE dht_table[MAX_DHT_TABLES];
 
-   FRM_HEADER_WSQ frm_header_wsq;
+   NBIS_THREAD_LOCAL FRM_HEADER_WSQ frm_header_wsq;
 #else
-   QUANT_VALS quant_vals = {0};
+   NBIS_THREAD_LOCAL QUANT_VALS quant_vals = {0};
 
-   W_TREE w_tree[W_TREELEN] = {{0}};
+   NBIS_THREAD_LOCAL W_TREE w_tree[W_TREELEN] = {{0}};
 
-   Q_TREE q_tree[Q_TREELEN] = {{0}};
+   NBIS_THREAD_LOCAL Q_TREE q_tree[Q_TREELEN] = {{0}};
 
-   DTT_TABLE dtt_table = {NULL};
+   NBIS_THREAD_LOCAL DTT_TABLE dtt_table = {NULL};
 
-   DQT_TABLE dqt_table = {0};
+   NBIS_THREAD_LOCAL DQT_TABLE dqt_table = {0};
 
-   DHT_TABLE dht_table[MAX_DHT_TABLES] = {{0}};
+   NBIS_THREAD_LOCAL DHT_TABLE dht_table[MAX_DHT_TABLES] = {{0}};
 
-   FRM_HEADER_WSQ frm_header_wsq = {0};
+   NBIS_THREAD_LOCAL FRM_HEADER_WSQ frm_header_wsq = {0};
 #endif
 
 #ifdef FILTBANK_EVEN_8X8_1
@@ -76,6 +76,8 @@ of the software.
 #cat:
 #cat: wsq_reconstruct - Reconstructs a lossy floating point pixmap from
 #cat:                  a WSQ compressed datastream.
+#cat: wsq_reconstruct_node - Reconstructs the subbands of a WSQ
+#cat:                  decomposition up to a given w_tree node.
 #cat: join_lets - Reconstruct the image from the wavelet subbands.
 #cat:
 #cat: int_sign - Get the sign of the sythesis filter coefficients.
@@ -889,6 +891,19 @@ void get_lets(
 int wsq_reconstruct(float *fdata, const int width, const int height,
                   W_TREE w_tree[], const int w_treelen,
                   const DTT_TABLE *dtt_table)
+{
+   return(wsq_reconstruct_node(fdata, width, height, w_tree, w_treelen,
+                               dtt_table, 0));
+}
+
+/****************************************************************/
+/* Reconstruct the subbands of w_tree nodes w_treelen - 1 down  */
+/* to last_node.  The region of last_node then holds its        */
+/* lowpass image.                                               */
+/****************************************************************/
+int wsq_reconstruct_node(float *fdata, const int width, const int height,
+                  W_TREE w_tree[], const int w_treelen,
+                  const DTT_TABLE *dtt_table, const int last_node)
 {
    int num_pix, node;
    float *fdata1, *fdata_bse;
@@ -912,7 +927,7 @@ int wsq_reconstruct(float *fdata, const int width, const int height,
    }
 
    /* Reconstruct floating point pixmap from wavelet subband data. */
-   for (node = w_treelen - 1; node >= 0; node--) {
+   for (node = w_treelen - 1; node >= last_node; node--) {
       fdata_bse = fdata + (w_tree[node].y * width) + w_tree[node].x;
       join_lets(fdata1, fdata_bse, w_tree[node].lenx, w_tree[node].leny,
                   1, width,
@@ -122,7 +122,7 @@ namespace BiometricEvaluation
 			 */
 			static std::set<int>
 			recordLocations(
-			    Memory::uint8Array &buf,
+			    const Memory::ByteView &buf,
 			    const View::AN2KView::RecordType recordType);
 			    
 			/**
@@ -173,7 +173,7 @@ namespace BiometricEvaluation
 			 *	record.
 			 */
 			AN2KRecord(
-			    Memory::uint8Array &buf);
+			    const Memory::ByteView &buf);
 
 			/**
 			 * @return
@@ -355,8 +355,8 @@ namespace BiometricEvaluation
 			 * @param[in] buf
 			 *	AN2K buffer.
 			 */
-			void readAN2KRecord(Memory::uint8Array &buf);
-			void readType1Record(Memory::uint8Array &buf);
+			void readAN2KRecord(const Memory::ByteView &buf);
+			void readType1Record(const Memory::ByteView &buf);
 			    
 			/**
 			 * @brief
@@ -365,9 +365,9 @@ namespace BiometricEvaluation
 			 * @param[in] buf
 			 *	AN2K buffer.
 			 */
-    			void readMinutiaeData(Memory::uint8Array &buf);
-			void readFingerCaptures(Memory::uint8Array &buf);
-			void readFingerLatents(Memory::uint8Array &buf);
+    			void readMinutiaeData(const Memory::ByteView &buf);
+			void readFingerCaptures(const Memory::ByteView &buf);
+			void readFingerLatents(const Memory::ByteView &buf);
 		};
 	}
 }
@@ -17,6 +17,7 @@
 #include <be_feature_minutiae.h>
 #include <be_finger.h>
 #include <be_memory_autoarray.h>
+#include <be_memory_byteview.h>
 
 namespace BiometricEvaluation 
 {
@@ -200,7 +201,7 @@ namespace BiometricEvaluation
 			 *	for the requested number.
 			 */
 			AN2K7Minutiae(
-			    Memory::uint8Array &buf,
+			    const Memory::ByteView &buf,
 			    int recordNumber);
 
 			/**
@@ -259,7 +260,7 @@ namespace BiometricEvaluation
 		protected:
 		private:
 			void readType9Record(
-			    Memory::uint8Array &buf,
+			    const Memory::ByteView &buf,
     			    int recordNumber);
 
 			MinutiaPointSet _minutiaPointSet;
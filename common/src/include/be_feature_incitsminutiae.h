@@ -52,6 +52,7 @@ namespace BiometricEvaluation
 			 */
 			static const uint32_t FED_HEADER_LENGTH = 4;
 			static const uint32_t FED_RCD_ITEM_LENGTH = 3;
+			static const uint32_t FMD_ITEM_LENGTH = 6;
 
 			/*
 			 * Define the masks for the minutia type and x/y
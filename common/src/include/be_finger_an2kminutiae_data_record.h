@@ -16,6 +16,7 @@
 
 #include <be_feature_an2k7minutiae.h>
 #include <be_memory_autoarray.h>
+#include <be_memory_byteview.h>
 
 /* an2k.h forward declares */
 struct record;
@@ -83,7 +84,7 @@ namespace BiometricEvaluation {
 			 *	for the requested number.
 			 */
 			AN2KMinutiaeDataRecord(
-			    Memory::uint8Array &buf,
+			    const Memory::ByteView &buf,
 			    int recordNumber);
 		
 			/**
@@ -159,7 +160,7 @@ namespace BiometricEvaluation {
 			 */
 			void
 			readType9Record(
-			    Memory::uint8Array &buf,
+			    const Memory::ByteView &buf,
 			    int recordNumber);
 			
 			/**
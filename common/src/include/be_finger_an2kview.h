@@ -173,7 +173,7 @@ namespace BiometricEvaluation
 			 *	An error occurred when parsing the AN2K record.
 			 */
 			AN2KView(
-			    Memory::uint8Array &buf,
+			    const Memory::ByteView &buf,
 			    const RecordType typeID,
 			    const uint32_t recordNumber);
 
@@ -155,7 +155,7 @@ namespace BiometricEvaluation
 			 * just the finger image and/or minutiae records.
 			 */
 			AN2KViewCapture(
-			    Memory::uint8Array &buf,
+			    const Memory::ByteView &buf,
 			    const uint32_t recordNumber);
 
 			/**
@@ -40,7 +40,7 @@ namespace BiometricEvaluation
 			 * just the finger image and/or minutiae records.
 			 */
 			AN2KViewLatent(
-			    Memory::uint8Array &buf,
+			    const Memory::ByteView &buf,
 			    const uint32_t recordNumber);
 
 			/**
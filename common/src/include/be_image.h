@@ -42,7 +42,8 @@ namespace BiometricEvaluation
 			JP2L		= 6,
 			PNG		= 7,
 			NetPBM		= 8,
-			BMP		= 9
+			BMP		= 9,
+			TiledRaw	= 10
 		};
 
 		/** Image pixel formats. */
@@ -55,7 +56,11 @@ namespace BiometricEvaluation
 			/** 8-bit gray */
 			Gray8		= 2,
 			/** 8-bit red/8-bit blue/8-bit green */
-			RGB24		= 3
+			RGB24		= 3,
+			/** 16-bit gray, in native byte order */
+			Gray16		= 4,
+			/** As returned by Image::Image::getRawData() */
+			Native		= 5
 		};
 
 		/**
@@ -263,6 +268,27 @@ namespace BiometricEvaluation
 		};
 		using Resolution = struct Resolution;
 
+		/**
+		 * @brief
+		 * Properties of an image, as described by its header.
+		 */
+		struct Properties {
+			/** Compression algorithm of the image data */
+			CompressionAlgorithm compressionAlgorithm{
+			    CompressionAlgorithm::None};
+			/** Dimensions of the image, in pixels */
+			Size dimensions{};
+			/** Bits in one pixel */
+			uint32_t colorDepth{0};
+			/** Bits in one component of a pixel */
+			uint16_t bitDepth{0};
+			/** Resolution of the image */
+			Resolution resolution{};
+			/** Whether or not the image has an alpha channel */
+			bool hasAlphaChannel{false};
+		};
+		using Properties = struct Properties;
+
 		/** Number of centimeters in one inch */
 		const double CentimetersPerInch = 2.54;
 		/** Number of millimeters in one inch */
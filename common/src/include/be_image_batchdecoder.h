@@ -0,0 +1,314 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_IMAGE_BATCHDECODER_H__
+#define __BE_IMAGE_BATCHDECODER_H__
+
+#include <pthread.h>
+
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <be_image.h>
+#include <be_io_recordstore.h>
+#include <be_memory_autoarray.h>
+#include <be_memory_byteview.h>
+
+namespace BiometricEvaluation
+{
+	namespace Image
+	{
+		/**
+		 * @brief
+		 * Decode many images concurrently.
+		 * @details
+		 * Images are added as buffers, files, or RecordStore
+		 * keys, and decoded by a pool of threads into the
+		 * format of Image::getRawData(). Results are returned
+		 * by next(), in the order images were added or as they
+		 * complete.
+		 *
+		 * Memory is bounded: a thread starts decoding only
+		 * while fewer than the pending limit of images are
+		 * being decoded or waiting to be returned.
+		 *
+		 * Codecs keep their state per call or per thread, so
+		 * images of any format are decoded in parallel.
+		 *
+		 * @note
+		 * add(), close(), and next() may be called from
+		 * different threads.
+		 */
+		class BatchDecoder
+		{
+		public:
+			/** Order in which results are returned */
+			enum class Order
+			{
+				/** Order in which images were added */
+				Submission,
+				/** Order in which decoding finished */
+				Completion
+			};
+
+			/** A decoded image */
+			struct Result
+			{
+				/** Number of the image, counting from 0 */
+				uint64_t index{0};
+				/** Path or key of the image, if any */
+				std::string name{};
+				/** Properties of the image */
+				Properties properties{};
+				/**
+				 * Decoded data, as Image::getRawData(), or
+				 * Image::getReducedRawData() when decoding
+				 * at a reduced resolution.
+				 */
+				Memory::uint8Array rawData{};
+				/**
+				 * Exception raised opening or decoding the
+				 * image, nullptr on success.
+				 */
+				std::exception_ptr error{};
+			};
+
+			/**
+			 * @brief
+			 * Constructor.
+			 *
+			 * @param[in] threads
+			 *	Number of decoding threads, or 0 for
+			 *	System::getCPUCount().
+			 * @param[in] maxPending
+			 *	Most images being decoded or waiting to be
+			 *	returned, or 0 for twice threads.
+			 * @param[in] order
+			 *	Order in which results are returned.
+			 * @param[in] scaleDenominator
+			 *	Decode with Image::getReducedRawData() when
+			 *	not 1.
+			 *
+			 * @throw Error::ParameterError
+			 *	Invalid scaleDenominator.
+			 * @throw Error::StrategyError
+			 *	Could not start a thread.
+			 */
+			BatchDecoder(
+			    uint32_t threads = 0,
+			    uint32_t maxPending = 0,
+			    Order order = Order::Submission,
+			    uint8_t scaleDenominator = 1);
+
+			/**
+			 * @brief
+			 * Destructor.
+			 * @details
+			 * Images not yet decoded are abandoned, and
+			 * decodes in progress are allowed to finish.
+			 */
+			~BatchDecoder();
+
+			/**
+			 * @brief
+			 * Add an image held by the caller.
+			 *
+			 * @param[in] data
+			 *	Image data, which must remain valid until
+			 *	its result is returned.
+			 *
+			 * @return
+			 *	Index of the image.
+			 *
+			 * @throw Error::StrategyError
+			 *	close() was called.
+			 */
+			uint64_t
+			add(
+			    const Memory::ByteView &data);
+
+			/**
+			 * @brief
+			 * Add an image file.
+			 * @details
+			 * The file is read by the decoding thread.
+			 *
+			 * @param[in] path
+			 *	Path to the image file.
+			 *
+			 * @return
+			 *	Index of the image.
+			 *
+			 * @throw Error::StrategyError
+			 *	close() was called.
+			 */
+			uint64_t
+			add(
+			    const std::string &path);
+
+			/**
+			 * @brief
+			 * Add an image stored in a RecordStore.
+			 * @details
+			 * Records are read by the decoding threads, one at
+			 * a time, so recordStore must not be used by other
+			 * threads until its results are returned.
+			 *
+			 * @param[in] recordStore
+			 *	RecordStore holding the image.
+			 * @param[in] key
+			 *	Key of the image.
+			 *
+			 * @return
+			 *	Index of the image.
+			 *
+			 * @throw Error::StrategyError
+			 *	close() was called.
+			 */
+			uint64_t
+			add(
+			    const std::shared_ptr<IO::RecordStore> &recordStore,
+			    const std::string &key);
+
+			/**
+			 * @brief
+			 * Indicate that no more images will be added.
+			 * @details
+			 * next() returns false once every result has been
+			 * returned.
+			 */
+			void
+			close();
+
+			/**
+			 * @brief
+			 * Obtain the next result.
+			 * @details
+			 * Blocks until a result is available.
+			 *
+			 * @param[out] result
+			 *	The next result.
+			 *
+			 * @return
+			 *	true if result was set, false if close() was
+			 *	called and every result has been returned.
+			 */
+			bool
+			next(
+			    Result &result);
+
+			/** @return Number of decoding threads */
+			uint32_t
+			getThreadCount()
+			    const;
+
+			/* Threads may not be duplicated */
+			BatchDecoder(const BatchDecoder&) = delete;
+			BatchDecoder& operator=(const BatchDecoder&) = delete;
+
+		private:
+			/** An image waiting to be decoded */
+			struct Source
+			{
+				uint64_t index;
+				Memory::ByteView data;
+				std::string path;
+				std::shared_ptr<IO::RecordStore> recordStore;
+			};
+
+			/**
+			 * @brief
+			 * Queue an image.
+			 *
+			 * @param[in] source
+			 *	Image to queue, index is assigned.
+			 *
+			 * @return
+			 *	Index of the image.
+			 */
+			uint64_t
+			enqueue(
+			    Source &&source);
+
+			/**
+			 * @brief
+			 * Open and decode one image.
+			 *
+			 * @param[in] source
+			 *	Image to decode.
+			 *
+			 * @return
+			 *	Result of decoding source.
+			 */
+			Result
+			decode(
+			    const Source &source);
+
+			/**
+			 * @brief
+			 * Discard queued images and join the decoding
+			 * threads.
+			 */
+			void
+			stopThreads();
+
+			/** Loop run by each decoding thread */
+			void
+			work();
+
+			/** pthread entry point, arg is the BatchDecoder */
+			static void*
+			worker(
+			    void *arg);
+
+			/** Order in which results are returned */
+			const Order _order;
+			/** Decode at a reduced resolution when not 1 */
+			const uint8_t _scaleDenominator;
+			/** Most images decoding or waiting to be returned */
+			uint32_t _maxPending;
+
+			/** Decoding threads */
+			std::vector<pthread_t> _threads;
+			/** Serializes reads from RecordStores */
+			pthread_mutex_t _readMutex;
+			/** Guards all members below */
+			pthread_mutex_t _mutex;
+			/** Signaled when a worker may take a source */
+			pthread_cond_t _work;
+			/** Signaled when a result is stored */
+			pthread_cond_t _done;
+
+			/** Images waiting to be decoded */
+			std::deque<Source> _sources;
+			/** Results waiting to be returned, by index */
+			std::map<uint64_t, Result> _results;
+			/** Index of the next image added */
+			uint64_t _added;
+			/** Index of the next result in Submission order */
+			uint64_t _nextIndex;
+			/** Images being decoded or waiting to be returned */
+			uint32_t _pending;
+			/** Results returned by next() */
+			uint64_t _returned;
+			/** Whether or not close() was called */
+			bool _closed;
+			/** Whether or not threads should exit */
+			bool _stop;
+		};
+	}
+}
+
+#endif /* __BE_IMAGE_BATCHDECODER_H__ */
@@ -36,12 +36,12 @@ namespace BiometricEvaluation
 			BMP(
 			    const Memory::uint8Array &data);
 
+			/** data is referenced, not copied, by the object */
+			explicit BMP(
+			    const Memory::ByteView &data);
+
 			~BMP() = default;
 
-			Memory::AutoArray<uint8_t>
-			getRawData()
-			    const;
-			    
 			Memory::AutoArray<uint8_t>
 			getRawGrayscaleData(
 			    uint8_t depth)
@@ -63,7 +63,29 @@ namespace BiometricEvaluation
 			isBMP(
 			    const uint8_t *data,
 			    uint64_t size);
+
+			/** @return Whether the bitmap is uncompressed */
+			bool
+			decodesRegions()
+			    const;
+
 		protected:
+			Memory::uint8Array
+			decodeRawData()
+			    const;
+
+			/**
+			 * @brief
+			 * Decode a rectangle of the image data.
+			 * @details
+			 * Rows of uncompressed bitmaps are located directly;
+			 * RLE bitmaps are decoded in full.
+			 */
+			Memory::uint8Array
+			decodeRawRegion(
+			    const Coordinate &origin,
+			    const Size &size)
+			    const;
 
 		private:
 			/** Bitmap File Header */
@@ -0,0 +1,281 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_IMAGE_CONVERSION_H__
+#define __BE_IMAGE_CONVERSION_H__
+
+#include <cstdint>
+#include <vector>
+
+#include <be_framework_enumeration.h>
+
+namespace BiometricEvaluation
+{
+	namespace Image
+	{
+		/**
+		 * @brief
+		 * Pixel conversion kernels used on decoded image data.
+		 * @details
+		 * Each kernel has a portable implementation and, on x86-64,
+		 * SSE4.1 and AVX2 implementations chosen when the library is
+		 * first used, based on what the processor supports. All
+		 * implementations produce identical output.
+		 *
+		 * 16-bit samples are read and written in native byte order,
+		 * as Image::getRawData() returns them. Color kernels take
+		 * three- or four-channel pixels, ignoring the fourth (alpha)
+		 * channel, and weight channels with the ITU-R BT.601
+		 * luma coefficients.
+		 */
+		namespace Conversion
+		{
+			/** Instruction sets kernels may use */
+			enum class Instructions
+			{
+				/** Portable C++ */
+				Scalar,
+				/** SSE4.1 */
+				SSE41,
+				/** AVX2 */
+				AVX2
+			};
+
+			/** @return Instructions kernels currently use */
+			Instructions
+			getInstructions();
+
+			/**
+			 * @brief
+			 * Change the instructions kernels use.
+			 * @details
+			 * Intended for testing and benchmarking. Requests
+			 * for instructions the processor does not support
+			 * are lowered to the best that it does.
+			 *
+			 * @param[in] instructions
+			 *	Instructions to use.
+			 *
+			 * @return
+			 *	Instructions that will be used.
+			 */
+			Instructions
+			setInstructions(
+			    Instructions instructions);
+
+			/** @return Best instructions the processor supports */
+			Instructions
+			getSupportedInstructions();
+
+			/**
+			 * @brief
+			 * Convert 8-bit color to 8-bit grayscale.
+			 *
+			 * @param[in] in
+			 *	pixels * channels samples.
+			 * @param[out] out
+			 *	pixels samples.
+			 * @param[in] pixels
+			 *	Number of pixels.
+			 * @param[in] channels
+			 *	3 (RGB) or 4 (RGBA).
+			 *
+			 * @throw Error::ParameterError
+			 *	Invalid channels.
+			 */
+			void
+			colorToGray8(
+			    const uint8_t *in,
+			    uint8_t *out,
+			    uint64_t pixels,
+			    uint8_t channels);
+
+			/**
+			 * @brief
+			 * Convert 8-bit color to 16-bit grayscale.
+			 *
+			 * @param[in] in
+			 *	pixels * channels samples.
+			 * @param[out] out
+			 *	pixels 16-bit samples.
+			 * @param[in] pixels
+			 *	Number of pixels.
+			 * @param[in] channels
+			 *	3 (RGB) or 4 (RGBA).
+			 *
+			 * @throw Error::ParameterError
+			 *	Invalid channels.
+			 */
+			void
+			colorToGray16(
+			    const uint8_t *in,
+			    uint8_t *out,
+			    uint64_t pixels,
+			    uint8_t channels);
+
+			/**
+			 * @brief
+			 * Convert 16-bit color to 8-bit grayscale.
+			 *
+			 * @param[in] in
+			 *	pixels * channels 16-bit samples.
+			 * @param[out] out
+			 *	pixels samples.
+			 * @param[in] pixels
+			 *	Number of pixels.
+			 * @param[in] channels
+			 *	3 (RGB) or 4 (RGBA).
+			 *
+			 * @throw Error::ParameterError
+			 *	Invalid channels.
+			 */
+			void
+			color16ToGray8(
+			    const uint8_t *in,
+			    uint8_t *out,
+			    uint64_t pixels,
+			    uint8_t channels);
+
+			/**
+			 * @brief
+			 * Convert 16-bit color to 16-bit grayscale.
+			 *
+			 * @param[in] in
+			 *	pixels * channels 16-bit samples.
+			 * @param[out] out
+			 *	pixels 16-bit samples.
+			 * @param[in] pixels
+			 *	Number of pixels.
+			 * @param[in] channels
+			 *	3 (RGB) or 4 (RGBA).
+			 *
+			 * @throw Error::ParameterError
+			 *	Invalid channels.
+			 */
+			void
+			color16ToGray16(
+			    const uint8_t *in,
+			    uint8_t *out,
+			    uint64_t pixels,
+			    uint8_t channels);
+
+			/**
+			 * @brief
+			 * Rescale 8-bit samples to 16 bits.
+			 *
+			 * @param[in] in
+			 *	count samples.
+			 * @param[out] out
+			 *	count 16-bit samples.
+			 * @param[in] count
+			 *	Number of samples.
+			 */
+			void
+			rescale8To16(
+			    const uint8_t *in,
+			    uint8_t *out,
+			    uint64_t count);
+
+			/**
+			 * @brief
+			 * Rescale 16-bit samples to 8 bits.
+			 *
+			 * @param[in] in
+			 *	count 16-bit samples.
+			 * @param[out] out
+			 *	count samples.
+			 * @param[in] count
+			 *	Number of samples.
+			 */
+			void
+			rescale16To8(
+			    const uint8_t *in,
+			    uint8_t *out,
+			    uint64_t count);
+
+			/**
+			 * @brief
+			 * Quantize 8-bit samples to black and white.
+			 * @details
+			 * Samples up to 127 become 0x00, the rest 0xFF.
+			 *
+			 * @param[in,out] data
+			 *	count samples.
+			 * @param[in] count
+			 *	Number of samples.
+			 */
+			void
+			threshold(
+			    uint8_t *data,
+			    uint64_t count);
+
+			/**
+			 * @brief
+			 * Interleave planes of 32-bit samples into pixels.
+			 * @details
+			 * Used for codecs, such as OpenJPEG, that decode
+			 * each component into its own plane of int32_t.
+			 *
+			 * @param[in] planes
+			 *	planeCount pointers to count samples each.
+			 * @param[in] planeCount
+			 *	Number of planes, and so of samples per
+			 *	pixel.
+			 * @param[out] out
+			 *	count * planeCount samples of sampleSize
+			 *	bytes, in native byte order.
+			 * @param[in] count
+			 *	Number of pixels.
+			 * @param[in] sampleSize
+			 *	Bytes per output sample: 1 or 2.
+			 * @param[in] mask
+			 *	Mask applied to each sample, such as
+			 *	(1 << precision) - 1.
+			 *
+			 * @throw Error::ParameterError
+			 *	Invalid sampleSize.
+			 */
+			void
+			interleave(
+			    const int32_t *const *planes,
+			    uint8_t planeCount,
+			    uint8_t *out,
+			    uint64_t count,
+			    uint8_t sampleSize,
+			    uint32_t mask);
+
+			/**
+			 * @brief
+			 * Copy pixels without some of their components.
+			 *
+			 * @param[in] in
+			 *	pixels * components.size() components.
+			 * @param[out] out
+			 *	Space for the kept components.
+			 * @param[in] pixels
+			 *	Number of pixels.
+			 * @param[in] componentSize
+			 *	Bytes per component.
+			 * @param[in] components
+			 *	Components of a pixel, true for those to
+			 *	remove.
+			 */
+			void
+			removeComponents(
+			    const uint8_t *in,
+			    uint8_t *out,
+			    uint64_t pixels,
+			    uint8_t componentSize,
+			    const std::vector<bool> &components);
+		}
+	}
+}
+
+#endif /* __BE_IMAGE_CONVERSION_H__ */
@@ -0,0 +1,354 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_IMAGE_ENCODER_H__
+#define __BE_IMAGE_ENCODER_H__
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <be_image.h>
+#include <be_image_image.h>
+#include <be_io_recordstore.h>
+#include <be_memory_autoarray.h>
+#include <be_memory_byteview.h>
+
+namespace BiometricEvaluation
+{
+	namespace Image
+	{
+		/**
+		 * @brief
+		 * Encode raw pixels into a compressed image format.
+		 * @details
+		 * Encoders are obtained from openEncoder() and take
+		 * pixels in the format of Image::getRawData(). Encoded
+		 * data can be opened again with Image::openImage().
+		 *
+		 * An Encoder holds no state between calls, so one
+		 * Encoder may be used by several threads at once.
+		 */
+		class Encoder
+		{
+		public:
+			/**
+			 * @brief
+			 * Tunable encoder settings.
+			 * @details
+			 * Each encoder uses only the settings that apply
+			 * to its format.
+			 */
+			struct Settings
+			{
+				/** JPEG quality, 1 (worst) to 100 (best) */
+				uint8_t quality{90};
+				/**
+				 * PNG zlib compression level, 0 (fastest)
+				 * to 9 (smallest), or -1 for the zlib
+				 * default.
+				 */
+				int8_t compressionLevel{-1};
+				/** WSQ bit rate, in bits per pixel */
+				float bitRate{0.75};
+				/** Lossy JPEG 2000 compression ratio */
+				float compressionRatio{10};
+				/**
+				 * Threads used to encode one JPEG 2000
+				 * image, or 0 for System::getCPUCount()
+				 * (1 when images are encoded in parallel).
+				 * Ignored by OpenJPEG older than 2.3.
+				 */
+				uint32_t threads{1};
+			};
+			using Settings = struct Settings;
+
+			/**
+			 * @brief
+			 * Obtain an encoder.
+			 *
+			 * @param[in] compressionAlgorithm
+			 *	Format to encode: PNG, JPEGB, JP2, JP2L
+			 *	(lossless JPEG 2000), or WSQ20.
+			 * @param[in] settings
+			 *	Settings for the encoder.
+			 *
+			 * @return
+			 *	Encoder for compressionAlgorithm.
+			 *
+			 * @throw Error::NotImplemented
+			 *	compressionAlgorithm cannot be encoded.
+			 * @throw Error::ParameterError
+			 *	Invalid value in settings.
+			 */
+			static std::shared_ptr<Encoder>
+			openEncoder(
+			    CompressionAlgorithm compressionAlgorithm,
+			    const Settings &settings);
+
+			/**
+			 * @brief
+			 * Obtain an encoder with default settings.
+			 *
+			 * @param[in] compressionAlgorithm
+			 *	Format to encode: PNG, JPEGB, JP2, JP2L
+			 *	(lossless JPEG 2000), or WSQ20.
+			 *
+			 * @return
+			 *	Encoder for compressionAlgorithm.
+			 *
+			 * @throw Error::NotImplemented
+			 *	compressionAlgorithm cannot be encoded.
+			 */
+			static std::shared_ptr<Encoder>
+			openEncoder(
+			    CompressionAlgorithm compressionAlgorithm);
+
+			virtual ~Encoder() = default;
+
+			/** @return Format produced by this encoder */
+			CompressionAlgorithm
+			getCompressionAlgorithm()
+			    const;
+
+			/** @return Settings used by this encoder */
+			Settings
+			getSettings()
+			    const;
+
+			/**
+			 * @brief
+			 * Encode raw pixels.
+			 *
+			 * @param[in] rawData
+			 *	Pixels in the format of Image::getRawData().
+			 * @param[in] properties
+			 *	Description of rawData. compressionAlgorithm
+			 *	is ignored.
+			 *
+			 * @return
+			 *	Encoded image.
+			 *
+			 * @throw Error::ParameterError
+			 *	rawData is too small for properties, or
+			 *	this format cannot hold such pixels.
+			 * @throw Error::StrategyError
+			 *	Error encoding.
+			 */
+			Memory::uint8Array
+			encode(
+			    const Memory::ByteView &rawData,
+			    const Properties &properties)
+			    const;
+
+			/**
+			 * @brief
+			 * Encode an image.
+			 * @details
+			 * Pixels are converted when this format cannot hold
+			 * the image's pixels, such as color to grayscale
+			 * for WSQ.
+			 *
+			 * @param[in] image
+			 *	Image to encode.
+			 *
+			 * @return
+			 *	Encoded image.
+			 *
+			 * @throw Error::NotImplemented
+			 *	The image cannot be converted to pixels
+			 *	this format can hold.
+			 * @throw Error::DataError
+			 *	Error decoding image.
+			 * @throw Error::StrategyError
+			 *	Error encoding.
+			 */
+			Memory::uint8Array
+			encode(
+			    const Image &image)
+			    const;
+
+			/**
+			 * @brief
+			 * Encode an image into a RecordStore.
+			 *
+			 * @param[in] image
+			 *	Image to encode.
+			 * @param[in] recordStore
+			 *	RecordStore to hold the encoded image.
+			 * @param[in] key
+			 *	Key of the encoded image.
+			 *
+			 * @throw Error::ObjectExists
+			 *	key is already in recordStore.
+			 * @throw Error::StrategyError
+			 *	Error encoding, or error inserting into
+			 *	recordStore.
+			 */
+			void
+			encode(
+			    const Image &image,
+			    IO::RecordStore &recordStore,
+			    const std::string &key)
+			    const;
+
+			/**
+			 * @brief
+			 * Encode many images in parallel.
+			 *
+			 * @param[in] images
+			 *	Images to encode.
+			 * @param[in] threads
+			 *	Number of encoding threads, or 0 for
+			 *	System::getCPUCount().
+			 *
+			 * @return
+			 *	Encoded images, in the order of images.
+			 *
+			 * @throw Error::Exception
+			 *	The first exception thrown while encoding,
+			 *	after all threads have finished.
+			 */
+			std::vector<Memory::uint8Array>
+			encode(
+			    const std::vector<std::shared_ptr<Image>> &images,
+			    uint32_t threads = 0)
+			    const;
+
+			/**
+			 * @brief
+			 * Encode many images into a RecordStore in
+			 * parallel.
+			 * @details
+			 * Encoded images are inserted as they complete, so
+			 * at most one encoded image per thread is held in
+			 * memory. Inserts are serialized.
+			 *
+			 * @param[in] images
+			 *	Images to encode.
+			 * @param[in] keys
+			 *	Key of each encoded image.
+			 * @param[in] recordStore
+			 *	RecordStore to hold the encoded images.
+			 * @param[in] threads
+			 *	Number of encoding threads, or 0 for
+			 *	System::getCPUCount().
+			 *
+			 * @throw Error::ParameterError
+			 *	images and keys differ in size.
+			 * @throw Error::Exception
+			 *	The first exception thrown while encoding
+			 *	or inserting, after all threads have
+			 *	finished.
+			 */
+			void
+			encode(
+			    const std::vector<std::shared_ptr<Image>> &images,
+			    const std::vector<std::string> &keys,
+			    IO::RecordStore &recordStore,
+			    uint32_t threads = 0)
+			    const;
+
+		protected:
+			/**
+			 * @brief
+			 * Constructor.
+			 *
+			 * @param[in] compressionAlgorithm
+			 *	Format produced by this encoder.
+			 * @param[in] settings
+			 *	Settings for the encoder.
+			 */
+			Encoder(
+			    CompressionAlgorithm compressionAlgorithm,
+			    const Settings &settings);
+
+			/**
+			 * @brief
+			 * Encode raw pixels.
+			 *
+			 * @param[in] rawData
+			 *	Pixels in the format of Image::getRawData(),
+			 *	at least as large as properties requires.
+			 * @param[in] properties
+			 *	Description of rawData.
+			 *
+			 * @return
+			 *	Encoded image.
+			 *
+			 * @throw Error::ParameterError
+			 *	This format cannot hold such pixels.
+			 * @throw Error::StrategyError
+			 *	Error encoding.
+			 */
+			virtual Memory::uint8Array
+			encodeRawData(
+			    const Memory::ByteView &rawData,
+			    const Properties &properties)
+			    const = 0;
+
+			/**
+			 * @brief
+			 * Obtain the pixel format in which to encode an
+			 * image.
+			 *
+			 * @param[in] properties
+			 *	Properties of the image.
+			 *
+			 * @return
+			 *	PixelFormat::Native if this format can hold
+			 *	the image's pixels, otherwise a format
+			 *	accepted by Image::decodeInto().
+			 */
+			virtual PixelFormat
+			getPixelFormat(
+			    const Properties &properties)
+			    const;
+
+		private:
+			/**
+			 * @brief
+			 * Call a function for each number in a range, on a
+			 * pool of threads.
+			 *
+			 * @param[in] count
+			 *	fn is called with 0 through count - 1.
+			 * @param[in] threads
+			 *	Number of threads, or 0 for
+			 *	System::getCPUCount().
+			 * @param[in] fn
+			 *	Function to call.
+			 *
+			 * @throw Error::Exception
+			 *	The first exception thrown by fn, after all
+			 *	threads have finished.
+			 *
+			 * @note
+			 * The calling thread is one of the threads, so fn
+			 * is still called for every number if no other
+			 * thread can be started.
+			 */
+			static void
+			parallelFor(
+			    uint64_t count,
+			    uint32_t threads,
+			    const std::function<void(uint64_t)> &fn);
+
+			/** Format produced by this encoder */
+			const CompressionAlgorithm _compressionAlgorithm;
+			/** Settings for the encoder */
+			const Settings _settings;
+		};
+	}
+}
+
+#endif /* __BE_IMAGE_ENCODER_H__ */
@@ -11,12 +11,18 @@
 #ifndef __BE_IMAGE_IMAGE_H__
 #define __BE_IMAGE_IMAGE_H__
 
+#include <pthread.h>
+
 #include <cstdint>
+#include <functional>
 #include <stdexcept>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <be_image.h>
 #include <be_memory_autoarray.h>
+#include <be_memory_byteview.h>
 
 namespace BiometricEvaluation
 {
@@ -26,7 +32,8 @@ namespace BiometricEvaluation
 	 */
 	namespace Image
 	{
-		/* Forward declaration */
+		/* Forward declarations */
+		class Encoder;
 		class Raw;
 
 		/**
@@ -43,6 +50,12 @@ namespace BiometricEvaluation
 		 * Image resolution is in pixels per centimeter, and the
 		 * coordinate system has the origin at the upper left of the
 		 * image.
+		 *
+		 * Decoded data can be kept between calls by giving the
+		 * object a decode cache limit (see setDecodeCacheLimit()).
+		 * The raw, grayscale and alpha-stripped variants share the
+		 * cache, so asking for several of them decodes the image
+		 * once.
 		 */
 		class Image {
 		public:
@@ -104,6 +117,53 @@ namespace BiometricEvaluation
 			    const uint64_t size,
 			    const CompressionAlgorithm compression);
 
+			/**
+		 	 * @brief
+			 * Parent constructor for all Image classes, referring
+			 * to the caller's copy of the image data.
+			 *
+			 * @param[in] data
+			 *	The image data, which is not copied and must
+			 *	remain valid for the life of this object and
+			 *	its copies.
+			 * @param[in] dimensions
+			 *	The width and height of the image in pixels.
+			 * @param[in] colorDepth
+			 *	The image color depth, in bits-per-pixel.
+			 * @param[in] bitDepth
+			 *	The number of bits per color component.
+			 * @param[in] resolution
+			 *	The resolution of the image
+			 * @param[in] compression
+			 *	The CompressionAlgorithm of data.
+			 * @param[in] hasAlphaChannel
+			 *	Presence of an alpha channel.
+			 */
+			Image(
+			    const Memory::ByteView &data,
+			    const Size dimensions,
+			    const uint32_t colorDepth,
+			    const uint16_t bitDepth,
+			    const Resolution resolution,
+			    const CompressionAlgorithm compression,
+			    const bool hasAlphaChannel);
+
+			/**
+		 	 * @brief
+			 * Parent constructor for all Image classes, referring
+			 * to the caller's copy of the image data.
+			 *
+			 * @param[in] data
+			 *	The image data, which is not copied and must
+			 *	remain valid for the life of this object and
+			 *	its copies.
+			 * @param[in] compression
+			 *	The CompressionAlgorithm of data.
+			 */
+			Image(
+			    const Memory::ByteView &data,
+			    const CompressionAlgorithm compression);
+
 			/**
 			 * @brief
 			 * Accessor for the CompressionAlgorithm of the image.
@@ -139,11 +199,27 @@ namespace BiometricEvaluation
 			getData()
 			    const;
 
+			/**
+			 * @brief
+			 * Accessor for the image data, without copying.
+			 *
+			 * @return
+			 *	View of the image data, valid for the life of
+			 *	this object.
+			 */
+			Memory::ByteView
+			getDataView()
+			    const;
+
 			/**
 		 	 * @brief
 			 * Accessor for the raw image data. The data returned
 			 * should not be compressed or encoded.
 			 * 
+			 * @details
+			 * Decoding is done by decodeRawData(), unless the
+			 * result is held by the decode cache.
+			 *
 			 * @return
 			 *	AutoArray holding raw image data.
 			 *
@@ -152,7 +228,7 @@ namespace BiometricEvaluation
 			 */
 			virtual Memory::uint8Array
 			getRawData()
-			    const = 0;
+			    const;
 
 			/**
 		 	 * @brief
@@ -178,6 +254,110 @@ namespace BiometricEvaluation
 			getRawData(
 			    const bool removeAlphaChannelIfPresent)
 			    const;
+
+			/**
+			 * @brief
+			 * Accessor for a rectangle of the raw image data.
+			 * @details
+			 * Codecs that can decode part of an image (JPEG,
+			 * JPEG-2000, PNG, binary NetPBM, uncompressed BMP,
+			 * and Raw) decode only as much as the rectangle
+			 * requires. Others decode the whole image, or use
+			 * the decode cache if it holds getRawData().
+			 *
+			 * @param[in] origin
+			 *	Top-left pixel of the rectangle.
+			 * @param[in] size
+			 *	Dimensions of the rectangle.
+			 *
+			 * @return
+			 *	AutoArray holding raw image data of the
+			 *	rectangle, in the same format as getRawData().
+			 *
+			 * @throw Error::DataError
+			 *	Error decompressing image data.
+			 * @throw Error::ParameterError
+			 *	Rectangle is empty or not within the image.
+			 */
+			Memory::uint8Array
+			getRawData(
+			    const Coordinate &origin,
+			    const Size &size)
+			    const;
+
+			/**
+			 * @brief
+			 * Whether getRawData(const Coordinate&, const
+			 * Size&) decodes only the rectangle requested.
+			 * @details
+			 * Callers that read an image in many rectangles
+			 * should call getRawData() once instead when this
+			 * is false, since each rectangle would otherwise
+			 * decode the whole image.
+			 *
+			 * @return
+			 *	true if this codec decodes rectangles of this
+			 *	image, false otherwise.
+			 */
+			virtual bool
+			decodesRegions()
+			    const;
+
+			/**
+			 * @brief
+			 * Obtain the dimensions of getReducedRawData().
+			 *
+			 * @param[in] scaleDenominator
+			 *	1, 2, 4, or 8.
+			 *
+			 * @return
+			 *	Dimensions divided by scaleDenominator,
+			 *	rounded up.
+			 *
+			 * @throw Error::ParameterError
+			 *	Invalid scaleDenominator.
+			 */
+			Size
+			getReducedDimensions(
+			    uint8_t scaleDenominator)
+			    const;
+
+			/**
+			 * @brief
+			 * Accessor for the raw image data at a reduced
+			 * resolution.
+			 * @details
+			 * Intended for thumbnails and quality screening.
+			 * JPEG, JPEG-2000, and WSQ decode at the reduced
+			 * resolution directly (DCT scaling, discarding
+			 * resolution levels, and stopping the wavelet
+			 * reconstruction early), doing a fraction of the
+			 * work of getRawData(). Others average blocks of
+			 * getRawData(). Results approximate, but are not
+			 * identical to, block averages of getRawData().
+			 *
+			 * @param[in] scaleDenominator
+			 *	1, 2, 4, or 8. Each dimension is divided by
+			 *	scaleDenominator.
+			 *
+			 * @return
+			 *	AutoArray holding raw image data of
+			 *	getReducedDimensions(scaleDenominator)
+			 *	pixels, in the same format as getRawData().
+			 *
+			 * @throw Error::DataError
+			 *	Error decompressing image data.
+			 * @throw Error::ParameterError
+			 *	Invalid scaleDenominator.
+			 *
+			 * @note
+			 * Each scaleDenominator is kept separately by the
+			 * decode cache.
+			 */
+			Memory::uint8Array
+			getReducedRawData(
+			    uint8_t scaleDenominator)
+			    const;
 			    
 			/**
 			 * @brief
@@ -198,9 +378,7 @@ namespace BiometricEvaluation
 			 *	Invalid value for depth.
 			 *
 			 * @note
-			 *	This method does not save a cached copy of the
-			 *	decompressed image because the bit depth of the
-			 *	image can be changed between calls.
+			 * Each depth is kept separately by the decode cache.
 			 *
 			 * @note
 			 * When depth is 1, this method returns an image that
@@ -216,7 +394,123 @@ namespace BiometricEvaluation
 			virtual Memory::uint8Array
 			getRawGrayscaleData(
 			    uint8_t depth)
-			    const = 0;
+			    const;
+
+			/**
+			 * @brief
+			 * Obtain the size of a row of decoded pixels.
+			 *
+			 * @param[in] format
+			 *	Format of the pixels.
+			 *
+			 * @return
+			 *	Bytes in one row of pixels in format,
+			 *	without padding.
+			 *
+			 * @throw Error::NotImplemented
+			 *	The image cannot be decoded to format.
+			 */
+			uint64_t
+			getRowSize(
+			    PixelFormat format = PixelFormat::Native)
+			    const;
+
+			/**
+			 * @brief
+			 * Decode the image into a buffer owned by the caller.
+			 * @details
+			 * Row n of the image is written to
+			 * dst + (n * stride). Bytes between the end of one
+			 * row and the start of the next are not changed.
+			 *
+			 * Native pixels are decoded directly into dst,
+			 * without an intermediate copy, by codecs that
+			 * support it, unless the decode cache already
+			 * holds them. Other formats are as returned by
+			 * getRawGrayscaleData() (Gray8, Gray16),
+			 * getRawData(true) (RGB24 from 8-bit RGBA), or
+			 * getRawGrayscaleData(1) packed eight pixels to a
+			 * byte, most significant bit first (MonoWhite,
+			 * MonoBlack).
+			 *
+			 * @param[out] dst
+			 *	Buffer of at least
+			 *	(stride * (ySize - 1)) + getRowSize(format)
+			 *	bytes.
+			 * @param[in] stride
+			 *	Bytes from the start of one row to the start
+			 *	of the next, at least getRowSize(format).
+			 * @param[in] format
+			 *	Format of the decoded pixels.
+			 *
+			 * @throw Error::ParameterError
+			 *	dst is nullptr or stride is too small.
+			 * @throw Error::NotImplemented
+			 *	The image cannot be decoded to format.
+			 * @throw Error::DataError
+			 *	Error decompressing image data.
+			 */
+			void
+			decodeInto(
+			    uint8_t *dst,
+			    uint64_t stride,
+			    PixelFormat format = PixelFormat::Native)
+			    const;
+
+			/**
+			 * @brief
+			 * Limit the bytes of decoded data kept by this object.
+			 * @details
+			 * Variants that would exceed the limit evict the
+			 * oldest variants, and a single variant larger
+			 * than the limit is not kept. A limit of 0 disables
+			 * the cache and releases its contents.
+			 *
+			 * @param[in] limit
+			 *	Most bytes to keep.
+			 */
+			void
+			setDecodeCacheLimit(
+			    uint64_t limit);
+
+			/** @return Most bytes of decoded data kept */
+			uint64_t
+			getDecodeCacheLimit()
+			    const;
+
+			/** @return Bytes of decoded data currently kept */
+			uint64_t
+			getDecodeCacheSize()
+			    const;
+
+			/**
+			 * @brief
+			 * Invalidate and release the decoded data kept by
+			 * this object.
+			 * @details
+			 * Needed if the image data referenced by an Image
+			 * made from a ByteView changes.
+			 */
+			void
+			clearDecodeCache()
+			    const;
+
+			/**
+			 * @brief
+			 * Set the decode cache limit of Images constructed
+			 * from now on, by any thread.
+			 *
+			 * @param[in] limit
+			 *	Most bytes to keep per Image, 0 (the
+			 *	initial value) to disable the cache.
+			 */
+			static void
+			setDefaultDecodeCacheLimit(
+			    uint64_t limit);
+
+			/** @return Decode cache limit of new Images */
+			static uint64_t
+			getDefaultDecodeCacheLimit();
 
 			/**
 		 	 * @brief
@@ -339,6 +633,28 @@ namespace BiometricEvaluation
 			static std::shared_ptr<Image>
 			openImage(
 			    const Memory::uint8Array &data);
+
+			/**
+			 * @brief
+			 * Determine the image type of a buffer of image data
+			 * and create an Image object that refers to, rather
+			 * than copies, the buffer.
+			 *
+ 			 * @param[in] data
+			 *	The image data, which must remain valid for
+			 *	the life of the returned Image and its copies.
+			 *
+			 * @return
+			 *	Image representation of the input data buffer.
+ 			 *
+			 * @throw Error::DataError
+			 *	Error manipulating data.
+			 * @throw Error::StrategyError
+			 *	Error while creating Image.
+			 */
+			static std::shared_ptr<Image>
+			openImage(
+			    const Memory::ByteView &data);
 			    
 			/**
 			 * @brief
@@ -404,6 +720,26 @@ namespace BiometricEvaluation
 			static CompressionAlgorithm
 			getCompressionAlgorithm(
 			    const Memory::uint8Array &data);
+
+			/**
+			 * @brief
+			 * Determine the compression algorithm of a buffer
+			 * of image data.
+			 *
+  			 * @param[in] data
+			 *	The image data.
+			 *
+			 * @return
+			 *	Compression algorithm used in the buffer.
+			 *
+			 * @attention
+			 *	CompressionAlgorithm::None is returned if
+			 *	no compression algorithm known to the
+			 *	Biometric Evaluation Framework is found.
+			 */
+			static CompressionAlgorithm
+			getCompressionAlgorithm(
+			    const Memory::ByteView &data);
 			
 			/**
 			 * @brief
@@ -430,6 +766,33 @@ namespace BiometricEvaluation
 			getCompressionAlgorithm(
 			    const std::string &path);
 
+			/**
+			 * @brief
+			 * Read the properties of image data from its header.
+			 * @details
+			 * The format is identified from the leading bytes,
+			 * and only its header is parsed: data is neither
+			 * copied nor decoded. Suitable for scanning the
+			 * properties of many images, such as those in a
+			 * RecordStore or a memory-mapped file.
+			 *
+			 * @param[in] data
+			 *	The image data, which need only remain valid
+			 *	during the call.
+			 *
+			 * @return
+			 *	Properties of the image.
+			 *
+			 * @throw Error::DataError
+			 *	Invalid header.
+			 * @throw Error::StrategyError
+			 *	No compression algorithm known to the
+			 *	Biometric Evaluation Framework is found.
+			 */
+			static Properties
+			probe(
+			    const Memory::ByteView &data);
+
 			/**
 			 * @brief
 			 * Obtain Image::Raw version of an Image::Image.
@@ -450,6 +813,259 @@ namespace BiometricEvaluation
 			    Image> &image);
 
 		protected:
+			/**
+			 * @brief
+			 * Decode the image data.
+			 * @details
+			 * Implemented by each codec and called by
+			 * getRawData() when the decode cache does not hold
+			 * the result.
+			 *
+			 * @return
+			 *	AutoArray holding raw image data.
+			 *
+			 * @throw Error::DataError
+			 *	Error decompressing image data.
+			 */
+			virtual Memory::uint8Array
+			decodeRawData()
+			    const = 0;
+
+			/**
+			 * @brief
+			 * Decode the image data into rows owned by the
+			 * caller.
+			 * @details
+			 * Called by decodeInto(). The default copies the
+			 * rows of decodeRawData(); codecs that can decode
+			 * in place override this.
+			 *
+			 * @param[out] dst
+			 *	Start of the first row.
+			 * @param[in] stride
+			 *	Bytes between the starts of rows, at least
+			 *	getRawRowSize().
+			 *
+			 * @throw Error::DataError
+			 *	Error decompressing image data.
+			 */
+			virtual void
+			decodeRawInto(
+			    uint8_t *dst,
+			    uint64_t stride)
+			    const;
+
+			/**
+			 * @brief
+			 * Decode a rectangle of the image data.
+			 * @details
+			 * Called by getRawData(const Coordinate&, const
+			 * Size&) with a validated rectangle that is not the
+			 * whole image. The default crops getRawData();
+			 * codecs that can decode part of an image override
+			 * this.
+			 *
+			 * @param[in] origin
+			 *	Top-left pixel of the rectangle.
+			 * @param[in] size
+			 *	Dimensions of the rectangle.
+			 *
+			 * @return
+			 *	AutoArray holding raw image data of the
+			 *	rectangle.
+			 *
+			 * @throw Error::DataError
+			 *	Error decompressing image data.
+			 */
+			virtual Memory::uint8Array
+			decodeRawRegion(
+			    const Coordinate &origin,
+			    const Size &size)
+			    const;
+
+			/**
+			 * @brief
+			 * Decode the image data at a reduced resolution.
+			 * @details
+			 * Called by getReducedRawData() with a validated
+			 * scaleDenominator other than 1, when the decode
+			 * cache does not hold the result. The default
+			 * averages scaleDenominator x scaleDenominator
+			 * blocks of getRawData(), rounding to the nearest
+			 * value, or takes the top-left pixel of each block
+			 * of pixels packed smaller than a byte. Codecs
+			 * that can decode at a reduced resolution override
+			 * this.
+			 *
+			 * @param[in] scaleDenominator
+			 *	2, 4, or 8.
+			 *
+			 * @return
+			 *	AutoArray holding raw image data of
+			 *	getReducedDimensions(scaleDenominator)
+			 *	pixels.
+			 *
+			 * @throw Error::DataError
+			 *	Error decompressing image data.
+			 */
+			virtual Memory::uint8Array
+			decodeReducedRawData(
+			    uint8_t scaleDenominator)
+			    const;
+
+			/**
+			 * @brief
+			 * Obtain the size of a pixel of getRawData().
+			 * @details
+			 * The default assumes one byte for samples up to 8
+			 * bits and two bytes for samples up to 16 bits,
+			 * and so counts 1-bit images as expanded to 8 bits.
+			 *
+			 * @return
+			 *	Bits in one pixel of raw data.
+			 */
+			virtual uint32_t
+			getRawPixelBits()
+			    const;
+
+			/**
+			 * @return
+			 *	Bytes in one row of raw data, with rows that
+			 *	end within a byte padded to the byte.
+			 */
+			uint64_t
+			getRawRowSize()
+			    const;
+
+			/**
+			 * @brief
+			 * Copy a run of pixels out of a row of raw data.
+			 *
+			 * @param[in] src
+			 *	Row of raw data.
+			 * @param[in] x
+			 *	First pixel to copy.
+			 * @param[in] count
+			 *	Pixels to copy.
+			 * @param[out] dst
+			 *	Start of a row of raw data for count pixels.
+			 *	Bits past the last pixel are cleared.
+			 */
+			void
+			copyPixels(
+			    const uint8_t *src,
+			    uint32_t x,
+			    uint32_t count,
+			    uint8_t *dst)
+			    const;
+
+			/**
+			 * @brief
+			 * Copy a rectangle out of raw data.
+			 *
+			 * @param[in] src
+			 *	Raw data of the whole image.
+			 * @param[in] origin
+			 *	Top-left pixel of the rectangle.
+			 * @param[in] size
+			 *	Dimensions of the rectangle.
+			 *
+			 * @return
+			 *	Raw data of the rectangle.
+			 *
+			 * @throw Error::StrategyError
+			 *	src is smaller than the image.
+			 */
+			Memory::uint8Array
+			cropRows(
+			    const Memory::ByteView &src,
+			    const Coordinate &origin,
+			    const Size &size)
+			    const;
+
+			/**
+			 * @brief
+			 * Copy rows of decoded data into rows owned by the
+			 * caller.
+			 *
+			 * @param[in] src
+			 *	Decoded data, tightly packed.
+			 * @param[in] rowSize
+			 *	Bytes in one row of src.
+			 * @param[out] dst
+			 *	Start of the first row.
+			 * @param[in] stride
+			 *	Bytes between the starts of rows in dst.
+			 *
+			 * @throw Error::StrategyError
+			 *	src is smaller than the image.
+			 */
+			void
+			copyRows(
+			    const Memory::ByteView &src,
+			    uint64_t rowSize,
+			    uint8_t *dst,
+			    uint64_t stride)
+			    const;
+
+			/**
+			 * @brief
+			 * Produce grayscale data.
+			 * @details
+			 * Called by getRawGrayscaleData() with a validated
+			 * depth other than the color depth, when the
+			 * decode cache does not hold the result. The
+			 * default converts getRawData() with ITU-R BT.601
+			 * weights. Codecs that can decode directly to
+			 * grayscale may override this.
+			 *
+			 * @param[in] depth
+			 *	Bit depth of the result: 16, 8, or 1.
+			 *
+			 * @return
+			 *	AutoArray holding raw grayscale image data.
+			 */
+			virtual Memory::uint8Array
+			decodeRawGrayscaleData(
+			    uint8_t depth)
+			    const;
+
+			/**
+			 * @brief
+			 * Kinds of decoded data held by the decode cache.
+			 * @details
+			 * Grayscale variants are Grayscale plus the depth,
+			 * and Reduced variants are Reduced plus the scale
+			 * denominator.
+			 */
+			enum class DecodedVariant : uint16_t
+			{
+				Raw = 0x0000,
+				RawWithoutAlpha = 0x0001,
+				Grayscale = 0x0100,
+				Reduced = 0x0200
+			};
+
+			/**
+			 * @brief
+			 * Obtain decoded data through the decode cache.
+			 *
+			 * @param[in] variant
+			 *	Key of the data in the cache.
+			 * @param[in] decode
+			 *	Function producing the data when it is not
+			 *	cached.
+			 *
+			 * @return
+			 *	Copy of the cached data, or the result of
+			 *	decode.
+			 */
+			Memory::uint8Array
+			getCachedDecode(
+			    uint16_t variant,
+			    const std::function<Memory::uint8Array()> &decode)
+			    const;
+
 			/**
 		 	 * @brief
 			 * Mutator for the resolution of the image .
@@ -495,16 +1111,29 @@ namespace BiometricEvaluation
 			setBitDepth(
 			    const uint16_t bitDepth);
 			    
-			/** @return Const pointer to buffer underlying _data. */
+			/** @return Const pointer to the image data. */
 			const uint8_t *
 			getDataPointer()
 			    const;
 
-			/** @return Size of _data. */
+			/** @return Size of the image data. */
 			uint64_t
 			getDataSize()
 			    const;
 
+			/**
+			 * @brief
+			 * Take a private copy of image data the object was
+			 * constructed to refer to.
+			 * @details
+			 * Constructors that accept a pointer or uint8Array
+			 * parse the caller's buffer through their ByteView
+			 * counterparts and then call this, so the buffer
+			 * is copied once, after it is known to be valid.
+			 */
+			void
+			copyData();
+
 			/**
 			 * @brief
 			 * Mutator for the presence of an alpha channel.
@@ -517,9 +1146,13 @@ namespace BiometricEvaluation
 			    const bool hasAlphaChannel)
 			{
 				this->_hasAlphaChannel = hasAlphaChannel;
+				this->_decodeCache.clear();
 			}
 
 		private:
+			/** Encoders describe raw data by getRawPixelBits() */
+			friend class Encoder;
+
 			/** Image dimensions (width and height) in pixels */
 			Size _dimensions;
 
@@ -535,11 +1168,81 @@ namespace BiometricEvaluation
 			/** Resolution */
 			Resolution _resolution;
 
-			/** Encoded image data */
+			/** Encoded image data, when owned by this object */
 			Memory::AutoArray<uint8_t> _data;
 
+			/** Encoded image data, when owned by the caller */
+			Memory::ByteView _view;
+
 			/** Compression algorithm of _data */
 			CompressionAlgorithm _compressionAlgorithm;
+
+			/**
+			 * @brief
+			 * Decoded data kept between calls.
+			 * @details
+			 * Copying an Image copies the limit but not the
+			 * contents.
+			 */
+			class DecodeCache
+			{
+			public:
+				DecodeCache();
+				DecodeCache(
+				    const DecodeCache &other);
+				DecodeCache&
+				operator=(
+				    const DecodeCache &other);
+				~DecodeCache();
+
+				/** @return Cached data, or nullptr */
+				std::shared_ptr<const Memory::uint8Array>
+				find(
+				    uint16_t variant)
+				    const;
+
+				/** Keep data, evicting to stay in limit */
+				void
+				insert(
+				    uint16_t variant,
+				    const Memory::uint8Array &data);
+
+				/** Remove all data */
+				void
+				clear();
+
+				/** Change the limit, evicting as needed */
+				void
+				setLimit(
+				    uint64_t limit);
+
+				uint64_t
+				getLimit()
+				    const;
+
+				uint64_t
+				getSize()
+				    const;
+
+			private:
+				/** Remove oldest entries until size fits */
+				void
+				evict(
+				    uint64_t size);
+
+				/** Most bytes kept */
+				uint64_t _limit;
+				/** Bytes kept */
+				uint64_t _size;
+				/** Data by variant, oldest first */
+				std::vector<std::pair<uint16_t, std::shared_ptr<
+				    const Memory::uint8Array>>> _entries;
+				/** Readers share, inserts are exclusive */
+				mutable pthread_rwlock_t _lock;
+			};
+
+			/** Decoded data, filled by const accessors */
+			mutable DecodeCache _decodeCache;
 		};
 	}
 }
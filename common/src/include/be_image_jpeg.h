@@ -56,16 +56,16 @@ namespace BiometricEvaluation
 			JPEG(
 			    const Memory::uint8Array &data);
 
+			/** data is referenced, not copied, by the object */
+			explicit JPEG(
+			    const Memory::ByteView &data);
+
 			~JPEG() = default;
 
 			Memory::uint8Array
 			getRawGrayscaleData(
 			    uint8_t depth) const;
 
-			Memory::uint8Array
-			getRawData()
-			    const;
-	
 			/**
 			 * Whether or not data is a Lossy JPEG image.
 			 *
@@ -89,7 +89,36 @@ namespace BiometricEvaluation
 			    unsigned char **cbufptr,
 			    unsigned char *ebufptr);
 
+			bool
+			decodesRegions()
+			    const;
+
 		protected:
+			Memory::uint8Array
+			decodeRawData()
+			    const;
+
+			void
+			decodeRawInto(
+			    uint8_t *dst,
+			    uint64_t stride)
+			    const;
+
+			Memory::uint8Array
+			decodeRawRegion(
+			    const Coordinate &origin,
+			    const Size &size)
+			    const;
+
+			Memory::uint8Array
+			decodeReducedRawData(
+			    uint8_t scaleDenominator)
+			    const;
+
+			Memory::uint8Array
+			decodeRawGrayscaleData(
+			    uint8_t depth)
+			    const;
 
 		private:
 			/**
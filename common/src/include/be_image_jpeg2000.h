@@ -48,12 +48,13 @@ namespace BiometricEvaluation
 			JPEG2000(
 			    const Memory::uint8Array &data);
 
+			/** data is referenced, not copied, by the object */
+			explicit JPEG2000(
+			    const Memory::ByteView &data,
+			    const int8_t codecFormat = 2);
+
 			~JPEG2000() = default;
 
-			Memory::uint8Array
-			getRawData()
-			    const;
-			    
 			Memory::uint8Array
 			getRawGrayscaleData(
 			    uint8_t depth) const;
@@ -75,10 +76,76 @@ namespace BiometricEvaluation
 			    const uint8_t *data,
 			    uint64_t size);
 
+			bool
+			decodesRegions()
+			    const;
+
+		protected:
+			Memory::uint8Array
+			decodeRawData()
+			    const;
+
+			void
+			decodeRawInto(
+			    uint8_t *dst,
+			    uint64_t stride)
+			    const;
+
+			Memory::uint8Array
+			decodeRawRegion(
+			    const Coordinate &origin,
+			    const Size &size)
+			    const;
+
+			Memory::uint8Array
+			decodeReducedRawData(
+			    uint8_t scaleDenominator)
+			    const;
+
 		private:
 			/** JPEG2000 codec to use (from libopenjpeg) */
 			const int8_t _codecFormat;
 
+			/**
+			 * @brief
+			 * Decode a rectangle of the image into rows owned
+			 * by the caller.
+			 * @details
+			 * Only the code-blocks that hold the rectangle are
+			 * decoded. With a reduction, the whole image is
+			 * decoded without its highest resolution levels.
+			 *
+			 * @param[in] origin
+			 *	Top-left pixel of the rectangle, {0, 0} when
+			 *	reduction is not 0.
+			 * @param[in] size
+			 *	Dimensions of the rectangle, or of the
+			 *	reduced image.
+			 * @param[in] reduction
+			 *	Resolution levels to discard, each halving
+			 *	the dimensions.
+			 * @param[out] dst
+			 *	Start of the first row.
+			 * @param[in] stride
+			 *	Bytes between the starts of rows.
+			 *
+			 * @throw Error::DataError
+			 *	Decoded size does not match the header.
+			 * @throw Error::NotImplemented
+			 *	Unsupported component layout or precision,
+			 *	or too few resolution levels for reduction.
+			 * @throw Error::StrategyError
+			 *	Error from libopenjp2.
+			 */
+			void
+			decodeRegionInto(
+			    const Coordinate &origin,
+			    const Size &size,
+			    uint8_t reduction,
+			    uint8_t *dst,
+			    uint64_t stride)
+			    const;
+
 			/**
 			 * @brief
 			 * Parse CDEF box to check for an opacity component.
@@ -31,16 +31,16 @@ namespace BiometricEvaluation
 			JPEGL(
 			    const Memory::uint8Array &data);
 
+			/** data is referenced, not copied, by the object */
+			explicit JPEGL(
+			    const Memory::ByteView &data);
+
 			~JPEGL() = default;
 
 			Memory::uint8Array
 			getRawGrayscaleData(
 			    uint8_t depth) const;
 
-			Memory::uint8Array
-			getRawData()
-			    const;
-	
 			/**
 			 * Whether or not data is a Lossless JPEG image.
 			 *
@@ -59,6 +59,9 @@ namespace BiometricEvaluation
 			    uint64_t size);
 
 		protected:
+			Memory::uint8Array
+			decodeRawData()
+			    const;
 
 		private:
 
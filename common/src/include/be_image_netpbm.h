@@ -48,31 +48,12 @@ namespace BiometricEvaluation
 			NetPBM(
 			    const Memory::uint8Array &data);
 
+			/** data is referenced, not copied, by the object */
+			explicit NetPBM(
+			    const Memory::ByteView &data);
+
 			~NetPBM() = default;
 
-			/**
-		 	 * @brief
-			 * Accessor for the raw image data. The data returned
-			 * should not be compressed or encoded.
-			 * 
-			 * @return
-			 *	AutoArray holding raw image data.
-			 *
-			 * @throw Error::DataError
-			 *	Error decompressing image data.
-			 * @throw Error::NotImplemented
-			 * 	Compression type not supported.
-			 *
-			 * @note
-			 * The raw data returned from this method is encoded
-			 * at the same bit depth as the compressed data,
-			 * except in the case of 1-bit (bitmap) images, which
-			 * are expanded to 8-bit.
-			 */
-			Memory::uint8Array
-			getRawData()
-			    const;
-			    
 			Memory::uint8Array
 			getRawGrayscaleData(
 			    uint8_t depth) const;
@@ -266,6 +247,59 @@ namespace BiometricEvaluation
 			    uint32_t width,
 			    uint32_t height);
 
+			/** @return Whether samples are binary */
+			bool
+			decodesRegions()
+			    const;
+
+		protected:
+			/**
+		 	 * @brief
+			 * Decode the image data.
+			 * 
+			 * @return
+			 *	AutoArray holding raw image data.
+			 *
+			 * @throw Error::DataError
+			 *	Error decompressing image data.
+			 * @throw Error::NotImplemented
+			 * 	Compression type not supported.
+			 *
+			 * @note
+			 * The raw data returned from this method is encoded
+			 * at the same bit depth as the compressed data,
+			 * except in the case of 1-bit (bitmap) images, which
+			 * are expanded to 8-bit.
+			 */
+			Memory::uint8Array
+			decodeRawData()
+			    const;
+
+			/**
+			 * @brief
+			 * Decode a rectangle of the image data.
+			 * @details
+			 * Rows of binary formats are located directly;
+			 * ASCII formats are decoded in full.
+			 *
+			 * @param[in] origin
+			 *	Top-left pixel of the rectangle.
+			 * @param[in] size
+			 *	Dimensions of the rectangle.
+			 *
+			 * @return
+			 *	AutoArray holding raw image data of the
+			 *	rectangle, as from decodeRawData().
+			 *
+			 * @throw Error::DataError
+			 *	Image data is truncated.
+			 */
+			Memory::uint8Array
+			decodeRawRegion(
+			    const Coordinate &origin,
+			    const Size &size)
+			    const;
+
 		private:
 			/**
 			 * @brief
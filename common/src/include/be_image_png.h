@@ -44,11 +44,11 @@ namespace BiometricEvaluation
 			PNG(
 			    const Memory::uint8Array &data);
 
-			~PNG() = default;
+			/** data is referenced, not copied, by the object */
+			explicit PNG(
+			    const Memory::ByteView &data);
 
-			Memory::uint8Array
-			getRawData()
-			    const;
+			~PNG() = default;
 
 			Memory::uint8Array
 			getRawGrayscaleData(
@@ -71,7 +71,36 @@ namespace BiometricEvaluation
 			    const uint8_t *data,
 			    uint64_t size);
 
+			/** @return Whether the image is not interlaced */
+			bool
+			decodesRegions()
+			    const;
+
 		protected:
+			Memory::uint8Array
+			decodeRawData()
+			    const;
+
+			void
+			decodeRawInto(
+			    uint8_t *dst,
+			    uint64_t stride)
+			    const;
+
+			Memory::uint8Array
+			decodeRawRegion(
+			    const Coordinate &origin,
+			    const Size &size)
+			    const;
+
+			/**
+			 * @return
+			 *	Bits in one pixel of raw data, where samples
+			 *	of fewer than 8 bits are packed.
+			 */
+			uint32_t
+			getRawPixelBits()
+			    const;
 
 		private:
 			/**
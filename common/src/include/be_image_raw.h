@@ -41,12 +41,24 @@ namespace BiometricEvaluation
 			    const Resolution resolution,
 			    const bool hasAlphaChannel);
 
+			/** data is referenced, not copied, by the object */
+			Raw(
+			    const Memory::ByteView &data,
+			    const Size dimensions,
+			    const uint32_t colorDepth,
+			    const uint16_t bitDepth,
+			    const Resolution resolution,
+			    const bool hasAlphaChannel);
+
 			~Raw() = default;
 
 			/*
 			 * Implementations of the Image interface.
 			 */
 
+			using Image::getRawData;
+
+			/** Raw data is returned directly, never cached */
 			Memory::uint8Array
 			getRawData()
 			    const;
@@ -55,7 +67,26 @@ namespace BiometricEvaluation
 			getRawGrayscaleData(
 			    uint8_t depth) const;
 
+			bool
+			decodesRegions()
+			    const;
+
 		protected:
+			Memory::uint8Array
+			decodeRawData()
+			    const;
+
+			void
+			decodeRawInto(
+			    uint8_t *dst,
+			    uint64_t stride)
+			    const;
+
+			Memory::uint8Array
+			decodeRawRegion(
+			    const Coordinate &origin,
+			    const Size &size)
+			    const;
 
 		private:
 
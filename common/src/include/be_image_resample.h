@@ -0,0 +1,112 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_IMAGE_RESAMPLE_H__
+#define __BE_IMAGE_RESAMPLE_H__
+
+#include <cstdint>
+
+#include <be_framework_enumeration.h>
+#include <be_image.h>
+#include <be_image_raw.h>
+
+namespace BiometricEvaluation
+{
+	namespace Image
+	{
+		/** Filters used to resample images */
+		enum class ResampleFilter
+		{
+			/**
+			 * Average of the input pixels each output pixel
+			 * covers, weighted by the part of each that is
+			 * covered, for downscaling.
+			 */
+			Area,
+			/** Linear interpolation, antialiased downscaling */
+			Bilinear,
+			/** Three-lobed Lanczos windowed sinc */
+			Lanczos
+		};
+
+		/**
+		 * @brief
+		 * Resample an image to a new resolution.
+		 * @details
+		 * Images are resampled separably, rows then columns, on
+		 * 8- or 16-bit grayscale or color pixels, with or
+		 * without alpha. Kernels use SSE4.1 or AVX2 as chosen by
+		 * Conversion::getInstructions(), produce identical output
+		 * with each, and rows are divided among threads.
+		 *
+		 * @param[in] image
+		 *	Image to resample.
+		 * @param[in] target
+		 *	Resolution of the returned image, in any units.
+		 * @param[in] filter
+		 *	Filter to resample with.
+		 * @param[in] threads
+		 *	Number of threads, or 0 for
+		 *	System::getCPUCount().
+		 *
+		 * @return
+		 *	image resampled to target, with resolution target.
+		 *
+		 * @throw Error::ParameterError
+		 *	image or target has no resolution, or the
+		 *	resampled image would be empty.
+		 * @throw Error::NotImplemented
+		 *	image does not have 8- or 16-bit samples, or
+		 *	has more than four components.
+		 */
+		Raw
+		resample(
+		    const Raw &image,
+		    const Resolution &target,
+		    ResampleFilter filter = ResampleFilter::Area,
+		    uint32_t threads = 0);
+
+		/**
+		 * @brief
+		 * Resample an image to new dimensions.
+		 * @details
+		 * As resample(const Raw&, const Resolution&,
+		 * ResampleFilter, uint32_t). The resolution of image,
+		 * if any, is scaled with its dimensions.
+		 *
+		 * @param[in] image
+		 *	Image to resample.
+		 * @param[in] dimensions
+		 *	Dimensions of the returned image.
+		 * @param[in] filter
+		 *	Filter to resample with.
+		 * @param[in] threads
+		 *	Number of threads, or 0 for
+		 *	System::getCPUCount().
+		 *
+		 * @return
+		 *	image resampled to dimensions.
+		 *
+		 * @throw Error::ParameterError
+		 *	dimensions are empty.
+		 * @throw Error::NotImplemented
+		 *	image does not have 8- or 16-bit samples, or
+		 *	has more than four components.
+		 */
+		Raw
+		resample(
+		    const Raw &image,
+		    const Size &dimensions,
+		    ResampleFilter filter = ResampleFilter::Area,
+		    uint32_t threads = 0);
+	}
+}
+
+#endif /* __BE_IMAGE_RESAMPLE_H__ */
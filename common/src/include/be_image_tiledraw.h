@@ -0,0 +1,406 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_IMAGE_TILEDRAW_H__
+#define __BE_IMAGE_TILEDRAW_H__
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <be_image_image.h>
+#include <be_memory_autoarray.h>
+#include <be_memory_byteview.h>
+
+namespace BiometricEvaluation
+{
+	namespace Image
+	{
+		/**
+		 * @brief
+		 * Raw pixels stored as fixed-size tiles.
+		 * @details
+		 * A TiledRaw image divides the pixels of getRawData()
+		 * into tiles of the same dimensions, except in the last
+		 * column and row, each optionally compressed with a
+		 * codec that Encoder can write. Tiles are read only when
+		 * needed, so rectangles of the image and single tiles
+		 * are obtained without decoding the rest, and images
+		 * opened from a file are memory mapped rather than read.
+		 *
+		 * Only pixels of 8- or 16-bit samples are stored.
+		 * Multi-byte values, including 16-bit samples, are in
+		 * native byte order.
+		 *
+		 * Layout: a 64-byte header, the tiles in row-major order
+		 * each starting at a multiple of 64 bytes, then, ending
+		 * the data, an index of the offset and length of each
+		 * tile. Placing the index last lets tiles be written as
+		 * they are encoded.
+		 */
+		class TiledRaw : public Image
+		{
+		public:
+			/** A decoded tile */
+			struct Tile
+			{
+				/** Column of the tile */
+				uint32_t column;
+				/** Row of the tile */
+				uint32_t row;
+				/** Top-left pixel of the tile in the image */
+				Coordinate origin;
+				/** Dimensions of the tile */
+				Size dimensions;
+				/**
+				 * Pixels of the tile, in the format of
+				 * getRawData(), valid only while the
+				 * tile is being processed.
+				 */
+				Memory::ByteView pixels;
+			};
+
+			/**
+			 * @brief
+			 * Open a TiledRaw file by mapping it into memory.
+			 *
+			 * @param[in] pathname
+			 *	Path to a file written by create().
+			 *
+			 * @throw Error::FileError
+			 *	pathname could not be opened or mapped.
+			 * @throw Error::DataError
+			 *	pathname is not a valid TiledRaw image.
+			 */
+			TiledRaw(
+			    const std::string &pathname);
+
+			TiledRaw(
+			    const uint8_t *data,
+			    const uint64_t size);
+
+			TiledRaw(
+			    const Memory::uint8Array &data);
+
+			/** data is referenced, not copied, by the object */
+			explicit TiledRaw(
+			    const Memory::ByteView &data);
+
+			~TiledRaw() = default;
+
+			/** @return Dimensions of all but edge tiles */
+			Size
+			getTileSize()
+			    const;
+
+			/** @return Number of tile columns and rows */
+			Size
+			getTileCount()
+			    const;
+
+			/** @return Codec of each tile */
+			CompressionAlgorithm
+			getTileCompressionAlgorithm()
+			    const;
+
+			/**
+			 * @brief
+			 * Decode one tile.
+			 *
+			 * @param[in] column
+			 *	Column of the tile.
+			 * @param[in] row
+			 *	Row of the tile.
+			 *
+			 * @return
+			 *	Pixels of the tile, in the format of
+			 *	getRawData().
+			 *
+			 * @throw Error::ParameterError
+			 *	No such tile.
+			 * @throw Error::DataError
+			 *	Error decoding the tile.
+			 */
+			Memory::uint8Array
+			getTile(
+			    uint32_t column,
+			    uint32_t row)
+			    const;
+
+			/**
+			 * @brief
+			 * Decode each tile and pass it to a function.
+			 * @details
+			 * Each thread decodes one tile at a time, so no
+			 * more than threads tiles are in memory at once.
+			 * With one thread, tiles are passed in row-major
+			 * order. Uncompressed tiles are passed without
+			 * copying.
+			 *
+			 * @param[in] fn
+			 *	Function called once for each tile,
+			 *	concurrently from threads threads.
+			 * @param[in] threads
+			 *	Number of threads, or 0 for
+			 *	System::getCPUCount(). The calling thread
+			 *	is one of them.
+			 *
+			 * @throw Error::Exception
+			 *	The first exception thrown decoding a tile
+			 *	or by fn, after all threads have finished.
+			 */
+			void
+			forEachTile(
+			    const std::function<void(const Tile&)> &fn,
+			    uint32_t threads = 1)
+			    const;
+
+			/**
+			 * @brief
+			 * Write an image as a TiledRaw file.
+			 * @details
+			 * The image is read one row of tiles at a time,
+			 * using Image::getRawData(const Coordinate&,
+			 * const Size&), and the tiles of each row are
+			 * encoded in parallel. Images whose codec cannot
+			 * decode rectangles (see Image::decodesRegions())
+			 * are decoded once, in full, instead.
+			 *
+			 * @param[in] pathname
+			 *	Path of the file to create.
+			 * @param[in] image
+			 *	Image to write.
+			 * @param[in] tileSize
+			 *	Dimensions of each tile.
+			 * @param[in] tileCompression
+			 *	Codec of each tile, CompressionAlgorithm::None
+			 *	or one that Encoder writes and decodes to the
+			 *	same pixel format, such as PNG or JP2L.
+			 * @param[in] threads
+			 *	Number of threads encoding tiles, or 0 for
+			 *	System::getCPUCount().
+			 *
+			 * @throw Error::ObjectExists
+			 *	pathname exists.
+			 * @throw Error::FileError
+			 *	Error writing pathname.
+			 * @throw Error::ParameterError
+			 *	image or tileSize is empty.
+			 * @throw Error::NotImplemented
+			 *	image does not have 8- or 16-bit samples, or
+			 *	tileCompression cannot be written.
+			 */
+			static void
+			create(
+			    const std::string &pathname,
+			    const Image &image,
+			    const Size &tileSize = Size(256, 256),
+			    CompressionAlgorithm tileCompression =
+			        CompressionAlgorithm::None,
+			    uint32_t threads = 0);
+
+			/**
+			 * @brief
+			 * Encode an image as TiledRaw data in memory.
+			 * @details
+			 * As create(), returning the data instead of
+			 * writing a file.
+			 *
+			 * @param[in] image
+			 *	Image to encode.
+			 * @param[in] tileSize
+			 *	Dimensions of each tile.
+			 * @param[in] tileCompression
+			 *	Codec of each tile.
+			 * @param[in] threads
+			 *	Number of threads encoding tiles, or 0 for
+			 *	System::getCPUCount().
+			 *
+			 * @return
+			 *	TiledRaw image data.
+			 *
+			 * @throw Error::ParameterError
+			 *	image or tileSize is empty.
+			 * @throw Error::NotImplemented
+			 *	image does not have 8- or 16-bit samples, or
+			 *	tileCompression cannot be written.
+			 */
+			static Memory::uint8Array
+			encode(
+			    const Image &image,
+			    const Size &tileSize = Size(256, 256),
+			    CompressionAlgorithm tileCompression =
+			        CompressionAlgorithm::None,
+			    uint32_t threads = 0);
+
+			/**
+			 * Whether or not data is a TiledRaw image.
+			 *
+			 * @param[in] data
+			 *	The buffer to check.
+			 * @param[in] size
+			 *	The size of data.
+			 *
+			 * @return
+			 *	true if data appears to be a TiledRaw image,
+			 *	false otherwise
+			 */
+			static bool
+			isTiledRaw(
+			    const uint8_t *data,
+			    uint64_t size);
+
+			bool
+			decodesRegions()
+			    const;
+
+		protected:
+			Memory::uint8Array
+			decodeRawData()
+			    const;
+
+			void
+			decodeRawInto(
+			    uint8_t *dst,
+			    uint64_t stride)
+			    const;
+
+			Memory::uint8Array
+			decodeRawRegion(
+			    const Coordinate &origin,
+			    const Size &size)
+			    const;
+
+		private:
+			struct Header;
+			struct IndexEntry;
+			struct Mapping;
+
+			/** Refer to a mapped file */
+			TiledRaw(
+			    const std::shared_ptr<const Mapping> &mapping);
+
+			/**
+			 * @brief
+			 * Read and check the header and index.
+			 *
+			 * @throw Error::DataError
+			 *	Invalid header or index.
+			 */
+			void
+			readHeader();
+
+			/** @return Index entry of tile (column, row) */
+			IndexEntry
+			getIndexEntry(
+			    uint32_t column,
+			    uint32_t row)
+			    const;
+
+			/** @return Dimensions of tile (column, row) */
+			Size
+			getTileDimensions(
+			    uint32_t column,
+			    uint32_t row)
+			    const;
+
+			/**
+			 * @brief
+			 * Obtain the pixels of a tile.
+			 *
+			 * @param[in] column
+			 *	Column of the tile.
+			 * @param[in] row
+			 *	Row of the tile.
+			 * @param[out] buffer
+			 *	Holds decoded pixels of compressed tiles.
+			 *
+			 * @return
+			 *	View of the pixels, in the image data or
+			 *	buffer.
+			 *
+			 * @throw Error::DataError
+			 *	Error decoding the tile.
+			 */
+			Memory::ByteView
+			readTile(
+			    uint32_t column,
+			    uint32_t row,
+			    Memory::uint8Array &buffer)
+			    const;
+
+			/**
+			 * @brief
+			 * Copy the part of each tile within a rectangle
+			 * into rows owned by the caller.
+			 *
+			 * @param[in] origin
+			 *	Top-left pixel of the rectangle.
+			 * @param[in] size
+			 *	Dimensions of the rectangle.
+			 * @param[out] dst
+			 *	Start of the first row.
+			 * @param[in] stride
+			 *	Bytes between the starts of rows.
+			 *
+			 * @throw Error::DataError
+			 *	Error decoding a tile.
+			 */
+			void
+			copyRegion(
+			    const Coordinate &origin,
+			    const Size &size,
+			    uint8_t *dst,
+			    uint64_t stride)
+			    const;
+
+			/**
+			 * @brief
+			 * Encode image one row of tiles at a time.
+			 * @details
+			 * Each row of tiles is decoded from image on its
+			 * own if image.decodesRegions(); otherwise image
+			 * is decoded once, in full.
+			 *
+			 * @param[in] image
+			 *	Image to encode.
+			 * @param[in] tileSize
+			 *	Dimensions of each tile.
+			 * @param[in] tileCompression
+			 *	Codec of each tile.
+			 * @param[in] threads
+			 *	Number of threads encoding tiles.
+			 * @param[in] write
+			 *	Called with each piece of the output, in
+			 *	order.
+			 */
+			static void
+			write(
+			    const Image &image,
+			    const Size &tileSize,
+			    CompressionAlgorithm tileCompression,
+			    uint32_t threads,
+			    const std::function<void(const Memory::ByteView&)>
+			    &write);
+
+			/** Mapped file, if any, shared with copies */
+			std::shared_ptr<const Mapping> _mapping;
+			/** Dimensions of all but edge tiles */
+			Size _tileSize;
+			/** Number of tile columns and rows */
+			Size _tileCount;
+			/** Codec of each tile */
+			CompressionAlgorithm _tileCompression;
+		};
+	}
+}
+
+#endif /* __BE_IMAGE_TILEDRAW_H__ */
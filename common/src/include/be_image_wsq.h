@@ -24,6 +24,22 @@ namespace BiometricEvaluation
 		class WSQ : public Image
 		{
 		public:
+			/** Implementations of WSQ decoding */
+			enum class Decoder
+			{
+				/** NBIS wsq_decode_mem() */
+				NBIS,
+				/**
+				 * Table-driven Huffman decoding and
+				 * vectorized, multithreaded wavelet
+				 * reconstruction, producing the same
+				 * pixels as NBIS. Corrupt data for which
+				 * NBIS reads uninitialized memory or
+				 * writes past its buffers is rejected.
+				 */
+				Optimized
+			};
+
 			WSQ(
 			    const uint8_t *data,
 			    const uint64_t size);
@@ -31,12 +47,12 @@ namespace BiometricEvaluation
 			WSQ(
 			    const Memory::uint8Array &data);
 
+			/** data is referenced, not copied, by the object */
+			explicit WSQ(
+			    const Memory::ByteView &data);
+
 			~WSQ() = default;
 
-			Memory::uint8Array
-			getRawData()
-			    const;
-			    
 			Memory::uint8Array
 			getRawGrayscaleData(
 			    uint8_t depth) const;
@@ -58,7 +74,54 @@ namespace BiometricEvaluation
 			    const uint8_t *data,
 			    uint64_t size);
 
+			/**
+			 * @brief
+			 * Decode WSQ data.
+			 * @details
+			 * The Optimized decoder reconstructs each level of
+			 * the wavelet with the same floating-point
+			 * operations, in the same order, as NBIS, so its
+			 * pixels are identical for every instruction set
+			 * Image::Conversion::getInstructions() selects.
+			 * Streams whose subbands NBIS reconstructs from
+			 * outside the image are decoded by NBIS.
+			 *
+			 * @param[in] data
+			 *	WSQ data.
+			 * @param[in] scaleDenominator
+			 *	1, 2, 4, or 8, to decode at
+			 *	getReducedDimensions(scaleDenominator).
+			 * @param[in] decoder
+			 *	Implementation to use.
+			 * @param[in] threads
+			 *	Threads reconstructing large images, or 0
+			 *	for System::getCPUCount(). The calling
+			 *	thread is one of them. Ignored by NBIS.
+			 *
+			 * @return
+			 *	8-bit grayscale pixels.
+			 *
+			 * @throw Error::ParameterError
+			 *	Invalid scaleDenominator.
+			 * @throw Error::DataError
+			 *	Invalid WSQ data.
+			 */
+			static Memory::uint8Array
+			decode(
+			    const Memory::ByteView &data,
+			    uint8_t scaleDenominator = 1,
+			    Decoder decoder = Decoder::Optimized,
+			    uint32_t threads = 0);
+
 		protected:
+			Memory::uint8Array
+			decodeRawData()
+			    const;
+
+			Memory::uint8Array
+			decodeReducedRawData(
+			    uint8_t scaleDenominator)
+			    const;
 
 		private:
 
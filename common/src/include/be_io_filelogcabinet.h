@@ -108,6 +108,38 @@ namespace BiometricEvaluation {
 			 */
 			unsigned int getCount();
 
+			/**
+			 * Merge every FileLogsheet in the cabinet into a
+			 * single new FileLogsheet.
+			 *
+			 * Sheets are merged in order of their names using
+			 * FileLogsheet::mergeLogsheets(), and entries are
+			 * renumbered consecutively.
+			 *
+			 * @param[in] url
+			 *	The FileLogsheet to create, which should
+			 *	not be within the cabinet.
+			 * @param[in] description
+			 *	The text used to describe the new sheet.
+			 * @param[in] numThreads
+			 *	Number of threads used to copy sheets,
+			 *	or 0 for one per processor.
+			 *
+			 * @return
+			 *	The number of entries in the new sheet.
+			 * @throw Error::ObjectExists
+			 *	url already exists.
+			 * @throw Error::FileError
+			 *	Error reading or writing a sheet.
+			 * @throw Error::StrategyError
+			 *	An error occurred when using the underlying
+			 *	file system.
+			 */
+			uint32_t mergeLogsheets(
+			    const std::string &url,
+			    const std::string &description,
+			    uint32_t numThreads = 0);
+
 		private:
 			 
 			/* The directory where the cabinet is rooted */
@@ -11,7 +11,10 @@
 #ifndef __BE_IO_FILELOGSHEET_H__
 #define __BE_IO_FILELOGSHEET_H__
 
+#include <pthread.h>
+
 #include <fstream>
+#include <functional>
 #include <vector>
 
 #include <be_io_logsheet.h>
@@ -30,6 +33,12 @@ namespace BiometricEvaluation
 		 * the client by the LogCabinet object. All sheets created in
 		 * this manner are placed in a common area maintained by the
 		 * cabinet.
+		 *
+		 * By default, every entry is written through to the file
+		 * as it is committed. In asynchronous mode, entries are
+		 * instead formatted into memory and written by a
+		 * background thread in large batches; see
+		 * setAsynchronous().
 		 */
 		class FileLogsheet : public IO::Logsheet
 		{
@@ -109,6 +118,97 @@ namespace BiometricEvaluation
 			    std::vector<std::shared_ptr<FileLogsheet>>
 			    &logsheets);
 
+			/**
+			 * @brief
+			 * Merge FileLogsheet files into a new FileLogsheet,
+			 * in parallel.
+			 * @details
+			 * The bodies of the sheets are concatenated in the
+			 * order given, and entries are renumbered
+			 * consecutively. Comments and debug entries are
+			 * kept. The position of each sheet in the output is
+			 * planned before any data is copied, so the sheets
+			 * are copied concurrently with large block reads
+			 * and writes, renumbering entries as they pass
+			 * through. Sheets must not be written while they
+			 * are merged.
+			 *
+			 * @param[in] urls
+			 *	FileLogsheets to merge.
+			 * @param[in] url
+			 *	FileLogsheet to create.
+			 * @param[in] description
+			 *	Description of the new FileLogsheet.
+			 * @param[in] numThreads
+			 *	Number of sheets to copy at once, or 0
+			 *	for one per online processor.
+			 *
+			 * @return
+			 *	Number of entries in the new FileLogsheet.
+			 *
+			 * @throw Error::ParameterError
+			 *	A URL is malformed.
+			 * @throw Error::ObjectExists
+			 *	url already exists.
+			 * @throw Error::ObjectDoesNotExist
+			 *	A sheet in urls does not exist.
+			 * @throw Error::FileError
+			 *	Error reading or writing a sheet.
+			 * @throw Error::StrategyError
+			 *	A sheet has entry numbers that are not ten
+			 *	digits.
+			 */
+			static uint32_t
+			mergeLogsheets(
+			    const std::vector<std::string> &urls,
+			    const std::string &url,
+			    const std::string &description,
+			    uint32_t numThreads = 0);
+
+			/**
+			 * @brief
+			 * Merge the entries of FileLogsheet files into a
+			 * new FileLogsheet, in order.
+			 * @details
+			 * Each sheet must already be in order. Entries are
+			 * merged k-way, taking the entry that comes first
+			 * among the next entry of each sheet, and are
+			 * renumbered consecutively. Comments and debug
+			 * entries are not merged.
+			 *
+			 * @param[in] urls
+			 *	FileLogsheets to merge.
+			 * @param[in] url
+			 *	FileLogsheet to create.
+			 * @param[in] description
+			 *	Description of the new FileLogsheet.
+			 * @param[in] before
+			 *	Returns whether the first entry comes
+			 *	before the second. Entries are given
+			 *	without delimiter and number.
+			 *
+			 * @return
+			 *	Number of entries in the new FileLogsheet.
+			 *
+			 * @throw Error::ParameterError
+			 *	A URL is malformed.
+			 * @throw Error::ObjectExists
+			 *	url already exists.
+			 * @throw Error::ObjectDoesNotExist
+			 *	A sheet in urls does not exist.
+			 * @throw Error::FileError
+			 *	Error reading a sheet.
+			 * @throw Error::StrategyError
+			 *	Error writing the new FileLogsheet.
+			 */
+			static uint32_t
+			mergeLogsheets(
+			    const std::vector<std::string> &urls,
+			    const std::string &url,
+			    const std::string &description,
+			    const std::function<bool(const std::string &first,
+			    const std::string &second)> &before);
+
 			/** Sequence from beginning */
 			static const int32_t BE_FILELOGSHEET_SEQ_START = 1;
 			/** Sequence from current position */
@@ -162,10 +262,107 @@ namespace BiometricEvaluation
 			    const std::string &entry);
 
 
+			/**
+			 * @brief
+			 * Enable or disable asynchronous writing.
+			 * @details
+			 * While asynchronous, committed entries are
+			 * appended to an in-memory buffer and a background
+			 * thread writes the buffer to the file once it
+			 * holds bufferSize bytes, or once its oldest entry
+			 * has waited flushLatency microseconds, whichever
+			 * comes first. Writers block only when the
+			 * background thread falls behind by several
+			 * buffers.
+			 *
+			 * Auto-sync is ignored while asynchronous; sync()
+			 * is a barrier that returns once every entry
+			 * committed before it is durably on disk.
+			 * Disabling asynchronous mode writes all buffered
+			 * entries first. The background thread is not
+			 * inherited by fork(), so asynchronous mode should
+			 * be enabled by the process that writes entries.
+			 *
+			 * @param[in] state
+			 *	Whether or not to write asynchronously.
+			 * @param[in] flushLatency
+			 *	Longest time, in microseconds, an entry
+			 *	remains in memory before being written.
+			 * @param[in] bufferSize
+			 *	Number of bytes buffered before a write is
+			 *	started.
+			 *
+			 * @throw Error::ParameterError
+			 *	flushLatency or bufferSize is 0.
+			 * @throw Error::StrategyError
+			 *	Could not open the log file, start the
+			 *	background thread, or write buffered
+			 *	entries.
+			 */
+			void
+			setAsynchronous(
+			    bool state,
+			    uint64_t flushLatency = 100000,
+			    uint64_t bufferSize = 1048576);
+
+			/**
+			 * @return
+			 *	Whether or not entries are written
+			 *	asynchronously.
+			 */
+			bool
+			getAsynchronous()
+			    const;
+
+			/**
+			 * @brief
+			 * Enable or disable maintenance of the sidecar
+			 * entry index.
+			 * @details
+			 * While enabled, the offset of each entry is
+			 * appended to the index read by
+			 * FileLogsheetReader, so that the sheet can later
+			 * be opened and read by entry number without
+			 * scanning it. Enabling brings an existing index
+			 * up to date first.
+			 *
+			 * @param[in] state
+			 *	Whether or not to maintain the index.
+			 *
+			 * @throw Error::FileError
+			 *	Could not update or open the index.
+			 * @throw Error::StrategyError
+			 *	Could not write buffered entries.
+			 */
+			void
+			setIndexing(
+			    bool state);
+
+			/**
+			 * @return
+			 *	Whether or not the sidecar entry index is
+			 *	maintained.
+			 */
+			bool
+			getIndexing()
+			    const;
+
 			/* Declare implementations of parent interface */
 			void write(const std::string &entry);
 			void writeComment(const std::string &entry);
 			void writeDebug(const std::string &entry);
+
+			/**
+			 * @brief
+			 * Flush entries to the log file.
+			 * @details
+			 * When asynchronous, block until every entry
+			 * committed so far has been written and the file
+			 * has been synchronized to stable storage.
+			 *
+			 * @throw Error::StrategyError
+			 *	Error writing or synchronizing the file.
+			 */
 			void sync();
 			
 		protected:
@@ -192,6 +389,92 @@ namespace BiometricEvaluation
 
 			/** Position of the sequencer, relative to SOF */
 			streamoff _cursor;
+
+		private:
+			/**
+			 * @brief
+			 * Record the position of the next entry in the
+			 * sidecar index.
+			 *
+			 * @throw Error::StrategyError
+			 *	Could not write the index.
+			 */
+			void
+			indexEntry();
+
+			/**
+			 * @brief
+			 * Hand a formatted line to the background thread.
+			 *
+			 * @param[in] line
+			 *	Entry, including delimiter and newline.
+			 *
+			 * @throw Error::StrategyError
+			 *	A previous background write failed.
+			 */
+			void
+			appendAsynchronous(
+			    const std::string &line);
+
+			/**
+			 * @brief
+			 * Block until the background thread has written
+			 * every line appended so far.
+			 *
+			 * @throw Error::StrategyError
+			 *	A background write failed.
+			 */
+			void
+			drainAsynchronous();
+
+			/**
+			 * @brief
+			 * Body of the background thread.
+			 *
+			 * @param[in] ptr
+			 *	The FileLogsheet being written.
+			 */
+			static void *
+			asyncWriter(
+			    void *ptr);
+
+			/** Path to the log file */
+			std::string _pathname;
+			/** Size of the log file, including buffered lines */
+			uint64_t _logSize;
+			/** Stream for the sidecar index, when indexing */
+			std::unique_ptr<std::ofstream> _indexFile;
+
+			/** Whether or not writing asynchronously */
+			bool _async;
+			/** Maximum time entries are buffered (usec) */
+			uint64_t _flushLatency;
+			/** Amount of data that starts a write */
+			uint64_t _bufferSize;
+			/** Descriptor used by the background thread */
+			int _asyncFD;
+			/** Background thread */
+			pthread_t _asyncThread;
+			/** Protects the asynchronous state below */
+			pthread_mutex_t _asyncMutex;
+			/** Signals the background thread */
+			pthread_cond_t _asyncWork;
+			/** Signals writers that a batch was written */
+			pthread_cond_t _asyncDone;
+			/** Lines not yet taken by the background thread */
+			std::string _pending;
+			/** When the oldest pending line was appended */
+			struct timespec _pendingSince;
+			/** Bytes ever appended */
+			uint64_t _appended;
+			/** Bytes ever written */
+			uint64_t _written;
+			/** Bytes that must be written promptly */
+			uint64_t _flushTarget;
+			/** Request for the background thread to exit */
+			bool _asyncStop;
+			/** errno of a failed background write, or 0 */
+			int _asyncError;
 		};
 	}
 }
@@ -0,0 +1,280 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_IO_FILELOGSHEETREADER_H__
+#define __BE_IO_FILELOGSHEETREADER_H__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BiometricEvaluation
+{
+	namespace IO
+	{
+		/**
+		 * @brief
+		 * Random access to the numbered entries of a FileLogsheet.
+		 * @details
+		 * The log file is memory-mapped read-only and the
+		 * position of every numbered entry is found once, so that
+		 * any entry can then be retrieved by number without
+		 * reading the entries before it.
+		 *
+		 * Entry positions may be kept in a sidecar index file
+		 * next to the log (see getIndexPathname()), written by
+		 * FileLogsheet::setIndexing() or by a FileLogsheetReader.
+		 * When the index is present, only the part of the log
+		 * written after the last indexed entry is scanned. An
+		 * index that does not match the log, such as one written
+		 * ahead of entries lost in a crash, is repaired.
+		 *
+		 * A FileLogsheetReader is a snapshot of the log when it
+		 * was constructed; entries written afterwards are not
+		 * seen. All const methods may be called concurrently,
+		 * so partition() can be used to divide the entries
+		 * among threads or processes.
+		 */
+		class FileLogsheetReader
+		{
+		public:
+			/** How the sidecar index is used */
+			enum class IndexMode {
+				/** Scan the entire log; ignore any index */
+				None,
+				/** Use an index if present; never write it */
+				ReadOnly,
+				/** Use, create, or repair the index */
+				Update
+			};
+
+			/**
+			 * @brief
+			 * Map a FileLogsheet for reading.
+			 *
+			 * @param[in] url
+			 *	Path name or file:// URL of the
+			 *	FileLogsheet.
+			 * @param[in] indexMode
+			 *	How to use the sidecar index. Use
+			 *	IndexMode::ReadOnly while a FileLogsheet
+			 *	with indexing enabled is still writing
+			 *	the log.
+			 *
+			 * @throw Error::ParameterError
+			 *	url does not name a file.
+			 * @throw Error::ObjectDoesNotExist
+			 *	The FileLogsheet does not exist.
+			 * @throw Error::FileError
+			 *	Could not read the FileLogsheet, or could
+			 *	not write the index.
+			 */
+			FileLogsheetReader(
+			    const std::string &url,
+			    IndexMode indexMode = IndexMode::Update);
+
+			~FileLogsheetReader();
+
+			/**
+			 * @return
+			 *	Number of numbered entries, which is also
+			 *	the number of the last entry.
+			 */
+			uint32_t
+			getEntryCount()
+			    const;
+
+			/**
+			 * @brief
+			 * Obtain an entry by number.
+			 *
+			 * @param[in] number
+			 *	Number of the entry, from 1 to
+			 *	getEntryCount().
+			 * @param[in] trim
+			 *	Whether or not to remove the entry
+			 *	delimiter and number.
+			 *
+			 * @return
+			 *	The entry, including any continuation
+			 *	lines.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 *	No entry has number.
+			 */
+			std::string
+			getEntry(
+			    uint32_t number,
+			    bool trim = true)
+			    const;
+
+			/**
+			 * @param[in] number
+			 *	Number of the entry, from 1 to
+			 *	getEntryCount().
+			 *
+			 * @return
+			 *	Offset of the entry from the start of the
+			 *	log file.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 *	No entry has number.
+			 */
+			uint64_t
+			getEntryOffset(
+			    uint32_t number)
+			    const;
+
+			/**
+			 * @brief
+			 * Divide the entries into contiguous ranges.
+			 *
+			 * @param[in] count
+			 *	Number of ranges desired.
+			 *
+			 * @return
+			 *	Up to count pairs of first and last entry
+			 *	numbers, together covering every entry and
+			 *	differing in size by at most one.
+			 */
+			std::vector<std::pair<uint32_t, uint32_t>>
+			partition(
+			    uint32_t count)
+			    const;
+
+			/**
+			 * @brief
+			 * Visit a range of entries, in order.
+			 *
+			 * @param[in] first
+			 *	Number of the first entry to visit.
+			 * @param[in] last
+			 *	Number of the last entry to visit.
+			 * @param[in] visitor
+			 *	Called with each entry number and the
+			 *	entry, as trimmed by getEntry().
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 *	first or last is not an entry number.
+			 */
+			void
+			forEachEntry(
+			    uint32_t first,
+			    uint32_t last,
+			    const std::function<void(uint32_t number,
+			    const std::string &entry)> &visitor)
+			    const;
+
+			/**
+			 * @param[in] pathname
+			 *	Path to a FileLogsheet.
+			 *
+			 * @return
+			 *	Path to the sidecar index of pathname.
+			 */
+			static std::string
+			getIndexPathname(
+			    const std::string &pathname);
+
+			/**
+			 * @brief
+			 * Bring the sidecar index of a FileLogsheet up to
+			 * date.
+			 *
+			 * @param[in] url
+			 *	Path name or file:// URL of the
+			 *	FileLogsheet.
+			 *
+			 * @return
+			 *	Number of entries in the FileLogsheet.
+			 *
+			 * @throw Error::ParameterError
+			 *	url does not name a file.
+			 * @throw Error::ObjectDoesNotExist
+			 *	The FileLogsheet does not exist.
+			 * @throw Error::FileError
+			 *	Could not read the FileLogsheet or write
+			 *	the index.
+			 */
+			static uint32_t
+			updateIndex(
+			    const std::string &url);
+
+			/* Mappings may not be duplicated */
+			FileLogsheetReader(const FileLogsheetReader&) = delete;
+			FileLogsheetReader& operator=(
+			    const FileLogsheetReader&) = delete;
+
+		private:
+			/**
+			 * @brief
+			 * Read the sidecar index, discarding entries that
+			 * do not match the log.
+			 *
+			 * @return
+			 *	Whether or not the index file must be
+			 *	rewritten.
+			 */
+			bool
+			loadIndex();
+
+			/**
+			 * @brief
+			 * Record the offset of every entry at or after
+			 * offset.
+			 *
+			 * @param[in] offset
+			 *	Start of a line.
+			 */
+			void
+			scan(
+			    uint64_t offset);
+
+			/**
+			 * @brief
+			 * Write offsets to the sidecar index.
+			 *
+			 * @param[in] first
+			 *	Index of the first offset to write.
+			 * @param[in] rewrite
+			 *	Whether to replace the index file or
+			 *	append to it.
+			 */
+			void
+			writeIndex(
+			    uint64_t first,
+			    bool rewrite)
+			    const;
+
+			/**
+			 * @return
+			 *	Whether or not a numbered entry starts at
+			 *	offset.
+			 */
+			bool
+			isEntryAt(
+			    uint64_t offset)
+			    const;
+
+			/** Path to the log file */
+			std::string _pathname;
+			/** Read-only mapping of the log file */
+			const char *_map;
+			/** Size of the log file when mapped */
+			uint64_t _size;
+			/** Offset of each entry, indexed by number - 1 */
+			std::vector<uint64_t> _offsets;
+		};
+	}
+}
+
+#endif /* __BE_IO_FILELOGSHEETREADER_H__ */
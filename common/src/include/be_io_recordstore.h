@@ -17,6 +17,7 @@
 #include <be_framework_enumeration.h>
 #include <be_io.h>
 #include <be_memory_autoarray.h>
+#include <be_memory_byteview.h>
 
 /*
  * This file contains the class declaration for the RecordStore, a virtual
@@ -198,6 +199,28 @@ namespace BiometricEvaluation {
 			    const std::string &key,
 			    const Memory::uint8Array &data);
 
+			/**
+			 * Insert a record into the store.
+			 *
+			 * @param[in] key
+			 *	The key of the record to be inserted.
+			 * @param[in] data
+			 *	The data for the record, such as a region
+			 *	of a memory-mapped file or message buffer.
+			 *
+			 * @throw Error::ObjectExists
+			 *	A record with the given key is already
+			 *	present.
+			 * @throw Error::StrategyError
+			 *	The RecordStore is opened read-only, or
+			 *	an error occurred when using the underlying
+			 *	storage system.
+			 */
+			void
+			virtual insert(
+			    const std::string &key,
+			    const Memory::ByteView &data);
+
 			/**
 			 * Insert a record into the store.
 			 *
@@ -276,6 +299,26 @@ namespace BiometricEvaluation {
 			    const std::string &key,
 			    const Memory::uint8Array &data);
 
+			/**
+			 * Replace a complete record in a RecordStore.
+			 *
+			 * @param[in] key
+			 *	The key of the record to be replaced.
+			 * @param[in] data
+			 *	The data for the record, such as a region
+			 *	of a memory-mapped file or message buffer.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 *	A record for the key does not exist.
+			 * @throw Error::StrategyError
+			 *	The RecordStore is opened read-only, or
+			 *	an error occurred when using the underlying
+			 *	storage system.
+			 */	
+			virtual void replace(
+			    const std::string &key,
+			    const Memory::ByteView &data);
+
 			/**
 			 * Replace a complete record in a RecordStore.
 			 *
@@ -0,0 +1,525 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_IO_RESULTSHEET_H__
+#define __BE_IO_RESULTSHEET_H__
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <be_memory_autoarray.h>
+
+namespace BiometricEvaluation
+{
+	namespace IO
+	{
+		/**
+		 * @brief
+		 * A typed, columnar, binary log of results.
+		 * @details
+		 * Where a Logsheet records each result as a line of text
+		 * that must later be parsed, a ResultSheet records each
+		 * result as a row of typed fields declared up front in a
+		 * schema. Rows are grouped into blocks of up to
+		 * rowsPerBlock rows, and within a block the values of each
+		 * column are stored contiguously, optionally compressed.
+		 *
+		 * A ResultSheet is either created, in which case rows may
+		 * only be appended, or opened, in which case the file is
+		 * memory-mapped read-only and columns are returned as
+		 * arrays of native values that can be iterated without
+		 * parsing. An opened ResultSheet ignores a partially
+		 * written final block, so a sheet whose writer did not
+		 * finish can still be read.
+		 *
+		 * Values are stored in the byte order of the writer, and
+		 * a ResultSheet can only be opened on a machine with the
+		 * same byte order.
+		 */
+		class ResultSheet
+		{
+		public:
+			/** Types of values that may be stored in a column */
+			enum class Type : uint8_t {
+				/** 64-bit signed integer */
+				Integer = 1,
+				/** 64-bit IEEE-754 floating point */
+				Real = 2,
+				/** Variable-length string */
+				String = 3
+			};
+
+			/** Description of one column of a ResultSheet */
+			struct Column {
+				/** Name of the column */
+				std::string name;
+				/** Type of values in the column */
+				Type type;
+			};
+
+			/**
+			 * @brief
+			 * Zero-copy view of a column of strings from one
+			 * block.
+			 */
+			class StringColumn {
+			public:
+				/**
+				 * @param[in] offsets
+				 *	rowCount + 1 offsets into data.
+				 * @param[in] data
+				 *	Concatenated string values.
+				 * @param[in] rowCount
+				 *	Number of values.
+				 */
+				StringColumn(
+				    const uint64_t *offsets,
+				    const char *data,
+				    uint64_t rowCount);
+
+				/** @return Number of values. */
+				uint64_t
+				size()
+				    const;
+
+				/**
+				 * @param[in] row
+				 *	Row within the block.
+				 * @return
+				 *	Start of the value in row, which is
+				 *	not NUL-terminated.
+				 */
+				const char*
+				data(
+				    uint64_t row)
+				    const;
+
+				/**
+				 * @param[in] row
+				 *	Row within the block.
+				 * @return
+				 *	Length of the value in row.
+				 */
+				uint64_t
+				length(
+				    uint64_t row)
+				    const;
+
+				/**
+				 * @param[in] row
+				 *	Row within the block.
+				 * @return
+				 *	Copy of the value in row.
+				 */
+				std::string
+				operator[](
+				    uint64_t row)
+				    const;
+
+			private:
+				const uint64_t *_offsets;
+				const char *_data;
+				uint64_t _rowCount;
+			};
+
+			/** Default number of rows in each block */
+			static const uint32_t DefaultRowsPerBlock = 65536;
+
+			/**
+			 * @brief
+			 * Create a new ResultSheet.
+			 *
+			 * @param[in] pathname
+			 *	Path of the file to create.
+			 * @param[in] schema
+			 *	Columns of each row, in order.
+			 * @param[in] description
+			 *	Text describing the sheet.
+			 * @param[in] rowsPerBlock
+			 *	Maximum number of rows in each block.
+			 * @param[in] compress
+			 *	Whether or not to compress each column
+			 *	of each block, when that makes it smaller.
+			 *
+			 * @throw Error::ParameterError
+			 *	schema is empty, has duplicate names,
+			 *	or rowsPerBlock is 0.
+			 * @throw Error::ObjectExists
+			 *	pathname already exists.
+			 * @throw Error::FileError
+			 *	Could not create or write pathname.
+			 */
+			ResultSheet(
+			    const std::string &pathname,
+			    const std::vector<Column> &schema,
+			    const std::string &description = "",
+			    uint32_t rowsPerBlock = DefaultRowsPerBlock,
+			    bool compress = false);
+
+			/**
+			 * @brief
+			 * Open an existing ResultSheet for reading.
+			 *
+			 * @param[in] pathname
+			 *	Path of the ResultSheet.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 *	pathname does not exist.
+			 * @throw Error::FileError
+			 *	Could not open or map pathname.
+			 * @throw Error::StrategyError
+			 *	pathname is not a ResultSheet, or was
+			 *	written with a different byte order.
+			 * @throw Error::DataError
+			 *	A block is smaller than its header.
+			 */
+			ResultSheet(
+			    const std::string &pathname);
+
+			/**
+			 * @brief
+			 * Destructor.
+			 * @details
+			 * A created ResultSheet writes any buffered rows.
+			 */
+			~ResultSheet();
+
+			/** @return The columns of each row. */
+			std::vector<Column>
+			getSchema()
+			    const;
+
+			/** @return The description of the sheet. */
+			std::string
+			getDescription()
+			    const;
+
+			/**
+			 * @param[in] name
+			 *	Name of a column.
+			 * @return
+			 *	Position of the column in the schema.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 *	No column is named name.
+			 */
+			uint32_t
+			getColumnIndex(
+			    const std::string &name)
+			    const;
+
+			/**
+			 * @return
+			 *	Number of complete rows, including rows
+			 *	not yet written when created.
+			 */
+			uint64_t
+			getRowCount()
+			    const;
+
+			/*
+			 * Writing.
+			 */
+
+			/**
+			 * @brief
+			 * Append an Integer to the current row.
+			 *
+			 * @param[in] value
+			 *	Value of the next column.
+			 *
+			 * @throw Error::StrategyError
+			 *	Sheet was opened for reading.
+			 * @throw Error::ParameterError
+			 *	Next column is not an Integer, or the row
+			 *	is complete.
+			 * @throw Error::FileError
+			 *	Error writing a completed block.
+			 */
+			void
+			appendInteger(
+			    int64_t value);
+
+			/**
+			 * @brief
+			 * Append a Real to the current row.
+			 *
+			 * @param[in] value
+			 *	Value of the next column.
+			 *
+			 * @throw Error::StrategyError
+			 *	Sheet was opened for reading.
+			 * @throw Error::ParameterError
+			 *	Next column is not a Real, or the row is
+			 *	complete.
+			 */
+			void
+			appendReal(
+			    double value);
+
+			/**
+			 * @brief
+			 * Append a String to the current row.
+			 *
+			 * @param[in] value
+			 *	Value of the next column.
+			 *
+			 * @throw Error::StrategyError
+			 *	Sheet was opened for reading.
+			 * @throw Error::ParameterError
+			 *	Next column is not a String, or the row
+			 *	is complete.
+			 */
+			void
+			appendString(
+			    const std::string &value);
+
+			/**
+			 * @brief
+			 * Complete the current row.
+			 * @details
+			 * When the block is full, it is written to the
+			 * file.
+			 *
+			 * @throw Error::StrategyError
+			 *	Sheet was opened for reading.
+			 * @throw Error::ParameterError
+			 *	Not every column of the row has a value.
+			 * @throw Error::FileError
+			 *	Error writing the block.
+			 */
+			void
+			endRow();
+
+			/**
+			 * @brief
+			 * Write all complete rows to the file.
+			 * @details
+			 * Buffered rows are written as a block smaller
+			 * than rowsPerBlock.
+			 *
+			 * @throw Error::StrategyError
+			 *	Sheet was opened for reading.
+			 * @throw Error::ParameterError
+			 *	The current row is incomplete.
+			 * @throw Error::FileError
+			 *	Error writing the block.
+			 */
+			void
+			sync();
+
+			/*
+			 * Reading.
+			 */
+
+			/** @return Number of blocks in an opened sheet. */
+			uint64_t
+			getBlockCount()
+			    const;
+
+			/**
+			 * @param[in] block
+			 *	Index of the block.
+			 * @return
+			 *	Number of rows in block.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 *	block is out of range.
+			 */
+			uint64_t
+			getBlockRowCount(
+			    uint64_t block)
+			    const;
+
+			/**
+			 * @brief
+			 * Obtain the values of an Integer column of a
+			 * block.
+			 *
+			 * @param[in] block
+			 *	Index of the block.
+			 * @param[in] column
+			 *	Index of the column.
+			 *
+			 * @return
+			 *	getBlockRowCount(block) values. For an
+			 *	uncompressed block, the values are read
+			 *	directly from the mapping and valid for the
+			 *	lifetime of this object; otherwise, they are
+			 *	valid until a column of another compressed
+			 *	block is requested.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 *	block or column is out of range.
+			 * @throw Error::ParameterError
+			 *	column is not an Integer column.
+			 * @throw Error::StrategyError
+			 *	Sheet was created, not opened, or a column
+			 *	could not be decompressed.
+			 * @throw Error::DataError
+			 *	The column is corrupt.
+			 */
+			const int64_t*
+			getIntegerColumn(
+			    uint64_t block,
+			    uint32_t column);
+
+			/**
+			 * @brief
+			 * Obtain the values of a Real column of a block.
+			 *
+			 * @param[in] block
+			 *	Index of the block.
+			 * @param[in] column
+			 *	Index of the column.
+			 *
+			 * @return
+			 *	getBlockRowCount(block) values, valid as
+			 *	for getIntegerColumn().
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 *	block or column is out of range.
+			 * @throw Error::ParameterError
+			 *	column is not a Real column.
+			 * @throw Error::StrategyError
+			 *	Sheet was created, not opened, or a column
+			 *	could not be decompressed.
+			 * @throw Error::DataError
+			 *	The column is corrupt.
+			 */
+			const double*
+			getRealColumn(
+			    uint64_t block,
+			    uint32_t column);
+
+			/**
+			 * @brief
+			 * Obtain the values of a String column of a block.
+			 *
+			 * @param[in] block
+			 *	Index of the block.
+			 * @param[in] column
+			 *	Index of the column.
+			 *
+			 * @return
+			 *	View of getBlockRowCount(block) values,
+			 *	valid as for getIntegerColumn().
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 *	block or column is out of range.
+			 * @throw Error::ParameterError
+			 *	column is not a String column.
+			 * @throw Error::StrategyError
+			 *	Sheet was created, not opened, or a column
+			 *	could not be decompressed.
+			 * @throw Error::DataError
+			 *	The column is corrupt.
+			 */
+			StringColumn
+			getStringColumn(
+			    uint64_t block,
+			    uint32_t column);
+
+			/* Prevent copying of ResultSheet objects */
+			ResultSheet(const ResultSheet&) = delete;
+			ResultSheet& operator=(const ResultSheet&) = delete;
+
+		private:
+			/** Header of each block in the file */
+			struct BlockHeader;
+			/** Location of a column within a block */
+			struct ChunkEntry;
+
+			/** Values of one column of the block being built */
+			struct ColumnBuffer {
+				/** Integers, Reals, or String bytes */
+				std::vector<uint8_t> values;
+				/** End of each String in values */
+				std::vector<uint64_t> offsets;
+			};
+
+			/**
+			 * @brief
+			 * Check that the next value may be of type.
+			 *
+			 * @return
+			 *	Buffer for the next value.
+			 */
+			ColumnBuffer&
+			nextColumn(
+			    Type type);
+
+			/** @brief Write the buffered rows as a block. */
+			void
+			writeBlock();
+
+			/**
+			 * @param[out] length
+			 *	Uncompressed size of the column.
+			 *
+			 * @return
+			 *	Uncompressed contents of a column of a
+			 *	block.
+			 *
+			 * @throw Error::DataError
+			 *	The column lies outside its block or is
+			 *	too small for the block's rows.
+			 */
+			const uint8_t*
+			getChunk(
+			    uint64_t block,
+			    uint32_t column,
+			    Type type,
+			    uint64_t &length);
+
+			/** Path to the file */
+			std::string _pathname;
+			/** Columns of each row */
+			std::vector<Column> _schema;
+			/** Description of the sheet */
+			std::string _description;
+			/** Whether or not the sheet was opened for reading */
+			bool _readOnly;
+
+			/** Stream for writing a created sheet */
+			std::unique_ptr<std::ofstream> _file;
+			/** Maximum number of rows per block */
+			uint32_t _rowsPerBlock;
+			/** Whether or not to compress columns */
+			bool _compress;
+			/** Columns of the block being built */
+			std::vector<ColumnBuffer> _buffers;
+			/** Index of the next column of the current row */
+			uint32_t _nextColumn;
+			/** Complete rows in the block being built */
+			uint32_t _bufferedRows;
+			/** Rows already written */
+			uint64_t _writtenRows;
+
+			/** Mapping of an opened sheet */
+			const uint8_t *_map;
+			/** Size of _map */
+			uint64_t _mapSize;
+			/** Start of each complete block in _map */
+			std::vector<const uint8_t*> _blocks;
+			/** Rows in all blocks of an opened sheet */
+			uint64_t _rowCount;
+			/** Block whose columns are in _decompressed */
+			uint64_t _decompressedBlock;
+			/** Decompressed columns of _decompressedBlock */
+			std::vector<Memory::uint8Array> _decompressed;
+		};
+	}
+}
+
+#endif /* __BE_IO_RESULTSHEET_H__ */
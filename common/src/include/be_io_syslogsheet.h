@@ -10,7 +10,13 @@
 
 #ifndef __BE_IO_SYSLOGSHEET_H__
 #define __BE_IO_SYSLOGSHEET_H__
-#endif
+
+#include <pthread.h>
+#include <time.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
 
 #include <be_io_logsheet.h>
 
@@ -40,11 +46,41 @@ namespace BiometricEvaluation
 		 * the process ID.
 		 * Multi-line messages are segmented and sent the to logger
 		 * as separate entries with the same timestamp and sequence
-		 * number.
+		 * number, in a single write.
+		 *
+		 * Messages are sent over TCP by default. UDP, or a local
+		 * Unix-domain datagram socket such as /dev/log, may be
+		 * named in the URL instead. Datagrams that cannot be
+		 * delivered are counted by getDroppedCount() rather than
+		 * reported as errors.
+		 *
+		 * By default each entry is sent before write() returns.
+		 * In asynchronous mode, entries are instead queued and
+		 * sent in batches by a background thread, so that a
+		 * slow logger does not delay the caller; see
+		 * setAsynchronous().
 		 */
 		class SysLogsheet : public IO::Logsheet
 		{
 		public:
+			/** How messages reach the logging service */
+			enum class Transport {
+				/** Stream socket to hostname:port */
+				TCP,
+				/** Datagram socket to hostname:port */
+				UDP,
+				/** Unix-domain datagram socket */
+				Unix
+			};
+
+			/** What to do when the asynchronous queue is full */
+			enum class OverflowPolicy {
+				/** Wait for the queue to drain */
+				Block,
+				/** Discard the entry */
+				Drop
+			};
+
 			/**
 			 * @brief
 			 * Create a new log sheet.
@@ -52,7 +88,11 @@ namespace BiometricEvaluation
 			 * @param[in] url
 			 *	The Uniform Resource Locator describing the
 			 *	logging service. Accepted forms are
-			 *	syslog://hostname:port
+			 *	syslog://hostname:port (TCP),
+			 *	syslog://hostname:port/tcp,
+			 *	syslog://hostname:port/udp, and
+			 *	syslog:///path/to/socket (Unix-domain
+			 *	datagram socket).
 			 * @param[in] description
 			 *	The text used to describe the sheet.
 			 *	This text is written into the log
@@ -84,7 +124,11 @@ namespace BiometricEvaluation
 			 * @param[in] url
 			 *	The Uniform Resource Locator describing the
 			 *	logging service. Accepted forms are
-			 *	syslog://hostname:port
+			 *	syslog://hostname:port (TCP),
+			 *	syslog://hostname:port/tcp,
+			 *	syslog://hostname:port/udp, and
+			 *	syslog:///path/to/socket (Unix-domain
+			 *	datagram socket).
 			 * @param[in] description
 			 *	The text used to describe the sheet.
 			 *	This text is written into the log
@@ -116,6 +160,80 @@ namespace BiometricEvaluation
 			/** Destructor */
 			~SysLogsheet();
 
+			/**
+			 * @brief
+			 * Enable or disable asynchronous sending.
+			 * @details
+			 * While asynchronous, entries are formatted and
+			 * queued, and a background thread sends everything
+			 * queued in as few writes as possible. When the
+			 * queue already holds queueSize bytes, an entry is
+			 * either waited on or dropped, as chosen by
+			 * policy. Disabling asynchronous mode sends all
+			 * queued entries first.
+			 *
+			 * The background thread is not inherited by
+			 * fork(), so asynchronous mode should be enabled
+			 * by the process that writes entries.
+			 *
+			 * @param[in] state
+			 *	Whether or not to send asynchronously.
+			 * @param[in] queueSize
+			 *	Number of bytes of entries that may wait
+			 *	to be sent.
+			 * @param[in] policy
+			 *	What to do with an entry that does not
+			 *	fit in the queue.
+			 *
+			 * @throw Error::ParameterError
+			 *	queueSize is 0.
+			 * @throw Error::StrategyError
+			 *	Could not start the background thread, or
+			 *	could not send queued entries.
+			 */
+			void
+			setAsynchronous(
+			    bool state,
+			    uint64_t queueSize = 1048576,
+			    OverflowPolicy policy = OverflowPolicy::Block);
+
+			/**
+			 * @return
+			 *	Whether or not entries are sent
+			 *	asynchronously.
+			 */
+			bool
+			getAsynchronous()
+			    const;
+
+			/**
+			 * @return
+			 *	How messages reach the logging service.
+			 */
+			Transport
+			getTransport()
+			    const;
+
+			/**
+			 * @return
+			 *	Number of messages sent to the logging
+			 *	service. Each line of a multi-line entry
+			 *	is a message.
+			 */
+			uint64_t
+			getSentCount()
+			    const;
+
+			/**
+			 * @return
+			 *	Number of messages discarded because the
+			 *	asynchronous queue was full or a datagram
+			 *	could not be sent.
+			 */
+			uint64_t
+			getDroppedCount()
+			    const;
+
 			/* Declare implementations of parent interface */
 			void
 			write(const std::string &entry);
@@ -123,6 +241,17 @@ namespace BiometricEvaluation
 			writeComment(const std::string &entry);
 			void
 			writeDebug(const std::string &entry);
+
+			/**
+			 * @brief
+			 * Wait for entries to be sent.
+			 * @details
+			 * When asynchronous, block until every entry
+			 * written so far has been sent or dropped.
+			 *
+			 * @throw Error::StrategyError
+			 *	Error sending entries to the logger.
+			 */
 			void
 			sync();
 
@@ -145,6 +274,29 @@ namespace BiometricEvaluation
 			    const std::string &prefix,
 			    const std::string &message);
 
+			/**
+			 * @brief
+			 * Send formatted messages to the logger.
+			 *
+			 * @param[in] messages
+			 *	Messages, one after another.
+			 * @param[in] lengths
+			 *	Length of each message in messages.
+			 *
+			 * @return
+			 *	Number of messages sent. Messages not
+			 *	sent were dropped.
+			 *
+			 * @throw Error::StrategyError
+			 *	Error writing to a stream socket.
+			 */
+			uint64_t sendMessages(
+			    const std::string &messages,
+			    const std::vector<uint32_t> &lengths);
+
+			/** @return RFC5424 time stamp of the current time */
+			std::string createTimestamp();
+
 			std::string _hostname;
 			std::string _appname;
 			std::string _procid;
@@ -160,7 +312,59 @@ namespace BiometricEvaluation
 
 			/** Whether time stamps are in UTC */
 			bool _utc;
+
+		private:
+			/** Send queued messages until stopped */
+			static void *
+			asyncSender(
+			    void *ptr);
+
+			/** How messages reach the logging service */
+			Transport _transport;
+
+			/** HOSTNAME through STRUCTURED-DATA of messages */
+			std::string _headerFields;
+
+			/** Second of the cached time stamp */
+			time_t _timestampSecond;
+			/** Date and time of the cached time stamp */
+			std::string _timestampDate;
+			/** UTC offset of the cached time stamp */
+			std::string _timestampZone;
+
+			/** Whether entries are sent asynchronously */
+			bool _async;
+			/** Bytes of messages that may be queued */
+			uint64_t _queueSize;
+			/** Whether to block or drop when full */
+			OverflowPolicy _policy;
+			/** Messages waiting to be sent */
+			std::string _pending;
+			/** Length of each message in _pending */
+			std::vector<uint32_t> _pendingLengths;
+			/** Messages queued since enabling async mode */
+			uint64_t _queued;
+			/** Queued messages sent or dropped by the thread */
+			uint64_t _handled;
+			/** Messages sent */
+			uint64_t _sent;
+			/** Messages dropped */
+			uint64_t _dropped;
+			/** Set to make the background thread exit */
+			bool _asyncStop;
+			/** Failure of the background thread */
+			std::string _asyncError;
+			/** Background sending thread */
+			pthread_t _asyncThread;
+			/** Protects the queue and counters */
+			mutable pthread_mutex_t _asyncMutex;
+			/** Signaled when messages are queued */
+			pthread_cond_t _asyncWork;
+			/** Signaled when queued messages are handled */
+			pthread_cond_t _asyncDone;
 		};
 	}
 }
 
+#endif /* __BE_IO_SYSLOGSHEET_H__ */
+
@@ -0,0 +1,258 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_MEMORY_ACCOUNTING_H__
+#define __BE_MEMORY_ACCOUNTING_H__
+
+#include <cstdint>
+#include <map>
+
+#include <be_framework_enumeration.h>
+#include <be_memory_resource.h>
+
+namespace BiometricEvaluation
+{
+	namespace Memory
+	{
+		/**
+		 * @brief
+		 * Owners to which library allocations are attributed.
+		 */
+		enum class AllocationTag
+		{
+			/** AutoArray storage not attributed elsewhere */
+			AutoArray,
+			/** In-memory RecordStore manifests */
+			RecordStoreManifest,
+			/** RecordStore caches, such as SQLite's page cache */
+			RecordStoreCache,
+			/** Buffers returned by Image decoding methods */
+			ImageDecode,
+			/** NBIS ANSI_NIST trees held by AN2K objects */
+			AN2KTree
+		};
+
+		/** Counters kept for each AllocationTag */
+		struct AllocationCounters
+		{
+			/** Bytes currently allocated */
+			uint64_t current;
+			/** Most bytes allocated at once */
+			uint64_t peak;
+			/** Number of allocations */
+			uint64_t allocations;
+			/** Number of deallocations */
+			uint64_t deallocations;
+		};
+
+		/**
+		 * @brief
+		 * Turn allocation accounting on or off.
+		 * @details
+		 * Accounting is off by default, and costs nothing but a
+		 * flag check while off. While on, AutoArrays allocated
+		 * from the default resource are charged to the calling
+		 * thread's current tag (see ScopedAllocationTag), and the
+		 * library charges manifests, caches, decode buffers and
+		 * AN2K trees to their own tags.
+		 *
+		 * Memory is released from the tag it was charged to even
+		 * if accounting has since been turned off, and memory
+		 * allocated while accounting was off is never counted, so
+		 * the counters stay consistent across changes.
+		 *
+		 * @param[in] enabled
+		 *	Whether to account for allocations.
+		 */
+		void
+		setAccountingEnabled(
+		    bool enabled);
+
+		/** @return Whether allocations are being accounted */
+		bool
+		isAccountingEnabled();
+
+		/**
+		 * @brief
+		 * Charge an allocation to a tag.
+		 *
+		 * @param[in] tag
+		 *	Owner of the memory.
+		 * @param[in] size
+		 *	Number of bytes.
+		 */
+		void
+		recordAllocation(
+		    AllocationTag tag,
+		    uint64_t size);
+
+		/**
+		 * @brief
+		 * Release an allocation previously charged to a tag.
+		 *
+		 * @param[in] tag
+		 *	Tag passed to recordAllocation().
+		 * @param[in] size
+		 *	size passed to recordAllocation().
+		 */
+		void
+		recordDeallocation(
+		    AllocationTag tag,
+		    uint64_t size);
+
+		/**
+		 * @brief
+		 * Obtain the counters of a tag.
+		 *
+		 * @param[in] tag
+		 *	Tag of interest.
+		 *
+		 * @return
+		 *	Snapshot of tag's counters.
+		 */
+		AllocationCounters
+		getAllocationCounters(
+		    AllocationTag tag);
+
+		/**
+		 * @return
+		 *	Snapshot of the counters of every tag.
+		 */
+		std::map<AllocationTag, AllocationCounters>
+		getAllocationCounters();
+
+		/**
+		 * @brief
+		 * Set the peak of every tag to its current size.
+		 * @details
+		 * Useful to measure the high-water mark of one phase of
+		 * processing, such as a single record.
+		 */
+		void
+		resetAllocationPeaks();
+
+		/**
+		 * @return
+		 *	The tag charged for AutoArrays allocated on the
+		 *	calling thread from the default resource.
+		 */
+		AllocationTag
+		getAllocationTag();
+
+		/**
+		 * @brief
+		 * Charge AutoArrays allocated on the calling thread from
+		 * the default resource to a tag for the lifetime of this
+		 * object.
+		 * @details
+		 * Each AutoArray keeps the tag in effect when its storage
+		 * was allocated, so an array returned out of the scope
+		 * remains charged to the tag until it is destroyed.
+		 */
+		class ScopedAllocationTag
+		{
+		public:
+			/**
+			 * @param[in] tag
+			 *	Tag to charge until destruction.
+			 */
+			explicit ScopedAllocationTag(
+			    AllocationTag tag);
+
+			/** Restore the previous tag */
+			~ScopedAllocationTag();
+
+			ScopedAllocationTag(
+			    const ScopedAllocationTag&) = delete;
+			ScopedAllocationTag& operator=(
+			    const ScopedAllocationTag&) = delete;
+
+		private:
+			/** Tag to restore */
+			AllocationTag _previous;
+		};
+
+		/**
+		 * @brief
+		 * Resource that charges every block to a tag.
+		 * @details
+		 * Blocks are obtained from an upstream resource and their
+		 * sizes charged to the tag, whether or not accounting is
+		 * enabled. Wrapping a PoolResource or ArenaResource in an
+		 * AccountingResource attributes the AutoArrays drawn from
+		 * it. The resource must outlive every block allocated
+		 * from it.
+		 */
+		class AccountingResource : public MemoryResource
+		{
+		public:
+			/**
+			 * @param[in] tag
+			 *	Tag to charge.
+			 * @param[in] upstream
+			 *	Source of blocks, or nullptr for
+			 *	getNewDeleteResource().
+			 */
+			AccountingResource(
+			    AllocationTag tag,
+			    MemoryResource *upstream = nullptr);
+
+			void *
+			allocate(
+			    size_t size,
+			    size_t alignment);
+
+			void
+			deallocate(
+			    void *block,
+			    size_t size,
+			    size_t alignment);
+
+			void *
+			reallocate(
+			    void *block,
+			    size_t size,
+			    size_t newSize,
+			    size_t alignment);
+
+			/** @return Tag charged */
+			AllocationTag
+			getTag()
+			    const;
+
+		private:
+			/** Tag charged */
+			AllocationTag _tag;
+			/** Source of blocks */
+			MemoryResource *_upstream;
+		};
+
+		/**
+		 * @brief
+		 * Obtain the resource that charges a tag for blocks from
+		 * getNewDeleteResource().
+		 * @details
+		 * While accounting is enabled, getDefaultResource()
+		 * returns the resource for the calling thread's tag
+		 * unless a default resource has been set.
+		 *
+		 * @param[in] tag
+		 *	Tag to charge.
+		 *
+		 * @return
+		 *	Resource that lives for the life of the process.
+		 */
+		MemoryResource *
+		getAccountingResource(
+		    AllocationTag tag);
+	}
+}
+
+#endif /* __BE_MEMORY_ACCOUNTING_H__ */
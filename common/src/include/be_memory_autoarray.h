@@ -20,12 +20,16 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <functional>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include <be_error_exception.h>
 #include <be_memory_autoarrayiterator.h>
+#include <be_memory_resource.h>
 
 namespace BiometricEvaluation
 {
@@ -39,6 +43,12 @@ namespace BiometricEvaluation
 		 * manner for containers, where (size_type) construction creates
 		 * an array of the given size, while {...} construction creates
 		 * an array with the given elements.
+		 *
+		 * Storage comes from a MemoryResource, which is the calling
+		 * thread's default resource (see getDefaultResource())
+		 * unless one is given at construction. An AutoArray
+		 * keeps its resource for its lifetime, except that move
+		 * assignment exchanges resources along with storage.
 		 */
 		template<class T> 
 		class AutoArray
@@ -266,6 +276,122 @@ namespace BiometricEvaluation
 				resize(
 				    size_type new_size,
 				    bool free = false);
+
+				/**
+				 * @brief
+				 * Change the number of accessible elements
+				 * without initializing new elements.
+				 * @details
+				 * Only available for trivial types. Storage
+				 * grows in place when the resource allows.
+				 * Existing elements are kept, and elements
+				 * beyond them have indeterminate values until
+				 * written.
+				 *
+				 * @param[in] new_size
+				 *	The number of accessible elements.
+				 *
+				 * @throw Error::MemoryError
+				 *	Problem allocating memory.
+				 */
+				void
+				resize_uninitialized(
+				    size_type new_size);
+
+				/**
+				 * @brief
+				 * Allocate storage for at least a number of
+				 * elements without changing size().
+				 *
+				 * @param[in] new_capacity
+				 *	Number of elements to make room for.
+				 *
+				 * @throw Error::MemoryError
+				 *	Problem allocating memory.
+				 */
+				void
+				reserve(
+				    size_type new_capacity);
+
+				/**
+				 * @return
+				 *	Number of elements that fit in the
+				 *	allocated storage.
+				 */
+				size_type
+				capacity()
+				    const;
+
+				/**
+				 * @brief
+				 * Add an element to the end of the AutoArray.
+				 * @details
+				 * Storage grows geometrically, so a series of
+				 * appends copies each element a constant number
+				 * of times on average.
+				 *
+				 * @param[in] value
+				 *	Element to append.
+				 *
+				 * @throw Error::MemoryError
+				 *	Problem allocating memory.
+				 */
+				void
+				push_back(
+				    const T &value);
+
+				/**
+				 * @brief
+				 * Add elements to the end of the AutoArray.
+				 * @details
+				 * Storage grows geometrically, as for
+				 * push_back().
+				 *
+				 * @param[in] buffer
+				 *	Elements to append.
+				 * @param[in] count
+				 *	Number of elements in buffer.
+				 *
+				 * @throw Error::MemoryError
+				 *	Problem allocating memory.
+				 */
+				void
+				append(
+				    const T *buffer,
+				    size_type count);
+
+				/**
+				 * @brief
+				 * Change the alignment of storage.
+				 * @details
+				 * Use CacheLineAlignment for buffers handed to
+				 * SIMD code, getPageSize() for O_DIRECT I/O,
+				 * or HugePageAlignment for very large buffers.
+				 * Existing storage is moved if it is not
+				 * already aligned.
+				 *
+				 * @param[in] alignment
+				 *	Power of two to which the address of the
+				 *	first element is aligned. Values less
+				 *	than alignof(T) are raised to alignof(T).
+				 *
+				 * @throw Error::ParameterError
+				 *	alignment is not a power of two.
+				 * @throw Error::MemoryError
+				 *	Problem allocating memory.
+				 */
+				void
+				setAlignment(
+				    size_t alignment);
+
+				/**
+				 * @return
+				 *	Alignment of the address of the first
+				 *	element.
+				 */
+				size_t
+				getAlignment()
+				    const;
 				    
 				/**
 				 * @brief
@@ -330,6 +456,15 @@ namespace BiometricEvaluation
 				to_vector()
 				    const;
 
+				/**
+				 * @return
+				 *	The resource from which storage is
+				 *	allocated.
+				 */
+				MemoryResource *
+				getResource()
+				    const;
+
 				/**
 				 * @brief
 				 * Construct an AutoArray.
@@ -337,12 +472,16 @@ namespace BiometricEvaluation
 				 * @param[in] size
 				 *	The number of elements this AutoArray
 				 *	should initially hold.
+				 * @param[in] resource
+				 *	Source of storage, or nullptr for the
+				 *	calling thread's default resource.
 				 *				 
 				 * @throw Error::MemoryError
 				 *	Could not allocate new memory.
 				 */
 				explicit AutoArray(
-				    size_type size = 0);
+				    size_type size = 0,
+				    MemoryResource *resource = nullptr);
 
 				/**
 				 * @brief
@@ -350,7 +489,9 @@ namespace BiometricEvaluation
 				 * 
 				 * @param[in] copy
 				 *	An AutoArray whose contents will be 
-				 *	deep copied into the new AutoArray.
+				 *	deep copied into the new AutoArray,
+				 *	using the calling thread's default
+				 *	resource.
 				 *
 				 * @throw Error::MemoryError
 				 *	Could not allocate new memory.
@@ -429,6 +570,64 @@ namespace BiometricEvaluation
 				~AutoArray();
 								
 			private:
+				/**
+				 * @brief
+				 * Obtain storage for default-initialized
+				 * elements.
+				 *
+				 * @param[in] count
+				 *	Number of elements.
+				 *
+				 * @return
+				 *	Storage, or nullptr when count is 0.
+				 *
+				 * @throw Error::MemoryError
+				 *	Could not allocate new memory.
+				 */
+				value_type *
+				allocate(
+				    size_type count);
+
+				/**
+				 * @brief
+				 * Destroy elements and return storage to
+				 * _resource.
+				 *
+				 * @param[in] data
+				 *	Storage from allocate().
+				 * @param[in] count
+				 *	Number of elements in data.
+				 */
+				void
+				deallocate(
+				    value_type *data,
+				    size_type count);
+
+				/**
+				 * @brief
+				 * Change the allocated storage, keeping as
+				 * many elements as fit.
+				 *
+				 * @param[in] new_capacity
+				 *	Number of elements to allocate.
+				 *
+				 * @throw Error::MemoryError
+				 *	Could not allocate new memory.
+				 */
+				void
+				reallocate(
+				    size_type new_capacity);
+
+				/** @return Capacity for count more elements */
+				size_type
+				grownCapacity(
+				    size_type count)
+				    const;
+
+				/** Source of storage */
+				MemoryResource *_resource;
+				/** Alignment of _data */
+				size_t _alignment;
 				/** The underlying C-array */
 				value_type *_data;
 				/** Advertised size of _data */
@@ -499,6 +698,98 @@ BiometricEvaluation::Memory::AutoArray<T>::size()
 	return (_size);
 }
 
+template<class T>
+typename BiometricEvaluation::Memory::AutoArray<T>::value_type *
+BiometricEvaluation::Memory::AutoArray<T>::allocate(
+    size_type count)
+{
+	if (count == 0)
+		return (nullptr);
+	if (count > (SIZE_MAX / sizeof(T)))
+		throw Error::MemoryError("Could not allocate data");
+	T *data = static_cast<T*>(_resource->allocate(count * sizeof(T),
+	    _alignment));
+	if (data == nullptr)
+		throw Error::MemoryError("Could not allocate data");
+
+	/* Default-initialize, as new T[] does */
+	if (!std::is_trivial<T>::value) {
+		size_type i = 0;
+		try {
+			for (; i < count; i++)
+				new (&data[i]) T;
+		} catch (...) {
+			while (i > 0)
+				data[--i].~T();
+			_resource->deallocate(data, count * sizeof(T),
+			    _alignment);
+			throw;
+		}
+	}
+	return (data);
+}
+
+template<class T>
+void
+BiometricEvaluation::Memory::AutoArray<T>::deallocate(
+    value_type *data,
+    size_type count)
+{
+	if (data == nullptr)
+		return;
+	if (!std::is_trivially_destructible<T>::value)
+		for (size_type i = 0; i < count; i++)
+			data[i].~T();
+	_resource->deallocate(data, count * sizeof(T), _alignment);
+}
+
+template<class T>
+void
+BiometricEvaluation::Memory::AutoArray<T>::reallocate(
+    size_type new_capacity)
+{
+	const size_type kept = (new_capacity < _size) ? new_capacity : _size;
+
+	/* Trivial elements can be resized in place by the resource */
+	if (std::is_trivial<T>::value && (_data != nullptr) &&
+	    (new_capacity != 0)) {
+		if (new_capacity > (SIZE_MAX / sizeof(T)))
+			throw Error::MemoryError("Could not allocate data");
+		T *new_data = static_cast<T*>(_resource->reallocate(_data,
+		    _capacity * sizeof(T), new_capacity * sizeof(T),
+		    _alignment));
+		if (new_data == nullptr)
+			throw Error::MemoryError("Could not allocate data");
+		_data = new_data;
+		_capacity = new_capacity;
+		_size = kept;
+		return;
+	}
+
+	T *new_data = this->allocate(new_capacity);
+	std::move(&_data[0], &_data[kept], new_data);
+	this->deallocate(_data, _capacity);
+	_data = new_data;
+	_capacity = new_capacity;
+	_size = kept;
+}
+
+template<class T>
+typename BiometricEvaluation::Memory::AutoArray<T>::size_type
+BiometricEvaluation::Memory::AutoArray<T>::grownCapacity(
+    size_type count)
+    const
+{
+	if (count > (SIZE_MAX / sizeof(T)) - _size)
+		throw Error::MemoryError("Could not allocate data");
+	const size_type needed = _size + count;
+	if (needed <= _capacity)
+		return (_capacity);
+	if (_capacity > (SIZE_MAX / sizeof(T)) / 2)
+		return (needed);
+	return (needed > (_capacity * 2) ? needed : (_capacity * 2));
+}
+
 template<class T>
 void
 BiometricEvaluation::Memory::AutoArray<T>::resize(
@@ -511,22 +802,119 @@ BiometricEvaluation::Memory::AutoArray<T>::resize(
 		return;
 	}
 
-	T* new_data = nullptr;
-	if (new_size != 0) {
-		new_data = new (std::nothrow) T[new_size];
-		if (new_data == nullptr)
-			throw Error::MemoryError("Could not allocate data");
+	/* Keep as much data as will fit into the new buffer */
+	this->reallocate(new_size);
+	_size = new_size;
+}
+
+template<class T>
+void
+BiometricEvaluation::Memory::AutoArray<T>::resize_uninitialized(
+    size_type new_size)
+{
+	static_assert(std::is_trivial<T>::value,
+	    "resize_uninitialized() requires a trivial type");
+
+	if (new_size > _capacity)
+		this->reallocate(new_size);
+	_size = new_size;
+}
+
+template<class T>
+void
+BiometricEvaluation::Memory::AutoArray<T>::reserve(
+    size_type new_capacity)
+{
+	if (new_capacity > _capacity) {
+		const size_type size = _size;
+		this->reallocate(new_capacity);
+		_size = size;
 	}
+}
 
-	/* Copy as much data as will fit into the new buffer */
-	std::copy(&_data[0], &_data[((new_size < _size) ? new_size : _size)],
-	    new_data);
+template<class T>
+typename BiometricEvaluation::Memory::AutoArray<T>::size_type
+BiometricEvaluation::Memory::AutoArray<T>::capacity()
+    const
+{
+	return (_capacity);
+}
 
-	/* Delete the old buffer and assign the new buffer to this object */
-	if (_data != nullptr)
-		delete [] _data;
-	_data = new_data;
-	_size = _capacity = new_size;
+template<class T>
+void
+BiometricEvaluation::Memory::AutoArray<T>::push_back(
+    const T &value)
+{
+	if (_size == _capacity) {
+		/* value may be an element of this AutoArray */
+		T copy(value);
+		this->reserve(this->grownCapacity(1));
+		_data[_size++] = std::move(copy);
+		return;
+	}
+	_data[_size++] = value;
+}
+
+template<class T>
+void
+BiometricEvaluation::Memory::AutoArray<T>::append(
+    const T *buffer,
+    size_type count)
+{
+	if (count == 0)
+		return;
+
+	/* buffer may be within this AutoArray */
+	if ((_size + count > _capacity) && (_data != nullptr) &&
+	    (std::less_equal<const T*>()(_data, buffer)) &&
+	    (std::less<const T*>()(buffer, _data + _capacity))) {
+		const size_type offset = buffer - _data;
+		this->reserve(this->grownCapacity(count));
+		buffer = _data + offset;
+	} else {
+		this->reserve(this->grownCapacity(count));
+	}
+	std::copy(buffer, buffer + count, &_data[_size]);
+	_size += count;
+}
+
+template<class T>
+void
+BiometricEvaluation::Memory::AutoArray<T>::setAlignment(
+    size_t alignment)
+{
+	if ((alignment == 0) || ((alignment & (alignment - 1)) != 0))
+		throw Error::ParameterError("Alignment must be a power of two");
+	if (alignment < alignof(T))
+		alignment = alignof(T);
+	if (alignment == _alignment)
+		return;
+
+	/* Move storage that does not meet the new alignment */
+	if (((uintptr_t)_data % alignment) != 0) {
+		T *new_data;
+		const size_t old_alignment = _alignment;
+		_alignment = alignment;
+		try {
+			new_data = this->allocate(_capacity);
+		} catch (Error::Exception &e) {
+			_alignment = old_alignment;
+			throw;
+		}
+		std::move(&_data[0], &_data[_size], new_data);
+		_alignment = old_alignment;
+		this->deallocate(_data, _capacity);
+		_data = new_data;
+	}
+	_alignment = alignment;
+}
+
+template<class T>
+size_t
+BiometricEvaluation::Memory::AutoArray<T>::getAlignment()
+    const
+{
+	return (_alignment);
 }
 
 template<class T>
@@ -586,6 +974,14 @@ BiometricEvaluation::Memory::AutoArray<T>::to_vector()
 	return (vec);
 }
 
+template<class T>
+BiometricEvaluation::Memory::MemoryResource *
+BiometricEvaluation::Memory::AutoArray<T>::getResource()
+    const
+{
+	return (_resource);
+}
+
 /******************************************************************************/
 /* Conversion Operators.                                                      */
 /******************************************************************************/
@@ -628,19 +1024,14 @@ BiometricEvaluation::Memory::AutoArray<T>::operator=(
     const BiometricEvaluation::Memory::AutoArray<T> &other)
 {
 	if (this != &other) {
+		this->deallocate(_data, _capacity);
+		_data = nullptr;
+		_size = _capacity = 0;
+		_data = this->allocate(other._size);
 		_size = _capacity = other._size;
-		if (_data != nullptr) {
-			delete [] _data;
-			_data = nullptr;
-		}
-		if (_size != 0) {
-			_data = new (std::nothrow) T[_size];
-			if (_data == nullptr)
-				throw Error::MemoryError("Could not "
-				    "allocate data");
+		if (_size != 0)
 			std::copy(&(other._data[0]), &(other._data[_size]),
 			    _data);
-		}
 	}
 
 	return (*this);
@@ -661,6 +1052,8 @@ BiometricEvaluation::Memory::AutoArray<T>::operator=(
 	swap(_size, other._size);
 	swap(_capacity, other._capacity);
 	swap(_data, other._data);
+	swap(_resource, other._resource);
+	swap(_alignment, other._alignment);
 
 	return (*this);
 }
@@ -719,37 +1112,37 @@ BiometricEvaluation::Memory::AutoArray<T>::cend()
 /******************************************************************************/
 template<class T>
 BiometricEvaluation::Memory::AutoArray<T>::AutoArray(
-    size_type size) :
+    size_type size,
+    MemoryResource *resource) :
+    _resource(resource == nullptr ? getDefaultResource() : resource),
+    _alignment(alignof(T)),
     _data(nullptr),
     _size(size),
     _capacity(size)
 {
-	if (_size != 0) {
-		_data = new (std::nothrow) T[_size];
-		if (_data == nullptr)
-			throw Error::MemoryError("Could not allocate data");
-	}
+	_data = this->allocate(_size);
 }
 
 template<class T>
 BiometricEvaluation::Memory::AutoArray<T>::AutoArray(
     const AutoArray& copy) :
+    _resource(getDefaultResource()),
+    _alignment(copy._alignment),
     _data(nullptr),
     _size(copy._size),
     _capacity(copy._size)
 {
-	if (_size != 0) {
-		_data = new (std::nothrow) T[_size];
-		if (_data == nullptr)
-			throw Error::MemoryError("Could not allocate data");
+	_data = this->allocate(_size);
+	if (_size != 0)
 		std::copy(&(copy._data[0]), &(copy._data[_size]), _data);
-	}
 }
 
 template<class T>
 BiometricEvaluation::Memory::AutoArray<T>::AutoArray(
     AutoArray &&rvalue)
     noexcept :
+    _resource(rvalue._resource),
+    _alignment(rvalue._alignment),
     _data(rvalue._data),
     _size(rvalue._size),
     _capacity(rvalue._capacity)
@@ -773,8 +1166,7 @@ BiometricEvaluation::Memory::AutoArray<T>::AutoArray(
 template<class T>
 BiometricEvaluation::Memory::AutoArray<T>::~AutoArray()
 {
-	if (_data != nullptr)
-		delete [] _data;
+	this->deallocate(_data, _capacity);
 }
 
 /******************************************************************************/
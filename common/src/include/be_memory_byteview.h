@@ -0,0 +1,226 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_MEMORY_BYTEVIEW_H__
+#define __BE_MEMORY_BYTEVIEW_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <be_memory_autoarray.h>
+
+namespace BiometricEvaluation
+{
+	namespace Memory
+	{
+		/**
+		 * @brief
+		 * Read-only reference to a contiguous range of bytes.
+		 * @details
+		 * A ByteView pairs a pointer with a length, in the manner
+		 * of C++20's std::span<const uint8_t>. It does not own the
+		 * bytes it refers to, and copying a ByteView never copies
+		 * them. A ByteView may be made implicitly from a uint8Array,
+		 * so functions that take a ByteView accept one, as well as
+		 * memory the library does not manage, such as a
+		 * memory-mapped file or a message received with MPI. A view
+		 * of a std::vector<uint8_t> must be made explicitly, so that
+		 * a temporary vector cannot silently become a view that
+		 * outlives it.
+		 *
+		 * The bytes must remain valid and unchanged for as long as
+		 * the ByteView, or any object that documents that it keeps
+		 * one, is in use.
+		 */
+		class ByteView
+		{
+		public:
+			/** Refer to no bytes */
+			ByteView() :
+			    _data(nullptr),
+			    _size(0)
+			{
+
+			}
+
+			/**
+			 * @brief
+			 * Refer to a buffer.
+			 *
+			 * @param[in] data
+			 *	First byte.
+			 * @param[in] size
+			 *	Number of bytes at data.
+			 */
+			ByteView(
+			    const uint8_t *data,
+			    uint64_t size) :
+			    _data(data),
+			    _size(size)
+			{
+
+			}
+
+			/**
+			 * @brief
+			 * Refer to the contents of a uint8Array.
+			 *
+			 * @param[in] aa
+			 *	uint8Array to refer to. The view is
+			 *	invalidated by anything that reallocates
+			 *	aa.
+			 */
+			ByteView(
+			    const uint8Array &aa) :
+			    _data(aa),
+			    _size(aa.size())
+			{
+
+			}
+
+			/**
+			 * @brief
+			 * Refer to the contents of a vector.
+			 *
+			 * @param[in] v
+			 *	Vector to refer to. The view is invalidated
+			 *	by anything that reallocates v.
+			 */
+			explicit ByteView(
+			    const std::vector<uint8_t> &v) :
+			    _data(v.data()),
+			    _size(v.size())
+			{
+
+			}
+
+			/** @return First byte */
+			const uint8_t *
+			data()
+			    const
+			{
+				return (this->_data);
+			}
+
+			/** @return Number of bytes */
+			uint64_t
+			size()
+			    const
+			{
+				return (this->_size);
+			}
+
+			/** @return Whether the view has no bytes */
+			bool
+			empty()
+			    const
+			{
+				return (this->_size == 0);
+			}
+
+			/** @return Iterator to the first byte */
+			const uint8_t *
+			begin()
+			    const
+			{
+				return (this->_data);
+			}
+
+			/** @return Iterator past the last byte */
+			const uint8_t *
+			end()
+			    const
+			{
+				return (this->_data + this->_size);
+			}
+
+			/**
+			 * @brief
+			 * Unchecked access to a byte.
+			 *
+			 * @param[in] index
+			 *	Offset of the byte, less than size().
+			 *
+			 * @return
+			 *	The byte at index.
+			 */
+			const uint8_t &
+			operator[](
+			    uint64_t index)
+			    const
+			{
+				return (this->_data[index]);
+			}
+
+			/**
+			 * @brief
+			 * Checked access to a byte.
+			 *
+			 * @param[in] index
+			 *	Offset of the byte.
+			 *
+			 * @return
+			 *	The byte at index.
+			 *
+			 * @throw Error::ParameterError
+			 *	index is not less than size().
+			 */
+			const uint8_t &
+			at(
+			    uint64_t index)
+			    const;
+
+			/**
+			 * @brief
+			 * Obtain a view of part of this view.
+			 *
+			 * @param[in] offset
+			 *	Offset of the first byte of the subview.
+			 * @param[in] length
+			 *	Number of bytes in the subview, or npos
+			 *	for all bytes from offset to the end.
+			 *
+			 * @return
+			 *	View of the bytes.
+			 *
+			 * @throw Error::ParameterError
+			 *	The range extends past the end of the view.
+			 */
+			ByteView
+			subview(
+			    uint64_t offset,
+			    uint64_t length = npos)
+			    const;
+
+			/**
+			 * @brief
+			 * Copy the bytes.
+			 *
+			 * @return
+			 *	uint8Array owning a copy of the bytes.
+			 */
+			uint8Array
+			to_array()
+			    const;
+
+			/** subview() length meaning "to the end" */
+			static const uint64_t npos = UINT64_MAX;
+
+		private:
+			/** First byte */
+			const uint8_t *_data;
+			/** Number of bytes */
+			uint64_t _size;
+		};
+	}
+}
+
+#endif /* __BE_MEMORY_BYTEVIEW_H__ */
@@ -12,6 +12,7 @@
 #define __BE_MEMORY_INDEXEDBUFFER__
 
 #include <be_memory_autoarray.h>
+#include <be_memory_byteview.h>
 
 namespace BiometricEvaluation
 {
@@ -59,6 +60,16 @@ namespace BiometricEvaluation
 				IndexedBuffer(
 				    const uint8Array &aa);
 
+				/**
+				 * @brief
+				 * Wrap the bytes of a ByteView.
+				 *
+				 * @param view
+				 * View to wrap.
+				 */
+				IndexedBuffer(
+				    const ByteView &view);
+
 				/** Copy constructor (default). */
 				IndexedBuffer(
 				    const IndexedBuffer &copy) = default;
@@ -218,6 +229,120 @@ namespace BiometricEvaluation
 				    void *buf,
 				    uint64_t len);
 
+				/**
+				 * @brief
+				 * Obtain a view of the next 'n' elements of
+				 * the buffer, without copying them, and
+				 * increment the current index value by n.
+				 * @details
+				 * Checking the length of a structure once and
+				 * decoding it from the view avoids a bounds
+				 * check for every field.
+				 *
+				 * @param[in] len
+				 * The number of elements to view.
+				 *
+				 * @return
+				 * View of the elements, valid for as long as
+				 * the wrapped buffer.
+				 *
+				 * @throw Error::DataError
+				 * The buffer is exhausted.
+				 */
+				ByteView
+				scanView(
+				    uint64_t len);
+
+				/**
+				 * @brief
+				 * Obtain the next 'count' unsigned 16-bit
+				 * values of the buffer, in host byte order,
+				 * and increment the current index value.
+				 *
+				 * @param[out] vals
+				 * Array of at least count values.
+				 * @param[in] count
+				 * The number of values to scan.
+				 *
+				 * @throw Error::DataError
+				 * The buffer is exhausted; nothing is
+				 * scanned.
+				 */
+				void
+				scanU16Vals(
+				    uint16_t *vals,
+				    uint64_t count);
+
+				/**
+				 * @brief
+				 * Obtain the next 'count' unsigned 16-bit
+				 * values of the buffer, scanned as big-endian
+				 * values, and increment the current index
+				 * value.
+				 * @details
+				 * The buffer is checked once for all values,
+				 * and the bytes are swapped with vector
+				 * instructions where available.
+				 *
+				 * @param[out] vals
+				 * Array of at least count values.
+				 * @param[in] count
+				 * The number of values to scan.
+				 *
+				 * @throw Error::DataError
+				 * The buffer is exhausted; nothing is
+				 * scanned.
+				 */
+				void
+				scanBeU16Vals(
+				    uint16_t *vals,
+				    uint64_t count);
+
+				/**
+				 * @brief
+				 * Obtain the next 'count' unsigned 32-bit
+				 * values of the buffer, in host byte order,
+				 * and increment the current index value.
+				 *
+				 * @param[out] vals
+				 * Array of at least count values.
+				 * @param[in] count
+				 * The number of values to scan.
+				 *
+				 * @throw Error::DataError
+				 * The buffer is exhausted; nothing is
+				 * scanned.
+				 */
+				void
+				scanU32Vals(
+				    uint32_t *vals,
+				    uint64_t count);
+
+				/**
+				 * @brief
+				 * Obtain the next 'count' unsigned 32-bit
+				 * values of the buffer, scanned as big-endian
+				 * values, and increment the current index
+				 * value.
+				 * @details
+				 * The buffer is checked once for all values,
+				 * and the bytes are swapped with vector
+				 * instructions where available.
+				 *
+				 * @param[out] vals
+				 * Array of at least count values.
+				 * @param[in] count
+				 * The number of values to scan.
+				 *
+				 * @throw Error::DataError
+				 * The buffer is exhausted; nothing is
+				 * scanned.
+				 */
+				void
+				scanBeU32Vals(
+				    uint32_t *vals,
+				    uint64_t count);
+
 				/**
 				 * @brief
 				 * Returns a pointer to the managed buffer.
@@ -0,0 +1,397 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_MEMORY_RESOURCE_H__
+#define __BE_MEMORY_RESOURCE_H__
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace BiometricEvaluation
+{
+	namespace Memory
+	{
+		/** Alignment of a cache line, suitable for SIMD loads */
+		static const size_t CacheLineAlignment = 64;
+
+		/**
+		 * @brief
+		 * Alignment that requests transparent huge pages.
+		 * @details
+		 * On Linux, blocks allocated by getNewDeleteResource()
+		 * with this alignment or greater are advised to be backed
+		 * by huge pages, reducing page faults and TLB misses for
+		 * very large buffers.
+		 */
+		static const size_t HugePageAlignment = 2 * 1024 * 1024;
+
+		/**
+		 * @return
+		 *	Size of a virtual memory page, the alignment
+		 *	required by O_DIRECT I/O on most file systems.
+		 */
+		size_t
+		getPageSize();
+
+		/**
+		 * @brief
+		 * Source of the memory used by AutoArray.
+		 * @details
+		 * A MemoryResource hands out and takes back blocks of raw
+		 * memory, in the manner of C++17's
+		 * std::pmr::memory_resource. A block must be returned to
+		 * the resource that allocated it, with the same size and
+		 * alignment.
+		 *
+		 * Each thread has a default resource, used by every
+		 * AutoArray allocated on that thread without an explicit
+		 * resource. It starts as getNewDeleteResource(), and can
+		 * be replaced for a scope with ScopedDefaultResource so
+		 * that code which allocates AutoArrays internally, such as
+		 * RecordStore::read(), draws from a pool or arena.
+		 */
+		class MemoryResource
+		{
+		public:
+			/**
+			 * @brief
+			 * Allocate a block.
+			 *
+			 * @param[in] size
+			 *	Number of bytes.
+			 * @param[in] alignment
+			 *	Power of two to which the block's address
+			 *	must be aligned.
+			 *
+			 * @return
+			 *	The block, or nullptr if memory could not
+			 *	be allocated.
+			 */
+			virtual void *
+			allocate(
+			    size_t size,
+			    size_t alignment) = 0;
+
+			/**
+			 * @brief
+			 * Return a block.
+			 *
+			 * @param[in] block
+			 *	Block returned by allocate().
+			 * @param[in] size
+			 *	size passed to allocate().
+			 * @param[in] alignment
+			 *	alignment passed to allocate().
+			 */
+			virtual void
+			deallocate(
+			    void *block,
+			    size_t size,
+			    size_t alignment) = 0;
+
+			/**
+			 * @brief
+			 * Change the size of a block, in place when
+			 * possible.
+			 * @details
+			 * The default implementation allocates a new
+			 * block, copies, and deallocates the old block.
+			 *
+			 * @param[in] block
+			 *	Block returned by allocate().
+			 * @param[in] size
+			 *	size passed to allocate().
+			 * @param[in] newSize
+			 *	New size of the block.
+			 * @param[in] alignment
+			 *	alignment passed to allocate().
+			 *
+			 * @return
+			 *	The resized block, holding the first
+			 *	min(size, newSize) bytes of block, or
+			 *	nullptr, leaving block unchanged, if
+			 *	memory could not be allocated.
+			 */
+			virtual void *
+			reallocate(
+			    void *block,
+			    size_t size,
+			    size_t newSize,
+			    size_t alignment);
+
+			virtual ~MemoryResource() = default;
+		};
+
+		/**
+		 * @return
+		 *	Resource that allocates every block from the
+		 *	heap. It may be used from any thread.
+		 */
+		MemoryResource *
+		getNewDeleteResource();
+
+		/**
+		 * @return
+		 *	The calling thread's default resource. Unless
+		 *	one has been set, this is getNewDeleteResource(),
+		 *	wrapped by an AccountingResource while allocation
+		 *	accounting is enabled.
+		 */
+		MemoryResource *
+		getDefaultResource();
+
+		/**
+		 * @brief
+		 * Change the calling thread's default resource.
+		 *
+		 * @param[in] resource
+		 *	New default resource, or nullptr for
+		 *	getNewDeleteResource().
+		 *
+		 * @return
+		 *	The previous default resource.
+		 */
+		MemoryResource *
+		setDefaultResource(
+		    MemoryResource *resource);
+
+		/**
+		 * @brief
+		 * Replace the calling thread's default resource for the
+		 * lifetime of this object.
+		 */
+		class ScopedDefaultResource
+		{
+		public:
+			/**
+			 * @param[in] resource
+			 *	Default resource until destruction.
+			 */
+			explicit ScopedDefaultResource(
+			    MemoryResource *resource);
+
+			/** Restore the previous default resource */
+			~ScopedDefaultResource();
+
+			ScopedDefaultResource(
+			    const ScopedDefaultResource&) = delete;
+			ScopedDefaultResource& operator=(
+			    const ScopedDefaultResource&) = delete;
+
+		private:
+			/** Default resource to restore */
+			MemoryResource *_previous;
+		};
+
+		/**
+		 * @brief
+		 * Resource that recycles freed blocks by size class.
+		 * @details
+		 * Requests are rounded up to a power of two, and returned
+		 * blocks are kept on a free list for their size so that a
+		 * loop allocating buffers of similar size reuses the same
+		 * memory rather than calling into the heap and faulting in
+		 * fresh pages every iteration. Blocks larger than
+		 * maxBlockSize, and blocks that would keep more than
+		 * maxRetained bytes on the free lists, go directly to and
+		 * from the upstream resource.
+		 *
+		 * A PoolResource may be used from any thread. It must
+		 * outlive every block allocated from it.
+		 */
+		class PoolResource : public MemoryResource
+		{
+		public:
+			/**
+			 * @param[in] maxBlockSize
+			 *	Largest request served from the pool.
+			 * @param[in] maxRetained
+			 *	Most bytes kept on the free lists.
+			 * @param[in] upstream
+			 *	Source of new blocks, or nullptr for
+			 *	getNewDeleteResource().
+			 */
+			PoolResource(
+			    size_t maxBlockSize = 64 * 1024 * 1024,
+			    size_t maxRetained = 256 * 1024 * 1024,
+			    MemoryResource *upstream = nullptr);
+
+			/** Return all retained blocks upstream */
+			~PoolResource();
+
+			void *
+			allocate(
+			    size_t size,
+			    size_t alignment);
+
+			void
+			deallocate(
+			    void *block,
+			    size_t size,
+			    size_t alignment);
+
+			/** Keeps blocks that stay within a size class */
+			void *
+			reallocate(
+			    void *block,
+			    size_t size,
+			    size_t newSize,
+			    size_t alignment);
+
+			/** Return all retained blocks upstream */
+			void
+			release();
+
+			/** @return Bytes held on the free lists */
+			size_t
+			getRetainedSize()
+			    const;
+
+			/** @return Allocations served from the free lists */
+			uint64_t
+			getReuseCount()
+			    const;
+
+			PoolResource(const PoolResource&) = delete;
+			PoolResource& operator=(const PoolResource&) = delete;
+
+		private:
+			/** Alignment of every pooled block */
+			static const size_t BlockAlignment = 64;
+
+			/** @return Size class of a request, or -1 */
+			int
+			getSizeClass(
+			    size_t size,
+			    size_t alignment)
+			    const;
+
+			/** Largest request served from the pool */
+			size_t _maxBlockSize;
+			/** Most bytes kept on the free lists */
+			size_t _maxRetained;
+			/** Source of new blocks */
+			MemoryResource *_upstream;
+			/** Free blocks of 2^i bytes, indexed by i */
+			std::vector<std::vector<void *>> _freeLists;
+			/** Bytes held on the free lists */
+			size_t _retained;
+			/** Allocations served from the free lists */
+			uint64_t _reused;
+			/** Protects the free lists */
+			mutable pthread_mutex_t _mutex;
+		};
+
+		/**
+		 * @brief
+		 * Resource that allocates by advancing through large
+		 * chunks.
+		 * @details
+		 * Allocation is a pointer increment and deallocation does
+		 * nothing; memory is reclaimed all at once by reset(),
+		 * which keeps the chunks for reuse, or release(). This
+		 * suits work that allocates many buffers and then
+		 * discards them together, such as the processing of one
+		 * record, when reset() is called between records.
+		 *
+		 * An ArenaResource is not safe to use from more than one
+		 * thread; each thread should have its own. Every block
+		 * allocated from it becomes invalid at reset(), release(),
+		 * or destruction, so an AutoArray drawing from an arena
+		 * must not outlive the next reset().
+		 */
+		class ArenaResource : public MemoryResource
+		{
+		public:
+			/**
+			 * @param[in] chunkSize
+			 *	Size of each chunk obtained upstream.
+			 *	Larger requests get a chunk of their own.
+			 * @param[in] upstream
+			 *	Source of chunks, or nullptr for
+			 *	getNewDeleteResource().
+			 */
+			ArenaResource(
+			    size_t chunkSize = 4 * 1024 * 1024,
+			    MemoryResource *upstream = nullptr);
+
+			/** Return all chunks upstream */
+			~ArenaResource();
+
+			void *
+			allocate(
+			    size_t size,
+			    size_t alignment);
+
+			void
+			deallocate(
+			    void *block,
+			    size_t size,
+			    size_t alignment);
+
+			/** Extends the most recent block in place */
+			void *
+			reallocate(
+			    void *block,
+			    size_t size,
+			    size_t newSize,
+			    size_t alignment);
+
+			/** Reclaim every block, keeping the chunks */
+			void
+			reset();
+
+			/** Reclaim every block and return the chunks */
+			void
+			release();
+
+			/** @return Bytes allocated since the last reset */
+			size_t
+			getAllocatedSize()
+			    const;
+
+			/** @return Bytes held in chunks */
+			size_t
+			getChunkSize()
+			    const;
+
+			ArenaResource(const ArenaResource&) = delete;
+			ArenaResource& operator=(const ArenaResource&) = delete;
+
+		private:
+			/** A block of memory obtained upstream */
+			struct Chunk {
+				char *data;
+				size_t size;
+			};
+
+			/** Alignment of every chunk */
+			static const size_t ChunkAlignment = 64;
+
+			/** Size of each ordinary chunk */
+			size_t _chunkSize;
+			/** Source of chunks */
+			MemoryResource *_upstream;
+			/** Chunks obtained upstream */
+			std::vector<Chunk> _chunks;
+			/** Index of the chunk being allocated from */
+			size_t _current;
+			/** Offset of the next free byte in _current */
+			size_t _offset;
+			/** Bytes allocated since the last reset */
+			size_t _allocated;
+		};
+	}
+}
+
+#endif /* __BE_MEMORY_RESOURCE_H__ */
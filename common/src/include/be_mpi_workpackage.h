@@ -11,6 +11,7 @@
 #define _BE_MPI_WORKPACKAGE_H
 
 #include <be_memory_autoarray.h>
+#include <be_memory_byteview.h>
 
 namespace BiometricEvaluation {
 	namespace MPI {
@@ -38,6 +39,15 @@ namespace BiometricEvaluation {
 			 * package.
 			 */
 			WorkPackage(const Memory::uint8Array &data);
+
+			/**
+			 * @brief
+			 * Construct a work package that takes over a buffer.
+			 * @param[in] data
+			 * The data that will be managed by this work
+			 * package, moved rather than copied.
+			 */
+			WorkPackage(Memory::uint8Array &&data);
 			~WorkPackage();
 
 			/**
@@ -46,6 +56,15 @@ namespace BiometricEvaluation {
 			 */
 			void getData(Memory::uint8Array &data) const;
 
+			/**
+		 	 * @brief
+			 * Obtain the package data without copying.
+			 * @return
+			 * View of the package data, valid until the
+			 * package is changed or destroyed.
+			 */
+			Memory::ByteView getDataView() const;
+
 			/**
 		 	 * @brief
 			 * Set the package data from raw data.
@@ -54,6 +73,23 @@ namespace BiometricEvaluation {
 			 */
 			void setData(const Memory::uint8Array &data);
 
+			/**
+		 	 * @brief
+			 * Set the package data from a buffer it takes over.
+			 * @param[in] data
+			 * The data moved into the work package.
+			 */
+			void setData(Memory::uint8Array &&data);
+
+			/**
+		 	 * @brief
+			 * Set the package data from memory owned elsewhere,
+			 * such as a message buffer.
+			 * @param[in] data
+			 * The data copied into the work package.
+			 */
+			void setData(const Memory::ByteView &data);
+
 			/**
 		 	 * @brief
 			 * Obtain the size of the package data.
@@ -13,6 +13,7 @@
 
 #include <unistd.h>
 
+#include <functional>
 #include <list>
 
 #include <be_process_manager.h>
@@ -28,6 +29,17 @@ namespace BiometricEvaluation
 		 * @brief
 		 * Manager implementation that starts Workers by calling
 		 * fork(2).
+		 * @details
+		 * By default, every Worker is forked from the process that
+		 * owns the ForkManager. When the Workers share expensive
+		 * initialization (loading a vendor library, reading a
+		 * gallery), enableZygote() runs that initialization once in
+		 * a template process, the zygote, and Workers are forked
+		 * from the zygote instead, starting with the initialized
+		 * state already in place.
+		 *
+		 * Workers that exit abnormally can be restarted
+		 * automatically; see setRespawnLimit().
 		 */
 		class ForkManager : public Manager
 		{
@@ -67,6 +79,10 @@ namespace BiometricEvaluation
 			/**
 			 * @brief
 			 * Begin Worker's work.
+			 * @details
+			 * If a Worker cannot be started, the Workers
+			 * already started are asked to stop and are waited
+			 * for before the exception is rethrown.
 			 *
 			 * @param[in] wait
 			 *	Whether or not to wait for all Workers to
@@ -267,6 +283,109 @@ namespace BiometricEvaluation
 			setExitStatus(
 			    const pid_t pid,
 			    const int32_t waitStatus);
+
+			/**
+			 * @brief
+			 * Start a zygote process from which Workers will be
+			 * forked.
+			 * @details
+			 * The zygote is forked from this process and runs
+			 * initializer once. Every Worker started afterwards
+			 * (including respawned Workers) is forked from the
+			 * zygote, inheriting whatever state initializer
+			 * created, and remains a child of this ForkManager's
+			 * process for the purposes of waiting and signaling.
+			 *
+			 * @param[in] initializer
+			 * Expensive initialization shared by all Workers.
+			 *
+			 * @throw Error::ObjectExists
+			 * A zygote is already running.
+			 * @throw Error::NotImplemented
+			 * Zygotes are not supported on this system.
+			 * @throw Error::StrategyError
+			 * Could not start the zygote, or initializer threw
+			 * an exception or caused the zygote to exit.
+			 *
+			 * @note
+			 * The zygote holds a copy of the Workers (and their
+			 * parameters) as they are when this method is
+			 * called. Workers added later cannot be started
+			 * until the zygote is disabled.
+			 * @note
+			 * Workers forked from a zygote may not communicate
+			 * with the Manager.
+			 */
+			void
+			enableZygote(
+			    const std::function<void()> &initializer);
+
+			/**
+			 * @brief
+			 * Stop the zygote process.
+			 * @details
+			 * Workers already started are unaffected; Workers
+			 * started afterwards are forked from this process.
+			 */
+			void
+			disableZygote();
+
+			/**
+			 * @return
+			 * Whether or not Workers are forked from a zygote.
+			 */
+			bool
+			hasZygote()
+			    const;
+
+			/**
+			 * @brief
+			 * Restart Workers that exit abnormally.
+			 * @details
+			 * A Worker that exits due to a signal, or with an
+			 * exit status other than EXIT_SUCCESS, is started
+			 * again, up to limit times, unless it was asked to
+			 * exit with stopWorker(). Restarted Workers are forked
+			 * from the zygote when one is enabled.
+			 *
+			 * @param[in] limit
+			 * Maximum number of times each Worker is restarted
+			 * after being started with startWorkers() or
+			 * startWorker(). 0, the default, disables restarts.
+			 *
+			 * @note
+			 * Workers are restarted only while this ForkManager
+			 * is waiting for Workers to exit, and only if they
+			 * were started without communication.
+			 */
+			void
+			setRespawnLimit(
+			    const uint32_t limit);
+
+			/** @return Maximum restarts of each Worker. */
+			uint32_t
+			getRespawnLimit()
+			    const;
+
+			/**
+			 * @brief
+			 * Obtain the number of times a Worker was restarted.
+			 *
+			 * @param[in] workerController
+			 * Worker managed by this ForkManager.
+			 *
+			 * @return
+			 * Number of restarts since the Worker was last
+			 * started with startWorkers() or startWorker().
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 * workerController has never been started by this
+			 * ForkManager.
+			 */
+			uint32_t
+			getRespawnCount(
+			    std::shared_ptr<WorkerController> workerController)
+			    const;
 			
 		private:
 			/**
@@ -294,6 +413,57 @@ namespace BiometricEvaluation
 			void
 			_wait();
 
+			/**
+			 * @brief
+			 * Start a Worker, from the zygote if enabled, and
+			 * record its status.
+			 *
+			 * @param[in] fwc
+			 * Worker to start.
+			 * @param[in] communicate
+			 * Whether or not to enable communication between
+			 * Worker and Manager.
+			 *
+			 * @throw Error::ObjectExists
+			 * fwc is already working.
+			 * @throw Error::NotImplemented
+			 * communicate is true and a zygote is enabled.
+			 * @throw Error::StrategyError
+			 * Error starting the Worker.
+			 */
+			void
+			launch(
+			    std::shared_ptr<ForkWorkerController> fwc,
+			    bool communicate);
+
+			/**
+			 * @brief
+			 * Restart a Worker that exited abnormally, if
+			 * allowed by the respawn limit.
+			 *
+			 * @param[in] fwc
+			 * Worker that exited.
+			 * @param[in] status
+			 * Status of the exit, from wait(2).
+			 */
+			void
+			respawnIfFailed(
+			    std::shared_ptr<ForkWorkerController> fwc,
+			    int status);
+
+			/**
+			 * @brief
+			 * Service requests to fork Workers.
+			 * @details
+			 * Runs in the zygote process and never returns.
+			 *
+			 * @param[in] controlSocket
+			 * Zygote end of the socket connected to the Manager.
+			 */
+			void
+			zygoteMain(
+			    int controlSocket);
+
 			/**
 			 * @brief
 			 * Clean-up zombie children.
@@ -323,6 +493,10 @@ namespace BiometricEvaluation
 				pid_t pid;
 				/** Whether or not the PID is active */
 				bool isWorking;
+				/** Whether or not communication is enabled */
+				bool communicate;
+				/** Number of times the Worker was restarted */
+				uint32_t respawns;
 			};
 			    
 			/**
@@ -350,6 +524,15 @@ namespace BiometricEvaluation
 			std::map<
 			    std::shared_ptr<ForkWorkerController>, Status>
 			    _wcStatus;
+
+			/** PID of the zygote, or 0 if not running */
+			pid_t _zygotePID;
+			/** Manager end of the zygote socket, or -1 */
+			int _zygoteSocket;
+			/** Number of Workers known to the zygote */
+			uint32_t _zygoteWorkerCount;
+			/** Maximum restarts of each Worker */
+			uint32_t _respawnLimit;
 		};
 		
 		
@@ -469,6 +652,22 @@ namespace BiometricEvaluation
 			void
 			stop();
 
+			/**
+			 * @brief
+			 * Become the decorated Worker.
+			 * @details
+			 * Called in the newly forked process, runs
+			 * Worker::workerMain(), and exits with its
+			 * return value.
+			 *
+			 * @param communicate
+			 *	Whether or not communication between Worker
+			 *	and Manager is enabled.
+			 */
+			void
+			runWorker(
+			    bool communicate);
+
 			/** PID of the process represented by _worker */
     			pid_t _pid;
 			
@@ -583,6 +782,13 @@ namespace BiometricEvaluation
 			ForkManager::setExitStatus(
 			    const pid_t pid,
 			    const int32_t waitStatus);
+
+			/*
+			 * ForkManager::launch() and ForkManager::zygoteMain()
+			 * also start Workers, but as private members they
+			 * cannot be named individually.
+			 */
+			friend class ForkManager;
 		};
 	}
 }
@@ -0,0 +1,320 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_PROCESS_SHAREDDATASET_H__
+#define __BE_PROCESS_SHAREDDATASET_H__
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <be_io_recordstore.h>
+#include <be_memory_autoarray.h>
+
+namespace BiometricEvaluation
+{
+	namespace Process
+	{
+		/**
+		 * @brief
+		 * A read-only collection of keyed records loaded once and
+		 * shared by every process that maps it.
+		 * @details
+		 * The records (a template gallery read from a RecordStore,
+		 * or a lookup table, for example) are laid out in a single
+		 * segment: a header, an index sorted by key, the keys, and
+		 * the record data, each record aligned to a cache line.
+		 * The segment is mapped read-only, so its pages are never
+		 * copied, no matter what the processes sharing it do to
+		 * their own heaps.
+		 *
+		 * A SharedDataset constructed from a RecordStore lives in
+		 * anonymous memory (on Linux, a sealed memfd) and is
+		 * inherited by processes forked afterwards, so it should be
+		 * constructed before ForkManager::startWorkers(). A
+		 * SharedDataset may also be written to a file with
+		 * createFile() and opened by any number of unrelated
+		 * processes, in which case the operating system's page cache
+		 * holds the only copy.
+		 *
+		 * Lookups by key are a binary search of the index and
+		 * return pointers into the segment without copying.
+		 */
+		class SharedDataset
+		{
+		public:
+			/**
+			 * @brief
+			 * Load all records from a RecordStore into
+			 * anonymous shared memory.
+			 *
+			 * @param[in] rs
+			 * RecordStore whose records are loaded.
+			 *
+			 * @throw Error::StrategyError
+			 * Could not create the shared memory, or error
+			 * reading from rs.
+			 * @throw Error::DataError
+			 * A record's length changed while it was loaded.
+			 */
+			SharedDataset(
+			    const std::shared_ptr<IO::RecordStore> &rs);
+
+			/**
+			 * @brief
+			 * Load a set of records into anonymous shared
+			 * memory.
+			 *
+			 * @param[in] records
+			 * Records to load. Keys must be unique.
+			 *
+			 * @throw Error::ObjectExists
+			 * A key appears more than once.
+			 * @throw Error::StrategyError
+			 * Could not create the shared memory.
+			 */
+			SharedDataset(
+			    const std::vector<IO::RecordStore::Record> &records);
+
+			/**
+			 * @brief
+			 * Map a SharedDataset file created with
+			 * createFile().
+			 * @details
+			 * On Linux, pathname may also name the descriptor
+			 * of another process' anonymous SharedDataset,
+			 * as /proc/<pid>/fd/<getFileDescriptor()>.
+			 *
+			 * @param[in] pathname
+			 * Path to the SharedDataset file.
+			 *
+			 * @throw Error::FileError
+			 * Could not open pathname.
+			 * @throw Error::StrategyError
+			 * pathname is not a SharedDataset, or could not
+			 * be mapped.
+			 * @throw Error::DataError
+			 * An index entry lies outside the segment.
+			 */
+			SharedDataset(
+			    const std::string &pathname);
+
+			~SharedDataset();
+
+			/**
+			 * @brief
+			 * Write all records from a RecordStore to a
+			 * SharedDataset file.
+			 *
+			 * @param[in] pathname
+			 * Path of the file to create.
+			 * @param[in] rs
+			 * RecordStore whose records are written.
+			 *
+			 * @throw Error::ObjectExists
+			 * pathname already exists.
+			 * @throw Error::FileError
+			 * Error creating or writing pathname.
+			 * @throw Error::StrategyError
+			 * Error reading from rs.
+			 * @throw Error::DataError
+			 * A record's length changed while it was written.
+			 */
+			static void
+			createFile(
+			    const std::string &pathname,
+			    const std::shared_ptr<IO::RecordStore> &rs);
+
+			/** @return Number of records in the dataset. */
+			uint64_t
+			getCount()
+			    const;
+
+			/**
+			 * @return
+			 * Size of the shared segment, in bytes.
+			 */
+			uint64_t
+			getSegmentSize()
+			    const;
+
+			/**
+			 * @return
+			 * File descriptor backing an anonymous dataset, or
+			 * -1 if the dataset is not backed by a descriptor.
+			 */
+			int
+			getFileDescriptor()
+			    const;
+
+			/**
+			 * @param[in] key
+			 * The key to locate.
+			 *
+			 * @return
+			 * Whether the dataset contains a record for key.
+			 */
+			bool
+			containsKey(
+			    const std::string &key)
+			    const;
+
+			/**
+			 * @param[in] key
+			 * The key of the record.
+			 *
+			 * @return
+			 * Length of the record, in bytes.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 * A record for key does not exist.
+			 */
+			uint64_t
+			length(
+			    const std::string &key)
+			    const;
+
+			/**
+			 * @brief
+			 * Obtain a record without copying it.
+			 *
+			 * @param[in] key
+			 * The key of the record.
+			 *
+			 * @return
+			 * Pointer to the first of length(key) bytes of the
+			 * record, valid for the lifetime of this object.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 * A record for key does not exist.
+			 */
+			const uint8_t*
+			getData(
+			    const std::string &key)
+			    const;
+
+			/**
+			 * @brief
+			 * Obtain a copy of a record.
+			 *
+			 * @param[in] key
+			 * The key of the record.
+			 *
+			 * @return
+			 * The record associated with key.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 * A record for key does not exist.
+			 */
+			Memory::uint8Array
+			read(
+			    const std::string &key)
+			    const;
+
+			/**
+			 * @param[in] index
+			 * Position of a record, in key order, between 0
+			 * and getCount() - 1.
+			 *
+			 * @return
+			 * Key of the record at index.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 * index is out of range.
+			 */
+			std::string
+			getKey(
+			    const uint64_t index)
+			    const;
+
+			/* Shared memory may not be duplicated */
+			SharedDataset(const SharedDataset&) = delete;
+			SharedDataset& operator=(const SharedDataset&) = delete;
+
+		private:
+			/** Header at the start of the segment */
+			struct Header;
+			/** Entry in the sorted index */
+			struct IndexEntry;
+
+			/** Key and length of a record to be laid out */
+			using Extent = std::pair<std::string, uint64_t>;
+			/** Copy length bytes of a record into the segment */
+			using Filler = std::function<void(
+			    const std::string &key, uint8_t *destination,
+			    uint64_t length)>;
+
+			/** @return Size of the segment for extents */
+			static uint64_t
+			layoutSize(
+			    std::vector<Extent> &extents);
+
+			/**
+			 * @brief
+			 * Lay out a dataset in a writable segment.
+			 *
+			 * @param[in] segment
+			 * Start of the segment, of layoutSize(extents)
+			 * bytes.
+			 * @param[in] extents
+			 * Keys and lengths of the records, as sorted by
+			 * layoutSize().
+			 * @param[in] fill
+			 * Copies each record's data into the segment.
+			 */
+			static void
+			layout(
+			    uint8_t *segment,
+			    const std::vector<Extent> &extents,
+			    const Filler &fill);
+
+			/**
+			 * @brief
+			 * Create the anonymous segment and lay out a
+			 * dataset within it.
+			 */
+			void
+			createAnonymous(
+			    std::vector<Extent> &extents,
+			    const Filler &fill);
+
+			/** @brief Validate the mapped segment. */
+			void
+			validate()
+			    const;
+
+			/**
+			 * @return
+			 * Index entry for key, or nullptr if not present.
+			 */
+			const IndexEntry*
+			find(
+			    const std::string &key)
+			    const;
+
+			/** @return Index entry for key. */
+			const IndexEntry*
+			entry(
+			    const std::string &key)
+			    const;
+
+			/** Start of the read-only segment */
+			const uint8_t *_segment;
+			/** Size of the segment */
+			uint64_t _segmentSize;
+			/** Descriptor backing the segment, or -1 */
+			int _fd;
+		};
+	}
+}
+
+#endif /* __BE_PROCESS_SHAREDDATASET_H__ */
@@ -0,0 +1,388 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#ifndef __BE_PROCESS_SHAREDQUEUE_H__
+#define __BE_PROCESS_SHAREDQUEUE_H__
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <string>
+
+#include <be_memory_autoarray.h>
+
+namespace BiometricEvaluation
+{
+	namespace Process
+	{
+		/**
+		 * @brief
+		 * A bounded, multi-producer/multi-consumer queue of
+		 * variable-size messages kept in shared memory.
+		 * @details
+		 * The queue is a ring of fixed-size slots, each holding
+		 * one message of up to maxMessageSize() bytes. Producers
+		 * and consumers claim slots with atomic operations only;
+		 * no lock is ever taken on the data path. When the queue
+		 * is full (or empty), callers of the blocking methods
+		 * sleep in the kernel (on Linux, on a futex) and are
+		 * woken by the next consumer (or producer).
+		 *
+		 * An anonymous SharedQueue is created in memory that is
+		 * inherited across fork(2), so a queue constructed
+		 * before ForkManager::startWorkers() is shared by the
+		 * manager and all of its Workers. A named SharedQueue
+		 * can additionally be opened by unrelated processes.
+		 * @note
+		 * Because messages are copied into and out of the slots,
+		 * message memory is never shared between processes;
+		 * only the queue itself is.
+		 * @note
+		 * Like Semaphore, a named queue is unlinked when the
+		 * object that created it is destroyed in the creating
+		 * process.
+		 */
+		class SharedQueue
+		{
+		public:
+			/**
+			 * @brief
+			 * Create an anonymous queue.
+			 * @details
+			 * The queue is visible to this process and to
+			 * any process subsequently forked from it.
+			 *
+			 * @param[in] numSlots
+			 * Maximum number of messages that may be
+			 * queued at once.
+			 * @param[in] maxMessageSize
+			 * Largest message, in bytes, that may be queued.
+			 *
+			 * @throw Error::ParameterError
+			 * numSlots or maxMessageSize is 0.
+			 * @throw Error::StrategyError
+			 * Could not create the shared memory.
+			 */
+			SharedQueue(
+			    const uint32_t numSlots,
+			    const uint64_t maxMessageSize);
+
+			/**
+			 * @brief
+			 * Create a named queue.
+			 *
+			 * @param[in] name
+			 * The name of the queue, which must obey the
+			 * syntax documented for the shm_open(2) call.
+			 * @param[in] mode
+			 * The permission mode of the queue.
+			 * @param[in] numSlots
+			 * Maximum number of messages that may be
+			 * queued at once.
+			 * @param[in] maxMessageSize
+			 * Largest message, in bytes, that may be queued.
+			 * @param[in] exclusive
+			 * The queue is created, disassociating an existing
+			 * queue of the same name.
+			 *
+			 * @throw Error::ObjectExists
+			 * The queue already exists with the given name.
+			 * @throw Error::ParameterError
+			 * numSlots or maxMessageSize is 0.
+			 * @throw Error::StrategyError
+			 * An error occurred when creating the queue.
+			 */
+			SharedQueue(
+			    const std::string &name,
+			    const mode_t mode,
+			    const uint32_t numSlots,
+			    const uint64_t maxMessageSize,
+			    const bool exclusive = false);
+
+			/**
+			 * @brief
+			 * Open an existing named queue.
+			 *
+			 * @param[in] name
+			 * The name of the queue, which must obey the
+			 * syntax documented for the shm_open(2) call.
+			 *
+			 * @throw Error::ObjectDoesNotExist
+			 * A queue does not exist with the given name.
+			 * @throw Error::StrategyError
+			 * An error occurred when opening the queue, or
+			 * the named object is not a SharedQueue.
+			 */
+			SharedQueue(
+			    const std::string &name);
+
+			~SharedQueue();
+
+			/**
+			 * @brief
+			 * Add a message, waiting indefinitely for room
+			 * in the queue.
+			 *
+			 * @param[in] message
+			 * Message contents.
+			 * @param[in] size
+			 * Size of message, in bytes.
+			 * @param[in] interruptible
+			 * true if the function should return if waiting
+			 * was interrupted, false otherwise.
+			 *
+			 * @return
+			 * true if the message was queued; false if not.
+			 *
+			 * @throw Error::ParameterError
+			 * size is larger than maxMessageSize().
+			 */
+			bool
+			push(
+			    const uint8_t *message,
+			    const uint64_t size,
+			    const bool interruptible);
+
+			/**
+			 * @brief
+			 * Add a message, waiting indefinitely for room
+			 * in the queue.
+			 *
+			 * @param[in] message
+			 * Message contents.
+			 * @param[in] interruptible
+			 * true if the function should return if waiting
+			 * was interrupted, false otherwise.
+			 *
+			 * @return
+			 * true if the message was queued; false if not.
+			 *
+			 * @throw Error::ParameterError
+			 * message is larger than maxMessageSize().
+			 */
+			bool
+			push(
+			    const Memory::uint8Array &message,
+			    const bool interruptible);
+
+			/**
+			 * @brief
+			 * Attempt to add a message without blocking.
+			 *
+			 * @param[in] message
+			 * Message contents.
+			 * @param[in] size
+			 * Size of message, in bytes.
+			 *
+			 * @return
+			 * true if the message was queued; false if the
+			 * queue was full.
+			 *
+			 * @throw Error::ParameterError
+			 * size is larger than maxMessageSize().
+			 */
+			bool
+			tryPush(
+			    const uint8_t *message,
+			    const uint64_t size);
+
+			/**
+			 * @brief
+			 * Attempt to add a message, blocking for at most
+			 * the specified time interval.
+			 *
+			 * @param[in] message
+			 * Message contents.
+			 * @param[in] size
+			 * Size of message, in bytes.
+			 * @param[in] interval
+			 * The max time to wait, in microseconds.
+			 * @param[in] interruptible
+			 * true if the function should return if waiting
+			 * was interrupted, false otherwise.
+			 *
+			 * @return
+			 * true if the message was queued; false if not.
+			 *
+			 * @throw Error::ParameterError
+			 * size is larger than maxMessageSize().
+			 */
+			bool
+			timedPush(
+			    const uint8_t *message,
+			    const uint64_t size,
+			    const uint64_t interval,
+			    const bool interruptible);
+
+			/**
+			 * @brief
+			 * Remove the oldest message, waiting indefinitely
+			 * for one to be queued.
+			 *
+			 * @param[out] message
+			 * Buffer to store the received message, resized to
+			 * the size of the message.
+			 * @param[in] interruptible
+			 * true if the function should return if waiting
+			 * was interrupted, false otherwise.
+			 *
+			 * @return
+			 * true if a message was removed; false if not.
+			 */
+			bool
+			pop(
+			    Memory::uint8Array &message,
+			    const bool interruptible);
+
+			/**
+			 * @brief
+			 * Attempt to remove the oldest message without
+			 * blocking.
+			 *
+			 * @param[out] message
+			 * Buffer to store the received message, resized to
+			 * the size of the message.
+			 *
+			 * @return
+			 * true if a message was removed; false if the
+			 * queue was empty.
+			 */
+			bool
+			tryPop(
+			    Memory::uint8Array &message);
+
+			/**
+			 * @brief
+			 * Attempt to remove the oldest message, blocking
+			 * for at most the specified time interval.
+			 *
+			 * @param[out] message
+			 * Buffer to store the received message, resized to
+			 * the size of the message.
+			 * @param[in] interval
+			 * The max time to wait, in microseconds.
+			 * @param[in] interruptible
+			 * true if the function should return if waiting
+			 * was interrupted, false otherwise.
+			 *
+			 * @return
+			 * true if a message was removed; false if not.
+			 */
+			bool
+			timedPop(
+			    Memory::uint8Array &message,
+			    const uint64_t interval,
+			    const bool interruptible);
+
+			/**
+			 * @return
+			 * Approximate number of messages in the queue.
+			 * @note
+			 * The value may be stale by the time it is
+			 * returned if other processes are using the queue.
+			 */
+			uint32_t
+			size()
+			    const;
+
+			/** @return Maximum number of queued messages. */
+			uint32_t
+			capacity()
+			    const;
+
+			/** @return Largest message that may be queued. */
+			uint64_t
+			maxMessageSize()
+			    const;
+
+			/* Shared memory may not be duplicated */
+			SharedQueue(const SharedQueue&) = delete;
+			SharedQueue& operator=(const SharedQueue&) = delete;
+
+		private:
+			/** Control block at the start of the segment. */
+			struct Header;
+			/** Prefix of every slot in the ring. */
+			struct Slot;
+
+			/**
+			 * @brief
+			 * Lay out a new queue in this object's segment.
+			 *
+			 * @param[in] numSlots
+			 * Number of slots in the ring.
+			 * @param[in] maxMessageSize
+			 * Largest message that may be queued.
+			 */
+			void
+			format(
+			    const uint32_t numSlots,
+			    const uint64_t maxMessageSize);
+
+			/**
+			 * @return
+			 * Size of the segment for the given geometry.
+			 */
+			static uint64_t
+			segmentSize(
+			    const uint32_t numSlots,
+			    const uint64_t maxMessageSize);
+
+			/** @return Slot for position pos in the ring. */
+			Slot*
+			slotAt(
+			    const uint64_t pos)
+			    const;
+
+			/**
+			 * @brief
+			 * Common implementation of the blocking push
+			 * and pop methods.
+			 *
+			 * @param[in] producer
+			 * true to wait for room, false to wait for a
+			 * message.
+			 * @param[in] attempt
+			 * Non-blocking operation to retry.
+			 * @param[in] timed
+			 * Whether or not interval is honored.
+			 * @param[in] interval
+			 * The max time to wait, in microseconds.
+			 * @param[in] interruptible
+			 * true if the function should return if waiting
+			 * was interrupted, false otherwise.
+			 *
+			 * @return
+			 * Result of the last attempt.
+			 */
+			template<typename Attempt>
+			bool
+			blockingAttempt(
+			    const bool producer,
+			    Attempt attempt,
+			    const bool timed,
+			    const uint64_t interval,
+			    const bool interruptible);
+
+			/** Start of the shared segment */
+			uint8_t *_segment;
+			/** Size of the shared segment */
+			uint64_t _segmentSize;
+			/** Control block, inside the segment */
+			Header *_header;
+			/** Name of a named queue, or empty */
+			std::string _name;
+			/** Process that created a named queue */
+			pid_t _creatorPID;
+		};
+	}
+}
+
+#endif /* __BE_PROCESS_SHAREDQUEUE_H__ */
@@ -170,6 +170,12 @@ namespace BiometricEvaluation {
 			 * @brief
 			 * Create a snapshot of the current process statistics
 			 * in the FileLogsheet created in the FileLogCabinet.
+			 * @details
+			 * While allocation accounting is enabled (see
+			 * Memory::setAccountingEnabled()), the bytes
+			 * currently charged to each Memory::AllocationTag
+			 * are appended to the entry. A comment naming these
+			 * columns precedes the first such entry.
 			 *
 			 * @throw Error::ObjectDoesNotExist
 			 *	The FileLogsheet does not exist; this object was
@@ -240,6 +246,7 @@ namespace BiometricEvaluation {
 			std::shared_ptr<IO::Logsheet> _logSheet;
 			bool _logging;
 			bool _autoLogging;
+			bool _loggingAllocations;
 			pthread_t _loggingThread;
 			pthread_mutex_t _logMutex;
 		};
@@ -15,6 +15,7 @@
 
 #include <be_error_exception.h>
 #include <be_memory_autoarray.h>
+#include <be_memory_byteview.h>
 #include <be_process.h>
 #include <be_process_worker.h>
 
@@ -54,7 +55,7 @@ namespace BiometricEvaluation
 			 */
 			virtual void
 			sendMessageToWorker(
-			    const Memory::uint8Array &message);
+			    const Memory::ByteView &message);
 
 			/**
 			 * @brief
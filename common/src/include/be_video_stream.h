@@ -103,6 +103,8 @@ namespace BiometricEvaluation
 			 * @param pixelFormat
 			 * The pixel format of all returned frames.
 			 *
+			 * @throw Error::ParameterError
+			 * pixelFormat is PixelFormat::Native.
 			 */
 			virtual void setFramePixelFormat(
 			    const Image::PixelFormat pixelFormat) = 0;
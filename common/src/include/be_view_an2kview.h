@@ -20,6 +20,7 @@
 #include <be_finger_an2kminutiae_data_record.h>
 #include <be_framework_enumeration.h>
 #include <be_memory_autobuffer.h>
+#include <be_memory_byteview.h>
 #include <be_view_view.h>
 #include <be_image_image.h>
 
@@ -185,7 +186,7 @@ namespace BiometricEvaluation
 			 * just the image and other view-related records.
 			 */
 			AN2KView(
-			    Memory::uint8Array &buf,
+			    const Memory::ByteView &buf,
 			    const RecordType typeID,
 			    const uint32_t recordNumber);
 
@@ -212,6 +213,55 @@ namespace BiometricEvaluation
 			 */
 			RecordType getRecordType() const;
 
+			/**
+			 * @brief
+			 * Charge the memory of an ANSI_NIST tree to
+			 * Memory::AllocationTag::AN2KTree.
+			 * @details
+			 * Call after reading into an AutoBuffer that was
+			 * made with freeAN2K() and copyAN2K(), which
+			 * release and duplicate the charge. Calling again
+			 * after the tree changes updates the charge.
+			 * Nothing is charged while allocation accounting
+			 * is disabled.
+			 *
+			 * @param[in] an2k
+			 *	Tree that has been read.
+			 */
+			static void
+			chargeAN2K(
+			    const ANSI_NIST *an2k);
+
+			/**
+			 * @brief
+			 * free_ANSI_NIST() that releases the charge made
+			 * by chargeAN2K().
+			 *
+			 * @param[in] an2k
+			 *	Tree to free.
+			 */
+			static void
+			freeAN2K(
+			    ANSI_NIST *an2k);
+
+			/**
+			 * @brief
+			 * copy_ANSI_NIST() that charges the copy when the
+			 * original is charged.
+			 *
+			 * @param[out] copy
+			 *	Where to store the copy.
+			 * @param[in] an2k
+			 *	Tree to copy.
+			 *
+			 * @return
+			 *	Result of copy_ANSI_NIST().
+			 */
+			static int
+			copyAN2K(
+			    ANSI_NIST **copy,
+			    ANSI_NIST *an2k);
+
 		protected:
 
 			/**
@@ -269,7 +319,7 @@ namespace BiometricEvaluation
 			 */
 			void
 			associateMinutiaeData(
-			    Memory::uint8Array &buf);
+			    const Memory::ByteView &buf);
 			    
 			/**
 			 * @brief
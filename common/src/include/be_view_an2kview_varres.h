@@ -164,7 +164,7 @@ namespace BiometricEvaluation
 			 * just the finger image and/or minutiae records.
 			 */
 			AN2KViewVariableResolution(
-			    Memory::uint8Array &buf,
+			    const Memory::ByteView &buf,
 			    const RecordType typeID,
 			    const uint32_t recordNumber);
 
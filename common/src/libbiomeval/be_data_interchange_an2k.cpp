@@ -23,15 +23,17 @@ namespace BE = BiometricEvaluation;
 /******************************************************************************/
 std::set<int>
 BiometricEvaluation::DataInterchange::AN2KRecord::recordLocations(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     View::AN2KView::RecordType recordType)
 {
 	Memory::AutoBuffer<ANSI_NIST> an2k(&alloc_ANSI_NIST,
-	    &free_ANSI_NIST, &copy_ANSI_NIST);
+	    &View::AN2KView::freeAN2K, &View::AN2KView::copyAN2K);
 	AN2KBDB bdb;
-        INIT_AN2KBDB(&bdb, buf, buf.size());
+        INIT_AN2KBDB(&bdb, const_cast<uint8_t *>(buf.data()),
+	    buf.size());
 	if (scan_ANSI_NIST(&bdb, an2k) != 0)
 		throw Error::DataError("Could not read AN2K buffer");
+	View::AN2KView::chargeAN2K(an2k);
 
 	return (recordLocations(an2k, recordType));
 }
@@ -53,14 +55,16 @@ BiometricEvaluation::DataInterchange::AN2KRecord::recordLocations(
 
 void
 BiometricEvaluation::DataInterchange::AN2KRecord::readType1Record(
-    Memory::uint8Array &buf)
+    const Memory::ByteView &buf)
 {
 	Memory::AutoBuffer<ANSI_NIST> an2k(&alloc_ANSI_NIST,
-	    &free_ANSI_NIST, &copy_ANSI_NIST);
+	    &View::AN2KView::freeAN2K, &View::AN2KView::copyAN2K);
 	AN2KBDB bdb;
-        INIT_AN2KBDB(&bdb, buf, buf.size());
+        INIT_AN2KBDB(&bdb, const_cast<uint8_t *>(buf.data()),
+	    buf.size());
 	if (scan_ANSI_NIST(&bdb, an2k) != 0)
 		throw Error::DataError("Could not read AN2K buffer");
+	View::AN2KView::chargeAN2K(an2k);
 
 	/* The Type-1 record is always first, but check anyway. */
 	RECORD *rec;
@@ -165,7 +169,7 @@ BiometricEvaluation::DataInterchange::AN2KRecord::readType1Record(
 
 void
 BiometricEvaluation::DataInterchange::AN2KRecord::readFingerCaptures(
-    Memory::uint8Array &buf)
+    const Memory::ByteView &buf)
 {
 	int i = 1;
 	while(true) {
@@ -181,7 +185,7 @@ BiometricEvaluation::DataInterchange::AN2KRecord::readFingerCaptures(
 
 void
 BiometricEvaluation::DataInterchange::AN2KRecord::readFingerLatents(
-    Memory::uint8Array &buf)
+    const Memory::ByteView &buf)
 {
 	int i = 1;
 	while(true) {
@@ -197,7 +201,7 @@ BiometricEvaluation::DataInterchange::AN2KRecord::readFingerLatents(
 
 void
 BiometricEvaluation::DataInterchange::AN2KRecord::readMinutiaeData(
-    Memory::uint8Array &buf)
+    const Memory::ByteView &buf)
 {
 	std::set<int> loc = recordLocations(
 	    buf, View::AN2KView::RecordType::Type_9);
@@ -237,14 +241,14 @@ BiometricEvaluation::DataInterchange::AN2KRecord::AN2KRecord(
 }
 
 BiometricEvaluation::DataInterchange::AN2KRecord::AN2KRecord(
-    Memory::uint8Array &buf)
+    const Memory::ByteView &buf)
 {
 	readAN2KRecord(buf);
 }
 
 void
 BiometricEvaluation::DataInterchange::AN2KRecord::readAN2KRecord(
-    Memory::uint8Array &buf)
+    const Memory::ByteView &buf)
 {
 	readType1Record(buf);
 	readMinutiaeData(buf);
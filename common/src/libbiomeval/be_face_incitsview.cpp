@@ -234,18 +234,23 @@ BiometricEvaluation::Face::INCITSView::readFaceView(
 	/*
 	 * Feature point blocks
 	 */
+	static const uint32_t FeaturePointLength = 8;
+	const BE::Memory::ByteView points = buf.scanView(
+	    numFeaturePoints * FeaturePointLength);
 	BE::Feature::MPEGFacePoint fp;
 	for (uint16_t count = 0; count < numFeaturePoints; count++) {
-		fp.type = buf.scanU8Val();
-		uval8 = buf.scanU8Val();
+		const uint8_t *point = points.data() +
+		    (count * FeaturePointLength);
+		fp.type = point[0];
+		uval8 = point[1];
 		fp.major = (uval8 & 0xF0) >> 4;
 		fp.minor = uval8 & 0x0F;
-		uint16_t hp = buf.scanBeU16Val();
-		uint16_t vp = buf.scanBeU16Val();
+		uint16_t hp = (point[2] << 8) | point[3];
+		uint16_t vp = (point[4] << 8) | point[5];
 		fp.coordinate = BE::Image::Coordinate(hp, vp);
-		(void)buf.scanBeU16Val();	/* reserved field */
+		/* point[6] and point[7] are a reserved field */
 		this->_featurePointSet.push_back(fp);
-		remainLen = remainLen - 8; /* Sum of above data item lengths */
+		remainLen = remainLen - FeaturePointLength;
 	}
 
 	/*
@@ -63,7 +63,7 @@ BiometricEvaluation::Feature::AN2K7Minutiae::getFormat() const
 }
 
 BiometricEvaluation::Feature::AN2K7Minutiae::AN2K7Minutiae(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     int recordNumber)
 {
 	readType9Record(buf, recordNumber);
@@ -341,18 +341,20 @@ BiometricEvaluation::Feature::AN2K7Minutiae::convertCoordinate(
 
 void
 BiometricEvaluation::Feature::AN2K7Minutiae::readType9Record(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     int recordNumber)
 {
 	Memory::AutoBuffer<ANSI_NIST> an2k =
 	    Memory::AutoBuffer<ANSI_NIST>(&alloc_ANSI_NIST,
-		&free_ANSI_NIST, &copy_ANSI_NIST);
+		&View::AN2KView::freeAN2K, &View::AN2KView::copyAN2K);
 
 	AN2KBDB bdb;
-	INIT_AN2KBDB(&bdb, buf, buf.size());
+	INIT_AN2KBDB(&bdb, const_cast<uint8_t *>(buf.data()),
+	    buf.size());
 	if (scan_ANSI_NIST(&bdb, an2k) != 0)
 		throw BE::Error::DataError(
 		    "Could not read complete AN2K record");
+	View::AN2KView::chargeAN2K(an2k);
 
 	/*
 	 * Find the requested Type-9 in the file, throwing an exception
@@ -39,7 +39,7 @@ BiometricEvaluation::Finger::AN2KMinutiaeDataRecord::AN2KMinutiaeDataRecord(
 }
 
 BiometricEvaluation::Finger::AN2KMinutiaeDataRecord::AN2KMinutiaeDataRecord(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     int recordNumber)
 {
 	readType9Record(buf, recordNumber);
@@ -208,17 +208,19 @@ BiometricEvaluation::Finger::AN2KMinutiaeDataRecord::readRegisteredVendorBlock(
 
 void
 BiometricEvaluation::Finger::AN2KMinutiaeDataRecord::readType9Record(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     int recordNumber)
 {
 	Memory::AutoBuffer<ANSI_NIST> an2k =
 	    Memory::AutoBuffer<ANSI_NIST>(&alloc_ANSI_NIST,
-		&free_ANSI_NIST, &copy_ANSI_NIST);
+		&View::AN2KView::freeAN2K, &View::AN2KView::copyAN2K);
 
 	AN2KBDB bdb;
-	INIT_AN2KBDB(&bdb, buf, buf.size());
+	INIT_AN2KBDB(&bdb, const_cast<uint8_t *>(buf.data()),
+	    buf.size());
 	if (scan_ANSI_NIST(&bdb, an2k) != 0)
 		throw Error::DataError("Could not read complete AN2K record");
+	View::AN2KView::chargeAN2K(an2k);
 
 	/*
 	 * Find the requested Type-9 in the file, throwing an exception
@@ -26,7 +26,7 @@ BiometricEvaluation::Finger::AN2KView::AN2KView(
 }
 
 BiometricEvaluation::Finger::AN2KView::AN2KView(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     const RecordType typeID,
     const uint32_t recordNumber) :
     BiometricEvaluation::View::AN2KView(buf, typeID, recordNumber)
@@ -24,7 +24,7 @@ BiometricEvaluation::Finger::AN2KViewCapture::AN2KViewCapture(
 }
 
 BiometricEvaluation::Finger::AN2KViewCapture::AN2KViewCapture(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     const uint32_t recordNumber) :
     AN2KViewVariableResolution(buf, RecordType::Type_14, recordNumber)
 {
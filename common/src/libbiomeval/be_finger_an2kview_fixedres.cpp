@@ -27,7 +27,7 @@ BiometricEvaluation::Finger::AN2KViewFixedResolution::AN2KViewFixedResolution(
 }
 
 BiometricEvaluation::Finger::AN2KViewFixedResolution::AN2KViewFixedResolution(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     const RecordType typeID,
     const uint32_t recordNumber) :
     Finger::AN2KView(buf, typeID, recordNumber)
@@ -24,7 +24,7 @@ BiometricEvaluation::Finger::AN2KViewLatent::AN2KViewLatent(
 }
 
 BiometricEvaluation::Finger::AN2KViewLatent::AN2KViewLatent(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     const uint32_t recordNumber) :
     AN2KViewVariableResolution(buf, RecordType::Type_13, recordNumber)
 {
@@ -33,7 +33,7 @@ AN2KViewVariableResolution(
 
 BiometricEvaluation::Finger::AN2KViewVariableResolution::
 AN2KViewVariableResolution(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     const RecordType typeID,
     const uint32_t recordNumber) :
     BiometricEvaluation::View::AN2KViewVariableResolution(
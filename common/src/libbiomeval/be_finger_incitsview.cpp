@@ -135,14 +135,18 @@ BiometricEvaluation::Finger::INCITSView::getMinutiaeReservedData()
 /******************************************************************************/
 /* Local functions.                                                           */
 /******************************************************************************/
+/*
+ * Decode one finger minutiae data record from fmd, which holds at least
+ * FMD_ITEM_LENGTH bytes already checked against the buffer length.
+ */
 static std::tuple<BiometricEvaluation::Feature::MinutiaPoint, uint8_t>
-scanFMD(BiometricEvaluation::Memory::IndexedBuffer &buf)
+scanFMD(const uint8_t *fmd)
 {
 	uint16_t sval;
 	uint8_t cval;
 	BE::Feature::MinutiaPoint m;
 
-	sval = buf.scanBeU16Val();	
+	sval = (fmd[0] << 8) | fmd[1];
 
 	m.has_type = true;
 	uint8_t nativeType = ((sval & 
@@ -164,29 +168,33 @@ scanFMD(BiometricEvaluation::Memory::IndexedBuffer &buf)
 		break;
 	}
 	m.coordinate.x = sval & BE::Feature::INCITSMinutiae::FMD_X_COORD_MASK;
-	sval = buf.scanBeU16Val();
+	sval = (fmd[2] << 8) | fmd[3];
 	m.coordinate.y = sval & BE::Feature::INCITSMinutiae::FMD_Y_COORD_MASK;
 	uint8_t reservedValue = sval &
 	    BE::Feature::INCITSMinutiae::FMD_RESERVED_MASK;
 
 	/* Angle and quality */
-	cval = buf.scanU8Val();
+	cval = fmd[4];
 	m.theta = cval;
-	cval = buf.scanU8Val();
+	cval = fmd[5];
 	m.has_quality = true;
 	m.quality = cval;
 
 	return (std::make_tuple(m, reservedValue));
 }
 
+/*
+ * Decode one ridge count data record from rcd, which holds at least
+ * FED_RCD_ITEM_LENGTH bytes already checked against the buffer length.
+ */
 static
 BiometricEvaluation::Feature::RidgeCountItem scanRCD(
-    BiometricEvaluation::Memory::IndexedBuffer &buf,
+    const uint8_t *rcd,
     uint8_t nativeExtrMethod)
 {
-	uint8_t idx1 = buf.scanU8Val();
-	uint8_t idx2 = buf.scanU8Val();
-	uint8_t	count = buf.scanU8Val();
+	uint8_t idx1 = rcd[0];
+	uint8_t idx2 = rcd[1];
+	uint8_t	count = rcd[2];
 	BE::Feature::RidgeCountExtractionMethod extrMethod;
 	switch (nativeExtrMethod) {
 	case BE::Feature::INCITSMinutiae::RCE_NONSPECIFIC:
@@ -203,8 +211,8 @@ BiometricEvaluation::Feature::RidgeCountItem scanRCD(
 		    "Invalid ridge count extraction method"));
 		break;
 	}
-	BE::Feature::RidgeCountItem rcd(extrMethod, idx1, idx2, count);
-	return (rcd);
+	BE::Feature::RidgeCountItem rci(extrMethod, idx1, idx2, count);
+	return (rci);
 }
 
 /******************************************************************************/
@@ -401,10 +409,15 @@ BiometricEvaluation::Finger::INCITSView::readMinutiaeDataPoints(
     BiometricEvaluation::Memory::IndexedBuffer &buf,
     uint32_t count)
 {
+	/* Check the length of all records at once */
+	const Memory::ByteView fmd = buf.scanView(static_cast<uint64_t>(
+	    count) * BE::Feature::INCITSMinutiae::FMD_ITEM_LENGTH);
+
 	BE::Feature::MinutiaPointSet mps(count);
 	std::vector<uint8_t> reserved(count);
 	for (uint32_t i = 0; i < count; i++) {
-		std::tie(mps[i], reserved[i]) = scanFMD(buf);
+		std::tie(mps[i], reserved[i]) = scanFMD(fmd.data() +
+		    (i * BE::Feature::INCITSMinutiae::FMD_ITEM_LENGTH));
 		mps[i].index = i;
 	}
 	return (std::make_tuple(mps, reserved));
@@ -422,10 +435,16 @@ BiometricEvaluation::Finger::INCITSView::readRidgeCountData(
 		throw (Error::DataError(
 		    "Ridge count data block has bad length"));
 	BE::Feature::RidgeCountItemSet rcis;
-	while (remLength > 0) {
-		rcis.push_back(scanRCD(buf, nativeExtrMethod));
-		remLength -= BE::Feature::INCITSMinutiae::FED_RCD_ITEM_LENGTH;
-	}
+	if (remLength <= 0)
+		return (rcis);
+
+	/* Check the length of all records at once */
+	const Memory::ByteView rcd = buf.scanView(remLength);
+	rcis.reserve(remLength /
+	    BE::Feature::INCITSMinutiae::FED_RCD_ITEM_LENGTH);
+	for (uint64_t offset = 0; offset < rcd.size();
+	    offset += BE::Feature::INCITSMinutiae::FED_RCD_ITEM_LENGTH)
+		rcis.push_back(scanRCD(rcd.data() + offset, nativeExtrMethod));
 	return (rcis);
 }
 
@@ -11,7 +11,7 @@
 #include <cmath>
 
 #include <be_image.h>
-#include <be_memory_mutableindexedbuffer.h>
+#include <be_image_conversion.h>
 
 namespace BE = BiometricEvaluation;
 
@@ -61,7 +61,8 @@ const std::map<BiometricEvaluation::Image::CompressionAlgorithm, std::string>
 	{Image::CompressionAlgorithm::JP2L, "JP2L"},
 	{Image::CompressionAlgorithm::NetPBM, "NetPBM"},
 	{Image::CompressionAlgorithm::PNG, "PNG"},
-	{Image::CompressionAlgorithm::BMP, "BMP"}
+	{Image::CompressionAlgorithm::BMP, "BMP"},
+	{Image::CompressionAlgorithm::TiledRaw, "TiledRaw"}
 };
 
 template<>
@@ -71,7 +72,9 @@ const std::map<BiometricEvaluation::Image::PixelFormat, std::string>
 	{Image::PixelFormat::MonoWhite, "Monochrome white"},
 	{Image::PixelFormat::MonoBlack, "Monochrome black"},
 	{Image::PixelFormat::Gray8, "8-Bit grayscale"},
-	{Image::PixelFormat::RGB24, "24-bit red/green/blue"}
+	{Image::PixelFormat::RGB24, "24-bit red/green/blue"},
+	{Image::PixelFormat::Gray16, "16-Bit grayscale"},
+	{Image::PixelFormat::Native, "Native"}
 };
 
 std::string
@@ -298,25 +301,8 @@ BiometricEvaluation::Image::removeComponents(
 
 	BE::Memory::uint8Array out((rawData.size() / pixelStride) *
 	    (numComponents - numComponentsToRemove) * componentStride);
-	BE::Memory::MutableIndexedBuffer outBuf(out);
-
-	/* Naively loop over image, skipping over specified components */
-	for (uint64_t px = 0; px < rawData.size(); px += pixelStride) {
-		for (uint8_t comp = 0; comp < numComponents; ++comp) {
-			if (!components[comp]) {
-				switch (bitDepth) {
-				case 8:
-					outBuf.pushU8Val(rawData[px +
-					    (comp * componentStride)]);
-					break;
-				case 16:
-					outBuf.pushBeU16Val(rawData[px +
-					    (comp * componentStride)]);
-					break;
-				}
-			}
-		}
-	}
+	BE::Image::Conversion::removeComponents(rawData, out,
+	    rawData.size() / pixelStride, componentStride, components);
 
 	return (out);
 }
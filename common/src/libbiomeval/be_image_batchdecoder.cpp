@@ -0,0 +1,283 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <cstring>
+
+#include <be_error_exception.h>
+#include <be_image_batchdecoder.h>
+#include <be_image_image.h>
+#include <be_io_utility.h>
+#include <be_system.h>
+
+namespace BE = BiometricEvaluation;
+
+BiometricEvaluation::Image::BatchDecoder::BatchDecoder(
+    uint32_t threads,
+    uint32_t maxPending,
+    Order order,
+    uint8_t scaleDenominator) :
+    _order(order),
+    _scaleDenominator(scaleDenominator),
+    _maxPending(maxPending),
+    _added(0),
+    _nextIndex(0),
+    _pending(0),
+    _returned(0),
+    _closed(false),
+    _stop(false)
+{
+	switch (scaleDenominator) {
+	case 1:
+		/* FALLTHROUGH */
+	case 2:
+		/* FALLTHROUGH */
+	case 4:
+		/* FALLTHROUGH */
+	case 8:
+		break;
+	default:
+		throw Error::ParameterError("Invalid scale denominator (" +
+		    std::to_string(scaleDenominator) + ")");
+	}
+
+	if (threads == 0)
+		threads = std::max<uint32_t>(System::getCPUCount(), 1);
+	if (_maxPending == 0)
+		_maxPending = threads * 2;
+
+	pthread_mutex_init(&_readMutex, nullptr);
+	pthread_mutex_init(&_mutex, nullptr);
+	pthread_cond_init(&_work, nullptr);
+	pthread_cond_init(&_done, nullptr);
+
+	for (uint32_t i = 0; i < threads; i++) {
+		pthread_t thread;
+		const int rv = pthread_create(&thread, nullptr,
+		    BatchDecoder::worker, this);
+		if (rv != 0) {
+			/* The destructor does not run for a constructor */
+			this->stopThreads();
+			pthread_cond_destroy(&_done);
+			pthread_cond_destroy(&_work);
+			pthread_mutex_destroy(&_mutex);
+			pthread_mutex_destroy(&_readMutex);
+			throw Error::StrategyError("Could not start decoding "
+			    "thread: " + std::string(strerror(rv)));
+		}
+		_threads.push_back(thread);
+	}
+}
+
+BiometricEvaluation::Image::BatchDecoder::~BatchDecoder()
+{
+	this->stopThreads();
+
+	pthread_cond_destroy(&_done);
+	pthread_cond_destroy(&_work);
+	pthread_mutex_destroy(&_mutex);
+	pthread_mutex_destroy(&_readMutex);
+}
+
+void
+BiometricEvaluation::Image::BatchDecoder::stopThreads()
+{
+	pthread_mutex_lock(&_mutex);
+	_stop = true;
+	_sources.clear();
+	pthread_cond_broadcast(&_work);
+	pthread_mutex_unlock(&_mutex);
+
+	for (const auto &thread : _threads)
+		pthread_join(thread, nullptr);
+	_threads.clear();
+}
+
+uint64_t
+BiometricEvaluation::Image::BatchDecoder::add(
+    const Memory::ByteView &data)
+{
+	Source source{};
+	source.data = data;
+	return (this->enqueue(std::move(source)));
+}
+
+uint64_t
+BiometricEvaluation::Image::BatchDecoder::add(
+    const std::string &path)
+{
+	Source source{};
+	source.path = path;
+	return (this->enqueue(std::move(source)));
+}
+
+uint64_t
+BiometricEvaluation::Image::BatchDecoder::add(
+    const std::shared_ptr<IO::RecordStore> &recordStore,
+    const std::string &key)
+{
+	if (recordStore == nullptr)
+		throw Error::ParameterError("RecordStore is nullptr");
+
+	Source source{};
+	source.path = key;
+	source.recordStore = recordStore;
+	return (this->enqueue(std::move(source)));
+}
+
+uint64_t
+BiometricEvaluation::Image::BatchDecoder::enqueue(
+    Source &&source)
+{
+	pthread_mutex_lock(&_mutex);
+	if (_closed) {
+		pthread_mutex_unlock(&_mutex);
+		throw Error::StrategyError("BatchDecoder is closed");
+	}
+	source.index = _added++;
+	const uint64_t index = source.index;
+	_sources.push_back(std::move(source));
+	pthread_cond_signal(&_work);
+	pthread_mutex_unlock(&_mutex);
+
+	return (index);
+}
+
+void
+BiometricEvaluation::Image::BatchDecoder::close()
+{
+	pthread_mutex_lock(&_mutex);
+	_closed = true;
+	pthread_cond_broadcast(&_done);
+	pthread_mutex_unlock(&_mutex);
+}
+
+bool
+BiometricEvaluation::Image::BatchDecoder::next(
+    Result &result)
+{
+	pthread_mutex_lock(&_mutex);
+	for (;;) {
+		if (!_results.empty()) {
+			/* Lowest index finished, or exactly the next one */
+			auto it = _results.begin();
+			if ((_order == Order::Completion) ||
+			    (it->first == _nextIndex))
+				break;
+		}
+		if (_closed && (_returned == _added)) {
+			pthread_mutex_unlock(&_mutex);
+			return (false);
+		}
+		pthread_cond_wait(&_done, &_mutex);
+	}
+
+	auto it = _results.begin();
+	result = std::move(it->second);
+	_results.erase(it);
+	if (result.index == _nextIndex)
+		_nextIndex++;
+	_returned++;
+	_pending--;
+
+	/* A slot is free for another decode */
+	pthread_cond_signal(&_work);
+	pthread_mutex_unlock(&_mutex);
+
+	return (true);
+}
+
+uint32_t
+BiometricEvaluation::Image::BatchDecoder::getThreadCount()
+    const
+{
+	return (_threads.size());
+}
+
+BiometricEvaluation::Image::BatchDecoder::Result
+BiometricEvaluation::Image::BatchDecoder::decode(
+    const Source &source)
+{
+	Result result;
+	result.index = source.index;
+	result.name = source.path;
+
+	try {
+		Memory::uint8Array buffer;
+		Memory::ByteView data = source.data;
+		if (source.recordStore != nullptr) {
+			pthread_mutex_lock(&_readMutex);
+			try {
+				buffer = source.recordStore->read(source.path);
+			} catch (...) {
+				pthread_mutex_unlock(&_readMutex);
+				throw;
+			}
+			pthread_mutex_unlock(&_readMutex);
+			data = Memory::ByteView(buffer, buffer.size());
+		} else if (!source.path.empty()) {
+			buffer = IO::Utility::readFile(source.path);
+			data = Memory::ByteView(buffer, buffer.size());
+		}
+
+		/* Codecs reference data rather than copy it */
+		const auto image = Image::openImage(data);
+		result.properties.compressionAlgorithm =
+		    image->getCompressionAlgorithm();
+		result.properties.dimensions = image->getDimensions();
+		result.properties.colorDepth = image->getColorDepth();
+		result.properties.bitDepth = image->getBitDepth();
+		result.properties.resolution = image->getResolution();
+		result.properties.hasAlphaChannel = image->hasAlphaChannel();
+		if (_scaleDenominator == 1)
+			result.rawData = image->getRawData();
+		else
+			result.rawData = image->getReducedRawData(
+			    _scaleDenominator);
+	} catch (...) {
+		result.rawData = Memory::uint8Array();
+		result.error = std::current_exception();
+	}
+
+	return (result);
+}
+
+void
+BiometricEvaluation::Image::BatchDecoder::work()
+{
+	pthread_mutex_lock(&_mutex);
+	for (;;) {
+		/* Wait for a source and room for its result */
+		while (!_stop && (_sources.empty() ||
+		    (_pending >= _maxPending)))
+			pthread_cond_wait(&_work, &_mutex);
+		if (_stop)
+			break;
+
+		const Source source = std::move(_sources.front());
+		_sources.pop_front();
+		_pending++;
+		pthread_mutex_unlock(&_mutex);
+
+		Result result = this->decode(source);
+
+		pthread_mutex_lock(&_mutex);
+		_results.emplace(result.index, std::move(result));
+		pthread_cond_broadcast(&_done);
+	}
+	pthread_mutex_unlock(&_mutex);
+}
+
+void*
+BiometricEvaluation::Image::BatchDecoder::worker(
+    void *arg)
+{
+	static_cast<BatchDecoder*>(arg)->work();
+	return (nullptr);
+}
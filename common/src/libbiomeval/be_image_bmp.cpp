@@ -9,15 +9,23 @@
  */
 
 #include <be_image_bmp.h>
+#include <be_memory_accounting.h>
 
 BiometricEvaluation::Image::BMP::BMP(
     const uint8_t *data,
     const uint64_t size) :
-    Image::Image(data,
-    size,
+    BiometricEvaluation::Image::BMP::BMP(Memory::ByteView(data, size))
+{
+	this->copyData();
+}
+
+BiometricEvaluation::Image::BMP::BMP(
+    const Memory::ByteView &data) :
+    Image::Image(
+    data,
     CompressionAlgorithm::BMP)
 {
-	if (BMP::isBMP(data, size) == false)
+	if (BMP::isBMP(data.data(), data.size()) == false)
 		throw Error::StrategyError("Not a BMP");
 
 	BITMAPINFOHEADER dibHeader;
@@ -27,7 +35,7 @@ BiometricEvaluation::Image::BMP::BMP(
 		 * if this type of BMP is supported.
 		 */
 		BMPHeader bmpHeader;
-		BMP::getBMPHeader(data, size, &bmpHeader);
+		BMP::getBMPHeader(data.data(), data.size(), &bmpHeader);
 
 		/* 
 		 * The types of BMP supported in this class do not support
@@ -35,7 +43,7 @@ BiometricEvaluation::Image::BMP::BMP(
 		 */
 		this->setHasAlphaChannel(false);
 
-		BMP::getDIBHeader(data, size, &dibHeader);
+		BMP::getDIBHeader(data.data(), data.size(), &dibHeader);
 	} catch (Error::NotImplemented &e) {
 		throw Error::StrategyError(e.what());
 	}
@@ -54,10 +62,56 @@ BiometricEvaluation::Image::BMP::BMP(
 
 }
 
+/**
+ * @brief
+ * Convert a run of uncompressed BMP pixels to raw pixels.
+ *
+ * @param[in] bmpRow
+ *	BMP pixels.
+ * @param[out] rawRow
+ *	Raw pixels.
+ * @param[in] bitsPerPixel
+ *	Bits per BMP pixel: 32, 24, or 8.
+ * @param[in] size
+ *	Bytes to convert.
+ */
+static void
+convertRow(
+    const uint8_t *bmpRow,
+    uint8_t *rawRow,
+    uint16_t bitsPerPixel,
+    uint64_t size)
+{
+	switch (bitsPerPixel) {
+	case 32:
+		/* BGRA -> RGBA */
+		for (uint64_t i = 0; (i + 4) <= size; i += 4) {
+			rawRow[i] = bmpRow[i + 2];
+			rawRow[i + 1] = bmpRow[i + 1];
+			rawRow[i + 2] = bmpRow[i];
+			rawRow[i + 3] = bmpRow[i + 3];
+		}
+		break;
+	case 24:
+		/* BGR -> RGB */
+		for (uint64_t i = 0; (i + 3) <= size; i += 3) {
+			rawRow[i] = bmpRow[i + 2];
+			rawRow[i + 1] = bmpRow[i + 1];
+			rawRow[i + 2] = bmpRow[i];
+		}
+		break;
+	case 8:
+		memcpy(rawRow, bmpRow, size);
+		break;
+	}
+}
+
 BiometricEvaluation::Memory::AutoArray<uint8_t>
-BiometricEvaluation::Image::BMP::getRawData()
+BiometricEvaluation::Image::BMP::decodeRawData()
     const
 {
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
 	const uint8_t *bmpData = this->getDataPointer();
 	uint64_t bmpDataSize = this->getDataSize();
 
@@ -95,30 +149,8 @@ BiometricEvaluation::Image::BMP::getRawData()
 				bmpRow = bmpData + bmpHeader.startingAddress +
 				    ((dibHeader.height - row - 1) * stride);
 
-			switch (dibHeader.bitsPerPixel) {
-			case 32:
-				/* BGRA -> RGBA */
-				for (uint64_t i = 0; i <= (stride - 4);
-				    i += 4) {
-					rawRow[i] = bmpRow[i + 2];
-					rawRow[i + 1] = bmpRow[i + 1];
-					rawRow[i + 2] = bmpRow[i];
-					rawRow[i + 3] = bmpRow[i + 3];
-				}
-				break;
-			case 24:
-				/* BGR -> RGB */
-				for (uint64_t i = 0; i <= (stride - 3);
-				    i += 3) {
-					rawRow[i] = bmpRow[i + 2];
-					rawRow[i + 1] = bmpRow[i + 1];
-					rawRow[i + 2] = bmpRow[i];
-				}
-				break;
-			case 8:
-				memcpy(rawRow, bmpRow, stride);
-				break;
-			}
+			convertRow(bmpRow, rawRow, dibHeader.bitsPerPixel,
+			    stride);
 		}
 		break;
 	}
@@ -153,6 +185,63 @@ BiometricEvaluation::Image::BMP::getRawData()
 	return (rawData);
 }
 
+bool
+BiometricEvaluation::Image::BMP::decodesRegions()
+    const
+{
+	BITMAPINFOHEADER dibHeader;
+	try {
+		BMP::getDIBHeader(this->getDataPointer(), this->getDataSize(),
+		    &dibHeader);
+	} catch (Error::Exception &e) {
+		return (false);
+	}
+	return (dibHeader.compressionMethod == BI_RGB);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::BMP::decodeRawRegion(
+    const Coordinate &origin,
+    const Size &size)
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	const uint8_t *bmpData = this->getDataPointer();
+	uint64_t bmpDataSize = this->getDataSize();
+
+	BMPHeader bmpHeader;
+	BITMAPINFOHEADER dibHeader;
+	try {
+		BMP::getBMPHeader(bmpData, bmpDataSize, &bmpHeader);
+		BMP::getDIBHeader(bmpData, bmpDataSize, &dibHeader);
+	} catch (Error::NotImplemented &e) {
+		throw Error::DataError(e.what());
+	}
+	if (dibHeader.compressionMethod != BI_RGB)
+		return (Image::decodeRawRegion(origin, size));
+
+	const uint64_t pixelSize = dibHeader.bitsPerPixel / 8;
+	const uint64_t stride = pixelSize * dibHeader.width;
+	const uint32_t height = this->getDimensions().ySize;
+	if ((bmpHeader.startingAddress + (height * stride)) > bmpDataSize)
+		throw Error::DataError("Buffer length too small");
+
+	const uint64_t rowSize = pixelSize * size.xSize;
+	Memory::uint8Array rawData(rowSize * size.ySize);
+	for (uint32_t row = origin.y; row < (origin.y + size.ySize); row++) {
+		/* Pixels are stored top to bottom if height is < 0 */
+		const uint64_t bmpRow = (dibHeader.height < 0 ? row :
+		    (height - row - 1));
+		convertRow(bmpData + bmpHeader.startingAddress +
+		    (bmpRow * stride) + (origin.x * pixelSize),
+		    rawData + ((row - origin.y) * rowSize),
+		    dibHeader.bitsPerPixel, rowSize);
+	}
+
+	return (rawData);
+}
+
 BiometricEvaluation::Memory::AutoArray<uint8_t>
 BiometricEvaluation::Image::BMP::getRawGrayscaleData(
     uint8_t depth)
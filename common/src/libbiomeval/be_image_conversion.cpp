@@ -0,0 +1,915 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+/*
+ * The x86-64 kernels are compiled for their instruction sets with target
+ * attributes, so the rest of the library (and this file's portable code)
+ * keeps the baseline instruction set and the choice is made at run time.
+ */
+#if defined __x86_64__ && defined __GNUC__
+#define BE_IMAGE_CONVERSION_X86
+#include <immintrin.h>
+#endif
+
+#include <atomic>
+#include <cstring>
+
+#include <be_error_exception.h>
+#include <be_image_conversion.h>
+
+namespace BE = BiometricEvaluation;
+
+template<>
+const std::map<BiometricEvaluation::Image::Conversion::Instructions,
+    std::string> BiometricEvaluation::Framework::EnumerationFunctions<
+    BiometricEvaluation::Image::Conversion::Instructions>::enumToStringMap = {
+	{Image::Conversion::Instructions::Scalar, "Scalar"},
+	{Image::Conversion::Instructions::SSE41, "SSE4.1"},
+	{Image::Conversion::Instructions::AVX2, "AVX2"}
+};
+
+/******************************************************************************/
+/* Portable kernels.                                                          */
+/******************************************************************************/
+
+/*
+ * Constants from ITU-R BT.601. The float arithmetic below, including the
+ * order of operations and truncation, is what Image::getRawGrayscaleData()
+ * has always done, and the vector kernels repeat it exactly.
+ */
+static const float redFactor = 0.299;
+static const float greenFactor = 0.587;
+static const float blueFactor = 0.114;
+
+/** Read a native-order 16-bit sample */
+static inline uint16_t
+loadU16(
+    const uint8_t *p)
+{
+	uint16_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return (v);
+}
+
+/** Write a native-order 16-bit sample */
+static inline void
+storeU16(
+    uint8_t *p,
+    uint16_t v)
+{
+	std::memcpy(p, &v, sizeof(v));
+}
+
+/**
+ * @brief
+ * Convert color pixels to grayscale.
+ *
+ * @param[in] in
+ *	First sample of the first pixel to convert.
+ * @param[out] out
+ *	First output sample.
+ * @param[in] pixels
+ *	Number of pixels.
+ * @param[in] channels
+ *	Samples per pixel.
+ * @param[in] inSize
+ *	Bytes per input sample (1 or 2).
+ * @param[in] outSize
+ *	Bytes per output sample (1 or 2).
+ */
+static void
+colorToGrayScalar(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t pixels,
+    uint8_t channels,
+    uint8_t inSize,
+    uint8_t outSize)
+{
+	const uint64_t stride = channels * inSize;
+	uint16_t r, g, b;
+	for (uint64_t p = 0; p < pixels; p++, in += stride) {
+		if (inSize == 1) {
+			r = in[0];
+			g = in[1];
+			b = in[2];
+			if (outSize == 2) {
+				r *= 257;
+				g *= 257;
+				b *= 257;
+			}
+		} else {
+			r = loadU16(in);
+			g = loadU16(in + 2);
+			b = loadU16(in + 4);
+			if (outSize == 1) {
+				r /= 257;
+				g /= 257;
+				b /= 257;
+			}
+		}
+
+		const float y = (r * redFactor) + (g * greenFactor) +
+		    (b * blueFactor);
+		if (outSize == 1)
+			out[p] = static_cast<uint8_t>(y);
+		else
+			storeU16(out + (p * 2), static_cast<uint16_t>(y));
+	}
+}
+
+static void
+rescale8To16Scalar(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t count)
+{
+	for (uint64_t i = 0; i < count; i++)
+		storeU16(out + (i * 2), static_cast<uint16_t>(in[i] * 257));
+}
+
+static void
+rescale16To8Scalar(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t count)
+{
+	for (uint64_t i = 0; i < count; i++)
+		out[i] = static_cast<uint8_t>(loadU16(in + (i * 2)) / 257);
+}
+
+static void
+thresholdScalar(
+    uint8_t *data,
+    uint64_t count)
+{
+	for (uint64_t i = 0; i < count; i++)
+		data[i] = (data[i] <= 127 ? 0x00 : 0xFF);
+}
+
+static void
+removeComponentsScalar(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t pixels,
+    uint8_t componentSize,
+    const std::vector<bool> &components)
+{
+	const uint64_t stride = components.size() * componentSize;
+	for (uint64_t p = 0; p < pixels; p++, in += stride) {
+		for (uint8_t c = 0; c < components.size(); c++) {
+			if (components[c])
+				continue;
+			std::memcpy(out, in + (c * componentSize),
+			    componentSize);
+			out += componentSize;
+		}
+	}
+}
+
+static void
+interleaveScalar(
+    const int32_t *const *planes,
+    uint8_t planeCount,
+    uint8_t *out,
+    uint64_t count,
+    uint8_t sampleSize,
+    uint32_t mask)
+{
+	for (uint64_t i = 0; i < count; i++) {
+		for (uint8_t p = 0; p < planeCount; p++) {
+			const uint32_t v = static_cast<uint32_t>(planes[p][i]) &
+			    mask;
+			if (sampleSize == 1)
+				*out++ = static_cast<uint8_t>(v);
+			else {
+				storeU16(out, static_cast<uint16_t>(v));
+				out += 2;
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+/* x86-64 kernels.                                                            */
+/******************************************************************************/
+
+#if defined BE_IMAGE_CONVERSION_X86
+
+/**
+ * @brief
+ * Shuffle masks gathering the red, green and blue samples of four pixels
+ * into 32-bit lanes.
+ * @details
+ * Samples are read from two 16-byte loads: A at the first pixel and B at
+ * secondOffset bytes past it. A sample is taken from A when it lies wholly
+ * within A.
+ */
+struct GatherMasks
+{
+	int8_t a[3][16];
+	int8_t b[3][16];
+	/** Offset of load B from load A */
+	uint8_t secondOffset;
+	/** Whether any sample is taken from B */
+	bool useB;
+	/** Bytes read from the first pixel */
+	uint8_t span;
+
+	GatherMasks(
+	    uint8_t channels,
+	    uint8_t sampleSize)
+	{
+		std::memset(a, 0x80, sizeof(a));
+		std::memset(b, 0x80, sizeof(b));
+		const uint8_t fourPixels = 4 * channels * sampleSize;
+		this->secondOffset = (fourPixels > 16 ? fourPixels - 16 : 0);
+		this->useB = false;
+		for (uint8_t c = 0; c < 3; c++) {
+			for (uint8_t k = 0; k < 4; k++) {
+				const uint8_t o = ((k * channels) + c) *
+				    sampleSize;
+				for (uint8_t j = 0; j < sampleSize; j++) {
+					if (o + sampleSize <= 16) {
+						a[c][(4 * k) + j] = o + j;
+					} else {
+						b[c][(4 * k) + j] = o + j -
+						    this->secondOffset;
+						this->useB = true;
+					}
+				}
+			}
+		}
+		this->span = (this->useB ? this->secondOffset + 16 : 16);
+	}
+};
+
+/** @return Masks for channels samples of sampleSize bytes */
+static const GatherMasks &
+getGatherMasks(
+    uint8_t channels,
+    uint8_t sampleSize)
+{
+	static const GatherMasks masks[2][2] = {
+		{GatherMasks(3, 1), GatherMasks(3, 2)},
+		{GatherMasks(4, 1), GatherMasks(4, 2)}
+	};
+	return (masks[channels - 3][sampleSize - 1]);
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i
+gatherSSE41(
+    __m128i a,
+    __m128i b,
+    const GatherMasks &masks,
+    uint8_t channel)
+{
+	__m128i v = _mm_shuffle_epi8(a, _mm_loadu_si128(
+	    reinterpret_cast<const __m128i *>(masks.a[channel])));
+	if (masks.useB)
+		v = _mm_or_si128(v, _mm_shuffle_epi8(b, _mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(masks.b[channel]))));
+	return (v);
+}
+
+/** @return Pixels converted; the caller converts the rest */
+__attribute__((target("sse4.1")))
+static uint64_t
+colorToGraySSE41(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t pixels,
+    uint8_t channels,
+    uint8_t inSize,
+    uint8_t outSize)
+{
+	const GatherMasks &masks = getGatherMasks(channels, inSize);
+	const uint64_t stride = channels * inSize;
+	const uint64_t inBytes = pixels * stride;
+
+	const __m128 vRed = _mm_set1_ps(redFactor);
+	const __m128 vGreen = _mm_set1_ps(greenFactor);
+	const __m128 vBlue = _mm_set1_ps(blueFactor);
+	const __m128i narrow = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1,
+	    -1, -1, -1, -1, -1, -1, -1, -1);
+
+	uint64_t p = 0;
+	for (; (p * stride) + masks.span <= inBytes; p += 4) {
+		const uint8_t *src = in + (p * stride);
+		const __m128i a = _mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(src));
+		const __m128i b = (masks.useB ? _mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(src +
+		    masks.secondOffset)) : a);
+
+		__m128i rgb[3];
+		for (uint8_t c = 0; c < 3; c++) {
+			rgb[c] = gatherSSE41(a, b, masks, c);
+			if ((inSize == 1) && (outSize == 2))
+				rgb[c] = _mm_mullo_epi32(rgb[c],
+				    _mm_set1_epi32(257));
+			else if ((inSize == 2) && (outSize == 1))
+				/* Exact floor(x / 257) for 16-bit x */
+				rgb[c] = _mm_srli_epi32(_mm_mullo_epi32(rgb[c],
+				    _mm_set1_epi32(0xFF01)), 24);
+		}
+
+		const __m128 y = _mm_add_ps(_mm_add_ps(
+		    _mm_mul_ps(_mm_cvtepi32_ps(rgb[0]), vRed),
+		    _mm_mul_ps(_mm_cvtepi32_ps(rgb[1]), vGreen)),
+		    _mm_mul_ps(_mm_cvtepi32_ps(rgb[2]), vBlue));
+		const __m128i yi = _mm_cvttps_epi32(y);
+
+		if (outSize == 1) {
+			const int32_t packed = _mm_cvtsi128_si32(
+			    _mm_shuffle_epi8(yi, narrow));
+			std::memcpy(out + p, &packed, 4);
+		} else {
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(
+			    out + (p * 2)), _mm_packus_epi32(yi, yi));
+		}
+	}
+	return (p);
+}
+
+/** @return Pixels converted; the caller converts the rest */
+__attribute__((target("avx2")))
+static uint64_t
+colorToGrayAVX2(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t pixels,
+    uint8_t channels,
+    uint8_t inSize,
+    uint8_t outSize)
+{
+	const GatherMasks &masks = getGatherMasks(channels, inSize);
+	const uint64_t stride = channels * inSize;
+	const uint64_t inBytes = pixels * stride;
+
+	__m256i maskA[3], maskB[3];
+	for (uint8_t c = 0; c < 3; c++) {
+		maskA[c] = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(masks.a[c])));
+		maskB[c] = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(masks.b[c])));
+	}
+
+	const __m256 vRed = _mm256_set1_ps(redFactor);
+	const __m256 vGreen = _mm256_set1_ps(greenFactor);
+	const __m256 vBlue = _mm256_set1_ps(blueFactor);
+	const __m256i narrow = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+	    0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+
+	/* Pixels p..p+3 in the low lane, p+4..p+7 in the high lane */
+	uint64_t p = 0;
+	for (; ((p + 4) * stride) + masks.span <= inBytes; p += 8) {
+		const uint8_t *lo = in + (p * stride);
+		const uint8_t *hi = lo + (4 * stride);
+		const __m256i a = _mm256_inserti128_si256(
+		    _mm256_castsi128_si256(_mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(lo))), _mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(hi)), 1);
+		__m256i b = a;
+		if (masks.useB)
+			b = _mm256_inserti128_si256(_mm256_castsi128_si256(
+			    _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+			    lo + masks.secondOffset))), _mm_loadu_si128(
+			    reinterpret_cast<const __m128i *>(
+			    hi + masks.secondOffset)), 1);
+
+		__m256i rgb[3];
+		for (uint8_t c = 0; c < 3; c++) {
+			rgb[c] = _mm256_shuffle_epi8(a, maskA[c]);
+			if (masks.useB)
+				rgb[c] = _mm256_or_si256(rgb[c],
+				    _mm256_shuffle_epi8(b, maskB[c]));
+			if ((inSize == 1) && (outSize == 2))
+				rgb[c] = _mm256_mullo_epi32(rgb[c],
+				    _mm256_set1_epi32(257));
+			else if ((inSize == 2) && (outSize == 1))
+				/* Exact floor(x / 257) for 16-bit x */
+				rgb[c] = _mm256_srli_epi32(_mm256_mullo_epi32(
+				    rgb[c], _mm256_set1_epi32(0xFF01)), 24);
+		}
+
+		const __m256 y = _mm256_add_ps(_mm256_add_ps(
+		    _mm256_mul_ps(_mm256_cvtepi32_ps(rgb[0]), vRed),
+		    _mm256_mul_ps(_mm256_cvtepi32_ps(rgb[1]), vGreen)),
+		    _mm256_mul_ps(_mm256_cvtepi32_ps(rgb[2]), vBlue));
+		const __m256i yi = _mm256_cvttps_epi32(y);
+
+		if (outSize == 1) {
+			const __m256i packed = _mm256_shuffle_epi8(yi, narrow);
+			const int32_t low = _mm_cvtsi128_si32(
+			    _mm256_castsi256_si128(packed));
+			const int32_t high = _mm_cvtsi128_si32(
+			    _mm256_extracti128_si256(packed, 1));
+			std::memcpy(out + p, &low, 4);
+			std::memcpy(out + p + 4, &high, 4);
+		} else {
+			const __m256i packed = _mm256_permute4x64_epi64(
+			    _mm256_packus_epi32(yi, yi), 0x08);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(
+			    out + (p * 2)), _mm256_castsi256_si128(packed));
+		}
+	}
+	return (p);
+}
+
+/** @return Samples rescaled; the caller rescales the rest */
+__attribute__((target("sse4.1")))
+static uint64_t
+rescale8To16SSE41(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t count)
+{
+	uint64_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m128i v = _mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(in + i));
+		/* (x << 8) | x == x * 257 */
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + (i * 2)),
+		    _mm_unpacklo_epi8(v, v));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(
+		    out + (i * 2) + 16), _mm_unpackhi_epi8(v, v));
+	}
+	return (i);
+}
+
+/** @return Samples rescaled; the caller rescales the rest */
+__attribute__((target("avx2")))
+static uint64_t
+rescale8To16AVX2(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t count)
+{
+	uint64_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(in + i)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + (i * 2)),
+		    _mm256_or_si256(v, _mm256_slli_epi16(v, 8)));
+	}
+	return (i);
+}
+
+/** @return Samples rescaled; the caller rescales the rest */
+__attribute__((target("sse4.1")))
+static uint64_t
+rescale16To8SSE41(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t count)
+{
+	/* Exact floor(x / 257) for 16-bit x */
+	const __m128i reciprocal = _mm_set1_epi16(static_cast<int16_t>(0xFF01));
+
+	uint64_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m128i a = _mm_srli_epi16(_mm_mulhi_epu16(
+		    _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+		    in + (i * 2))), reciprocal), 8);
+		const __m128i b = _mm_srli_epi16(_mm_mulhi_epu16(
+		    _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+		    in + (i * 2) + 16)), reciprocal), 8);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+		    _mm_packus_epi16(a, b));
+	}
+	return (i);
+}
+
+/** @return Samples rescaled; the caller rescales the rest */
+__attribute__((target("avx2")))
+static uint64_t
+rescale16To8AVX2(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t count)
+{
+	/* Exact floor(x / 257) for 16-bit x */
+	const __m256i reciprocal = _mm256_set1_epi16(
+	    static_cast<int16_t>(0xFF01));
+
+	uint64_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		const __m256i a = _mm256_srli_epi16(_mm256_mulhi_epu16(
+		    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(
+		    in + (i * 2))), reciprocal), 8);
+		const __m256i b = _mm256_srli_epi16(_mm256_mulhi_epu16(
+		    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(
+		    in + (i * 2) + 32)), reciprocal), 8);
+		/* Packing works within lanes, so restore the order */
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+		    _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+	}
+	return (i);
+}
+
+/** @return Samples quantized; the caller quantizes the rest */
+__attribute__((target("sse4.1")))
+static uint64_t
+thresholdSSE41(
+    uint8_t *data,
+    uint64_t count)
+{
+	/* Samples above 127 have their sign bit set */
+	const __m128i zero = _mm_setzero_si128();
+
+	uint64_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i *p = reinterpret_cast<__m128i *>(data + i);
+		_mm_storeu_si128(p, _mm_cmplt_epi8(_mm_loadu_si128(p), zero));
+	}
+	return (i);
+}
+
+/** @return Samples quantized; the caller quantizes the rest */
+__attribute__((target("avx2")))
+static uint64_t
+thresholdAVX2(
+    uint8_t *data,
+    uint64_t count)
+{
+	/* Samples above 127 have their sign bit set */
+	const __m256i zero = _mm256_setzero_si256();
+
+	uint64_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		__m256i *p = reinterpret_cast<__m256i *>(data + i);
+		_mm256_storeu_si256(p, _mm256_cmpgt_epi8(zero,
+		    _mm256_loadu_si256(p)));
+	}
+	return (i);
+}
+
+/**
+ * @brief
+ * Remove components from pixels that evenly divide 16 bytes.
+ *
+ * @return
+ *	Pixels copied; the caller copies the rest.
+ */
+__attribute__((target("sse4.1")))
+static uint64_t
+removeComponentsSSE41(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t pixels,
+    uint8_t componentSize,
+    const std::vector<bool> &components)
+{
+	const uint64_t inStride = components.size() * componentSize;
+	if ((inStride > 16) || ((16 % inStride) != 0))
+		return (0);
+
+	/* Build the shuffle keeping the wanted bytes of each pixel */
+	alignas(16) int8_t mask[16];
+	std::memset(mask, 0x80, sizeof(mask));
+	uint8_t kept = 0;
+	for (uint8_t p = 0; p < 16 / inStride; p++)
+		for (uint8_t c = 0; c < components.size(); c++)
+			if (!components[c])
+				for (uint8_t j = 0; j < componentSize; j++)
+					mask[kept++] = (p * inStride) +
+					    (c * componentSize) + j;
+	const uint64_t outStride = kept / (16 / inStride);
+	const __m128i shuffle = _mm_load_si128(
+	    reinterpret_cast<const __m128i *>(mask));
+
+	/* All 16 bytes are stored, so stop before overrunning out */
+	const uint64_t perLoad = 16 / inStride;
+	uint64_t p = 0;
+	for (; (p * outStride) + 16 <= pixels * outStride; p += perLoad)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(
+		    out + (p * outStride)), _mm_shuffle_epi8(_mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(in + (p * inStride))),
+		    shuffle));
+	return (p);
+}
+
+/**
+ * @brief
+ * Interleave up to four planes.
+ * @details
+ * Each step narrows four 8-bit (or two 16-bit) samples from every plane
+ * into bytes [4p, 4p + 4) of one register, then shuffles them into pixel
+ * order.
+ *
+ * @return
+ *	Pixels interleaved; the caller interleaves the rest.
+ */
+__attribute__((target("sse4.1")))
+static uint64_t
+interleaveSSE41(
+    const int32_t *const *planes,
+    uint8_t planeCount,
+    uint8_t *out,
+    uint64_t count,
+    uint8_t sampleSize,
+    uint32_t mask)
+{
+	if ((planeCount == 0) || (planeCount > 4))
+		return (0);
+
+	/* Pixels per step and bytes written per step */
+	const uint8_t step = (sampleSize == 1 ? 4 : 2);
+	const uint8_t outBytes = step * planeCount * sampleSize;
+
+	/* Planar: plane p at bytes [4p, 4p + 4); build the pixel order */
+	alignas(16) int8_t order[16];
+	std::memset(order, 0x80, sizeof(order));
+	for (uint8_t k = 0; k < step; k++)
+		for (uint8_t p = 0; p < planeCount; p++)
+			for (uint8_t j = 0; j < sampleSize; j++)
+				order[(((k * planeCount) + p) * sampleSize) +
+				    j] = (4 * p) + (k * sampleSize) + j;
+	const __m128i shuffle = _mm_load_si128(
+	    reinterpret_cast<const __m128i *>(order));
+	const __m128i vMask = _mm_set1_epi32(static_cast<int32_t>(mask));
+	/* Narrow the low byte or 16 bits of each 32-bit sample */
+	const __m128i narrow = (sampleSize == 1 ?
+	    _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1,
+	    -1, -1, -1, -1) :
+	    _mm_setr_epi8(0, 1, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1,
+	    -1, -1, -1, -1));
+
+	alignas(16) uint8_t pixels[16];
+	uint64_t i = 0;
+	/* Loads read four samples from each plane */
+	for (; i + 4 <= count; i += step) {
+		__m128i planar = _mm_setzero_si128();
+		for (uint8_t p = 0; p < planeCount; p++) {
+			__m128i v = _mm_shuffle_epi8(_mm_and_si128(
+			    _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+			    planes[p] + i)), vMask), narrow);
+			switch (p) {
+			case 1:
+				v = _mm_slli_si128(v, 4);
+				break;
+			case 2:
+				v = _mm_slli_si128(v, 8);
+				break;
+			case 3:
+				v = _mm_slli_si128(v, 12);
+				break;
+			}
+			planar = _mm_or_si128(planar, v);
+		}
+		_mm_store_si128(reinterpret_cast<__m128i *>(pixels),
+		    _mm_shuffle_epi8(planar, shuffle));
+		std::memcpy(out + (i * planeCount * sampleSize), pixels,
+		    outBytes);
+	}
+	return (i);
+}
+
+#endif /* BE_IMAGE_CONVERSION_X86 */
+
+/******************************************************************************/
+/* Dispatch.                                                                  */
+/******************************************************************************/
+
+/** @return Instructions in use, initially the best supported */
+static std::atomic<BE::Image::Conversion::Instructions> &
+currentInstructions()
+{
+	static std::atomic<BE::Image::Conversion::Instructions> current(
+	    BE::Image::Conversion::getSupportedInstructions());
+	return (current);
+}
+
+BiometricEvaluation::Image::Conversion::Instructions
+BiometricEvaluation::Image::Conversion::getSupportedInstructions()
+{
+#if defined BE_IMAGE_CONVERSION_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return (Instructions::AVX2);
+	if (__builtin_cpu_supports("sse4.1"))
+		return (Instructions::SSE41);
+#endif
+	return (Instructions::Scalar);
+}
+
+BiometricEvaluation::Image::Conversion::Instructions
+BiometricEvaluation::Image::Conversion::getInstructions()
+{
+	return (currentInstructions().load(std::memory_order_relaxed));
+}
+
+BiometricEvaluation::Image::Conversion::Instructions
+BiometricEvaluation::Image::Conversion::setInstructions(
+    Instructions instructions)
+{
+	const Instructions supported = getSupportedInstructions();
+	if (to_int_type(instructions) > to_int_type(supported))
+		instructions = supported;
+	currentInstructions().store(instructions, std::memory_order_relaxed);
+	return (instructions);
+}
+
+/** Check and dispatch a color conversion */
+static void
+colorToGray(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t pixels,
+    uint8_t channels,
+    uint8_t inSize,
+    uint8_t outSize)
+{
+	if ((channels != 3) && (channels != 4))
+		throw BE::Error::ParameterError("Unsupported number of "
+		    "channels (" + std::to_string(channels) + ")");
+
+	uint64_t done = 0;
+#if defined BE_IMAGE_CONVERSION_X86
+	switch (BE::Image::Conversion::getInstructions()) {
+	case BE::Image::Conversion::Instructions::AVX2:
+		done = colorToGrayAVX2(in, out, pixels, channels, inSize,
+		    outSize);
+		/* FALLTHROUGH */
+	case BE::Image::Conversion::Instructions::SSE41:
+		done += colorToGraySSE41(in + (done * channels * inSize),
+		    out + (done * outSize), pixels - done, channels, inSize,
+		    outSize);
+		break;
+	case BE::Image::Conversion::Instructions::Scalar:
+		break;
+	}
+#endif
+	colorToGrayScalar(in + (done * channels * inSize),
+	    out + (done * outSize), pixels - done, channels, inSize, outSize);
+}
+
+void
+BiometricEvaluation::Image::Conversion::colorToGray8(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t pixels,
+    uint8_t channels)
+{
+	colorToGray(in, out, pixels, channels, 1, 1);
+}
+
+void
+BiometricEvaluation::Image::Conversion::colorToGray16(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t pixels,
+    uint8_t channels)
+{
+	colorToGray(in, out, pixels, channels, 1, 2);
+}
+
+void
+BiometricEvaluation::Image::Conversion::color16ToGray8(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t pixels,
+    uint8_t channels)
+{
+	colorToGray(in, out, pixels, channels, 2, 1);
+}
+
+void
+BiometricEvaluation::Image::Conversion::color16ToGray16(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t pixels,
+    uint8_t channels)
+{
+	colorToGray(in, out, pixels, channels, 2, 2);
+}
+
+void
+BiometricEvaluation::Image::Conversion::rescale8To16(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t count)
+{
+	uint64_t done = 0;
+#if defined BE_IMAGE_CONVERSION_X86
+	switch (getInstructions()) {
+	case Instructions::AVX2:
+		done = rescale8To16AVX2(in, out, count);
+		break;
+	case Instructions::SSE41:
+		done = rescale8To16SSE41(in, out, count);
+		break;
+	case Instructions::Scalar:
+		break;
+	}
+#endif
+	rescale8To16Scalar(in + done, out + (done * 2), count - done);
+}
+
+void
+BiometricEvaluation::Image::Conversion::rescale16To8(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t count)
+{
+	uint64_t done = 0;
+#if defined BE_IMAGE_CONVERSION_X86
+	switch (getInstructions()) {
+	case Instructions::AVX2:
+		done = rescale16To8AVX2(in, out, count);
+		/* FALLTHROUGH */
+	case Instructions::SSE41:
+		done += rescale16To8SSE41(in + (done * 2), out + done,
+		    count - done);
+		break;
+	case Instructions::Scalar:
+		break;
+	}
+#endif
+	rescale16To8Scalar(in + (done * 2), out + done, count - done);
+}
+
+void
+BiometricEvaluation::Image::Conversion::threshold(
+    uint8_t *data,
+    uint64_t count)
+{
+	uint64_t done = 0;
+#if defined BE_IMAGE_CONVERSION_X86
+	switch (getInstructions()) {
+	case Instructions::AVX2:
+		done = thresholdAVX2(data, count);
+		/* FALLTHROUGH */
+	case Instructions::SSE41:
+		done += thresholdSSE41(data + done, count - done);
+		break;
+	case Instructions::Scalar:
+		break;
+	}
+#endif
+	thresholdScalar(data + done, count - done);
+}
+
+void
+BiometricEvaluation::Image::Conversion::interleave(
+    const int32_t *const *planes,
+    uint8_t planeCount,
+    uint8_t *out,
+    uint64_t count,
+    uint8_t sampleSize,
+    uint32_t mask)
+{
+	if ((sampleSize != 1) && (sampleSize != 2))
+		throw Error::ParameterError("Unsupported sample size (" +
+		    std::to_string(sampleSize) + ")");
+
+	uint64_t done = 0;
+#if defined BE_IMAGE_CONVERSION_X86
+	if (getInstructions() != Instructions::Scalar)
+		done = interleaveSSE41(planes, planeCount, out, count,
+		    sampleSize, mask);
+#endif
+	if (done == count)
+		return;
+
+	std::vector<const int32_t *> rest(planes, planes + planeCount);
+	for (auto &plane : rest)
+		plane += done;
+	interleaveScalar(rest.data(), planeCount,
+	    out + (done * planeCount * sampleSize), count - done, sampleSize,
+	    mask);
+}
+
+void
+BiometricEvaluation::Image::Conversion::removeComponents(
+    const uint8_t *in,
+    uint8_t *out,
+    uint64_t pixels,
+    uint8_t componentSize,
+    const std::vector<bool> &components)
+{
+	uint64_t kept = 0;
+	for (const bool c : components)
+		if (!c)
+			kept++;
+
+	uint64_t done = 0;
+#if defined BE_IMAGE_CONVERSION_X86
+	/* A 16-byte shuffle is as wide as this operation usefully gets */
+	if (getInstructions() != Instructions::Scalar)
+		done = removeComponentsSSE41(in, out, pixels, componentSize,
+		    components);
+#endif
+	removeComponentsScalar(in + (done * components.size() * componentSize),
+	    out + (done * kept * componentSize), pixels - done, componentSize,
+	    components);
+}
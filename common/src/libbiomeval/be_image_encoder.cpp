@@ -0,0 +1,1078 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>		/* Needed for NBIS and libjpeg headers */
+#include <cstdlib>
+#include <cstring>
+
+#include <openjpeg.h>
+#include <png.h>
+
+extern "C" {
+	#include <jpeglib.h>
+	#include <wsq.h>
+}
+
+#include <be_error_exception.h>
+#include <be_image_encoder.h>
+#include <be_memory.h>
+#include <be_system.h>
+
+namespace BE = BiometricEvaluation;
+
+namespace
+{
+	/**
+	 * @brief
+	 * Growable buffer written by codec callbacks.
+	 */
+	class OutputBuffer
+	{
+	public:
+		/** Write length bytes of src at the current offset */
+		void
+		write(
+		    const void *src,
+		    uint64_t length)
+		{
+			this->reserve(_offset + length);
+			std::memcpy(_data + _offset, src, length);
+			_offset += length;
+			_size = std::max(_size, _offset);
+		}
+
+		/** Move the current offset, zero-filling any gap */
+		void
+		seek(
+		    uint64_t offset)
+		{
+			if (offset > _size) {
+				this->reserve(offset);
+				std::memset(_data + _size, 0, offset - _size);
+				_size = offset;
+			}
+			_offset = offset;
+		}
+
+		/** @return Current offset */
+		uint64_t
+		tell()
+		    const
+		{
+			return (_offset);
+		}
+
+		/** @return Bytes written, releasing the buffer */
+		BE::Memory::uint8Array
+		release()
+		{
+			_data.resize(_size, true);
+			_size = _offset = 0;
+			return (std::move(_data));
+		}
+
+	private:
+		/** Grow storage geometrically to hold size bytes */
+		void
+		reserve(
+		    uint64_t size)
+		{
+			if (size <= _data.size())
+				return;
+			if (size > _data.capacity())
+				_data.reserve(std::max<uint64_t>(size,
+				    std::max<uint64_t>(_data.capacity() * 2,
+				    4096)));
+			_data.resize_uninitialized(size);
+		}
+
+		BE::Memory::uint8Array _data{};
+		uint64_t _size{0};
+		uint64_t _offset{0};
+	};
+
+	/**
+	 * Whether this thread is one of several run by
+	 * Encoder::parallelFor(), and so should not start more.
+	 */
+	thread_local bool inParallelFor = false;
+
+	/** @return Bytes in one row of pixels described by properties */
+	uint64_t
+	getRowSize(
+	    const BE::Image::Properties &properties)
+	{
+		return (((static_cast<uint64_t>(properties.dimensions.xSize) *
+		    properties.colorDepth) + 7) / 8);
+	}
+
+	/** @return Components in one pixel described by properties */
+	uint32_t
+	getComponentCount(
+	    const BE::Image::Properties &properties)
+	{
+		if ((properties.bitDepth == 0) ||
+		    ((properties.colorDepth % properties.bitDepth) != 0))
+			throw BE::Error::ParameterError("Color depth (" +
+			    std::to_string(properties.colorDepth) + ") is not "
+			    "a multiple of bit depth (" +
+			    std::to_string(properties.bitDepth) + ")");
+		return (properties.colorDepth / properties.bitDepth);
+	}
+
+	/** @return Resolution in units, or 0 if resolution has no units */
+	double
+	getResolution(
+	    const BE::Image::Resolution &resolution,
+	    BE::Image::Resolution::Units units)
+	{
+		if (resolution.units == BE::Image::Resolution::Units::NA)
+			return (0);
+		return (resolution.toUnits(units).xRes);
+	}
+
+	/**
+	 * @brief
+	 * PNG encoder, via libpng.
+	 */
+	class PNGEncoder : public BE::Image::Encoder
+	{
+	public:
+		PNGEncoder(
+		    const Settings &settings) :
+		    BE::Image::Encoder(BE::Image::CompressionAlgorithm::PNG,
+		    settings)
+		{
+			if ((settings.compressionLevel < -1) ||
+			    (settings.compressionLevel > 9))
+				throw BE::Error::ParameterError("Invalid PNG "
+				    "compression level (" + std::to_string(
+				    settings.compressionLevel) + ")");
+		}
+
+	protected:
+		BE::Memory::uint8Array
+		encodeRawData(
+		    const BE::Memory::ByteView &rawData,
+		    const BE::Image::Properties &properties)
+		    const
+		{
+			const uint32_t components = getComponentCount(
+			    properties);
+			int colorType;
+			switch (components) {
+			case 1:
+				colorType = PNG_COLOR_TYPE_GRAY;
+				break;
+			case 2:
+				colorType = PNG_COLOR_TYPE_GRAY_ALPHA;
+				break;
+			case 3:
+				colorType = PNG_COLOR_TYPE_RGB;
+				break;
+			case 4:
+				colorType = PNG_COLOR_TYPE_RGB_ALPHA;
+				break;
+			default:
+				throw BE::Error::ParameterError("PNG cannot "
+				    "hold " + std::to_string(components) +
+				    " components");
+			}
+			if (((components == 2) || (components == 4)) !=
+			    properties.hasAlphaChannel)
+				throw BE::Error::ParameterError("PNG cannot "
+				    "hold " + std::to_string(components) +
+				    " components " + (properties.hasAlphaChannel ?
+				    "with" : "without") + " alpha");
+			switch (properties.bitDepth) {
+			case 1:
+				/* FALLTHROUGH */
+			case 2:
+				/* FALLTHROUGH */
+			case 4:
+				if (components != 1)
+					throw BE::Error::ParameterError("PNG "
+					    "cannot hold color with bit depth "
+					    "of " + std::to_string(
+					    properties.bitDepth));
+				break;
+			case 8:
+				/* FALLTHROUGH */
+			case 16:
+				break;
+			default:
+				throw BE::Error::ParameterError("PNG cannot "
+				    "hold bit depth of " + std::to_string(
+				    properties.bitDepth));
+			}
+
+			png_structp png_ptr = png_create_write_struct(
+			    PNG_LIBPNG_VER_STRING, nullptr, png_error,
+			    png_warning);
+			if (png_ptr == nullptr)
+				throw BE::Error::StrategyError("libpng could "
+				    "not create png_struct");
+			png_infop png_info_ptr = png_create_info_struct(
+			    png_ptr);
+			if (png_info_ptr == nullptr) {
+				png_destroy_write_struct(&png_ptr, nullptr);
+				throw BE::Error::StrategyError("libpng could "
+				    "not create png_info");
+			}
+
+			OutputBuffer output;
+			try {
+				png_set_write_fn(png_ptr, &output,
+				    png_write_mem_dest, png_flush_mem_dest);
+				if (this->getSettings().compressionLevel >= 0)
+					png_set_compression_level(png_ptr,
+					    this->getSettings().
+					    compressionLevel);
+
+				png_set_IHDR(png_ptr, png_info_ptr,
+				    properties.dimensions.xSize,
+				    properties.dimensions.ySize,
+				    properties.bitDepth, colorType,
+				    PNG_INTERLACE_NONE,
+				    PNG_COMPRESSION_TYPE_DEFAULT,
+				    PNG_FILTER_TYPE_DEFAULT);
+				const double ppcm = getResolution(
+				    properties.resolution,
+				    BE::Image::Resolution::Units::PPCM);
+				if (ppcm > 0) {
+					const BE::Image::Resolution ppcmRes =
+					    properties.resolution.toUnits(
+					    BE::Image::Resolution::Units::PPCM);
+					png_set_pHYs(png_ptr, png_info_ptr,
+					    std::lround(ppcmRes.xRes * 100),
+					    std::lround(ppcmRes.yRes * 100),
+					    PNG_RESOLUTION_METER);
+				}
+				png_write_info(png_ptr, png_info_ptr);
+
+				/* PNG default storage is big-endian */
+				if ((properties.bitDepth > 8) &&
+				    BE::Memory::isLittleEndian())
+					png_set_swap(png_ptr);
+
+				const uint64_t rowSize = getRowSize(properties);
+				for (uint32_t y = 0;
+				    y < properties.dimensions.ySize; y++)
+					png_write_row(png_ptr,
+					    const_cast<png_bytep>(rawData.data() +
+					    (y * rowSize)));
+				png_write_end(png_ptr, png_info_ptr);
+			} catch (...) {
+				png_destroy_write_struct(&png_ptr,
+				    &png_info_ptr);
+				throw;
+			}
+			png_destroy_write_struct(&png_ptr, &png_info_ptr);
+
+			return (output.release());
+		}
+
+	private:
+		/** libpng callback to write to an OutputBuffer */
+		static void
+		png_write_mem_dest(
+		    png_structp png_ptr,
+		    png_bytep data,
+		    png_size_t length)
+		{
+			static_cast<OutputBuffer*>(png_get_io_ptr(png_ptr))->
+			    write(data, length);
+		}
+
+		/** libpng callback to flush an OutputBuffer */
+		static void
+		png_flush_mem_dest(
+		    png_structp png_ptr)
+		{
+
+		}
+
+		/** Convert libpng errors into C++ exceptions */
+		static void
+		png_error(
+		    png_structp png_ptr,
+		    png_const_charp msg)
+		{
+			throw BE::Error::StrategyError("libpng: " +
+			    std::string(msg));
+		}
+
+		/** Ignore libpng warnings */
+		static void
+		png_warning(
+		    png_structp png_ptr,
+		    png_const_charp msg)
+		{
+
+		}
+	};
+
+	/**
+	 * @brief
+	 * libjpeg destination manager writing to an OutputBuffer.
+	 */
+	struct JPEGDestination
+	{
+		/** Must be first, libjpeg sees only this member */
+		struct jpeg_destination_mgr manager;
+		/** Encoded data */
+		OutputBuffer *output;
+		/** Data waiting to be copied to output */
+		JOCTET buffer[65536];
+	};
+
+	/**
+	 * @brief
+	 * Lossy JPEG encoder, via libjpeg.
+	 */
+	class JPEGEncoder : public BE::Image::Encoder
+	{
+	public:
+		JPEGEncoder(
+		    const Settings &settings) :
+		    BE::Image::Encoder(BE::Image::CompressionAlgorithm::JPEGB,
+		    settings)
+		{
+			if ((settings.quality < 1) || (settings.quality > 100))
+				throw BE::Error::ParameterError("Invalid JPEG "
+				    "quality (" + std::to_string(
+				    settings.quality) + ")");
+		}
+
+	protected:
+		BE::Memory::uint8Array
+		encodeRawData(
+		    const BE::Memory::ByteView &rawData,
+		    const BE::Image::Properties &properties)
+		    const
+		{
+			if ((properties.bitDepth != 8) ||
+			    ((properties.colorDepth != 8) &&
+			    (properties.colorDepth != 24)) ||
+			    properties.hasAlphaChannel)
+				throw BE::Error::ParameterError("JPEG cannot "
+				    "hold " + std::to_string(
+				    properties.colorDepth) + "-bit pixels");
+
+			/* Initialize custom JPEG error manager to throw */
+			struct jpeg_error_mgr jpeg_error_mgr;
+			jpeg_std_error(&jpeg_error_mgr);
+			jpeg_error_mgr.error_exit = error_exit;
+
+			struct jpeg_compress_struct cinfo;
+			cinfo.err = &jpeg_error_mgr;
+			jpeg_create_compress(&cinfo);
+
+			OutputBuffer output;
+			std::unique_ptr<JPEGDestination> destination(
+			    new JPEGDestination());
+			destination->manager.init_destination =
+			    init_destination;
+			destination->manager.empty_output_buffer =
+			    empty_output_buffer;
+			destination->manager.term_destination =
+			    term_destination;
+			destination->output = &output;
+			cinfo.dest = &destination->manager;
+
+			try {
+				cinfo.image_width = properties.dimensions.xSize;
+				cinfo.image_height =
+				    properties.dimensions.ySize;
+				cinfo.input_components =
+				    properties.colorDepth / 8;
+				cinfo.in_color_space =
+				    (cinfo.input_components == 1 ?
+				    JCS_GRAYSCALE : JCS_RGB);
+				jpeg_set_defaults(&cinfo);
+				jpeg_set_quality(&cinfo,
+				    this->getSettings().quality, TRUE);
+
+				const double ppi = getResolution(
+				    properties.resolution,
+				    BE::Image::Resolution::Units::PPI);
+				if (ppi > 0) {
+					const BE::Image::Resolution inches =
+					    properties.resolution.toUnits(
+					    BE::Image::Resolution::Units::PPI);
+					cinfo.density_unit = 1;
+					cinfo.X_density = static_cast<UINT16>(
+					    std::lround(inches.xRes));
+					cinfo.Y_density = static_cast<UINT16>(
+					    std::lround(inches.yRes));
+				}
+
+				jpeg_start_compress(&cinfo, TRUE);
+				const uint64_t rowSize = getRowSize(properties);
+				while (cinfo.next_scanline < cinfo.image_height) {
+					JSAMPROW row = const_cast<JSAMPROW>(
+					    rawData.data() + (cinfo.next_scanline *
+					    rowSize));
+					jpeg_write_scanlines(&cinfo, &row, 1);
+				}
+				jpeg_finish_compress(&cinfo);
+			} catch (...) {
+				jpeg_destroy_compress(&cinfo);
+				throw;
+			}
+			jpeg_destroy_compress(&cinfo);
+
+			return (output.release());
+		}
+
+		BE::Image::PixelFormat
+		getPixelFormat(
+		    const BE::Image::Properties &properties)
+		    const
+		{
+			if ((properties.bitDepth == 8) &&
+			    ((properties.colorDepth == 8) ||
+			    (properties.colorDepth == 24)))
+				return (BE::Image::PixelFormat::Native);
+			if (properties.colorDepth == properties.bitDepth)
+				return (BE::Image::PixelFormat::Gray8);
+			return (BE::Image::PixelFormat::RGB24);
+		}
+
+	private:
+		static void
+		init_destination(
+		    j_compress_ptr cinfo)
+		{
+			JPEGDestination *destination =
+			    reinterpret_cast<JPEGDestination*>(cinfo->dest);
+			destination->manager.next_output_byte =
+			    destination->buffer;
+			destination->manager.free_in_buffer =
+			    sizeof(destination->buffer);
+		}
+
+		static boolean
+		empty_output_buffer(
+		    j_compress_ptr cinfo)
+		{
+			/* The whole buffer, regardless of free_in_buffer */
+			JPEGDestination *destination =
+			    reinterpret_cast<JPEGDestination*>(cinfo->dest);
+			destination->output->write(destination->buffer,
+			    sizeof(destination->buffer));
+			init_destination(cinfo);
+			return (TRUE);
+		}
+
+		static void
+		term_destination(
+		    j_compress_ptr cinfo)
+		{
+			JPEGDestination *destination =
+			    reinterpret_cast<JPEGDestination*>(cinfo->dest);
+			destination->output->write(destination->buffer,
+			    sizeof(destination->buffer) -
+			    destination->manager.free_in_buffer);
+		}
+
+		/** Convert libjpeg errors into C++ exceptions */
+		static void
+		error_exit(
+		    j_common_ptr cinfo)
+		{
+			char message[JMSG_LENGTH_MAX];
+			(*cinfo->err->format_message)(cinfo, message);
+			throw BE::Error::StrategyError("libjpeg: " +
+			    std::string(message));
+		}
+	};
+
+	/**
+	 * @brief
+	 * JPEG 2000 encoder, via OpenJPEG.
+	 */
+	class JPEG2000Encoder : public BE::Image::Encoder
+	{
+	public:
+		JPEG2000Encoder(
+		    BE::Image::CompressionAlgorithm compressionAlgorithm,
+		    const Settings &settings) :
+		    BE::Image::Encoder(compressionAlgorithm, settings)
+		{
+			if ((compressionAlgorithm ==
+			    BE::Image::CompressionAlgorithm::JP2) &&
+			    !(settings.compressionRatio >= 1))
+				throw BE::Error::ParameterError("Invalid JPEG "
+				    "2000 compression ratio (" + std::to_string(
+				    settings.compressionRatio) + ")");
+		}
+
+	protected:
+		BE::Memory::uint8Array
+		encodeRawData(
+		    const BE::Memory::ByteView &rawData,
+		    const BE::Image::Properties &properties)
+		    const
+		{
+			const uint32_t components = getComponentCount(
+			    properties);
+			if ((properties.bitDepth < 8) ||
+			    (properties.bitDepth > 16) ||
+			    (components < 1) || (components > 4))
+				throw BE::Error::ParameterError("JPEG 2000 "
+				    "encoding of " + std::to_string(components) +
+				    " components of " + std::to_string(
+				    properties.bitDepth) + " bits is not "
+				    "supported");
+			const uint32_t width = properties.dimensions.xSize;
+			const uint32_t height = properties.dimensions.ySize;
+
+			std::vector<opj_image_cmptparm_t> parameters(
+			    components);
+			for (auto &p : parameters) {
+				std::memset(&p, 0, sizeof(p));
+				p.dx = p.dy = 1;
+				p.w = width;
+				p.h = height;
+				p.prec = properties.bitDepth;
+				p.sgnd = 0;
+			}
+			std::unique_ptr<opj_image_t, void(*)(opj_image_t*)>
+			    image(opj_image_create(components,
+			    parameters.data(), (components < 3 ?
+			    OPJ_CLRSPC_GRAY : OPJ_CLRSPC_SRGB)),
+			    opj_image_destroy);
+			if (image == nullptr)
+				throw BE::Error::StrategyError("libopenjp2: "
+				    "opj_image_create");
+			image->x0 = image->y0 = 0;
+			image->x1 = width;
+			image->y1 = height;
+			if (properties.hasAlphaChannel)
+				image->comps[components - 1].alpha = 1;
+
+			/* Split interleaved pixels into planes */
+			const uint64_t rowSize = getRowSize(properties);
+			for (uint32_t y = 0; y < height; y++) {
+				const uint8_t *row = rawData.data() +
+				    (y * rowSize);
+				for (uint32_t c = 0; c < components; c++) {
+					OPJ_INT32 *plane = image->comps[c].data +
+					    (static_cast<uint64_t>(y) * width);
+					if (properties.bitDepth == 8) {
+						for (uint32_t x = 0; x < width;
+						    x++)
+							plane[x] = row[(x *
+							    components) + c];
+					} else {
+						uint16_t sample;
+						for (uint32_t x = 0; x < width;
+						    x++) {
+							std::memcpy(&sample,
+							    row + (((x *
+							    components) + c) *
+							    2), 2);
+							plane[x] = sample;
+						}
+					}
+				}
+			}
+
+			opj_cparameters_t cparameters;
+			opj_set_default_encoder_parameters(&cparameters);
+			cparameters.tcp_numlayers = 1;
+			cparameters.cp_disto_alloc = 1;
+			if (this->getCompressionAlgorithm() ==
+			    BE::Image::CompressionAlgorithm::JP2L) {
+				/* Reversible 5-3 wavelet */
+				cparameters.tcp_rates[0] = 0;
+				cparameters.irreversible = 0;
+			} else {
+				cparameters.tcp_rates[0] =
+				    this->getSettings().compressionRatio;
+				cparameters.irreversible = 1;
+			}
+			cparameters.tcp_mct = (components >= 3 ? 1 : 0);
+			/* Smallest resolution level must be at least 1x1 */
+			while ((cparameters.numresolution > 1) &&
+			    ((1u << (cparameters.numresolution - 1)) >
+			    std::min(width, height)))
+				cparameters.numresolution--;
+
+			std::unique_ptr<opj_codec_t, void(*)(opj_codec_t*)>
+			    codec(opj_create_compress(OPJ_CODEC_JP2),
+			    opj_destroy_codec);
+			if (codec == nullptr)
+				throw BE::Error::StrategyError("libopenjp2: "
+				    "opj_create_compress");
+			std::string error;
+			opj_set_error_handler(codec.get(), openjpeg_error,
+			    &error);
+			opj_set_warning_handler(codec.get(), nullptr, nullptr);
+			opj_set_info_handler(codec.get(), nullptr, nullptr);
+			if (opj_setup_encoder(codec.get(), &cparameters,
+			    image.get()) == OPJ_FALSE)
+				throw BE::Error::StrategyError("libopenjp2: "
+				    "opj_setup_encoder: " + error);
+#if (OPJ_VERSION_MAJOR > 2) || \
+    ((OPJ_VERSION_MAJOR == 2) && (OPJ_VERSION_MINOR >= 3))
+			/* Batches already run one encode per CPU */
+			uint32_t threads = this->getSettings().threads;
+			if (threads == 0)
+				threads = (inParallelFor ? 1 :
+				    BE::System::getCPUCount());
+			if (threads > 1)
+				opj_codec_set_threads(codec.get(), threads);
+#endif
+
+			OutputBuffer output;
+			std::unique_ptr<opj_stream_t, void(*)(opj_stream_t*)>
+			    stream(opj_stream_default_create(OPJ_FALSE),
+			    opj_stream_destroy);
+			if (stream == nullptr)
+				throw BE::Error::StrategyError("libopenjp2: "
+				    "opj_stream_default_create");
+			opj_stream_set_user_data(stream.get(), &output,
+			    nullptr);
+			opj_stream_set_write_function(stream.get(),
+			    libopenjp2Write);
+			opj_stream_set_skip_function(stream.get(),
+			    libopenjp2Skip);
+			opj_stream_set_seek_function(stream.get(),
+			    libopenjp2Seek);
+
+			if (opj_start_compress(codec.get(), image.get(),
+			    stream.get()) == OPJ_FALSE)
+				throw BE::Error::StrategyError("libopenjp2: "
+				    "opj_start_compress: " + error);
+			if (opj_encode(codec.get(), stream.get()) == OPJ_FALSE)
+				throw BE::Error::StrategyError("libopenjp2: "
+				    "opj_encode: " + error);
+			if (opj_end_compress(codec.get(), stream.get()) ==
+			    OPJ_FALSE)
+				throw BE::Error::StrategyError("libopenjp2: "
+				    "opj_end_compress: " + error);
+
+			/* Stream flushes on destruction */
+			stream.reset();
+			return (output.release());
+		}
+
+		BE::Image::PixelFormat
+		getPixelFormat(
+		    const BE::Image::Properties &properties)
+		    const
+		{
+			if (properties.bitDepth < 8)
+				return (BE::Image::PixelFormat::Gray8);
+			return (BE::Image::PixelFormat::Native);
+		}
+
+	private:
+		/** Record OpenJPEG errors, reported by return values */
+		static void
+		openjpeg_error(
+		    const char *msg,
+		    void *client_data)
+		{
+			static_cast<std::string*>(client_data)->append(msg);
+		}
+
+		static OPJ_SIZE_T
+		libopenjp2Write(
+		    void *p_buffer,
+		    OPJ_SIZE_T p_nb_bytes,
+		    void *p_user_data)
+		{
+			static_cast<OutputBuffer*>(p_user_data)->write(
+			    p_buffer, p_nb_bytes);
+			return (p_nb_bytes);
+		}
+
+		static OPJ_OFF_T
+		libopenjp2Skip(
+		    OPJ_OFF_T p_nb_bytes,
+		    void *p_user_data)
+		{
+			OutputBuffer *output = static_cast<OutputBuffer*>(
+			    p_user_data);
+			if ((p_nb_bytes < 0) &&
+			    (static_cast<uint64_t>(-p_nb_bytes) >
+			    output->tell()))
+				return (-1);
+			output->seek(output->tell() + p_nb_bytes);
+			return (p_nb_bytes);
+		}
+
+		static OPJ_BOOL
+		libopenjp2Seek(
+		    OPJ_OFF_T p_nb_bytes,
+		    void *p_user_data)
+		{
+			if (p_nb_bytes < 0)
+				return (OPJ_FALSE);
+			static_cast<OutputBuffer*>(p_user_data)->seek(
+			    p_nb_bytes);
+			return (OPJ_TRUE);
+		}
+	};
+
+	/**
+	 * @brief
+	 * WSQ encoder, via NBIS.
+	 */
+	class WSQEncoder : public BE::Image::Encoder
+	{
+	public:
+		WSQEncoder(
+		    const Settings &settings) :
+		    BE::Image::Encoder(BE::Image::CompressionAlgorithm::WSQ20,
+		    settings)
+		{
+			if (!(settings.bitRate > 0))
+				throw BE::Error::ParameterError("Invalid WSQ "
+				    "bit rate (" + std::to_string(
+				    settings.bitRate) + ")");
+		}
+
+	protected:
+		BE::Memory::uint8Array
+		encodeRawData(
+		    const BE::Memory::ByteView &rawData,
+		    const BE::Image::Properties &properties)
+		    const
+		{
+			if ((properties.colorDepth != 8) ||
+			    (properties.bitDepth != 8))
+				throw BE::Error::ParameterError("WSQ cannot "
+				    "hold " + std::to_string(
+				    properties.colorDepth) + "-bit pixels");
+
+			/* NBIS uses -1 for unknown resolution */
+			const double ppi = getResolution(properties.resolution,
+			    BE::Image::Resolution::Units::PPI);
+			const int wsqPPI = (ppi > 0 ?
+			    static_cast<int>(std::lround(ppi)) : -1);
+
+			/* NBIS coder state is per thread */
+			unsigned char *odata = nullptr;
+			int olen = 0;
+			const int rv = wsq_encode_mem(&odata, &olen,
+			    this->getSettings().bitRate,
+			    const_cast<unsigned char*>(rawData.data()),
+			    properties.dimensions.xSize,
+			    properties.dimensions.ySize, 8, wsqPPI, nullptr);
+			if (rv != 0)
+				throw BE::Error::StrategyError("wsq_encode_mem "
+				    "returned " + std::to_string(rv));
+
+			BE::Memory::uint8Array encoded(olen);
+			std::memcpy(encoded, odata, olen);
+			std::free(odata);
+			return (encoded);
+		}
+
+		BE::Image::PixelFormat
+		getPixelFormat(
+		    const BE::Image::Properties &properties)
+		    const
+		{
+			if ((properties.colorDepth == 8) &&
+			    (properties.bitDepth == 8))
+				return (BE::Image::PixelFormat::Native);
+			return (BE::Image::PixelFormat::Gray8);
+		}
+	};
+
+	/**
+	 * @brief
+	 * State shared by the threads of Encoder::parallelFor().
+	 */
+	struct ParallelFor
+	{
+		/** Numbers to pass to fn */
+		uint64_t count;
+		/** Function to call */
+		const std::function<void(uint64_t)> *fn;
+		/** Next number to pass to fn */
+		std::atomic<uint64_t> next;
+		/** Set when fn throws, to stop taking numbers */
+		std::atomic<bool> failed;
+		/** Whether more than one thread calls fn */
+		bool parallel;
+		/** Guards error */
+		pthread_mutex_t mutex;
+		/** First exception thrown by fn */
+		std::exception_ptr error;
+	};
+
+	void*
+	parallelForWorker(
+	    void *arg)
+	{
+		ParallelFor *state = static_cast<ParallelFor*>(arg);
+		const bool wasInParallelFor = inParallelFor;
+		inParallelFor = wasInParallelFor || state->parallel;
+		while (!state->failed) {
+			const uint64_t i = state->next++;
+			if (i >= state->count)
+				break;
+			try {
+				(*state->fn)(i);
+			} catch (...) {
+				pthread_mutex_lock(&state->mutex);
+				if (!state->failed)
+					state->error = std::current_exception();
+				state->failed = true;
+				pthread_mutex_unlock(&state->mutex);
+			}
+		}
+		inParallelFor = wasInParallelFor;
+		return (nullptr);
+	}
+}
+
+BiometricEvaluation::Image::Encoder::Encoder(
+    CompressionAlgorithm compressionAlgorithm,
+    const Settings &settings) :
+    _compressionAlgorithm(compressionAlgorithm),
+    _settings(settings)
+{
+
+}
+
+std::shared_ptr<BiometricEvaluation::Image::Encoder>
+BiometricEvaluation::Image::Encoder::openEncoder(
+    CompressionAlgorithm compressionAlgorithm,
+    const Settings &settings)
+{
+	switch (compressionAlgorithm) {
+	case CompressionAlgorithm::PNG:
+		return (std::make_shared<PNGEncoder>(settings));
+	case CompressionAlgorithm::JPEGB:
+		return (std::make_shared<JPEGEncoder>(settings));
+	case CompressionAlgorithm::JP2:
+		/* FALLTHROUGH */
+	case CompressionAlgorithm::JP2L:
+		return (std::make_shared<JPEG2000Encoder>(
+		    compressionAlgorithm, settings));
+	case CompressionAlgorithm::WSQ20:
+		return (std::make_shared<WSQEncoder>(settings));
+	default:
+		throw Error::NotImplemented("Encoding " +
+		    ::to_string(compressionAlgorithm));
+	}
+}
+
+std::shared_ptr<BiometricEvaluation::Image::Encoder>
+BiometricEvaluation::Image::Encoder::openEncoder(
+    CompressionAlgorithm compressionAlgorithm)
+{
+	return (openEncoder(compressionAlgorithm, Settings()));
+}
+
+BiometricEvaluation::Image::CompressionAlgorithm
+BiometricEvaluation::Image::Encoder::getCompressionAlgorithm()
+    const
+{
+	return (_compressionAlgorithm);
+}
+
+BiometricEvaluation::Image::Encoder::Settings
+BiometricEvaluation::Image::Encoder::getSettings()
+    const
+{
+	return (_settings);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Encoder::encode(
+    const Memory::ByteView &rawData,
+    const Properties &properties)
+    const
+{
+	if ((properties.dimensions.xSize == 0) ||
+	    (properties.dimensions.ySize == 0) ||
+	    (properties.colorDepth == 0) || (properties.bitDepth == 0))
+		throw Error::ParameterError("Invalid properties");
+	const uint64_t size = getRowSize(properties) *
+	    properties.dimensions.ySize;
+	if (rawData.size() < size)
+		throw Error::ParameterError("Raw data (" +
+		    std::to_string(rawData.size()) + " bytes) is smaller "
+		    "than properties require (" + std::to_string(size) +
+		    " bytes)");
+
+	return (this->encodeRawData(rawData, properties));
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Encoder::encode(
+    const Image &image)
+    const
+{
+	Properties properties;
+	properties.compressionAlgorithm = image.getCompressionAlgorithm();
+	properties.dimensions = image.getDimensions();
+	properties.colorDepth = image.getColorDepth();
+	properties.bitDepth = image.getBitDepth();
+	properties.resolution = image.getResolution();
+	properties.hasAlphaChannel = image.hasAlphaChannel();
+
+	const PixelFormat format = this->getPixelFormat(properties);
+	if (format == PixelFormat::Native) {
+		/* Raw data may widen samples, as 1-bit images to 8 bits */
+		const uint32_t pixelBits = image.getRawPixelBits();
+		if ((pixelBits != properties.colorDepth) &&
+		    (properties.bitDepth != 0) &&
+		    (properties.colorDepth >= properties.bitDepth)) {
+			properties.bitDepth = static_cast<uint16_t>(pixelBits /
+			    (properties.colorDepth / properties.bitDepth));
+			properties.colorDepth = pixelBits;
+		}
+
+		const Memory::uint8Array rawData = image.getRawData();
+		return (this->encode(Memory::ByteView(rawData, rawData.size()),
+		    properties));
+	}
+
+	const uint64_t rowSize = image.getRowSize(format);
+	Memory::uint8Array pixels(rowSize * properties.dimensions.ySize);
+	image.decodeInto(pixels, rowSize, format);
+	switch (format) {
+	case PixelFormat::Gray8:
+		properties.colorDepth = properties.bitDepth = 8;
+		break;
+	case PixelFormat::Gray16:
+		properties.colorDepth = properties.bitDepth = 16;
+		break;
+	case PixelFormat::RGB24:
+		properties.colorDepth = 24;
+		properties.bitDepth = 8;
+		break;
+	default:
+		properties.colorDepth = properties.bitDepth = 1;
+		break;
+	}
+	properties.hasAlphaChannel = false;
+
+	return (this->encode(Memory::ByteView(pixels, pixels.size()),
+	    properties));
+}
+
+void
+BiometricEvaluation::Image::Encoder::encode(
+    const Image &image,
+    IO::RecordStore &recordStore,
+    const std::string &key)
+    const
+{
+	const Memory::uint8Array encoded = this->encode(image);
+	recordStore.insert(key, encoded);
+}
+
+std::vector<BiometricEvaluation::Memory::uint8Array>
+BiometricEvaluation::Image::Encoder::encode(
+    const std::vector<std::shared_ptr<Image>> &images,
+    uint32_t threads)
+    const
+{
+	std::vector<Memory::uint8Array> encoded(images.size());
+	parallelFor(images.size(), threads, [&](uint64_t i) {
+		if (images[i] == nullptr)
+			throw Error::ParameterError("Image " +
+			    std::to_string(i) + " is nullptr");
+		encoded[i] = this->encode(*images[i]);
+	});
+
+	return (encoded);
+}
+
+void
+BiometricEvaluation::Image::Encoder::encode(
+    const std::vector<std::shared_ptr<Image>> &images,
+    const std::vector<std::string> &keys,
+    IO::RecordStore &recordStore,
+    uint32_t threads)
+    const
+{
+	if (images.size() != keys.size())
+		throw Error::ParameterError("Number of images (" +
+		    std::to_string(images.size()) + ") and keys (" +
+		    std::to_string(keys.size()) + ") differ");
+
+	pthread_mutex_t insertMutex = PTHREAD_MUTEX_INITIALIZER;
+	parallelFor(images.size(), threads, [&](uint64_t i) {
+		if (images[i] == nullptr)
+			throw Error::ParameterError("Image " +
+			    std::to_string(i) + " is nullptr");
+		const Memory::uint8Array encoded = this->encode(*images[i]);
+
+		pthread_mutex_lock(&insertMutex);
+		try {
+			recordStore.insert(keys[i], encoded);
+		} catch (...) {
+			pthread_mutex_unlock(&insertMutex);
+			throw;
+		}
+		pthread_mutex_unlock(&insertMutex);
+	});
+	pthread_mutex_destroy(&insertMutex);
+}
+
+BiometricEvaluation::Image::PixelFormat
+BiometricEvaluation::Image::Encoder::getPixelFormat(
+    const Properties &properties)
+    const
+{
+	return (PixelFormat::Native);
+}
+
+void
+BiometricEvaluation::Image::Encoder::parallelFor(
+    uint64_t count,
+    uint32_t threads,
+    const std::function<void(uint64_t)> &fn)
+{
+	if (threads == 0)
+		threads = std::max<uint32_t>(System::getCPUCount(), 1);
+	threads = static_cast<uint32_t>(std::min<uint64_t>(threads, count));
+
+	ParallelFor state;
+	state.count = count;
+	state.fn = &fn;
+	state.next = 0;
+	state.failed = false;
+	state.parallel = (threads > 1);
+	pthread_mutex_init(&state.mutex, nullptr);
+
+	/* The calling thread is one of the workers */
+	std::vector<pthread_t> workers;
+	for (uint32_t i = 1; i < threads; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, nullptr, parallelForWorker,
+		    &state) != 0)
+			break;
+		workers.push_back(thread);
+	}
+	parallelForWorker(&state);
+	for (const auto &thread : workers)
+		pthread_join(thread, nullptr);
+	pthread_mutex_destroy(&state.mutex);
+
+	if (state.error != nullptr)
+		std::rethrow_exception(state.error);
+}
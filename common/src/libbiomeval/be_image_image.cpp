@@ -8,10 +8,14 @@
  * about its quality, reliability, or any other characteristic.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <stdexcept>
 #include <memory>
 
+#include <be_image_conversion.h>
 #include <be_image_image.h>
 #include <be_image_bmp.h>
 #include <be_image_jpeg.h>
@@ -20,16 +24,57 @@
 #include <be_image_netpbm.h>
 #include <be_image_raw.h>
 #include <be_image_png.h>
+#include <be_image_tiledraw.h>
 #include <be_image_wsq.h>
 #include <be_io_utility.h>
+#include <be_memory_accounting.h>
 #include <be_memory_autoarrayiterator.h>
-#include <be_memory_mutableindexedbuffer.h>
 
 namespace BE = BiometricEvaluation;
 
+/** Decode cache limit given to new Images */
+static std::atomic<uint64_t> defaultDecodeCacheLimit(0);
+
+BiometricEvaluation::Image::Image::Image(
+    const uint8_t *data,
+    const uint64_t size,
+    const Size dimensions,
+    const uint32_t colorDepth,
+    const uint16_t bitDepth,
+    const Resolution resolution,
+    const CompressionAlgorithm compressionAlgorithm,
+    const bool hasAlphaChannel) :
+    BiometricEvaluation::Image::Image::Image(
+    Memory::ByteView(data, size),
+    dimensions,
+    colorDepth,
+    bitDepth,
+    resolution,
+    compressionAlgorithm,
+    hasAlphaChannel)
+{
+	this->copyData();
+}
+
 BiometricEvaluation::Image::Image::Image(
     const uint8_t *data,
     const uint64_t size,
+    const CompressionAlgorithm compressionAlgorithm) :
+    BiometricEvaluation::Image::Image::Image(
+    data,
+    size,
+    Size(),
+    0,
+    0,
+    Resolution(),
+    compressionAlgorithm,
+    false)
+{
+
+}
+
+BiometricEvaluation::Image::Image::Image(
+    const Memory::ByteView &data,
     const Size dimensions,
     const uint32_t colorDepth,
     const uint16_t bitDepth,
@@ -41,19 +86,18 @@ BiometricEvaluation::Image::Image::Image(
     _hasAlphaChannel(hasAlphaChannel),
     _bitDepth(bitDepth),
     _resolution(resolution),
-    _data(size),
+    _view(data),
     _compressionAlgorithm(compressionAlgorithm)
 {
-	std::memcpy(_data, data, size);
+	this->_decodeCache.setLimit(defaultDecodeCacheLimit.load(
+	    std::memory_order_relaxed));
 }
 
 BiometricEvaluation::Image::Image::Image(
-    const uint8_t *data,
-    const uint64_t size,
+    const Memory::ByteView &data,
     const CompressionAlgorithm compressionAlgorithm) :
     BiometricEvaluation::Image::Image::Image(
     data,
-    size,
     Size(),
     0,
     0,
@@ -99,21 +143,112 @@ BiometricEvaluation::Image::Image::getBitDepth()
 	return (this->_bitDepth);
 }
 
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Image::getRawData()
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	return (this->getCachedDecode(to_int_type(DecodedVariant::Raw),
+	    [&]() { return (this->decodeRawData()); }));
+}
+
 BiometricEvaluation::Memory::uint8Array
 BiometricEvaluation::Image::Image::getRawData(
     const bool removeAlphaChannelIfPresent)
     const
 {
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
 	if (!removeAlphaChannelIfPresent || !this->hasAlphaChannel())
 		return (this->getRawData());
 
-	/* Set the last channel to be removed */
-	std::vector<bool> components(this->getColorDepth() /
-	    this->getBitDepth(), false);
-	*(std::prev(components.end(), 1)) = true;
+	return (this->getCachedDecode(
+	    to_int_type(DecodedVariant::RawWithoutAlpha), [&]() {
+		/* Set the last channel to be removed */
+		std::vector<bool> components(this->getColorDepth() /
+		    this->getBitDepth(), false);
+		*(std::prev(components.end(), 1)) = true;
+
+		return (BiometricEvaluation::Image::removeComponents(
+		    this->getRawData(), this->getBitDepth(), components));
+	}));
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Image::getRawData(
+    const Coordinate &origin,
+    const Size &size)
+    const
+{
+	const Size dimensions = this->getDimensions();
+	if ((size.xSize == 0) || (size.ySize == 0) ||
+	    ((static_cast<uint64_t>(origin.x) + size.xSize) >
+	    dimensions.xSize) ||
+	    ((static_cast<uint64_t>(origin.y) + size.ySize) >
+	    dimensions.ySize))
+		throw Error::ParameterError("Region " + to_string(size) +
+		    " at " + to_string(origin) + " is not within " +
+		    to_string(dimensions));
+	if ((origin.x == 0) && (origin.y == 0) && (size == dimensions))
+		return (this->getRawData());
+
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	const auto cached = this->_decodeCache.find(
+	    to_int_type(DecodedVariant::Raw));
+	if (cached)
+		return (this->cropRows(*cached, origin, size));
+	return (this->decodeRawRegion(origin, size));
+}
+
+bool
+BiometricEvaluation::Image::Image::decodesRegions()
+    const
+{
+	return (false);
+}
+
+BiometricEvaluation::Image::Size
+BiometricEvaluation::Image::Image::getReducedDimensions(
+    uint8_t scaleDenominator)
+    const
+{
+	switch (scaleDenominator) {
+	case 1:
+		/* FALLTHROUGH */
+	case 2:
+		/* FALLTHROUGH */
+	case 4:
+		/* FALLTHROUGH */
+	case 8:
+		break;
+	default:
+		throw Error::ParameterError("Invalid scale denominator (" +
+		    std::to_string(scaleDenominator) + ")");
+	}
+
+	const Size dimensions = this->getDimensions();
+	return (Size((dimensions.xSize + scaleDenominator - 1) /
+	    scaleDenominator, (dimensions.ySize + scaleDenominator - 1) /
+	    scaleDenominator));
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Image::getReducedRawData(
+    uint8_t scaleDenominator)
+    const
+{
+	/* Validates scaleDenominator */
+	this->getReducedDimensions(scaleDenominator);
+	if (scaleDenominator == 1)
+		return (this->getRawData());
 
-	return (BiometricEvaluation::Image::removeComponents(this->getRawData(),
-	    this->getBitDepth(), components));
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	return (this->getCachedDecode(
+	    to_int_type(DecodedVariant::Reduced) + scaleDenominator,
+	    [&]() { return (this->decodeReducedRawData(scaleDenominator)); }));
 }
 
 BiometricEvaluation::Memory::uint8Array
@@ -121,6 +256,8 @@ BiometricEvaluation::Image::Image::getRawGrayscaleData(
     uint8_t depth)
     const
 {
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
 	if (depth != 16 && depth != 8 && depth != 1)
 		throw Error::ParameterError("Invalid value for bit depth");
 		
@@ -128,135 +265,468 @@ BiometricEvaluation::Image::Image::getRawGrayscaleData(
 	if (this->getColorDepth() == depth)
 		return (this->getRawData());
 
-	const uint8_t bpcIn = static_cast<uint8_t>(
-	    std::ceil(this->getColorDepth() / 8.0));
+	return (this->getCachedDecode(
+	    to_int_type(DecodedVariant::Grayscale) + depth,
+	    [&]() { return (this->decodeRawGrayscaleData(depth)); }));
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Image::decodeRawGrayscaleData(
+    uint8_t depth)
+    const
+{
+	const uint32_t colorDepth = this->getColorDepth();
+	/* Bitmap images are upped to 8-bit in getRawData() */
+	const uint8_t bpcIn = (colorDepth == 1 ? 1 :
+	    static_cast<uint8_t>(std::ceil(colorDepth / 8.0)));
 	const Memory::uint8Array rawColor{this->getRawData()};
-	Memory::IndexedBuffer inBuffer{rawColor};
 
+	const uint64_t pixels = static_cast<uint64_t>(
+	    this->getDimensions().xSize) * this->getDimensions().ySize;
+	if (rawColor.size() < pixels * bpcIn)
+		throw Error::DataError("Raw data is too small for the image "
+		    "dimensions");
+
+	/* 1-bit conversions are quantized after converting to 8-bit */
 	const uint8_t bpcOut = static_cast<uint8_t>(std::ceil(depth / 8.0));
-	Memory::uint8Array rawGray(
-	    bpcOut * this->getDimensions().xSize * this->getDimensions().ySize);
-	Memory::MutableIndexedBuffer outBuffer(rawGray);
+	Memory::uint8Array rawGray(bpcOut * pixels);
+
+	switch (colorDepth) {
+	case 1:
+		/* FALLTHROUGH */
+	case 8: /* 8-bit single-channel (grayscale) */
+		if (depth == 16)
+			Conversion::rescale8To16(rawColor, rawGray, pixels);
+		else
+			std::copy(rawColor.cbegin(), rawColor.cbegin() + pixels,
+			    rawGray.begin());
+		break;
+	case 16: /* 16-bit single-channel (grayscale) */
+		Conversion::rescale16To8(rawColor, rawGray, pixels);
+		break;
+	case 24: /* 8-bit RGB */
+		/* FALLTHROUGH */
+	case 32: /* 8-bit RGBA (ignoring alpha channel) */
+		if (depth == 16)
+			Conversion::colorToGray16(rawColor, rawGray, pixels,
+			    colorDepth / 8);
+		else
+			Conversion::colorToGray8(rawColor, rawGray, pixels,
+			    colorDepth / 8);
+		break;
+	case 48: /* 16-bit RGB */
+		/* FALLTHROUGH */
+	case 64: /* 16-bit RGBA (ignoring alpha channel) */
+		if (depth == 16)
+			Conversion::color16ToGray16(rawColor, rawGray, pixels,
+			    colorDepth / 16);
+		else
+			Conversion::color16ToGray8(rawColor, rawGray, pixels,
+			    colorDepth / 16);
+		break;
+	default:
+		throw BE::Error::NotImplemented("Grayscale conversion "
+		    "for " + std::to_string(colorDepth) + "-bit "
+		    "depth imagery");
+	}
 
-	/* Constants from ITU-R BT.601 */
-	static const float redFactor = 0.299;
-	static const float greenFactor = 0.587;
-	static const float blueFactor = 0.114;
+	/* Quantize down to black and white */
+	if (depth == 1)
+		Conversion::threshold(rawGray, rawGray.size());
 
-	uint16_t rValue, bValue, gValue;
+	return (rawGray);
+}
 
-	/* 
-	 * Convert to 16-bit or 8-bit. 1-bit conversions will be quantized
-	 * after converting to 8-bit.
-	 */
-	for (uint32_t i = 0; i < rawColor.size(); i += bpcIn) {
-		switch (this->getColorDepth()) {
-		case 1:
-			/* Bitmap images are upped to 8-bit in getRawData() */
-			/* FALLTHROUGH */
-		case 8: /* 8-bit single-channel (grayscale) */
-			if (depth == 8) {
-				outBuffer.pushU8Val(inBuffer.scanU8Val());
-			} else if (depth == 16) {
-				/* Get 16-bit colorspace interpolated value */
-				outBuffer.pushU16Val(valueInColorspace(
-				    inBuffer.scanU8Val(), UINT8_MAX, 16));
-			}
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Image::getCachedDecode(
+    uint16_t variant,
+    const std::function<Memory::uint8Array()> &decode)
+    const
+{
+	if (this->_decodeCache.getLimit() == 0)
+		return (decode());
 
-			break;
-		case 16: /* 16-bit single-channel (grayscale) */
-			if (depth == 8) {
-				/* Interpolate value in 8-bit colorspace */
-				outBuffer.pushU8Val(valueInColorspace(
-				    inBuffer.scanU16Val(), UINT16_MAX, 8));
-			}
+	const auto cached = this->_decodeCache.find(variant);
+	if (cached)
+		return (*cached);
 
-			break;
-		case 32: /* 8-bit RGBA */
-			/* FALLTHROUGH (ignoring alpha channel) */
-		case 24: /* 8-bit RGB */
-			if (depth == 16) {
-				/* Get 16-bit colorspace interpolated value */
-				rValue = static_cast<uint16_t>(
-				    valueInColorspace(inBuffer.scanU8Val(),
-				    UINT8_MAX, 16));
-				gValue = static_cast<uint16_t>(
-				    valueInColorspace(inBuffer.scanU8Val(),
-				    UINT8_MAX, 16));
-				bValue = static_cast<uint16_t>(
-				    valueInColorspace(inBuffer.scanU8Val(),
-				    UINT8_MAX, 16));
-
-				/* Pull Y' component from Y'CbCr */
-				outBuffer.pushU16Val((rValue * redFactor) +
-				    (gValue * greenFactor) +
-				    (bValue * blueFactor));
-			} else {
-				/* Pull Y' component from Y'CbCr */
-				outBuffer.pushU8Val(static_cast<uint8_t>(
-				    (inBuffer.scanU8Val() * redFactor) +
-				    (inBuffer.scanU8Val() * greenFactor) +
-				    (inBuffer.scanU8Val() * blueFactor)));
-			}
+	/* Concurrent misses may both decode; the results are identical */
+	Memory::uint8Array decoded = decode();
+	this->_decodeCache.insert(variant, decoded);
+	return (decoded);
+}
 
-			/* Increment over the alpha channel */
-			if (this->getColorDepth() == 32)
-				inBuffer.scanU8Val();
+uint64_t
+BiometricEvaluation::Image::Image::getRowSize(
+    PixelFormat format)
+    const
+{
+	const uint64_t xSize = this->getDimensions().xSize;
 
-			break;
-		case 64: /* 16-bit RGBA */
-			/* FALLTHROUGH (ignoring alpha channel) */
-		case 48: /* 16-bit RGB */
-			/* Extract 16-bit values */
-			rValue = inBuffer.scanU16Val();
-			gValue = inBuffer.scanU16Val();
-			bValue = inBuffer.scanU16Val();
-
-			if (depth == 16) {
-				/* Y' component from Y'CbCr */
-				outBuffer.pushU16Val((rValue * redFactor) +
-				    (gValue * greenFactor) +
-				    (bValue * blueFactor));
-			} else {
-				/* Interpolate colors in 8-bit colorspace */
-				rValue = static_cast<uint8_t>(
-				    valueInColorspace(rValue, UINT16_MAX, 8));
-				gValue = static_cast<uint8_t>(
-				    valueInColorspace(gValue, UINT16_MAX, 8));
-				bValue = static_cast<uint8_t>(
-				    valueInColorspace(bValue, UINT16_MAX, 8));
-
-				/* Pull Y' component from Y'CbCr */
-				outBuffer.pushU8Val((rValue * redFactor) +
-				    (gValue * greenFactor) +
-				    (bValue * blueFactor));
+	switch (format) {
+	case PixelFormat::Native:
+		return (this->getRawRowSize());
+	case PixelFormat::Gray8:
+		return (xSize);
+	case PixelFormat::Gray16:
+		return (xSize * 2);
+	case PixelFormat::RGB24:
+		if ((this->getBitDepth() == 8) &&
+		    ((this->getColorDepth() == 24) ||
+		    ((this->getColorDepth() == 32) && this->hasAlphaChannel())))
+			return (xSize * 3);
+		throw Error::NotImplemented("RGB24 from " + std::to_string(
+		    this->getColorDepth()) + "-bit depth imagery");
+	case PixelFormat::MonoWhite:
+		/* FALLTHROUGH */
+	case PixelFormat::MonoBlack:
+		return ((xSize + 7) / 8);
+	}
+
+	throw Error::NotImplemented("Pixel format " + ::to_string(format));
+}
+
+void
+BiometricEvaluation::Image::Image::decodeInto(
+    uint8_t *dst,
+    uint64_t stride,
+    PixelFormat format)
+    const
+{
+	if (dst == nullptr)
+		throw Error::ParameterError("dst is nullptr");
+	const uint64_t rowSize = this->getRowSize(format);
+	if (stride < rowSize)
+		throw Error::ParameterError("Stride (" + std::to_string(stride) +
+		    ") is less than row size (" + std::to_string(rowSize) + ")");
+
+	/* Formats that are the same as the native pixels */
+	const uint32_t colorDepth = this->getColorDepth();
+	if (((format == PixelFormat::Gray8) && (colorDepth == 8)) ||
+	    ((format == PixelFormat::Gray16) && (colorDepth == 16)) ||
+	    ((format == PixelFormat::RGB24) && (colorDepth == 24)))
+		format = PixelFormat::Native;
+
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	switch (format) {
+	case PixelFormat::Native: {
+		const auto cached = this->_decodeCache.find(
+		    to_int_type(DecodedVariant::Raw));
+		if (cached)
+			this->copyRows(*cached, rowSize, dst, stride);
+		else
+			this->decodeRawInto(dst, stride);
+		break;
+	}
+	case PixelFormat::Gray8:
+		this->copyRows(this->getRawGrayscaleData(8), rowSize, dst,
+		    stride);
+		break;
+	case PixelFormat::Gray16:
+		this->copyRows(this->getRawGrayscaleData(16), rowSize, dst,
+		    stride);
+		break;
+	case PixelFormat::RGB24:
+		this->copyRows(this->getRawData(true), rowSize, dst, stride);
+		break;
+	case PixelFormat::MonoWhite:
+		/* FALLTHROUGH */
+	case PixelFormat::MonoBlack: {
+		const Memory::uint8Array bw{this->getRawGrayscaleData(1)};
+		const uint64_t xSize = this->getDimensions().xSize;
+		const uint32_t ySize = this->getDimensions().ySize;
+		if (bw.size() < xSize * ySize)
+			throw Error::StrategyError("Decoded data is smaller "
+			    "than the image");
+
+		/* MonoBlack sets bits for white pixels, MonoWhite black */
+		const uint8_t set = (format == PixelFormat::MonoBlack ?
+		    0xFF : 0x00);
+		for (uint32_t row = 0; row < ySize; row++) {
+			const uint8_t *in = bw + (row * xSize);
+			uint8_t *out = dst + (row * stride);
+			std::fill(out, out + rowSize, 0);
+			for (uint64_t col = 0; col < xSize; col++)
+				if (in[col] == set)
+					out[col / 8] |= (0x80 >> (col % 8));
+		}
+		break;
+	}
+	}
+}
+
+void
+BiometricEvaluation::Image::Image::decodeRawInto(
+    uint8_t *dst,
+    uint64_t stride)
+    const
+{
+	this->copyRows(this->decodeRawData(), this->getRawRowSize(), dst,
+	    stride);
+}
+
+uint32_t
+BiometricEvaluation::Image::Image::getRawPixelBits()
+    const
+{
+	const uint32_t colorDepth = this->getColorDepth();
+	const uint16_t bitDepth = this->getBitDepth();
+	if ((bitDepth == 0) || (colorDepth < bitDepth))
+		return (((colorDepth + 7) / 8) * 8);
+
+	return ((colorDepth / bitDepth) * (bitDepth <= 8 ? 8 : 16));
+}
+
+uint64_t
+BiometricEvaluation::Image::Image::getRawRowSize()
+    const
+{
+	return (((static_cast<uint64_t>(this->getDimensions().xSize) *
+	    this->getRawPixelBits()) + 7) / 8);
+}
+
+void
+BiometricEvaluation::Image::Image::copyRows(
+    const Memory::ByteView &src,
+    uint64_t rowSize,
+    uint8_t *dst,
+    uint64_t stride)
+    const
+{
+	const uint32_t ySize = this->getDimensions().ySize;
+	if (src.size() < rowSize * ySize)
+		throw Error::StrategyError("Decoded data is smaller than the "
+		    "image");
+
+	if (stride == rowSize) {
+		std::memcpy(dst, src.data(), rowSize * ySize);
+		return;
+	}
+	for (uint32_t row = 0; row < ySize; row++)
+		std::memcpy(dst + (row * stride), src.data() + (row * rowSize),
+		    rowSize);
+}
+
+void
+BiometricEvaluation::Image::Image::copyPixels(
+    const uint8_t *src,
+    uint32_t x,
+    uint32_t count,
+    uint8_t *dst)
+    const
+{
+	const uint64_t bits = this->getRawPixelBits();
+	const uint64_t first = x * bits;
+	const uint64_t length = count * bits;
+	const uint64_t size = (length + 7) / 8;
+
+	if ((first % 8) == 0) {
+		std::memcpy(dst, src + (first / 8), size);
+		/* Clear the bits of pixels past count */
+		if ((length % 8) != 0)
+			dst[size - 1] &= (0xFF << (8 - (length % 8)));
+		return;
+	}
+
+	/* Packed pixels that do not start on a byte, MSB first */
+	std::fill(dst, dst + size, 0);
+	for (uint64_t i = 0; i < length; i++)
+		if (src[(first + i) / 8] & (0x80 >> ((first + i) % 8)))
+			dst[i / 8] |= (0x80 >> (i % 8));
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Image::cropRows(
+    const Memory::ByteView &src,
+    const Coordinate &origin,
+    const Size &size)
+    const
+{
+	const uint64_t srcRowSize = this->getRawRowSize();
+	if (src.size() < srcRowSize * this->getDimensions().ySize)
+		throw Error::StrategyError("Decoded data is smaller than the "
+		    "image");
+
+	const uint64_t rowSize = ((static_cast<uint64_t>(size.xSize) *
+	    this->getRawPixelBits()) + 7) / 8;
+	Memory::uint8Array region(rowSize * size.ySize);
+	for (uint32_t row = 0; row < size.ySize; row++)
+		this->copyPixels(src.data() + ((origin.y + row) * srcRowSize),
+		    origin.x, size.xSize, region + (row * rowSize));
+
+	return (region);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Image::decodeRawRegion(
+    const Coordinate &origin,
+    const Size &size)
+    const
+{
+	return (this->cropRows(this->getRawData(), origin, size));
+}
+
+/*
+ * Average blocks of scale x scale pixels of components samples of type T,
+ * rounding to the nearest value. Blocks at the right and bottom edges may
+ * be smaller.
+ */
+template<typename T>
+static void
+averageBlocks(
+    const uint8_t *src,
+    uint64_t srcRowSize,
+    const BE::Image::Size &srcSize,
+    uint8_t *dst,
+    uint64_t dstRowSize,
+    const BE::Image::Size &dstSize,
+    uint8_t components,
+    uint8_t scale)
+{
+	std::vector<uint64_t> sums(static_cast<uint64_t>(dstSize.xSize) *
+	    components);
+	for (uint32_t y = 0; y < dstSize.ySize; y++) {
+		std::fill(sums.begin(), sums.end(), 0);
+		const uint32_t firstRow = y * scale;
+		const uint32_t rows = std::min<uint32_t>(scale,
+		    srcSize.ySize - firstRow);
+		for (uint32_t row = firstRow; row < firstRow + rows; row++) {
+			const uint8_t *in = src + (row * srcRowSize);
+			for (uint32_t x = 0; x < srcSize.xSize; x++) {
+				const uint64_t out = (x / scale) * components;
+				for (uint8_t c = 0; c < components; c++) {
+					T sample;
+					std::memcpy(&sample, in, sizeof(T));
+					in += sizeof(T);
+					sums[out + c] += sample;
+				}
 			}
+		}
 
-			/* Increment over the alpha channel */
-			if (this->getColorDepth() == 64)
-				inBuffer.scanU16Val();
+		uint8_t *out = dst + (y * dstRowSize);
+		for (uint32_t x = 0; x < dstSize.xSize; x++) {
+			const uint64_t count = static_cast<uint64_t>(rows) *
+			    std::min<uint32_t>(scale, srcSize.xSize -
+			    (x * scale));
+			for (uint8_t c = 0; c < components; c++) {
+				const T sample = static_cast<T>(
+				    (sums[(x * components) + c] +
+				    (count / 2)) / count);
+				std::memcpy(out, &sample, sizeof(T));
+				out += sizeof(T);
+			}
+		}
+	}
+}
 
-			break;
-		default:
-			throw BE::Error::NotImplemented("Grayscale conversion "
-			    "for " + std::to_string(this->getColorDepth()) + "-bit "
-			    "depth imagery");
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Image::decodeReducedRawData(
+    uint8_t scaleDenominator)
+    const
+{
+	const Memory::uint8Array rawData = this->getRawData();
+	const Size dimensions = this->getDimensions();
+	const uint64_t srcRowSize = this->getRawRowSize();
+	if (rawData.size() < srcRowSize * dimensions.ySize)
+		throw Error::StrategyError("Decoded data is smaller than the "
+		    "image");
+
+	const Size reduced = this->getReducedDimensions(scaleDenominator);
+	const uint32_t pixelBits = this->getRawPixelBits();
+	const uint64_t rowSize = ((static_cast<uint64_t>(reduced.xSize) *
+	    pixelBits) + 7) / 8;
+	Memory::uint8Array reducedData(rowSize * reduced.ySize);
+
+	/* Packed pixels are not averaged */
+	if (pixelBits < 8) {
+		std::fill(reducedData.begin(), reducedData.end(), 0);
+		const uint8_t *row = rawData;
+		for (uint32_t y = 0; y < reduced.ySize; y++) {
+			uint8_t *out = reducedData + (y * rowSize);
+			for (uint32_t x = 0; x < reduced.xSize; x++) {
+				const uint64_t srcBit = static_cast<uint64_t>(
+				    x) * scaleDenominator * pixelBits;
+				const uint64_t dstBit = static_cast<uint64_t>(
+				    x) * pixelBits;
+				for (uint32_t b = 0; b < pixelBits; b++)
+					if (row[(srcBit + b) / 8] & (0x80 >>
+					    ((srcBit + b) % 8)))
+						out[(dstBit + b) / 8] |= (0x80 >>
+						    ((dstBit + b) % 8));
+			}
+			row += srcRowSize * scaleDenominator;
 		}
+		return (reducedData);
 	}
 
-	/* Quantize down to black and white */
-	if (depth == 1)
-		std::transform(rawGray.begin(), rawGray.end(), rawGray.begin(),
-		    [](const uint8_t &i) { return (i <= 127 ? 0x00 : 0xFF); });
+	const uint16_t bitDepth = this->getBitDepth();
+	if ((bitDepth > 8) && (bitDepth <= 16) && ((pixelBits % 16) == 0))
+		averageBlocks<uint16_t>(rawData, srcRowSize, dimensions,
+		    reducedData, rowSize, reduced, pixelBits / 16,
+		    scaleDenominator);
+	else
+		averageBlocks<uint8_t>(rawData, srcRowSize, dimensions,
+		    reducedData, rowSize, reduced, pixelBits / 8,
+		    scaleDenominator);
 
-	return (rawGray);
+	return (reducedData);
+}
+
+void
+BiometricEvaluation::Image::Image::setDecodeCacheLimit(
+    uint64_t limit)
+{
+	this->_decodeCache.setLimit(limit);
+}
+
+uint64_t
+BiometricEvaluation::Image::Image::getDecodeCacheLimit()
+    const
+{
+	return (this->_decodeCache.getLimit());
+}
+
+uint64_t
+BiometricEvaluation::Image::Image::getDecodeCacheSize()
+    const
+{
+	return (this->_decodeCache.getSize());
+}
+
+void
+BiometricEvaluation::Image::Image::clearDecodeCache()
+    const
+{
+	this->_decodeCache.clear();
+}
+
+void
+BiometricEvaluation::Image::Image::setDefaultDecodeCacheLimit(
+    uint64_t limit)
+{
+	defaultDecodeCacheLimit.store(limit, std::memory_order_relaxed);
+}
+
+uint64_t
+BiometricEvaluation::Image::Image::getDefaultDecodeCacheLimit()
+{
+	return (defaultDecodeCacheLimit.load(std::memory_order_relaxed));
 }
 
 BiometricEvaluation::Memory::uint8Array
 BiometricEvaluation::Image::Image::getData()
     const
 {
-	return (Memory::uint8Array(_data));
+	return (this->getDataView().to_array());
+}
+
+BiometricEvaluation::Memory::ByteView
+BiometricEvaluation::Image::Image::getDataView()
+    const
+{
+	return (Memory::ByteView(this->getDataPointer(),
+	    this->getDataSize()));
 }
 
 void
@@ -264,6 +734,7 @@ BiometricEvaluation::Image::Image::setResolution(
     const Resolution resolution)
 {
 	_resolution = resolution;
+	this->_decodeCache.clear();
 }
 
 void
@@ -271,6 +742,7 @@ BiometricEvaluation::Image::Image::setDimensions(
     const Size dimensions)
 {
 	_dimensions = dimensions;
+	this->_decodeCache.clear();
 }
 	
 void
@@ -278,6 +750,7 @@ BiometricEvaluation::Image::Image::setColorDepth(
     const uint32_t colorDepth)
 {
 	_colorDepth = colorDepth;
+	this->_decodeCache.clear();
 }
 
 void
@@ -285,12 +758,15 @@ BiometricEvaluation::Image::Image::setBitDepth(
     const uint16_t bitDepth)
 {
 	this->_bitDepth = bitDepth;
+	this->_decodeCache.clear();
 }
 
 const uint8_t *
 BiometricEvaluation::Image::Image::getDataPointer()
     const
 {
+	if (this->_view.data() != nullptr)
+		return (this->_view.data());
 	return (&(*(this->_data)));
 }
 
@@ -298,14 +774,166 @@ uint64_t
 BiometricEvaluation::Image::Image::getDataSize()
     const
 {
+	if (this->_view.data() != nullptr)
+		return (this->_view.size());
 	return (this->_data.size());
 }
 
+void
+BiometricEvaluation::Image::Image::copyData()
+{
+	if (this->_view.data() == nullptr)
+		return;
+	this->_data = this->_view.to_array();
+	this->_view = Memory::ByteView();
+}
+
 BiometricEvaluation::Image::Image::~Image()
 {
 
 }
 
+/*
+ * DecodeCache.
+ */
+
+BiometricEvaluation::Image::Image::DecodeCache::DecodeCache() :
+    _limit(0),
+    _size(0)
+{
+	if (pthread_rwlock_init(&this->_lock, nullptr) != 0)
+		throw Error::StrategyError("Could not create decode cache lock");
+}
+
+BiometricEvaluation::Image::Image::DecodeCache::DecodeCache(
+    const DecodeCache &other) :
+    DecodeCache()
+{
+	this->_limit = other.getLimit();
+}
+
+BiometricEvaluation::Image::Image::DecodeCache&
+BiometricEvaluation::Image::Image::DecodeCache::operator=(
+    const DecodeCache &other)
+{
+	if (this != &other) {
+		this->clear();
+		this->setLimit(other.getLimit());
+	}
+	return (*this);
+}
+
+BiometricEvaluation::Image::Image::DecodeCache::~DecodeCache()
+{
+	pthread_rwlock_destroy(&this->_lock);
+}
+
+std::shared_ptr<const BiometricEvaluation::Memory::uint8Array>
+BiometricEvaluation::Image::Image::DecodeCache::find(
+    uint16_t variant)
+    const
+{
+	std::shared_ptr<const Memory::uint8Array> data;
+
+	pthread_rwlock_rdlock(&this->_lock);
+	for (const auto &entry : this->_entries) {
+		if (entry.first == variant) {
+			data = entry.second;
+			break;
+		}
+	}
+	pthread_rwlock_unlock(&this->_lock);
+
+	return (data);
+}
+
+void
+BiometricEvaluation::Image::Image::DecodeCache::insert(
+    uint16_t variant,
+    const Memory::uint8Array &data)
+{
+	if (data.size() > this->getLimit())
+		return;
+
+	/* Copy outside the lock so readers are not held up */
+	std::shared_ptr<const Memory::uint8Array> entry;
+	try {
+		entry = std::make_shared<const Memory::uint8Array>(data);
+	} catch (const Error::MemoryError&) {
+		/* Caching is only an optimization */
+		return;
+	} catch (const std::bad_alloc&) {
+		return;
+	}
+
+	pthread_rwlock_wrlock(&this->_lock);
+	/* Another thread may have inserted, or the limit changed */
+	bool present = false;
+	for (const auto &existing : this->_entries)
+		if (existing.first == variant)
+			present = true;
+	if (!present && (data.size() <= this->_limit)) {
+		this->evict(this->_limit - data.size());
+		this->_entries.emplace_back(variant, entry);
+		this->_size += data.size();
+	}
+	pthread_rwlock_unlock(&this->_lock);
+}
+
+void
+BiometricEvaluation::Image::Image::DecodeCache::clear()
+{
+	std::vector<std::pair<uint16_t, std::shared_ptr<
+	    const Memory::uint8Array>>> released;
+
+	pthread_rwlock_wrlock(&this->_lock);
+	released.swap(this->_entries);
+	this->_size = 0;
+	pthread_rwlock_unlock(&this->_lock);
+}
+
+void
+BiometricEvaluation::Image::Image::DecodeCache::setLimit(
+    uint64_t limit)
+{
+	pthread_rwlock_wrlock(&this->_lock);
+	this->_limit = limit;
+	this->evict(limit);
+	pthread_rwlock_unlock(&this->_lock);
+}
+
+uint64_t
+BiometricEvaluation::Image::Image::DecodeCache::getLimit()
+    const
+{
+	pthread_rwlock_rdlock(&this->_lock);
+	const uint64_t limit = this->_limit;
+	pthread_rwlock_unlock(&this->_lock);
+	return (limit);
+}
+
+uint64_t
+BiometricEvaluation::Image::Image::DecodeCache::getSize()
+    const
+{
+	pthread_rwlock_rdlock(&this->_lock);
+	const uint64_t size = this->_size;
+	pthread_rwlock_unlock(&this->_lock);
+	return (size);
+}
+
+void
+BiometricEvaluation::Image::Image::DecodeCache::evict(
+    uint64_t size)
+{
+	/* Caller holds the write lock */
+	auto it = this->_entries.begin();
+	while ((this->_size > size) && (it != this->_entries.end())) {
+		this->_size -= it->second->size();
+		it = this->_entries.erase(it);
+	}
+}
+
 uint64_t
 BiometricEvaluation::Image::Image::valueInColorspace(
     uint64_t color,
@@ -320,7 +948,9 @@ BiometricEvaluation::Image::Image::valueInColorspace(
 	 *      maxColorValue   2^(depth) - 1
 	 */
 
-	return ((((uint64_t)pow(2.0, depth) - 1) * color) / maxColorValue);
+	const uint64_t maxDepthValue = (depth >= 64 ? UINT64_MAX :
+	    (UINT64_C(1) << depth) - 1);
+	return ((maxDepthValue * color) / maxColorValue);
 }
 
 std::shared_ptr<BiometricEvaluation::Image::Image>
@@ -345,6 +975,8 @@ BiometricEvaluation::Image::Image::openImage(
 		return (std::shared_ptr<Image>(new WSQ(data, size)));
 	case CompressionAlgorithm::BMP:
 		return (std::shared_ptr<Image>(new BMP(data, size)));
+	case CompressionAlgorithm::TiledRaw:
+		return (std::shared_ptr<Image>(new TiledRaw(data, size)));
 	default:
 		throw Error::StrategyError("Could not determine compression "
 		    "algorithm");
@@ -358,6 +990,35 @@ BiometricEvaluation::Image::Image::openImage(
 	return (Image::openImage(data, data.size()));
 }
 
+std::shared_ptr<BiometricEvaluation::Image::Image>
+BiometricEvaluation::Image::Image::openImage(
+    const Memory::ByteView &data)
+{
+	switch (Image::getCompressionAlgorithm(data)) {
+	case CompressionAlgorithm::JPEGB:
+		return (std::shared_ptr<Image>(new JPEG(data)));
+	case CompressionAlgorithm::JPEGL:
+		return (std::shared_ptr<Image>(new JPEGL(data)));
+	case CompressionAlgorithm::JP2:
+		/* FALLTHROUGH */
+	case CompressionAlgorithm::JP2L:
+		return (std::shared_ptr<Image>(new JPEG2000(data)));
+	case CompressionAlgorithm::PNG:
+		return (std::shared_ptr<Image>(new PNG(data)));
+	case CompressionAlgorithm::NetPBM:
+		return (std::shared_ptr<Image>(new NetPBM(data)));
+	case CompressionAlgorithm::WSQ20:
+		return (std::shared_ptr<Image>(new WSQ(data)));
+	case CompressionAlgorithm::BMP:
+		return (std::shared_ptr<Image>(new BMP(data)));
+	case CompressionAlgorithm::TiledRaw:
+		return (std::shared_ptr<Image>(new TiledRaw(data)));
+	default:
+		throw Error::StrategyError("Could not determine compression "
+		    "algorithm");
+	}
+}
+
 std::shared_ptr<BiometricEvaluation::Image::Image>
 BiometricEvaluation::Image::Image::openImage(
     const std::string &path)
@@ -371,22 +1032,48 @@ BiometricEvaluation::Image::Image::getCompressionAlgorithm(
     const uint8_t *data,
     const uint64_t size)
 {
-	if (NetPBM::isNetPBM(data, size))
-		return (CompressionAlgorithm::NetPBM);
-	else if (JPEG2000::isJPEG2000(data, size))
-		return (CompressionAlgorithm::JP2);
-	else if (JPEG::isJPEG(data, size))
-		return (CompressionAlgorithm::JPEGB);
-	else if (JPEGL::isJPEGL(data, size))
-		return (CompressionAlgorithm::JPEGL);
-	else if (PNG::isPNG(data, size))
-		return (CompressionAlgorithm::PNG);
-	else if (BMP::isBMP(data, size))
-		return (CompressionAlgorithm::BMP);
-	else if (WSQ::isWSQ(data, size))
-		return (CompressionAlgorithm::WSQ20);
+	if (size == 0)
+		return (CompressionAlgorithm::None);
+
+	/* Only the formats that can start with the first byte are checked */
+	switch (data[0]) {
+	case '#':	/* NetPBM comment */
+		/* FALLTHROUGH */
+	case 'P':	/* NetPBM or BMP pointer */
+		if (NetPBM::isNetPBM(data, size))
+			return (CompressionAlgorithm::NetPBM);
+		else if (BMP::isBMP(data, size))
+			return (CompressionAlgorithm::BMP);
+		break;
+	case 0x00:
+		if (JPEG2000::isJPEG2000(data, size))
+			return (CompressionAlgorithm::JP2);
+		break;
+	case 0xFF:
+		if ((size > 1) && (data[1] == 0xA0)) {
+			if (WSQ::isWSQ(data, size))
+				return (CompressionAlgorithm::WSQ20);
+		} else if (JPEG::isJPEG(data, size))
+			return (CompressionAlgorithm::JPEGB);
+		else if (JPEGL::isJPEGL(data, size))
+			return (CompressionAlgorithm::JPEGL);
+		break;
+	case 0x89:
+		if (PNG::isPNG(data, size))
+			return (CompressionAlgorithm::PNG);
+		break;
+	case 'B':	/* TiledRaw or BMP */
+		if (TiledRaw::isTiledRaw(data, size))
+			return (CompressionAlgorithm::TiledRaw);
+		/* FALLTHROUGH */
+	case 'C':
+		/* FALLTHROUGH */
+	case 'I':
+		if (BMP::isBMP(data, size))
+			return (CompressionAlgorithm::BMP);
+		break;
+	}
 
-		
 	return (CompressionAlgorithm::None);
 }
 
@@ -397,6 +1084,13 @@ BiometricEvaluation::Image::Image::getCompressionAlgorithm(
 	return (Image::getCompressionAlgorithm(data, data.size()));
 }
 
+BiometricEvaluation::Image::CompressionAlgorithm
+BiometricEvaluation::Image::Image::getCompressionAlgorithm(
+    const Memory::ByteView &data)
+{
+	return (Image::getCompressionAlgorithm(data.data(), data.size()));
+}
+
 BiometricEvaluation::Image::CompressionAlgorithm
 BiometricEvaluation::Image::Image::getCompressionAlgorithm(
     const std::string &path)
@@ -405,6 +1099,53 @@ BiometricEvaluation::Image::Image::getCompressionAlgorithm(
 	return (Image::getCompressionAlgorithm(data));
 }
 
+/* Read the header of data with a codec that references, not copies, it */
+template<typename T>
+static BE::Image::Properties
+probeWith(
+    const BE::Memory::ByteView &data)
+{
+	const T image(data);
+
+	BE::Image::Properties properties;
+	properties.compressionAlgorithm = image.getCompressionAlgorithm();
+	properties.dimensions = image.getDimensions();
+	properties.colorDepth = image.getColorDepth();
+	properties.bitDepth = image.getBitDepth();
+	properties.resolution = image.getResolution();
+	properties.hasAlphaChannel = image.hasAlphaChannel();
+	return (properties);
+}
+
+BiometricEvaluation::Image::Properties
+BiometricEvaluation::Image::Image::probe(
+    const Memory::ByteView &data)
+{
+	switch (Image::getCompressionAlgorithm(data)) {
+	case CompressionAlgorithm::JPEGB:
+		return (probeWith<JPEG>(data));
+	case CompressionAlgorithm::JPEGL:
+		return (probeWith<JPEGL>(data));
+	case CompressionAlgorithm::JP2:
+		/* FALLTHROUGH */
+	case CompressionAlgorithm::JP2L:
+		return (probeWith<JPEG2000>(data));
+	case CompressionAlgorithm::PNG:
+		return (probeWith<PNG>(data));
+	case CompressionAlgorithm::NetPBM:
+		return (probeWith<NetPBM>(data));
+	case CompressionAlgorithm::WSQ20:
+		return (probeWith<WSQ>(data));
+	case CompressionAlgorithm::BMP:
+		return (probeWith<BMP>(data));
+	case CompressionAlgorithm::TiledRaw:
+		return (probeWith<TiledRaw>(data));
+	default:
+		throw Error::StrategyError("Could not determine compression "
+		    "algorithm");
+	}
+}
+
 BiometricEvaluation::Image::Raw
 BiometricEvaluation::Image::Image::getRawImage(
     const std::shared_ptr<BiometricEvaluation::Image::Image> &image)
@@ -8,7 +8,9 @@
  * about its quality, reliability, or any other characteristic.
  */
 
+#include <algorithm>
 #include <cstdio>		/* Needed for NBIS headers */
+#include <cstring>
 #include <sstream>
 
 extern "C" {
@@ -18,13 +20,20 @@ extern "C" {
 }
 
 #include <be_image_jpeg.h>
+#include <be_memory_accounting.h>
 
 BiometricEvaluation::Image::JPEG::JPEG(
     const uint8_t *data,
     const uint64_t size) :
+    BiometricEvaluation::Image::JPEG::JPEG(Memory::ByteView(data, size))
+{
+	this->copyData();
+}
+
+BiometricEvaluation::Image::JPEG::JPEG(
+    const Memory::ByteView &data) :
     Image::Image(
     data,
-    size,
     CompressionAlgorithm::JPEGB)
 {
 	/* Initialize custom JPEG error manager to throw exceptions */
@@ -66,7 +75,22 @@ BiometricEvaluation::Image::JPEG::JPEG(
 }
 
 BiometricEvaluation::Memory::uint8Array
-BiometricEvaluation::Image::JPEG::getRawData()
+BiometricEvaluation::Image::JPEG::decodeRawData()
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	const uint64_t rowSize = this->getRawRowSize();
+	Memory::uint8Array rawData(rowSize * this->getDimensions().ySize);
+	this->decodeRawInto(rawData, rowSize);
+
+	return (rawData);
+}
+
+void
+BiometricEvaluation::Image::JPEG::decodeRawInto(
+    uint8_t *dst,
+    uint64_t stride)
     const
 {
 	/* Initialize custom JPEG error manager to throw exceptions */
@@ -91,15 +115,185 @@ BiometricEvaluation::Image::JPEG::getRawData()
 	if (jpeg_start_decompress(&dinfo) != TRUE)
 		throw Error::StrategyError("jpeg_start_decompress()");
 
-	uint64_t row_stride = dinfo.output_width * dinfo.output_components;
-	Memory::uint8Array rawData(dinfo.output_height * row_stride);
+	/* Rows are sized from the header parsed at construction */
+	const uint64_t row_stride = dinfo.output_width *
+	    dinfo.output_components;
+	if ((row_stride != this->getRawRowSize()) ||
+	    (dinfo.output_height != this->getDimensions().ySize)) {
+		jpeg_destroy_decompress(&dinfo);
+		throw Error::DataError("Decompressed size does not match "
+		    "header");
+	}
+
+	/* Decompress several scanlines at a time straight into dst */
+	static const JDIMENSION MaxRows = 16;
+	JSAMPROW rows[MaxRows];
+	while (dinfo.output_scanline < dinfo.output_height) {
+		const JDIMENSION count = std::min(MaxRows,
+		    dinfo.output_height - dinfo.output_scanline);
+		for (JDIMENSION i = 0; i < count; i++)
+			rows[i] = dst + ((dinfo.output_scanline + i) * stride);
+		jpeg_read_scanlines(&dinfo, rows, count);
+	}
+
+	/* Clean up after libjpeg */
+	jpeg_finish_decompress(&dinfo);
+	jpeg_destroy_decompress(&dinfo);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::JPEG::getRawGrayscaleData(
+    uint8_t depth)
+    const
+{
+	if (depth != 8 && depth != 1)
+		throw Error::ParameterError("Invalid value for bit depth");
+	return (Image::getRawGrayscaleData(depth));
+}
+
+bool
+BiometricEvaluation::Image::JPEG::decodesRegions()
+    const
+{
+	return (true);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::JPEG::decodeRawRegion(
+    const Coordinate &origin,
+    const Size &size)
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+
+	/* Initialize custom JPEG error manager to throw exceptions */
+	struct jpeg_error_mgr jpeg_error_mgr;
+	jpeg_std_error(&jpeg_error_mgr);
+	jpeg_error_mgr.error_exit = JPEG::error_exit;
+	
+	struct jpeg_decompress_struct dinfo;
+	dinfo.err = &jpeg_error_mgr;
+	jpeg_create_decompress(&dinfo);
+
+#if JPEG_LIB_VERSION >= 80
+	::jpeg_mem_src(&dinfo, (unsigned char *)this->getDataPointer(),
+	    this->getDataSize());
+#else
+	JPEG::jpeg_mem_src(&dinfo, (unsigned char *)this->getDataPointer(),
+	    this->getDataSize());
+#endif
+	
+	if (jpeg_read_header(&dinfo, TRUE) != JPEG_HEADER_OK)
+		throw Error::StrategyError("jpeg_read_header()");
+	if (jpeg_start_decompress(&dinfo) != TRUE)
+		throw Error::StrategyError("jpeg_start_decompress()");
+
+	const uint64_t components = dinfo.output_components;
+	if (((dinfo.output_width * components) != this->getRawRowSize()) ||
+	    (dinfo.output_height != this->getDimensions().ySize)) {
+		jpeg_destroy_decompress(&dinfo);
+		throw Error::DataError("Decompressed size does not match "
+		    "header");
+	}
 
+	/*
+	 * libjpeg-turbo can decompress only the iMCU columns that hold the
+	 * region and skip rows above it. Otherwise, rows above the region
+	 * are decompressed and discarded.
+	 */
+	JDIMENSION xOffset = origin.x;
+#if defined(LIBJPEG_TURBO_VERSION_NUMBER) && \
+    (LIBJPEG_TURBO_VERSION_NUMBER >= 1005000)
+	/*
+	 * Chroma upsampling differs at the edges of a crop, so keep an
+	 * extra iMCU on each side to match decoding the whole image.
+	 */
+	const JDIMENSION margin = dinfo.max_h_samp_factor * DCTSIZE;
+	JDIMENSION xStart = (origin.x > margin ? origin.x - margin : 0);
+	JDIMENSION width = std::min<JDIMENSION>(origin.x + size.xSize +
+	    margin, dinfo.output_width) - xStart;
+	jpeg_crop_scanline(&dinfo, &xStart, &width);
+	xOffset = origin.x - xStart;
+	if (origin.y > 0)
+		jpeg_skip_scanlines(&dinfo, origin.y);
+#endif
+
+	const uint64_t row_stride = dinfo.output_width * components;
 	JSAMPARRAY buffer = (*dinfo.mem->alloc_sarray)(
 	    (j_common_ptr)&dinfo, JPOOL_IMAGE, row_stride, 1);
 
-	for (int n = 0; dinfo.output_scanline < dinfo.output_height; n++) {
+	const uint64_t rowSize = size.xSize * components;
+	Memory::uint8Array rawData(rowSize * size.ySize);
+	while (dinfo.output_scanline < (origin.y + size.ySize)) {
+		const JDIMENSION row = dinfo.output_scanline;
 		jpeg_read_scanlines(&dinfo, buffer, 1);
-		memcpy(&rawData[n * row_stride], buffer[0], row_stride);
+		if (row >= origin.y)
+			std::memcpy(rawData + ((row - origin.y) * rowSize),
+			    buffer[0] + (xOffset * components), rowSize);
+	}
+
+	/* Rows below the region are never decompressed */
+	jpeg_destroy_decompress(&dinfo);
+
+	return (rawData);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::JPEG::decodeReducedRawData(
+    uint8_t scaleDenominator)
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+
+	/* Initialize custom JPEG error manager to throw exceptions */
+	struct jpeg_error_mgr jpeg_error_mgr;
+	jpeg_std_error(&jpeg_error_mgr);
+	jpeg_error_mgr.error_exit = JPEG::error_exit;
+	
+	struct jpeg_decompress_struct dinfo;
+	dinfo.err = &jpeg_error_mgr;
+	jpeg_create_decompress(&dinfo);
+
+#if JPEG_LIB_VERSION >= 80
+	::jpeg_mem_src(&dinfo, (unsigned char *)this->getDataPointer(),
+	    this->getDataSize());
+#else
+	JPEG::jpeg_mem_src(&dinfo, (unsigned char *)this->getDataPointer(),
+	    this->getDataSize());
+#endif
+	
+	if (jpeg_read_header(&dinfo, TRUE) != JPEG_HEADER_OK)
+		throw Error::StrategyError("jpeg_read_header()");
+
+	/* Scaled IDCTs produce the reduced image from the DCT blocks */
+	dinfo.scale_num = 1;
+	dinfo.scale_denom = scaleDenominator;
+	if (jpeg_start_decompress(&dinfo) != TRUE)
+		throw Error::StrategyError("jpeg_start_decompress()");
+
+	const Size reduced = this->getReducedDimensions(scaleDenominator);
+	const uint64_t row_stride = dinfo.output_width *
+	    dinfo.output_components;
+	if ((dinfo.output_width != reduced.xSize) ||
+	    (dinfo.output_height != reduced.ySize) ||
+	    ((row_stride * 8) != (reduced.xSize * this->getRawPixelBits()))) {
+		jpeg_destroy_decompress(&dinfo);
+		throw Error::DataError("Decompressed size does not match "
+		    "header");
+	}
+
+	Memory::uint8Array rawData(row_stride * reduced.ySize);
+	static const JDIMENSION MaxRows = 16;
+	JSAMPROW rows[MaxRows];
+	while (dinfo.output_scanline < dinfo.output_height) {
+		const JDIMENSION count = std::min(MaxRows,
+		    dinfo.output_height - dinfo.output_scanline);
+		for (JDIMENSION i = 0; i < count; i++)
+			rows[i] = rawData + ((dinfo.output_scanline + i) *
+			    row_stride);
+		jpeg_read_scanlines(&dinfo, rows, count);
 	}
 
 	/* Clean up after libjpeg */
@@ -110,13 +304,13 @@ BiometricEvaluation::Image::JPEG::getRawData()
 }
 
 BiometricEvaluation::Memory::uint8Array
-BiometricEvaluation::Image::JPEG::getRawGrayscaleData(
+BiometricEvaluation::Image::JPEG::decodeRawGrayscaleData(
     uint8_t depth)
     const
 {
-	if (depth != 8 && depth != 1)
-		throw Error::ParameterError("Invalid value for bit depth");
-	
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+
 	/* Initialize custom JPEG error manager to throw exceptions */
 	struct jpeg_error_mgr jpeg_error_mgr;
 	jpeg_std_error(&jpeg_error_mgr);
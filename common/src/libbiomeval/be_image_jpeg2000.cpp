@@ -11,7 +11,9 @@
 #include <openjpeg.h>
 
 #include <cmath>
+#include <be_image_conversion.h>
 #include <be_image_jpeg2000.h>
+#include <be_memory_accounting.h>
 #include <be_memory_mutableindexedbuffer.h>
 
 namespace BE = BiometricEvaluation;
@@ -20,9 +22,18 @@ BiometricEvaluation::Image::JPEG2000::JPEG2000(
     const uint8_t *data,
     const uint64_t size,
     const int8_t codecFormat) :
+    BiometricEvaluation::Image::JPEG2000::JPEG2000(
+    Memory::ByteView(data, size),
+    codecFormat)
+{
+	this->copyData();
+}
+
+BiometricEvaluation::Image::JPEG2000::JPEG2000(
+    const Memory::ByteView &data,
+    const int8_t codecFormat) :
     Image::Image(
     data,
-    size,
     CompressionAlgorithm::JP2),
     _codecFormat(codecFormat)
 {
@@ -105,7 +116,83 @@ BiometricEvaluation::Image::JPEG2000::JPEG2000(
 }
 
 BiometricEvaluation::Memory::uint8Array
-BiometricEvaluation::Image::JPEG2000::getRawData()
+BiometricEvaluation::Image::JPEG2000::decodeRawData()
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	const uint64_t rowSize = this->getRawRowSize();
+	Memory::uint8Array rawData(rowSize * this->getDimensions().ySize);
+	this->decodeRawInto(rawData, rowSize);
+
+	return (rawData);
+}
+
+void
+BiometricEvaluation::Image::JPEG2000::decodeRawInto(
+    uint8_t *dst,
+    uint64_t stride)
+    const
+{
+	this->decodeRegionInto({0, 0}, this->getDimensions(), 0, dst, stride);
+}
+
+bool
+BiometricEvaluation::Image::JPEG2000::decodesRegions()
+    const
+{
+	return (true);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::JPEG2000::decodeRawRegion(
+    const Coordinate &origin,
+    const Size &size)
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	const uint64_t rowSize = (static_cast<uint64_t>(size.xSize) *
+	    this->getRawPixelBits()) / 8;
+	Memory::uint8Array rawData(rowSize * size.ySize);
+	this->decodeRegionInto(origin, size, 0, rawData, rowSize);
+
+	return (rawData);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::JPEG2000::decodeReducedRawData(
+    uint8_t scaleDenominator)
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	uint8_t reduction = 0;
+	while ((1 << reduction) < scaleDenominator)
+		reduction++;
+
+	const Size reduced = this->getReducedDimensions(scaleDenominator);
+	const uint64_t rowSize = (static_cast<uint64_t>(reduced.xSize) *
+	    this->getRawPixelBits()) / 8;
+	Memory::uint8Array rawData(rowSize * reduced.ySize);
+	try {
+		this->decodeRegionInto({0, 0}, reduced, reduction, rawData,
+		    rowSize);
+	} catch (const Error::NotImplemented&) {
+		/* Too few resolution levels, or an offset image origin */
+		return (Image::decodeReducedRawData(scaleDenominator));
+	}
+
+	return (rawData);
+}
+
+void
+BiometricEvaluation::Image::JPEG2000::decodeRegionInto(
+    const Coordinate &origin,
+    const Size &size,
+    uint8_t reduction,
+    uint8_t *dst,
+    uint64_t stride)
     const
 {
 	std::unique_ptr<opj_codec_t, void(*)(opj_codec_t*)> codec(
@@ -128,48 +215,63 @@ BiometricEvaluation::Image::JPEG2000::getRawData()
 	if (image->comps[0].sgnd == 1)
 		throw Error::NotImplemented("libopenjp2: Signed buffers");
 
+	/* Discarded resolution levels are not decoded at all */
+	if (reduction > 0) {
+		if (opj_set_decoded_resolution_factor(codec.get(),
+		    reduction) == OPJ_FALSE)
+			throw Error::NotImplemented("libopenjp2: Reduction "
+			    "of " + std::to_string(reduction) + " resolution "
+			    "levels");
+	}
+
+	/* Decode area is on the reference grid, offset by the image origin */
+	else if (size != this->getDimensions())
+		if (opj_set_decode_area(codec.get(), image.get(),
+		    image->x0 + origin.x, image->y0 + origin.y,
+		    image->x0 + origin.x + size.xSize,
+		    image->y0 + origin.y + size.ySize) == OPJ_FALSE)
+			throw Error::StrategyError("libopenjp2: "
+			    "opj_set_decode_area");
+
 	if (opj_decode(codec.get(), stream.get(), image.get()) == OPJ_FALSE)
 		throw Error::StrategyError("libopenjp2: opj_decode");
 
-	const uint32_t w = this->getDimensions().xSize;
-	const uint32_t h = this->getDimensions().ySize;
+	const uint32_t w = size.xSize;
+	const uint32_t h = size.ySize;
 	const uint8_t bpc = image->comps[0].prec;
+	if (image->numcomps > UINT8_MAX)
+		throw Error::NotImplemented("libopenjp2: " +
+		    std::to_string(image->numcomps) + " components");
 
-	std::vector<int32_t*> ptr;
+	std::vector<const int32_t*> planes;
 	for (uint32_t i = 0; i < image->numcomps; ++i) {
-		ptr.push_back(image->comps[i].data);
+		planes.push_back(image->comps[i].data);
 		if ((image->comps[i].w != w) || (image->comps[i].h != h) ||
 		    (image->comps[i].prec != bpc))
 			throw Error::NotImplemented("libopenjp2: Non-equal "
 			    "components");
 	}
 
-	Memory::uint8Array rawData(image->numcomps * (bpc / 8) * image->x1 *
-	    image->y1);
-	Memory::MutableIndexedBuffer buffer(rawData);
-
-	const int32_t mask = (1 << image->comps[0].prec) - 1;
+	uint8_t sampleSize;
+	if (bpc <= 8)
+		sampleSize = 1;
+	else if (bpc <= 16)
+		sampleSize = 2;
+	else
+		throw Error::NotImplemented("libopenjp2: " +
+		    std::to_string(bpc) + "-bit-per-component images");
+	if ((image->numcomps * sampleSize * 8) != this->getRawPixelBits())
+		throw Error::DataError("Decompressed size does not match "
+		    "header");
+
+	/* Interleave each row of the component planes into dst */
+	const uint32_t mask = (1u << bpc) - 1;
 	for (uint32_t row = 0; row < h; ++row) {
-		for (uint32_t col = 0; col < w; ++col) {
-			if (bpc <= 8) {
-				for (uint32_t i = 0; i < image->numcomps; ++i) {
-					buffer.pushU8Val(*ptr[i] & mask);
-					ptr[i]++;
-				}
-			} else if (bpc <= 16) {
-				for (uint32_t i = 0; i < image->numcomps; ++i) {
-					buffer.pushU16Val(*ptr[i] & mask);
-					ptr[i]++;
-				}
-			} else {
-				throw Error::NotImplemented(
-				    "libopenjp2: " + std::to_string(bpc) +
-				    "-bit-per-component images");
-			}
-		}
+		Conversion::interleave(planes.data(), image->numcomps,
+		    dst + (row * stride), w, sampleSize, mask);
+		for (auto &plane : planes)
+			plane += w;
 	}
-
-	return (rawData);
 }
 
 BiometricEvaluation::Memory::uint8Array
@@ -17,13 +17,20 @@ extern "C" {
 
 #include <be_image_jpeg.h>
 #include <be_image_jpegl.h>
+#include <be_memory_accounting.h>
 
 BiometricEvaluation::Image::JPEGL::JPEGL(
     const uint8_t *data,
     const uint64_t size) :
+    BiometricEvaluation::Image::JPEGL::JPEGL(Memory::ByteView(data, size))
+{
+	this->copyData();
+}
+
+BiometricEvaluation::Image::JPEGL::JPEGL(
+    const Memory::ByteView &data) :
     Image::Image(
     data,
-    size,
     CompressionAlgorithm::JPEGL)
 {
 	uint8_t *markerBuf = (uint8_t *)this->getDataPointer();
@@ -94,9 +101,11 @@ BiometricEvaluation::Image::JPEGL::JPEGL(
 }
 
 BiometricEvaluation::Memory::uint8Array
-BiometricEvaluation::Image::JPEGL::getRawData()
+BiometricEvaluation::Image::JPEGL::decodeRawData()
     const
 {
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
 	/* TODO: Extract the raw data without using the IMG_DAT struct */
 	IMG_DAT *imgDat = nullptr;
 	int32_t lossy;
@@ -10,11 +10,13 @@
 
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <type_traits>
 
 #include <be_memory.h>
 #include <be_image_netpbm.h>
+#include <be_memory_accounting.h>
 #include <be_memory_mutableindexedbuffer.h>
 
 template<>
@@ -32,12 +34,18 @@ const std::map<BiometricEvaluation::Image::NetPBM::Kind, std::string>
 BiometricEvaluation::Image::NetPBM::NetPBM(
     const uint8_t *data,
     const uint64_t size) :
+    BiometricEvaluation::Image::NetPBM::NetPBM(Memory::ByteView(data, size))
+{
+	this->copyData();
+}
+
+BiometricEvaluation::Image::NetPBM::NetPBM(
+    const Memory::ByteView &data) :
     Image::Image(
     data,
-    size,
     CompressionAlgorithm::NetPBM)
 {
-	if (isNetPBM(data, size) != true)
+	if (isNetPBM(data.data(), data.size()) != true)
 		throw Error::DataError("Not a NetPBM formatted image");
 	
 	try {
@@ -228,9 +236,11 @@ BiometricEvaluation::Image::NetPBM::skipLine(
 }
 
 BiometricEvaluation::Memory::uint8Array
-BiometricEvaluation::Image::NetPBM::getRawData()
+BiometricEvaluation::Image::NetPBM::decodeRawData()
     const
 {
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
 	const uint8_t *data = this->getDataPointer() + this->_headerLength;
 	const uint64_t dataSize = this->getDataSize() - this->_headerLength;
 
@@ -267,6 +277,82 @@ BiometricEvaluation::Image::NetPBM::getRawData()
 	}
 }
 
+bool
+BiometricEvaluation::Image::NetPBM::decodesRegions()
+    const
+{
+	switch (_kind) {
+	case Kind::BinaryPortableBitmap:
+		/* FALLTHROUGH */
+	case Kind::BinaryPortableGraymap:
+		/* FALLTHROUGH */
+	case Kind::BinaryPortablePixmap:
+		return (true);
+	default:
+		return (false);
+	}
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::NetPBM::decodeRawRegion(
+    const Coordinate &origin,
+    const Size &size)
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	const uint8_t *data = this->getDataPointer() + this->_headerLength;
+	const uint64_t dataSize = this->getDataSize() - this->_headerLength;
+	const uint64_t xSize = this->getDimensions().xSize;
+
+	switch (_kind) {
+	case Kind::BinaryPortableBitmap: {
+		/* Rows are padded to a byte; 0 is white, 1 is black */
+		const uint64_t srcRowSize = (xSize + 7) / 8;
+		if (dataSize < ((origin.y + size.ySize) * srcRowSize))
+			throw Error::DataError("Bitmap is truncated");
+
+		Memory::uint8Array rawData(size.xSize * size.ySize);
+		for (uint32_t row = 0; row < size.ySize; row++) {
+			const uint8_t *src = data +
+			    ((origin.y + row) * srcRowSize);
+			uint8_t *dst = rawData + (row * size.xSize);
+			for (uint32_t col = origin.x;
+			    col < (origin.x + size.xSize); col++)
+				*dst++ = ((src[col / 8] & (0x80 >> (col % 8)))
+				    == 0) ? 0xFF : 0x00;
+		}
+		return (rawData);
+	}
+	case Kind::BinaryPortableGraymap:
+		/* FALLTHROUGH */
+	case Kind::BinaryPortablePixmap: {
+		const uint64_t srcRowSize = this->getRawRowSize();
+		if (dataSize < ((origin.y + size.ySize) * srcRowSize))
+			throw Error::DataError("Image data is truncated");
+
+		const uint64_t pixelSize = this->getRawPixelBits() / 8;
+		const uint64_t rowSize = size.xSize * pixelSize;
+		Memory::uint8Array rawData(rowSize * size.ySize);
+		for (uint32_t row = 0; row < size.ySize; row++)
+			std::memcpy(rawData + (row * rowSize), data +
+			    ((origin.y + row) * srcRowSize) +
+			    (origin.x * pixelSize), rowSize);
+
+		/* NetPBM stores data big-endian */
+		if ((this->getColorDepth() == 16 ||
+		    this->getColorDepth() == 48) && Memory::isLittleEndian())
+			for (uint64_t i = 0; i < (rawData.size() - 1); i += 2)
+				std::swap(rawData[i], rawData[i + 1]);
+
+		return (rawData);
+	}
+	default:
+		/* ASCII samples have no fixed position */
+		return (Image::decodeRawRegion(origin, size));
+	}
+}
+
 BiometricEvaluation::Memory::uint8Array
 BiometricEvaluation::Image::NetPBM::ASCIIBitmapTo8Bit(
     const uint8_t *bitmap,
@@ -12,14 +12,21 @@
 
 #include <be_memory.h>
 #include <be_image_png.h>
+#include <be_memory_accounting.h>
 #include <be_memory_autoarray.h>
 
 BiometricEvaluation::Image::PNG::PNG(
     const uint8_t *data,
     const uint64_t size) :
+    BiometricEvaluation::Image::PNG::PNG(Memory::ByteView(data, size))
+{
+	this->copyData();
+}
+
+BiometricEvaluation::Image::PNG::PNG(
+    const Memory::ByteView &data) :
     Image::Image(
     data,
-    size,
     CompressionAlgorithm::PNG)
 {
 	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
@@ -93,7 +100,22 @@ BiometricEvaluation::Image::PNG::PNG(
 }
 
 BiometricEvaluation::Memory::uint8Array
-BiometricEvaluation::Image::PNG::getRawData()
+BiometricEvaluation::Image::PNG::decodeRawData()
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	const uint64_t rowSize = this->getRawRowSize();
+	Memory::uint8Array rawData(rowSize * this->getDimensions().ySize);
+	this->decodeRawInto(rawData, rowSize);
+
+	return (rawData);
+}
+
+void
+BiometricEvaluation::Image::PNG::decodeRawInto(
+    uint8_t *dst,
+    uint64_t stride)
     const
 {
 	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
@@ -120,21 +142,113 @@ BiometricEvaluation::Image::PNG::getRawData()
 	    BiometricEvaluation::Memory::isLittleEndian())
 		png_set_swap(png_ptr);
 	
-	/* Determine size of decompressed data */
+	/* Rows are sized from the header parsed at construction */
 	const png_uint_32 rowbytes = png_get_rowbytes(png_ptr, png_info_ptr);
 	const uint32_t height = this->getDimensions().ySize;
-	Memory::AutoArray<png_bytep> row_pointers(height);
-	Memory::uint8Array rawData(rowbytes * height);
+	if ((rowbytes != this->getRawRowSize()) ||
+	    (png_get_image_height(png_ptr, png_info_ptr) != height)) {
+		png_destroy_read_struct(&png_ptr, &png_info_ptr, nullptr);
+		throw Error::DataError("Decompressed size does not match "
+		    "header");
+	}
 
-	/* Tell libpng to store decompressed PNG data directly into AutoArray */
-	for (uint32_t row = 0; row < height; row++)
-		row_pointers[row] = rawData + (row * rowbytes);
+	/* Tell libpng to store decompressed PNG data directly into dst */
+	Memory::AutoArray<png_bytep> row_pointers(height);
+	const bool partialByte = ((static_cast<uint64_t>(
+	    this->getDimensions().xSize) * this->getColorDepth()) % 8) != 0;
+	for (uint32_t row = 0; row < height; row++) {
+		row_pointers[row] = dst + (row * stride);
+		/* libpng keeps the existing bits past the last pixel */
+		if (partialByte)
+			row_pointers[row][rowbytes - 1] = 0;
+	}
 	png_read_image(png_ptr, row_pointers);
 
+	png_destroy_read_struct(&png_ptr, &png_info_ptr, nullptr);
+}
+
+bool
+BiometricEvaluation::Image::PNG::decodesRegions()
+    const
+{
+	/* Interlace method is the last byte of IHDR, after the signature */
+	static const uint64_t InterlaceOffset = 8 + 8 + 12;
+	if (this->getDataSize() <= InterlaceOffset)
+		return (false);
+	return (this->getDataPointer()[InterlaceOffset] == 0);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::PNG::decodeRawRegion(
+    const Coordinate &origin,
+    const Size &size)
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
+	    nullptr, png_error, png_error);
+	if (png_ptr == nullptr)
+		throw Error::StrategyError("libpng could not create "
+		    "png_struct");
+
+	/* Read encoded PNG data from a buffer using our extension */
+	png_buffer png_buf = { this->getDataPointer(), this->getDataSize(), 0 };
+	png_set_read_fn(png_ptr, &png_buf, png_read_mem_src);
+	
+	/* Read the header information */
+	png_infop png_info_ptr = png_create_info_struct(png_ptr);
+	if (png_info_ptr == nullptr) {
+		png_destroy_read_struct(&png_ptr, nullptr, nullptr);
+		throw Error::StrategyError("libpng could not create "
+		    "png_info");
+	}
+	png_read_info(png_ptr, png_info_ptr);
+
+	/* Rows of interlaced images are not complete until the last pass */
+	if (png_get_interlace_type(png_ptr, png_info_ptr) !=
+	    PNG_INTERLACE_NONE) {
+		png_destroy_read_struct(&png_ptr, &png_info_ptr, nullptr);
+		return (Image::decodeRawRegion(origin, size));
+	}
+
+	/* PNG default storage is big-endian */
+	if ((png_get_bit_depth(png_ptr, png_info_ptr) > 8) &&
+	    BiometricEvaluation::Memory::isLittleEndian())
+		png_set_swap(png_ptr);
+
+	const png_uint_32 rowbytes = png_get_rowbytes(png_ptr, png_info_ptr);
+	if ((rowbytes != this->getRawRowSize()) ||
+	    (png_get_image_height(png_ptr, png_info_ptr) !=
+	    this->getDimensions().ySize)) {
+		png_destroy_read_struct(&png_ptr, &png_info_ptr, nullptr);
+		throw Error::DataError("Decompressed size does not match "
+		    "header");
+	}
+
+	/* Decompress rows through the last row of the region */
+	const uint64_t rowSize = ((static_cast<uint64_t>(size.xSize) *
+	    this->getRawPixelBits()) + 7) / 8;
+	Memory::uint8Array rawData(rowSize * size.ySize);
+	Memory::uint8Array row(rowbytes);
+	for (uint32_t y = 0; y < (origin.y + size.ySize); y++) {
+		png_read_row(png_ptr, row, nullptr);
+		if (y >= origin.y)
+			this->copyPixels(row, origin.x, size.xSize,
+			    rawData + ((y - origin.y) * rowSize));
+	}
+
 	png_destroy_read_struct(&png_ptr, &png_info_ptr, nullptr);
 	return (rawData);
 }
 
+uint32_t
+BiometricEvaluation::Image::PNG::getRawPixelBits()
+    const
+{
+	return (this->getColorDepth());
+}
+
 BiometricEvaluation::Memory::uint8Array
 BiometricEvaluation::Image::PNG::getRawGrayscaleData(
     uint8_t depth)
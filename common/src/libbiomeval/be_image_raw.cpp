@@ -9,6 +9,7 @@
  */
 
 #include <be_image_raw.h>
+#include <be_memory_accounting.h>
 #include <be_memory_autoarray.h>
 
 BiometricEvaluation::Image::Raw::Raw(
@@ -19,16 +20,15 @@ BiometricEvaluation::Image::Raw::Raw(
     const uint16_t bitDepth,
     const Resolution resolution,
     const bool hasAlphaChannel) :
-    Image(data,
-    size,
+    BiometricEvaluation::Image::Raw::Raw(
+    Memory::ByteView(data, size),
     dimensions,
     colorDepth,
     bitDepth,
     resolution,
-    CompressionAlgorithm::None,
     hasAlphaChannel)
 {
-
+	this->copyData();
 }
 
 BiometricEvaluation::Image::Raw::Raw(
@@ -49,13 +49,66 @@ BiometricEvaluation::Image::Raw::Raw(
 
 }
 
+BiometricEvaluation::Image::Raw::Raw(
+    const Memory::ByteView &data,
+    const Size dimensions,
+    const uint32_t colorDepth,
+    const uint16_t bitDepth,
+    const Resolution resolution,
+    const bool hasAlphaChannel) :
+    Image(data,
+    dimensions,
+    colorDepth,
+    bitDepth,
+    resolution,
+    CompressionAlgorithm::None,
+    hasAlphaChannel)
+{
+
+}
+
 BiometricEvaluation::Memory::uint8Array
 BiometricEvaluation::Image::Raw::getRawData()
     const
 {
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
 	return (this->getData());
 }
 
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Raw::decodeRawData()
+    const
+{
+	return (this->getData());
+}
+
+void
+BiometricEvaluation::Image::Raw::decodeRawInto(
+    uint8_t *dst,
+    uint64_t stride)
+    const
+{
+	this->copyRows(this->getDataView(), this->getRawRowSize(), dst,
+	    stride);
+}
+
+bool
+BiometricEvaluation::Image::Raw::decodesRegions()
+    const
+{
+	return (true);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::Raw::decodeRawRegion(
+    const Coordinate &origin,
+    const Size &size)
+    const
+{
+	return (this->cropRows(this->getDataView(), origin, size));
+}
+
 BiometricEvaluation::Memory::uint8Array
 BiometricEvaluation::Image::Raw::getRawGrayscaleData(
     uint8_t depth)
@@ -0,0 +1,705 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+/*
+ * As in be_image_conversion.cpp, x86-64 kernels are compiled for their
+ * instruction sets with target attributes and chosen at run time.
+ */
+#if defined __x86_64__ && defined __GNUC__
+#define BE_IMAGE_RESAMPLE_X86
+#include <immintrin.h>
+#endif
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <vector>
+
+#include <be_error_exception.h>
+#include <be_image_conversion.h>
+#include <be_image_resample.h>
+#include <be_system.h>
+
+namespace BE = BiometricEvaluation;
+
+template<>
+const std::map<BiometricEvaluation::Image::ResampleFilter, std::string>
+    BiometricEvaluation::Framework::EnumerationFunctions<
+    BiometricEvaluation::Image::ResampleFilter>::enumToStringMap = {
+	{Image::ResampleFilter::Area, "Area"},
+	{Image::ResampleFilter::Bilinear, "Bilinear"},
+	{Image::ResampleFilter::Lanczos, "Lanczos"}
+};
+
+/******************************************************************************/
+/* Filter coefficients.                                                       */
+/******************************************************************************/
+
+static double
+bilinearFilter(
+    double x)
+{
+	x = std::fabs(x);
+	return (x < 1.0 ? 1.0 - x : 0.0);
+}
+
+static double
+sinc(
+    double x)
+{
+	if (x == 0.0)
+		return (1.0);
+	x *= M_PI;
+	return (std::sin(x) / x);
+}
+
+static double
+lanczosFilter(
+    double x)
+{
+	return (((x > -3.0) && (x < 3.0)) ? sinc(x) * sinc(x / 3.0) : 0.0);
+}
+
+/**
+ * @brief
+ * Weights of the input samples that make up each output sample, along
+ * one axis.
+ */
+struct Coefficients
+{
+	/** Weights per output sample, including zero padding */
+	uint32_t taps;
+	/** First input sample of each output sample */
+	std::vector<uint32_t> start;
+	/** Input samples, from start, with nonzero weight */
+	std::vector<uint32_t> count;
+	/** Weight k of output sample i is weights[(i * taps) + k] */
+	std::vector<float> weights;
+	/** Weight k of output sample i is transposed[(k * size) + i] */
+	std::vector<float> transposed;
+};
+
+/**
+ * @brief
+ * Compute the weights that resample one axis.
+ * @details
+ * When downscaling, filters are stretched by the scale factor so that
+ * every input sample contributes (antialiasing). The Area filter instead
+ * weights each input sample by how much of it lies within the output
+ * sample's footprint, so 3 samples become 2 as (p0 + p1 / 2) / 1.5 and
+ * (p1 / 2 + p2) / 1.5.
+ *
+ * @param[in] inSize
+ *	Input samples along the axis.
+ * @param[in] outSize
+ *	Output samples along the axis.
+ * @param[in] filter
+ *	Resampling filter.
+ *
+ * @return
+ *	Normalized weights for each output sample.
+ */
+static Coefficients
+computeCoefficients(
+    uint32_t inSize,
+    uint32_t outSize,
+    BE::Image::ResampleFilter filter)
+{
+	double support;
+	double (*fn)(double);
+	switch (filter) {
+	case BE::Image::ResampleFilter::Area:
+		support = 0.5;
+		fn = nullptr;
+		break;
+	case BE::Image::ResampleFilter::Bilinear:
+		support = 1.0;
+		fn = bilinearFilter;
+		break;
+	case BE::Image::ResampleFilter::Lanczos:
+		support = 3.0;
+		fn = lanczosFilter;
+		break;
+	default:
+		throw BE::Error::NotImplemented(::to_string(filter));
+	}
+
+	const double scale = static_cast<double>(inSize) / outSize;
+	const double filterScale = std::max(scale, 1.0);
+	support *= filterScale;
+
+	Coefficients c;
+	c.taps = (static_cast<uint32_t>(std::ceil(support)) * 2) + 1;
+	c.start.resize(outSize);
+	c.count.resize(outSize);
+	c.weights.assign(static_cast<uint64_t>(outSize) * c.taps, 0);
+	for (uint32_t i = 0; i < outSize; i++) {
+		const double center = (i + 0.5) * scale;
+		int64_t first, last;
+		if (fn == nullptr) {
+			/* Input samples overlapping [i, i + 1) * scale */
+			first = static_cast<int64_t>(std::floor(i * scale));
+			last = std::min<int64_t>(static_cast<int64_t>(
+			    std::ceil((i + 1) * scale)), inSize);
+		} else {
+			first = std::max<int64_t>(static_cast<int64_t>(
+			    center - support + 0.5), 0);
+			last = std::min<int64_t>(static_cast<int64_t>(
+			    center + support + 0.5), inSize);
+		}
+		const uint32_t count = static_cast<uint32_t>(std::min<int64_t>(
+		    std::max<int64_t>(last - first, 1), c.taps));
+		c.start[i] = static_cast<uint32_t>(std::min<int64_t>(first,
+		    inSize - count));
+		c.count[i] = count;
+
+		float *w = c.weights.data() + (static_cast<uint64_t>(i) *
+		    c.taps);
+		double sum = 0;
+		std::vector<double> unnormalized(count);
+		for (uint32_t k = 0; k < count; k++) {
+			const double sample = k + c.start[i];
+			if (fn == nullptr)
+				unnormalized[k] = std::max(0.0,
+				    std::min(sample + 1, (i + 1) * scale) -
+				    std::max(sample, i * scale));
+			else
+				unnormalized[k] = fn((sample - center + 0.5) /
+				    filterScale);
+			sum += unnormalized[k];
+		}
+		for (uint32_t k = 0; k < count; k++)
+			w[k] = static_cast<float>(sum != 0 ?
+			    unnormalized[k] / sum : (k == 0 ? 1.0 : 0.0));
+	}
+
+	c.transposed.resize(c.weights.size());
+	for (uint32_t i = 0; i < outSize; i++)
+		for (uint32_t k = 0; k < c.taps; k++)
+			c.transposed[(static_cast<uint64_t>(k) * outSize) + i] =
+			    c.weights[(static_cast<uint64_t>(i) * c.taps) + k];
+
+	return (c);
+}
+
+/******************************************************************************/
+/* Portable kernels.                                                          */
+/*                                                                            */
+/* Every kernel sums weighted samples in the same order, with separate       */
+/* multiplies and adds, so the vector kernels match these exactly.           */
+/******************************************************************************/
+
+/** Read a sample of sampleSize bytes, in native byte order */
+static inline float
+loadSample(
+    const uint8_t *row,
+    uint64_t index,
+    uint8_t sampleSize)
+{
+	if (sampleSize == 1)
+		return (row[index]);
+	uint16_t v;
+	std::memcpy(&v, row + (index * 2), sizeof(v));
+	return (v);
+}
+
+/** Write a clamped and rounded sample of sampleSize bytes */
+static inline void
+storeSample(
+    uint8_t *row,
+    uint64_t index,
+    uint8_t sampleSize,
+    float value,
+    float maximum)
+{
+	value = std::min(std::max(value, 0.0f), maximum);
+	const uint16_t v = static_cast<uint16_t>(std::nearbyint(value));
+	if (sampleSize == 1)
+		row[index] = static_cast<uint8_t>(v);
+	else
+		std::memcpy(row + (index * 2), &v, sizeof(v));
+}
+
+/**
+ * @brief
+ * Combine input rows into one row of floats.
+ *
+ * @param[in] rows
+ *	count input rows.
+ * @param[in] count
+ *	Number of rows.
+ * @param[in] weights
+ *	Weight of each row.
+ * @param[in] sampleSize
+ *	Bytes per input sample (1 or 2).
+ * @param[in] first
+ *	First sample to combine.
+ * @param[in] samples
+ *	Samples in a row.
+ * @param[out] out
+ *	samples floats.
+ */
+static void
+verticalScalar(
+    const uint8_t *const *rows,
+    uint32_t count,
+    const float *weights,
+    uint8_t sampleSize,
+    uint64_t first,
+    uint64_t samples,
+    float *out)
+{
+	for (uint64_t s = first; s < samples; s++) {
+		float acc = 0.0f;
+		for (uint32_t k = 0; k < count; k++)
+			acc = acc + (weights[k] * loadSample(rows[k], s,
+			    sampleSize));
+		out[s] = acc;
+	}
+}
+
+/**
+ * @brief
+ * Resample one row of floats into output pixels.
+ *
+ * @param[in] in
+ *	Input row, followed by taps pixels of padding.
+ * @param[in] channels
+ *	Samples per pixel.
+ * @param[in] h
+ *	Horizontal coefficients.
+ * @param[in] first
+ *	First output pixel to compute.
+ * @param[in] width
+ *	Output pixels in the row.
+ * @param[out] out
+ *	Output row.
+ * @param[in] sampleSize
+ *	Bytes per output sample (1 or 2).
+ * @param[in] maximum
+ *	Largest output sample.
+ */
+static void
+horizontalScalar(
+    const float *in,
+    uint8_t channels,
+    const Coefficients &h,
+    uint32_t first,
+    uint32_t width,
+    uint8_t *out,
+    uint8_t sampleSize,
+    float maximum)
+{
+	for (uint32_t x = first; x < width; x++) {
+		const float *w = h.weights.data() +
+		    (static_cast<uint64_t>(x) * h.taps);
+		for (uint8_t c = 0; c < channels; c++) {
+			const float *src = in + (static_cast<uint64_t>(
+			    h.start[x]) * channels) + c;
+			float acc = 0.0f;
+			for (uint32_t k = 0; k < h.taps; k++)
+				acc = acc + (w[k] * src[k * channels]);
+			storeSample(out, (static_cast<uint64_t>(x) *
+			    channels) + c, sampleSize, acc, maximum);
+		}
+	}
+}
+
+/******************************************************************************/
+/* x86-64 kernels.                                                            */
+/******************************************************************************/
+
+#if defined BE_IMAGE_RESAMPLE_X86
+
+/** @return Samples combined; the caller combines the rest */
+__attribute__((target("sse4.1")))
+static uint64_t
+verticalSSE41(
+    const uint8_t *const *rows,
+    uint32_t count,
+    const float *weights,
+    uint8_t sampleSize,
+    uint64_t samples,
+    float *out)
+{
+	uint64_t s = 0;
+	for (; s + 4 <= samples; s += 4) {
+		__m128 acc = _mm_setzero_ps();
+		for (uint32_t k = 0; k < count; k++) {
+			__m128i v;
+			if (sampleSize == 1) {
+				int32_t bytes;
+				std::memcpy(&bytes, rows[k] + s, sizeof(bytes));
+				v = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+			} else {
+				v = _mm_cvtepu16_epi32(_mm_loadl_epi64(
+				    reinterpret_cast<const __m128i *>(
+				    rows[k] + (s * 2))));
+			}
+			acc = _mm_add_ps(acc, _mm_mul_ps(
+			    _mm_set1_ps(weights[k]), _mm_cvtepi32_ps(v)));
+		}
+		_mm_storeu_ps(out + s, acc);
+	}
+	return (s);
+}
+
+/** @return Samples combined; the caller combines the rest */
+__attribute__((target("avx2")))
+static uint64_t
+verticalAVX2(
+    const uint8_t *const *rows,
+    uint32_t count,
+    const float *weights,
+    uint8_t sampleSize,
+    uint64_t samples,
+    float *out)
+{
+	uint64_t s = 0;
+	for (; s + 8 <= samples; s += 8) {
+		__m256 acc = _mm256_setzero_ps();
+		for (uint32_t k = 0; k < count; k++) {
+			__m256i v;
+			if (sampleSize == 1)
+				v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+				    reinterpret_cast<const __m128i *>(
+				    rows[k] + s)));
+			else
+				v = _mm256_cvtepu16_epi32(_mm_loadu_si128(
+				    reinterpret_cast<const __m128i *>(
+				    rows[k] + (s * 2))));
+			acc = _mm256_add_ps(acc, _mm256_mul_ps(
+			    _mm256_set1_ps(weights[k]), _mm256_cvtepi32_ps(v)));
+		}
+		_mm256_storeu_ps(out + s, acc);
+	}
+	return (s);
+}
+
+/**
+ * @return
+ * Output pixels computed; the caller computes the rest.
+ * @note
+ * Eight output pixels at a time, gathering their inputs.
+ */
+__attribute__((target("avx2")))
+static uint32_t
+horizontalAVX2(
+    const float *in,
+    uint8_t channels,
+    const Coefficients &h,
+    uint32_t width,
+    uint8_t *out,
+    uint8_t sampleSize,
+    float maximum)
+{
+	const __m256i step = _mm256_set1_epi32(channels);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 ceiling = _mm256_set1_ps(maximum);
+	alignas(32) int32_t values[8];
+
+	uint32_t x = 0;
+	for (; x + 8 <= width; x += 8) {
+		const __m256i base = _mm256_mullo_epi32(_mm256_loadu_si256(
+		    reinterpret_cast<const __m256i *>(h.start.data() + x)),
+		    step);
+		for (uint8_t c = 0; c < channels; c++) {
+			__m256i index = _mm256_add_epi32(base,
+			    _mm256_set1_epi32(c));
+			__m256 acc = _mm256_setzero_ps();
+			for (uint32_t k = 0; k < h.taps; k++) {
+				const __m256 w = _mm256_loadu_ps(
+				    h.transposed.data() +
+				    (static_cast<uint64_t>(k) * width) + x);
+				acc = _mm256_add_ps(acc, _mm256_mul_ps(w,
+				    _mm256_i32gather_ps(in, index, 4)));
+				index = _mm256_add_epi32(index, step);
+			}
+			acc = _mm256_min_ps(_mm256_max_ps(acc, zero), ceiling);
+			_mm256_store_si256(reinterpret_cast<__m256i *>(values),
+			    _mm256_cvtps_epi32(acc));
+			for (uint8_t j = 0; j < 8; j++) {
+				const uint16_t v = static_cast<uint16_t>(
+				    values[j]);
+				const uint64_t i = (static_cast<uint64_t>(
+				    x + j) * channels) + c;
+				if (sampleSize == 1)
+					out[i] = static_cast<uint8_t>(v);
+				else
+					std::memcpy(out + (i * 2), &v,
+					    sizeof(v));
+			}
+		}
+	}
+	return (x);
+}
+
+#endif /* BE_IMAGE_RESAMPLE_X86 */
+
+/******************************************************************************/
+/* Dispatch.                                                                  */
+/******************************************************************************/
+
+static void
+vertical(
+    const uint8_t *const *rows,
+    uint32_t count,
+    const float *weights,
+    uint8_t sampleSize,
+    uint64_t samples,
+    float *out)
+{
+	uint64_t done = 0;
+#if defined BE_IMAGE_RESAMPLE_X86
+	switch (BE::Image::Conversion::getInstructions()) {
+	case BE::Image::Conversion::Instructions::AVX2:
+		done = verticalAVX2(rows, count, weights, sampleSize, samples,
+		    out);
+		break;
+	case BE::Image::Conversion::Instructions::SSE41:
+		done = verticalSSE41(rows, count, weights, sampleSize, samples,
+		    out);
+		break;
+	case BE::Image::Conversion::Instructions::Scalar:
+		break;
+	}
+#endif
+	verticalScalar(rows, count, weights, sampleSize, done, samples, out);
+}
+
+static void
+horizontal(
+    const float *in,
+    uint8_t channels,
+    const Coefficients &h,
+    uint32_t width,
+    uint8_t *out,
+    uint8_t sampleSize,
+    float maximum)
+{
+	uint32_t done = 0;
+#if defined BE_IMAGE_RESAMPLE_X86
+	/* SSE4.1 has no gather, so it shares the portable kernel */
+	if (BE::Image::Conversion::getInstructions() ==
+	    BE::Image::Conversion::Instructions::AVX2)
+		done = horizontalAVX2(in, channels, h, width, out, sampleSize,
+		    maximum);
+#endif
+	horizontalScalar(in, channels, h, done, width, out, sampleSize,
+	    maximum);
+}
+
+/**
+ * @brief
+ * State shared by the threads of forEachRowBlock().
+ */
+struct RowBlocks
+{
+	/** Number of rows */
+	uint32_t rows;
+	/** Rows in each block */
+	uint32_t blockSize;
+	/** Function called with the first and last + 1 row of a block */
+	const std::function<void(uint32_t, uint32_t)> *fn;
+	/** Next block to process */
+	std::atomic<uint32_t> next;
+	/** Guards error */
+	pthread_mutex_t mutex;
+	/** First exception thrown by fn */
+	std::exception_ptr error;
+};
+
+static void*
+rowBlockWorker(
+    void *arg)
+{
+	RowBlocks *state = static_cast<RowBlocks*>(arg);
+	for (;;) {
+		const uint64_t first = static_cast<uint64_t>(state->next++) *
+		    state->blockSize;
+		if (first >= state->rows)
+			break;
+		try {
+			(*state->fn)(static_cast<uint32_t>(first),
+			    static_cast<uint32_t>(std::min<uint64_t>(first +
+			    state->blockSize, state->rows)));
+		} catch (...) {
+			pthread_mutex_lock(&state->mutex);
+			if (state->error == nullptr)
+				state->error = std::current_exception();
+			pthread_mutex_unlock(&state->mutex);
+		}
+	}
+	return (nullptr);
+}
+
+/**
+ * @brief
+ * Divide rows into blocks and process them on a pool of threads.
+ *
+ * @param[in] rows
+ *	Number of rows.
+ * @param[in] threads
+ *	Number of threads, or 0 for System::getCPUCount(). The calling
+ *	thread is one of them.
+ * @param[in] fn
+ *	Function called with the first and last + 1 row of each block.
+ */
+static void
+forEachRowBlock(
+    uint32_t rows,
+    uint32_t threads,
+    const std::function<void(uint32_t, uint32_t)> &fn)
+{
+	static const uint32_t blockSize = 16;
+	if (threads == 0)
+		threads = std::max<uint32_t>(BE::System::getCPUCount(), 1);
+	threads = std::min(threads, (rows + blockSize - 1) / blockSize);
+
+	RowBlocks state;
+	state.rows = rows;
+	state.blockSize = blockSize;
+	state.fn = &fn;
+	state.next = 0;
+	pthread_mutex_init(&state.mutex, nullptr);
+
+	std::vector<pthread_t> workers;
+	for (uint32_t i = 1; i < threads; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, nullptr, rowBlockWorker,
+		    &state) != 0)
+			break;
+		workers.push_back(thread);
+	}
+	rowBlockWorker(&state);
+	for (const auto &thread : workers)
+		pthread_join(thread, nullptr);
+	pthread_mutex_destroy(&state.mutex);
+
+	if (state.error != nullptr)
+		std::rethrow_exception(state.error);
+}
+
+/** Resample image to dimensions, labeling it with resolution */
+static BE::Image::Raw
+resampleTo(
+    const BE::Image::Raw &image,
+    const BE::Image::Size &dimensions,
+    const BE::Image::Resolution &resolution,
+    BE::Image::ResampleFilter filter,
+    uint32_t threads)
+{
+	if ((dimensions.xSize == 0) || (dimensions.ySize == 0))
+		throw BE::Error::ParameterError("Resampled image would be "
+		    "empty (" + BE::Image::to_string(dimensions) + ")");
+
+	const uint16_t bitDepth = image.getBitDepth();
+	const uint32_t colorDepth = image.getColorDepth();
+	if (((bitDepth != 8) && (bitDepth != 16)) ||
+	    ((colorDepth % bitDepth) != 0) ||
+	    ((colorDepth / bitDepth) > 4))
+		throw BE::Error::NotImplemented("Resampling " +
+		    std::to_string(colorDepth) + "-bit pixels of " +
+		    std::to_string(bitDepth) + "-bit samples");
+	const uint8_t channels = static_cast<uint8_t>(colorDepth / bitDepth);
+	const uint8_t sampleSize = static_cast<uint8_t>(bitDepth / 8);
+	const float maximum = static_cast<float>((1u << bitDepth) - 1);
+
+	/* Raw pixels are the image data, so they need not be copied */
+	const BE::Memory::ByteView in = image.getDataView();
+	const uint32_t inWidth = image.getDimensions().xSize;
+	const uint32_t inHeight = image.getDimensions().ySize;
+	const uint64_t inRowSize = static_cast<uint64_t>(inWidth) * channels *
+	    sampleSize;
+	if (in.size() < inRowSize * inHeight)
+		throw BE::Error::DataError("Raw data is smaller than its "
+		    "dimensions");
+
+	const Coefficients h = computeCoefficients(inWidth, dimensions.xSize,
+	    filter);
+	const Coefficients v = computeCoefficients(inHeight, dimensions.ySize,
+	    filter);
+	const uint64_t outRowSize = static_cast<uint64_t>(dimensions.xSize) *
+	    channels * sampleSize;
+	BE::Memory::uint8Array out;
+	out.resize_uninitialized(outRowSize * dimensions.ySize);
+
+	forEachRowBlock(dimensions.ySize, threads,
+	    [&](uint32_t first, uint32_t last) {
+		/* Padding lets every output pixel read all taps */
+		std::vector<float> row((static_cast<uint64_t>(inWidth) +
+		    h.taps) * channels, 0.0f);
+		std::vector<const uint8_t *> rows(v.taps);
+		for (uint32_t y = first; y < last; y++) {
+			for (uint32_t k = 0; k < v.count[y]; k++)
+				rows[k] = in.data() + (static_cast<uint64_t>(
+				    v.start[y] + k) * inRowSize);
+			vertical(rows.data(), v.count[y], v.weights.data() +
+			    (static_cast<uint64_t>(y) * v.taps), sampleSize,
+			    static_cast<uint64_t>(inWidth) * channels,
+			    row.data());
+			horizontal(row.data(), channels, h, dimensions.xSize,
+			    out + (y * outRowSize), sampleSize, maximum);
+		}
+	});
+
+	return (BE::Image::Raw(out, dimensions, colorDepth, bitDepth,
+	    resolution, image.hasAlphaChannel()));
+}
+
+BiometricEvaluation::Image::Raw
+BiometricEvaluation::Image::resample(
+    const Raw &image,
+    const Resolution &target,
+    ResampleFilter filter,
+    uint32_t threads)
+{
+	const Resolution source = image.getResolution();
+	if ((source.units == Resolution::Units::NA) || !(source.xRes > 0) ||
+	    !(source.yRes > 0))
+		throw Error::ParameterError("Image has no resolution");
+	if ((target.units == Resolution::Units::NA) || !(target.xRes > 0) ||
+	    !(target.yRes > 0))
+		throw Error::ParameterError("Invalid target resolution (" +
+		    to_string(target) + ")");
+
+	const Resolution scaled = target.toUnits(source.units);
+	const Size dimensions(
+	    static_cast<uint32_t>(std::lround(image.getDimensions().xSize *
+	    (scaled.xRes / source.xRes))),
+	    static_cast<uint32_t>(std::lround(image.getDimensions().ySize *
+	    (scaled.yRes / source.yRes))));
+
+	return (resampleTo(image, dimensions, target, filter, threads));
+}
+
+BiometricEvaluation::Image::Raw
+BiometricEvaluation::Image::resample(
+    const Raw &image,
+    const Size &dimensions,
+    ResampleFilter filter,
+    uint32_t threads)
+{
+	Resolution resolution = image.getResolution();
+	if ((image.getDimensions().xSize != 0) &&
+	    (image.getDimensions().ySize != 0)) {
+		resolution.xRes *= static_cast<double>(dimensions.xSize) /
+		    image.getDimensions().xSize;
+		resolution.yRes *= static_cast<double>(dimensions.ySize) /
+		    image.getDimensions().ySize;
+	}
+
+	return (resampleTo(image, dimensions, resolution, filter, threads));
+}
@@ -0,0 +1,749 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#include <be_error.h>
+#include <be_error_exception.h>
+#include <be_image_encoder.h>
+#include <be_image_tiledraw.h>
+#include <be_io_utility.h>
+#include <be_memory_accounting.h>
+#include <be_system.h>
+
+namespace BE = BiometricEvaluation;
+
+/** Identifies TiledRaw data */
+static const char TILEDRAWMAGIC[8] = {'B', 'E', 'T', 'I', 'L', 'E', '0', '1'};
+/** Alignment of each tile */
+static const uint64_t TILEALIGNMENT = 64;
+
+struct BiometricEvaluation::Image::TiledRaw::Header
+{
+	char magic[8];
+	/** Image properties */
+	uint32_t width;
+	uint32_t height;
+	uint32_t colorDepth;
+	uint16_t bitDepth;
+	uint8_t hasAlphaChannel;
+	/** Resolution::Units */
+	uint8_t resolutionUnits;
+	double xResolution;
+	double yResolution;
+	/** Dimensions of all but edge tiles */
+	uint32_t tileWidth;
+	uint32_t tileHeight;
+	/** CompressionAlgorithm of each tile */
+	uint32_t tileCompression;
+	uint32_t reserved[3];
+};
+
+struct BiometricEvaluation::Image::TiledRaw::IndexEntry
+{
+	/** Offset of the tile from the start of the data */
+	uint64_t offset;
+	/** Size of the tile */
+	uint64_t length;
+};
+
+struct BiometricEvaluation::Image::TiledRaw::Mapping
+{
+	/** Map pathname read-only */
+	Mapping(
+	    const std::string &pathname);
+	~Mapping();
+
+	const uint8_t *data;
+	uint64_t size;
+};
+
+BiometricEvaluation::Image::TiledRaw::Mapping::Mapping(
+    const std::string &pathname) :
+    data(nullptr),
+    size(0)
+{
+	int fd = open(pathname.c_str(), O_RDONLY);
+	if (fd == -1)
+		throw BE::Error::FileError("Could not open " + pathname +
+		    ": " + BE::Error::errorStr());
+	struct stat sb;
+	if (fstat(fd, &sb) != 0) {
+		const std::string err = BE::Error::errorStr();
+		close(fd);
+		throw BE::Error::FileError("Could not stat " + pathname +
+		    ": " + err);
+	}
+	if (static_cast<uint64_t>(sb.st_size) < sizeof(Header)) {
+		close(fd);
+		throw BE::Error::DataError(pathname + " is not a TiledRaw "
+		    "image");
+	}
+	this->size = sb.st_size;
+
+	void *segment = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, fd,
+	    0);
+	close(fd);
+	if (segment == MAP_FAILED)
+		throw BE::Error::FileError("Could not map " + pathname + ": " +
+		    BE::Error::errorStr());
+	this->data = static_cast<const uint8_t*>(segment);
+}
+
+BiometricEvaluation::Image::TiledRaw::Mapping::~Mapping()
+{
+	munmap(const_cast<uint8_t*>(this->data), this->size);
+}
+
+/** @return value rounded up to the tile alignment */
+static inline uint64_t
+align(
+    const uint64_t value)
+{
+	return (((value + TILEALIGNMENT - 1) / TILEALIGNMENT) * TILEALIGNMENT);
+}
+
+/**
+ * @brief
+ * State shared by the threads of forEachIndex().
+ */
+struct IndexWork
+{
+	/** Number of indices */
+	uint64_t count;
+	/** Function called with each index */
+	const std::function<void(uint64_t)> *fn;
+	/** Next index to process */
+	std::atomic<uint64_t> next;
+	/** Guards error */
+	pthread_mutex_t mutex;
+	/** First exception thrown by fn */
+	std::exception_ptr error;
+};
+
+static void*
+indexWorker(
+    void *arg)
+{
+	IndexWork *state = static_cast<IndexWork*>(arg);
+	for (;;) {
+		const uint64_t i = state->next++;
+		if (i >= state->count)
+			break;
+		try {
+			(*state->fn)(i);
+		} catch (...) {
+			pthread_mutex_lock(&state->mutex);
+			if (state->error == nullptr)
+				state->error = std::current_exception();
+			pthread_mutex_unlock(&state->mutex);
+		}
+	}
+	return (nullptr);
+}
+
+/**
+ * @brief
+ * Call a function with each of a range of indices on a pool of threads.
+ *
+ * @param[in] count
+ *	Number of indices.
+ * @param[in] threads
+ *	Number of threads, or 0 for System::getCPUCount(). The calling
+ *	thread is one of them.
+ * @param[in] fn
+ *	Function called with each index in [0, count).
+ */
+static void
+forEachIndex(
+    uint64_t count,
+    uint32_t threads,
+    const std::function<void(uint64_t)> &fn)
+{
+	if (threads == 0)
+		threads = std::max<uint32_t>(BE::System::getCPUCount(), 1);
+	threads = static_cast<uint32_t>(std::min<uint64_t>(threads, count));
+
+	IndexWork state;
+	state.count = count;
+	state.fn = &fn;
+	state.next = 0;
+	pthread_mutex_init(&state.mutex, nullptr);
+
+	std::vector<pthread_t> workers;
+	for (uint32_t i = 1; i < threads; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, nullptr, indexWorker, &state) != 0)
+			break;
+		workers.push_back(thread);
+	}
+	indexWorker(&state);
+	for (const auto &thread : workers)
+		pthread_join(thread, nullptr);
+	pthread_mutex_destroy(&state.mutex);
+
+	if (state.error != nullptr)
+		std::rethrow_exception(state.error);
+}
+
+/** @throw Error::NotImplemented Pixels TiledRaw cannot store */
+static void
+checkPixelFormat(
+    uint32_t colorDepth,
+    uint16_t bitDepth)
+{
+	if (((bitDepth != 8) && (bitDepth != 16)) ||
+	    ((colorDepth % bitDepth) != 0) || (colorDepth == 0) ||
+	    ((colorDepth / bitDepth) > 4))
+		throw BE::Error::NotImplemented("Tiling " +
+		    std::to_string(colorDepth) + "-bit pixels of " +
+		    std::to_string(bitDepth) + "-bit samples");
+}
+
+BiometricEvaluation::Image::TiledRaw::TiledRaw(
+    const std::string &pathname) :
+    TiledRaw(std::make_shared<const Mapping>(pathname))
+{
+
+}
+
+BiometricEvaluation::Image::TiledRaw::TiledRaw(
+    const std::shared_ptr<const Mapping> &mapping) :
+    Image::Image(
+    Memory::ByteView(mapping->data, mapping->size),
+    CompressionAlgorithm::TiledRaw),
+    _mapping(mapping)
+{
+	this->readHeader();
+}
+
+BiometricEvaluation::Image::TiledRaw::TiledRaw(
+    const uint8_t *data,
+    const uint64_t size) :
+    BiometricEvaluation::Image::TiledRaw::TiledRaw(
+    Memory::ByteView(data, size))
+{
+	this->copyData();
+}
+
+BiometricEvaluation::Image::TiledRaw::TiledRaw(
+    const Memory::uint8Array &data) :
+    BiometricEvaluation::Image::TiledRaw::TiledRaw(data, data.size())
+{
+
+}
+
+BiometricEvaluation::Image::TiledRaw::TiledRaw(
+    const Memory::ByteView &data) :
+    Image::Image(
+    data,
+    CompressionAlgorithm::TiledRaw)
+{
+	this->readHeader();
+}
+
+void
+BiometricEvaluation::Image::TiledRaw::readHeader()
+{
+	const uint64_t size = this->getDataSize();
+	if (!isTiledRaw(this->getDataPointer(), size))
+		throw Error::DataError("Not a TiledRaw image");
+
+	Header header;
+	std::memcpy(&header, this->getDataPointer(), sizeof(header));
+	try {
+		checkPixelFormat(header.colorDepth, header.bitDepth);
+	} catch (const Error::NotImplemented &e) {
+		throw Error::DataError(e.whatString());
+	}
+	if ((header.width == 0) || (header.height == 0) ||
+	    (header.tileWidth == 0) || (header.tileHeight == 0) ||
+	    (header.resolutionUnits > static_cast<uint8_t>(
+	    Resolution::Units::PPCM)))
+		throw Error::DataError("Invalid TiledRaw header");
+
+	this->setDimensions(Size(header.width, header.height));
+	this->setColorDepth(header.colorDepth);
+	this->setBitDepth(header.bitDepth);
+	this->setHasAlphaChannel(header.hasAlphaChannel != 0);
+	this->setResolution(Resolution(header.xResolution,
+	    header.yResolution, static_cast<Resolution::Units>(
+	    header.resolutionUnits)));
+	this->_tileSize = Size(header.tileWidth, header.tileHeight);
+
+	/* Computed in 64 bits, as width + tileWidth can exceed 32 */
+	const uint64_t columns = (static_cast<uint64_t>(header.width) +
+	    header.tileWidth - 1) / header.tileWidth;
+	const uint64_t rows = (static_cast<uint64_t>(header.height) +
+	    header.tileHeight - 1) / header.tileHeight;
+	if ((columns == 0) || (rows == 0) ||
+	    ((columns * header.tileWidth) < header.width) ||
+	    (((columns - 1) * header.tileWidth) >= header.width) ||
+	    ((rows * header.tileHeight) < header.height) ||
+	    (((rows - 1) * header.tileHeight) >= header.height))
+		throw Error::DataError("Invalid TiledRaw tile grid");
+	this->_tileCount = Size(static_cast<uint32_t>(columns),
+	    static_cast<uint32_t>(rows));
+	this->_tileCompression = static_cast<CompressionAlgorithm>(
+	    header.tileCompression);
+
+	/* The index ends the data */
+	const uint64_t tiles = static_cast<uint64_t>(this->_tileCount.xSize) *
+	    this->_tileCount.ySize;
+	if (((size - sizeof(Header)) / sizeof(IndexEntry)) < tiles)
+		throw Error::DataError("TiledRaw index is truncated");
+	const uint64_t indexOffset = size - (tiles * sizeof(IndexEntry));
+	for (uint32_t row = 0; row < this->_tileCount.ySize; row++) {
+		for (uint32_t column = 0; column < this->_tileCount.xSize;
+		    column++) {
+			const IndexEntry entry = this->getIndexEntry(column,
+			    row);
+			const Size dimensions = this->getTileDimensions(column,
+			    row);
+			if ((entry.offset < sizeof(Header)) ||
+			    (entry.offset > indexOffset) ||
+			    (entry.length > (indexOffset - entry.offset)) ||
+			    ((this->_tileCompression ==
+			    CompressionAlgorithm::None) && (entry.length !=
+			    static_cast<uint64_t>(dimensions.xSize) *
+			    dimensions.ySize * (header.colorDepth / 8))))
+				throw Error::DataError("Invalid TiledRaw index "
+				    "entry for tile (" + std::to_string(column) +
+				    ", " + std::to_string(row) + ")");
+		}
+	}
+}
+
+BiometricEvaluation::Image::TiledRaw::IndexEntry
+BiometricEvaluation::Image::TiledRaw::getIndexEntry(
+    uint32_t column,
+    uint32_t row)
+    const
+{
+	if ((column >= this->_tileCount.xSize) ||
+	    (row >= this->_tileCount.ySize))
+		throw Error::ParameterError("No tile (" +
+		    std::to_string(column) + ", " + std::to_string(row) + ")");
+
+	const uint64_t tiles = static_cast<uint64_t>(this->_tileCount.xSize) *
+	    this->_tileCount.ySize;
+	const uint64_t tile = (static_cast<uint64_t>(row) *
+	    this->_tileCount.xSize) + column;
+
+	/* Data need not be aligned, so entries are copied out */
+	IndexEntry entry;
+	std::memcpy(&entry, this->getDataPointer() + this->getDataSize() -
+	    ((tiles - tile) * sizeof(IndexEntry)), sizeof(entry));
+	return (entry);
+}
+
+BiometricEvaluation::Image::Size
+BiometricEvaluation::Image::TiledRaw::getTileDimensions(
+    uint32_t column,
+    uint32_t row)
+    const
+{
+	const Size dimensions = this->getDimensions();
+	return (Size(
+	    std::min(this->_tileSize.xSize, dimensions.xSize -
+	    (column * this->_tileSize.xSize)),
+	    std::min(this->_tileSize.ySize, dimensions.ySize -
+	    (row * this->_tileSize.ySize))));
+}
+
+BiometricEvaluation::Image::Size
+BiometricEvaluation::Image::TiledRaw::getTileSize()
+    const
+{
+	return (this->_tileSize);
+}
+
+BiometricEvaluation::Image::Size
+BiometricEvaluation::Image::TiledRaw::getTileCount()
+    const
+{
+	return (this->_tileCount);
+}
+
+BiometricEvaluation::Image::CompressionAlgorithm
+BiometricEvaluation::Image::TiledRaw::getTileCompressionAlgorithm()
+    const
+{
+	return (this->_tileCompression);
+}
+
+BiometricEvaluation::Memory::ByteView
+BiometricEvaluation::Image::TiledRaw::readTile(
+    uint32_t column,
+    uint32_t row,
+    Memory::uint8Array &buffer)
+    const
+{
+	const IndexEntry entry = this->getIndexEntry(column, row);
+	const Memory::ByteView encoded(this->getDataPointer() + entry.offset,
+	    entry.length);
+	if (this->_tileCompression == CompressionAlgorithm::None)
+		return (encoded);
+
+	const Size dimensions = this->getTileDimensions(column, row);
+	const std::shared_ptr<Image> tile = Image::openImage(encoded);
+	if ((tile->getDimensions() != dimensions) ||
+	    (tile->getColorDepth() != this->getColorDepth()) ||
+	    (tile->getBitDepth() != this->getBitDepth()))
+		throw Error::DataError("Tile (" + std::to_string(column) +
+		    ", " + std::to_string(row) + ") does not match the image");
+	buffer = tile->getRawData();
+	if (buffer.size() != static_cast<uint64_t>(dimensions.xSize) *
+	    dimensions.ySize * (this->getColorDepth() / 8))
+		throw Error::DataError("Tile (" + std::to_string(column) +
+		    ", " + std::to_string(row) + ") does not match the image");
+	return (Memory::ByteView(buffer));
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::TiledRaw::getTile(
+    uint32_t column,
+    uint32_t row)
+    const
+{
+	if ((column >= this->_tileCount.xSize) ||
+	    (row >= this->_tileCount.ySize))
+		throw Error::ParameterError("No tile (" +
+		    std::to_string(column) + ", " + std::to_string(row) + ")");
+
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	Memory::uint8Array buffer;
+	const Memory::ByteView pixels = this->readTile(column, row, buffer);
+	if (pixels.data() != buffer)
+		buffer.copy(pixels.data(), pixels.size());
+	return (buffer);
+}
+
+void
+BiometricEvaluation::Image::TiledRaw::forEachTile(
+    const std::function<void(const Tile&)> &fn,
+    uint32_t threads)
+    const
+{
+	const uint32_t columns = this->_tileCount.xSize;
+	forEachIndex(static_cast<uint64_t>(columns) * this->_tileCount.ySize,
+	    threads, [&](uint64_t i) {
+		Tile tile;
+		tile.column = static_cast<uint32_t>(i % columns);
+		tile.row = static_cast<uint32_t>(i / columns);
+		tile.origin = Coordinate(tile.column * this->_tileSize.xSize,
+		    tile.row * this->_tileSize.ySize);
+		tile.dimensions = this->getTileDimensions(tile.column,
+		    tile.row);
+
+		Memory::uint8Array buffer;
+		tile.pixels = this->readTile(tile.column, tile.row, buffer);
+		fn(tile);
+	});
+}
+
+void
+BiometricEvaluation::Image::TiledRaw::copyRegion(
+    const Coordinate &origin,
+    const Size &size,
+    uint8_t *dst,
+    uint64_t stride)
+    const
+{
+	const uint64_t pixelSize = this->getColorDepth() / 8;
+	const uint32_t firstColumn = origin.x / this->_tileSize.xSize;
+	const uint32_t lastColumn = (origin.x + size.xSize - 1) /
+	    this->_tileSize.xSize;
+	const uint32_t firstRow = origin.y / this->_tileSize.ySize;
+	const uint32_t lastRow = (origin.y + size.ySize - 1) /
+	    this->_tileSize.ySize;
+
+	/* Only one tile is decoded at a time */
+	Memory::uint8Array buffer;
+	for (uint32_t row = firstRow; row <= lastRow; row++) {
+		for (uint32_t column = firstColumn; column <= lastColumn;
+		    column++) {
+			const Memory::ByteView pixels = this->readTile(column,
+			    row, buffer);
+			const Size dimensions = this->getTileDimensions(column,
+			    row);
+			const Coordinate tileOrigin(column *
+			    this->_tileSize.xSize, row * this->_tileSize.ySize);
+
+			const uint32_t x0 = std::max(origin.x, tileOrigin.x);
+			const uint32_t x1 = std::min(origin.x + size.xSize,
+			    tileOrigin.x + dimensions.xSize);
+			const uint32_t y0 = std::max(origin.y, tileOrigin.y);
+			const uint32_t y1 = std::min(origin.y + size.ySize,
+			    tileOrigin.y + dimensions.ySize);
+			const uint64_t tileRowSize = dimensions.xSize *
+			    pixelSize;
+			for (uint32_t y = y0; y < y1; y++)
+				std::memcpy(dst + ((y - origin.y) * stride) +
+				    ((x0 - origin.x) * pixelSize),
+				    pixels.data() + ((y - tileOrigin.y) *
+				    tileRowSize) + ((x0 - tileOrigin.x) *
+				    pixelSize), (x1 - x0) * pixelSize);
+		}
+	}
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::TiledRaw::decodeRawData()
+    const
+{
+	const uint64_t rowSize = this->getRawRowSize();
+	Memory::uint8Array rawData;
+	rawData.resize_uninitialized(rowSize * this->getDimensions().ySize);
+	this->copyRegion(Coordinate(0, 0), this->getDimensions(), rawData,
+	    rowSize);
+	return (rawData);
+}
+
+void
+BiometricEvaluation::Image::TiledRaw::decodeRawInto(
+    uint8_t *dst,
+    uint64_t stride)
+    const
+{
+	this->copyRegion(Coordinate(0, 0), this->getDimensions(), dst,
+	    stride);
+}
+
+bool
+BiometricEvaluation::Image::TiledRaw::decodesRegions()
+    const
+{
+	return (true);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::TiledRaw::decodeRawRegion(
+    const Coordinate &origin,
+    const Size &size)
+    const
+{
+	const uint64_t rowSize = static_cast<uint64_t>(size.xSize) *
+	    (this->getColorDepth() / 8);
+	Memory::uint8Array rawData;
+	rawData.resize_uninitialized(rowSize * size.ySize);
+	this->copyRegion(origin, size, rawData, rowSize);
+	return (rawData);
+}
+
+void
+BiometricEvaluation::Image::TiledRaw::write(
+    const Image &image,
+    const Size &tileSize,
+    CompressionAlgorithm tileCompression,
+    uint32_t threads,
+    const std::function<void(const Memory::ByteView&)> &write)
+{
+	const Size dimensions = image.getDimensions();
+	if ((tileSize.xSize == 0) || (tileSize.ySize == 0))
+		throw Error::ParameterError("Tile size is empty");
+	if ((dimensions.xSize == 0) || (dimensions.ySize == 0))
+		throw Error::ParameterError("Image is empty");
+	checkPixelFormat(image.getColorDepth(), image.getBitDepth());
+
+	std::shared_ptr<Encoder> encoder;
+	if (tileCompression != CompressionAlgorithm::None)
+		encoder = Encoder::openEncoder(tileCompression);
+
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, TILEDRAWMAGIC, sizeof(header.magic));
+	header.width = dimensions.xSize;
+	header.height = dimensions.ySize;
+	header.colorDepth = image.getColorDepth();
+	header.bitDepth = image.getBitDepth();
+	header.hasAlphaChannel = image.hasAlphaChannel() ? 1 : 0;
+	const Resolution resolution = image.getResolution();
+	header.resolutionUnits = static_cast<uint8_t>(resolution.units);
+	header.xResolution = resolution.xRes;
+	header.yResolution = resolution.yRes;
+	header.tileWidth = tileSize.xSize;
+	header.tileHeight = tileSize.ySize;
+	header.tileCompression = static_cast<uint32_t>(tileCompression);
+	write(Memory::ByteView(reinterpret_cast<const uint8_t*>(&header),
+	    sizeof(header)));
+	uint64_t offset = sizeof(header);
+
+	const uint32_t columns = (dimensions.xSize + tileSize.xSize - 1) /
+	    tileSize.xSize;
+	const uint32_t rows = (dimensions.ySize + tileSize.ySize - 1) /
+	    tileSize.ySize;
+	const uint64_t pixelSize = image.getColorDepth() / 8;
+	const uint8_t padding[TILEALIGNMENT]{};
+	std::vector<IndexEntry> index;
+	index.reserve(static_cast<uint64_t>(columns) * rows);
+
+	const uint64_t bandRowSize = dimensions.xSize * pixelSize;
+
+	/*
+	 * Codecs that cannot decode part of an image would decode all of
+	 * it for every row of tiles, so decode it once instead.
+	 */
+	Memory::uint8Array decoded;
+	if (!image.decodesRegions()) {
+		decoded = image.getRawData();
+		if (decoded.size() < bandRowSize * dimensions.ySize)
+			throw Error::DataError("Raw data is smaller than its "
+			    "dimensions");
+	}
+
+	/* Only one row of tiles is held at a time */
+	std::vector<Memory::uint8Array> tiles(columns);
+	for (uint32_t row = 0; row < rows; row++) {
+		const uint32_t y = row * tileSize.ySize;
+		const uint32_t height = std::min(tileSize.ySize,
+		    dimensions.ySize - y);
+		Memory::uint8Array region;
+		const uint8_t *band;
+		if (decoded.size() != 0) {
+			band = decoded + (y * bandRowSize);
+		} else {
+			region = image.getRawData(Coordinate(0, y),
+			    Size(dimensions.xSize, height));
+			if (region.size() < bandRowSize * height)
+				throw Error::DataError("Raw data is smaller "
+				    "than its dimensions");
+			band = region;
+		}
+
+		forEachIndex(columns, threads, [&](uint64_t column) {
+			const uint32_t x = static_cast<uint32_t>(column) *
+			    tileSize.xSize;
+			const uint32_t width = std::min(tileSize.xSize,
+			    dimensions.xSize - x);
+			const uint64_t tileRowSize = width * pixelSize;
+			Memory::uint8Array pixels;
+			pixels.resize_uninitialized(tileRowSize * height);
+			for (uint32_t r = 0; r < height; r++)
+				std::memcpy(pixels + (r * tileRowSize), band +
+				    (r * bandRowSize) + (x * pixelSize),
+				    tileRowSize);
+
+			if (encoder == nullptr) {
+				tiles[column] = std::move(pixels);
+				return;
+			}
+			Properties properties;
+			properties.compressionAlgorithm = tileCompression;
+			properties.dimensions = Size(width, height);
+			properties.colorDepth = image.getColorDepth();
+			properties.bitDepth = image.getBitDepth();
+			properties.resolution = resolution;
+			properties.hasAlphaChannel = image.hasAlphaChannel();
+			tiles[column] = encoder->encode(pixels, properties);
+		});
+
+		for (uint32_t column = 0; column < columns; column++) {
+			write(Memory::ByteView(padding, align(offset) -
+			    offset));
+			offset = align(offset);
+			index.push_back({offset, tiles[column].size()});
+			write(tiles[column]);
+			offset += tiles[column].size();
+		}
+	}
+
+	write(Memory::ByteView(reinterpret_cast<const uint8_t*>(
+	    index.data()), index.size() * sizeof(IndexEntry)));
+}
+
+void
+BiometricEvaluation::Image::TiledRaw::create(
+    const std::string &pathname,
+    const Image &image,
+    const Size &tileSize,
+    CompressionAlgorithm tileCompression,
+    uint32_t threads)
+{
+	if (IO::Utility::fileExists(pathname))
+		throw Error::ObjectExists(pathname);
+
+	int fd = open(pathname.c_str(), O_WRONLY | O_CREAT | O_EXCL,
+	    S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fd == -1) {
+		if (errno == EEXIST)
+			throw Error::ObjectExists(pathname);
+		throw Error::FileError("Could not create " + pathname + ": " +
+		    Error::errorStr());
+	}
+
+	try {
+		TiledRaw::write(image, tileSize, tileCompression, threads,
+		    [&](const Memory::ByteView &data) {
+			uint64_t written = 0;
+			while (written < data.size()) {
+				const ssize_t rv = ::write(fd, data.data() +
+				    written, data.size() - written);
+				if (rv == -1) {
+					if (errno == EINTR)
+						continue;
+					throw Error::FileError("Could not "
+					    "write " + pathname + ": " +
+					    Error::errorStr());
+				}
+				written += rv;
+			}
+		});
+	} catch (...) {
+		close(fd);
+		unlink(pathname.c_str());
+		throw;
+	}
+	if (close(fd) != 0) {
+		const std::string err = Error::errorStr();
+		unlink(pathname.c_str());
+		throw Error::FileError("Could not write " + pathname + ": " +
+		    err);
+	}
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::TiledRaw::encode(
+    const Image &image,
+    const Size &tileSize,
+    CompressionAlgorithm tileCompression,
+    uint32_t threads)
+{
+	Memory::uint8Array data;
+	TiledRaw::write(image, tileSize, tileCompression, threads,
+	    [&](const Memory::ByteView &piece) {
+		data.append(piece.data(), piece.size());
+	});
+	return (data);
+}
+
+bool
+BiometricEvaluation::Image::TiledRaw::isTiledRaw(
+    const uint8_t *data,
+    uint64_t size)
+{
+	return ((size >= sizeof(Header)) && (std::memcmp(data, TILEDRAWMAGIC,
+	    sizeof(TILEDRAWMAGIC)) == 0));
+}
@@ -7,8 +7,27 @@
  * its use by other parties, and makes no guarantees, expressed or implied,
  * about its quality, reliability, or any other characteristic.
  */
- 
+
+/*
+ * As in be_image_conversion.cpp, x86-64 kernels are compiled for their
+ * instruction sets with target attributes and chosen at run time.
+ */
+#if defined __x86_64__ && defined __GNUC__
+#define BE_IMAGE_WSQ_X86
+#include <immintrin.h>
+#endif
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <utility>
+#include <vector>
 
 extern "C" {
 	#include <dataio.h>
@@ -16,18 +35,1465 @@ extern "C" {
 	int debug = 0;	/* Required by libwsq */
 }
 
+#include <be_error_exception.h>
+#include <be_image_conversion.h>
 #include <be_image_wsq.h>
+#include <be_memory_accounting.h>
+#include <be_system.h>
+
+namespace BE = BiometricEvaluation;
+
+/*
+ * The optimized decoder follows wsq_decode_mem_reduced(), reading
+ * markers and tables with libwsq, and matches its pixels exactly:
+ *
+ *  - Huffman codes are looked up in a table built from the same
+ *    maxcode/mincode/valptr arrays that libwsq searches one bit at a time.
+ *    As in huffman_decode_data_mem(), a code cut off by a marker is
+ *    discarded. Data that libwsq would decode into memory it never
+ *    initialized or past the end of its buffer (too few or too many
+ *    coefficients, or a code longer than any in the table) throws
+ *    Error::DataError instead, since libwsq's pixels are then undefined.
+ *  - join_lets() computes each output of a row or column of a subband
+ *    with multiply-adds whose inputs, coefficients, and order depend only
+ *    on the length of the line. They are recorded once per line length by
+ *    following join_lets() step for step, then replayed on many lines at
+ *    once with SIMD, without fused multiply-adds.
+ */
+
+/******************************************************************************/
+/* Tables.                                                                    */
+/******************************************************************************/
+
+/** Tables and trees libwsq keeps in globals, owned by one decode */
+struct WSQTables
+{
+	DTT_TABLE dtt;
+	DQT_TABLE dqt;
+	DHT_TABLE dht[MAX_DHT_TABLES];
+	FRM_HEADER_WSQ frame;
+	W_TREE wTree[W_TREELEN];
+	Q_TREE qTree[Q_TREELEN];
+
+	WSQTables()
+	{
+		std::memset(&this->dtt, 0, sizeof(this->dtt));
+		std::memset(&this->dqt, 0, sizeof(this->dqt));
+		std::memset(this->dht, 0, sizeof(this->dht));
+		std::memset(&this->frame, 0, sizeof(this->frame));
+	}
+
+	~WSQTables()
+	{
+		std::free(this->dtt.lofilt);
+		std::free(this->dtt.hifilt);
+	}
+
+	WSQTables(const WSQTables&) = delete;
+	WSQTables& operator=(const WSQTables&) = delete;
+};
+
+/** Throw if a libwsq function failed */
+static void
+checkWSQ(
+    int rv,
+    const std::string &action)
+{
+	if (rv != 0)
+		throw BE::Error::DataError("libwsq could not " + action +
+		    " (" + std::to_string(rv) + ")");
+}
+
+/**
+ * Throw if a DHT segment at cbufptr defines a table ID that would index
+ * past WSQTables::dht, which getc_huffman_table_wsq() does not check.
+ * Other errors are left for libwsq to report.
+ */
+static void
+checkHuffmanTableIDs(
+    const unsigned char *cbufptr,
+    const unsigned char *ebufptr)
+{
+	if (ebufptr - cbufptr < 2)
+		return;
+	int bytesLeft = ((cbufptr[0] << 8) | cbufptr[1]) - 2;
+	cbufptr += 2;
+
+	/* Table ID, then 16 counts, then as many values as counted */
+	while (bytesLeft > 0) {
+		if (ebufptr - cbufptr < 1 + MAX_HUFFBITS)
+			return;
+		const unsigned char id = cbufptr[0];
+		if (id >= MAX_DHT_TABLES)
+			throw BE::Error::DataError("WSQ Huffman table ID " +
+			    std::to_string(id) + " is out of range");
+		int values = 0;
+		for (int i = 1; i <= MAX_HUFFBITS; i++)
+			values += cbufptr[i];
+		if (values > MAX_HUFFCOUNTS_WSQ + 1)
+			return;
+		cbufptr += 1 + MAX_HUFFBITS;
+		if (ebufptr - cbufptr < values)
+			return;
+		cbufptr += values;
+		bytesLeft -= 1 + MAX_HUFFBITS + values;
+	}
+}
+
+/**
+ * Throw if the DTT segment at cbufptr has an empty filter, which
+ * getc_transform_table() writes before, or ends within its filters,
+ * after which getc_transform_table() frees the filters without clearing
+ * the pointers to them. Other errors are left for libwsq to report.
+ */
+static void
+checkTransformTable(
+    const unsigned char *cbufptr,
+    const unsigned char *ebufptr)
+{
+	/* Segment length, then the high and low pass filter lengths */
+	if (ebufptr - cbufptr < 4)
+		return;
+	const int hisz = cbufptr[2];
+	const int losz = cbufptr[3];
+	if ((hisz == 0) || (losz == 0))
+		throw BE::Error::DataError("WSQ transform table has an empty "
+		    "filter");
+
+	/* Sign, scale, and value of half of each symmetric filter */
+	if ((ebufptr - cbufptr) < 4 + (6 * (((hisz + 1) / 2) +
+	    ((losz + 1) / 2))))
+		throw BE::Error::DataError("WSQ transform table is "
+		    "truncated");
+}
+
+/** Read tables until a marker other than a table or comment */
+static void
+readTables(
+    WSQTables &tables,
+    unsigned short &marker,
+    const int markers,
+    const unsigned short until,
+    unsigned char **cbufptr,
+    unsigned char *ebufptr)
+{
+	while (marker != until) {
+		if (marker == DHT_WSQ)
+			checkHuffmanTableIDs(*cbufptr, ebufptr);
+		else if (marker == DTT_WSQ)
+			checkTransformTable(*cbufptr, ebufptr);
+		checkWSQ(getc_table_wsq(marker, &tables.dtt, &tables.dqt,
+		    tables.dht, cbufptr, ebufptr), "read table");
+		checkWSQ(getc_marker_wsq(&marker, markers, cbufptr, ebufptr),
+		    "read marker");
+	}
+}
+
+/******************************************************************************/
+/* Huffman decoding.                                                          */
+/******************************************************************************/
+
+/** Bits of Huffman code looked up at once */
+static const int LookaheadBits = 10;
+
+/** Decoding tables of one Huffman table */
+struct HuffmanTable
+{
+	int maxcode[MAX_HUFFBITS + 1];
+	int mincode[MAX_HUFFBITS + 1];
+	int valptr[MAX_HUFFBITS + 1];
+	const unsigned char *values;
+	/**
+	 * Symbol of the code starting each LookaheadBits bits, with
+	 * the length of the code above bit 8, or 0 if the code is
+	 * longer.
+	 */
+	uint16_t lookahead[1 << LookaheadBits];
+};
+
+static void
+buildHuffmanTable(
+    DHT_TABLE &dht,
+    HuffmanTable &table)
+{
+	HUFFCODE *codes = nullptr;
+	int lastSize;
+	checkWSQ(build_huffsizes(&codes, &lastSize, dht.huffbits,
+	    MAX_HUFFCOUNTS_WSQ), "build Huffman table");
+	build_huffcodes(codes);
+	gen_decode_table(codes, table.maxcode, table.mincode, table.valptr,
+	    dht.huffbits);
+	std::free(codes);
+	table.values = dht.huffvalues;
+
+	/* Search as decode_data_mem() does, one bit at a time */
+	for (uint32_t bits = 0; bits < (1u << LookaheadBits); bits++) {
+		table.lookahead[bits] = 0;
+		int length = 1;
+		int code = static_cast<int>(bits >> (LookaheadBits - 1));
+		while ((code > table.maxcode[length]) &&
+		    (length < LookaheadBits)) {
+			length++;
+			code = (code << 1) | static_cast<int>((bits >>
+			    (LookaheadBits - length)) & 1);
+		}
+		if (code > table.maxcode[length])
+			continue;
+		const int index = table.valptr[length] + code -
+		    table.mincode[length];
+		if ((index >= 0) && (index <= MAX_HUFFCOUNTS_WSQ))
+			table.lookahead[bits] = static_cast<uint16_t>(
+			    table.values[index] | (length << 8));
+	}
+}
+
+/** Reads entropy-coded data, removing stuffed zero bytes */
+struct BitReader
+{
+	/** Next byte to read */
+	const unsigned char *next;
+	/** End of the data */
+	const unsigned char *end;
+	/** Unread bits, first bit most significant */
+	uint64_t bits;
+	/** Number of unread bits */
+	uint32_t count;
+
+	BitReader(
+	    const unsigned char *begin,
+	    const unsigned char *end) :
+	    next(begin),
+	    end(end),
+	    bits(0),
+	    count(0)
+	{
+
+	}
+
+	/** Read bytes until 57 bits are unread, or a marker or the end */
+	void
+	fill()
+	{
+		while (this->count <= 56) {
+			if (this->next == this->end)
+				return;
+			const unsigned char byte = *this->next;
+			if (byte == 0xFF) {
+				/* Within data, 0xFF is followed by a zero */
+				if ((this->next + 1 == this->end) ||
+				    (this->next[1] != 0x00))
+					return;
+				this->next += 2;
+			} else
+				this->next++;
+			this->bits |= static_cast<uint64_t>(byte) <<
+			    (56 - this->count);
+			this->count += 8;
+		}
+	}
+
+	void
+	consume(
+	    uint32_t n)
+	{
+		this->bits <<= n;
+		this->count -= n;
+	}
+
+	/** @return The next n (at most 16) bits */
+	uint16_t
+	read(
+	    uint32_t n)
+	{
+		if (this->count < n) {
+			this->fill();
+			if (this->count < n)
+				throw BE::Error::DataError("WSQ data ends "
+				    "within a coefficient");
+		}
+		const uint16_t value = static_cast<uint16_t>(this->bits >>
+		    (64 - n));
+		this->consume(n);
+		return (value);
+	}
+
+	/** @return Whether the unread bytes start with a marker */
+	bool
+	atMarker()
+	    const
+	{
+		return ((this->next + 1 < this->end) &&
+		    (this->next[0] == 0xFF) && (this->next[1] != 0x00));
+	}
+};
+
+/**
+ * @return
+ *	The next Huffman symbol, or -1 if a marker comes first, which, as
+ *	in getc_nextbits_wsq(), discards the bits of an unfinished code.
+ */
+static int
+decodeSymbol(
+    BitReader &reader,
+    const HuffmanTable &table)
+{
+	if (reader.count < MAX_HUFFBITS)
+		reader.fill();
+	const uint16_t entry = table.lookahead[reader.bits >>
+	    (64 - LookaheadBits)];
+	const uint32_t entryLength = entry >> 8;
+	if ((entryLength != 0) && (entryLength <= reader.count)) {
+		reader.consume(entryLength);
+		return (entry & 0xFF);
+	}
+
+	/* Long codes, and codes cut off by a marker */
+	int code = 0;
+	for (uint32_t length = 1; ; length++) {
+		if (length > reader.count) {
+			if (!reader.atMarker())
+				throw BE::Error::DataError("WSQ data ends "
+				    "within a Huffman code");
+			return (-1);
+		}
+		if (length > MAX_HUFFBITS)
+			throw BE::Error::DataError("Invalid WSQ Huffman code");
+		code = (code << 1) | static_cast<int>((reader.bits >>
+		    (64 - length)) & 1);
+		if (code <= table.maxcode[length]) {
+			const int index = table.valptr[length] + code -
+			    table.mincode[length];
+			if ((index < 0) || (index > MAX_HUFFCOUNTS_WSQ))
+				throw BE::Error::DataError("Invalid WSQ "
+				    "Huffman code");
+			reader.consume(length);
+			return (table.values[index]);
+		}
+	}
+}
+
+/**
+ * @brief
+ * Decode the quantized coefficients of every block, as
+ * huffman_decode_data_mem().
+ *
+ * @param[in] tables
+ *	Tables read so far, updated by tables between blocks.
+ * @param[in,out] cbufptr
+ *	Start of the first block's marker, then the end of the data read.
+ * @param[in] ebufptr
+ *	End of the WSQ data.
+ * @param[out] qdata
+ *	Zeroed coefficients, one per pixel of the image.
+ *
+ * @throw Error::DataError
+ *	Invalid WSQ data, including data that does not code exactly one
+ *	coefficient per pixel of the quantized subbands.
+ */
+static void
+decodeBlocks(
+    WSQTables &tables,
+    unsigned char **cbufptr,
+    unsigned char *ebufptr,
+    short *qdata)
+{
+	unsigned short marker;
+	checkWSQ(getc_marker_wsq(&marker, TBLS_N_SOB, cbufptr, ebufptr),
+	    "read marker");
+
+	int blk = 0;
+	int64_t ipc = 0;
+	int64_t ipcMax = static_cast<int64_t>(tables.frame.width) *
+	    tables.frame.height;
+	bool ipcQuantized = false;
+	short *ip = qdata;
+	HuffmanTable table;
+	while (marker != EOI_WSQ) {
+		blk++;
+		readTables(tables, marker, TBLS_N_SOB, SOB_WSQ, cbufptr,
+		    ebufptr);
+		/* Subbands without quantization are not coded */
+		if (tables.dqt.dqt_def && !ipcQuantized) {
+			for (int n = 0; n < 64; n++)
+				if (tables.dqt.q_bin[n] == 0.0)
+					ipcMax -= tables.qTree[n].lenx *
+					    tables.qTree[n].leny;
+			ipcQuantized = true;
+		}
+
+		unsigned char id;
+		checkWSQ(getc_block_header(&id, cbufptr, ebufptr),
+		    "read block header");
+		if ((id >= MAX_DHT_TABLES) || (tables.dht[id].tabdef != 1))
+			throw BE::Error::DataError("WSQ Huffman table " +
+			    std::to_string(id) + " undefined");
+		buildHuffmanTable(tables.dht[id], table);
+
+		BitReader reader(*cbufptr, ebufptr);
+		for (;;) {
+			const int symbol = decodeSymbol(reader, table);
+			if (symbol == -1)
+				break;
+			if (ipc > ipcMax)
+				throw BE::Error::DataError("Decoded WSQ data "
+				    "extends past image");
+
+			/* Runs are of zeros, which qdata already holds */
+			uint32_t run;
+			if ((symbol > 0) && (symbol <= 100))
+				run = symbol;
+			else if (symbol == 105)
+				run = reader.read(8);
+			else if (symbol == 106)
+				run = reader.read(16);
+			else {
+				/* libwsq would write past its buffer */
+				if (ipc == ipcMax)
+					throw BE::Error::DataError("Decoded "
+					    "WSQ data extends past image");
+				if ((symbol > 106) && (symbol < 0xFF))
+					*ip = static_cast<short>(symbol - 180);
+				else if (symbol == 101)
+					*ip = static_cast<short>(reader.read(8));
+				else if (symbol == 102)
+					*ip = static_cast<short>(
+					    -reader.read(8));
+				else if (symbol == 103)
+					*ip = static_cast<short>(
+					    reader.read(16));
+				else if (symbol == 104)
+					*ip = static_cast<short>(
+					    -reader.read(16));
+				else
+					throw BE::Error::DataError("Invalid "
+					    "WSQ Huffman symbol (" +
+					    std::to_string(symbol) + ")");
+				ip++;
+				ipc++;
+				continue;
+			}
+			ipc += run;
+			if (ipc > ipcMax)
+				throw BE::Error::DataError("Decoded WSQ data "
+				    "extends past image");
+			ip += run;
+		}
+
+		/* Consume the marker, as getc_nextbits_wsq() */
+		marker = static_cast<unsigned short>((reader.next[0] << 8) |
+		    reader.next[1]);
+		*cbufptr = const_cast<unsigned char*>(reader.next) + 2;
+		while ((marker == COM_WSQ) && (blk == 3)) {
+			checkWSQ(getc_table_wsq(marker, &tables.dtt,
+			    &tables.dqt, tables.dht, cbufptr, ebufptr),
+			    "read comment");
+			checkWSQ(getc_marker_wsq(&marker, ANY_WSQ, cbufptr,
+			    ebufptr), "read marker");
+		}
+	}
+
+	/* libwsq would leave the remaining coefficients uninitialized */
+	if (ipc != ipcMax)
+		throw BE::Error::DataError("WSQ data ends before the last "
+		    "coefficient");
+}
+
+/** Dequantize coefficients, as unquantize() */
+static void
+unquantize(
+    const WSQTables &tables,
+    const short *sip,
+    float *fip,
+    const int width)
+{
+	if (tables.dqt.dqt_def != 1)
+		throw BE::Error::DataError("WSQ quantization table undefined");
+
+	const short *sptr = sip;
+	const float C = tables.dqt.bin_center;
+	for (int cnt = 0; cnt < NUM_SUBBANDS; cnt++) {
+		if (tables.dqt.q_bin[cnt] == 0.0)
+			continue;
+		const Q_TREE &q = tables.qTree[cnt];
+		float *fptr = fip + (q.y * width) + q.x;
+		for (int row = 0; row < q.leny; row++,
+		    fptr += width - q.lenx) {
+			for (int col = 0; col < q.lenx; col++) {
+				if (*sptr == 0)
+					*fptr = 0.0;
+				else if (*sptr > 0)
+					*fptr = (tables.dqt.q_bin[cnt] *
+					    (static_cast<float>(*sptr) - C)) +
+					    (tables.dqt.z_bin[cnt] / 2.0);
+				else
+					*fptr = (tables.dqt.q_bin[cnt] *
+					    (static_cast<float>(*sptr) + C)) -
+					    (tables.dqt.z_bin[cnt] / 2.0);
+				fptr++;
+				sptr++;
+			}
+		}
+	}
+}
+
+/******************************************************************************/
+/* Wavelet reconstruction.                                                    */
+/******************************************************************************/
+
+/**
+ * @brief
+ * The multiply-adds join_lets() applies to each line of a subband.
+ * @details
+ * Output i of a line starts as 0 when zero[i] is set, otherwise as the
+ * product of input index[first[i]] and coefficient[first[i]]. The
+ * products of the remaining terms, to first[i + 1], are then added in
+ * order.
+ */
+struct Synthesis
+{
+	std::vector<uint32_t> first;
+	std::vector<uint8_t> zero;
+	std::vector<uint32_t> index;
+	std::vector<float> coefficient;
+};
+
+/**
+ * @brief
+ * Record the multiply-adds of join_lets() on a line.
+ * @details
+ * The control flow, variable names, and pointer arithmetic (as indices)
+ * are those of join_lets(). Lines that join_lets() reads or writes
+ * outside of, or that it adds to before assigning, are not recorded.
+ *
+ * @param[in] len2
+ *	Length of the line.
+ * @param[in] hi
+ *	Highpass filter.
+ * @param[in] hsz
+ *	Length of hi.
+ * @param[in] lo
+ *	Lowpass filter.
+ * @param[in] lsz
+ *	Length of lo.
+ * @param[in] inv
+ *	Whether the highpass half of the line comes first.
+ * @param[out] synthesis
+ *	The multiply-adds.
+ *
+ * @return
+ *	Whether the line was recorded.
+ */
+static bool
+recordSynthesis(
+    const int len2,
+    const float *hi,
+    const int hsz,
+    const float *lo,
+    const int lsz,
+    const int inv,
+    Synthesis &synthesis)
+{
+	if (len2 < 2)
+		return (false);
+
+	/* Terms of each output, and whether it is unset, zero, or assigned */
+	std::vector<std::vector<std::pair<int, float>>> terms(len2);
+	enum class State { Unset, Zero, Assigned };
+	std::vector<State> state(len2, State::Unset);
+	bool valid = true;
+	const auto inLine = [&](int px) { return ((px >= 0) && (px < len2)); };
+	const auto assign = [&](int img, int px, float c) {
+		if (!inLine(img) || !inLine(px)) {
+			valid = false;
+			return;
+		}
+		terms[img].assign(1, std::make_pair(px, c));
+		state[img] = State::Assigned;
+	};
+	const auto add = [&](int img, int px, float c) {
+		if (!inLine(img) || !inLine(px) ||
+		    (state[img] == State::Unset)) {
+			valid = false;
+			return;
+		}
+		terms[img].emplace_back(px, c);
+	};
+	/* Multiplying by sfac is exact, so it may be folded into hi[i] */
+	const auto addHigh = [&](int img, int px, float h, float sfac) {
+		if ((sfac != 1.0) && (sfac != -1.0) && (sfac != 0.0))
+			valid = false;
+		add(img, px, h * sfac);
+	};
+
+	int lp0, lp1, hp0, hp1;
+	int lopass, hipass;
+	int limg, himg;
+	int pix, i, da_ev;
+	int loc, hoc;
+	int hlen, llen;
+	int nstr, pstr;
+	int tap;
+	int fi_ev;
+	int olle, ohle, olre, ohre;
+	int lle, lle2, lre, lre2;
+	int hle, hle2, hre, hre2;
+	int lpx, lspx;
+	int lpxstr, lspxstr;
+	int lstap, lotap;
+	int hpx, hspx;
+	int hpxstr, hspxstr;
+	int hstap, hotap;
+	int asym, fhre = 0, ofhre;
+	float ssfac, osfac, sfac;
+	std::vector<float> h(hi, hi + hsz);
+
+	da_ev = len2 % 2;
+	fi_ev = lsz % 2;
+	pstr = 1;
+	nstr = -pstr;
+	if (da_ev) {
+		llen = (len2 + 1) / 2;
+		hlen = llen - 1;
+	} else {
+		llen = len2 / 2;
+		hlen = llen;
+	}
+
+	if (fi_ev) {
+		asym = 0;
+		ssfac = 1.0;
+		ofhre = 0;
+		loc = (lsz - 1) / 4;
+		hoc = (hsz + 1) / 4 - 1;
+		lotap = ((lsz - 1) / 2) % 2;
+		hotap = ((hsz + 1) / 2) % 2;
+		if (da_ev) {
+			olle = 0;
+			olre = 0;
+			ohle = 1;
+			ohre = 1;
+		} else {
+			olle = 0;
+			olre = 1;
+			ohle = 1;
+			ohre = 0;
+		}
+	} else {
+		asym = 1;
+		ssfac = -1.0;
+		ofhre = 2;
+		loc = lsz / 4 - 1;
+		hoc = hsz / 4 - 1;
+		lotap = (lsz / 2) % 2;
+		hotap = (hsz / 2) % 2;
+		if (da_ev) {
+			olle = 1;
+			olre = 0;
+			ohle = 1;
+			ohre = 1;
+		} else {
+			olle = 1;
+			olre = 1;
+			ohle = 1;
+			ohre = 1;
+		}
+
+		if (loc == -1) {
+			loc = 0;
+			olle = 0;
+		}
+		if (hoc == -1) {
+			hoc = 0;
+			ohle = 0;
+		}
+
+		for (i = 0; i < hsz; i++)
+			h[i] *= -1.0;
+	}
+
+	limg = 0;
+	himg = limg;
+	terms[0].clear();
+	state[0] = State::Zero;
+	terms[1].clear();
+	state[1] = State::Zero;
+	if (inv) {
+		hipass = 0;
+		lopass = hipass + hlen;
+	} else {
+		lopass = 0;
+		hipass = lopass + llen;
+	}
+
+	lp0 = lopass;
+	lp1 = lp0 + (llen - 1);
+	lspx = lp0 + loc;
+	lspxstr = nstr;
+	lstap = lotap;
+	lle2 = olle;
+	lre2 = olre;
+
+	hp0 = hipass;
+	hp1 = hp0 + (hlen - 1);
+	hspx = hp0 + hoc;
+	hspxstr = nstr;
+	hstap = hotap;
+	hle2 = ohle;
+	hre2 = ohre;
+	osfac = ssfac;
+
+	const auto lowpass = [&]() {
+		lle = lle2;
+		lre = lre2;
+		lpx = lspx;
+		lpxstr = lspxstr;
+
+		assign(limg, lpx, lo[tap]);
+		for (i = tap + 2; i < lsz; i += 2) {
+			if (lpx == lp0) {
+				if (lle) {
+					lpxstr = 0;
+					lle = 0;
+				} else
+					lpxstr = pstr;
+			}
+			if (lpx == lp1) {
+				if (lre) {
+					lpxstr = 0;
+					lre = 0;
+				} else
+					lpxstr = nstr;
+			}
+			lpx += lpxstr;
+			add(limg, lpx, lo[i]);
+		}
+		limg++;
+	};
+	const auto highpass = [&]() {
+		for (i = tap; i < hsz; i += 2) {
+			if (hpx == hp0) {
+				if (hle) {
+					hpxstr = 0;
+					hle = 0;
+				} else {
+					hpxstr = pstr;
+					sfac = 1.0;
+				}
+			}
+			if (hpx == hp1) {
+				if (hre) {
+					hpxstr = 0;
+					hre = 0;
+					if (asym && da_ev) {
+						hre = 1;
+						fhre--;
+						sfac = static_cast<float>(fhre);
+						if (sfac == 0.0)
+							hre = 0;
+					}
+				} else {
+					hpxstr = nstr;
+					if (asym)
+						sfac = -1.0;
+				}
+			}
+			addHigh(himg, hpx, h[i], sfac);
+			hpx += hpxstr;
+		}
+		himg++;
+	};
+
+	for (pix = 0; pix < hlen; pix++) {
+		for (tap = lstap; tap >= 0; tap--)
+			lowpass();
+		if (lspx == lp0) {
+			if (lle2) {
+				lspxstr = 0;
+				lle2 = 0;
+			} else
+				lspxstr = pstr;
+		}
+		lspx += lspxstr;
+		lstap = 1;
+
+		for (tap = hstap; tap >= 0; tap--) {
+			hle = hle2;
+			hre = hre2;
+			hpx = hspx;
+			hpxstr = hspxstr;
+			fhre = ofhre;
+			sfac = osfac;
+			highpass();
+		}
+		if (hspx == hp0) {
+			if (hle2) {
+				hspxstr = 0;
+				hle2 = 0;
+			} else {
+				hspxstr = pstr;
+				osfac = 1.0;
+			}
+		}
+		hspx += hspxstr;
+		hstap = 1;
+	}
+
+	if (da_ev)
+		lstap = (lotap ? 1 : 0);
+	else
+		lstap = (lotap ? 2 : 1);
+	for (tap = 1; tap >= lstap; tap--)
+		lowpass();
+
+	if (da_ev) {
+		hstap = (hotap ? 1 : 0);
+		if (hsz == 2) {
+			hspx -= hspxstr;
+			fhre = 1;
+		}
+	} else
+		hstap = (hotap ? 2 : 1);
+	for (tap = 1; tap >= hstap; tap--) {
+		hle = hle2;
+		hre = hre2;
+		hpx = hspx;
+		hpxstr = hspxstr;
+		sfac = osfac;
+		if (hsz != 2)
+			fhre = ofhre;
+		highpass();
+	}
+
+	if (!valid)
+		return (false);
+	synthesis.first.assign(1, 0);
+	synthesis.zero.clear();
+	synthesis.index.clear();
+	synthesis.coefficient.clear();
+	for (int img = 0; img < len2; img++) {
+		if (state[img] == State::Unset)
+			return (false);
+		synthesis.zero.push_back(state[img] == State::Zero);
+		for (const auto &term : terms[img]) {
+			synthesis.index.push_back(term.first);
+			synthesis.coefficient.push_back(term.second);
+		}
+		synthesis.first.push_back(synthesis.index.size());
+	}
+	return (true);
+}
+
+/*
+ * Kernels apply a synthesis to lanes adjacent lines: input k of lane l
+ * is in[(k * inStride) + l] and output i is out[(i * outStride) + l].
+ * Each vector kernel returns the lanes it processed; the scalar kernel
+ * finishes the rest.
+ */
+
+static void
+synthesizeScalar(
+    const Synthesis &synthesis,
+    uint32_t firstOutput,
+    uint32_t lastOutput,
+    const float *in,
+    uint64_t inStride,
+    float *out,
+    uint64_t outStride,
+    uint32_t firstLane,
+    uint32_t lanes)
+{
+	for (uint32_t o = firstOutput; o < lastOutput; o++) {
+		const uint32_t first = synthesis.first[o];
+		const uint32_t last = synthesis.first[o + 1];
+		float *dst = out + (o * outStride);
+		for (uint32_t l = firstLane; l < lanes; l++) {
+			uint32_t t = first;
+			float sum;
+			if (synthesis.zero[o])
+				sum = 0.0;
+			else {
+				sum = in[(synthesis.index[t] * inStride) + l] *
+				    synthesis.coefficient[t];
+				t++;
+			}
+			for (; t < last; t++)
+				sum += in[(synthesis.index[t] * inStride) + l] *
+				    synthesis.coefficient[t];
+			dst[l] = sum;
+		}
+	}
+}
+
+#if defined BE_IMAGE_WSQ_X86
+__attribute__((target("sse4.1")))
+static uint32_t
+synthesizeSSE41(
+    const Synthesis &synthesis,
+    uint32_t firstOutput,
+    uint32_t lastOutput,
+    const float *in,
+    uint64_t inStride,
+    float *out,
+    uint64_t outStride,
+    uint32_t lanes)
+{
+	const uint32_t vectorLanes = lanes - (lanes % 4);
+	for (uint32_t o = firstOutput; o < lastOutput; o++) {
+		const uint32_t first = synthesis.first[o];
+		const uint32_t last = synthesis.first[o + 1];
+		float *dst = out + (o * outStride);
+		for (uint32_t l = 0; l < vectorLanes; l += 4) {
+			uint32_t t = first;
+			__m128 sum;
+			if (synthesis.zero[o])
+				sum = _mm_setzero_ps();
+			else {
+				sum = _mm_mul_ps(_mm_loadu_ps(in +
+				    (synthesis.index[t] * inStride) + l),
+				    _mm_set1_ps(synthesis.coefficient[t]));
+				t++;
+			}
+			for (; t < last; t++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(
+				    in + (synthesis.index[t] * inStride) + l),
+				    _mm_set1_ps(synthesis.coefficient[t])));
+			_mm_storeu_ps(dst + l, sum);
+		}
+	}
+	return (vectorLanes);
+}
+
+__attribute__((target("avx2")))
+static uint32_t
+synthesizeAVX2(
+    const Synthesis &synthesis,
+    uint32_t firstOutput,
+    uint32_t lastOutput,
+    const float *in,
+    uint64_t inStride,
+    float *out,
+    uint64_t outStride,
+    uint32_t lanes)
+{
+	const uint32_t vectorLanes = lanes - (lanes % 8);
+	for (uint32_t o = firstOutput; o < lastOutput; o++) {
+		const uint32_t first = synthesis.first[o];
+		const uint32_t last = synthesis.first[o + 1];
+		float *dst = out + (o * outStride);
+		for (uint32_t l = 0; l < vectorLanes; l += 8) {
+			uint32_t t = first;
+			__m256 sum;
+			if (synthesis.zero[o])
+				sum = _mm256_setzero_ps();
+			else {
+				sum = _mm256_mul_ps(_mm256_loadu_ps(in +
+				    (synthesis.index[t] * inStride) + l),
+				    _mm256_set1_ps(synthesis.coefficient[t]));
+				t++;
+			}
+			for (; t < last; t++)
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(
+				    _mm256_loadu_ps(in + (synthesis.index[t] *
+				    inStride) + l), _mm256_set1_ps(
+				    synthesis.coefficient[t])));
+			_mm256_storeu_ps(dst + l, sum);
+		}
+	}
+	return (vectorLanes);
+}
+#endif /* BE_IMAGE_WSQ_X86 */
+
+/** @return Lines the vector kernels process at once */
+static uint32_t
+synthesisWidth()
+{
+	switch (BE::Image::Conversion::getInstructions()) {
+	case BE::Image::Conversion::Instructions::AVX2:
+		return (8);
+	case BE::Image::Conversion::Instructions::SSE41:
+		return (4);
+	case BE::Image::Conversion::Instructions::Scalar:
+		break;
+	}
+	return (1);
+}
+
+static void
+synthesize(
+    const Synthesis &synthesis,
+    uint32_t firstOutput,
+    uint32_t lastOutput,
+    const float *in,
+    uint64_t inStride,
+    float *out,
+    uint64_t outStride,
+    uint32_t lanes)
+{
+	uint32_t done = 0;
+#if defined BE_IMAGE_WSQ_X86
+	switch (BE::Image::Conversion::getInstructions()) {
+	case BE::Image::Conversion::Instructions::AVX2:
+		done = synthesizeAVX2(synthesis, firstOutput, lastOutput, in,
+		    inStride, out, outStride, lanes);
+		break;
+	case BE::Image::Conversion::Instructions::SSE41:
+		done = synthesizeSSE41(synthesis, firstOutput, lastOutput, in,
+		    inStride, out, outStride, lanes);
+		break;
+	case BE::Image::Conversion::Instructions::Scalar:
+		break;
+	}
+#endif
+	synthesizeScalar(synthesis, firstOutput, lastOutput, in, inStride,
+	    out, outStride, done, lanes);
+}
+
+/**
+ * @brief
+ * Synthesize rows of a subband.
+ * @details
+ * Groups of rows are transposed so that the vector kernels process
+ * several rows at once.
+ *
+ * @param[in] synthesis
+ *	Multiply-adds of a row.
+ * @param[in] length
+ *	Length of a row.
+ * @param[in] in
+ *	First input row.
+ * @param[out] out
+ *	First output row.
+ * @param[in] stride
+ *	Distance between rows of in and out.
+ * @param[in] firstRow
+ *	First row to synthesize.
+ * @param[in] lastRow
+ *	Last row + 1 to synthesize.
+ */
+static void
+synthesizeRows(
+    const Synthesis &synthesis,
+    uint32_t length,
+    const float *in,
+    float *out,
+    uint64_t stride,
+    uint32_t firstRow,
+    uint32_t lastRow)
+{
+	const uint32_t group = synthesisWidth();
+	uint32_t row = firstRow;
+	if ((group > 1) && (lastRow - firstRow >= group)) {
+		std::vector<float> columns(2 * length * group);
+		float *results = columns.data() + (length * group);
+		for (; row + group <= lastRow; row += group) {
+			for (uint32_t l = 0; l < group; l++) {
+				const float *src = in + ((row + l) * stride);
+				for (uint32_t k = 0; k < length; k++)
+					columns[(k * group) + l] = src[k];
+			}
+			synthesize(synthesis, 0, length, columns.data(), group,
+			    results, group, group);
+			for (uint32_t l = 0; l < group; l++) {
+				float *dst = out + ((row + l) * stride);
+				for (uint32_t k = 0; k < length; k++)
+					dst[k] = results[(k * group) + l];
+			}
+		}
+	}
+	for (; row < lastRow; row++)
+		synthesizeScalar(synthesis, 0, length, in + (row * stride), 1,
+		    out + (row * stride), 1, 0, 1);
+}
+
+/**
+ * @brief
+ * State shared by the threads of forEachRowBlock().
+ */
+struct RowBlocks
+{
+	/** Number of rows */
+	uint32_t rows;
+	/** Rows in each block */
+	uint32_t blockSize;
+	/** Function called with the first and last + 1 row of a block */
+	const std::function<void(uint32_t, uint32_t)> *fn;
+	/** Next block to process */
+	std::atomic<uint32_t> next;
+	/** Guards error */
+	pthread_mutex_t mutex;
+	/** First exception thrown by fn */
+	std::exception_ptr error;
+};
+
+static void*
+rowBlockWorker(
+    void *arg)
+{
+	RowBlocks *state = static_cast<RowBlocks*>(arg);
+	for (;;) {
+		const uint64_t first = static_cast<uint64_t>(state->next++) *
+		    state->blockSize;
+		if (first >= state->rows)
+			break;
+		try {
+			(*state->fn)(static_cast<uint32_t>(first),
+			    static_cast<uint32_t>(std::min<uint64_t>(first +
+			    state->blockSize, state->rows)));
+		} catch (...) {
+			pthread_mutex_lock(&state->mutex);
+			if (state->error == nullptr)
+				state->error = std::current_exception();
+			pthread_mutex_unlock(&state->mutex);
+		}
+	}
+	return (nullptr);
+}
+
+/**
+ * @brief
+ * Divide rows into blocks and process them on a pool of threads.
+ *
+ * @param[in] rows
+ *	Number of rows.
+ * @param[in] threads
+ *	Number of threads. The calling thread is one of them.
+ * @param[in] fn
+ *	Function called with the first and last + 1 row of each block.
+ */
+static void
+forEachRowBlock(
+    uint32_t rows,
+    uint32_t threads,
+    const std::function<void(uint32_t, uint32_t)> &fn)
+{
+	static const uint32_t blockSize = 32;
+	threads = std::max<uint32_t>(std::min(threads,
+	    (rows + blockSize - 1) / blockSize), 1);
+
+	RowBlocks state;
+	state.rows = rows;
+	state.blockSize = blockSize;
+	state.fn = &fn;
+	state.next = 0;
+	pthread_mutex_init(&state.mutex, nullptr);
+
+	std::vector<pthread_t> workers;
+	for (uint32_t i = 1; i < threads; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, nullptr, rowBlockWorker,
+		    &state) != 0)
+			break;
+		workers.push_back(thread);
+	}
+	rowBlockWorker(&state);
+	for (const auto &thread : workers)
+		pthread_join(thread, nullptr);
+	pthread_mutex_destroy(&state.mutex);
+
+	if (state.error != nullptr)
+		std::rethrow_exception(state.error);
+}
+
+/** Subbands smaller than this many pixels are synthesized by one thread */
+static const uint64_t ParallelSubbandSize = 1 << 18;
+
+/**
+ * @brief
+ * Reconstruct the subbands of w_tree nodes W_TREELEN - 1 down to
+ * lastNode, as wsq_reconstruct_node().
+ *
+ * @param[in] tables
+ *	Tables of the image.
+ * @param[in,out] fdata
+ *	Subbands, then the image.
+ * @param[in] width
+ *	Width of the image.
+ * @param[in] height
+ *	Height of the image.
+ * @param[in] lastNode
+ *	Last node to reconstruct.
+ * @param[in] threads
+ *	Threads synthesizing large subbands.
+ *
+ * @return
+ *	false if the subbands need to be reconstructed by libwsq.
+ */
+static bool
+reconstruct(
+    const WSQTables &tables,
+    float *fdata,
+    const int width,
+    const int height,
+    const int lastNode,
+    uint32_t threads)
+{
+	if (tables.dtt.lodef != 1)
+		throw BE::Error::DataError("WSQ lowpass filter undefined");
+	if (tables.dtt.hidef != 1)
+		throw BE::Error::DataError("WSQ highpass filter undefined");
+
+	/* Columns, then rows, of each node */
+	std::vector<std::pair<Synthesis, Synthesis>> syntheses(W_TREELEN);
+	for (int node = W_TREELEN - 1; node >= lastNode; node--) {
+		const W_TREE &w = tables.wTree[node];
+		if ((w.lenx <= 0) || (w.leny <= 0) ||
+		    !recordSynthesis(w.leny, tables.dtt.hifilt,
+		    tables.dtt.hisz, tables.dtt.lofilt, tables.dtt.losz,
+		    w.inv_cl, syntheses[node].first) ||
+		    !recordSynthesis(w.lenx, tables.dtt.hifilt,
+		    tables.dtt.hisz, tables.dtt.lofilt, tables.dtt.losz,
+		    w.inv_rw, syntheses[node].second))
+			return (false);
+	}
+
+	std::vector<float> fdata1(static_cast<uint64_t>(width) * height);
+	for (int node = W_TREELEN - 1; node >= lastNode; node--) {
+		const W_TREE &w = tables.wTree[node];
+		float *fdata_bse = fdata + (w.y * width) + w.x;
+		const uint32_t nodeThreads = ((static_cast<uint64_t>(w.lenx) *
+		    w.leny) >= ParallelSubbandSize) ? threads : 1;
+
+		const Synthesis &columns = syntheses[node].first;
+		forEachRowBlock(w.leny, nodeThreads,
+		    [&](uint32_t first, uint32_t last) {
+			synthesize(columns, first, last, fdata_bse, width,
+			    fdata1.data(), width, w.lenx);
+		});
+
+		const Synthesis &rows = syntheses[node].second;
+		forEachRowBlock(w.leny, nodeThreads,
+		    [&](uint32_t first, uint32_t last) {
+			synthesizeRows(rows, w.lenx, fdata1.data(), fdata_bse,
+			    width, first, last);
+		});
+	}
+	return (true);
+}
+
+/******************************************************************************/
+/* Conversion to pixels.                                                      */
+/******************************************************************************/
+
+/*
+ * As conv_img_2_uchar(). Adding 0.5 in float rather than double gives
+ * the same result for every value not clamped to 255.
+ */
+
+static void
+toPixelsScalar(
+    const float *in,
+    uint8_t *out,
+    uint64_t first,
+    uint64_t count,
+    const float mShift,
+    const float rScale)
+{
+	for (uint64_t i = first; i < count; i++) {
+		float value = (in[i] * rScale) + mShift;
+		value += 0.5;
+		if (value < 0.0)
+			out[i] = 0;
+		else if (value > 255.0)
+			out[i] = 255;
+		else
+			out[i] = static_cast<uint8_t>(value);
+	}
+}
+
+#if defined BE_IMAGE_WSQ_X86
+__attribute__((target("sse4.1")))
+static uint64_t
+toPixelsSSE41(
+    const float *in,
+    uint8_t *out,
+    uint64_t count,
+    const float mShift,
+    const float rScale)
+{
+	const __m128 shift = _mm_set1_ps(mShift);
+	const __m128 scale = _mm_set1_ps(rScale);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 maximum = _mm_set1_ps(255.0f);
+	uint64_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale),
+		    shift);
+		v = _mm_min_ps(_mm_max_ps(_mm_add_ps(v, half), zero),
+		    maximum);
+		__m128i p = _mm_cvttps_epi32(v);
+		p = _mm_packus_epi16(_mm_packs_epi32(p, p), p);
+		const int32_t pixels = _mm_cvtsi128_si32(p);
+		std::memcpy(out + i, &pixels, 4);
+	}
+	return (i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t
+toPixelsAVX2(
+    const float *in,
+    uint8_t *out,
+    uint64_t count,
+    const float mShift,
+    const float rScale)
+{
+	const __m256 shift = _mm256_set1_ps(mShift);
+	const __m256 scale = _mm256_set1_ps(rScale);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 maximum = _mm256_set1_ps(255.0f);
+	uint64_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i),
+		    scale), shift);
+		v = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(v, half), zero),
+		    maximum);
+		const __m256i p = _mm256_cvttps_epi32(v);
+		__m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(p),
+		    _mm256_extracti128_si256(p, 1));
+		packed = _mm_packus_epi16(packed, packed);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), packed);
+	}
+	return (i);
+}
+#endif /* BE_IMAGE_WSQ_X86 */
+
+static void
+toPixels(
+    const float *in,
+    uint8_t *out,
+    uint64_t count,
+    const float mShift,
+    const float rScale)
+{
+	uint64_t done = 0;
+#if defined BE_IMAGE_WSQ_X86
+	switch (BE::Image::Conversion::getInstructions()) {
+	case BE::Image::Conversion::Instructions::AVX2:
+		done = toPixelsAVX2(in, out, count, mShift, rScale);
+		break;
+	case BE::Image::Conversion::Instructions::SSE41:
+		done = toPixelsSSE41(in, out, count, mShift, rScale);
+		break;
+	case BE::Image::Conversion::Instructions::Scalar:
+		break;
+	}
+#endif
+	toPixelsScalar(in, out, done, count, mShift, rScale);
+}
+
+/******************************************************************************/
+/* Decoding.                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief
+ * Decode WSQ data as wsq_decode_mem_reduced().
+ *
+ * @param[in] data
+ *	WSQ data.
+ * @param[in] reduction
+ *	Decode at 1/2^reduction of the size in each dimension.
+ * @param[in] threads
+ *	Threads synthesizing large subbands.
+ * @param[out] pixels
+ *	Decoded pixels.
+ *
+ * @return
+ *	false if data must be decoded by libwsq.
+ *
+ * @throw Error::DataError
+ *	Invalid WSQ data.
+ */
+static bool
+decodeOptimized(
+    const BE::Memory::ByteView &data,
+    const int reduction,
+    uint32_t threads,
+    BE::Memory::uint8Array &pixels)
+{
+	static const int lowpassNode[WSQ_MAX_REDUCTION + 1] =
+	    {0, 1, 14, 15, 19};
+
+	WSQTables tables;
+	unsigned char *idata = const_cast<unsigned char*>(data.data());
+	unsigned char *cbufptr = idata;
+	unsigned char *ebufptr = idata + data.size();
+
+	unsigned short marker;
+	checkWSQ(getc_marker_wsq(&marker, SOI_WSQ, &cbufptr, ebufptr),
+	    "read SOI marker");
+	checkWSQ(getc_marker_wsq(&marker, TBLS_N_SOF, &cbufptr, ebufptr),
+	    "read marker");
+	readTables(tables, marker, TBLS_N_SOF, SOF_WSQ, &cbufptr, ebufptr);
+	checkWSQ(getc_frame_header_wsq(&tables.frame, &cbufptr, ebufptr),
+	    "read frame header");
+	int width = tables.frame.width;
+	int height = tables.frame.height;
+	int ppi;
+	checkWSQ(getc_ppi_wsq(&ppi, idata, static_cast<int>(data.size())),
+	    "read NISTCOM");
+	build_wsq_trees(tables.wTree, W_TREELEN, tables.qTree, Q_TREELEN,
+	    width, height);
+
+	std::vector<float> fdata(static_cast<uint64_t>(width) * height);
+	{
+		std::vector<short> qdata(fdata.size());
+		decodeBlocks(tables, &cbufptr, ebufptr, qdata.data());
+		unquantize(tables, qdata.data(), fdata.data(), width);
+	}
+
+	const int node = lowpassNode[reduction];
+	if (!reconstruct(tables, fdata.data(), width, height, node, threads))
+		return (false);
+
+	if (reduction > 0) {
+		/* Lowpass region is at the origin; pack its rows together */
+		const int rwidth = tables.wTree[node].lenx;
+		const int rheight = tables.wTree[node].leny;
+		for (int y = 1; y < rheight; y++)
+			std::memmove(fdata.data() + (y * rwidth),
+			    fdata.data() + (y * width), rwidth * sizeof(float));
+
+		/* Undo the DC gain of the lowpass filter at each level */
+		float lo_gain = 0.0;
+		for (int i = 0; i < tables.dtt.losz; i++)
+			lo_gain += tables.dtt.lofilt[i];
+		lo_gain *= lo_gain;
+		float scale = 1.0;
+		for (int i = 0; i < reduction; i++)
+			scale /= lo_gain;
+		for (int i = 0; i < rwidth * rheight; i++)
+			fdata[i] *= scale;
+
+		width = rwidth;
+		height = rheight;
+	}
+
+	pixels.resize(static_cast<uint64_t>(width) * height);
+	toPixels(fdata.data(), pixels, pixels.size(), tables.frame.m_shift,
+	    tables.frame.r_scale);
+	return (true);
+}
 
 BiometricEvaluation::Image::WSQ::WSQ(
     const uint8_t *data,
     const uint64_t size) :
+    BiometricEvaluation::Image::WSQ::WSQ(Memory::ByteView(data, size))
+{
+	this->copyData();
+}
+
+BiometricEvaluation::Image::WSQ::WSQ(
+    const Memory::ByteView &data) :
     Image::Image(
     data,
-    size,
     CompressionAlgorithm::WSQ20)
 {
 	uint8_t *marker_buf = (uint8_t *)this->getDataPointer();
 	uint8_t *wsq_buf = marker_buf;
+	const uint64_t size = data.size();
 
 	/* Read to the "start of image" marker */
 	uint16_t marker, tbl_size;
@@ -94,19 +1560,75 @@ BiometricEvaluation::Image::WSQ::WSQ(
 }
 
 BiometricEvaluation::Memory::uint8Array
-BiometricEvaluation::Image::WSQ::getRawData()
+BiometricEvaluation::Image::WSQ::decodeRawData()
     const
 {
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	return (decode(this->getDataView()));
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::WSQ::decodeReducedRawData(
+    uint8_t scaleDenominator)
+    const
+{
+	Memory::ScopedAllocationTag allocationTag(
+	    Memory::AllocationTag::ImageDecode);
+	const Size reduced = this->getReducedDimensions(scaleDenominator);
+	Memory::uint8Array rawData = decode(this->getDataView(),
+	    scaleDenominator);
+	if (rawData.size() != (static_cast<uint64_t>(reduced.xSize) *
+	    reduced.ySize))
+		throw Error::DataError("Decompressed size does not match "
+		    "header");
+
+	return (rawData);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Image::WSQ::decode(
+    const Memory::ByteView &data,
+    uint8_t scaleDenominator,
+    Decoder decoder,
+    uint32_t threads)
+{
+	int reduction;
+	switch (scaleDenominator) {
+	case 1:
+		reduction = 0;
+		break;
+	case 2:
+		reduction = 1;
+		break;
+	case 4:
+		reduction = 2;
+		break;
+	case 8:
+		reduction = 3;
+		break;
+	default:
+		throw Error::ParameterError("Invalid scale denominator (" +
+		    std::to_string(scaleDenominator) + ")");
+	}
+	if (threads == 0)
+		threads = std::max<uint32_t>(System::getCPUCount(), 1);
+
+	Memory::uint8Array rawData;
+	if ((decoder == Decoder::Optimized) &&
+	    decodeOptimized(data, reduction, threads, rawData))
+		return (rawData);
+
+	/* Wavelet reconstruction stops at the lowpass subband needed */
 	uint8_t *rawbuf = nullptr;
 	int32_t depth, height, lossy, ppi, rv, width;
-	if ((rv = wsq_decode_mem(&rawbuf, &width, &height, &depth, &ppi,
-	    &lossy, (unsigned char *)this->getDataPointer(),
-	    this->getDataSize())))
+	if ((rv = wsq_decode_mem_reduced(&rawbuf, &width, &height, &depth,
+	    &ppi, &lossy, const_cast<unsigned char*>(data.data()),
+	    data.size(), reduction)))
 		throw Error::DataError("Could not convert WSQ to raw.");
 
 	/* rawbuf allocated within libwsq.  Copy to manage with AutoArray. */
-	/* TODO: AutoBuffer-wrapped AutoArray */
-	Memory::uint8Array rawData(width * height * (depth / 8));
+	rawData.resize(width * height * (depth / 8));
 	rawData.copy(rawbuf);
 	free(rawbuf);
 
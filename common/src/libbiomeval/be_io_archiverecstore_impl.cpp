@@ -24,6 +24,7 @@
 #include <be_error.h>
 #include <be_io_utility.h>
 #include <be_io_archiverecstore.h>
+#include <be_memory_accounting.h>
 #include <be_memory_autoarray.h>
 #include <be_text.h>
 
@@ -35,6 +36,7 @@ BiometricEvaluation::IO::ArchiveRecordStore::Impl::Impl(
     RecordStore::Impl(pathname, description, RecordStore::Kind::Archive)
 {
 	_dirty = false;
+	_manifestSize = 0;
 
 	try {
 		this->open_streams();
@@ -49,19 +51,24 @@ BiometricEvaluation::IO::ArchiveRecordStore::Impl::Impl(
     RecordStore::Impl(pathname, mode)
 {
 	_dirty = false;
+	_manifestSize = 0;
 
 	try {
 		this->open_streams();
 		read_manifest();
 	} catch (Error::ConversionError &e) {
+		uncharge_manifest();
 		throw Error::StrategyError(e.what());
 	} catch (Error::FileError &e) {
+		uncharge_manifest();
 		throw Error::StrategyError(e.what());
 	}
 }
 
 BiometricEvaluation::IO::ArchiveRecordStore::Impl::~Impl()
 {
+	uncharge_manifest();
+
 	try {
 		close_streams();
 	} catch (Error::StrategyError &e) {
@@ -517,13 +524,33 @@ BiometricEvaluation::IO::ArchiveRecordStore::Impl::setCursorAtKey(
 	_cursorPos = (lb == _entries.begin()) ? lb : --lb;
 }
 
+void
+BiometricEvaluation::IO::ArchiveRecordStore::Impl::uncharge_manifest()
+{
+	if (_manifestSize != 0)
+		Memory::recordDeallocation(
+		    Memory::AllocationTag::RecordStoreManifest, _manifestSize);
+	_manifestSize = 0;
+}
+
 void
 BiometricEvaluation::IO::ArchiveRecordStore::Impl::efficient_insert(
     ManifestMap &m,
     const ManifestMap::key_type &k,
     const ManifestMap::mapped_type &v)
 {
-	_entries[k] = v;
+	if (Memory::isAccountingEnabled() && !m.keyExists(k)) {
+		/* Key is held by the map node and the ordering list */
+		const uint64_t entrySize = (2 * (sizeof(ManifestMap::key_type) +
+		    k.size() + 1)) + sizeof(ManifestMap::mapped_type) +
+		    (4 * sizeof(void *));
+		m[k] = v;
+		Memory::recordAllocation(
+		    Memory::AllocationTag::RecordStoreManifest, entrySize);
+		_manifestSize += entrySize;
+		return;
+	}
+	m[k] = v;
 }
 
 void
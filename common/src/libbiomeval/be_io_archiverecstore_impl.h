@@ -211,6 +211,12 @@ namespace BiometricEvaluation {
 			 * deleted entry and would benefit from vacuum().
 			 */
 			bool _dirty;
+
+			/**
+			 * Bytes of _entries charged to
+			 * Memory::AllocationTag::RecordStoreManifest.
+			 */
+			uint64_t _manifestSize;
 			
 			/**
 			 * @brief
@@ -222,6 +228,13 @@ namespace BiometricEvaluation {
 			 *	Manifest is malformed or could not be read.
 			 */
 			void read_manifest();
+
+			/**
+			 * @brief
+			 * Release the manifest's charge to allocation
+			 * accounting.
+			 */
+			void uncharge_manifest();
 		
 			/**
 			 * @brief
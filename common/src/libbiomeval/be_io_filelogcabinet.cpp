@@ -10,11 +10,15 @@
 
 #include <sys/stat.h>
 
+#include <dirent.h>
+
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
 #include <be_io_filelogcabinet.h>
+#include <be_io_filelogsheetreader.h>
 #include <be_io_utility.h>
 
 namespace BE = BiometricEvaluation;
@@ -118,6 +122,43 @@ BiometricEvaluation::IO::FileLogCabinet::getCount()
 	return (this->_count);
 }
 
+uint32_t
+BiometricEvaluation::IO::FileLogCabinet::mergeLogsheets(
+    const std::string &url,
+    const std::string &description,
+    uint32_t numThreads)
+{
+	DIR *dir = opendir(this->_pathname.c_str());
+	if (dir == nullptr)
+		throw Error::StrategyError("Could not open directory");
+
+	/* Every sheet, but not the control file or sheet indexes */
+	const std::string indexSuffix = FileLogsheetReader::getIndexPathname("");
+	std::vector<std::string> names;
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != nullptr) {
+		const std::string name(entry->d_name);
+		if ((name == ".") || (name == "..") || (name == controlFileName))
+			continue;
+		if ((name.size() > indexSuffix.size()) && (name.compare(
+		    name.size() - indexSuffix.size(), std::string::npos,
+		    indexSuffix) == 0))
+			continue;
+		struct stat sb;
+		if ((stat(canonicalName(name).c_str(), &sb) == 0) &&
+		    S_ISREG(sb.st_mode))
+			names.push_back(name);
+	}
+	closedir(dir);
+	std::sort(names.begin(), names.end());
+
+	std::vector<std::string> urls;
+	for (const auto &name : names)
+		urls.push_back(canonicalName(name));
+	return (FileLogsheet::mergeLogsheets(urls, url, description,
+	    numThreads));
+}
+
 /*
  * Protected methods.
  */
@@ -8,9 +8,25 @@
  * about its quality, reliability, or any other characteristic.
  */
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <queue>
+#include <unistd.h>
 #include <vector>
+
+#include <be_error.h>
+#include <be_error_exception.h>
 #include <be_io_utility.h>
 #include <be_io_filelogsheet.h>
+#include <be_io_filelogsheetreader.h>
+#include <be_time.h>
 
 namespace BE = BiometricEvaluation;
 
@@ -54,11 +70,22 @@ BiometricEvaluation::IO::FileLogsheet::FileLogsheet(
     const std::string &url,
     const std::string &description) :
     Logsheet(),
-    _cursor(0)
+    _cursor(0),
+    _logSize(0),
+    _async(false),
+    _flushLatency(0),
+    _bufferSize(0),
+    _asyncFD(-1),
+    _appended(0),
+    _written(0),
+    _flushTarget(0),
+    _asyncStop(false),
+    _asyncError(0)
 {
 	std::string pathname;
 	if (parseURL(url, pathname) != true)
 		throw Error::ParameterError("Malformed URL");
+	_pathname = pathname;
 	if (IO::Utility::fileExists(pathname))
 		throw Error::ObjectExists();
 
@@ -74,6 +101,8 @@ BiometricEvaluation::IO::FileLogsheet::FileLogsheet(
 	if (_theLogFile->fail())
 		throw Error::StrategyError("Could not write description to "
 		    "log file");
+	_logSize = BE::IO::Logsheet::DescriptionTag.size() + 1 +
+	    description.size() + 1;
 	
 	_sequenceFile.reset(new std::fstream(pathname.c_str(), in));
 	if (_sequenceFile->fail())
@@ -83,30 +112,44 @@ BiometricEvaluation::IO::FileLogsheet::FileLogsheet(
 BiometricEvaluation::IO::FileLogsheet::FileLogsheet(
     const std::string &url) :
     Logsheet(),
-    _cursor(0)
+    _cursor(0),
+    _logSize(0),
+    _async(false),
+    _flushLatency(0),
+    _bufferSize(0),
+    _asyncFD(-1),
+    _appended(0),
+    _written(0),
+    _flushTarget(0),
+    _asyncStop(false),
+    _asyncError(0)
 {
 	std::string pathname;
 	if (parseURL(url, pathname) != true)
 		throw Error::ParameterError("Malformed URL");
+	_pathname = pathname;
 	if (!IO::Utility::fileExists(pathname))
 		throw Error::ObjectDoesNotExist();
 
-	/* Open the log sheet file as a file input stream so we can
-	 * obtain the last entry number. */
-	std::ifstream ifs(pathname.c_str(), std::ios_base::in);
-	if (ifs.fail())
-		throw Error::StrategyError("Could not open FileLogsheet file");
-
 	/*
-	 * Determine the current entry number by counting lines that
-	 * begin with the entry delimiter, etc.
+	 * Determine the current entry number by counting entries, using
+	 * and updating the sidecar index if this sheet has one.
 	 */
-	std::string oneline;
-	while (!ifs.eof()) {
-		std::getline(ifs, oneline);
-		if (BE::IO::Logsheet::lineIsEntry(oneline))
-			this->incrementEntryNumber();
+	uint32_t entryCount;
+	try {
+		const bool indexed = IO::Utility::fileExists(
+		    FileLogsheetReader::getIndexPathname(pathname));
+		FileLogsheetReader reader(pathname, indexed ?
+		    FileLogsheetReader::IndexMode::Update :
+		    FileLogsheetReader::IndexMode::None);
+		entryCount = reader.getEntryCount();
+		_logSize = IO::Utility::getFileSize(pathname);
+	} catch (Error::Exception &e) {
+		throw Error::StrategyError("Could not read FileLogsheet file: " +
+		    e.whatString());
 	}
+	for (uint32_t i = 0; i < entryCount; i++)
+		this->incrementEntryNumber();
 
 	/* Open the log sheet file as a file output stream */
 	std::fstream *ofs = new std::fstream(pathname.c_str(), app | out);
@@ -126,9 +169,19 @@ BiometricEvaluation::IO::FileLogsheet::write(const std::string &entry)
 	if (this->getCommit() == false)
 		return;
 
-	*_theLogFile << EntryDelimiter << ' '
-	    << this->getCurrentEntryNumberAsString()
-	    << ' ' << entry << std::endl;
+	const std::string number = this->getCurrentEntryNumberAsString();
+	if (_indexFile)
+		this->indexEntry();
+	if (_async) {
+		this->appendAsynchronous(EntryDelimiter + (' ' + number) + ' ' +
+		    entry + '\n');
+		this->incrementEntryNumber();
+		return;
+	}
+
+	*_theLogFile << EntryDelimiter << ' ' << number << ' ' << entry
+	    << std::endl;
+	_logSize += 2 + number.size() + 1 + entry.size() + 1;
 	if (_theLogFile->fail()) {
 		std::ostringstream sbuf;
 		sbuf << "Failed writing entry " << this->getCurrentEntryNumber()
@@ -147,7 +200,14 @@ BiometricEvaluation::IO::FileLogsheet::writeComment(
 	if (this->getCommentCommit() == false)
 		return;
 
+	if (_async) {
+		this->appendAsynchronous(CommentDelimiter + (' ' + entry) +
+		    '\n');
+		return;
+	}
+
 	*_theLogFile << CommentDelimiter << ' ' << entry << std::endl;
+	_logSize += 2 + entry.size() + 1;
 	if (_theLogFile->fail())
 		throw Error::StrategyError();
 	if (this->getAutoSync())
@@ -161,7 +221,14 @@ BiometricEvaluation::IO::FileLogsheet::writeDebug(
 	if (this->getDebugCommit() == false)
 		return;
 
+	if (_async) {
+		this->appendAsynchronous(DebugDelimiter + (' ' + entry) +
+		    '\n');
+		return;
+	}
+
 	*_theLogFile << DebugDelimiter << ' ' << entry << std::endl;
+	_logSize += 2 + entry.size() + 1;
 	if (_theLogFile->fail())
 		throw Error::StrategyError();
 	if (this->getAutoSync())
@@ -171,9 +238,68 @@ BiometricEvaluation::IO::FileLogsheet::writeDebug(
 void
 BiometricEvaluation::IO::FileLogsheet::sync()
 {
-	_theLogFile->flush();
-	if (_theLogFile->fail())
-		throw Error::StrategyError("Could not sync the log file");
+	if (_async) {
+		this->drainAsynchronous();
+		if (::fsync(_asyncFD) != 0)
+			throw Error::StrategyError("Could not sync the log "
+			    "file: " + Error::errorStr());
+	} else {
+		_theLogFile->flush();
+		if (_theLogFile->fail())
+			throw Error::StrategyError("Could not sync the log "
+			    "file");
+	}
+
+	/* Index follows the log, so it never names unwritten entries */
+	if (_indexFile) {
+		_indexFile->flush();
+		if (_indexFile->fail())
+			throw Error::StrategyError("Could not sync the index");
+	}
+}
+
+void
+BiometricEvaluation::IO::FileLogsheet::setIndexing(
+    bool state)
+{
+	if (!state) {
+		if (_indexFile) {
+			_indexFile->close();
+			_indexFile.reset();
+		}
+		return;
+	}
+	if (_indexFile)
+		return;
+
+	/* Index everything already in the log */
+	this->sync();
+	FileLogsheetReader::updateIndex(_pathname);
+	_logSize = IO::Utility::getFileSize(_pathname);
+
+	_indexFile.reset(new std::ofstream(
+	    FileLogsheetReader::getIndexPathname(_pathname),
+	    std::ios_base::out | std::ios_base::app | std::ios_base::binary));
+	if (_indexFile->fail()) {
+		_indexFile.reset();
+		throw Error::FileError("Could not open index of " + _pathname);
+	}
+}
+
+bool
+BiometricEvaluation::IO::FileLogsheet::getIndexing()
+    const
+{
+	return (static_cast<bool>(_indexFile));
+}
+
+void
+BiometricEvaluation::IO::FileLogsheet::indexEntry()
+{
+	const uint64_t offset = _logSize;
+	_indexFile->write((const char *)&offset, sizeof(offset));
+	if (_indexFile->fail())
+		throw Error::StrategyError("Could not write to index");
 }
 
 std::string
@@ -188,6 +314,8 @@ BiometricEvaluation::IO::FileLogsheet::sequence(
 		    "argument");
 	
 	/* Sync to make sure that fstream knows about recent writes */
+	if (_async)
+		this->drainAsynchronous();
 	_sequenceFile->sync();
 	/* Reset EOF */
 	_sequenceFile->clear();
@@ -297,8 +425,648 @@ BiometricEvaluation::IO::FileLogsheet::mergeLogsheets(
 	}
 }
 
+void
+BiometricEvaluation::IO::FileLogsheet::setAsynchronous(
+    bool state,
+    uint64_t flushLatency,
+    uint64_t bufferSize)
+{
+	if (state) {
+		if ((flushLatency == 0) || (bufferSize == 0))
+			throw Error::ParameterError("Flush latency and buffer "
+			    "size must be non-zero");
+		if (_async) {
+			pthread_mutex_lock(&_asyncMutex);
+			_flushLatency = flushLatency;
+			_bufferSize = bufferSize;
+			pthread_cond_signal(&_asyncWork);
+			pthread_mutex_unlock(&_asyncMutex);
+			return;
+		}
+
+		/* Entries written synchronously must precede ours */
+		this->sync();
+		_asyncFD = ::open(_pathname.c_str(), O_WRONLY | O_APPEND);
+		if (_asyncFD == -1)
+			throw Error::StrategyError("Could not open FileLogsheet "
+			    "file: " + Error::errorStr());
+
+		_flushLatency = flushLatency;
+		_bufferSize = bufferSize;
+		_pending.clear();
+		_pending.reserve(bufferSize);
+		_appended = _written = _flushTarget = 0;
+		_asyncStop = false;
+		_asyncError = 0;
+		pthread_mutex_init(&_asyncMutex, nullptr);
+		pthread_cond_init(&_asyncWork, nullptr);
+		pthread_cond_init(&_asyncDone, nullptr);
+		if (pthread_create(&_asyncThread, nullptr,
+		    FileLogsheet::asyncWriter, this) != 0) {
+			pthread_cond_destroy(&_asyncDone);
+			pthread_cond_destroy(&_asyncWork);
+			pthread_mutex_destroy(&_asyncMutex);
+			::close(_asyncFD);
+			_asyncFD = -1;
+			throw Error::StrategyError("pthread_create() error");
+		}
+		_async = true;
+		return;
+	}
+
+	if (!_async)
+		return;
+
+	/* The thread writes everything pending before exiting */
+	pthread_mutex_lock(&_asyncMutex);
+	_asyncStop = true;
+	pthread_cond_signal(&_asyncWork);
+	pthread_mutex_unlock(&_asyncMutex);
+	pthread_join(_asyncThread, nullptr);
+	_async = false;
+
+	const int asyncError = _asyncError;
+	pthread_cond_destroy(&_asyncDone);
+	pthread_cond_destroy(&_asyncWork);
+	pthread_mutex_destroy(&_asyncMutex);
+	::close(_asyncFD);
+	_asyncFD = -1;
+	_pending.clear();
+	_pending.shrink_to_fit();
+
+	/* Resume synchronous writing after the asynchronous entries */
+	_theLogFile->seekp(0, std::ios_base::end);
+	if (asyncError != 0) {
+		errno = asyncError;
+		throw Error::StrategyError("Failed writing entries to log "
+		    "file: " + Error::errorStr());
+	}
+}
+
+bool
+BiometricEvaluation::IO::FileLogsheet::getAsynchronous()
+    const
+{
+	return (_async);
+}
+
+void
+BiometricEvaluation::IO::FileLogsheet::appendAsynchronous(
+    const std::string &line)
+{
+	pthread_mutex_lock(&_asyncMutex);
+	if (_asyncError != 0) {
+		const int asyncError = _asyncError;
+		pthread_mutex_unlock(&_asyncMutex);
+		errno = asyncError;
+		throw Error::StrategyError("Failed writing entries to log "
+		    "file: " + Error::errorStr());
+	}
+
+	/* Apply back pressure when the writer falls far behind */
+	while ((_pending.size() >= 4 * _bufferSize) && (_asyncError == 0))
+		pthread_cond_wait(&_asyncDone, &_asyncMutex);
+
+	const bool wasEmpty = _pending.empty();
+	if (wasEmpty)
+		clock_gettime(CLOCK_REALTIME, &_pendingSince);
+	_pending.append(line);
+	_appended += line.size();
+	_logSize += line.size();
+
+	/* Wake the writer to start the latency clock or write a batch */
+	if (wasEmpty || (_pending.size() >= _bufferSize))
+		pthread_cond_signal(&_asyncWork);
+	pthread_mutex_unlock(&_asyncMutex);
+}
+
+void
+BiometricEvaluation::IO::FileLogsheet::drainAsynchronous()
+{
+	pthread_mutex_lock(&_asyncMutex);
+	const uint64_t target = _appended;
+	if (target > _flushTarget) {
+		_flushTarget = target;
+		pthread_cond_signal(&_asyncWork);
+	}
+	while ((_written < target) && (_asyncError == 0))
+		pthread_cond_wait(&_asyncDone, &_asyncMutex);
+	const int asyncError = _asyncError;
+	pthread_mutex_unlock(&_asyncMutex);
+
+	if (asyncError != 0) {
+		errno = asyncError;
+		throw Error::StrategyError("Failed writing entries to log "
+		    "file: " + Error::errorStr());
+	}
+}
+
+void *
+BiometricEvaluation::IO::FileLogsheet::asyncWriter(
+    void *ptr)
+{
+	FileLogsheet *ls = static_cast<FileLogsheet *>(ptr);
+	std::string batch;
+	batch.reserve(ls->_bufferSize);
+
+	pthread_mutex_lock(&ls->_asyncMutex);
+	while (true) {
+		if (ls->_pending.empty()) {
+			if (ls->_asyncStop)
+				break;
+			pthread_cond_wait(&ls->_asyncWork, &ls->_asyncMutex);
+			continue;
+		}
+
+		/* Wait for a full buffer, a barrier, or the latency */
+		if (!ls->_asyncStop && (ls->_flushTarget <= ls->_written) &&
+		    (ls->_pending.size() < ls->_bufferSize)) {
+			struct timespec deadline = ls->_pendingSince;
+			deadline.tv_sec += ls->_flushLatency /
+			    Time::MicrosecondsPerSecond;
+			deadline.tv_nsec += (ls->_flushLatency %
+			    Time::MicrosecondsPerSecond) *
+			    Time::NanosecondsPerMicrosecond;
+			if (deadline.tv_nsec >= 1000000000) {
+				deadline.tv_sec++;
+				deadline.tv_nsec -= 1000000000;
+			}
+			if (pthread_cond_timedwait(&ls->_asyncWork,
+			    &ls->_asyncMutex, &deadline) != ETIMEDOUT)
+				continue;
+		}
+
+		/* Write the batch without holding up writers */
+		batch.swap(ls->_pending);
+		pthread_mutex_unlock(&ls->_asyncMutex);
+
+		int error = 0;
+		const char *data = batch.data();
+		size_t remaining = batch.size();
+		while (remaining > 0) {
+			ssize_t sz = ::write(ls->_asyncFD, data, remaining);
+			if (sz == -1) {
+				if (errno == EINTR)
+					continue;
+				error = errno;
+				break;
+			}
+			data += sz;
+			remaining -= sz;
+		}
+
+		pthread_mutex_lock(&ls->_asyncMutex);
+		ls->_written += batch.size();
+		if ((error != 0) && (ls->_asyncError == 0))
+			ls->_asyncError = error;
+		batch.clear();
+		pthread_cond_broadcast(&ls->_asyncDone);
+	}
+	pthread_mutex_unlock(&ls->_asyncMutex);
+
+	return (nullptr);
+}
+
+/** Size of the blocks copied when merging */
+static const uint64_t MERGEBLOCKSIZE = 4 * 1024 * 1024;
+/** Width of an entry number, as formatted by Logsheet */
+static const uint64_t ENTRYNUMBERWIDTH = 10;
+
+/** Tasks shared by the threads of runInParallel() */
+struct ParallelTasks {
+	std::function<void(uint32_t)> task;
+	uint32_t count;
+	uint32_t next;
+	/** Whether any task failed, and the message of the first */
+	bool failed;
+	std::string error;
+	pthread_mutex_t mutex;
+};
+
+extern "C" void *
+parallelTaskRunner(void *ptr)
+{
+	ParallelTasks *tasks = static_cast<ParallelTasks *>(ptr);
+	while (true) {
+		pthread_mutex_lock(&tasks->mutex);
+		/* Stop taking tasks after any failure */
+		if ((tasks->next >= tasks->count) || tasks->failed) {
+			pthread_mutex_unlock(&tasks->mutex);
+			break;
+		}
+		const uint32_t i = tasks->next++;
+		pthread_mutex_unlock(&tasks->mutex);
+
+		/* Exceptions must not escape the thread */
+		bool failed = false;
+		std::string error;
+		try {
+			tasks->task(i);
+		} catch (const BE::Error::Exception &e) {
+			failed = true;
+			error = e.whatString();
+		} catch (const std::exception &e) {
+			failed = true;
+			error = e.what();
+		}
+		if (failed) {
+			pthread_mutex_lock(&tasks->mutex);
+			if (!tasks->failed) {
+				tasks->failed = true;
+				tasks->error = error;
+			}
+			pthread_mutex_unlock(&tasks->mutex);
+		}
+	}
+	return (nullptr);
+}
+
+/*
+ * Run task(0) through task(count - 1) on up to numThreads threads,
+ * throwing StrategyError with the message of the first task that threw
+ * an Error::Exception or std::exception.
+ */
+static void
+runInParallel(
+    uint32_t numThreads,
+    uint32_t count,
+    const std::function<void(uint32_t)> &task)
+{
+	ParallelTasks tasks;
+	tasks.task = task;
+	tasks.count = count;
+	tasks.next = 0;
+	tasks.failed = false;
+	pthread_mutex_init(&tasks.mutex, nullptr);
+
+	std::vector<pthread_t> threads;
+	for (uint32_t i = 1; i < std::min(numThreads, count); i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, nullptr, parallelTaskRunner,
+		    &tasks) != 0)
+			break;
+		threads.push_back(thread);
+	}
+	parallelTaskRunner(&tasks);
+	for (auto &thread : threads)
+		pthread_join(thread, nullptr);
+	pthread_mutex_destroy(&tasks.mutex);
+
+	if (tasks.failed)
+		throw BE::Error::StrategyError(tasks.error);
+}
+
+/** Read exactly size bytes at offset, or throw */
+static void
+preadFully(
+    int fd,
+    char *buffer,
+    uint64_t size,
+    uint64_t offset,
+    const std::string &pathname)
+{
+	while (size > 0) {
+		ssize_t sz = pread(fd, buffer, size, offset);
+		if ((sz == -1) && (errno == EINTR))
+			continue;
+		if (sz <= 0)
+			throw BE::Error::FileError("Could not read " + pathname +
+			    ": " + BE::Error::errorStr());
+		buffer += sz;
+		size -= sz;
+		offset += sz;
+	}
+}
+
+/** Write exactly size bytes at offset, or throw */
+static void
+pwriteFully(
+    int fd,
+    const char *buffer,
+    uint64_t size,
+    uint64_t offset,
+    const std::string &pathname)
+{
+	while (size > 0) {
+		ssize_t sz = pwrite(fd, buffer, size, offset);
+		if ((sz == -1) && (errno == EINTR))
+			continue;
+		if (sz <= 0)
+			throw BE::Error::FileError("Could not write " +
+			    pathname + ": " + BE::Error::errorStr());
+		buffer += sz;
+		size -= sz;
+		offset += sz;
+	}
+}
+
+/** Where a sheet's body is read from and written to when merging */
+struct MergePlan {
+	std::string pathname;
+	/** Offset of the first line after the description */
+	uint64_t bodyStart;
+	/** Size of the sheet */
+	uint64_t size;
+	/** Whether the last line lacks a newline */
+	bool addNewline;
+	uint32_t entryCount;
+	/** Offset of the body in the merged sheet */
+	uint64_t outputOffset;
+	/** Number of the first entry in the merged sheet */
+	uint32_t firstNumber;
+};
+
+/*
+ * Find the body and entries of a sheet.
+ */
+static void
+planMerge(
+    MergePlan &plan)
+{
+	BE::IO::FileLogsheetReader reader(plan.pathname,
+	    BE::IO::FileLogsheetReader::IndexMode::ReadOnly);
+	plan.entryCount = reader.getEntryCount();
+	plan.size = BE::IO::Utility::getFileSize(plan.pathname);
+	plan.bodyStart = 0;
+	plan.addNewline = false;
+	if (plan.size == 0)
+		return;
+
+	int fd = open(plan.pathname.c_str(), O_RDONLY);
+	if (fd == -1)
+		throw BE::Error::FileError("Could not open " + plan.pathname +
+		    ": " + BE::Error::errorStr());
+	try {
+		char last;
+		preadFully(fd, &last, 1, plan.size - 1, plan.pathname);
+		plan.addNewline = (last != '\n');
+
+		/* Skip the description line */
+		const std::string &tag = BE::IO::Logsheet::DescriptionTag;
+		std::vector<char> buffer(std::min<uint64_t>(plan.size,
+		    std::max<uint64_t>(MERGEBLOCKSIZE, tag.size())));
+		preadFully(fd, buffer.data(), buffer.size(), 0, plan.pathname);
+		if ((buffer.size() >= tag.size()) &&
+		    (std::string(buffer.data(), tag.size()) == tag)) {
+			uint64_t offset = 0;
+			while (true) {
+				const char *newline = static_cast<const char*>(
+				    memchr(buffer.data(), '\n', buffer.size()));
+				if (newline != nullptr) {
+					plan.bodyStart = offset +
+					    (newline - buffer.data()) + 1;
+					break;
+				}
+				offset += buffer.size();
+				if (offset >= plan.size) {
+					plan.bodyStart = plan.size;
+					plan.addNewline = false;
+					break;
+				}
+				buffer.resize(std::min<uint64_t>(plan.size -
+				    offset, MERGEBLOCKSIZE));
+				preadFully(fd, buffer.data(), buffer.size(),
+				    offset, plan.pathname);
+			}
+		}
+	} catch (BE::Error::Exception &e) {
+		close(fd);
+		throw;
+	}
+	close(fd);
+}
+
+/*
+ * Copy the body of a sheet into the merged sheet, renumbering entries.
+ */
+static void
+copyBody(
+    const MergePlan &plan,
+    int outputFD,
+    const std::string &outputPathname)
+{
+	if (plan.bodyStart >= plan.size)
+		return;
+
+	int fd = open(plan.pathname.c_str(), O_RDONLY);
+	if (fd == -1)
+		throw BE::Error::FileError("Could not open " + plan.pathname +
+		    ": " + BE::Error::errorStr());
+	try {
+		std::vector<char> buffer(MERGEBLOCKSIZE);
+		uint64_t inputOffset = plan.bodyStart;
+		uint64_t outputOffset = plan.outputOffset;
+		uint64_t carried = 0;
+		uint32_t number = plan.firstNumber;
+		char digits[ENTRYNUMBERWIDTH + 1];
+		while ((inputOffset < plan.size) || (carried > 0)) {
+			/* Make room for a line longer than the buffer */
+			if (carried == buffer.size())
+				buffer.resize(buffer.size() * 2);
+			const uint64_t length = std::min<uint64_t>(
+			    buffer.size() - carried, plan.size - inputOffset);
+			preadFully(fd, buffer.data() + carried, length,
+			    inputOffset, plan.pathname);
+			inputOffset += length;
+			uint64_t available = carried + length;
+
+			/* Process only complete lines until the end */
+			uint64_t complete = available;
+			if (inputOffset < plan.size) {
+				const char *p = buffer.data() + available;
+				while ((p > buffer.data()) && (p[-1] != '\n'))
+					p--;
+				complete = p - buffer.data();
+				if (complete == 0) {
+					carried = available;
+					continue;
+				}
+			} else if (plan.addNewline) {
+				if (available == buffer.size())
+					buffer.resize(buffer.size() + 1);
+				buffer[available++] = '\n';
+				complete = available;
+			}
+
+			/* Renumber entries */
+			char *line = buffer.data();
+			char *end = buffer.data() + complete;
+			while (line < end) {
+				if ((end - line > 2) && (line[0] ==
+				    BE::IO::Logsheet::EntryDelimiter) &&
+				    (line[1] == ' ') && std::isdigit(line[2])) {
+					if ((uint64_t)(end - line) <
+					    ENTRYNUMBERWIDTH + 3 ||
+					    !std::all_of(line + 2, line + 2 +
+					    ENTRYNUMBERWIDTH, ::isdigit) ||
+					    (line[2 + ENTRYNUMBERWIDTH] != ' ' &&
+					    line[2 + ENTRYNUMBERWIDTH] != '\n'))
+						throw BE::Error::StrategyError(
+						    plan.pathname + " has an "
+						    "entry number that is not " +
+						    std::to_string(
+						    ENTRYNUMBERWIDTH) +
+						    " digits");
+					snprintf(digits, sizeof(digits),
+					    "%010u", number++);
+					memcpy(line + 2, digits,
+					    ENTRYNUMBERWIDTH);
+				}
+				line = static_cast<char*>(memchr(line, '\n',
+				    end - line)) + 1;
+			}
+
+			pwriteFully(outputFD, buffer.data(), complete,
+			    outputOffset, outputPathname);
+			outputOffset += complete;
+			carried = available - complete;
+			memmove(buffer.data(), buffer.data() + complete,
+			    carried);
+		}
+
+		if (number != plan.firstNumber + plan.entryCount)
+			throw BE::Error::StrategyError(plan.pathname + " "
+			    "changed while merging");
+	} catch (BE::Error::Exception &e) {
+		close(fd);
+		throw;
+	}
+	close(fd);
+}
+
+uint32_t
+BiometricEvaluation::IO::FileLogsheet::mergeLogsheets(
+    const std::vector<std::string> &urls,
+    const std::string &url,
+    const std::string &description,
+    uint32_t numThreads)
+{
+	std::string outputPathname;
+	if (parseURL(url, outputPathname) != true)
+		throw Error::ParameterError("Malformed URL");
+	if (IO::Utility::fileExists(outputPathname))
+		throw Error::ObjectExists(outputPathname);
+	if (numThreads == 0) {
+		const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+		numThreads = (processors > 0) ? processors : 1;
+	}
+
+	std::vector<MergePlan> plans(urls.size());
+	for (uint32_t i = 0; i < urls.size(); i++) {
+		if (parseURL(urls[i], plans[i].pathname) != true)
+			throw Error::ParameterError("Malformed URL");
+		if (!IO::Utility::fileExists(plans[i].pathname))
+			throw Error::ObjectDoesNotExist(plans[i].pathname);
+	}
+
+	/* Size every body, then place each one after the last */
+	runInParallel(numThreads, plans.size(), [&](uint32_t i) {
+		planMerge(plans[i]);
+	});
+	const std::string header = DescriptionTag + " " + description + '\n';
+	uint64_t outputSize = header.size();
+	uint64_t entryCount = 0;
+	for (auto &plan : plans) {
+		plan.outputOffset = outputSize;
+		plan.firstNumber = entryCount + 1;
+		outputSize += (plan.size - plan.bodyStart) +
+		    (plan.addNewline ? 1 : 0);
+		entryCount += plan.entryCount;
+	}
+	if (entryCount >= UINT32_MAX)
+		throw Error::StrategyError("Too many entries to merge");
+
+	int fd = open(outputPathname.c_str(), O_WRONLY | O_CREAT | O_EXCL,
+	    S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fd == -1)
+		throw Error::FileError("Could not create " + outputPathname +
+		    ": " + Error::errorStr());
+	try {
+		if (ftruncate(fd, outputSize) != 0)
+			throw Error::FileError("Could not size " +
+			    outputPathname + ": " + Error::errorStr());
+		pwriteFully(fd, header.data(), header.size(), 0,
+		    outputPathname);
+		runInParallel(numThreads, plans.size(), [&](uint32_t i) {
+			copyBody(plans[i], fd, outputPathname);
+		});
+	} catch (Error::Exception &e) {
+		close(fd);
+		unlink(outputPathname.c_str());
+		throw;
+	}
+	if (close(fd) != 0)
+		throw Error::FileError("Could not close " + outputPathname +
+		    ": " + Error::errorStr());
+
+	return (entryCount);
+}
+
+uint32_t
+BiometricEvaluation::IO::FileLogsheet::mergeLogsheets(
+    const std::vector<std::string> &urls,
+    const std::string &url,
+    const std::string &description,
+    const std::function<bool(const std::string &first,
+    const std::string &second)> &before)
+{
+	std::vector<std::unique_ptr<FileLogsheetReader>> readers;
+	for (const auto &inputURL : urls)
+		readers.emplace_back(new FileLogsheetReader(inputURL,
+		    FileLogsheetReader::IndexMode::ReadOnly));
+
+	/* Entry text after the delimiter and number */
+	const auto entryText = [&](uint32_t sheet, uint32_t number) {
+		const std::string entry = readers[sheet]->getEntry(number,
+		    false);
+		const std::string::size_type start = entry.find(' ', 2);
+		return ((start == std::string::npos) ? std::string() :
+		    entry.substr(start + 1));
+	};
+
+	/* Next entry of each sheet, earliest on top */
+	struct Head {
+		std::string entry;
+		uint32_t sheet;
+		uint32_t number;
+	};
+	const auto later = [&](const Head &a, const Head &b) {
+		if (before(b.entry, a.entry))
+			return (true);
+		/* Keep the order of the sheets for equal entries */
+		return (!before(a.entry, b.entry) && (a.sheet > b.sheet));
+	};
+	std::priority_queue<Head, std::vector<Head>, decltype(later)>
+	    heads(later);
+	for (uint32_t i = 0; i < readers.size(); i++)
+		if (readers[i]->getEntryCount() > 0)
+			heads.push({entryText(i, 1), i, 1});
+
+	FileLogsheet merged(url, description);
+	merged.setAsynchronous(true);
+	uint32_t entryCount = 0;
+	while (!heads.empty()) {
+		const Head head = heads.top();
+		heads.pop();
+		merged.write(head.entry);
+		entryCount++;
+		if (head.number < readers[head.sheet]->getEntryCount())
+			heads.push({entryText(head.sheet, head.number + 1),
+			    head.sheet, head.number + 1});
+	}
+	merged.setAsynchronous(false);
+	merged.sync();
+
+	return (entryCount);
+}
+
 BiometricEvaluation::IO::FileLogsheet::~FileLogsheet()
 {
+	try {
+		this->setAsynchronous(false);
+	} catch (Error::Exception &e) {
+		/* Nothing can be done about lost entries now */
+	}
 	_theLogFile->close();
 }
 
@@ -0,0 +1,372 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+#include <be_error.h>
+#include <be_error_exception.h>
+#include <be_io_filelogsheetreader.h>
+#include <be_io_logsheet.h>
+#include <be_io_utility.h>
+
+namespace BE = BiometricEvaluation;
+
+/** Identifies a FileLogsheet index ("BELSIX01") */
+static const uint64_t LOGSHEETINDEXMAGIC = 0x42454C5349583031ULL;
+
+/** @return pathname named by a path name or file:// URL */
+static std::string
+pathnameFromURL(
+    const std::string &url)
+{
+	BE::IO::Logsheet::Kind kind;
+	try {
+		kind = BE::IO::Logsheet::getTypeFromURL(url);
+	} catch (BE::Error::Exception &e) {
+		/* No scheme, so url is a path name */
+		return (url);
+	}
+	if (kind != BE::IO::Logsheet::Kind::File)
+		throw BE::Error::ParameterError("Not a file URL");
+	return (url.substr(url.find("://") + 3));
+}
+
+/** @return Whether a line starting at p begins an entry, comment, or debug */
+static inline bool
+lineIsRecord(
+    const char *p,
+    uint64_t available)
+{
+	if (available == 0)
+		return (false);
+	switch (p[0]) {
+	case BE::IO::Logsheet::CommentDelimiter:
+		return (true);
+	case BE::IO::Logsheet::EntryDelimiter:
+		return ((available > 2) && (p[1] == ' ') &&
+		    std::isdigit(p[2]));
+	case BE::IO::Logsheet::DebugDelimiter:
+		return ((available > 1) && (p[1] == ' '));
+	default:
+		return (false);
+	}
+}
+
+BiometricEvaluation::IO::FileLogsheetReader::FileLogsheetReader(
+    const std::string &url,
+    IndexMode indexMode) :
+    _pathname(pathnameFromURL(url)),
+    _map(nullptr),
+    _size(0)
+{
+	if (!IO::Utility::fileExists(this->_pathname))
+		throw Error::ObjectDoesNotExist(this->_pathname);
+
+	int fd = open(this->_pathname.c_str(), O_RDONLY);
+	if (fd == -1)
+		throw Error::FileError("Could not open " + this->_pathname +
+		    ": " + Error::errorStr());
+	struct stat sb;
+	if (fstat(fd, &sb) != 0) {
+		close(fd);
+		throw Error::FileError("Could not stat " + this->_pathname +
+		    ": " + Error::errorStr());
+	}
+	this->_size = sb.st_size;
+	if (this->_size != 0) {
+		void *map = mmap(nullptr, this->_size, PROT_READ, MAP_SHARED,
+		    fd, 0);
+		if (map == MAP_FAILED) {
+			close(fd);
+			throw Error::FileError("Could not map " +
+			    this->_pathname + ": " + Error::errorStr());
+		}
+		this->_map = static_cast<const char*>(map);
+	}
+	close(fd);
+
+	try {
+		bool rewrite = false;
+		if (indexMode != IndexMode::None)
+			rewrite = this->loadIndex();
+		const uint64_t indexed = this->_offsets.size();
+
+		/* Continue from the line after the last indexed entry */
+		uint64_t offset = 0;
+		if (!this->_offsets.empty()) {
+			const char *newline = static_cast<const char*>(memchr(
+			    this->_map + this->_offsets.back(), '\n',
+			    this->_size - this->_offsets.back()));
+			offset = (newline == nullptr) ? this->_size :
+			    (newline - this->_map) + 1;
+		}
+		this->scan(offset);
+
+		if ((indexMode == IndexMode::Update) && (rewrite ||
+		    (this->_offsets.size() != indexed) ||
+		    !IO::Utility::fileExists(getIndexPathname(
+		    this->_pathname))))
+			this->writeIndex(rewrite ? 0 : indexed, rewrite ||
+			    (indexed == 0));
+	} catch (Error::Exception &e) {
+		if (this->_map != nullptr)
+			munmap(const_cast<char*>(this->_map), this->_size);
+		throw;
+	}
+}
+
+bool
+BiometricEvaluation::IO::FileLogsheetReader::isEntryAt(
+    uint64_t offset)
+    const
+{
+	if (offset >= this->_size)
+		return (false);
+	if ((offset != 0) && (this->_map[offset - 1] != '\n'))
+		return (false);
+	return ((this->_map[offset] == Logsheet::EntryDelimiter) &&
+	    lineIsRecord(this->_map + offset, this->_size - offset));
+}
+
+bool
+BiometricEvaluation::IO::FileLogsheetReader::loadIndex()
+{
+	const std::string indexPathname = getIndexPathname(this->_pathname);
+	int fd = open(indexPathname.c_str(), O_RDONLY);
+	if (fd == -1)
+		return (false);
+
+	struct stat sb;
+	uint64_t magic = 0;
+	if ((fstat(fd, &sb) != 0) || (sb.st_size < (off_t)sizeof(magic)) ||
+	    ((sb.st_size % sizeof(uint64_t)) != 0) ||
+	    (::read(fd, &magic, sizeof(magic)) != sizeof(magic)) ||
+	    (magic != LOGSHEETINDEXMAGIC)) {
+		close(fd);
+		return (true);
+	}
+
+	this->_offsets.resize((sb.st_size / sizeof(uint64_t)) - 1);
+	uint64_t remaining = this->_offsets.size() * sizeof(uint64_t);
+	char *destination = (char *)this->_offsets.data();
+	while (remaining > 0) {
+		ssize_t sz = ::read(fd, destination, remaining);
+		if (sz == -1 && errno == EINTR)
+			continue;
+		if (sz <= 0) {
+			close(fd);
+			this->_offsets.clear();
+			return (true);
+		}
+		destination += sz;
+		remaining -= sz;
+	}
+	close(fd);
+
+	/* Keep the prefix of increasing offsets */
+	bool rewrite = false;
+	for (uint64_t i = 1; i < this->_offsets.size(); i++) {
+		if (this->_offsets[i] <= this->_offsets[i - 1]) {
+			this->_offsets.resize(i);
+			rewrite = true;
+			break;
+		}
+	}
+
+	/* Drop entries written to the index but not to the log */
+	while (!this->_offsets.empty() &&
+	    !this->isEntryAt(this->_offsets.back())) {
+		this->_offsets.pop_back();
+		rewrite = true;
+	}
+	if (!this->_offsets.empty() && !this->isEntryAt(this->_offsets[0])) {
+		this->_offsets.clear();
+		rewrite = true;
+	}
+	return (rewrite);
+}
+
+void
+BiometricEvaluation::IO::FileLogsheetReader::scan(
+    uint64_t offset)
+{
+	const char *p = this->_map + offset;
+	const char *end = this->_map + this->_size;
+	while (p < end) {
+		if ((*p == Logsheet::EntryDelimiter) &&
+		    lineIsRecord(p, end - p))
+			this->_offsets.push_back(p - this->_map);
+		p = static_cast<const char*>(memchr(p, '\n', end - p));
+		if (p == nullptr)
+			break;
+		p++;
+	}
+}
+
+void
+BiometricEvaluation::IO::FileLogsheetReader::writeIndex(
+    uint64_t first,
+    bool rewrite)
+    const
+{
+	const std::string indexPathname = getIndexPathname(this->_pathname);
+	const std::string pathname = rewrite ? indexPathname + ".tmp" :
+	    indexPathname;
+	int fd = open(pathname.c_str(), O_WRONLY | O_CREAT |
+	    (rewrite ? O_TRUNC : O_APPEND), S_IRUSR | S_IWUSR | S_IRGRP |
+	    S_IROTH);
+	if (fd == -1)
+		throw Error::FileError("Could not open " + pathname + ": " +
+		    Error::errorStr());
+
+	bool success = true;
+	if (rewrite)
+		success = (::write(fd, &LOGSHEETINDEXMAGIC,
+		    sizeof(LOGSHEETINDEXMAGIC)) == sizeof(LOGSHEETINDEXMAGIC));
+	const char *source = (const char *)(this->_offsets.data() + first);
+	uint64_t remaining = (this->_offsets.size() - first) *
+	    sizeof(uint64_t);
+	while (success && (remaining > 0)) {
+		ssize_t sz = ::write(fd, source, remaining);
+		if (sz == -1 && errno == EINTR)
+			continue;
+		if (sz <= 0) {
+			success = false;
+			break;
+		}
+		source += sz;
+		remaining -= sz;
+	}
+	if (close(fd) != 0)
+		success = false;
+	if (success && rewrite)
+		success = (rename(pathname.c_str(),
+		    indexPathname.c_str()) == 0);
+	if (!success) {
+		const std::string error = Error::errorStr();
+		if (rewrite)
+			unlink(pathname.c_str());
+		throw Error::FileError("Could not write " + indexPathname +
+		    ": " + error);
+	}
+}
+
+uint32_t
+BiometricEvaluation::IO::FileLogsheetReader::getEntryCount()
+    const
+{
+	return (this->_offsets.size());
+}
+
+uint64_t
+BiometricEvaluation::IO::FileLogsheetReader::getEntryOffset(
+    uint32_t number)
+    const
+{
+	if ((number == 0) || (number > this->_offsets.size()))
+		throw Error::ObjectDoesNotExist("Entry " +
+		    std::to_string(number));
+	return (this->_offsets[number - 1]);
+}
+
+std::string
+BiometricEvaluation::IO::FileLogsheetReader::getEntry(
+    uint32_t number,
+    bool trim)
+    const
+{
+	const uint64_t start = this->getEntryOffset(number);
+
+	/* Continuation lines run until the next entry, comment, or debug */
+	const char *end = this->_map + this->_size;
+	const char *p = this->_map + start;
+	const char *last = end;
+	while (true) {
+		const char *newline = static_cast<const char*>(memchr(p, '\n',
+		    end - p));
+		if (newline == nullptr)
+			break;
+		p = newline + 1;
+		if ((p == end) || lineIsRecord(p, end - p)) {
+			last = newline;
+			break;
+		}
+	}
+
+	const std::string entry(this->_map + start, last - (this->_map + start));
+	return (trim ? Logsheet::trim(entry) : entry);
+}
+
+std::vector<std::pair<uint32_t, uint32_t>>
+BiometricEvaluation::IO::FileLogsheetReader::partition(
+    uint32_t count)
+    const
+{
+	std::vector<std::pair<uint32_t, uint32_t>> ranges;
+	const uint32_t entries = this->getEntryCount();
+	if ((count == 0) || (entries == 0))
+		return (ranges);
+	if (count > entries)
+		count = entries;
+
+	uint32_t first = 1;
+	for (uint32_t i = 0; i < count; i++) {
+		const uint32_t size = (entries / count) +
+		    ((i < (entries % count)) ? 1 : 0);
+		ranges.push_back(std::make_pair(first, first + size - 1));
+		first += size;
+	}
+	return (ranges);
+}
+
+void
+BiometricEvaluation::IO::FileLogsheetReader::forEachEntry(
+    uint32_t first,
+    uint32_t last,
+    const std::function<void(uint32_t number,
+    const std::string &entry)> &visitor)
+    const
+{
+	this->getEntryOffset(first);
+	this->getEntryOffset(last);
+	for (uint32_t number = first; number <= last; number++)
+		visitor(number, this->getEntry(number));
+}
+
+std::string
+BiometricEvaluation::IO::FileLogsheetReader::getIndexPathname(
+    const std::string &pathname)
+{
+	return (pathname + ".index");
+}
+
+uint32_t
+BiometricEvaluation::IO::FileLogsheetReader::updateIndex(
+    const std::string &url)
+{
+	FileLogsheetReader reader(url, IndexMode::Update);
+	return (reader.getEntryCount());
+}
+
+BiometricEvaluation::IO::FileLogsheetReader::~FileLogsheetReader()
+{
+	if (this->_map != nullptr)
+		munmap(const_cast<char*>(this->_map), this->_size);
+}
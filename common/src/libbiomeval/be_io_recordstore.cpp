@@ -59,6 +59,14 @@ BiometricEvaluation::IO::RecordStore::insert(
 	this->insert(key, data, data.size());
 }
 
+void
+BiometricEvaluation::IO::RecordStore::insert(
+    const std::string &key,
+    const Memory::ByteView &data)
+{
+	this->insert(key, data.data(), data.size());
+}
+
 void
 BiometricEvaluation::IO::RecordStore::replace(
     const std::string &key,
@@ -67,6 +75,14 @@ BiometricEvaluation::IO::RecordStore::replace(
 	this->replace(key, data, data.size());
 }
 
+void
+BiometricEvaluation::IO::RecordStore::replace(
+    const std::string &key,
+    const Memory::ByteView &data)
+{
+	this->replace(key, data.data(), data.size());
+}
+
 void
 BiometricEvaluation::IO::RecordStore::replace(
     const std::string &key,
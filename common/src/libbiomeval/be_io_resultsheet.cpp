@@ -0,0 +1,668 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <set>
+
+#include <be_error.h>
+#include <be_error_exception.h>
+#include <be_io_compressor.h>
+#include <be_io_resultsheet.h>
+#include <be_io_utility.h>
+
+namespace BE = BiometricEvaluation;
+
+/** Identifies a ResultSheet file ("BERSLT01") */
+static const uint64_t RESULTSHEETMAGIC = 0x424552534C543031ULL;
+/** Identifies a block of a ResultSheet ("BLK1") */
+static const uint32_t BLOCKMAGIC = 0x424C4B31;
+/** Reads differently when written with another byte order */
+static const uint32_t BYTEORDERMARK = 0x01020304;
+/** Alignment of blocks and of each column within a block */
+static const uint64_t CHUNKALIGNMENT = 8;
+
+/** @return value rounded up to the chunk alignment */
+static inline uint64_t
+align(
+    const uint64_t value)
+{
+	return (((value + CHUNKALIGNMENT - 1) / CHUNKALIGNMENT) *
+	    CHUNKALIGNMENT);
+}
+
+/** Fixed portion of the file header, followed by the schema */
+struct FileHeader
+{
+	uint64_t magic;
+	uint32_t byteOrder;
+	uint32_t columnCount;
+	uint32_t rowsPerBlock;
+	uint32_t descriptionLength;
+};
+
+struct BiometricEvaluation::IO::ResultSheet::BlockHeader
+{
+	uint32_t magic;
+	/** Number of rows in the block */
+	uint32_t rowCount;
+	/** Size of the block, including this header */
+	uint64_t blockSize;
+};
+
+struct BiometricEvaluation::IO::ResultSheet::ChunkEntry
+{
+	/** Offset of the column from the start of the block */
+	uint64_t offset;
+	/** Size of the column as stored */
+	uint64_t storedLength;
+	/** Size of the column when not compressed */
+	uint64_t rawLength;
+	/** Whether or not the column is compressed */
+	uint32_t compressed;
+	uint32_t reserved;
+};
+
+/*
+ * StringColumn.
+ */
+
+BiometricEvaluation::IO::ResultSheet::StringColumn::StringColumn(
+    const uint64_t *offsets,
+    const char *data,
+    uint64_t rowCount) :
+    _offsets(offsets),
+    _data(data),
+    _rowCount(rowCount)
+{
+
+}
+
+uint64_t
+BiometricEvaluation::IO::ResultSheet::StringColumn::size()
+    const
+{
+	return (this->_rowCount);
+}
+
+const char*
+BiometricEvaluation::IO::ResultSheet::StringColumn::data(
+    uint64_t row)
+    const
+{
+	return (this->_data + this->_offsets[row]);
+}
+
+uint64_t
+BiometricEvaluation::IO::ResultSheet::StringColumn::length(
+    uint64_t row)
+    const
+{
+	return (this->_offsets[row + 1] - this->_offsets[row]);
+}
+
+std::string
+BiometricEvaluation::IO::ResultSheet::StringColumn::operator[](
+    uint64_t row)
+    const
+{
+	return (std::string(this->data(row), this->length(row)));
+}
+
+/*
+ * Creating.
+ */
+
+BiometricEvaluation::IO::ResultSheet::ResultSheet(
+    const std::string &pathname,
+    const std::vector<Column> &schema,
+    const std::string &description,
+    uint32_t rowsPerBlock,
+    bool compress) :
+    _pathname(pathname),
+    _schema(schema),
+    _description(description),
+    _readOnly(false),
+    _rowsPerBlock(rowsPerBlock),
+    _compress(compress),
+    _buffers(schema.size()),
+    _nextColumn(0),
+    _bufferedRows(0),
+    _writtenRows(0),
+    _map(nullptr),
+    _mapSize(0),
+    _rowCount(0),
+    _decompressedBlock(0)
+{
+	if (schema.empty())
+		throw Error::ParameterError("Schema has no columns");
+	if (rowsPerBlock == 0)
+		throw Error::ParameterError("rowsPerBlock must be non-zero");
+	std::set<std::string> names;
+	for (const auto &column : schema) {
+		if (!names.insert(column.name).second)
+			throw Error::ParameterError("Duplicate column name: " +
+			    column.name);
+		if ((column.type != Type::Integer) &&
+		    (column.type != Type::Real) &&
+		    (column.type != Type::String))
+			throw Error::ParameterError("Invalid type for column " +
+			    column.name);
+	}
+	if (IO::Utility::fileExists(pathname))
+		throw Error::ObjectExists(pathname);
+
+	this->_file.reset(new std::ofstream(pathname,
+	    std::ios_base::out | std::ios_base::binary));
+	if (!this->_file->good())
+		throw Error::FileError("Could not create " + pathname);
+
+	FileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = RESULTSHEETMAGIC;
+	header.byteOrder = BYTEORDERMARK;
+	header.columnCount = schema.size();
+	header.rowsPerBlock = rowsPerBlock;
+	header.descriptionLength = description.size();
+	this->_file->write((const char *)&header, sizeof(header));
+	this->_file->write(description.data(), description.size());
+	uint64_t length = sizeof(header) + description.size();
+	for (const auto &column : schema) {
+		const uint8_t type = static_cast<uint8_t>(column.type);
+		const uint32_t nameLength = column.name.size();
+		this->_file->write((const char *)&type, sizeof(type));
+		this->_file->write((const char *)&nameLength,
+		    sizeof(nameLength));
+		this->_file->write(column.name.data(), nameLength);
+		length += sizeof(type) + sizeof(nameLength) + nameLength;
+	}
+	static const char padding[CHUNKALIGNMENT] = {0};
+	this->_file->write(padding, align(length) - length);
+	this->_file->flush();
+	if (!this->_file->good())
+		throw Error::FileError("Could not write header to " +
+		    pathname);
+
+	for (uint32_t i = 0; i < schema.size(); i++) {
+		if (schema[i].type == Type::String) {
+			this->_buffers[i].offsets.reserve(rowsPerBlock + 1);
+			this->_buffers[i].offsets.push_back(0);
+		} else
+			this->_buffers[i].values.reserve(rowsPerBlock *
+			    sizeof(uint64_t));
+	}
+}
+
+BiometricEvaluation::IO::ResultSheet::ColumnBuffer&
+BiometricEvaluation::IO::ResultSheet::nextColumn(
+    Type type)
+{
+	if (this->_readOnly)
+		throw Error::StrategyError("ResultSheet was opened for "
+		    "reading");
+	if (this->_nextColumn >= this->_schema.size())
+		throw Error::ParameterError("Row is complete");
+	if (this->_schema[this->_nextColumn].type != type)
+		throw Error::ParameterError("Wrong type for column " +
+		    this->_schema[this->_nextColumn].name);
+	return (this->_buffers[this->_nextColumn++]);
+}
+
+void
+BiometricEvaluation::IO::ResultSheet::appendInteger(
+    int64_t value)
+{
+	ColumnBuffer &buffer = this->nextColumn(Type::Integer);
+	const uint8_t *bytes = (const uint8_t *)&value;
+	buffer.values.insert(buffer.values.end(), bytes, bytes + sizeof(value));
+}
+
+void
+BiometricEvaluation::IO::ResultSheet::appendReal(
+    double value)
+{
+	ColumnBuffer &buffer = this->nextColumn(Type::Real);
+	const uint8_t *bytes = (const uint8_t *)&value;
+	buffer.values.insert(buffer.values.end(), bytes, bytes + sizeof(value));
+}
+
+void
+BiometricEvaluation::IO::ResultSheet::appendString(
+    const std::string &value)
+{
+	ColumnBuffer &buffer = this->nextColumn(Type::String);
+	buffer.values.insert(buffer.values.end(), value.begin(), value.end());
+	buffer.offsets.push_back(buffer.values.size());
+}
+
+void
+BiometricEvaluation::IO::ResultSheet::endRow()
+{
+	if (this->_readOnly)
+		throw Error::StrategyError("ResultSheet was opened for "
+		    "reading");
+	if (this->_nextColumn != this->_schema.size())
+		throw Error::ParameterError("Row is incomplete");
+
+	this->_nextColumn = 0;
+	if (++this->_bufferedRows == this->_rowsPerBlock)
+		this->writeBlock();
+}
+
+void
+BiometricEvaluation::IO::ResultSheet::sync()
+{
+	if (this->_readOnly)
+		throw Error::StrategyError("ResultSheet was opened for "
+		    "reading");
+	if (this->_nextColumn != 0)
+		throw Error::ParameterError("Row is incomplete");
+	if (this->_bufferedRows != 0)
+		this->writeBlock();
+	this->_file->flush();
+	if (!this->_file->good())
+		throw Error::FileError("Could not flush " + this->_pathname);
+}
+
+void
+BiometricEvaluation::IO::ResultSheet::writeBlock()
+{
+	/* Discard the values of an incomplete row (from destructor) */
+	if (this->_nextColumn != 0) {
+		for (uint32_t i = 0; i < this->_nextColumn; i++) {
+			ColumnBuffer &buffer = this->_buffers[i];
+			if (this->_schema[i].type == Type::String) {
+				buffer.offsets.pop_back();
+				buffer.values.resize(buffer.offsets.back());
+			} else
+				buffer.values.resize(buffer.values.size() -
+				    sizeof(uint64_t));
+		}
+		this->_nextColumn = 0;
+	}
+	if (this->_bufferedRows == 0)
+		return;
+
+	const uint32_t columnCount = this->_schema.size();
+	std::vector<ChunkEntry> entries(columnCount);
+	std::vector<Memory::uint8Array> compressed(columnCount);
+	std::shared_ptr<Compressor> compressor;
+	if (this->_compress)
+		compressor = Compressor::createCompressor(
+		    Compressor::Kind::GZIP);
+
+	uint64_t offset = align(sizeof(BlockHeader) +
+	    (columnCount * sizeof(ChunkEntry)));
+	for (uint32_t i = 0; i < columnCount; i++) {
+		ColumnBuffer &buffer = this->_buffers[i];
+		/* Strings are stored as offsets followed by bytes */
+		if (this->_schema[i].type == Type::String) {
+			const uint8_t *offsets = (const uint8_t *)
+			    buffer.offsets.data();
+			buffer.values.insert(buffer.values.begin(), offsets,
+			    offsets + (buffer.offsets.size() *
+			    sizeof(uint64_t)));
+		}
+
+		memset(&entries[i], 0, sizeof(ChunkEntry));
+		entries[i].offset = offset;
+		entries[i].rawLength = buffer.values.size();
+		entries[i].storedLength = entries[i].rawLength;
+		if (compressor && !buffer.values.empty()) {
+			compressed[i] = compressor->compress(
+			    buffer.values.data(), buffer.values.size());
+			if (compressed[i].size() < buffer.values.size()) {
+				entries[i].compressed = 1;
+				entries[i].storedLength = compressed[i].size();
+			}
+		}
+		offset = align(offset + entries[i].storedLength);
+	}
+
+	BlockHeader header;
+	header.magic = BLOCKMAGIC;
+	header.rowCount = this->_bufferedRows;
+	header.blockSize = offset;
+	this->_file->write((const char *)&header, sizeof(header));
+	this->_file->write((const char *)entries.data(),
+	    columnCount * sizeof(ChunkEntry));
+
+	static const char padding[CHUNKALIGNMENT] = {0};
+	uint64_t written = sizeof(header) + (columnCount * sizeof(ChunkEntry));
+	for (uint32_t i = 0; i < columnCount; i++) {
+		this->_file->write(padding, entries[i].offset - written);
+		if (entries[i].compressed)
+			this->_file->write((const char *)&compressed[i][0],
+			    entries[i].storedLength);
+		else
+			this->_file->write((const char *)
+			    this->_buffers[i].values.data(),
+			    entries[i].storedLength);
+		written = entries[i].offset + entries[i].storedLength;
+	}
+	this->_file->write(padding, header.blockSize - written);
+	if (!this->_file->good())
+		throw Error::FileError("Could not write block to " +
+		    this->_pathname);
+
+	this->_writtenRows += this->_bufferedRows;
+	this->_bufferedRows = 0;
+	for (uint32_t i = 0; i < columnCount; i++) {
+		this->_buffers[i].values.clear();
+		if (this->_schema[i].type == Type::String) {
+			this->_buffers[i].offsets.clear();
+			this->_buffers[i].offsets.push_back(0);
+		}
+	}
+}
+
+/*
+ * Opening.
+ */
+
+BiometricEvaluation::IO::ResultSheet::ResultSheet(
+    const std::string &pathname) :
+    _pathname(pathname),
+    _readOnly(true),
+    _rowsPerBlock(0),
+    _compress(false),
+    _nextColumn(0),
+    _bufferedRows(0),
+    _writtenRows(0),
+    _map(nullptr),
+    _mapSize(0),
+    _rowCount(0),
+    _decompressedBlock(0)
+{
+	if (!IO::Utility::fileExists(pathname))
+		throw Error::ObjectDoesNotExist(pathname);
+
+	int fd = open(pathname.c_str(), O_RDONLY);
+	if (fd == -1)
+		throw Error::FileError("Could not open " + pathname + ": " +
+		    Error::errorStr());
+	struct stat sb;
+	if (fstat(fd, &sb) != 0) {
+		close(fd);
+		throw Error::FileError("Could not stat " + pathname + ": " +
+		    Error::errorStr());
+	}
+	this->_mapSize = sb.st_size;
+	if (this->_mapSize < sizeof(FileHeader)) {
+		close(fd);
+		throw Error::StrategyError(pathname + " is not a ResultSheet");
+	}
+	void *map = mmap(nullptr, this->_mapSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		throw Error::FileError("Could not map " + pathname + ": " +
+		    Error::errorStr());
+	this->_map = static_cast<const uint8_t*>(map);
+	/* Columns are generally read from start to end */
+	madvise(map, this->_mapSize, MADV_SEQUENTIAL);
+
+	try {
+		FileHeader header;
+		memcpy(&header, this->_map, sizeof(header));
+		if (header.magic != RESULTSHEETMAGIC)
+			throw Error::StrategyError(pathname + " is not a "
+			    "ResultSheet");
+		if (header.byteOrder != BYTEORDERMARK)
+			throw Error::StrategyError(pathname + " was written "
+			    "with a different byte order");
+		this->_rowsPerBlock = header.rowsPerBlock;
+
+		/* Schema */
+		uint64_t offset = sizeof(header);
+		if (offset + header.descriptionLength > this->_mapSize)
+			throw Error::StrategyError("Truncated header");
+		this->_description.assign((const char *)this->_map + offset,
+		    header.descriptionLength);
+		offset += header.descriptionLength;
+		for (uint32_t i = 0; i < header.columnCount; i++) {
+			uint8_t type;
+			uint32_t nameLength;
+			if (offset + sizeof(type) + sizeof(nameLength) >
+			    this->_mapSize)
+				throw Error::StrategyError("Truncated header");
+			memcpy(&type, this->_map + offset, sizeof(type));
+			offset += sizeof(type);
+			memcpy(&nameLength, this->_map + offset,
+			    sizeof(nameLength));
+			offset += sizeof(nameLength);
+			if (offset + nameLength > this->_mapSize)
+				throw Error::StrategyError("Truncated header");
+			this->_schema.push_back({std::string((const char *)
+			    this->_map + offset, nameLength),
+			    static_cast<Type>(type)});
+			offset += nameLength;
+		}
+		offset = align(offset);
+
+		/* Index the complete blocks */
+		const uint64_t entriesSize = this->_schema.size() *
+		    sizeof(ChunkEntry);
+		while (offset + sizeof(BlockHeader) + entriesSize <=
+		    this->_mapSize) {
+			const BlockHeader *block = (const BlockHeader *)
+			    (this->_map + offset);
+			if (block->magic != BLOCKMAGIC)
+				throw Error::StrategyError("Corrupt block "
+				    "header at offset " +
+				    std::to_string(offset));
+			if (block->blockSize < sizeof(BlockHeader) +
+			    entriesSize)
+				throw Error::DataError("Invalid size of block "
+				    "at offset " + std::to_string(offset));
+			/* Ignore an incomplete final block */
+			if (block->blockSize > this->_mapSize - offset)
+				break;
+			this->_blocks.push_back(this->_map + offset);
+			this->_rowCount += block->rowCount;
+			offset += block->blockSize;
+		}
+	} catch (Error::Exception &e) {
+		munmap(const_cast<uint8_t*>(this->_map), this->_mapSize);
+		throw;
+	}
+}
+
+uint64_t
+BiometricEvaluation::IO::ResultSheet::getBlockCount()
+    const
+{
+	return (this->_blocks.size());
+}
+
+uint64_t
+BiometricEvaluation::IO::ResultSheet::getBlockRowCount(
+    uint64_t block)
+    const
+{
+	if (block >= this->_blocks.size())
+		throw Error::ObjectDoesNotExist("Block " +
+		    std::to_string(block));
+	return (((const BlockHeader *)this->_blocks[block])->rowCount);
+}
+
+const uint8_t*
+BiometricEvaluation::IO::ResultSheet::getChunk(
+    uint64_t block,
+    uint32_t column,
+    Type type,
+    uint64_t &length)
+{
+	if (!this->_readOnly)
+		throw Error::StrategyError("ResultSheet was created, not "
+		    "opened");
+	if (block >= this->_blocks.size())
+		throw Error::ObjectDoesNotExist("Block " +
+		    std::to_string(block));
+	if (column >= this->_schema.size())
+		throw Error::ObjectDoesNotExist("Column " +
+		    std::to_string(column));
+	if (this->_schema[column].type != type)
+		throw Error::ParameterError("Wrong type for column " +
+		    this->_schema[column].name);
+
+	const uint8_t *start = this->_blocks[block];
+	const BlockHeader *header = (const BlockHeader *)start;
+	const ChunkEntry *entry = (const ChunkEntry *)(start +
+	    sizeof(BlockHeader)) + column;
+	if ((entry->offset > header->blockSize) ||
+	    (entry->storedLength > header->blockSize - entry->offset))
+		throw Error::DataError("Column " + this->_schema[column].name +
+		    " extends past block " + std::to_string(block));
+
+	/* Integers and Reals, or String offsets, for each row */
+	const uint64_t minimumLength = (static_cast<uint64_t>(
+	    header->rowCount) + (type == Type::String ? 1 : 0)) *
+	    sizeof(uint64_t);
+	length = (entry->compressed ? entry->rawLength : entry->storedLength);
+	if (length < minimumLength)
+		throw Error::DataError("Column " + this->_schema[column].name +
+		    " of block " + std::to_string(block) + " is too small "
+		    "for its rows");
+	if (!entry->compressed)
+		return (start + entry->offset);
+
+	if ((this->_decompressedBlock != block) ||
+	    this->_decompressed.empty()) {
+		this->_decompressed.clear();
+		this->_decompressed.resize(this->_schema.size());
+		this->_decompressedBlock = block;
+	}
+	Memory::uint8Array &chunk = this->_decompressed[column];
+	if (chunk.size() != entry->rawLength) {
+		try {
+			chunk = Compressor::createCompressor(
+			    Compressor::Kind::GZIP)->decompress(
+			    start + entry->offset, entry->storedLength);
+		} catch (Error::Exception &e) {
+			throw Error::StrategyError("Could not decompress "
+			    "column " + this->_schema[column].name + ": " +
+			    e.whatString());
+		}
+		if (chunk.size() != entry->rawLength)
+			throw Error::StrategyError("Column " +
+			    this->_schema[column].name + " decompressed to "
+			    "the wrong size");
+	}
+	return (&chunk[0]);
+}
+
+const int64_t*
+BiometricEvaluation::IO::ResultSheet::getIntegerColumn(
+    uint64_t block,
+    uint32_t column)
+{
+	uint64_t length;
+	return ((const int64_t *)this->getChunk(block, column, Type::Integer,
+	    length));
+}
+
+const double*
+BiometricEvaluation::IO::ResultSheet::getRealColumn(
+    uint64_t block,
+    uint32_t column)
+{
+	uint64_t length;
+	return ((const double *)this->getChunk(block, column, Type::Real,
+	    length));
+}
+
+BiometricEvaluation::IO::ResultSheet::StringColumn
+BiometricEvaluation::IO::ResultSheet::getStringColumn(
+    uint64_t block,
+    uint32_t column)
+{
+	uint64_t length;
+	const uint8_t *chunk = this->getChunk(block, column, Type::String,
+	    length);
+	const uint64_t rowCount = this->getBlockRowCount(block);
+
+	/* Offsets must ascend within the bytes that follow them */
+	const uint64_t *offsets = (const uint64_t *)chunk;
+	const uint64_t valuesLength = length - ((rowCount + 1) *
+	    sizeof(uint64_t));
+	for (uint64_t i = 0; i < rowCount; i++)
+		if (offsets[i] > offsets[i + 1])
+			throw Error::DataError("Column " +
+			    this->_schema[column].name + " of block " +
+			    std::to_string(block) + " is corrupt");
+	if (offsets[rowCount] > valuesLength)
+		throw Error::DataError("Column " + this->_schema[column].name +
+		    " of block " + std::to_string(block) + " is corrupt");
+
+	return (StringColumn(offsets, (const char *)chunk +
+	    ((rowCount + 1) * sizeof(uint64_t)), rowCount));
+}
+
+/*
+ * Common.
+ */
+
+std::vector<BiometricEvaluation::IO::ResultSheet::Column>
+BiometricEvaluation::IO::ResultSheet::getSchema()
+    const
+{
+	return (this->_schema);
+}
+
+std::string
+BiometricEvaluation::IO::ResultSheet::getDescription()
+    const
+{
+	return (this->_description);
+}
+
+uint32_t
+BiometricEvaluation::IO::ResultSheet::getColumnIndex(
+    const std::string &name)
+    const
+{
+	for (uint32_t i = 0; i < this->_schema.size(); i++)
+		if (this->_schema[i].name == name)
+			return (i);
+	throw Error::ObjectDoesNotExist(name);
+}
+
+uint64_t
+BiometricEvaluation::IO::ResultSheet::getRowCount()
+    const
+{
+	if (this->_readOnly)
+		return (this->_rowCount);
+	return (this->_writtenRows + this->_bufferedRows);
+}
+
+BiometricEvaluation::IO::ResultSheet::~ResultSheet()
+{
+	if (this->_readOnly) {
+		munmap(const_cast<uint8_t*>(this->_map), this->_mapSize);
+		return;
+	}
+
+	/* Values of an incomplete row are discarded */
+	try {
+		if ((this->_bufferedRows != 0) || (this->_nextColumn != 0))
+			this->writeBlock();
+	} catch (Error::Exception &e) {
+		/* Nothing can be done about lost rows now */
+	}
+	this->_file->close();
+}
@@ -14,6 +14,7 @@
 #include "be_io_sqliterecstore_impl.h"
 #include <be_error.h>
 #include <be_io_utility.h>
+#include <be_memory_accounting.h>
 #include <be_text.h>
 
 namespace BE = BiometricEvaluation;
@@ -64,7 +65,8 @@ BiometricEvaluation::IO::SQLiteRecordStore::Impl::Impl(
     _db(nullptr),
     _dbname(""),
     _sequencer(nullptr),
-    _sequenceEnd(false)
+    _sequenceEnd(false),
+    _cacheSize(0)
 {
 #ifdef	SQLITE_V2_SUPPORT
 	sqlite3_initialize();
@@ -96,7 +98,8 @@ BiometricEvaluation::IO::SQLiteRecordStore::Impl::Impl(
     _db(nullptr),
     _dbname(""),
     _sequencer(nullptr),
-    _sequenceEnd(false)
+    _sequenceEnd(false),
+    _cacheSize(0)
 {
 #ifdef	SQLITE_V2_SUPPORT
 	sqlite3_initialize();
@@ -274,6 +277,8 @@ BiometricEvaluation::IO::SQLiteRecordStore::Impl::insert(
 		}
 	}
 	
+	this->chargeCache();
+
 	/* Propagate to parent class */
 	RecordStore::Impl::insert(key, data, size);
 }
@@ -347,6 +352,8 @@ BiometricEvaluation::IO::SQLiteRecordStore::Impl::remove(
 		}
 	}
 	
+	this->chargeCache();
+
 	/* Propagate changes to parent */		
 	RecordStore::Impl::remove(key);
 }
@@ -359,6 +366,7 @@ BiometricEvaluation::IO::SQLiteRecordStore::Impl::read(
 	BiometricEvaluation::Memory::uint8Array data;
 	data.resize(this->length(key));
 	this->readSegments(key, data);
+	this->chargeCache();
 	return(data);
 }
 
@@ -655,6 +663,12 @@ BiometricEvaluation::IO::SQLiteRecordStore::Impl::cleanup()
 		    "sequencer");
 	_sequenceEnd = false;
 	_sequencer = nullptr;
+
+	/* The cache is freed with the connection */
+	if (_cacheSize != 0)
+		Memory::recordDeallocation(Memory::AllocationTag::RecordStoreCache,
+		    _cacheSize);
+	_cacheSize = 0;
 	
 	/* Close DB */
 	rv = sqlite3_close(_db);
@@ -663,6 +677,30 @@ BiometricEvaluation::IO::SQLiteRecordStore::Impl::cleanup()
 		    "free all statements?)");
 }
 
+void
+BiometricEvaluation::IO::SQLiteRecordStore::Impl::chargeCache()
+    const
+{
+#ifdef SQLITE_DBSTATUS_CACHE_USED
+	int current = 0, highwater = 0;
+	if (Memory::isAccountingEnabled() && (sqlite3_db_status(_db,
+	    SQLITE_DBSTATUS_CACHE_USED, &current, &highwater, 0) != SQLITE_OK))
+		return;
+	const uint64_t cacheSize = Memory::isAccountingEnabled() ?
+	    static_cast<uint64_t>(current) : 0;
+	if (cacheSize == _cacheSize)
+		return;
+
+	if (_cacheSize != 0)
+		Memory::recordDeallocation(Memory::AllocationTag::RecordStoreCache,
+		    _cacheSize);
+	if (cacheSize != 0)
+		Memory::recordAllocation(Memory::AllocationTag::RecordStoreCache,
+		    cacheSize);
+	_cacheSize = cacheSize;
+#endif /* SQLITE_DBSTATUS_CACHE_USED */
+}
+
 void
 BiometricEvaluation::IO::SQLiteRecordStore::Impl::sqliteError(
     int32_t errorNumber)
@@ -195,6 +195,11 @@ namespace BiometricEvaluation
 			bool _sequenceEnd;
 			/** Row for key in setCursorForKey() */
 			uint64_t _cursorRow;
+			/**
+			 * Bytes of SQLite's page cache charged to
+			 * Memory::AllocationTag::RecordStoreCache.
+			 */
+			mutable uint64_t _cacheSize;
 			
 			/** Name given to the primate SQLite table */
 			static const std::string PRIMARY_KV_TABLE;
@@ -209,6 +214,18 @@ namespace BiometricEvaluation
 			 */
 			std::string getDBFilename() const;
 
+			/**
+			 * @brief
+			 * Update the charge to allocation accounting for
+			 * the database connection's page cache.
+			 * @details
+			 * The charge is released while accounting is
+			 * disabled.
+			 */
+			void
+			chargeCache()
+			    const;
+
 			/**
 			 * Internal implementation of sequencing through a
 			 * store, returning the key, and optionally, the
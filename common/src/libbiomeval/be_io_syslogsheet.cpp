@@ -8,12 +8,14 @@
  * about its quality, reliability, or any other characteristic.
  */
 
-#include <csignal>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/un.h>
 #include <netdb.h>
 #include <strings.h>
 #include <time.h>
@@ -33,18 +35,54 @@ static const std::string DebugPRI("<143>");	/* 17*8 + 7 */
 static const std::string SyslogVersion("1");
 static const std::string SyslogNIL("-");
 
+/* Avoid SIGPIPE when the logger closes the connection */
+#if defined MSG_NOSIGNAL
+static const int SendFlags = MSG_NOSIGNAL;
+#else
+static const int SendFlags = 0;
+#endif
+
 static bool
-parseURL(const std::string &url, std::string &hostname, int &port)
+parseURL(
+    const std::string &url,
+    BE::IO::SysLogsheet::Transport &transport,
+    std::string &hostname,
+    int &port)
 {
 	if (BE::IO::Logsheet::getTypeFromURL(url) !=
 	    BE::IO::Logsheet::Kind::Syslog)
 		return (false);
 
+	/* A path names a Unix-domain socket */
+	std::string location = url.substr(url.find("://") + 3);
+	if (!location.empty() && (location[0] == '/')) {
+		transport = BE::IO::SysLogsheet::Transport::Unix;
+		hostname = location;
+		return (true);
+	}
+
+	/* Find the optional transport */
+	transport = BE::IO::SysLogsheet::Transport::TCP;
+	std::string::size_type slash = location.find('/');
+	if (slash != std::string::npos) {
+		const std::string name = location.substr(slash + 1);
+		if (BE::Text::caseInsensitiveCompare(name, "udp"))
+			transport = BE::IO::SysLogsheet::Transport::UDP;
+		else if (!BE::Text::caseInsensitiveCompare(name, "tcp"))
+			return (false);
+		location.erase(slash);
+	}
+
 	/* Find the host name and port */
-	std::string::size_type start = url.find("://");
-	std::string::size_type stop = url.rfind(':');
-	hostname = url.substr(start + 3, stop - (start + 3));
-	port = std::stoi(url.substr(stop + 1, url.length()));
+	std::string::size_type stop = location.rfind(':');
+	if (stop == std::string::npos)
+		return (false);
+	hostname = location.substr(0, stop);
+	try {
+		port = std::stoi(location.substr(stop + 1));
+	} catch (std::exception &e) {
+		return (false);
+	}
 
 	return (true);
 }
@@ -56,33 +94,66 @@ BiometricEvaluation::IO::SysLogsheet::setup(
 {
 	/* Check the URL for syntax */
 	std::string hostname;
-	int port;
-	if (!parseURL(url, hostname, port))
+	int port = 0;
+	if (!parseURL(url, this->_transport, hostname, port))
 		throw BE::Error::StrategyError("Invalid URL");
+
 	/* Open the connection to the system logger daemon */
-	int sockFD = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
-	if (sockFD == -1)
-		throw BE::Error::StrategyError("Could not create socket");
-	
-	struct hostent *host = gethostbyname(hostname.c_str());
-	if (host == NULL)
-		throw BE::Error::StrategyError("Could not resolve hostname");
-
-	struct sockaddr_in server;
-	bzero((char *)&server, sizeof(server));
-	server.sin_family = AF_INET;
-	server.sin_addr.s_addr = ((struct in_addr *)(host->h_addr))->s_addr;
-	server.sin_port = htons(port);
-
-	int rval = connect(sockFD, (struct sockaddr *)&server, sizeof(server));
-	if (rval < 0)
-		throw BE::Error::StrategyError("Could not connect to server");
+	int sockFD;
+	if (this->_transport == Transport::Unix) {
+		struct sockaddr_un server;
+		if (hostname.size() >= sizeof(server.sun_path))
+			throw BE::Error::StrategyError("Socket path too long");
+		sockFD = socket(AF_UNIX, SOCK_DGRAM, 0);
+		if (sockFD == -1)
+			throw BE::Error::StrategyError("Could not create "
+			    "socket");
+		bzero((char *)&server, sizeof(server));
+		server.sun_family = AF_UNIX;
+		std::strcpy(server.sun_path, hostname.c_str());
+		if (connect(sockFD, (struct sockaddr *)&server,
+		    sizeof(server)) < 0) {
+			close(sockFD);
+			throw BE::Error::StrategyError("Could not connect to "
+			    "socket");
+		}
+	} else {
+		struct hostent *host = gethostbyname(hostname.c_str());
+		if (host == NULL)
+			throw BE::Error::StrategyError("Could not resolve "
+			    "hostname");
+
+		if (this->_transport == Transport::UDP)
+			sockFD = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		else
+			sockFD = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+		if (sockFD == -1)
+			throw BE::Error::StrategyError("Could not create "
+			    "socket");
+
+		struct sockaddr_in server;
+		bzero((char *)&server, sizeof(server));
+		server.sin_family = AF_INET;
+		server.sin_addr.s_addr =
+		    ((struct in_addr *)(host->h_addr))->s_addr;
+		server.sin_port = htons(port);
+
+		int rval = connect(sockFD, (struct sockaddr *)&server,
+		    sizeof(server));
+		if (rval < 0) {
+			close(sockFD);
+			throw BE::Error::StrategyError("Could not connect to "
+			    "server");
+		}
+	}
+#if defined SO_NOSIGPIPE
+	int on = 1;
+	(void)setsockopt(sockFD, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
 
 	this->_sockFD = sockFD;
 	this->_operational = true;
-	std::stringstream sstr;
-	sstr << getpid();
-	this->_procid = sstr.str();
+	this->_procid = std::to_string(getpid());
 
 	// XXX Do something with the description string
 }
@@ -97,13 +168,24 @@ BiometricEvaluation::IO::SysLogsheet::SysLogsheet(
     _appname(appname),
     _sequenced(sequenced),
     _operational(false),
-    _utc(utc)
+    _utc(utc),
+    _timestampSecond(-1),
+    _async(false),
+    _queueSize(0),
+    _policy(OverflowPolicy::Block),
+    _queued(0),
+    _handled(0),
+    _sent(0),
+    _dropped(0),
+    _asyncStop(false)
 {
 	setup(url, description);
 	long maxLen = sysconf(_SC_HOST_NAME_MAX);
 	Memory::uint8Array buf(maxLen);
 	(void)gethostname((char *)&buf[0], maxLen);
 	_hostname = std::string((char *)&buf[0]);
+	_headerFields = _hostname + ' ' + _appname + ' ' + _procid + ' ' +
+	    SyslogNIL + ' ' + SyslogNIL + ' ';
 }
 
 BiometricEvaluation::IO::SysLogsheet::SysLogsheet(
@@ -118,47 +200,67 @@ BiometricEvaluation::IO::SysLogsheet::SysLogsheet(
     _appname(appname),
     _sequenced(sequenced),
     _operational(false),
-    _utc(utc)
+    _utc(utc),
+    _timestampSecond(-1),
+    _async(false),
+    _queueSize(0),
+    _policy(OverflowPolicy::Block),
+    _queued(0),
+    _handled(0),
+    _sent(0),
+    _dropped(0),
+    _asyncStop(false)
 {
 	setup(url, description);
+	_headerFields = _hostname + ' ' + _appname + ' ' + _procid + ' ' +
+	    SyslogNIL + ' ' + SyslogNIL + ' ';
 }
 
-//XXX May want to place this function in BE::Time
 /*
- * Create a syslog-format UTC time stamp.
+ * Create a syslog-format time stamp.
  */
-static inline std::string
-createSyslogTimestamp(bool utc)
+std::string
+BiometricEvaluation::IO::SysLogsheet::createTimestamp()
 {
 	/*
 	 * The timestamp is returned in RFC5424 format, six digits of
-	 * sub-second resolution, with the UTC offset.
+	 * sub-second resolution, with the UTC offset. The date, time,
+	 * and offset only change once a second.
 	 */
 	struct timeval tv;
 	(void)gettimeofday(&tv, NULL);
 
-	struct tm cTime;
-	if (utc)
-		(void)gmtime_r(&tv.tv_sec, &cTime);
-	else
-		(void)localtime_r(&tv.tv_sec, &cTime);
-	char TZsign;
-	if (cTime.tm_gmtoff < 0)
-		TZsign = '-';
-	else
-		TZsign = '+';
-
-	unsigned int hourOffset, minOffset;
-	hourOffset = std::abs(cTime.tm_gmtoff) / 3600;
-	minOffset = std::abs(cTime.tm_gmtoff) % 3600;
-	char buf[33];
-	std::snprintf(buf, 33,
-	    "%4.4u-%2.2u-%2.2uT%2.2u:%2.2u:%2.2u.%6.6u%c%2.2u:%2.2u",
-	    cTime.tm_year + 1900, cTime.tm_mon + 1, cTime.tm_mday,
-	    cTime.tm_hour, cTime.tm_min, cTime.tm_sec,
-	    static_cast<unsigned int>(tv.tv_usec),
-	    TZsign, hourOffset, minOffset);
-	return(std::string(buf));
+	if (tv.tv_sec != this->_timestampSecond) {
+		struct tm cTime;
+		if (this->_utc)
+			(void)gmtime_r(&tv.tv_sec, &cTime);
+		else
+			(void)localtime_r(&tv.tv_sec, &cTime);
+		char TZsign;
+		if (cTime.tm_gmtoff < 0)
+			TZsign = '-';
+		else
+			TZsign = '+';
+
+		unsigned int hourOffset, minOffset;
+		hourOffset = std::abs(cTime.tm_gmtoff) / 3600;
+		minOffset = (std::abs(cTime.tm_gmtoff) % 3600) / 60;
+		char buf[21];
+		std::snprintf(buf, sizeof(buf),
+		    "%4.4u-%2.2u-%2.2uT%2.2u:%2.2u:%2.2u.",
+		    cTime.tm_year + 1900, cTime.tm_mon + 1, cTime.tm_mday,
+		    cTime.tm_hour, cTime.tm_min, cTime.tm_sec);
+		this->_timestampDate = buf;
+		std::snprintf(buf, sizeof(buf), "%c%2.2u:%2.2u", TZsign,
+		    hourOffset, minOffset);
+		this->_timestampZone = buf;
+		this->_timestampSecond = tv.tv_sec;
+	}
+
+	char usec[7];
+	std::snprintf(usec, sizeof(usec), "%6.6u",
+	    static_cast<unsigned int>(tv.tv_usec));
+	return (this->_timestampDate + usec + this->_timestampZone);
 }
 
 void
@@ -183,71 +285,150 @@ BiometricEvaluation::IO::SysLogsheet::writeToLogger(
 	 */
 
 	/*
-	 * Append a space to the prefix when it is not empty so the
-	 * output is separated during syslog message creation below.
+	 * Build the common part of all log messages sent to the logger,
+	 * separating a non-empty prefix from the message.
 	 */
-	std::string localprefix;
-	if (prefix.empty())
-		localprefix = prefix;
-	else
-		localprefix = prefix + " ";
+	std::string msgCom;
+	msgCom.reserve(priority.size() + 40 + this->_headerFields.size() +
+	    prefix.size());
+	msgCom.append(priority).append(SyslogVersion).append(1, ' ');
+	msgCom.append(this->createTimestamp()).append(1, ' ');
+	msgCom.append(this->_headerFields);
+	msgCom.append(1, delimiter).append(1, ' ');
+	if (!prefix.empty())
+		msgCom.append(prefix).append(1, ' ');
 
 	/*
-	 * Build the common part of all log messages sent to the logger.
+	 * Segment the message on newlines, ignoring a final newline,
+	 * and format each segment as a message. Stream messages are
+	 * framed by a newline.
 	 */
-	std::stringstream msgCom;
-	msgCom << priority << SyslogVersion << ' '
-	    << createSyslogTimestamp(this->_utc) << ' ' << this->_hostname
-	    << ' ' << this->_appname << ' ' << this->_procid
-	    << ' ' << SyslogNIL << ' ' << SyslogNIL
-	    << ' ' << delimiter << ' ' << localprefix;
+	const bool framed = (this->_transport == Transport::TCP);
+	std::string messages;
+	std::vector<uint32_t> lengths;
+	std::string::size_type start = 0;
+	while (true) {
+		std::string::size_type end = message.find('\n', start);
+		const std::string::size_type length =
+		    (end == std::string::npos) ? std::string::npos :
+		    end - start;
+		const std::string::size_type before = messages.size();
+		messages.append(msgCom).append(message, start, length);
+		if (framed)
+			messages.append(1, '\n');
+		lengths.push_back(messages.size() - before);
+		if ((end == std::string::npos) || (end == message.length() - 1))
+			break;
+		start = end + 1;
+	}
 
-	/*
-	 * Find the first newline-delimited segment of the message,
-	 * and send it to the logger. If there is no newline, then
-	 * the entire message is sent.
-	 */
-	std::string::size_type msglen, end;
-	std::string logMsg;
+	if (!this->_async) {
+		const uint64_t sent = this->sendMessages(messages, lengths);
+		this->_sent += sent;
+		this->_dropped += lengths.size() - sent;
+		return;
+	}
 
-	end = message.find('\n', 0);
-	logMsg = msgCom.str() + message.substr(0, end) + "\n";
-	msglen = logMsg.length();
+	pthread_mutex_lock(&this->_asyncMutex);
+	if (!this->_asyncError.empty()) {
+		const std::string asyncError = this->_asyncError;
+		pthread_mutex_unlock(&this->_asyncMutex);
+		throw Error::StrategyError(asyncError);
+	}
 
-	/*
-	 * Ignore the SIGPIPE signal during the writing of the
-	 * pipe; save the current signal handler, then restore it.
-	 */
-	struct sigaction sa;
-	struct sigaction osa;
-	sigemptyset(&sa.sa_mask);       /* Don't block other signals */
-	sa.sa_handler = SIG_IGN;
-	(void)sigaction(SIGPIPE, &sa, &osa);
+	/* Wait for room, or drop the entry, when the queue is full */
+	while (!this->_pending.empty() && (this->_pending.size() +
+	    messages.size() > this->_queueSize)) {
+		if (this->_policy == OverflowPolicy::Drop) {
+			this->_dropped += lengths.size();
+			pthread_mutex_unlock(&this->_asyncMutex);
+			return;
+		}
+		pthread_cond_wait(&this->_asyncDone, &this->_asyncMutex);
+		if (!this->_asyncError.empty()) {
+			const std::string asyncError = this->_asyncError;
+			pthread_mutex_unlock(&this->_asyncMutex);
+			throw Error::StrategyError(asyncError);
+		}
+	}
 
-	ssize_t rval = ::write(this->_sockFD, logMsg.c_str(), msglen);
-	if (rval != (ssize_t)msglen)
-		throw Error::StrategyError(
-		    "Failed write: " + Error::errorStr());
+	const bool wasEmpty = this->_pending.empty();
+	this->_pending.append(messages);
+	this->_pendingLengths.insert(this->_pendingLengths.end(),
+	    lengths.begin(), lengths.end());
+	this->_queued += lengths.size();
+	if (wasEmpty)
+		pthread_cond_signal(&this->_asyncWork);
+	pthread_mutex_unlock(&this->_asyncMutex);
+}
 
-	/*
-	 * Loop through the remainder of the message, if any,
-	 * and segment it based on newlines. Exit the loop
-	 * when there are no more newlines, or a newline was
-	 * found at the end. We may already be at one of these
-	 * stopping conditions due to the find() above.
-	 */
-	while ((end != std::string::npos) && (end != message.length() - 1)) {
-		size_t start = end + 1;
-		end = message.find('\n', start);
-		size_t sublen = end - start;
-		logMsg = msgCom.str() + message.substr(start, sublen) + "\n";
-		msglen = logMsg.length();
-		rval = ::write(this->_sockFD, logMsg.c_str(), msglen);
-		if (rval != (ssize_t)msglen)
-			throw Error::StrategyError(
-			    "Failed write: " + Error::errorStr());
+uint64_t
+BiometricEvaluation::IO::SysLogsheet::sendMessages(
+    const std::string &messages,
+    const std::vector<uint32_t> &lengths)
+{
+	/* A stream takes every message in one write */
+	if (this->_transport == Transport::TCP) {
+		const char *data = messages.data();
+		size_t remaining = messages.size();
+		while (remaining > 0) {
+			ssize_t sz = ::send(this->_sockFD, data, remaining,
+			    SendFlags);
+			if (sz == -1) {
+				if (errno == EINTR)
+					continue;
+				throw Error::StrategyError("Failed write: " +
+				    Error::errorStr());
+			}
+			data += sz;
+			remaining -= sz;
+		}
+		return (lengths.size());
 	}
-	(void)sigaction(SIGPIPE, &osa, nullptr);
+
+	/* Each datagram is a message; undeliverable ones are dropped */
+	uint64_t sent = 0;
+	const char *data = messages.data();
+#if defined Linux
+	static const unsigned int MaxBatch = 64;
+	struct mmsghdr msgs[MaxBatch];
+	struct iovec iovecs[MaxBatch];
+	uint64_t i = 0;
+	while (i < lengths.size()) {
+		unsigned int count = 0;
+		const char *batchData = data;
+		while ((count < MaxBatch) && (i + count < lengths.size())) {
+			iovecs[count].iov_base = const_cast<char *>(batchData);
+			iovecs[count].iov_len = lengths[i + count];
+			std::memset(&msgs[count], 0, sizeof(msgs[count]));
+			msgs[count].msg_hdr.msg_iov = &iovecs[count];
+			msgs[count].msg_hdr.msg_iovlen = 1;
+			batchData += lengths[i + count];
+			count++;
+		}
+		int rv = sendmmsg(this->_sockFD, msgs, count, SendFlags);
+		if ((rv == -1) && (errno == EINTR))
+			continue;
+		/* Skip a datagram that could not be sent */
+		const unsigned int done = (rv > 0) ? rv : 1;
+		if (rv > 0)
+			sent += rv;
+		for (unsigned int j = 0; j < done; j++)
+			data += lengths[i + j];
+		i += done;
+	}
+#else
+	for (const auto length : lengths) {
+		ssize_t sz;
+		do {
+			sz = ::send(this->_sockFD, data, length, SendFlags);
+		} while ((sz == -1) && (errno == EINTR));
+		if (sz == (ssize_t)length)
+			sent++;
+		data += length;
+	}
+#endif
+	return (sent);
 }
 
 void
@@ -296,13 +477,174 @@ BiometricEvaluation::IO::SysLogsheet::writeDebug(const std::string &entry)
 void
 BiometricEvaluation::IO::SysLogsheet::sync()
 {
-	/* There is nothing to do as the server has the data */
-	return;
+	/* Synchronously, the server already has the data */
+	if (!this->_async)
+		return;
+
+	pthread_mutex_lock(&this->_asyncMutex);
+	const uint64_t target = this->_queued;
+	while ((this->_handled < target) && this->_asyncError.empty())
+		pthread_cond_wait(&this->_asyncDone, &this->_asyncMutex);
+	const std::string asyncError = this->_asyncError;
+	pthread_mutex_unlock(&this->_asyncMutex);
+
+	if (!asyncError.empty())
+		throw Error::StrategyError(asyncError);
+}
+
+void
+BiometricEvaluation::IO::SysLogsheet::setAsynchronous(
+    bool state,
+    uint64_t queueSize,
+    OverflowPolicy policy)
+{
+	if (state) {
+		if (queueSize == 0)
+			throw Error::ParameterError("Queue size must be "
+			    "non-zero");
+		if (this->_async) {
+			pthread_mutex_lock(&this->_asyncMutex);
+			this->_queueSize = queueSize;
+			this->_policy = policy;
+			pthread_cond_broadcast(&this->_asyncDone);
+			pthread_mutex_unlock(&this->_asyncMutex);
+			return;
+		}
+
+		this->_queueSize = queueSize;
+		this->_policy = policy;
+		this->_pending.clear();
+		this->_pendingLengths.clear();
+		this->_queued = this->_handled = 0;
+		this->_asyncStop = false;
+		this->_asyncError.clear();
+		pthread_mutex_init(&this->_asyncMutex, nullptr);
+		pthread_cond_init(&this->_asyncWork, nullptr);
+		pthread_cond_init(&this->_asyncDone, nullptr);
+		if (pthread_create(&this->_asyncThread, nullptr,
+		    SysLogsheet::asyncSender, this) != 0) {
+			pthread_cond_destroy(&this->_asyncDone);
+			pthread_cond_destroy(&this->_asyncWork);
+			pthread_mutex_destroy(&this->_asyncMutex);
+			throw Error::StrategyError("pthread_create() error");
+		}
+		this->_async = true;
+		return;
+	}
+
+	if (!this->_async)
+		return;
+
+	/* The thread sends everything queued before exiting */
+	pthread_mutex_lock(&this->_asyncMutex);
+	this->_asyncStop = true;
+	pthread_cond_signal(&this->_asyncWork);
+	pthread_mutex_unlock(&this->_asyncMutex);
+	pthread_join(this->_asyncThread, nullptr);
+	this->_async = false;
+
+	pthread_cond_destroy(&this->_asyncDone);
+	pthread_cond_destroy(&this->_asyncWork);
+	pthread_mutex_destroy(&this->_asyncMutex);
+	this->_pending.clear();
+	this->_pending.shrink_to_fit();
+	this->_pendingLengths.clear();
+	this->_pendingLengths.shrink_to_fit();
+
+	if (!this->_asyncError.empty())
+		throw Error::StrategyError(this->_asyncError);
+}
+
+bool
+BiometricEvaluation::IO::SysLogsheet::getAsynchronous()
+    const
+{
+	return (this->_async);
+}
+
+BiometricEvaluation::IO::SysLogsheet::Transport
+BiometricEvaluation::IO::SysLogsheet::getTransport()
+    const
+{
+	return (this->_transport);
+}
+
+uint64_t
+BiometricEvaluation::IO::SysLogsheet::getSentCount()
+    const
+{
+	if (!this->_async)
+		return (this->_sent);
+	pthread_mutex_lock(&this->_asyncMutex);
+	const uint64_t sent = this->_sent;
+	pthread_mutex_unlock(&this->_asyncMutex);
+	return (sent);
+}
+
+uint64_t
+BiometricEvaluation::IO::SysLogsheet::getDroppedCount()
+    const
+{
+	if (!this->_async)
+		return (this->_dropped);
+	pthread_mutex_lock(&this->_asyncMutex);
+	const uint64_t dropped = this->_dropped;
+	pthread_mutex_unlock(&this->_asyncMutex);
+	return (dropped);
+}
+
+void *
+BiometricEvaluation::IO::SysLogsheet::asyncSender(
+    void *ptr)
+{
+	SysLogsheet *ls = static_cast<SysLogsheet *>(ptr);
+	std::string batch;
+	std::vector<uint32_t> lengths;
+
+	pthread_mutex_lock(&ls->_asyncMutex);
+	while (true) {
+		if (ls->_pending.empty()) {
+			if (ls->_asyncStop)
+				break;
+			pthread_cond_wait(&ls->_asyncWork, &ls->_asyncMutex);
+			continue;
+		}
+
+		/* Send everything queued without holding up writers */
+		batch.swap(ls->_pending);
+		lengths.swap(ls->_pendingLengths);
+		pthread_mutex_unlock(&ls->_asyncMutex);
+
+		uint64_t sent = 0;
+		std::string error;
+		try {
+			sent = ls->sendMessages(batch, lengths);
+		} catch (Error::Exception &e) {
+			error = e.whatString();
+		}
+
+		pthread_mutex_lock(&ls->_asyncMutex);
+		ls->_sent += sent;
+		ls->_dropped += lengths.size() - sent;
+		ls->_handled += lengths.size();
+		if (!error.empty() && ls->_asyncError.empty())
+			ls->_asyncError = error;
+		batch.clear();
+		lengths.clear();
+		pthread_cond_broadcast(&ls->_asyncDone);
+	}
+	pthread_mutex_unlock(&ls->_asyncMutex);
+
+	return (nullptr);
 }
 
 BiometricEvaluation::IO::SysLogsheet::~SysLogsheet()
 {
+	try {
+		this->setAsynchronous(false);
+	} catch (Error::Exception &e) {
+		/* Entries that could not be sent are lost */
+	}
 	if (_operational)
 		close(_sockFD);
 }
-
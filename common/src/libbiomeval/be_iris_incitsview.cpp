@@ -268,16 +268,19 @@ BiometricEvaluation::Iris::INCITSView::readIrisView(
 	uval8 = buf.scanU8Val();	/* Image bit depth */
 	this->setImageColorDepth((uint32_t)uval8);
 
-	this->_cameraRange = buf.scanBeU16Val();
-	this->_rollAngle = buf.scanBeU16Val();
-	this->_rollAngleUncertainty = buf.scanBeU16Val();
-
-	this->_irisCenterSmallestX = buf.scanBeU16Val();
-	this->_irisCenterLargestX = buf.scanBeU16Val();
-	this->_irisCenterSmallestY = buf.scanBeU16Val();
-	this->_irisCenterLargestY = buf.scanBeU16Val();
-	this->_irisDiameterSmallest = buf.scanBeU16Val();
-	this->_irisDiameterLargest = buf.scanBeU16Val();
+	/* Camera range through iris diameter are consecutive 16-bit values */
+	uint16_t geometry[9];
+	buf.scanBeU16Vals(geometry, 9);
+	this->_cameraRange = geometry[0];
+	this->_rollAngle = geometry[1];
+	this->_rollAngleUncertainty = geometry[2];
+
+	this->_irisCenterSmallestX = geometry[3];
+	this->_irisCenterLargestX = geometry[4];
+	this->_irisCenterSmallestY = geometry[5];
+	this->_irisCenterLargestY = geometry[6];
+	this->_irisDiameterSmallest = geometry[7];
+	this->_irisDiameterLargest = geometry[8];
 
 	uval32 = buf.scanBeU32Val();	/* image length */
 	BE::Memory::uint8Array imageData(uval32);
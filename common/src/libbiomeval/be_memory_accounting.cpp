@@ -0,0 +1,205 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <atomic>
+
+#include <be_memory_accounting.h>
+
+namespace BE = BiometricEvaluation;
+
+template<>
+const std::map<BiometricEvaluation::Memory::AllocationTag, std::string>
+    BiometricEvaluation::Framework::EnumerationFunctions<
+    BiometricEvaluation::Memory::AllocationTag>::enumToStringMap = {
+	{Memory::AllocationTag::AutoArray, "AutoArray"},
+	{Memory::AllocationTag::RecordStoreManifest, "RecordStoreManifest"},
+	{Memory::AllocationTag::RecordStoreCache, "RecordStoreCache"},
+	{Memory::AllocationTag::ImageDecode, "ImageDecode"},
+	{Memory::AllocationTag::AN2KTree, "AN2KTree"}
+};
+
+/** Number of AllocationTag values */
+static const size_t TagCount = 5;
+
+/** Counters of one tag, updated without locks */
+struct TagCounters {
+	std::atomic<uint64_t> current;
+	std::atomic<uint64_t> peak;
+	std::atomic<uint64_t> allocations;
+	std::atomic<uint64_t> deallocations;
+};
+
+static std::atomic<bool> accountingEnabled(false);
+static TagCounters counters[TagCount];
+static thread_local BE::Memory::AllocationTag currentTag =
+    BE::Memory::AllocationTag::AutoArray;
+
+void
+BiometricEvaluation::Memory::setAccountingEnabled(
+    bool enabled)
+{
+	accountingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool
+BiometricEvaluation::Memory::isAccountingEnabled()
+{
+	return (accountingEnabled.load(std::memory_order_relaxed));
+}
+
+void
+BiometricEvaluation::Memory::recordAllocation(
+    AllocationTag tag,
+    uint64_t size)
+{
+	TagCounters &c = counters[to_int_type(tag)];
+	c.allocations.fetch_add(1, std::memory_order_relaxed);
+	const uint64_t current = c.current.fetch_add(size,
+	    std::memory_order_relaxed) + size;
+
+	uint64_t peak = c.peak.load(std::memory_order_relaxed);
+	while ((current > peak) && !c.peak.compare_exchange_weak(peak,
+	    current, std::memory_order_relaxed));
+}
+
+void
+BiometricEvaluation::Memory::recordDeallocation(
+    AllocationTag tag,
+    uint64_t size)
+{
+	TagCounters &c = counters[to_int_type(tag)];
+	c.deallocations.fetch_add(1, std::memory_order_relaxed);
+	c.current.fetch_sub(size, std::memory_order_relaxed);
+}
+
+BiometricEvaluation::Memory::AllocationCounters
+BiometricEvaluation::Memory::getAllocationCounters(
+    AllocationTag tag)
+{
+	const TagCounters &c = counters[to_int_type(tag)];
+	AllocationCounters snapshot;
+	snapshot.current = c.current.load(std::memory_order_relaxed);
+	snapshot.peak = c.peak.load(std::memory_order_relaxed);
+	snapshot.allocations = c.allocations.load(std::memory_order_relaxed);
+	snapshot.deallocations = c.deallocations.load(
+	    std::memory_order_relaxed);
+	return (snapshot);
+}
+
+std::map<BiometricEvaluation::Memory::AllocationTag,
+    BiometricEvaluation::Memory::AllocationCounters>
+BiometricEvaluation::Memory::getAllocationCounters()
+{
+	std::map<AllocationTag, AllocationCounters> snapshot;
+	for (const auto &tag : BE::Framework::EnumerationFunctions<
+	    AllocationTag>::enumToStringMap)
+		snapshot[tag.first] = getAllocationCounters(tag.first);
+	return (snapshot);
+}
+
+void
+BiometricEvaluation::Memory::resetAllocationPeaks()
+{
+	for (size_t i = 0; i < TagCount; i++)
+		counters[i].peak.store(counters[i].current.load(
+		    std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+BiometricEvaluation::Memory::AllocationTag
+BiometricEvaluation::Memory::getAllocationTag()
+{
+	return (currentTag);
+}
+
+BiometricEvaluation::Memory::ScopedAllocationTag::ScopedAllocationTag(
+    AllocationTag tag) :
+    _previous(currentTag)
+{
+	currentTag = tag;
+}
+
+BiometricEvaluation::Memory::ScopedAllocationTag::~ScopedAllocationTag()
+{
+	currentTag = this->_previous;
+}
+
+/*
+ * AccountingResource.
+ */
+
+BiometricEvaluation::Memory::AccountingResource::AccountingResource(
+    AllocationTag tag,
+    MemoryResource *upstream) :
+    _tag(tag),
+    _upstream(upstream == nullptr ? getNewDeleteResource() : upstream)
+{
+
+}
+
+void *
+BiometricEvaluation::Memory::AccountingResource::allocate(
+    size_t size,
+    size_t alignment)
+{
+	void *block = this->_upstream->allocate(size, alignment);
+	if (block != nullptr)
+		recordAllocation(this->_tag, size);
+	return (block);
+}
+
+void
+BiometricEvaluation::Memory::AccountingResource::deallocate(
+    void *block,
+    size_t size,
+    size_t alignment)
+{
+	if (block == nullptr)
+		return;
+	this->_upstream->deallocate(block, size, alignment);
+	recordDeallocation(this->_tag, size);
+}
+
+void *
+BiometricEvaluation::Memory::AccountingResource::reallocate(
+    void *block,
+    size_t size,
+    size_t newSize,
+    size_t alignment)
+{
+	void *newBlock = this->_upstream->reallocate(block, size, newSize,
+	    alignment);
+	if (newBlock == nullptr)
+		return (nullptr);
+	if (block != nullptr)
+		recordDeallocation(this->_tag, size);
+	recordAllocation(this->_tag, newSize);
+	return (newBlock);
+}
+
+BiometricEvaluation::Memory::AllocationTag
+BiometricEvaluation::Memory::AccountingResource::getTag()
+    const
+{
+	return (this->_tag);
+}
+
+BiometricEvaluation::Memory::MemoryResource *
+BiometricEvaluation::Memory::getAccountingResource(
+    AllocationTag tag)
+{
+	static AccountingResource resources[TagCount] = {
+		AccountingResource(AllocationTag::AutoArray),
+		AccountingResource(AllocationTag::RecordStoreManifest),
+		AccountingResource(AllocationTag::RecordStoreCache),
+		AccountingResource(AllocationTag::ImageDecode),
+		AccountingResource(AllocationTag::AN2KTree)
+	};
+	return (&resources[to_int_type(tag)]);
+}
@@ -0,0 +1,57 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <cstring>
+
+#include <be_error_exception.h>
+#include <be_memory_byteview.h>
+
+namespace BE = BiometricEvaluation;
+
+const uint64_t BiometricEvaluation::Memory::ByteView::npos;
+
+const uint8_t &
+BiometricEvaluation::Memory::ByteView::at(
+    uint64_t index)
+    const
+{
+	if (index >= this->_size)
+		throw Error::ParameterError("Index " + std::to_string(index) +
+		    " out of range (size " + std::to_string(this->_size) + ")");
+	return (this->_data[index]);
+}
+
+BiometricEvaluation::Memory::ByteView
+BiometricEvaluation::Memory::ByteView::subview(
+    uint64_t offset,
+    uint64_t length)
+    const
+{
+	if (offset > this->_size)
+		throw Error::ParameterError("Offset " + std::to_string(offset) +
+		    " out of range (size " + std::to_string(this->_size) + ")");
+	if (length == npos)
+		length = this->_size - offset;
+	else if (length > this->_size - offset)
+		throw Error::ParameterError("Length " + std::to_string(length) +
+		    " at offset " + std::to_string(offset) + " out of range "
+		    "(size " + std::to_string(this->_size) + ")");
+	return (ByteView(this->_data + offset, length));
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Memory::ByteView::to_array()
+    const
+{
+	uint8Array copy(this->_size);
+	if (this->_size != 0)
+		std::memcpy(copy, this->_data, this->_size);
+	return (copy);
+}
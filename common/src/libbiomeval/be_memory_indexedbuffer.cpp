@@ -10,11 +10,120 @@
 
 #include <arpa/inet.h>
 
+/*
+ * As in be_image_conversion.cpp, the x86-64 kernels are compiled for
+ * SSSE3 with target attributes and chosen at run time, so the rest of
+ * the library keeps the baseline instruction set.
+ */
+#if defined __x86_64__ && defined __GNUC__
+#define BE_MEMORY_INDEXEDBUFFER_X86
+#include <immintrin.h>
+#elif defined __ARM_NEON
+#include <arm_neon.h>
+#endif
+
 #include <cstring>
 
 #include <be_error_exception.h>
 #include <be_memory_indexedbuffer.h>
 
+/******************************************************************************/
+/* Local functions.                                                           */
+/******************************************************************************/
+
+#if defined BE_MEMORY_INDEXEDBUFFER_X86
+/** @return Whether the SSSE3 kernels may be used */
+static bool
+hasSSSE3()
+{
+	static const bool supported = []() {
+		__builtin_cpu_init();
+		return (__builtin_cpu_supports("ssse3") != 0);
+	}();
+	return (supported);
+}
+
+/** @return Values decoded; the caller decodes the rest */
+__attribute__((target("ssse3")))
+static uint64_t
+decodeBeU16SSSE3(
+    uint16_t *dst,
+    const uint8_t *src,
+    uint64_t count)
+{
+	const __m128i swap = _mm_setr_epi8(
+	    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+	uint64_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+		    _mm_shuffle_epi8(_mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(src + (i * 2))), swap));
+	return (i);
+}
+
+/** @return Values decoded; the caller decodes the rest */
+__attribute__((target("ssse3")))
+static uint64_t
+decodeBeU32SSSE3(
+    uint32_t *dst,
+    const uint8_t *src,
+    uint64_t count)
+{
+	const __m128i swap = _mm_setr_epi8(
+	    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	uint64_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+		    _mm_shuffle_epi8(_mm_loadu_si128(
+		    reinterpret_cast<const __m128i *>(src + (i * 4))), swap));
+	return (i);
+}
+#endif /* BE_MEMORY_INDEXEDBUFFER_X86 */
+
+/** Decode count big-endian 16-bit values from src into dst */
+static void
+decodeBeU16(
+    uint16_t *dst,
+    const uint8_t *src,
+    uint64_t count)
+{
+	uint64_t i = 0;
+#if defined BE_MEMORY_INDEXEDBUFFER_X86
+	if (hasSSSE3())
+		i = decodeBeU16SSSE3(dst, src, count);
+#elif defined __ARM_NEON && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	for (; i + 8 <= count; i += 8)
+		vst1q_u8(reinterpret_cast<uint8_t *>(dst + i),
+		    vrev16q_u8(vld1q_u8(src + (i * 2))));
+#endif
+	for (; i < count; i++)
+		dst[i] = static_cast<uint16_t>((src[i * 2] << 8) |
+		    src[(i * 2) + 1]);
+}
+
+/** Decode count big-endian 32-bit values from src into dst */
+static void
+decodeBeU32(
+    uint32_t *dst,
+    const uint8_t *src,
+    uint64_t count)
+{
+	uint64_t i = 0;
+#if defined BE_MEMORY_INDEXEDBUFFER_X86
+	if (hasSSSE3())
+		i = decodeBeU32SSSE3(dst, src, count);
+#elif defined __ARM_NEON && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	for (; i + 4 <= count; i += 4)
+		vst1q_u8(reinterpret_cast<uint8_t *>(dst + i),
+		    vrev32q_u8(vld1q_u8(src + (i * 4))));
+#endif
+	for (; i < count; i++)
+		dst[i] = (static_cast<uint32_t>(src[i * 4]) << 24) |
+		    (static_cast<uint32_t>(src[(i * 4) + 1]) << 16) |
+		    (static_cast<uint32_t>(src[(i * 4) + 2]) << 8) |
+		    static_cast<uint32_t>(src[(i * 4) + 3]);
+}
+
 /******************************************************************************/
 /* Method implementations.                                                    */
 /******************************************************************************/
@@ -47,7 +156,7 @@ BiometricEvaluation::Memory::IndexedBuffer::scan(
     void *buf,
     uint64_t len)
 {
-	if (_index + len > _size)
+	if (len > _size - _index)
 		throw (Error::DataError("Can't read beyond end of buffer"));
 	if (buf != nullptr)
 		(void)memcpy(buf, _data + _index, len);
@@ -55,6 +164,59 @@ BiometricEvaluation::Memory::IndexedBuffer::scan(
 	return (len);
 }
 
+BiometricEvaluation::Memory::ByteView
+BiometricEvaluation::Memory::IndexedBuffer::scanView(
+    uint64_t len)
+{
+	if (len > _size - _index)
+		throw (Error::DataError("Can't read beyond end of buffer"));
+	const ByteView view(_data + _index, len);
+	_index += len;
+	return (view);
+}
+
+void
+BiometricEvaluation::Memory::IndexedBuffer::scanU16Vals(
+    uint16_t *vals,
+    uint64_t count)
+{
+	if (count > (_size - _index) / sizeof(uint16_t))
+		throw (Error::DataError("Can't read beyond end of buffer"));
+	(void)scan(vals, count * sizeof(uint16_t));
+}
+
+void
+BiometricEvaluation::Memory::IndexedBuffer::scanBeU16Vals(
+    uint16_t *vals,
+    uint64_t count)
+{
+	if (count > (_size - _index) / sizeof(uint16_t))
+		throw (Error::DataError("Can't read beyond end of buffer"));
+	decodeBeU16(vals, _data + _index, count);
+	_index += count * sizeof(uint16_t);
+}
+
+void
+BiometricEvaluation::Memory::IndexedBuffer::scanU32Vals(
+    uint32_t *vals,
+    uint64_t count)
+{
+	if (count > (_size - _index) / sizeof(uint32_t))
+		throw (Error::DataError("Can't read beyond end of buffer"));
+	(void)scan(vals, count * sizeof(uint32_t));
+}
+
+void
+BiometricEvaluation::Memory::IndexedBuffer::scanBeU32Vals(
+    uint32_t *vals,
+    uint64_t count)
+{
+	if (count > (_size - _index) / sizeof(uint32_t))
+		throw (Error::DataError("Can't read beyond end of buffer"));
+	decodeBeU32(vals, _data + _index, count);
+	_index += count * sizeof(uint32_t);
+}
+
 uint8_t
 BiometricEvaluation::Memory::IndexedBuffer::scanU8Val()
 {
@@ -135,3 +297,12 @@ BiometricEvaluation::Memory::IndexedBuffer::IndexedBuffer(
 {
 
 }
+
+BiometricEvaluation::Memory::IndexedBuffer::IndexedBuffer(
+    const BiometricEvaluation::Memory::ByteView &view) :
+    _data(view.data()),
+    _size(view.size()),
+    _index(0)
+{
+
+}
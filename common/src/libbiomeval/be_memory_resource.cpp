@@ -0,0 +1,430 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include <be_memory_accounting.h>
+#include <be_memory_resource.h>
+
+namespace BE = BiometricEvaluation;
+
+size_t
+BiometricEvaluation::Memory::getPageSize()
+{
+	static const long pageSize = sysconf(_SC_PAGESIZE);
+	return (pageSize > 0 ? pageSize : 4096);
+}
+
+void *
+BiometricEvaluation::Memory::MemoryResource::reallocate(
+    void *block,
+    size_t size,
+    size_t newSize,
+    size_t alignment)
+{
+	void *newBlock = this->allocate(newSize, alignment);
+	if (newBlock == nullptr)
+		return (nullptr);
+	if (block != nullptr) {
+		std::memcpy(newBlock, block, size < newSize ? size : newSize);
+		this->deallocate(block, size, alignment);
+	}
+	return (newBlock);
+}
+
+/** Resource that allocates every block from the heap */
+class NewDeleteResource : public BE::Memory::MemoryResource
+{
+public:
+	void *
+	allocate(
+	    size_t size,
+	    size_t alignment)
+	{
+		if (alignment <= alignof(std::max_align_t))
+			return (std::malloc(size));
+
+		void *block = nullptr;
+		if (posix_memalign(&block, alignment, size) != 0)
+			return (nullptr);
+#if defined Linux && defined MADV_HUGEPAGE
+		if (alignment >= BE::Memory::HugePageAlignment)
+			(void)madvise(block, size, MADV_HUGEPAGE);
+#endif
+		return (block);
+	}
+
+	void *
+	reallocate(
+	    void *block,
+	    size_t size,
+	    size_t newSize,
+	    size_t alignment)
+	{
+		/* realloc() can grow in place, but only keeps malloc()'s
+		 * alignment */
+		if (alignment <= alignof(std::max_align_t))
+			return (std::realloc(block, newSize));
+		return (MemoryResource::reallocate(block, size, newSize,
+		    alignment));
+	}
+
+	void
+	deallocate(
+	    void *block,
+	    size_t size,
+	    size_t alignment)
+	{
+		std::free(block);
+	}
+};
+
+/** Resource used by AutoArray when no other is given */
+static thread_local BE::Memory::MemoryResource *defaultResource = nullptr;
+
+BiometricEvaluation::Memory::MemoryResource *
+BiometricEvaluation::Memory::getNewDeleteResource()
+{
+	static NewDeleteResource resource;
+	return (&resource);
+}
+
+BiometricEvaluation::Memory::MemoryResource *
+BiometricEvaluation::Memory::getDefaultResource()
+{
+	if (defaultResource == nullptr) {
+		if (isAccountingEnabled())
+			return (getAccountingResource(getAllocationTag()));
+		return (getNewDeleteResource());
+	}
+	return (defaultResource);
+}
+
+BiometricEvaluation::Memory::MemoryResource *
+BiometricEvaluation::Memory::setDefaultResource(
+    MemoryResource *resource)
+{
+	MemoryResource *previous = getDefaultResource();
+	defaultResource = resource;
+	return (previous);
+}
+
+BiometricEvaluation::Memory::ScopedDefaultResource::ScopedDefaultResource(
+    MemoryResource *resource) :
+    _previous(defaultResource)
+{
+	/* Keep nullptr, so the accounting tag is still followed on restore */
+	defaultResource = resource;
+}
+
+BiometricEvaluation::Memory::ScopedDefaultResource::~ScopedDefaultResource()
+{
+	defaultResource = this->_previous;
+}
+
+/*
+ * PoolResource.
+ */
+
+BiometricEvaluation::Memory::PoolResource::PoolResource(
+    size_t maxBlockSize,
+    size_t maxRetained,
+    MemoryResource *upstream) :
+    _maxBlockSize(maxBlockSize),
+    _maxRetained(maxRetained),
+    _upstream(upstream == nullptr ? getNewDeleteResource() : upstream),
+    _freeLists(sizeof(size_t) * 8),
+    _retained(0),
+    _reused(0)
+{
+	pthread_mutex_init(&this->_mutex, nullptr);
+}
+
+int
+BiometricEvaluation::Memory::PoolResource::getSizeClass(
+    size_t size,
+    size_t alignment)
+    const
+{
+	if ((size > this->_maxBlockSize) || (alignment > BlockAlignment) ||
+	    (size > ((size_t)1 << (sizeof(size_t) * 8 - 1))))
+		return (-1);
+
+	int sizeClass = 6;
+	while (((size_t)1 << sizeClass) < size)
+		sizeClass++;
+	return (sizeClass);
+}
+
+void *
+BiometricEvaluation::Memory::PoolResource::allocate(
+    size_t size,
+    size_t alignment)
+{
+	const int sizeClass = this->getSizeClass(size, alignment);
+	if (sizeClass == -1)
+		return (this->_upstream->allocate(size, alignment));
+
+	pthread_mutex_lock(&this->_mutex);
+	std::vector<void *> &freeList = this->_freeLists[sizeClass];
+	if (!freeList.empty()) {
+		void *block = freeList.back();
+		freeList.pop_back();
+		this->_retained -= ((size_t)1 << sizeClass);
+		this->_reused++;
+		pthread_mutex_unlock(&this->_mutex);
+		return (block);
+	}
+	pthread_mutex_unlock(&this->_mutex);
+
+	return (this->_upstream->allocate((size_t)1 << sizeClass,
+	    BlockAlignment));
+}
+
+void
+BiometricEvaluation::Memory::PoolResource::deallocate(
+    void *block,
+    size_t size,
+    size_t alignment)
+{
+	if (block == nullptr)
+		return;
+	const int sizeClass = this->getSizeClass(size, alignment);
+	if (sizeClass == -1) {
+		this->_upstream->deallocate(block, size, alignment);
+		return;
+	}
+
+	const size_t blockSize = (size_t)1 << sizeClass;
+	pthread_mutex_lock(&this->_mutex);
+	if (this->_retained + blockSize <= this->_maxRetained) {
+		try {
+			this->_freeLists[sizeClass].push_back(block);
+			this->_retained += blockSize;
+			pthread_mutex_unlock(&this->_mutex);
+			return;
+		} catch (std::bad_alloc &e) {
+			/* Give the block back instead */
+		}
+	}
+	pthread_mutex_unlock(&this->_mutex);
+	this->_upstream->deallocate(block, blockSize, BlockAlignment);
+}
+
+void *
+BiometricEvaluation::Memory::PoolResource::reallocate(
+    void *block,
+    size_t size,
+    size_t newSize,
+    size_t alignment)
+{
+	const int sizeClass = this->getSizeClass(size, alignment);
+	if ((block != nullptr) && (sizeClass != -1) &&
+	    (sizeClass == this->getSizeClass(newSize, alignment)))
+		return (block);
+	return (MemoryResource::reallocate(block, size, newSize, alignment));
+}
+
+void
+BiometricEvaluation::Memory::PoolResource::release()
+{
+	pthread_mutex_lock(&this->_mutex);
+	for (size_t i = 0; i < this->_freeLists.size(); i++) {
+		for (void *block : this->_freeLists[i])
+			this->_upstream->deallocate(block, (size_t)1 << i,
+			    BlockAlignment);
+		this->_freeLists[i].clear();
+		this->_freeLists[i].shrink_to_fit();
+	}
+	this->_retained = 0;
+	pthread_mutex_unlock(&this->_mutex);
+}
+
+size_t
+BiometricEvaluation::Memory::PoolResource::getRetainedSize()
+    const
+{
+	pthread_mutex_lock(&this->_mutex);
+	const size_t retained = this->_retained;
+	pthread_mutex_unlock(&this->_mutex);
+	return (retained);
+}
+
+uint64_t
+BiometricEvaluation::Memory::PoolResource::getReuseCount()
+    const
+{
+	pthread_mutex_lock(&this->_mutex);
+	const uint64_t reused = this->_reused;
+	pthread_mutex_unlock(&this->_mutex);
+	return (reused);
+}
+
+BiometricEvaluation::Memory::PoolResource::~PoolResource()
+{
+	this->release();
+	pthread_mutex_destroy(&this->_mutex);
+}
+
+/*
+ * ArenaResource.
+ */
+
+BiometricEvaluation::Memory::ArenaResource::ArenaResource(
+    size_t chunkSize,
+    MemoryResource *upstream) :
+    _chunkSize(chunkSize == 0 ? 1 : chunkSize),
+    _upstream(upstream == nullptr ? getNewDeleteResource() : upstream),
+    _current(0),
+    _offset(0),
+    _allocated(0)
+{
+
+}
+
+void *
+BiometricEvaluation::Memory::ArenaResource::allocate(
+    size_t size,
+    size_t alignment)
+{
+	if (size == 0)
+		size = 1;
+
+	/* Fit the block into the current chunk */
+	if (this->_current < this->_chunks.size()) {
+		const Chunk &chunk = this->_chunks[this->_current];
+		const size_t start = ((((uintptr_t)chunk.data + this->_offset +
+		    alignment - 1) & ~(uintptr_t)(alignment - 1)) -
+		    (uintptr_t)chunk.data);
+		if ((start <= chunk.size) && (size <= chunk.size - start)) {
+			this->_offset = start + size;
+			this->_allocated += size;
+			return (chunk.data + start);
+		}
+	}
+
+	/* Move to a kept chunk that is large enough, or get a new one */
+	const size_t needed = size + (alignment > ChunkAlignment ?
+	    alignment : 0);
+	const size_t next = this->_chunks.empty() ? 0 : this->_current + 1;
+	size_t found = next;
+	while ((found < this->_chunks.size()) &&
+	    (this->_chunks[found].size < needed))
+		found++;
+	if (found < this->_chunks.size()) {
+		std::swap(this->_chunks[found], this->_chunks[next]);
+	} else {
+		Chunk chunk;
+		chunk.size = (needed > this->_chunkSize) ? needed :
+		    this->_chunkSize;
+		chunk.data = static_cast<char *>(this->_upstream->allocate(
+		    chunk.size, ChunkAlignment));
+		if (chunk.data == nullptr)
+			return (nullptr);
+		try {
+			this->_chunks.insert(this->_chunks.begin() + next,
+			    chunk);
+		} catch (std::bad_alloc &e) {
+			this->_upstream->deallocate(chunk.data, chunk.size,
+			    ChunkAlignment);
+			return (nullptr);
+		}
+	}
+	this->_current = next;
+
+	const Chunk &chunk = this->_chunks[this->_current];
+	const size_t start = ((uintptr_t)chunk.data + alignment - 1) &
+	    ~(uintptr_t)(alignment - 1);
+	this->_offset = (start - (uintptr_t)chunk.data) + size;
+	this->_allocated += size;
+	return (reinterpret_cast<void *>(start));
+}
+
+void
+BiometricEvaluation::Memory::ArenaResource::deallocate(
+    void *block,
+    size_t size,
+    size_t alignment)
+{
+	/* Memory is reclaimed by reset() */
+}
+
+void *
+BiometricEvaluation::Memory::ArenaResource::reallocate(
+    void *block,
+    size_t size,
+    size_t newSize,
+    size_t alignment)
+{
+	if (block == nullptr)
+		return (this->allocate(newSize, alignment));
+	if (size == 0)
+		size = 1;
+	if (newSize <= size)
+		return (block);
+
+	/* The most recent block can grow into the rest of its chunk */
+	if (this->_current < this->_chunks.size()) {
+		const Chunk &chunk = this->_chunks[this->_current];
+		const size_t start = static_cast<char *>(block) - chunk.data;
+		if ((static_cast<char *>(block) >= chunk.data) &&
+		    (start + size == this->_offset) &&
+		    (newSize <= chunk.size - start)) {
+			this->_offset = start + newSize;
+			this->_allocated += newSize - size;
+			return (block);
+		}
+	}
+	return (MemoryResource::reallocate(block, size, newSize, alignment));
+}
+
+void
+BiometricEvaluation::Memory::ArenaResource::reset()
+{
+	this->_current = 0;
+	this->_offset = 0;
+	this->_allocated = 0;
+}
+
+void
+BiometricEvaluation::Memory::ArenaResource::release()
+{
+	for (const auto &chunk : this->_chunks)
+		this->_upstream->deallocate(chunk.data, chunk.size,
+		    ChunkAlignment);
+	this->_chunks.clear();
+	this->reset();
+}
+
+size_t
+BiometricEvaluation::Memory::ArenaResource::getAllocatedSize()
+    const
+{
+	return (this->_allocated);
+}
+
+size_t
+BiometricEvaluation::Memory::ArenaResource::getChunkSize()
+    const
+{
+	size_t size = 0;
+	for (const auto &chunk : this->_chunks)
+		size += chunk.size;
+	return (size);
+}
+
+BiometricEvaluation::Memory::ArenaResource::~ArenaResource()
+{
+	this->release();
+}
@@ -95,7 +95,7 @@ BiometricEvaluation::MPI::CSVDistributor::createWorkPackage(
 	 */
 	if (this->_resources->getNumRemainingLines() == 0) {
 		workPackage.setNumElements(0);
-		workPackage.setData(packageData);
+		workPackage.setData(std::move(packageData));
 		return;
 	}
 
@@ -141,6 +141,6 @@ BiometricEvaluation::MPI::CSVDistributor::createWorkPackage(
 	 * NOTE: At this point it is possible to have no keys in the package.
 	 */
 	workPackage.setNumElements(realKeyCount);
-	workPackage.setData(packageData);
+	workPackage.setData(std::move(packageData));
 }
 
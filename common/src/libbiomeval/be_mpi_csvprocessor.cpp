@@ -33,8 +33,7 @@ BiometricEvaluation::MPI::CSVProcessor::processWorkPackage(
 	/*
 	 * Extract the key/value data from the work package
 	 */
-	 Memory::uint8Array packageData(0);
-	 workPackage.getData(packageData);
+	 const Memory::ByteView packageData = workPackage.getDataView();
 	 uint64_t numElements = workPackage.getNumElements();
 
 	/*
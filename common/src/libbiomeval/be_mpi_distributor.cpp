@@ -104,11 +104,10 @@ BiometricEvaluation::MPI::Distributor::sendWorkPackage(
 	 * The raw data and length, in the first message;
 	 * The number of elements in the second message.
 	 */
-	BE::Memory::uint8Array data(0);
-	workPackage.getData(data);
+	const BE::Memory::ByteView data = workPackage.getDataView();
 	int size = static_cast<int>(data.size());
 	::MPI::COMM_WORLD.Send(
-	    (void *)data, size, MPI_CHAR, MPITask,
+	    (void *)data.data(), size, MPI_CHAR, MPITask,
 	    to_int_type(BE::MPI::MessageTag::Data));
 
 	uint64_t numElements = workPackage.getNumElements();
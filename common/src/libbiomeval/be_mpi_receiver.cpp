@@ -203,7 +203,7 @@ BiometricEvaluation::MPI::Receiver::PackageWorker::workerMain()
 			std::memcpy(&wpCount, &message[0], sizeof(wpCount));
 			this->waitForMessage();
 			this->receiveMessageFromManager(message);
-			workPackage = MPI::WorkPackage(message);
+			workPackage = MPI::WorkPackage(std::move(message));
 			workPackage.setNumElements(wpCount);
 		} catch (Error::Exception &e) {
 			MPI::logMessage(*log, "Failed to receive work package"
@@ -267,7 +267,6 @@ BiometricEvaluation::MPI::Receiver::sendWorkPackage(
 	 */
 	std::shared_ptr<Process::WorkerController> worker;
 	BE::Memory::uint8Array message;
-	BE::Memory::uint8Array wpData;
 	MPI::TaskStatus taskStatus;
 	BE::IO::Logsheet *log = this->_logsheet.get();
 
@@ -365,7 +364,7 @@ BiometricEvaluation::MPI::Receiver::sendWorkPackage(
 	message.resize(sizeof(wpCount));
 	std::memcpy(&message[0], &wpCount, sizeof(wpCount));
 	worker->sendMessageToWorker(message);
-	workPackage.getData(wpData);
+	const BE::Memory::ByteView wpData = workPackage.getDataView();
 	worker->sendMessageToWorker(wpData);
 	*log << "Sent work package of size " << wpData.size() << " to worker";
 	MPI::logEntry(*log);
@@ -42,8 +42,7 @@ BiometricEvaluation::MPI::RecordProcessor::processWorkPackage(
 	/*
 	 * Extract the key/value data from the work package
 	 */
-	 Memory::uint8Array packageData(0);
-	 workPackage.getData(packageData);
+	 const Memory::ByteView packageData = workPackage.getDataView();
 	 uint64_t numElements = workPackage.getNumElements();
 
 	/*
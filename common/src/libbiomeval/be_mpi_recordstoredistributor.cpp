@@ -69,7 +69,11 @@ fillBufferWithKeyAndValue(
 	uint64_t neededSpace = index		/* buffer space in use */
 	    + sizeof(uint32_t) + keyLength	/* space for key and length */
 	    + sizeof(uint64_t) + valueSize;	/* for value and size */
-	buf.resize(neededSpace);
+
+	/* Grow geometrically so each record is not a reallocation */
+	if (neededSpace > buf.capacity())
+		buf.reserve(std::max<uint64_t>(neededSpace, buf.capacity() * 2));
+	buf.resize_uninitialized(neededSpace);
 
 	/* Write the key length, value size, key, value if non-zero size */
 	uint32_t *pInt32 = (uint32_t *)&buf[index];
@@ -101,7 +105,7 @@ BiometricEvaluation::MPI::RecordStoreDistributor::createWorkPackage(
 	 */
 	if (this->_recordsRemaining == 0) {
 		workPackage.setNumElements(0);
-		workPackage.setData(packageData);
+		workPackage.setData(std::move(packageData));
 		return;
 	}
 
@@ -153,6 +157,6 @@ BiometricEvaluation::MPI::RecordStoreDistributor::createWorkPackage(
 	 * NOTE: At this point it is possible to have no keys in the package.
 	 */
 	workPackage.setNumElements(realKeyCount);
-	workPackage.setData(packageData);
+	workPackage.setData(std::move(packageData));
 }
 
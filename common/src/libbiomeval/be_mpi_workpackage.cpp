@@ -8,6 +8,8 @@
  * about its quality, reliability, or any other characteristic.
  */
 
+#include <utility>
+
 #include <be_mpi_workpackage.h>
 
 using namespace BiometricEvaluation;
@@ -25,6 +27,13 @@ BiometricEvaluation::MPI::WorkPackage::WorkPackage(
 	this->_data = data;
 }
 
+BiometricEvaluation::MPI::WorkPackage::WorkPackage(
+    Memory::uint8Array &&data) :
+    _data(std::move(data)),
+    _numElements(0)
+{
+}
+
 /******************************************************************************/
 /* Object method definitions.                                                 */
 /******************************************************************************/
@@ -39,12 +48,31 @@ BiometricEvaluation::MPI::WorkPackage::getData(Memory::uint8Array &data)
 	data = this->_data;
 }
 
+BiometricEvaluation::Memory::ByteView
+BiometricEvaluation::MPI::WorkPackage::getDataView()
+    const
+{
+	return (Memory::ByteView(this->_data));
+}
+
 void
 BiometricEvaluation::MPI::WorkPackage::setData(const Memory::uint8Array &data)
 {
 	this->_data = data;
 }
 
+void
+BiometricEvaluation::MPI::WorkPackage::setData(Memory::uint8Array &&data)
+{
+	this->_data = std::move(data);
+}
+
+void
+BiometricEvaluation::MPI::WorkPackage::setData(const Memory::ByteView &data)
+{
+	this->_data = data.to_array();
+}
+
 uint64_t
 BiometricEvaluation::MPI::WorkPackage::getSize() const
 {
@@ -8,7 +8,11 @@
  * about its quality, reliability, or any other characteristic.
  */
 
+#include <sys/socket.h>
 #include <sys/wait.h>
+#if defined Linux
+#include <sys/prctl.h>
+#endif
 
 #include <unistd.h>
 
@@ -28,10 +32,27 @@ std::list<BiometricEvaluation::Process::ForkManager*>
     BiometricEvaluation::Process::ForkManager::FORKMANAGERS =
     std::list<BiometricEvaluation::Process::ForkManager*>();
 
+#if defined Linux
+/** ForkManagers with a zygote, for which this process is a subreaper */
+static uint32_t ZYGOTEMANAGERS = 0;
+
+/** Stop being a subreaper once no ForkManager has a zygote */
+static void
+releaseSubreaper()
+{
+	if (ZYGOTEMANAGERS == 0)
+		prctl(PR_SET_CHILD_SUBREAPER, 0);
+}
+#endif
+
 BiometricEvaluation::Process::ForkManager::ForkManager() :
     _exitCallback(nullptr),
     _parent(false),
-    _wcStatus()
+    _wcStatus(),
+    _zygotePID(0),
+    _zygoteSocket(-1),
+    _zygoteWorkerCount(0),
+    _respawnLimit(0)
 {
 	BiometricEvaluation::Process::ForkManager::FORKMANAGERS.push_back(this);
 }
@@ -119,12 +140,33 @@ BiometricEvaluation::Process::ForkManager::startWorkers(
 		throw Error::ObjectExists();
 	this->reset();
 
-	for (uint32_t i = 0; i < getTotalWorkers(); i++) {
-		std::shared_ptr<ForkWorkerController> fwc =
-		    std::static_pointer_cast<ForkWorkerController>(_workers[i]);
-		fwc->start(communicate);
-		_wcStatus[fwc].pid = fwc->getPID();
-		_wcStatus[fwc].isWorking = true;
+	std::vector<std::shared_ptr<ForkWorkerController>> launched;
+	try {
+		for (uint32_t i = 0; i < getTotalWorkers(); i++) {
+			std::shared_ptr<ForkWorkerController> fwc =
+			    std::static_pointer_cast<ForkWorkerController>(
+			    _workers[i]);
+			this->launch(fwc, communicate);
+			launched.push_back(fwc);
+			_wcStatus[fwc].respawns = 0;
+		}
+	} catch (...) {
+		/* Don't leave some of the Workers running */
+		_parent = true;
+		for (const auto &fwc : launched) {
+			_pendingExit.push_back(fwc);
+			try {
+				fwc->stop();
+			} catch (const Error::Exception &e) {
+				/* Worker has already exited */
+			}
+		}
+		try {
+			this->waitForWorkerExit();
+		} catch (const Error::Exception &e) {
+			/* Report the original error */
+		}
+		throw;
 	}
 	
 	/* In the child case, start() will eventually exit the child */
@@ -163,12 +205,11 @@ BiometricEvaluation::Process::ForkManager::startWorker(
 
 	std::shared_ptr<ForkWorkerController> fwc =
 	    std::static_pointer_cast<ForkWorkerController>(*it);
-	fwc->start(communicate);
+	this->launch(fwc, communicate);
+	_wcStatus[fwc].respawns = 0;
 	
 	/* In the child case, start() will eventually exit the child */
 	_parent = true;
-	_wcStatus[fwc].pid = fwc->getPID();
-	_wcStatus[fwc].isWorking = true;
 
 	/* Optionally wait for all processes to exit. */
 	if (wait)
@@ -199,47 +240,328 @@ BiometricEvaluation::Process::ForkWorkerController::start(
 	int32_t pid = fork();
 	
 	switch (pid) {
-	case 0: {	/* Child */
-		/* Update self references */
-		_pid = getpid();
+	case 0:		/* Child */
+		this->runWorker(communicate);
+		
+		/* Not reached */
+		break;
+	case -1:	/* Error */
+		throw Error::StrategyError("Error during fork(): " +
+		    Error::errorStr());
+		break;
+	default:	/* Parent */
+		_pid = pid;
+		if (communicate)
+			getWorker()->closeWorkerPipeEnds();
+		break;
+	}
+}
+
+void
+BiometricEvaluation::Process::ForkWorkerController::runWorker(
+    bool communicate)
+{
+	/* Update self references */
+	_pid = getpid();
+	BiometricEvaluation::Process::ForkManager::FORKMANAGERS.erase(
+	    BiometricEvaluation::Process::ForkManager::
+	    FORKMANAGERS.begin(),
+	    BiometricEvaluation::Process::ForkManager::
+	    FORKMANAGERS.end());
+
+	/* Copy to a static var only for this process's instance */
+	_staticWorker = getWorker();
+	if (communicate)
+		_staticWorker->closeManagerPipeEnds();
+
+	/* Catch SIGUSR1 to quit child on demand */
+	struct sigaction stopSignal;			
+	memset(&stopSignal, 0, sizeof(stopSignal));
+	stopSignal.sa_handler = ForkWorkerController::_stop;
+	sigaction(SIGUSR1, &stopSignal, nullptr);
+	    
+	/* Run workerMain() -- required method */
+	int32_t rv;
+	try {
+		rv = getWorker()->workerMain();
+	} catch (...) {
+		rv = EXIT_FAILURE;
+	}
+	std::exit(rv);
+}
+
+void
+BiometricEvaluation::Process::ForkManager::launch(
+    std::shared_ptr<ForkWorkerController> fwc,
+    bool communicate)
+{
+	if (this->_zygoteSocket == -1) {
+		fwc->start(communicate);
+		_wcStatus[fwc].pid = fwc->getPID();
+		_wcStatus[fwc].isWorking = true;
+		_wcStatus[fwc].communicate = communicate;
+		return;
+	}
+
+	if (communicate)
+		throw Error::NotImplemented("Communication with Workers "
+		    "forked from a zygote");
+	if (this->_zygotePID == 0)
+		throw Error::StrategyError("Zygote is no longer running");
+	const uint32_t index = std::distance(_workers.begin(),
+	    find(_workers.begin(), _workers.end(), fwc));
+	if (index >= this->_zygoteWorkerCount)
+		throw Error::StrategyError("Worker was added after the "
+		    "zygote was started");
+	if (fwc->isWorking())
+		throw Error::ObjectExists();
+	fwc->reset();
+
+	/*
+	 * Hold off the reaper until the new PID is recorded, in case
+	 * the Worker exits immediately.
+	 */
+	sigset_t chld, previous;
+	sigemptyset(&chld);
+	sigaddset(&chld, SIGCHLD);
+	sigprocmask(SIG_BLOCK, &chld, &previous);
+
+	pid_t pid = -1;
+	ssize_t sz = 0;
+	do {
+		sz = write(this->_zygoteSocket, &index, sizeof(index));
+	} while ((sz == -1) && (errno == EINTR));
+	if (sz == sizeof(index)) {
+		do {
+			sz = read(this->_zygoteSocket, &pid, sizeof(pid));
+		} while ((sz == -1) && (errno == EINTR));
+	}
+	if ((sz != sizeof(pid)) || (pid <= 0)) {
+		sigprocmask(SIG_SETMASK, &previous, nullptr);
+		throw Error::StrategyError("Zygote could not fork Worker");
+	}
+
+	fwc->_pid = pid;
+	_wcStatus[fwc].pid = pid;
+	_wcStatus[fwc].isWorking = true;
+	_wcStatus[fwc].communicate = false;
+	sigprocmask(SIG_SETMASK, &previous, nullptr);
+}
+
+void
+BiometricEvaluation::Process::ForkManager::respawnIfFailed(
+    std::shared_ptr<ForkWorkerController> fwc,
+    int status)
+{
+	if ((WIFEXITED(status) && (WEXITSTATUS(status) == EXIT_SUCCESS)) ||
+	    (!WIFEXITED(status) && !WIFSIGNALED(status)))
+		return;
+
+	/* Workers asked to stop are not restarted */
+	if (find(_pendingExit.begin(), _pendingExit.end(), fwc) !=
+	    _pendingExit.end())
+		return;
+
+	Status &workerStatus = _wcStatus[fwc];
+	if (workerStatus.communicate ||
+	    (workerStatus.respawns >= this->_respawnLimit))
+		return;
+
+	/* A Worker that cannot be restarted stays stopped */
+	const uint32_t respawns = workerStatus.respawns;
+	try {
+		this->launch(fwc, false);
+	} catch (const Error::Exception &e) {
+		return;
+	}
+	_wcStatus[fwc].respawns = respawns + 1;
+}
+
+void
+BiometricEvaluation::Process::ForkManager::enableZygote(
+    const std::function<void()> &initializer)
+{
+#if !defined Linux
+	/*
+	 * Workers are forked by the zygote, so a way to adopt them as
+	 * children of this process (PR_SET_CHILD_SUBREAPER) is required.
+	 */
+	throw Error::NotImplemented();
+#else
+	if (this->_zygoteSocket != -1)
+		throw Error::ObjectExists("Zygote is already running");
+
+	/* Become the parent of Workers orphaned by the zygote */
+	if (prctl(PR_SET_CHILD_SUBREAPER, 1) != 0)
+		throw Error::StrategyError("Could not become subreaper: " +
+		    Error::errorStr());
+
+	int sockets[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+		const std::string error = Error::errorStr();
+		releaseSubreaper();
+		throw Error::StrategyError("Could not create zygote socket: " +
+		    error);
+	}
+
+	pid_t pid = fork();
+	switch (pid) {
+	case 0: {	/* Zygote */
+		close(sockets[0]);
 		BiometricEvaluation::Process::ForkManager::FORKMANAGERS.erase(
 		    BiometricEvaluation::Process::ForkManager::
 		    FORKMANAGERS.begin(),
 		    BiometricEvaluation::Process::ForkManager::
 		    FORKMANAGERS.end());
 
-		/* Copy to a static var only for this process's instance */
-		_staticWorker = getWorker();
-		if (communicate)
-			_staticWorker->closeManagerPipeEnds();
-
-		/* Catch SIGUSR1 to quit child on demand */
-		struct sigaction stopSignal;			
-		memset(&stopSignal, 0, sizeof(stopSignal));
-		stopSignal.sa_handler = ForkWorkerController::_stop;
-		sigaction(SIGUSR1, &stopSignal, nullptr);
-		    
-		/* Run workerMain() -- required method */
-		int32_t rv;
+		/* The zygote reaps its own intermediate children */
+		struct sigaction defaultSignal;
+		memset(&defaultSignal, 0, sizeof(defaultSignal));
+		defaultSignal.sa_handler = SIG_DFL;
+		sigaction(SIGCHLD, &defaultSignal, nullptr);
+
+		uint8_t ready = 1;
 		try {
-			rv = getWorker()->workerMain();
+			initializer();
 		} catch (...) {
-			rv = EXIT_FAILURE;
+			ready = 0;
 		}
-		std::exit(rv);
+		if ((write(sockets[1], &ready, sizeof(ready)) !=
+		    sizeof(ready)) || (ready == 0))
+			_exit(EXIT_FAILURE);
+
+		this->zygoteMain(sockets[1]);
 		
 		/* Not reached */
 		break;
-	} case -1:	/* Error */
-		throw Error::StrategyError("Error during fork(): " +
-		    Error::errorStr());
-		break;
-	default:	/* Parent */
-		_pid = pid;
-		if (communicate)
-			getWorker()->closeWorkerPipeEnds();
+	} case -1: {	/* Error */
+		const std::string error = Error::errorStr();
+		close(sockets[0]);
+		close(sockets[1]);
+		releaseSubreaper();
+		throw Error::StrategyError("Error during fork(): " + error);
+	} default:	/* Manager */
+		close(sockets[1]);
 		break;
 	}
+
+	uint8_t ready = 0;
+	ssize_t sz;
+	do {
+		sz = read(sockets[0], &ready, sizeof(ready));
+	} while ((sz == -1) && (errno == EINTR));
+	if ((sz != sizeof(ready)) || (ready == 0)) {
+		close(sockets[0]);
+		waitpid(pid, nullptr, 0);
+		releaseSubreaper();
+		throw Error::StrategyError("Zygote initialization failed");
+	}
+
+	ZYGOTEMANAGERS++;
+	this->_zygotePID = pid;
+	this->_zygoteSocket = sockets[0];
+	this->_zygoteWorkerCount = this->_workers.size();
+#endif
+}
+
+void
+BiometricEvaluation::Process::ForkManager::zygoteMain(
+    int controlSocket)
+{
+	/* This process' copy of the Manager does not own a zygote */
+	this->_zygotePID = 0;
+	this->_zygoteSocket = -1;
+
+	while (true) {
+		uint32_t index;
+		ssize_t sz = read(controlSocket, &index, sizeof(index));
+		if ((sz == -1) && (errno == EINTR))
+			continue;
+		/* Manager closed the socket or disableZygote() */
+		if ((sz != sizeof(index)) || (index >= _workers.size()))
+			_exit(EXIT_SUCCESS);
+
+		/*
+		 * Fork twice, so that the Worker is orphaned and adopted
+		 * by the Manager, its nearest subreaper.
+		 */
+		pid_t intermediate = fork();
+		switch (intermediate) {
+		case 0: {	/* Intermediate */
+			pid_t pid = fork();
+			if (pid == 0) {
+				close(controlSocket);
+				std::static_pointer_cast<ForkWorkerController>(
+				    _workers[index])->runWorker(false);
+			}
+			(void)write(controlSocket, &pid, sizeof(pid));
+			_exit(EXIT_SUCCESS);
+		} case -1: {	/* Error */
+			pid_t pid = -1;
+			(void)write(controlSocket, &pid, sizeof(pid));
+			break;
+		} default:	/* Zygote */
+			while ((waitpid(intermediate, nullptr, 0) == -1) &&
+			    (errno == EINTR));
+			break;
+		}
+	}
+}
+
+void
+BiometricEvaluation::Process::ForkManager::disableZygote()
+{
+	if (this->_zygoteSocket == -1)
+		return;
+
+	/* The zygote exits when its socket is closed */
+	close(this->_zygoteSocket);
+	this->_zygoteSocket = -1;
+	if (this->_zygotePID != 0) {
+		while ((waitpid(this->_zygotePID, nullptr, 0) == -1) &&
+		    (errno == EINTR));
+		this->_zygotePID = 0;
+	}
+	this->_zygoteWorkerCount = 0;
+
+#if defined Linux
+	/* Workers already adopted remain children of this process */
+	ZYGOTEMANAGERS--;
+	releaseSubreaper();
+#endif
+}
+
+bool
+BiometricEvaluation::Process::ForkManager::hasZygote()
+    const
+{
+	return (this->_zygoteSocket != -1);
+}
+
+void
+BiometricEvaluation::Process::ForkManager::setRespawnLimit(
+    const uint32_t limit)
+{
+	this->_respawnLimit = limit;
+}
+
+uint32_t
+BiometricEvaluation::Process::ForkManager::getRespawnLimit()
+    const
+{
+	return (this->_respawnLimit);
+}
+
+uint32_t
+BiometricEvaluation::Process::ForkManager::getRespawnCount(
+    std::shared_ptr<WorkerController> workerController)
+    const
+{
+	const auto it = _wcStatus.find(
+	    std::static_pointer_cast<ForkWorkerController>(workerController));
+	if (it == _wcStatus.end())
+		throw Error::ObjectDoesNotExist();
+	return (it->second.respawns);
 }
 
 void
@@ -343,9 +665,24 @@ BiometricEvaluation::Process::ForkManager::_wait()
 			case 0:	/* Child exists but hasn't changed state */
 				break;
 			default:
+				/* The zygote is not a Worker */
+				if (process == this->_zygotePID) {
+					this->_zygotePID = 0;
+					break;
+				}
+
+				/*
+				 * As a subreaper, a Manager with a zygote
+				 * also adopts processes orphaned by Workers.
+				 * They are reaped without being reported.
+				 */
+				if (this->hasZygote() &&
+				    !this->responsibleFor(process))
+					break;
+
 				try {
 					this->setNotWorking(process);
-				} catch (Error::ObjectDoesNotExist) {
+				} catch (const Error::ObjectDoesNotExist &e) {
 					throw Error::StrategyError(
 					    Error::errorStr());
 				}
@@ -356,6 +693,9 @@ BiometricEvaluation::Process::ForkManager::_wait()
 					_exitCallback(
 					    getProcessWithPID(process), status);
 				}
+				if (this->_respawnLimit != 0)
+					this->respawnIfFailed(
+					    getProcessWithPID(process), status);
 				stop = true;
 				break;
 			}
@@ -414,6 +754,8 @@ BiometricEvaluation::Process::ForkManager::reap(
 		default:	/* Reap successful */
 			/* Update the Status list */
 			for (auto &it : FORKMANAGERS) {
+				if (it->_zygotePID == pid)
+					it->_zygotePID = 0;
 				if (it->responsibleFor(pid)) {
 					it->setExitStatus(pid, status);
 					it->setNotWorking(pid);
@@ -459,13 +801,16 @@ BiometricEvaluation::Process::ForkManager::defaultExitCallback(
 
 BiometricEvaluation::Process::ForkManager::Status::Status() :
     pid(0),
-    isWorking(false)
+    isWorking(false),
+    communicate(false),
+    respawns(0)
 {
 
 }
 
 BiometricEvaluation::Process::ForkManager::~ForkManager()
 {
+	this->disableZygote();
 	BiometricEvaluation::Process::ForkManager::FORKMANAGERS.remove(this);
 }
 
@@ -0,0 +1,530 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+#include <be_error.h>
+#include <be_error_exception.h>
+#include <be_io_utility.h>
+#include <be_process_shareddataset.h>
+
+namespace BE = BiometricEvaluation;
+
+/** Identifies a SharedDataset segment ("BESHDS01") */
+static const uint64_t SHAREDDATASETMAGIC = 0x4245534844533031ULL;
+/** Alignment of each section and of each record */
+static const uint64_t SEGMENTALIGNMENT = 64;
+
+/** @return value rounded up to the segment alignment */
+static inline uint64_t
+align(
+    const uint64_t value)
+{
+	return (((value + SEGMENTALIGNMENT - 1) / SEGMENTALIGNMENT) *
+	    SEGMENTALIGNMENT);
+}
+
+struct BiometricEvaluation::Process::SharedDataset::Header
+{
+	uint64_t magic;
+	/** Number of records */
+	uint64_t count;
+	/** Offsets of each section from the start of the segment */
+	uint64_t indexOffset;
+	uint64_t keysOffset;
+	uint64_t dataOffset;
+	/** Total size of the segment */
+	uint64_t segmentSize;
+	uint64_t reserved[2];
+};
+
+struct BiometricEvaluation::Process::SharedDataset::IndexEntry
+{
+	/** Offsets are from the start of the segment */
+	uint64_t keyOffset;
+	uint64_t keyLength;
+	uint64_t dataOffset;
+	uint64_t dataLength;
+};
+
+/** @return Whether length bytes at offset lie within [begin, end) */
+static inline bool
+withinSection(
+    const uint64_t offset,
+    const uint64_t length,
+    const uint64_t begin,
+    const uint64_t end)
+{
+	return ((offset >= begin) && (offset <= end) &&
+	    (length <= end - offset));
+}
+
+/**
+ * Copy a record read from rs, which must still be the length it had
+ * when the segment was laid out.
+ */
+static void
+copyRecord(
+    const std::shared_ptr<BE::IO::RecordStore> &rs,
+    const std::string &key,
+    uint8_t *destination,
+    uint64_t length)
+{
+	const BE::Memory::uint8Array data = rs->read(key);
+	if (data.size() != length)
+		throw BE::Error::DataError("Length of " + key + " changed "
+		    "while loading");
+	std::memcpy(destination, data, data.size());
+}
+
+BiometricEvaluation::Process::SharedDataset::SharedDataset(
+    const std::shared_ptr<IO::RecordStore> &rs) :
+    _segment(nullptr),
+    _segmentSize(0),
+    _fd(-1)
+{
+	std::vector<Extent> extents;
+	extents.reserve(rs->getCount());
+	try {
+		int cursor = IO::RecordStore::BE_RECSTORE_SEQ_START;
+		while (true) {
+			const std::string key = rs->sequenceKey(cursor);
+			cursor = IO::RecordStore::BE_RECSTORE_SEQ_NEXT;
+			extents.push_back(Extent(key, rs->length(key)));
+		}
+	} catch (BE::Error::ObjectDoesNotExist&) {
+		/* End of sequence */
+	}
+
+	this->createAnonymous(extents, [&](const std::string &key,
+	    uint8_t *destination, uint64_t length) {
+		copyRecord(rs, key, destination, length);
+	});
+}
+
+BiometricEvaluation::Process::SharedDataset::SharedDataset(
+    const std::vector<IO::RecordStore::Record> &records) :
+    _segment(nullptr),
+    _segmentSize(0),
+    _fd(-1)
+{
+	std::vector<Extent> extents;
+	std::map<std::string, const Memory::uint8Array*> data;
+	extents.reserve(records.size());
+	for (const auto &record : records) {
+		extents.push_back(Extent(record.key, record.data.size()));
+		data[record.key] = &record.data;
+	}
+
+	this->createAnonymous(extents, [&](const std::string &key,
+	    uint8_t *destination, uint64_t length) {
+		const Memory::uint8Array *source = data[key];
+		std::memcpy(destination, *source, source->size());
+	});
+}
+
+BiometricEvaluation::Process::SharedDataset::SharedDataset(
+    const std::string &pathname) :
+    _segment(nullptr),
+    _segmentSize(0),
+    _fd(-1)
+{
+	int fd = open(pathname.c_str(), O_RDONLY);
+	if (fd == -1)
+		throw BE::Error::FileError("Could not open " + pathname +
+		    ": " + BE::Error::errorStr());
+	struct stat sb;
+	if (fstat(fd, &sb) != 0) {
+		const std::string err = BE::Error::errorStr();
+		close(fd);
+		throw BE::Error::FileError("Could not stat " + pathname +
+		    ": " + err);
+	}
+	if (static_cast<uint64_t>(sb.st_size) < sizeof(Header)) {
+		close(fd);
+		throw BE::Error::StrategyError(pathname + " is not a "
+		    "SharedDataset");
+	}
+	this->_segmentSize = sb.st_size;
+
+	void *segment = mmap(nullptr, this->_segmentSize, PROT_READ,
+	    MAP_SHARED, fd, 0);
+	close(fd);
+	if (segment == MAP_FAILED)
+		throw BE::Error::StrategyError("Could not map " + pathname +
+		    ": " + BE::Error::errorStr());
+	this->_segment = static_cast<const uint8_t*>(segment);
+
+	try {
+		this->validate();
+	} catch (BE::Error::Exception&) {
+		munmap(segment, this->_segmentSize);
+		throw;
+	}
+}
+
+BiometricEvaluation::Process::SharedDataset::~SharedDataset()
+{
+	munmap(const_cast<uint8_t*>(this->_segment), this->_segmentSize);
+	if (this->_fd != -1)
+		close(this->_fd);
+}
+
+void
+BiometricEvaluation::Process::SharedDataset::createFile(
+    const std::string &pathname,
+    const std::shared_ptr<IO::RecordStore> &rs)
+{
+	if (IO::Utility::fileExists(pathname))
+		throw BE::Error::ObjectExists(pathname);
+
+	std::vector<Extent> extents;
+	extents.reserve(rs->getCount());
+	try {
+		int cursor = IO::RecordStore::BE_RECSTORE_SEQ_START;
+		while (true) {
+			const std::string key = rs->sequenceKey(cursor);
+			cursor = IO::RecordStore::BE_RECSTORE_SEQ_NEXT;
+			extents.push_back(Extent(key, rs->length(key)));
+		}
+	} catch (BE::Error::ObjectDoesNotExist&) {
+		/* End of sequence */
+	}
+	const uint64_t size = layoutSize(extents);
+
+	int fd = open(pathname.c_str(), O_RDWR | O_CREAT | O_EXCL,
+	    S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fd == -1) {
+		if (errno == EEXIST)
+			throw BE::Error::ObjectExists(pathname);
+		throw BE::Error::FileError("Could not create " + pathname +
+		    ": " + BE::Error::errorStr());
+	}
+	if (ftruncate(fd, size) != 0) {
+		const std::string err = BE::Error::errorStr();
+		close(fd);
+		unlink(pathname.c_str());
+		throw BE::Error::FileError("Could not size " + pathname +
+		    ": " + err);
+	}
+	void *segment = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+	    MAP_SHARED, fd, 0);
+	close(fd);
+	if (segment == MAP_FAILED) {
+		const std::string err = BE::Error::errorStr();
+		unlink(pathname.c_str());
+		throw BE::Error::FileError("Could not map " + pathname +
+		    ": " + err);
+	}
+
+	try {
+		layout(static_cast<uint8_t*>(segment), extents,
+		    [&](const std::string &key, uint8_t *destination,
+		    uint64_t length) {
+			copyRecord(rs, key, destination, length);
+		});
+	} catch (BE::Error::Exception&) {
+		munmap(segment, size);
+		unlink(pathname.c_str());
+		throw;
+	}
+	if (msync(segment, size, MS_SYNC) != 0) {
+		const std::string err = BE::Error::errorStr();
+		munmap(segment, size);
+		unlink(pathname.c_str());
+		throw BE::Error::FileError("Could not write " + pathname +
+		    ": " + err);
+	}
+	munmap(segment, size);
+}
+
+uint64_t
+BiometricEvaluation::Process::SharedDataset::layoutSize(
+    std::vector<Extent> &extents)
+{
+	std::sort(extents.begin(), extents.end(),
+	    [](const Extent &lhs, const Extent &rhs) -> bool {
+		return (lhs.first < rhs.first);
+	});
+
+	uint64_t keysSize = 0, dataSize = 0;
+	for (auto it = extents.cbegin(); it != extents.cend(); it++) {
+		if ((it != extents.cbegin()) && ((it - 1)->first == it->first))
+			throw BE::Error::ObjectExists(it->first);
+		keysSize += it->first.size();
+		dataSize += align(it->second);
+	}
+
+	return (align(sizeof(Header)) +
+	    align(extents.size() * sizeof(IndexEntry)) +
+	    align(keysSize) + dataSize);
+}
+
+void
+BiometricEvaluation::Process::SharedDataset::layout(
+    uint8_t *segment,
+    const std::vector<Extent> &extents,
+    const Filler &fill)
+{
+	Header *header = reinterpret_cast<Header*>(segment);
+	std::memset(header, 0, sizeof(Header));
+	header->count = extents.size();
+	header->indexOffset = align(sizeof(Header));
+	header->keysOffset = header->indexOffset +
+	    align(extents.size() * sizeof(IndexEntry));
+
+	uint64_t keysSize = 0;
+	for (const auto &extent : extents)
+		keysSize += extent.first.size();
+	header->dataOffset = header->keysOffset + align(keysSize);
+
+	IndexEntry *index = reinterpret_cast<IndexEntry*>(segment +
+	    header->indexOffset);
+	uint64_t keyOffset = header->keysOffset;
+	uint64_t dataOffset = header->dataOffset;
+	for (uint64_t i = 0; i < extents.size(); i++) {
+		index[i].keyOffset = keyOffset;
+		index[i].keyLength = extents[i].first.size();
+		std::memcpy(segment + keyOffset, extents[i].first.data(),
+		    index[i].keyLength);
+		keyOffset += index[i].keyLength;
+
+		index[i].dataOffset = dataOffset;
+		index[i].dataLength = extents[i].second;
+		fill(extents[i].first, segment + dataOffset,
+		    index[i].dataLength);
+		dataOffset += align(index[i].dataLength);
+	}
+	header->segmentSize = dataOffset;
+
+	/* Only a completely formatted segment is valid */
+	header->magic = SHAREDDATASETMAGIC;
+}
+
+void
+BiometricEvaluation::Process::SharedDataset::createAnonymous(
+    std::vector<Extent> &extents,
+    const Filler &fill)
+{
+	this->_segmentSize = layoutSize(extents);
+	void *segment;
+
+#if defined Linux && defined MFD_ALLOW_SEALING
+	/*
+	 * Back the segment with a memfd, sealed once written so that no
+	 * process holding the descriptor can change it.
+	 */
+	this->_fd = memfd_create("BiometricEvaluation::SharedDataset",
+	    MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (this->_fd == -1)
+		throw BE::Error::StrategyError("Could not create memfd: " +
+		    BE::Error::errorStr());
+	if (ftruncate(this->_fd, this->_segmentSize) != 0) {
+		const std::string err = BE::Error::errorStr();
+		close(this->_fd);
+		throw BE::Error::StrategyError("Could not size memfd: " + err);
+	}
+	segment = mmap(nullptr, this->_segmentSize, PROT_READ | PROT_WRITE,
+	    MAP_SHARED, this->_fd, 0);
+	if (segment == MAP_FAILED) {
+		const std::string err = BE::Error::errorStr();
+		close(this->_fd);
+		throw BE::Error::StrategyError("Could not map memfd: " + err);
+	}
+	try {
+		layout(static_cast<uint8_t*>(segment), extents, fill);
+	} catch (BE::Error::Exception&) {
+		munmap(segment, this->_segmentSize);
+		close(this->_fd);
+		throw;
+	}
+
+	/* Writable mappings must be gone before sealing writes */
+	munmap(segment, this->_segmentSize);
+	if (fcntl(this->_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW |
+	    F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+		const std::string err = BE::Error::errorStr();
+		close(this->_fd);
+		throw BE::Error::StrategyError("Could not seal memfd: " + err);
+	}
+	segment = mmap(nullptr, this->_segmentSize, PROT_READ, MAP_SHARED,
+	    this->_fd, 0);
+	if (segment == MAP_FAILED) {
+		const std::string err = BE::Error::errorStr();
+		close(this->_fd);
+		throw BE::Error::StrategyError("Could not map memfd: " + err);
+	}
+#else
+	segment = mmap(nullptr, this->_segmentSize, PROT_READ | PROT_WRITE,
+	    MAP_SHARED | MAP_ANON, -1, 0);
+	if (segment == MAP_FAILED)
+		throw BE::Error::StrategyError("Could not map dataset: " +
+		    BE::Error::errorStr());
+	try {
+		layout(static_cast<uint8_t*>(segment), extents, fill);
+	} catch (BE::Error::Exception&) {
+		munmap(segment, this->_segmentSize);
+		throw;
+	}
+	if (mprotect(segment, this->_segmentSize, PROT_READ) != 0) {
+		const std::string err = BE::Error::errorStr();
+		munmap(segment, this->_segmentSize);
+		throw BE::Error::StrategyError("Could not protect dataset: " +
+		    err);
+	}
+#endif
+	this->_segment = static_cast<const uint8_t*>(segment);
+}
+
+void
+BiometricEvaluation::Process::SharedDataset::validate()
+    const
+{
+	const Header *header = reinterpret_cast<const Header*>(
+	    this->_segment);
+	if ((header->magic != SHAREDDATASETMAGIC) ||
+	    (header->segmentSize > this->_segmentSize) ||
+	    (header->keysOffset > header->dataOffset) ||
+	    (header->dataOffset > header->segmentSize) ||
+	    (header->indexOffset > header->keysOffset) ||
+	    (header->count > (header->keysOffset - header->indexOffset) /
+	    sizeof(IndexEntry)))
+		throw BE::Error::StrategyError("Not a SharedDataset");
+
+	/* Records are read through ByteViews without further checks */
+	const IndexEntry *index = reinterpret_cast<const IndexEntry*>(
+	    this->_segment + header->indexOffset);
+	for (uint64_t i = 0; i < header->count; i++) {
+		if (!withinSection(index[i].keyOffset, index[i].keyLength,
+		    header->keysOffset, header->dataOffset) ||
+		    !withinSection(index[i].dataOffset, index[i].dataLength,
+		    header->dataOffset, header->segmentSize))
+			throw BE::Error::DataError("SharedDataset index "
+			    "entry " + std::to_string(i) + " is outside the "
+			    "segment");
+	}
+}
+
+const BiometricEvaluation::Process::SharedDataset::IndexEntry*
+BiometricEvaluation::Process::SharedDataset::find(
+    const std::string &key)
+    const
+{
+	const Header *header = reinterpret_cast<const Header*>(
+	    this->_segment);
+	const IndexEntry *first = reinterpret_cast<const IndexEntry*>(
+	    this->_segment + header->indexOffset);
+	const IndexEntry *last = first + header->count;
+
+	const IndexEntry *it = std::lower_bound(first, last, key,
+	    [&](const IndexEntry &entry, const std::string &value) -> bool {
+		return (value.compare(0, std::string::npos,
+		    reinterpret_cast<const char*>(this->_segment +
+		    entry.keyOffset), entry.keyLength) > 0);
+	});
+	if ((it == last) || (key.compare(0, std::string::npos,
+	    reinterpret_cast<const char*>(this->_segment + it->keyOffset),
+	    it->keyLength) != 0))
+		return (nullptr);
+	return (it);
+}
+
+const BiometricEvaluation::Process::SharedDataset::IndexEntry*
+BiometricEvaluation::Process::SharedDataset::entry(
+    const std::string &key)
+    const
+{
+	const IndexEntry *entry = this->find(key);
+	if (entry == nullptr)
+		throw BE::Error::ObjectDoesNotExist(key);
+	return (entry);
+}
+
+uint64_t
+BiometricEvaluation::Process::SharedDataset::getCount()
+    const
+{
+	return (reinterpret_cast<const Header*>(this->_segment)->count);
+}
+
+uint64_t
+BiometricEvaluation::Process::SharedDataset::getSegmentSize()
+    const
+{
+	return (this->_segmentSize);
+}
+
+int
+BiometricEvaluation::Process::SharedDataset::getFileDescriptor()
+    const
+{
+	return (this->_fd);
+}
+
+bool
+BiometricEvaluation::Process::SharedDataset::containsKey(
+    const std::string &key)
+    const
+{
+	return (this->find(key) != nullptr);
+}
+
+uint64_t
+BiometricEvaluation::Process::SharedDataset::length(
+    const std::string &key)
+    const
+{
+	return (this->entry(key)->dataLength);
+}
+
+const uint8_t*
+BiometricEvaluation::Process::SharedDataset::getData(
+    const std::string &key)
+    const
+{
+	return (this->_segment + this->entry(key)->dataOffset);
+}
+
+BiometricEvaluation::Memory::uint8Array
+BiometricEvaluation::Process::SharedDataset::read(
+    const std::string &key)
+    const
+{
+	const IndexEntry *entry = this->entry(key);
+	Memory::uint8Array data;
+	data.copy(this->_segment + entry->dataOffset, entry->dataLength);
+	return (data);
+}
+
+std::string
+BiometricEvaluation::Process::SharedDataset::getKey(
+    const uint64_t index)
+    const
+{
+	const Header *header = reinterpret_cast<const Header*>(
+	    this->_segment);
+	if (index >= header->count)
+		throw BE::Error::ObjectDoesNotExist("Index out of range");
+
+	const IndexEntry *entry = reinterpret_cast<const IndexEntry*>(
+	    this->_segment + header->indexOffset) + index;
+	return (std::string(reinterpret_cast<const char*>(this->_segment +
+	    entry->keyOffset), entry->keyLength));
+}
@@ -0,0 +1,537 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#if defined Linux
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <new>
+
+#include <be_error.h>
+#include <be_error_exception.h>
+#include <be_process_sharedqueue.h>
+#include <be_time.h>
+
+namespace BE = BiometricEvaluation;
+
+/** Identifies a formatted SharedQueue segment ("BESHMQ01") */
+static const uint64_t SHAREDQUEUEMAGIC = 0x4245534832513031ULL;
+/** Alignment of the control block fields and of each slot */
+static const uint64_t CACHELINESIZE = 64;
+
+struct BiometricEvaluation::Process::SharedQueue::Header
+{
+	/** Set last, once the segment is completely formatted */
+	std::atomic<uint64_t> magic;
+	/** Number of slots in the ring */
+	uint32_t numSlots;
+	/** Largest message that fits in a slot */
+	uint64_t maxMessageSize;
+	/** Distance between consecutive slots */
+	uint64_t slotStride;
+
+	/* Producer and consumer cursors live on separate cache lines */
+	alignas(CACHELINESIZE) std::atomic<uint64_t> enqueuePos;
+	alignas(CACHELINESIZE) std::atomic<uint64_t> dequeuePos;
+
+	/** Bumped by consumers when a slot is freed */
+	alignas(CACHELINESIZE) std::atomic<uint32_t> spaceEvent;
+	/** Number of producers sleeping on spaceEvent */
+	std::atomic<uint32_t> spaceWaiters;
+	/** Bumped by producers when a message is published */
+	alignas(CACHELINESIZE) std::atomic<uint32_t> dataEvent;
+	/** Number of consumers sleeping on dataEvent */
+	std::atomic<uint32_t> dataWaiters;
+};
+
+struct BiometricEvaluation::Process::SharedQueue::Slot
+{
+	/**
+	 * Position this slot is ready for: equal to the enqueue position
+	 * when free, and to the enqueue position + 1 when it holds a
+	 * message (D. Vyukov's bounded MPMC queue).
+	 */
+	std::atomic<uint64_t> sequence;
+	/** Size of the message held */
+	uint64_t length;
+};
+
+/*
+ * Sleep/wake primitives. On Linux, these are process-shared futexes on
+ * the event counter; elsewhere, waiters poll the counter.
+ */
+namespace
+{
+	/**
+	 * @return
+	 * 0 when woken or the counter changed, -1 with errno set to
+	 * EINTR or ETIMEDOUT otherwise.
+	 */
+	int
+	waitOnEvent(
+	    std::atomic<uint32_t> &event,
+	    const uint32_t observed,
+	    const struct timespec *timeout)
+	{
+#if defined Linux
+		return (syscall(SYS_futex,
+		    reinterpret_cast<uint32_t*>(&event), FUTEX_WAIT,
+		    observed, timeout, nullptr, 0) == 0 ||
+		    errno == EAGAIN ? 0 : -1);
+#else
+		/* Poll; callers recheck their deadline after each nap */
+		struct timespec nap = {0, 100 *
+		    BE::Time::NanosecondsPerMicrosecond};
+		if ((timeout != nullptr) && (timeout->tv_sec == 0) &&
+		    (timeout->tv_nsec < nap.tv_nsec))
+			nap.tv_nsec = timeout->tv_nsec;
+		if (event.load() != observed)
+			return (0);
+		return (nanosleep(&nap, nullptr));
+#endif
+	}
+
+	void
+	signalEvent(
+	    std::atomic<uint32_t> &event,
+	    std::atomic<uint32_t> &waiters)
+	{
+		event.fetch_add(1);
+#if defined Linux
+		if (waiters.load() != 0)
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&event),
+			    FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#endif
+	}
+
+	/** @return Microseconds on a clock unaffected by time changes */
+	uint64_t
+	monotonicMicroseconds()
+	{
+		struct timespec ts;
+#if defined Darwin
+		struct timeval tv;
+		(void)gettimeofday(&tv, nullptr);
+		ts.tv_sec = tv.tv_sec;
+		ts.tv_nsec = tv.tv_usec * BE::Time::NanosecondsPerMicrosecond;
+#else
+		(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+		return ((ts.tv_sec * BE::Time::MicrosecondsPerSecond) +
+		    (ts.tv_nsec / BE::Time::NanosecondsPerMicrosecond));
+	}
+}
+
+BiometricEvaluation::Process::SharedQueue::SharedQueue(
+    const uint32_t numSlots,
+    const uint64_t maxMessageSize) :
+    _segment(nullptr),
+    _segmentSize(segmentSize(numSlots, maxMessageSize)),
+    _header(nullptr),
+    _name(),
+    _creatorPID(getpid())
+{
+	void *segment = mmap(nullptr, this->_segmentSize,
+	    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+	if (segment == MAP_FAILED)
+		throw BE::Error::StrategyError("Could not map queue: " +
+		    BE::Error::errorStr());
+	this->_segment = static_cast<uint8_t*>(segment);
+
+	this->format(numSlots, maxMessageSize);
+}
+
+BiometricEvaluation::Process::SharedQueue::SharedQueue(
+    const std::string &name,
+    const mode_t mode,
+    const uint32_t numSlots,
+    const uint64_t maxMessageSize,
+    const bool exclusive) :
+    _segment(nullptr),
+    _segmentSize(segmentSize(numSlots, maxMessageSize)),
+    _header(nullptr),
+    _name(name),
+    _creatorPID(getpid())
+{
+	if (exclusive) {
+		if (shm_unlink(name.c_str()) != 0) {
+			if ((errno != ENOENT) && (errno != EINVAL)) {
+				throw BE::Error::StrategyError(
+				    "Could not remove queue: " +
+				    BE::Error::errorStr());
+			}
+		}
+	}
+
+	int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, mode);
+	if (fd == -1) {
+		if (errno == EEXIST)
+			throw BE::Error::ObjectExists();
+		throw BE::Error::StrategyError("Could not create queue: " +
+		    BE::Error::errorStr());
+	}
+	if (ftruncate(fd, this->_segmentSize) != 0) {
+		const std::string err = BE::Error::errorStr();
+		close(fd);
+		shm_unlink(name.c_str());
+		throw BE::Error::StrategyError("Could not size queue: " + err);
+	}
+	void *segment = mmap(nullptr, this->_segmentSize,
+	    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (segment == MAP_FAILED) {
+		const std::string err = BE::Error::errorStr();
+		shm_unlink(name.c_str());
+		throw BE::Error::StrategyError("Could not map queue: " + err);
+	}
+	this->_segment = static_cast<uint8_t*>(segment);
+
+	this->format(numSlots, maxMessageSize);
+}
+
+BiometricEvaluation::Process::SharedQueue::SharedQueue(
+    const std::string &name) :
+    _segment(nullptr),
+    _segmentSize(0),
+    _header(nullptr),
+    _name(name),
+    _creatorPID(0)
+{
+	int fd = shm_open(name.c_str(), O_RDWR, 0);
+	if (fd == -1) {
+		if (errno == ENOENT)
+			throw BE::Error::ObjectDoesNotExist();
+		throw BE::Error::StrategyError("Could not open queue: " +
+		    BE::Error::errorStr());
+	}
+	struct stat sb;
+	if (fstat(fd, &sb) != 0) {
+		const std::string err = BE::Error::errorStr();
+		close(fd);
+		throw BE::Error::StrategyError("Could not stat queue: " + err);
+	}
+	if (static_cast<uint64_t>(sb.st_size) < sizeof(Header)) {
+		close(fd);
+		throw BE::Error::StrategyError(name + " is not a queue");
+	}
+	this->_segmentSize = sb.st_size;
+	void *segment = mmap(nullptr, this->_segmentSize,
+	    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (segment == MAP_FAILED)
+		throw BE::Error::StrategyError("Could not map queue: " +
+		    BE::Error::errorStr());
+	this->_segment = static_cast<uint8_t*>(segment);
+	this->_header = reinterpret_cast<Header*>(this->_segment);
+
+	if ((this->_header->magic.load() != SHAREDQUEUEMAGIC) ||
+	    (segmentSize(this->_header->numSlots,
+	    this->_header->maxMessageSize) != this->_segmentSize)) {
+		munmap(this->_segment, this->_segmentSize);
+		throw BE::Error::StrategyError(name + " is not a queue");
+	}
+}
+
+BiometricEvaluation::Process::SharedQueue::~SharedQueue()
+{
+	munmap(this->_segment, this->_segmentSize);
+
+	/* As with Semaphore, only the creator removes the name */
+	if (!this->_name.empty() && (this->_creatorPID == getpid()))
+		shm_unlink(this->_name.c_str());
+}
+
+uint64_t
+BiometricEvaluation::Process::SharedQueue::segmentSize(
+    const uint32_t numSlots,
+    const uint64_t maxMessageSize)
+{
+	if ((numSlots == 0) || (maxMessageSize == 0))
+		throw BE::Error::ParameterError("Queue must have at least "
+		    "one slot of at least one byte");
+
+	const uint64_t stride = ((sizeof(Slot) + maxMessageSize +
+	    CACHELINESIZE - 1) / CACHELINESIZE) * CACHELINESIZE;
+	return (sizeof(Header) + (stride * numSlots));
+}
+
+void
+BiometricEvaluation::Process::SharedQueue::format(
+    const uint32_t numSlots,
+    const uint64_t maxMessageSize)
+{
+	this->_header = new (this->_segment) Header();
+	this->_header->numSlots = numSlots;
+	this->_header->maxMessageSize = maxMessageSize;
+	this->_header->slotStride = (this->_segmentSize - sizeof(Header)) /
+	    numSlots;
+	this->_header->enqueuePos.store(0);
+	this->_header->dequeuePos.store(0);
+	this->_header->spaceEvent.store(0);
+	this->_header->spaceWaiters.store(0);
+	this->_header->dataEvent.store(0);
+	this->_header->dataWaiters.store(0);
+
+	for (uint32_t i = 0; i < numSlots; i++) {
+		Slot *slot = new (this->_segment + sizeof(Header) +
+		    (i * this->_header->slotStride)) Slot();
+		slot->sequence.store(i);
+		slot->length = 0;
+	}
+
+	/* Publish the geometry to processes opening by name */
+	this->_header->magic.store(SHAREDQUEUEMAGIC);
+}
+
+BiometricEvaluation::Process::SharedQueue::Slot*
+BiometricEvaluation::Process::SharedQueue::slotAt(
+    const uint64_t pos)
+    const
+{
+	return (reinterpret_cast<Slot*>(this->_segment + sizeof(Header) +
+	    ((pos % this->_header->numSlots) * this->_header->slotStride)));
+}
+
+bool
+BiometricEvaluation::Process::SharedQueue::tryPush(
+    const uint8_t *message,
+    const uint64_t size)
+{
+	if (size > this->_header->maxMessageSize)
+		throw BE::Error::ParameterError("Message larger than "
+		    "maximum message size");
+
+	/* Claim the slot at the tail of the ring */
+	Slot *slot;
+	uint64_t pos = this->_header->enqueuePos.load(
+	    std::memory_order_relaxed);
+	while (true) {
+		slot = this->slotAt(pos);
+		const int64_t diff = static_cast<int64_t>(
+		    slot->sequence.load(std::memory_order_acquire) - pos);
+		if (diff == 0) {
+			if (this->_header->enqueuePos.compare_exchange_weak(
+			    pos, pos + 1, std::memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			/* Slot not yet consumed after a full lap */
+			return (false);
+		} else {
+			pos = this->_header->enqueuePos.load(
+			    std::memory_order_relaxed);
+		}
+	}
+
+	if (size != 0)
+		std::memcpy(reinterpret_cast<uint8_t*>(slot) + sizeof(Slot),
+		    message, size);
+	slot->length = size;
+	slot->sequence.store(pos + 1, std::memory_order_release);
+
+	signalEvent(this->_header->dataEvent, this->_header->dataWaiters);
+	return (true);
+}
+
+bool
+BiometricEvaluation::Process::SharedQueue::tryPop(
+    Memory::uint8Array &message)
+{
+	/* Claim the slot at the head of the ring */
+	Slot *slot;
+	uint64_t pos = this->_header->dequeuePos.load(
+	    std::memory_order_relaxed);
+	while (true) {
+		slot = this->slotAt(pos);
+		const int64_t diff = static_cast<int64_t>(
+		    slot->sequence.load(std::memory_order_acquire) - (pos + 1));
+		if (diff == 0) {
+			if (this->_header->dequeuePos.compare_exchange_weak(
+			    pos, pos + 1, std::memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			/* Slot not yet published */
+			return (false);
+		} else {
+			pos = this->_header->dequeuePos.load(
+			    std::memory_order_relaxed);
+		}
+	}
+
+	/* The slot must be released even when the copy fails */
+	try {
+		message.resize(slot->length);
+	} catch (BE::Error::MemoryError&) {
+		slot->sequence.store(pos + this->_header->numSlots,
+		    std::memory_order_release);
+		signalEvent(this->_header->spaceEvent,
+		    this->_header->spaceWaiters);
+		throw;
+	}
+	if (slot->length != 0)
+		std::memcpy(&message[0],
+		    reinterpret_cast<uint8_t*>(slot) + sizeof(Slot),
+		    slot->length);
+	slot->sequence.store(pos + this->_header->numSlots,
+	    std::memory_order_release);
+
+	signalEvent(this->_header->spaceEvent, this->_header->spaceWaiters);
+	return (true);
+}
+
+template<typename Attempt>
+bool
+BiometricEvaluation::Process::SharedQueue::blockingAttempt(
+    const bool producer,
+    Attempt attempt,
+    const bool timed,
+    const uint64_t interval,
+    const bool interruptible)
+{
+	std::atomic<uint32_t> &event = (producer ?
+	    this->_header->spaceEvent : this->_header->dataEvent);
+	std::atomic<uint32_t> &waiters = (producer ?
+	    this->_header->spaceWaiters : this->_header->dataWaiters);
+	const uint64_t deadline = (timed ?
+	    monotonicMicroseconds() + interval : 0);
+
+	while (true) {
+		if (attempt())
+			return (true);
+
+		/*
+		 * Sample the event counter before announcing ourselves and
+		 * retrying, so that any state change after the retry
+		 * changes the counter and the sleep returns immediately.
+		 */
+		const uint32_t observed = event.load();
+		waiters.fetch_add(1);
+		if (attempt()) {
+			waiters.fetch_sub(1);
+			return (true);
+		}
+
+		struct timespec remaining;
+		if (timed) {
+			const uint64_t now = monotonicMicroseconds();
+			if (now >= deadline) {
+				waiters.fetch_sub(1);
+				return (false);
+			}
+			remaining.tv_sec = (deadline - now) /
+			    BE::Time::MicrosecondsPerSecond;
+			remaining.tv_nsec = ((deadline - now) %
+			    BE::Time::MicrosecondsPerSecond) *
+			    BE::Time::NanosecondsPerMicrosecond;
+		}
+		const int rv = waitOnEvent(event, observed,
+		    timed ? &remaining : nullptr);
+		waiters.fetch_sub(1);
+
+		if (rv != 0) {
+			switch (errno) {
+			case EINTR:
+				if (interruptible)
+					return (false);
+				break;
+			case ETIMEDOUT:
+				return (attempt());
+			}
+		}
+	}
+}
+
+bool
+BiometricEvaluation::Process::SharedQueue::push(
+    const uint8_t *message,
+    const uint64_t size,
+    const bool interruptible)
+{
+	return (this->blockingAttempt(true, [&]() -> bool {
+	    return (this->tryPush(message, size)); }, false, 0,
+	    interruptible));
+}
+
+bool
+BiometricEvaluation::Process::SharedQueue::push(
+    const Memory::uint8Array &message,
+    const bool interruptible)
+{
+	return (this->push(message, message.size(), interruptible));
+}
+
+bool
+BiometricEvaluation::Process::SharedQueue::timedPush(
+    const uint8_t *message,
+    const uint64_t size,
+    const uint64_t interval,
+    const bool interruptible)
+{
+	return (this->blockingAttempt(true, [&]() -> bool {
+	    return (this->tryPush(message, size)); }, true, interval,
+	    interruptible));
+}
+
+bool
+BiometricEvaluation::Process::SharedQueue::pop(
+    Memory::uint8Array &message,
+    const bool interruptible)
+{
+	return (this->blockingAttempt(false, [&]() -> bool {
+	    return (this->tryPop(message)); }, false, 0, interruptible));
+}
+
+bool
+BiometricEvaluation::Process::SharedQueue::timedPop(
+    Memory::uint8Array &message,
+    const uint64_t interval,
+    const bool interruptible)
+{
+	return (this->blockingAttempt(false, [&]() -> bool {
+	    return (this->tryPop(message)); }, true, interval,
+	    interruptible));
+}
+
+uint32_t
+BiometricEvaluation::Process::SharedQueue::size()
+    const
+{
+	const uint64_t head = this->_header->dequeuePos.load();
+	const uint64_t tail = this->_header->enqueuePos.load();
+	if (tail <= head)
+		return (0);
+	return (std::min<uint64_t>(tail - head, this->_header->numSlots));
+}
+
+uint32_t
+BiometricEvaluation::Process::SharedQueue::capacity()
+    const
+{
+	return (this->_header->numSlots);
+}
+
+uint64_t
+BiometricEvaluation::Process::SharedQueue::maxMessageSize()
+    const
+{
+	return (this->_header->maxMessageSize);
+}
@@ -26,6 +26,7 @@
 #include <be_time.h>
 #include <be_process_statistics.h>
 #include <be_io_utility.h>
+#include <be_memory_accounting.h>
 
 namespace BE = BiometricEvaluation;
 
@@ -57,6 +58,8 @@ static const std::string LogsheetHeader =
     "Threads";
 static const std::string StartAutologComment = "Autolog started. Interval: ";
 static const std::string StopAutologComment = "Autolog stopped. ";
+static const std::string AllocationsComment = "Allocation columns follow "
+    "Threads, in bytes:";
 
 /*
  * Define a function to be used for Linux, to grab the OS statistics.
@@ -220,6 +223,7 @@ BiometricEvaluation::Process::Statistics::Statistics()
 	_logCabinet = nullptr;
 	_logging = false;
 	_autoLogging = false;
+	_loggingAllocations = false;
 	pthread_mutex_init(&_logMutex, nullptr);
 }
 
@@ -254,6 +258,7 @@ BiometricEvaluation::Process::Statistics::Statistics(
 	}
 	_logging = true;
 	_autoLogging = false;
+	_loggingAllocations = false;
 	pthread_mutex_init(&_logMutex, nullptr);
 	_logSheet->writeComment(LogsheetHeader);
 }
@@ -264,7 +269,8 @@ BiometricEvaluation::Process::Statistics::Statistics(
     _logCabinet(nullptr),
     _logSheet(logSheet),
     _logging(true),
-    _autoLogging(false)
+    _autoLogging(false),
+    _loggingAllocations(false)
 {
 	pthread_mutex_init(&_logMutex, nullptr);
 	_logSheet->writeComment(LogsheetHeader);
@@ -329,9 +335,22 @@ BiometricEvaluation::Process::Statistics::logStats()
 		pthread_mutex_unlock(&this->_logMutex);
 		throw;
 	}
+	const bool logAllocations = BE::Memory::isAccountingEnabled();
+	const auto allocations = BE::Memory::getAllocationCounters();
+	if (logAllocations && !_loggingAllocations) {
+		std::string comment = AllocationsComment;
+		for (const auto &tag : allocations)
+			comment += " " + std::string(to_string(tag.first));
+		_logSheet->writeComment(comment);
+		_loggingAllocations = true;
+	}
+
 	*_logSheet << usertime << " " << systemtime << " ";
 	*_logSheet << ps.vmrss << " " << ps.vmsize << " " << ps.vmpeak << " ";
 	*_logSheet << ps.vmdata << " " << ps.vmstack << " " << ps.threads;
+	if (logAllocations)
+		for (const auto &tag : allocations)
+			*_logSheet << " " << tag.second.current;
 	_logSheet->newEntry();
 
 	pthread_mutex_unlock(&this->_logMutex);
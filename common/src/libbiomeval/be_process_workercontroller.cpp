@@ -99,7 +99,7 @@ BiometricEvaluation::Process::WorkerController::getExitStatus()
 
 void
 BiometricEvaluation::Process::WorkerController::sendMessageToWorker(
-    const Memory::uint8Array &message)
+    const Memory::ByteView &message)
 {
 	uint64_t length = message.size();
 	sigset_t sigset;
@@ -118,7 +118,7 @@ BiometricEvaluation::Process::WorkerController::sendMessageToWorker(
 		throw (Error::StrategyError("Could not write message length: "
 		    + Error::errorStr()));
 	BEGIN_SIGNAL_BLOCK(&signalManager, pipe_write_message_block);
-		sz = write(pipeFD, message, length);
+		sz = write(pipeFD, message.data(), length);
 	END_SIGNAL_BLOCK(&signalManager, pipe_write_message_block);
 	if (signalManager.sigHandled())
 		throw Error::ObjectDoesNotExist("Widowed pipe");
@@ -375,7 +375,6 @@ void
 BiometricEvaluation::Video::StreamImpl::setFramePixelFormat(
     const Image::PixelFormat pixelFormat)
 {
-	this->_pixelFormat = pixelFormat;
 	switch (pixelFormat) {
 		case BE::Image::PixelFormat::MonoWhite:
 			this->_avPixelFormat = AV_PIX_FMT_MONOWHITE; break;
@@ -385,7 +384,13 @@ BiometricEvaluation::Video::StreamImpl::setFramePixelFormat(
 			this->_avPixelFormat = AV_PIX_FMT_GRAY8; break;
 		case BE::Image::PixelFormat::RGB24:
 			this->_avPixelFormat = AV_PIX_FMT_RGB24; break;
+		case BE::Image::PixelFormat::Gray16:
+			this->_avPixelFormat = AV_PIX_FMT_GRAY16; break;
+		case BE::Image::PixelFormat::Native:
+			throw BE::Error::ParameterError("Frames have no native "
+			    "pixel format");
 	}
+	this->_pixelFormat = pixelFormat;
 }
 
 BiometricEvaluation::Video::StreamImpl::~StreamImpl()
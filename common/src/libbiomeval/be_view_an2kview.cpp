@@ -8,12 +8,17 @@
  * about its quality, reliability, or any other characteristic.
  */
 
+#include <cstring>
+#include <map>
 #include <set>
 #include <type_traits>
 
+#include <pthread.h>
+
 #include <be_data_interchange_an2k.h>
 #include <be_finger_an2kminutiae_data_record.h>
 #include <be_io_utility.h>
+#include <be_memory_accounting.h>
 #include <be_view_an2kview.h>
 #include <be_memory_autobuffer.h>
 extern "C" {
@@ -78,30 +83,33 @@ BiometricEvaluation::View::AN2KView::AN2KView(
 		throw (Error::FileError("Could not open file."));
 
 	_an2k = Memory::AutoBuffer<ANSI_NIST>(&alloc_ANSI_NIST,
-		&free_ANSI_NIST, &copy_ANSI_NIST);
+		&freeAN2K, &copyAN2K);
 	if (read_ANSI_NIST(fp, _an2k) != 0) {
 		fclose(fp);
 		throw Error::FileError("Could not read AN2K file");
 	}
 	fclose(fp);
+	chargeAN2K(_an2k);
 	
 	readImageCommon(_an2k, typeID, recordNumber);
 	associateMinutiaeData(filename);
 }
 
 BiometricEvaluation::View::AN2KView::AN2KView(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     const RecordType typeID,
     const uint32_t recordNumber) :
 	_an2kRecord(nullptr)
 {
 	_an2k = Memory::AutoBuffer<ANSI_NIST>(&alloc_ANSI_NIST,
-		&free_ANSI_NIST, &copy_ANSI_NIST);
+		&freeAN2K, &copyAN2K);
 	
 	AN2KBDB bdb;
-	INIT_AN2KBDB(&bdb, buf, buf.size());
+	INIT_AN2KBDB(&bdb, const_cast<uint8_t *>(buf.data()),
+	    buf.size());
 	if (scan_ANSI_NIST(&bdb, _an2k) != 0)
 		throw Error::DataError("Could not read AN2K buffer");
+	chargeAN2K(_an2k);
 	readImageCommon(_an2k, typeID, recordNumber);
 	associateMinutiaeData(buf);
 }
@@ -206,6 +214,97 @@ BiometricEvaluation::View::AN2KView::getRecordType() const
 	return (this->_recordType);
 }
 
+/*
+ * Bytes charged for each ANSI_NIST tree, so that a tree is released from
+ * accounting only if it was charged, and by the amount that was charged.
+ */
+static std::map<const ANSI_NIST *, uint64_t> chargedTrees;
+static pthread_mutex_t chargedTreesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Bytes allocated by NBIS to hold an ANSI_NIST tree */
+static uint64_t
+sizeOfAN2K(
+    const ANSI_NIST *an2k)
+{
+	uint64_t size = sizeof(ANSI_NIST) + (an2k->alloc_records *
+	    sizeof(RECORD *));
+	for (int r = 0; r < an2k->num_records; r++) {
+		const RECORD *record = an2k->records[r];
+		size += sizeof(RECORD) + (record->alloc_fields *
+		    sizeof(FIELD *));
+		for (int f = 0; f < record->num_fields; f++) {
+			const FIELD *field = record->fields[f];
+			size += sizeof(FIELD) + (field->alloc_subfields *
+			    sizeof(SUBFIELD *));
+			if (field->id != nullptr)
+				size += std::strlen(field->id) + 1;
+			for (int sf = 0; sf < field->num_subfields; sf++) {
+				const SUBFIELD *subfield = field->subfields[sf];
+				size += sizeof(SUBFIELD) +
+				    (subfield->alloc_items * sizeof(ITEM *));
+				for (int i = 0; i < subfield->num_items; i++)
+					size += sizeof(ITEM) +
+					    subfield->items[i]->alloc_chars;
+			}
+		}
+	}
+	return (size);
+}
+
+void
+BiometricEvaluation::View::AN2KView::chargeAN2K(
+    const ANSI_NIST *an2k)
+{
+	if (an2k == nullptr)
+		return;
+
+	pthread_mutex_lock(&chargedTreesMutex);
+	const auto charged = chargedTrees.find(an2k);
+	if (charged != chargedTrees.end()) {
+		Memory::recordDeallocation(Memory::AllocationTag::AN2KTree,
+		    charged->second);
+		chargedTrees.erase(charged);
+	}
+	if (Memory::isAccountingEnabled()) {
+		const uint64_t size = sizeOfAN2K(an2k);
+		try {
+			chargedTrees[an2k] = size;
+			Memory::recordAllocation(
+			    Memory::AllocationTag::AN2KTree, size);
+		} catch (const std::bad_alloc &) {
+			/* Leave the tree unaccounted */
+		}
+	}
+	pthread_mutex_unlock(&chargedTreesMutex);
+}
+
+void
+BiometricEvaluation::View::AN2KView::freeAN2K(
+    ANSI_NIST *an2k)
+{
+	pthread_mutex_lock(&chargedTreesMutex);
+	const auto charged = chargedTrees.find(an2k);
+	if (charged != chargedTrees.end()) {
+		Memory::recordDeallocation(Memory::AllocationTag::AN2KTree,
+		    charged->second);
+		chargedTrees.erase(charged);
+	}
+	pthread_mutex_unlock(&chargedTreesMutex);
+
+	free_ANSI_NIST(an2k);
+}
+
+int
+BiometricEvaluation::View::AN2KView::copyAN2K(
+    ANSI_NIST **copy,
+    ANSI_NIST *an2k)
+{
+	const int rv = copy_ANSI_NIST(copy, an2k);
+	if (rv == 0)
+		chargeAN2K(*copy);
+	return (rv);
+}
+
 /******************************************************************************/
 /* Protected functions.                                                       */
 /******************************************************************************/
@@ -352,7 +451,7 @@ BiometricEvaluation::View::AN2KView::readImageCommon(
 
 void
 BiometricEvaluation::View::AN2KView::associateMinutiaeData(
-    Memory::uint8Array &buf)
+    const Memory::ByteView &buf)
 {
 	FIELD *field;
 	int idx;
@@ -29,7 +29,7 @@ BiometricEvaluation::View::AN2KViewVariableResolution::AN2KViewVariableResolutio
 }
 
 BiometricEvaluation::View::AN2KViewVariableResolution::AN2KViewVariableResolution(
-    Memory::uint8Array &buf,
+    const Memory::ByteView &buf,
     const RecordType typeID,
     const uint32_t recordNumber) :
     AN2KView(buf, typeID, recordNumber)
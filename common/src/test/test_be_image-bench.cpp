@@ -0,0 +1,581 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+/*
+ * Measure decoding throughput of each image codec.
+ *
+ * Every image of a corpus is probed, decoded, converted to grayscale,
+ * decoded in part, and decoded at a reduced resolution, and the
+ * throughput of each operation is written as JSON, for comparing
+ * library versions and codec backends. The corpus is the images of
+ * test_data/ImageRS and of any other RecordStores named, plus
+ * generated images of several sizes and depths in each format
+ * Image::Encoder writes, BMP, and NetPBM.
+ *
+ * Throughput is in megapixels of the image per second, or of the
+ * rectangle for partial decodes, using the median of several timed
+ * rounds.
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <be_error_exception.h>
+#include <be_framework.h>
+#include <be_image_encoder.h>
+#include <be_image_image.h>
+#include <be_image_raw.h>
+#include <be_io_recordstore.h>
+#include <be_time_timer.h>
+
+using namespace BiometricEvaluation;
+using namespace std;
+
+static const string DefaultRecordStore = "test_data/ImageRS";
+
+/** An encoded image to measure */
+struct Sample
+{
+	/** Key or description */
+	string name;
+	/** Codec label, distinguishing lossless JPEG 2000 */
+	string codec;
+	/** Encoded image */
+	Memory::uint8Array data;
+};
+
+/** Throughput of one operation on one image */
+struct Result
+{
+	const Sample *sample;
+	Image::Properties properties;
+	string operation;
+	/** Megapixels produced by one iteration */
+	double megapixels;
+	uint64_t iterations;
+	double secondsPerIteration;
+	/** Set if the operation failed */
+	string error;
+};
+
+static string
+codecName(
+    Image::CompressionAlgorithm compressionAlgorithm)
+{
+	if (compressionAlgorithm == Image::CompressionAlgorithm::JP2L)
+		return ("JP2L");
+	return (to_string(compressionAlgorithm));
+}
+
+/* Add the encoded images of a RecordStore, skipping raw data */
+static void
+addRecordStore(
+    const string &pathname,
+    vector<Sample> &samples)
+{
+	const auto rs = IO::RecordStore::openRecordStore(pathname,
+	    IO::Mode::ReadOnly);
+	for (;;) {
+		IO::RecordStore::Record record;
+		try {
+			record = rs->sequence();
+		} catch (const Error::ObjectDoesNotExist&) {
+			break;
+		}
+		if ((record.key.length() >= 4) && (record.key.compare(
+		    record.key.length() - 4, 4, ".raw") == 0))
+			continue;
+
+		Image::CompressionAlgorithm compressionAlgorithm;
+		try {
+			compressionAlgorithm = Image::Image::probe(
+			    record.data).compressionAlgorithm;
+		} catch (const Error::Exception &e) {
+			cerr << record.key << ": " << e.whatString() << endl;
+			continue;
+		}
+		/* JPEG 2000 headers do not say whether coding was lossless */
+		if ((compressionAlgorithm == Image::CompressionAlgorithm::JP2) &&
+		    (record.key.find(".jp2l") != string::npos))
+			compressionAlgorithm = Image::CompressionAlgorithm::JP2L;
+
+		samples.push_back({pathname + "/" + record.key,
+		    codecName(compressionAlgorithm), record.data});
+	}
+}
+
+/* Fingerprint-like ridges, with componentsPerPixel samples per pixel */
+static Memory::uint8Array
+makePixels(
+    const Image::Size &dimensions,
+    uint32_t componentsPerPixel,
+    uint16_t bitDepth)
+{
+	const uint32_t maximum = (1u << bitDepth) - 1;
+	const uint32_t bytes = bitDepth / 8;
+	Memory::uint8Array pixels;
+	pixels.resize_uninitialized(static_cast<uint64_t>(dimensions.xSize) *
+	    dimensions.ySize * componentsPerPixel * bytes);
+	uint64_t offset = 0;
+	for (uint32_t y = 0; y < dimensions.ySize; y++) {
+		for (uint32_t x = 0; x < dimensions.xSize; x++) {
+			const double r = sqrt(((x - (dimensions.xSize / 2.0)) *
+			    (x - (dimensions.xSize / 2.0))) + ((y -
+			    (dimensions.ySize / 3.0)) * (y -
+			    (dimensions.ySize / 3.0))));
+			for (uint32_t c = 0; c < componentsPerPixel; c++) {
+				double value = 0.5 + (0.4 * sin((r / 1.6) +
+				    c));
+				/* A border gives WSQ a strong edge */
+				if (x < (dimensions.xSize / 16))
+					value = 1.0;
+				const uint16_t sample = static_cast<uint16_t>(
+				    value * maximum);
+				if (bytes == 1)
+					pixels[offset] = static_cast<uint8_t>(
+					    sample);
+				else
+					memcpy(&pixels[offset], &sample, 2);
+				offset += bytes;
+			}
+		}
+	}
+	return (pixels);
+}
+
+/* A binary PGM or PPM of raw pixels */
+static Memory::uint8Array
+makeNetPBM(
+    const Memory::uint8Array &pixels,
+    const Image::Size &dimensions,
+    uint32_t componentsPerPixel,
+    uint16_t bitDepth)
+{
+	const string header = string(componentsPerPixel == 1 ? "P5" : "P6") +
+	    "\n" + to_string(dimensions.xSize) + " " +
+	    to_string(dimensions.ySize) + "\n" +
+	    to_string((1u << bitDepth) - 1) + "\n";
+	Memory::uint8Array data;
+	data.append(reinterpret_cast<const uint8_t*>(header.data()),
+	    header.size());
+	const uint64_t start = data.size();
+	data.append(pixels, pixels.size());
+	/* NetPBM samples are big-endian */
+	if (bitDepth == 16)
+		for (uint64_t i = start; i + 1 < data.size(); i += 2)
+			swap(data[i], data[i + 1]);
+	return (data);
+}
+
+/* Append a little-endian value */
+static void
+appendLE(
+    Memory::uint8Array &data,
+    uint32_t value,
+    uint8_t bytes)
+{
+	for (uint8_t i = 0; i < bytes; i++)
+		data.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+/* A bottom-up 24-bit BMP of RGB pixels */
+static Memory::uint8Array
+makeBMP(
+    const Memory::uint8Array &pixels,
+    const Image::Size &dimensions)
+{
+	const uint32_t rowSize = ((dimensions.xSize * 3) + 3) & ~3u;
+	const uint32_t imageSize = rowSize * dimensions.ySize;
+	Memory::uint8Array data;
+	data.push_back('B');
+	data.push_back('M');
+	appendLE(data, 54 + imageSize, 4);
+	appendLE(data, 0, 4);
+	appendLE(data, 54, 4);
+	appendLE(data, 40, 4);
+	appendLE(data, dimensions.xSize, 4);
+	appendLE(data, dimensions.ySize, 4);
+	appendLE(data, 1, 2);
+	appendLE(data, 24, 2);
+	appendLE(data, 0, 4);
+	appendLE(data, imageSize, 4);
+	appendLE(data, 19685, 4);	/* 500 ppi */
+	appendLE(data, 19685, 4);
+	appendLE(data, 0, 4);
+	appendLE(data, 0, 4);
+
+	for (uint32_t y = dimensions.ySize; y > 0; y--) {
+		const uint8_t *row = pixels + (static_cast<uint64_t>(y - 1) *
+		    dimensions.xSize * 3);
+		for (uint32_t x = 0; x < dimensions.xSize; x++) {
+			data.push_back(row[(x * 3) + 2]);
+			data.push_back(row[(x * 3) + 1]);
+			data.push_back(row[x * 3]);
+		}
+		for (uint32_t pad = dimensions.xSize * 3; pad < rowSize; pad++)
+			data.push_back(0);
+	}
+	return (data);
+}
+
+/* Add generated images of several sizes and depths in every format */
+static void
+addGenerated(
+    vector<Sample> &samples)
+{
+	/* Rolled finger, slap, and palm at 500 ppi */
+	const Image::Size sizes[] = {Image::Size(800, 750),
+	    Image::Size(1600, 1500), Image::Size(2000, 2500)};
+	const struct {
+		uint32_t componentsPerPixel;
+		uint16_t bitDepth;
+		vector<Image::CompressionAlgorithm> codecs;
+	} formats[] = {
+	    {1, 8, {Image::CompressionAlgorithm::WSQ20,
+	        Image::CompressionAlgorithm::JPEGB,
+	        Image::CompressionAlgorithm::JP2,
+	        Image::CompressionAlgorithm::JP2L,
+	        Image::CompressionAlgorithm::PNG}},
+	    {1, 16, {Image::CompressionAlgorithm::JP2L,
+	        Image::CompressionAlgorithm::PNG}},
+	    {3, 8, {Image::CompressionAlgorithm::JPEGB,
+	        Image::CompressionAlgorithm::JP2,
+	        Image::CompressionAlgorithm::JP2L,
+	        Image::CompressionAlgorithm::PNG}}
+	};
+
+	for (const auto &size : sizes) {
+		for (const auto &format : formats) {
+			const uint32_t colorDepth = format.componentsPerPixel *
+			    format.bitDepth;
+			const Memory::uint8Array pixels = makePixels(size,
+			    format.componentsPerPixel, format.bitDepth);
+			const string description = to_string(size.xSize) + "x" +
+			    to_string(size.ySize) + "x" + to_string(colorDepth);
+
+			const Image::Raw raw(pixels, size, colorDepth,
+			    format.bitDepth, Image::Resolution(500, 500,
+			    Image::Resolution::Units::PPI), false);
+			for (const auto codec : format.codecs) {
+				try {
+					samples.push_back({description,
+					    codecName(codec),
+					    Image::Encoder::openEncoder(
+					    codec)->encode(raw)});
+				} catch (const Error::Exception &e) {
+					cerr << "Encoding " << description <<
+					    " as " << codecName(codec) << ": " <<
+					    e.whatString() << endl;
+				}
+			}
+			samples.push_back({description, codecName(
+			    Image::CompressionAlgorithm::NetPBM),
+			    makeNetPBM(pixels, size, format.componentsPerPixel,
+			    format.bitDepth)});
+			if ((format.componentsPerPixel == 3) &&
+			    (format.bitDepth == 8))
+				samples.push_back({description, codecName(
+				    Image::CompressionAlgorithm::BMP),
+				    makeBMP(pixels, size)});
+		}
+	}
+}
+
+/**
+ * @brief
+ * Time a function.
+ * @details
+ * Iterations are doubled until a round takes at least 10 ms, then
+ * enough rounds are run to take about minimumSeconds.
+ *
+ * @return
+ *	Median seconds per call.
+ */
+static double
+timeFunction(
+    const function<void()> &fn,
+    double minimumSeconds,
+    uint64_t &iterations)
+{
+	/* Warm caches and lazily initialized libraries */
+	fn();
+
+	Time::Timer timer;
+	auto round = [&](uint64_t count) {
+		timer.time([&]() {
+			for (uint64_t i = 0; i < count; i++)
+				fn();
+		});
+		return (timer.elapsed());
+	};
+
+	iterations = 1;
+	uint64_t elapsed;
+	while (((elapsed = round(iterations)) < 10000) &&
+	    (iterations < (1u << 24)))
+		iterations *= 2;
+
+	const uint64_t rounds = min<uint64_t>(max<uint64_t>(3,
+	    static_cast<uint64_t>((minimumSeconds * 1e6) / max<uint64_t>(
+	    elapsed, 1))), 15);
+	vector<double> times{static_cast<double>(elapsed)};
+	for (uint64_t i = 1; i < rounds; i++)
+		times.push_back(round(iterations));
+	sort(times.begin(), times.end());
+
+	const uint64_t totalIterations = iterations * rounds;
+	const double median = times[times.size() / 2] / 1e6 / iterations;
+	iterations = totalIterations;
+	return (median);
+}
+
+/* Measure each operation on one image */
+static void
+measure(
+    const Sample &sample,
+    double minimumSeconds,
+    vector<Result> &results)
+{
+	const Memory::ByteView data(sample.data);
+	Image::Properties properties;
+	try {
+		properties = Image::Image::probe(data);
+	} catch (const Error::Exception &e) {
+		cerr << sample.name << ": " << e.whatString() << endl;
+		return;
+	}
+	const Image::Size dimensions = properties.dimensions;
+	const double megapixels = (static_cast<double>(dimensions.xSize) *
+	    dimensions.ySize) / 1e6;
+	const Image::Coordinate origin(dimensions.xSize / 4,
+	    dimensions.ySize / 4);
+	const Image::Size region(max<uint32_t>(dimensions.xSize / 2, 1),
+	    max<uint32_t>(dimensions.ySize / 2, 1));
+
+	const struct {
+		string operation;
+		double megapixels;
+		function<void()> fn;
+	} operations[] = {
+	    {"probe", megapixels, [&]() {
+		Image::Image::probe(data);
+	    }},
+	    {"getRawData", megapixels, [&]() {
+		Image::Image::openImage(data)->getRawData();
+	    }},
+	    {"getRawGrayscaleData", megapixels, [&]() {
+		Image::Image::openImage(data)->getRawGrayscaleData(8);
+	    }},
+	    {"getRawData(region)", (static_cast<double>(region.xSize) *
+		region.ySize) / 1e6, [&]() {
+		Image::Image::openImage(data)->getRawData(origin, region);
+	    }},
+	    {"getReducedRawData(2)", megapixels, [&]() {
+		Image::Image::openImage(data)->getReducedRawData(2);
+	    }}
+	};
+
+	for (const auto &op : operations) {
+		Result result{&sample, properties, op.operation, op.megapixels,
+		    0, 0, ""};
+		try {
+			result.secondsPerIteration = timeFunction(op.fn,
+			    minimumSeconds, result.iterations);
+		} catch (const Error::Exception &e) {
+			result.error = e.whatString();
+		}
+		results.push_back(result);
+	}
+}
+
+static string
+quote(
+    const string &s)
+{
+	ostringstream out;
+	out << '"';
+	for (const char c : s) {
+		switch (c) {
+		case '"':
+			out << "\\\"";
+			break;
+		case '\\':
+			out << "\\\\";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20)
+				out << "\\u" << hex << setw(4) << setfill('0')
+				    << static_cast<int>(c) << dec;
+			else
+				out << c;
+			break;
+		}
+	}
+	out << '"';
+	return (out.str());
+}
+
+static void
+writeJSON(
+    ostream &out,
+    const string &label,
+    double minimumSeconds,
+    const vector<Result> &results)
+{
+	out << setprecision(6);
+	out << "{\n";
+	out << "  \"framework\": " << quote(to_string(
+	    Framework::getMajorVersion()) + "." + to_string(
+	    Framework::getMinorVersion())) << ",\n";
+	out << "  \"compiler\": " << quote(Framework::getCompiler() + " " +
+	    Framework::getCompilerVersion()) << ",\n";
+	out << "  \"label\": " << quote(label) << ",\n";
+	out << "  \"minimumSeconds\": " << minimumSeconds << ",\n";
+
+	out << "  \"results\": [";
+	/* Totals per codec and operation, for the summary */
+	map<pair<string, string>, pair<double, double>> totals;
+	for (uint64_t i = 0; i < results.size(); i++) {
+		const Result &r = results[i];
+		out << (i == 0 ? "\n" : ",\n") << "    {\"image\": " <<
+		    quote(r.sample->name) << ", \"codec\": " <<
+		    quote(r.sample->codec) << ", \"width\": " <<
+		    r.properties.dimensions.xSize << ", \"height\": " <<
+		    r.properties.dimensions.ySize << ", \"colorDepth\": " <<
+		    r.properties.colorDepth << ", \"bitDepth\": " <<
+		    r.properties.bitDepth << ", \"bytes\": " <<
+		    r.sample->data.size() << ", \"operation\": " <<
+		    quote(r.operation);
+		if (!r.error.empty()) {
+			out << ", \"error\": " << quote(r.error) << "}";
+			continue;
+		}
+		out << ", \"iterations\": " << r.iterations <<
+		    ", \"secondsPerIteration\": " << r.secondsPerIteration <<
+		    ", \"megapixelsPerSecond\": " << (r.megapixels /
+		    r.secondsPerIteration) << "}";
+
+		auto &total = totals[make_pair(r.sample->codec, r.operation)];
+		total.first += r.megapixels;
+		total.second += r.secondsPerIteration;
+	}
+	out << "\n  ],\n";
+
+	out << "  \"summary\": [";
+	bool first = true;
+	for (const auto &total : totals) {
+		out << (first ? "\n" : ",\n") << "    {\"codec\": " <<
+		    quote(total.first.first) << ", \"operation\": " <<
+		    quote(total.first.second) << ", \"megapixelsPerSecond\": " <<
+		    (total.second.first / total.second.second) << "}";
+		first = false;
+	}
+	out << "\n  ]\n}\n";
+}
+
+static void
+usage(
+    const char *name)
+{
+	cerr << "Usage: " << name << " [-r recordstore]... [-c] [-g] "
+	    "[-t seconds] [-l label] [-o output]" << endl;
+	cerr << "\t-r\tAlso measure the images of recordstore" << endl;
+	cerr << "\t-c\tSkip " << DefaultRecordStore << endl;
+	cerr << "\t-g\tSkip generated images" << endl;
+	cerr << "\t-t\tApproximate seconds to time each operation "
+	    "(default 0.25)" << endl;
+	cerr << "\t-l\tLabel for this run, such as the codec libraries "
+	    "used" << endl;
+	cerr << "\t-o\tWrite JSON to output instead of stdout" << endl;
+}
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	vector<string> recordStores;
+	bool useDefault = true, useGenerated = true;
+	double minimumSeconds = 0.25;
+	string label, output;
+
+	int c;
+	while ((c = getopt(argc, argv, "r:cgt:l:o:")) != -1) {
+		switch (c) {
+		case 'r':
+			recordStores.push_back(optarg);
+			break;
+		case 'c':
+			useDefault = false;
+			break;
+		case 'g':
+			useGenerated = false;
+			break;
+		case 't':
+			minimumSeconds = atof(optarg);
+			break;
+		case 'l':
+			label = optarg;
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return (EXIT_FAILURE);
+		}
+	}
+	if (useDefault)
+		recordStores.insert(recordStores.begin(), DefaultRecordStore);
+
+	vector<Sample> samples;
+	for (const auto &rs : recordStores) {
+		try {
+			addRecordStore(rs, samples);
+		} catch (const Error::Exception &e) {
+			cerr << "Could not read " << rs << ": " <<
+			    e.whatString() << endl;
+			return (EXIT_FAILURE);
+		}
+	}
+	if (useGenerated)
+		addGenerated(samples);
+
+	vector<Result> results;
+	for (const auto &sample : samples) {
+		cerr << sample.codec << " " << sample.name << endl;
+		measure(sample, minimumSeconds, results);
+	}
+
+	if (output.empty()) {
+		writeJSON(cout, label, minimumSeconds, results);
+	} else {
+		ofstream out(output);
+		writeJSON(out, label, minimumSeconds, results);
+		if (!out) {
+			cerr << "Could not write " << output << endl;
+			return (EXIT_FAILURE);
+		}
+	}
+
+	return (EXIT_SUCCESS);
+}
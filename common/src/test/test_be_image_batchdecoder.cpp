@@ -0,0 +1,269 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <be_image_batchdecoder.h>
+#include <be_image_image.h>
+#include <be_io_recordstore.h>
+#include <be_io_utility.h>
+
+using namespace BiometricEvaluation;
+using namespace std;
+
+/* A binary grayscale NetPBM image whose pixels depend on seed */
+static vector<uint8_t>
+makeImage(
+    uint32_t seed)
+{
+	const uint32_t width = 16 + (seed % 37), height = 8 + (seed % 23);
+	const string header = "P5\n" + to_string(width) + " " +
+	    to_string(height) + "\n255\n";
+
+	vector<uint8_t> image(header.begin(), header.end());
+	for (uint32_t y = 0; y < height; y++)
+		for (uint32_t x = 0; x < width; x++)
+			image.push_back(static_cast<uint8_t>(x * 7 + y * 3 +
+			    seed));
+	return (image);
+}
+
+/* Decode every image with d and compare against sequential decoding */
+static bool
+checkOrder(
+    const vector<vector<uint8_t>> &images,
+    Image::BatchDecoder::Order order,
+    uint8_t scaleDenominator)
+{
+	Image::BatchDecoder decoder(4, 3, order, scaleDenominator);
+	for (const auto &image : images)
+		decoder.add(Memory::ByteView(image.data(), image.size()));
+	/* Not a supported format */
+	const vector<uint8_t> junk(64, 0x55);
+	const uint64_t junkIndex = decoder.add(Memory::ByteView(junk.data(),
+	    junk.size()));
+	decoder.close();
+
+	vector<bool> seen(images.size() + 1, false);
+	uint64_t expectedIndex = 0;
+	Image::BatchDecoder::Result result;
+	while (decoder.next(result)) {
+		if (result.index >= seen.size() || seen[result.index])
+			return (false);
+		seen[result.index] = true;
+		if ((order == Image::BatchDecoder::Order::Submission) &&
+		    (result.index != expectedIndex++))
+			return (false);
+
+		if (result.index == junkIndex) {
+			if (result.error == nullptr)
+				return (false);
+			continue;
+		}
+		if (result.error != nullptr)
+			return (false);
+
+		const auto &data = images[result.index];
+		const auto image = Image::Image::openImage(data.data(),
+		    data.size());
+		const Memory::uint8Array expected = (scaleDenominator == 1 ?
+		    image->getRawData() :
+		    image->getReducedRawData(scaleDenominator));
+		if (result.rawData != expected)
+			return (false);
+		if (result.properties.dimensions != image->getDimensions())
+			return (false);
+	}
+
+	for (const bool s : seen)
+		if (!s)
+			return (false);
+	return (true);
+}
+
+/* Every result of decoder must be expected[result.index] */
+static bool
+checkResults(
+    Image::BatchDecoder &decoder,
+    const vector<Memory::uint8Array> &expected)
+{
+	decoder.close();
+
+	vector<bool> seen(expected.size(), false);
+	Image::BatchDecoder::Result result;
+	while (decoder.next(result)) {
+		if ((result.index >= seen.size()) || seen[result.index] ||
+		    (result.error != nullptr) ||
+		    (result.rawData != expected[result.index]))
+			return (false);
+		seen[result.index] = true;
+	}
+
+	for (const bool s : seen)
+		if (!s)
+			return (false);
+	return (true);
+}
+
+/* Decode data on this thread */
+static Memory::uint8Array
+decodeSerially(
+    const Memory::uint8Array &data)
+{
+	return (Image::Image::openImage(data)->getRawData());
+}
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	bool success = true;
+
+	vector<vector<uint8_t>> images;
+	for (uint32_t i = 0; i < 100; i++)
+		images.push_back(makeImage(i));
+
+	cout << "Submission order matches sequential decoding: ";
+	if (checkOrder(images, Image::BatchDecoder::Order::Submission, 1))
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Completion order returns every image: ";
+	if (checkOrder(images, Image::BatchDecoder::Order::Completion, 1))
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Reduced resolution matches sequential decoding: ";
+	if (checkOrder(images, Image::BatchDecoder::Order::Submission, 4))
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	/*
+	 * The NBIS WSQ and Lossless JPEG decoders keep tables in
+	 * per-thread globals, so decode many of each at once.
+	 */
+	const string WSQPath = "test_data/img.wsq";
+	shared_ptr<IO::RecordStore> imageRS;
+	vector<string> keys;
+	vector<Memory::uint8Array> records;
+	try {
+		imageRS = IO::RecordStore::openRecordStore("test_data/ImageRS",
+		    IO::Mode::ReadOnly);
+		for (;;) {
+			IO::RecordStore::Record record;
+			try {
+				record = imageRS->sequence();
+			} catch (const Error::ObjectDoesNotExist&) {
+				break;
+			}
+			const string extension = record.key.substr(
+			    record.key.find_last_of('.') + 1);
+			if ((extension == "wsq") || (extension == "jpl")) {
+				keys.push_back(record.key);
+				records.push_back(record.data);
+			}
+		}
+		records.push_back(IO::Utility::readFile(WSQPath));
+	} catch (const Error::Exception &e) {
+		cout << "Could not read test images: " << e.whatString() <<
+		    endl;
+		return (EXIT_FAILURE);
+	}
+
+	cout << "Concurrent WSQ and JPEGL decoding matches serial decoding: ";
+	try {
+		Image::BatchDecoder decoder(4, 16,
+		    Image::BatchDecoder::Order::Completion);
+		vector<Memory::uint8Array> expected;
+		for (const auto &record : records) {
+			const Memory::uint8Array raw = decodeSerially(record);
+			for (uint32_t copy = 0; copy < 8; copy++) {
+				decoder.add(record);
+				expected.push_back(raw);
+			}
+		}
+		if ((keys.size() >= 2) && checkResults(decoder, expected))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "RecordStore and file sources match serial decoding: ";
+	try {
+		Image::BatchDecoder decoder(4);
+		vector<Memory::uint8Array> expected;
+		for (uint64_t i = 0; i < keys.size(); i++) {
+			decoder.add(imageRS, keys[i]);
+			expected.push_back(decodeSerially(records[i]));
+		}
+		decoder.add(WSQPath);
+		expected.push_back(decodeSerially(records.back()));
+		if (checkResults(decoder, expected))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Images are not added after close(): ";
+	try {
+		Image::BatchDecoder decoder(1);
+		decoder.close();
+		decoder.add(Memory::ByteView(images[0].data(),
+		    images[0].size()));
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::StrategyError&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Invalid scale denominators are rejected: ";
+	try {
+		Image::BatchDecoder decoder(1, 0,
+		    Image::BatchDecoder::Order::Submission, 3);
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::ParameterError&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Destruction abandons queued images: ";
+	{
+		Image::BatchDecoder decoder(2, 1);
+		for (const auto &image : images)
+			decoder.add(Memory::ByteView(image.data(),
+			    image.size()));
+	}
+	cout << "success." << endl;
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,243 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <be_image_conversion.h>
+
+using namespace BiometricEvaluation;
+using namespace std;
+
+using Instructions = Image::Conversion::Instructions;
+
+/** Kernels under test */
+enum class Kernel
+{
+	ColorToGray8,
+	ColorToGray16,
+	Color16ToGray8,
+	Color16ToGray16,
+	Rescale8To16,
+	Rescale16To8,
+	Threshold,
+	RemoveAlpha8,
+	RemoveAlpha16
+};
+
+/* Run a kernel with the given instructions */
+static vector<uint8_t>
+run(
+    Instructions instructions,
+    Kernel kernel,
+    const vector<uint8_t> &in,
+    uint64_t pixels,
+    uint8_t channels)
+{
+	Image::Conversion::setInstructions(instructions);
+
+	vector<uint8_t> out;
+	const vector<bool> alpha{false, false, false, true};
+	switch (kernel) {
+	case Kernel::ColorToGray8:
+		out.resize(pixels);
+		Image::Conversion::colorToGray8(in.data(), out.data(), pixels,
+		    channels);
+		break;
+	case Kernel::ColorToGray16:
+		out.resize(pixels * 2);
+		Image::Conversion::colorToGray16(in.data(), out.data(), pixels,
+		    channels);
+		break;
+	case Kernel::Color16ToGray8:
+		out.resize(pixels);
+		Image::Conversion::color16ToGray8(in.data(), out.data(), pixels,
+		    channels);
+		break;
+	case Kernel::Color16ToGray16:
+		out.resize(pixels * 2);
+		Image::Conversion::color16ToGray16(in.data(), out.data(),
+		    pixels, channels);
+		break;
+	case Kernel::Rescale8To16:
+		out.resize(pixels * 2);
+		Image::Conversion::rescale8To16(in.data(), out.data(), pixels);
+		break;
+	case Kernel::Rescale16To8:
+		out.resize(pixels);
+		Image::Conversion::rescale16To8(in.data(), out.data(), pixels);
+		break;
+	case Kernel::Threshold:
+		out.assign(in.begin(), in.begin() + pixels);
+		Image::Conversion::threshold(out.data(), pixels);
+		break;
+	case Kernel::RemoveAlpha8:
+		out.resize(pixels * 3);
+		Image::Conversion::removeComponents(in.data(), out.data(),
+		    pixels, 1, alpha);
+		break;
+	case Kernel::RemoveAlpha16:
+		out.resize(pixels * 6);
+		Image::Conversion::removeComponents(in.data(), out.data(),
+		    pixels, 2, alpha);
+		break;
+	}
+	return (out);
+}
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	bool success = true;
+	const Instructions supported =
+	    Image::Conversion::getSupportedInstructions();
+	cout << "Supported instructions: " << to_string(supported) << endl;
+
+	cout << "Vector kernels match the portable kernels: ";
+	mt19937 generator(1);
+	uniform_int_distribution<uint16_t> byte(0, UINT8_MAX);
+	bool matched = true;
+	for (uint64_t pixels : {0, 1, 3, 4, 5, 8, 15, 16, 17, 33, 100, 1001}) {
+		for (uint8_t channels : {3, 4}) {
+			/* Enough for four 16-bit channels */
+			vector<uint8_t> in(pixels * 8);
+			for (auto &sample : in)
+				sample = byte(generator);
+
+			for (uint8_t k = 0; k <= to_int_type(
+			    Kernel::RemoveAlpha16); k++) {
+				const Kernel kernel = static_cast<Kernel>(k);
+				const vector<uint8_t> expected = run(
+				    Instructions::Scalar, kernel, in, pixels,
+				    channels);
+				for (Instructions i : {Instructions::SSE41,
+				    Instructions::AVX2}) {
+					if (run(i, kernel, in, pixels,
+					    channels) == expected)
+						continue;
+					matched = false;
+					cout << endl << "\tKernel " << k <<
+					    ", " << pixels << " pixels, " <<
+					    static_cast<int>(channels) <<
+					    " channels, " << to_string(
+					    Image::Conversion::getInstructions())
+					    << " differs";
+				}
+			}
+		}
+	}
+	if (matched)
+		cout << "success." << endl;
+	else {
+		cout << endl << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Plane interleaving matches the portable kernel: ";
+	uniform_int_distribution<int32_t> sample(-70000, 70000);
+	bool interleaved = true;
+	for (uint64_t pixels : {0, 1, 2, 3, 4, 5, 7, 8, 9, 31, 1001}) {
+		vector<vector<int32_t>> planes(4, vector<int32_t>(pixels));
+		for (auto &plane : planes)
+			for (auto &value : plane)
+				value = sample(generator);
+		const int32_t *const pointers[4]{planes[0].data(),
+		    planes[1].data(), planes[2].data(), planes[3].data()};
+
+		for (uint8_t planeCount = 1; planeCount <= 4; planeCount++) {
+			for (uint8_t sampleSize : {1, 2}) {
+				const uint32_t mask = (sampleSize == 1 ?
+				    0xFF : 0x0FFF);
+				vector<uint8_t> expected(pixels * planeCount *
+				    sampleSize);
+				Image::Conversion::setInstructions(
+				    Instructions::Scalar);
+				Image::Conversion::interleave(pointers,
+				    planeCount, expected.data(), pixels,
+				    sampleSize, mask);
+				for (Instructions i : {Instructions::SSE41,
+				    Instructions::AVX2}) {
+					vector<uint8_t> out(expected.size());
+					Image::Conversion::setInstructions(i);
+					Image::Conversion::interleave(pointers,
+					    planeCount, out.data(), pixels,
+					    sampleSize, mask);
+					if (out != expected)
+						interleaved = false;
+				}
+			}
+		}
+	}
+	/* The portable kernel against a known pixel */
+	const int32_t red = 0x1FF, green = 0x0102, blue = -1;
+	const int32_t *const rgb[3]{&red, &green, &blue};
+	uint8_t pixel16[6];
+	Image::Conversion::interleave(rgb, 3, pixel16, 1, 2, 0x3FF);
+	uint16_t unpacked[3];
+	memcpy(unpacked, pixel16, sizeof(unpacked));
+	if ((unpacked[0] != 0x1FF) || (unpacked[1] != 0x102) ||
+	    (unpacked[2] != 0x3FF))
+		interleaved = false;
+	if (interleaved)
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "16-bit to 8-bit rescaling is exact for every value: ";
+	vector<uint8_t> every(65536 * 2);
+	for (uint32_t v = 0; v <= UINT16_MAX; v++) {
+		const uint16_t sample = static_cast<uint16_t>(v);
+		memcpy(&every[v * 2], &sample, sizeof(sample));
+	}
+	bool exact = true;
+	for (Instructions i : {Instructions::Scalar, Instructions::SSE41,
+	    Instructions::AVX2}) {
+		const vector<uint8_t> out = run(i, Kernel::Rescale16To8, every,
+		    65536, 1);
+		for (uint32_t v = 0; v <= UINT16_MAX; v++)
+			if (out[v] != (v * UINT8_MAX) / UINT16_MAX)
+				exact = false;
+	}
+	if (exact)
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Unsupported instructions are lowered: ";
+	if (to_int_type(Image::Conversion::setInstructions(
+	    Instructions::AVX2)) <= to_int_type(supported))
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+	Image::Conversion::setInstructions(supported);
+
+	cout << "Invalid channel counts are rejected: ";
+	uint8_t pixel[8]{}, gray[2]{};
+	try {
+		Image::Conversion::colorToGray8(pixel, gray, 1, 2);
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::ParameterError&) {
+		cout << "success." << endl;
+	}
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
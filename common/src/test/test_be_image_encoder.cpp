@@ -0,0 +1,274 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <be_error_exception.h>
+#include <be_image_encoder.h>
+#include <be_image_raw.h>
+#include <be_io_recordstore.h>
+
+using namespace BiometricEvaluation;
+using namespace std;
+
+/*
+ * A raw image with smooth content and one strong edge, which lossy
+ * coders reproduce closely.
+ */
+static shared_ptr<Image::Raw>
+makeImage(
+    uint32_t width,
+    uint32_t height,
+    uint32_t colorDepth,
+    uint16_t bitDepth,
+    bool hasAlphaChannel,
+    uint32_t seed = 0)
+{
+	const uint32_t components = colorDepth / bitDepth;
+	const uint32_t bytes = bitDepth / 8;
+	const uint32_t maximum = (1u << bitDepth) - 1;
+	Memory::uint8Array data(static_cast<uint64_t>(width) * height *
+	    components * bytes);
+	uint64_t offset = 0;
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			for (uint32_t c = 0; c < components; c++) {
+				double value = 0.5 + 0.35 * sin((x + seed) *
+				    0.05 * (c + 1)) * cos(y * 0.03);
+				if (x < (width / 6))
+					value = 1.0;
+				const uint16_t sample = static_cast<uint16_t>(
+				    value * maximum);
+				if (bytes == 1)
+					data[offset] = static_cast<uint8_t>(
+					    sample);
+				else
+					memcpy(&data[offset], &sample, 2);
+				offset += bytes;
+			}
+		}
+	}
+
+	return (make_shared<Image::Raw>(data, Image::Size(width, height),
+	    colorDepth, bitDepth, Image::Resolution(500, 500,
+	    Image::Resolution::Units::PPI), hasAlphaChannel));
+}
+
+/* Mean absolute difference of two 8-bit buffers */
+static double
+meanError(
+    const Memory::uint8Array &lhs,
+    const Memory::uint8Array &rhs)
+{
+	if ((lhs.size() != rhs.size()) || (lhs.size() == 0))
+		return (UINT8_MAX);
+	double error = 0;
+	for (uint64_t i = 0; i < lhs.size(); i++)
+		error += abs(static_cast<int>(lhs[i]) -
+		    static_cast<int>(rhs[i]));
+	return (error / lhs.size());
+}
+
+/* Encode image and check the decoded result */
+static bool
+checkRoundTrip(
+    Image::CompressionAlgorithm compressionAlgorithm,
+    const Image::Image &image,
+    double tolerance)
+{
+	const auto encoder = Image::Encoder::openEncoder(compressionAlgorithm);
+	const Memory::uint8Array encoded = encoder->encode(image);
+	const auto decoded = Image::Image::openImage(encoded);
+
+	if (decoded->getCompressionAlgorithm() != compressionAlgorithm)
+		return (false);
+	if (decoded->getDimensions() != image.getDimensions())
+		return (false);
+	if (tolerance == 0)
+		return (decoded->getRawData() == image.getRawData());
+	if (decoded->getColorDepth() == image.getColorDepth())
+		return (meanError(decoded->getRawData(),
+		    image.getRawData()) <= tolerance);
+	/* Converted to grayscale */
+	return (meanError(decoded->getRawGrayscaleData(8),
+	    image.getRawGrayscaleData(8)) <= tolerance);
+}
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	bool success = true;
+
+	struct {
+		string name;
+		Image::CompressionAlgorithm compressionAlgorithm;
+		shared_ptr<Image::Raw> image;
+		double tolerance;
+	} roundTrips[] = {
+	    {"PNG, 8-bit gray", Image::CompressionAlgorithm::PNG,
+	        makeImage(61, 43, 8, 8, false), 0},
+	    {"PNG, 16-bit gray", Image::CompressionAlgorithm::PNG,
+	        makeImage(61, 43, 16, 16, false), 0},
+	    {"PNG, 24-bit RGB", Image::CompressionAlgorithm::PNG,
+	        makeImage(61, 43, 24, 8, false), 0},
+	    {"PNG, 32-bit RGBA", Image::CompressionAlgorithm::PNG,
+	        makeImage(61, 43, 32, 8, true), 0},
+	    {"Lossless JPEG 2000, 8-bit gray",
+	        Image::CompressionAlgorithm::JP2L,
+	        makeImage(61, 43, 8, 8, false), 0},
+	    {"Lossless JPEG 2000, 24-bit RGB",
+	        Image::CompressionAlgorithm::JP2L,
+	        makeImage(61, 43, 24, 8, false), 0},
+	    {"JPEG, 8-bit gray", Image::CompressionAlgorithm::JPEGB,
+	        makeImage(61, 43, 8, 8, false), 4},
+	    {"JPEG, 24-bit RGB", Image::CompressionAlgorithm::JPEGB,
+	        makeImage(61, 43, 24, 8, false), 4},
+	    {"WSQ, 8-bit gray", Image::CompressionAlgorithm::WSQ20,
+	        makeImage(256, 200, 8, 8, false), 4},
+	    {"WSQ, from 24-bit RGB", Image::CompressionAlgorithm::WSQ20,
+	        makeImage(256, 200, 24, 8, false), 4}
+	};
+	for (const auto &r : roundTrips) {
+		cout << r.name << " round trip: ";
+		try {
+			if (checkRoundTrip(r.compressionAlgorithm, *r.image,
+			    r.tolerance))
+				cout << "success." << endl;
+			else {
+				cout << "FAILED." << endl;
+				success = false;
+			}
+		} catch (const Error::Exception &e) {
+			cout << "FAILED (" << e.whatString() << ")." << endl;
+			success = false;
+		}
+	}
+
+	cout << "PNG, 1-bit gray round trip: ";
+	try {
+		/* 16x4 PBM, whose raw data widens each bit to 8 */
+		const string header = "P4\n16 4\n";
+		const uint8_t bits[] = {0xFF, 0xFF, 0xF0, 0x0F, 0x00, 0x00,
+		    0xAA, 0x55};
+		Memory::uint8Array pbm(header.size() + sizeof(bits));
+		memcpy(&pbm[0], header.data(), header.size());
+		memcpy(&pbm[header.size()], bits, sizeof(bits));
+		if (checkRoundTrip(Image::CompressionAlgorithm::PNG,
+		    *Image::Image::openImage(pbm), 0))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	vector<shared_ptr<Image::Image>> images;
+	for (uint32_t i = 0; i < 24; i++)
+		images.push_back(makeImage(40 + i, 30 + i, 8, 8, false, i));
+	const auto png = Image::Encoder::openEncoder(
+	    Image::CompressionAlgorithm::PNG);
+
+	cout << "Parallel batch matches sequential encoding: ";
+	try {
+		const vector<Memory::uint8Array> batch = png->encode(images, 4);
+		bool matched = (batch.size() == images.size());
+		for (uint64_t i = 0; matched && (i < images.size()); i++)
+			matched = (batch[i] == png->encode(*images[i]));
+		if (matched)
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Parallel batch into a RecordStore: ";
+	const string rsName = "test_be_image_encoder_rs";
+	try {
+		IO::RecordStore::removeRecordStore(rsName);
+	} catch (const Error::Exception&) {}
+	try {
+		auto rs = IO::RecordStore::createRecordStore(rsName, "",
+		    IO::RecordStore::Kind::Default);
+		vector<string> keys;
+		for (uint64_t i = 0; i < images.size(); i++)
+			keys.push_back("image" + to_string(i));
+		png->encode(images, keys, *rs, 4);
+
+		bool matched = (rs->getCount() == images.size());
+		for (uint64_t i = 0; matched && (i < images.size()); i++) {
+			const auto decoded = Image::Image::openImage(
+			    rs->read(keys[i]));
+			matched = (decoded->getRawData() ==
+			    images[i]->getRawData());
+		}
+		rs.reset();
+		IO::RecordStore::removeRecordStore(rsName);
+		if (matched)
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Invalid settings are rejected: ";
+	try {
+		Image::Encoder::Settings settings;
+		settings.quality = 0;
+		Image::Encoder::openEncoder(
+		    Image::CompressionAlgorithm::JPEGB, settings);
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::ParameterError&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Unsupported formats are rejected: ";
+	try {
+		Image::Encoder::openEncoder(Image::CompressionAlgorithm::BMP);
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::NotImplemented&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Short raw data is rejected: ";
+	try {
+		Image::Properties properties;
+		properties.dimensions = Image::Size(10, 10);
+		properties.colorDepth = properties.bitDepth = 8;
+		const uint8_t pixels[50]{};
+		png->encode(Memory::ByteView(pixels, sizeof(pixels)),
+		    properties);
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::ParameterError&) {
+		cout << "success." << endl;
+	}
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -8,6 +8,8 @@
  * about its quality, reliability, or any other characteristic.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <iostream>
 #include <map>
@@ -275,6 +277,274 @@ compareProperties(
 		cout << "\t>> All Properties Validated" << endl;
 }
 
+/**
+ * @brief
+ * Check that decoded data kept by the decode cache matches fresh decodes.
+ *
+ * @param image
+ *	The image to check.
+ *
+ * @notes
+ * Writes success to stdout and errors to stderr.
+ */
+static void
+checkDecodeCache(
+    shared_ptr<Image::Image> image)
+{
+	const Memory::uint8Array raw{image->getRawData()};
+	const Memory::uint8Array gray{image->getRawGrayscaleData(8)};
+
+	image->setDecodeCacheLimit(raw.size() + gray.size());
+	bool passed = true;
+	for (int pass = 0; pass < 2; pass++) {
+		if (image->getRawData() != raw) {
+			cerr << "	*** cached raw data differs" << endl;
+			passed = false;
+		}
+		if (image->getRawGrayscaleData(8) != gray) {
+			cerr << "	*** cached raw gray data differs" << endl;
+			passed = false;
+		}
+	}
+	if ((imageType != "Raw") &&
+	    (image->getDecodeCacheSize() == 0)) {
+		cerr << "	*** decoded data was not cached" << endl;
+		passed = false;
+	}
+	if (image->getDecodeCacheSize() > image->getDecodeCacheLimit()) {
+		cerr << "	*** decode cache exceeds its limit" << endl;
+		passed = false;
+	}
+
+	image->clearDecodeCache();
+	if (image->getDecodeCacheSize() != 0) {
+		cerr << "	*** decode cache was not released" << endl;
+		passed = false;
+	}
+	image->setDecodeCacheLimit(0);
+
+	if (passed)
+		cout << "\t>> Decode Cache Validated" << endl;
+}
+
+/**
+ * @brief
+ * Check that decoding into a caller's padded rows matches getRawData().
+ *
+ * @param image
+ *	The image to check.
+ *
+ * @notes
+ * Writes success to stdout and errors to stderr.
+ */
+static void
+checkDecodeInto(
+    shared_ptr<Image::Image> image)
+{
+	static const uint64_t Padding = 13;
+	static const uint8_t Canary = 0xA5;
+	const uint32_t height = image->getDimensions().ySize;
+
+	bool passed = true;
+	for (const auto &expected : {
+	    make_pair(Image::PixelFormat::Native, image->getRawData()),
+	    make_pair(Image::PixelFormat::Gray8,
+	    image->getRawGrayscaleData(8))}) {
+		const uint64_t rowSize = image->getRowSize(expected.first);
+		if (expected.second.size() != (rowSize * height)) {
+			cerr << "	*** " << to_string(expected.first) <<
+			    " row size differs" << endl;
+			passed = false;
+			continue;
+		}
+
+		const uint64_t stride = rowSize + Padding;
+		Memory::uint8Array rows(stride * height);
+		std::fill(rows.begin(), rows.end(), Canary);
+		image->decodeInto(rows, stride, expected.first);
+		for (uint32_t row = 0; row < height; row++) {
+			const uint8_t *dst = rows + (row * stride);
+			if (!std::equal(dst, dst + rowSize,
+			    expected.second + (row * rowSize)) ||
+			    (std::count(dst + rowSize, dst + stride,
+			    Canary) != Padding)) {
+				cerr << "	*** " << to_string(expected.first) <<
+				    " row " << row << " differs" << endl;
+				passed = false;
+				break;
+			}
+		}
+	}
+
+	if (passed)
+		cout << "\t>> decodeInto Validated" << endl;
+}
+
+/**
+ * @brief
+ * Check that decoding rectangles matches cropping getRawData().
+ *
+ * @param image
+ *	The image to check.
+ *
+ * @notes
+ * Writes success to stdout and errors to stderr.
+ */
+static void
+checkRawRegion(
+    shared_ptr<Image::Image> image)
+{
+	const Image::Size dims = image->getDimensions();
+	const Memory::uint8Array raw{image->getRawData()};
+	const uint64_t rowSize = raw.size() / dims.ySize;
+	/* Packed pixels are not byte-addressable */
+	if ((rowSize % dims.xSize) != 0) {
+		cout << "\t>> Region decoding not checked (packed pixels)" <<
+		    endl;
+		return;
+	}
+	const uint64_t pixelSize = rowSize / dims.xSize;
+
+	bool passed = true;
+	for (const auto &region : {
+	    make_pair(Image::Coordinate(0, 0), Image::Size(1, 1)),
+	    make_pair(Image::Coordinate(dims.xSize / 3, dims.ySize / 4),
+	    Image::Size(dims.xSize / 2, dims.ySize / 2)),
+	    make_pair(Image::Coordinate(dims.xSize - 1, dims.ySize - 1),
+	    Image::Size(1, 1)),
+	    make_pair(Image::Coordinate(0, dims.ySize / 2),
+	    Image::Size(dims.xSize, dims.ySize - (dims.ySize / 2)))}) {
+		const Image::Coordinate &origin = region.first;
+		const Image::Size &size = region.second;
+		if ((size.xSize == 0) || (size.ySize == 0))
+			continue;
+
+		const Memory::uint8Array decoded{image->getRawData(origin,
+		    size)};
+		const uint64_t regionRowSize = size.xSize * pixelSize;
+		bool matched = (decoded.size() == (regionRowSize * size.ySize));
+		for (uint32_t row = 0; matched && (row < size.ySize); row++)
+			matched = std::equal(decoded + (row * regionRowSize),
+			    decoded + ((row + 1) * regionRowSize),
+			    raw + ((origin.y + row) * rowSize) +
+			    (origin.x * pixelSize));
+		if (!matched) {
+			cerr << "\t*** region " << size << " at " << origin <<
+			    " differs" << endl;
+			passed = false;
+		}
+	}
+
+	try {
+		image->getRawData(Image::Coordinate(dims.xSize / 2, 0),
+		    Image::Size(dims.xSize, 1));
+		cerr << "\t*** region outside of the image was accepted" <<
+		    endl;
+		passed = false;
+	} catch (const Error::ParameterError&) {}
+
+	if (passed)
+		cout << "\t>> Region Decoding Validated" << endl;
+}
+
+static void
+checkReducedRawData(
+    shared_ptr<Image::Image> image)
+{
+	const Image::Size dims = image->getDimensions();
+	const Memory::uint8Array raw{image->getRawData()};
+	const uint64_t rowSize = raw.size() / dims.ySize;
+	/* Packed pixels are not averaged */
+	if ((rowSize % dims.xSize) != 0) {
+		cout << "\t>> Reduced decoding not checked (packed pixels)" <<
+		    endl;
+		return;
+	}
+	const uint64_t pixelSize = rowSize / dims.xSize;
+
+	bool passed = true;
+	for (uint8_t denominator : {2, 4, 8}) {
+		const Image::Size reduced = image->getReducedDimensions(
+		    denominator);
+		const Memory::uint8Array decoded{image->getReducedRawData(
+		    denominator)};
+		if (decoded.size() != (static_cast<uint64_t>(reduced.xSize) *
+		    reduced.ySize * pixelSize)) {
+			cerr << "\t*** 1/" << static_cast<int>(denominator) <<
+			    " reduced size is " << decoded.size() << endl;
+			passed = false;
+			continue;
+		}
+
+		/*
+		 * Codec reductions filter differently than a block
+		 * average, so compare the mean difference of 8-bit samples.
+		 */
+		if (image->getBitDepth() > 8)
+			continue;
+		double difference = 0;
+		for (uint32_t y = 0; y < reduced.ySize; y++) {
+			for (uint64_t i = 0; i < reduced.xSize * pixelSize;
+			    i++) {
+				const uint32_t x = i / pixelSize;
+				uint64_t sum = 0, count = 0;
+				for (uint32_t sy = y * denominator; (sy <
+				    dims.ySize) && (sy < (y + 1) * denominator);
+				    sy++) {
+					for (uint32_t sx = x * denominator;
+					    (sx < dims.xSize) && (sx < (x + 1) *
+					    denominator); sx++) {
+						sum += raw[(sy * rowSize) +
+						    (sx * pixelSize) +
+						    (i % pixelSize)];
+						count++;
+					}
+				}
+				difference += std::abs((static_cast<double>(
+				    sum) / count) - decoded[(y *
+				    reduced.xSize * pixelSize) + i]);
+			}
+		}
+		difference /= decoded.size();
+		if (difference > 8) {
+			cerr << "\t*** 1/" << static_cast<int>(denominator) <<
+			    " reduced samples differ by " << difference <<
+			    " on average" << endl;
+			passed = false;
+		}
+	}
+
+	try {
+		image->getReducedRawData(3);
+		cerr << "\t*** scale denominator of 3 was accepted" << endl;
+		passed = false;
+	} catch (const Error::ParameterError&) {}
+
+	if (passed)
+		cout << "\t>> Reduced Decoding Validated" << endl;
+}
+
+#if !defined RAWTEST
+/* Raw images have no header to probe */
+static void
+checkProbe(
+    shared_ptr<Image::Image> image,
+    const Memory::ByteView &data)
+{
+	const Image::Properties probed = Image::Image::probe(data);
+	if ((probed.compressionAlgorithm !=
+	    image->getCompressionAlgorithm()) ||
+	    (probed.dimensions != image->getDimensions()) ||
+	    (probed.colorDepth != image->getColorDepth()) ||
+	    (probed.bitDepth != image->getBitDepth()) ||
+	    (probed.resolution != image->getResolution()) ||
+	    (probed.hasAlphaChannel != image->hasAlphaChannel()))
+		cerr << "\t*** probed properties differ" << endl;
+	else
+		cout << "\t>> Probe Validated" << endl;
+}
+#endif /* RAWTEST */
+
 int
 main(
     int argc,
@@ -448,6 +718,13 @@ main(
 		    properties->getPropertyAsBoolean("hasAlphaChannel")));
 #elif defined FACTORYTEST
 		image = Image::Image::openImage(record.data);
+
+		/* A view of the record is parsed in place, without a copy */
+		const Memory::ByteView view(record.data);
+		if (Image::Image::openImage(view)->getDataView().data() !=
+		    view.data())
+			cerr << record.key << ": openImage(ByteView) copied "
+			    "the image data" << endl;
 #endif
 
 		/* Print all the metadata for the Image */
@@ -489,6 +766,44 @@ main(
 			cerr << e.whatString() << endl;
 		}
 		
+		try {
+			checkDecodeCache(image);
+		} catch (Error::Exception &e) {
+			cerr << "Error checking decode cache for " <<
+			    record.key << ": " << e.whatString() << endl;
+		}
+
+		try {
+			checkDecodeInto(image);
+		} catch (Error::Exception &e) {
+			cerr << "Error checking decodeInto for " <<
+			    record.key << ": " << e.whatString() << endl;
+		}
+
+		try {
+			checkRawRegion(image);
+		} catch (Error::Exception &e) {
+			cerr << "Error checking region decoding for " <<
+			    record.key << ": " << e.whatString() << endl;
+		}
+
+		try {
+			checkReducedRawData(image);
+		} catch (Error::Exception &e) {
+			cerr << "Error checking reduced decoding for " <<
+			    record.key << ": " << e.whatString() << endl;
+		}
+
+#if !defined RAWTEST
+		try {
+			checkProbe(image, Memory::ByteView(record.data,
+			    record.data.size()));
+		} catch (Error::Exception &e) {
+			cerr << "Error checking probe for " << record.key <<
+			    ": " << e.whatString() << endl;
+		}
+#endif
+
 		/* 
 		 * Compare all properties of the Image as parsed to those 
 		 * generated by the constructor, including a difference of the
@@ -0,0 +1,249 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <be_error_exception.h>
+#include <be_image_conversion.h>
+#include <be_image_resample.h>
+
+using namespace BiometricEvaluation;
+using namespace std;
+
+/*
+ * A raw image of diagonal ramps, offset in each component. Ramps wrap,
+ * so the kernels also see sharp edges.
+ */
+static Image::Raw
+makeImage(
+    uint32_t width,
+    uint32_t height,
+    uint32_t colorDepth,
+    uint16_t bitDepth,
+    const Image::Resolution &resolution = Image::Resolution(1000, 1000,
+        Image::Resolution::Units::PPI))
+{
+	const uint32_t components = colorDepth / bitDepth;
+	const uint32_t bytes = bitDepth / 8;
+	const uint32_t maximum = (1u << bitDepth) - 1;
+	Memory::uint8Array data(static_cast<uint64_t>(width) * height *
+	    components * bytes);
+	uint64_t offset = 0;
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			for (uint32_t c = 0; c < components; c++) {
+				const uint16_t sample = static_cast<uint16_t>(
+				    (((x * 7) + (y * 5) + (c * 50)) *
+				    (maximum / 255)) % (maximum + 1));
+				if (bytes == 1)
+					data[offset] = static_cast<uint8_t>(
+					    sample);
+				else
+					memcpy(&data[offset], &sample, 2);
+				offset += bytes;
+			}
+		}
+	}
+
+	return (Image::Raw(data, Image::Size(width, height), colorDepth,
+	    bitDepth, resolution, components == 4));
+}
+
+/* Halving with Area is the average of each 2x2 block */
+static bool
+checkAreaAverage()
+{
+	const Image::Raw image = makeImage(64, 48, 8, 8);
+	const Image::Raw half = Image::resample(image, Image::Size(32, 24),
+	    Image::ResampleFilter::Area, 1);
+	const Memory::uint8Array in = image.getRawData();
+	const Memory::uint8Array out = half.getRawData();
+	for (uint32_t y = 0; y < 24; y++) {
+		for (uint32_t x = 0; x < 32; x++) {
+			const double sum = in[(2 * y * 64) + (2 * x)] +
+			    in[(2 * y * 64) + (2 * x) + 1] +
+			    in[(((2 * y) + 1) * 64) + (2 * x)] +
+			    in[(((2 * y) + 1) * 64) + (2 * x) + 1];
+			if (abs(out[(y * 32) + x] - (sum / 4)) > 0.5)
+				return (false);
+		}
+	}
+	return (true);
+}
+
+/* Part of input sample in covered by output sample out, of scale samples */
+static double
+coverage(
+    uint32_t out,
+    uint32_t in,
+    double scale)
+{
+	return (max(0.0, min(in + 1.0, (out + 1) * scale) -
+	    max(static_cast<double>(in), out * scale)));
+}
+
+/* Area weights input pixels by how much of each an output pixel covers */
+static bool
+checkAreaCoverage()
+{
+	/* 3 to 2 is (p0 + p1 / 2) / 1.5 and (p1 / 2 + p2) / 1.5 */
+	const Image::Raw image = makeImage(30, 21, 8, 8);
+	const Image::Raw reduced = Image::resample(image, Image::Size(20, 14),
+	    Image::ResampleFilter::Area, 1);
+	const Memory::uint8Array in = image.getRawData();
+	const Memory::uint8Array out = reduced.getRawData();
+	for (uint32_t y = 0; y < 14; y++) {
+		for (uint32_t x = 0; x < 20; x++) {
+			double expected = 0;
+			for (uint32_t iy = 0; iy < 21; iy++)
+				for (uint32_t ix = 0; ix < 30; ix++)
+					expected += coverage(x, ix, 1.5) *
+					    coverage(y, iy, 1.5) *
+					    in[(iy * 30) + ix];
+			expected /= (1.5 * 1.5);
+			if (abs(out[(y * 20) + x] - expected) > 0.501)
+				return (false);
+		}
+	}
+	return (true);
+}
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	bool success = true;
+
+	cout << "Area halving averages blocks: ";
+	if (checkAreaAverage())
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Area weights partly covered pixels: ";
+	if (checkAreaCoverage())
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "1000 ppi to 500 ppi: ";
+	try {
+		const Image::Raw image = makeImage(400, 300, 8, 8);
+		const Image::Raw resampled = Image::resample(image,
+		    Image::Resolution(500, 500, Image::Resolution::Units::PPI));
+		if ((resampled.getDimensions() == Image::Size(200, 150)) &&
+		    (resampled.getResolution().xRes == 500) &&
+		    (resampled.getColorDepth() == 8))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	/* Every instruction set and thread count gives the same pixels */
+	const Image::Conversion::Instructions available =
+	    Image::Conversion::getInstructions();
+	const Image::ResampleFilter filters[] = {
+	    Image::ResampleFilter::Area, Image::ResampleFilter::Bilinear,
+	    Image::ResampleFilter::Lanczos};
+	const struct {
+		uint32_t colorDepth;
+		uint16_t bitDepth;
+	} formats[] = {{8, 8}, {24, 8}, {32, 8}, {16, 16}, {48, 16}};
+	const Image::Size targets[] = {Image::Size(53, 37),
+	    Image::Size(241, 263)};
+	for (const auto filter : filters) {
+		for (const auto &format : formats) {
+			cout << to_string(filter) << ", " << format.colorDepth <<
+			    "-bit: ";
+			const Image::Raw image = makeImage(97, 131,
+			    format.colorDepth, format.bitDepth);
+			bool matched = true;
+			try {
+				for (const auto &target : targets) {
+					Image::Conversion::setInstructions(
+					    Image::Conversion::Instructions::Scalar);
+					const Memory::uint8Array expected =
+					    Image::resample(image, target, filter,
+					    1).getRawData();
+					for (const auto instructions : {
+					    Image::Conversion::Instructions::SSE41,
+					    Image::Conversion::Instructions::AVX2}) {
+						if (instructions > available)
+							continue;
+						Image::Conversion::setInstructions(
+						    instructions);
+						matched = matched && (Image::resample(
+						    image, target, filter,
+						    4).getRawData() == expected);
+					}
+				}
+				Image::Conversion::setInstructions(available);
+				if (matched)
+					cout << "success." << endl;
+				else {
+					cout << "FAILED." << endl;
+					success = false;
+				}
+			} catch (const Error::Exception &e) {
+				Image::Conversion::setInstructions(available);
+				cout << "FAILED (" << e.whatString() << ")." <<
+				    endl;
+				success = false;
+			}
+		}
+	}
+
+	cout << "Images without resolution are rejected: ";
+	try {
+		Image::resample(makeImage(10, 10, 8, 8, Image::Resolution()),
+		    Image::Resolution(500, 500, Image::Resolution::Units::PPI));
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::ParameterError&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Empty results are rejected: ";
+	try {
+		Image::resample(makeImage(10, 10, 8, 8), Image::Size(0, 10));
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::ParameterError&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Unsupported sample sizes are rejected: ";
+	try {
+		Memory::uint8Array bits(10 * 10 / 8 + 10);
+		Image::resample(Image::Raw(bits, Image::Size(10, 10), 1, 1,
+		    Image::Resolution(500, 500, Image::Resolution::Units::PPI),
+		    false), Image::Size(5, 5));
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::NotImplemented&) {
+		cout << "success." << endl;
+	}
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,312 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <be_error_exception.h>
+#include <be_image_raw.h>
+#include <be_image_tiledraw.h>
+
+using namespace BiometricEvaluation;
+using namespace std;
+
+/* A raw image whose every sample differs from its neighbors */
+static Image::Raw
+makeImage(
+    uint32_t width,
+    uint32_t height,
+    uint32_t colorDepth,
+    uint16_t bitDepth)
+{
+	const uint32_t components = colorDepth / bitDepth;
+	const uint32_t bytes = bitDepth / 8;
+	Memory::uint8Array data(static_cast<uint64_t>(width) * height *
+	    components * bytes);
+	for (uint64_t i = 0; i < data.size(); i++)
+		data[i] = static_cast<uint8_t>((i * 7) + (i / 251));
+
+	return (Image::Raw(data, Image::Size(width, height), colorDepth,
+	    bitDepth, Image::Resolution(1000, 1000,
+	    Image::Resolution::Units::PPI), components == 4));
+}
+
+/* A raw image that, like WSQ, decodes in full to obtain any rectangle */
+class WholeDecodeRaw : public Image::Raw
+{
+public:
+	WholeDecodeRaw(
+	    const Raw &raw) :
+	    Raw(raw),
+	    decodes(0)
+	{
+
+	}
+
+	using Raw::getRawData;
+
+	Memory::uint8Array
+	getRawData()
+	    const
+	{
+		decodes++;
+		return (Raw::getRawData());
+	}
+
+	bool
+	decodesRegions()
+	    const
+	{
+		return (false);
+	}
+
+	mutable std::atomic<uint32_t> decodes;
+
+protected:
+	Memory::uint8Array
+	decodeRawRegion(
+	    const BiometricEvaluation::Image::Coordinate &origin,
+	    const BiometricEvaluation::Image::Size &size)
+	    const
+	{
+		return (Image::decodeRawRegion(origin, size));
+	}
+};
+
+/* Compare a TiledRaw image with the image it was made from */
+static bool
+checkImage(
+    const Image::TiledRaw &tiled,
+    const Image::Image &image)
+{
+	if ((tiled.getDimensions() != image.getDimensions()) ||
+	    (tiled.getColorDepth() != image.getColorDepth()) ||
+	    (tiled.getBitDepth() != image.getBitDepth()) ||
+	    (tiled.getResolution() != image.getResolution()) ||
+	    (tiled.hasAlphaChannel() != image.hasAlphaChannel()))
+		return (false);
+	if (tiled.getRawData() != image.getRawData())
+		return (false);
+
+	/* A rectangle crossing tile boundaries */
+	const Image::Coordinate origin(image.getDimensions().xSize / 5,
+	    image.getDimensions().ySize / 4);
+	const Image::Size size(image.getDimensions().xSize / 2,
+	    image.getDimensions().ySize / 2);
+	return (tiled.getRawData(origin, size) ==
+	    image.getRawData(origin, size));
+}
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	bool success = true;
+
+	const struct {
+		string name;
+		Image::Raw image;
+		Image::CompressionAlgorithm tileCompression;
+	} roundTrips[] = {
+	    {"8-bit gray", makeImage(1000, 700, 8, 8),
+	        Image::CompressionAlgorithm::None},
+	    {"16-bit gray", makeImage(301, 203, 16, 16),
+	        Image::CompressionAlgorithm::None},
+	    {"24-bit RGB", makeImage(301, 203, 24, 8),
+	        Image::CompressionAlgorithm::None},
+	    {"32-bit RGBA", makeImage(301, 203, 32, 8),
+	        Image::CompressionAlgorithm::None},
+	    {"8-bit gray, PNG tiles", makeImage(1000, 700, 8, 8),
+	        Image::CompressionAlgorithm::PNG},
+	    {"24-bit RGB, PNG tiles", makeImage(301, 203, 24, 8),
+	        Image::CompressionAlgorithm::PNG}
+	};
+	for (const auto &r : roundTrips) {
+		cout << r.name << " round trip: ";
+		try {
+			const Memory::uint8Array data = Image::TiledRaw::encode(
+			    r.image, Image::Size(128, 96), r.tileCompression, 4);
+			const Image::TiledRaw tiled(data);
+			if ((tiled.getTileCompressionAlgorithm() ==
+			    r.tileCompression) && checkImage(tiled, r.image))
+				cout << "success." << endl;
+			else {
+				cout << "FAILED." << endl;
+				success = false;
+			}
+		} catch (const Error::Exception &e) {
+			cout << "FAILED (" << e.whatString() << ")." << endl;
+			success = false;
+		}
+	}
+
+	const Image::Raw image = makeImage(1000, 700, 8, 8);
+	const Memory::uint8Array data = Image::TiledRaw::encode(image,
+	    Image::Size(128, 96));
+
+	cout << "Tiles are opened by Image::openImage(): ";
+	try {
+		const auto opened = Image::Image::openImage(data);
+		if ((opened->getCompressionAlgorithm() ==
+		    Image::CompressionAlgorithm::TiledRaw) &&
+		    (opened->getRawData() == image.getRawData()))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Images without region decoding are decoded once: ";
+	try {
+		const WholeDecodeRaw whole(image);
+		const Memory::uint8Array wholeData = Image::TiledRaw::encode(
+		    whole, Image::Size(128, 96));
+		if ((whole.decodes == 1) && (wholeData == data))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED (" << whole.decodes << " decodes)." <<
+			    endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Single tiles: ";
+	try {
+		const Image::TiledRaw tiled(Memory::ByteView(data,
+		    data.size()));
+		/* The last tile is clipped to 1000 - 896 by 700 - 672 */
+		if ((tiled.getTileCount() == Image::Size(8, 8)) &&
+		    (tiled.getTile(7, 7) == image.getRawData(
+		    Image::Coordinate(896, 672), Image::Size(104, 28))) &&
+		    (tiled.getTile(2, 3) == image.getRawData(
+		    Image::Coordinate(256, 288), Image::Size(128, 96))))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Parallel tile processing covers every pixel once: ";
+	try {
+		const Image::TiledRaw tiled(data);
+		Memory::uint8Array assembled(image.getRawData().size());
+		std::atomic<uint32_t> count{0};
+		tiled.forEachTile([&](const Image::TiledRaw::Tile &tile) {
+			for (uint32_t y = 0; y < tile.dimensions.ySize; y++)
+				memcpy(&assembled[((tile.origin.y + y) * 1000) +
+				    tile.origin.x], tile.pixels.data() +
+				    (y * tile.dimensions.xSize),
+				    tile.dimensions.xSize);
+			count++;
+		}, 4);
+		if ((count == 64) && (assembled == image.getRawData()))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Memory-mapped file: ";
+	const string pathname = "test_be_image_tiledraw.tiled";
+	unlink(pathname.c_str());
+	try {
+		Image::TiledRaw::create(pathname, image, Image::Size(100, 100),
+		    Image::CompressionAlgorithm::None, 2);
+		const Image::TiledRaw tiled(pathname);
+		const Image::TiledRaw copy(tiled);
+		if (checkImage(tiled, image) && checkImage(copy, image))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Existing files are not replaced: ";
+	try {
+		Image::TiledRaw::create(pathname, image);
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::ObjectExists&) {
+		cout << "success." << endl;
+	}
+	unlink(pathname.c_str());
+
+	cout << "Truncated data is rejected: ";
+	try {
+		Image::TiledRaw tiled(Memory::ByteView(data,
+		    data.size() - 16));
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::DataError&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Headers whose tile grid overflows are rejected: ";
+	try {
+		/* Width 0xFFFFFFFF with 2-pixel tiles */
+		Memory::uint8Array corrupt(data);
+		const uint32_t width = 0xFFFFFFFF, tileWidth = 2;
+		memcpy(&corrupt[8], &width, sizeof(width));
+		memcpy(&corrupt[40], &tileWidth, sizeof(tileWidth));
+		Image::TiledRaw tiled(corrupt);
+		tiled.getRawData(Image::Coordinate(0, 0), Image::Size(10, 10));
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::DataError&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Empty tiles are rejected: ";
+	try {
+		Image::TiledRaw::encode(image, Image::Size(0, 64));
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::ParameterError&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Unsupported sample sizes are rejected: ";
+	try {
+		Memory::uint8Array bits(10 * 10);
+		Image::TiledRaw::encode(Image::Raw(bits, Image::Size(10, 10),
+		    1, 1, Image::Resolution(), false));
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::NotImplemented&) {
+		cout << "success." << endl;
+	}
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,202 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <be_error_exception.h>
+#include <be_image_conversion.h>
+#include <be_image_encoder.h>
+#include <be_image_raw.h>
+#include <be_image_wsq.h>
+#include <be_io_utility.h>
+
+using namespace BiometricEvaluation;
+using namespace std;
+
+/* A WSQ image of ridge-like content */
+static Memory::uint8Array
+makeWSQ(
+    uint32_t width,
+    uint32_t height,
+    float bitRate)
+{
+	Memory::uint8Array data(static_cast<uint64_t>(width) * height);
+	uint64_t offset = 0;
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			const double ridge = sin((x * 0.35) + (y * 0.2) +
+			    (3 * sin(y * 0.01)));
+			data[offset++] = static_cast<uint8_t>(128 + (100 *
+			    ridge) + ((x * 31 + y * 17) % 23));
+		}
+	}
+
+	Image::Encoder::Settings settings;
+	settings.bitRate = bitRate;
+	return (Image::Encoder::openEncoder(
+	    Image::CompressionAlgorithm::WSQ20, settings)->encode(
+	    Image::Raw(data, Image::Size(width, height), 8, 8,
+	    Image::Resolution(500, 500, Image::Resolution::Units::PPI),
+	    false)));
+}
+
+/*
+ * Whether the optimized decoder matches NBIS at every scale, with
+ * every instruction set and one or more threads.
+ */
+static bool
+checkDecoders(
+    const Memory::uint8Array &wsq)
+{
+	const Memory::ByteView data(wsq, wsq.size());
+	const Image::Conversion::Instructions available =
+	    Image::Conversion::getInstructions();
+	bool matched = true;
+	for (const uint8_t scaleDenominator : {1, 2, 4, 8}) {
+		const Memory::uint8Array expected = Image::WSQ::decode(data,
+		    scaleDenominator, Image::WSQ::Decoder::NBIS);
+		for (const auto instructions : {
+		    Image::Conversion::Instructions::Scalar,
+		    Image::Conversion::Instructions::SSE41,
+		    Image::Conversion::Instructions::AVX2}) {
+			if (instructions > available)
+				continue;
+			Image::Conversion::setInstructions(instructions);
+			for (const uint32_t threads : {1, 4})
+				matched = matched && (Image::WSQ::decode(data,
+				    scaleDenominator,
+				    Image::WSQ::Decoder::Optimized,
+				    threads) == expected);
+		}
+	}
+	Image::Conversion::setInstructions(available);
+	return (matched);
+}
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	bool success = true;
+
+	const struct {
+		string name;
+		uint32_t width;
+		uint32_t height;
+		float bitRate;
+	} images[] = {
+	    {"800x750, 0.75 bpp", 800, 750, 0.75},
+	    {"545x623, 2.25 bpp", 545, 623, 2.25},
+	    {"1600x1500, 0.75 bpp", 1600, 1500, 0.75}
+	};
+	for (const auto &image : images) {
+		cout << image.name << " matches NBIS: ";
+		try {
+			if (checkDecoders(makeWSQ(image.width, image.height,
+			    image.bitRate)))
+				cout << "success." << endl;
+			else {
+				cout << "FAILED." << endl;
+				success = false;
+			}
+		} catch (const Error::Exception &e) {
+			cout << "FAILED (" << e.whatString() << ")." << endl;
+			success = false;
+		}
+	}
+
+	Memory::uint8Array wsq;
+	cout << "test_data/img.wsq matches NBIS: ";
+	try {
+		wsq = IO::Utility::readFile("test_data/img.wsq");
+		if (checkDecoders(wsq))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Image::WSQ decodes with the optimized decoder: ";
+	try {
+		const Image::WSQ image(wsq);
+		if ((image.getRawData() == Image::WSQ::decode(
+		    Memory::ByteView(wsq, wsq.size()), 1,
+		    Image::WSQ::Decoder::NBIS)) &&
+		    (image.getReducedRawData(4) == Image::WSQ::decode(
+		    Memory::ByteView(wsq, wsq.size()), 4,
+		    Image::WSQ::Decoder::NBIS)))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (const Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Truncated data is rejected: ";
+	try {
+		Image::WSQ::decode(Memory::ByteView(wsq, wsq.size() / 2));
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::DataError&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Out of range Huffman table IDs are rejected: ";
+	try {
+		Memory::uint8Array corrupt(wsq);
+		uint64_t offset = 0;
+		while ((offset + 4 < corrupt.size()) &&
+		    !((corrupt[offset] == 0xFF) && (corrupt[offset + 1] == 0xA6)))
+			offset++;
+		/* Marker, then segment length, then the first table ID */
+		corrupt[offset + 4] = 200;
+		Image::WSQ::decode(Memory::ByteView(corrupt, corrupt.size()));
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::DataError&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Entropy data ending before the last coefficient is "
+	    "rejected: ";
+	try {
+		/* 0xF7 0xA1 becomes an EOI marker in the second block */
+		Memory::uint8Array corrupt(wsq);
+		corrupt[5432] = 0xFF;
+		Image::WSQ::decode(Memory::ByteView(corrupt, corrupt.size()));
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::DataError&) {
+		cout << "success." << endl;
+	}
+
+	cout << "Invalid scale denominators are rejected: ";
+	try {
+		Image::WSQ::decode(Memory::ByteView(wsq, wsq.size()), 3);
+		cout << "FAILED." << endl;
+		success = false;
+	} catch (const Error::ParameterError&) {
+		cout << "success." << endl;
+	}
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -14,6 +14,7 @@
 #include <sstream>
 
 #include <be_io_filelogcabinet.h>
+#include <be_io_filelogsheetreader.h>
 #include <be_io_utility.h>
 
 using namespace std;
@@ -151,6 +152,185 @@ doLogCabinetTests()
 	return (0);
 }
 
+/* Whether a sequenced entry holds text, ignoring leading whitespace */
+static bool
+entryIs(
+    const std::string &entry,
+    const std::string &text)
+{
+	const std::string::size_type start = entry.find_first_not_of(' ');
+	return ((start != std::string::npos) && (entry.substr(start) == text));
+}
+
+static int
+doAsyncTests()
+{
+	static const uint32_t AsyncEntryCount = 100000;
+	string lsname = "file://./logsheet_async_test";
+	cout << "Writing " << AsyncEntryCount << " asynchronous entries: ";
+	std::unique_ptr<FileLogsheet> als;
+	try {
+		als.reset(new FileLogsheet(lsname, "Asynchronous Log Sheet"));
+		als->writeComment("Synchronous comment");
+		als->setAsynchronous(true, 50000, 65536);
+		for (uint32_t i = 0; i < AsyncEntryCount; i++) {
+			*als << "Asynchronous entry " << i;
+			als->newEntry();
+			if (i == AsyncEntryCount / 2)
+				als->writeComment("Asynchronous comment");
+		}
+		als->sync();
+		als->setAsynchronous(false);
+		*als << "Synchronous entry";
+		als->newEntry();
+		als->sync();
+	} catch (Error::Exception &e) {
+		cout << "Caught " << e.what() << endl;
+		return (-1);
+	}
+	cout << "success." << endl;
+
+	cout << "Sequence asynchronous entries: ";
+	try {
+		uint32_t count = 0;
+		std::string entry = als->sequence(true, true,
+		    IO::FileLogsheet::BE_FILELOGSHEET_SEQ_START);
+		if (!entryIs(entry, "Synchronous comment")) {
+			cout << "failed! (first entry: " << entry << ")" << endl;
+			return (-1);
+		}
+		while (true) {
+			try {
+				entry = als->sequence();
+			} catch (Error::ObjectDoesNotExist) {
+				break;
+			}
+			if ((count < AsyncEntryCount) && !entryIs(entry,
+			    "Asynchronous entry " + std::to_string(count))) {
+				cout << "failed! (entry " << count << ": " <<
+				    entry << ")" << endl;
+				return (-1);
+			}
+			count++;
+		}
+		if ((count != AsyncEntryCount + 1) ||
+		    !entryIs(entry, "Synchronous entry")) {
+			cout << "failed! (" << count << " entries)" << endl;
+			return (-1);
+		}
+	} catch (Error::Exception &e) {
+		cout << "Caught " << e.what() << endl;
+		return (-1);
+	}
+	cout << "success." << endl;
+	return (0);
+}
+
+static int
+doMergeTests()
+{
+	static const uint32_t SheetCount = 5;
+	static const uint32_t SheetEntryCount = 2000;
+	string lcname = "./logcabinet_merge_test";
+	cout << "Writing " << SheetCount << " sheets to merge: ";
+	std::vector<std::string> urls;
+	try {
+		FileLogCabinet lc(lcname, "Merge Log Cabinet");
+		for (uint32_t i = 0; i < SheetCount; i++) {
+			auto ls = lc.newLogsheet("sheet" + std::to_string(i),
+			    "Merge sheet " + std::to_string(i));
+			ls->writeComment("Comment in sheet " + std::to_string(i));
+			/* Sheet i holds the values i, i + SheetCount, ... */
+			for (uint32_t j = 0; j < SheetEntryCount; j++) {
+				*ls << (j * SheetCount) + i;
+				ls->newEntry();
+			}
+			ls->sync();
+			urls.push_back(lcname + "/sheet" + std::to_string(i));
+		}
+	} catch (Error::Exception &e) {
+		cout << "Caught " << e.what() << endl;
+		return (-1);
+	}
+	cout << "success." << endl;
+
+	cout << "Bulk merge: ";
+	try {
+		const uint32_t count = FileLogsheet::mergeLogsheets(urls,
+		    "./logsheet_bulk_merge", "Bulk merge", 3);
+		FileLogsheetReader reader("./logsheet_bulk_merge");
+		if ((count != SheetCount * SheetEntryCount) ||
+		    (reader.getEntryCount() != count)) {
+			cout << "failed! (" << count << " entries)" << endl;
+			return (-1);
+		}
+		for (uint32_t n = 1; n <= count; n++) {
+			const uint32_t i = (n - 1) / SheetEntryCount;
+			const uint32_t j = (n - 1) % SheetEntryCount;
+			const std::string entry = reader.getEntry(n, false);
+			if ((std::stoul(entry.substr(2, 10)) != n) ||
+			    !entryIs(reader.getEntry(n),
+			    std::to_string((j * SheetCount) + i))) {
+				cout << "failed! (entry " << n << ": " <<
+				    entry << ")" << endl;
+				return (-1);
+			}
+		}
+		FileLogsheet merged("./logsheet_bulk_merge");
+		if (merged.getCurrentEntryNumber() != count + 1) {
+			cout << "failed! (next entry " <<
+			    merged.getCurrentEntryNumber() << ")" << endl;
+			return (-1);
+		}
+	} catch (Error::Exception &e) {
+		cout << "Caught " << e.what() << endl;
+		return (-1);
+	}
+	cout << "success." << endl;
+
+	cout << "Bulk merge of FileLogCabinet: ";
+	try {
+		FileLogCabinet lc(lcname);
+		const uint32_t count = lc.mergeLogsheets(
+		    "./logsheet_cabinet_merge", "Cabinet merge");
+		if (count != SheetCount * SheetEntryCount) {
+			cout << "failed! (" << count << " entries)" << endl;
+			return (-1);
+		}
+	} catch (Error::Exception &e) {
+		cout << "Caught " << e.what() << endl;
+		return (-1);
+	}
+	cout << "success." << endl;
+
+	cout << "Ordered merge: ";
+	try {
+		const uint32_t count = FileLogsheet::mergeLogsheets(urls,
+		    "./logsheet_ordered_merge", "Ordered merge",
+		    [](const std::string &first, const std::string &second) {
+			return (std::stoul(first) < std::stoul(second));
+		});
+		FileLogsheetReader reader("./logsheet_ordered_merge");
+		if ((count != SheetCount * SheetEntryCount) ||
+		    (reader.getEntryCount() != count)) {
+			cout << "failed! (" << count << " entries)" << endl;
+			return (-1);
+		}
+		for (uint32_t n = 1; n <= count; n++) {
+			if (!entryIs(reader.getEntry(n), std::to_string(n - 1))) {
+				cout << "failed! (entry " << n << ": " <<
+				    reader.getEntry(n) << ")" << endl;
+				return (-1);
+			}
+		}
+	} catch (Error::Exception &e) {
+		cout << "Caught " << e.what() << endl;
+		return (-1);
+	}
+	cout << "success." << endl;
+	return (0);
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -286,6 +466,14 @@ main(int argc, char* argv[])
 	if (doLogCabinetTests() != 0)
 		return(EXIT_FAILURE);
 
+	std::cout << endl << "Asynchronous FileLogsheet tests: " << std::endl;
+	if (doAsyncTests() != 0)
+		return(EXIT_FAILURE);
+
+	std::cout << endl << "FileLogsheet merge tests: " << std::endl;
+	if (doMergeTests() != 0)
+		return(EXIT_FAILURE);
+
 	std::cout << "Sequence all normal, comment, debug entries: "
 	    << std::endl;
 	try {
@@ -0,0 +1,166 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <be_error_exception.h>
+#include <be_io_filelogsheet.h>
+#include <be_io_filelogsheetreader.h>
+#include <be_io_utility.h>
+
+namespace BE = BiometricEvaluation;
+
+static const std::string pathname = "test_logsheetreader.log";
+static const uint32_t numEntries = 10000;
+
+static std::string
+entryFor(
+    uint32_t number)
+{
+	/* Every tenth entry has a continuation line */
+	std::string entry = "Entry " + std::to_string(number);
+	if (number % 10 == 0)
+		entry += "\n\tcontinued";
+	return (entry);
+}
+
+static void
+writeEntries(
+    BE::IO::FileLogsheet &sheet,
+    uint32_t first,
+    uint32_t last)
+{
+	for (uint32_t i = first; i <= last; i++) {
+		if (i % 100 == 0)
+			sheet.writeComment("Comment before " +
+			    std::to_string(i));
+		sheet.write(entryFor(i));
+	}
+	sheet.sync();
+}
+
+static bool
+checkEntries(
+    const BE::IO::FileLogsheetReader &reader,
+    uint32_t count)
+{
+	if (reader.getEntryCount() != count) {
+		std::cout << "FAIL (" << reader.getEntryCount() << " entries)"
+		    << std::endl;
+		return (false);
+	}
+
+	bool success = true;
+	for (const auto &range : reader.partition(7)) {
+		reader.forEachEntry(range.first, range.second,
+		    [&](uint32_t number, const std::string &entry) {
+			if (entry.find(entryFor(number)) == std::string::npos)
+				success = false;
+		});
+	}
+	if (!success || (reader.getEntry(count, false).find("E ") != 0)) {
+		std::cout << "FAIL (entries differ)" << std::endl;
+		return (false);
+	}
+	return (true);
+}
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	const std::string indexPathname =
+	    BE::IO::FileLogsheetReader::getIndexPathname(pathname);
+	unlink(pathname.c_str());
+	unlink(indexPathname.c_str());
+
+	int rv = EXIT_SUCCESS;
+	try {
+		std::cout << "Write " << numEntries << " indexed entries: ";
+		{
+			BE::IO::FileLogsheet sheet(pathname, "Indexed sheet");
+			sheet.setIndexing(true);
+			writeEntries(sheet, 1, numEntries);
+		}
+		if (BE::IO::Utility::getFileSize(indexPathname) !=
+		    (numEntries + 1) * sizeof(uint64_t))
+			throw BE::Error::StrategyError("Index is wrong size");
+		std::cout << "success." << std::endl;
+
+		std::cout << "Read entries by number: ";
+		{
+			BE::IO::FileLogsheetReader reader(pathname,
+			    BE::IO::FileLogsheetReader::IndexMode::ReadOnly);
+			if (checkEntries(reader, numEntries))
+				std::cout << "success." << std::endl;
+			else
+				rv = EXIT_FAILURE;
+		}
+
+		std::cout << "Reopen and append without indexing: ";
+		{
+			BE::IO::FileLogsheet sheet(pathname);
+			if (sheet.getCurrentEntryNumber() != numEntries + 1)
+				throw BE::Error::StrategyError("Wrong entry "
+				    "number on open");
+			writeEntries(sheet, numEntries + 1, 2 * numEntries);
+		}
+		std::cout << "success." << std::endl;
+
+		std::cout << "Extend index from the log: ";
+		{
+			BE::IO::FileLogsheetReader reader(pathname);
+			if (checkEntries(reader, 2 * numEntries))
+				std::cout << "success." << std::endl;
+			else
+				rv = EXIT_FAILURE;
+		}
+
+		std::cout << "Repair index naming unwritten entries: ";
+		{
+			std::ofstream index(indexPathname, std::ios_base::app |
+			    std::ios_base::binary);
+			const uint64_t bogus[] = {1ULL << 40, 1ULL << 41};
+			index.write((const char *)bogus, sizeof(bogus));
+		}
+		{
+			BE::IO::FileLogsheetReader reader(pathname);
+			if (checkEntries(reader, 2 * numEntries) &&
+			    (BE::IO::Utility::getFileSize(indexPathname) ==
+			    (2 * numEntries + 1) * sizeof(uint64_t)))
+				std::cout << "success." << std::endl;
+			else
+				rv = EXIT_FAILURE;
+		}
+
+		std::cout << "Read without index: ";
+		{
+			BE::IO::FileLogsheetReader reader(pathname,
+			    BE::IO::FileLogsheetReader::IndexMode::None);
+			if (checkEntries(reader, 2 * numEntries))
+				std::cout << "success." << std::endl;
+			else
+				rv = EXIT_FAILURE;
+		}
+	} catch (BE::Error::Exception &e) {
+		std::cout << "FAIL (" << e.whatString() << ")" << std::endl;
+		rv = EXIT_FAILURE;
+	}
+
+	unlink(pathname.c_str());
+	unlink(indexPathname.c_str());
+	return (rv);
+}
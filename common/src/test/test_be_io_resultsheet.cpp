@@ -0,0 +1,241 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include <be_error_exception.h>
+#include <be_io_resultsheet.h>
+
+namespace BE = BiometricEvaluation;
+
+static const uint32_t numRows = 100000;
+static const uint32_t rowsPerBlock = 4096;
+
+static const std::vector<BE::IO::ResultSheet::Column> schema = {
+	{"probe", BE::IO::ResultSheet::Type::String},
+	{"gallery", BE::IO::ResultSheet::Type::String},
+	{"score", BE::IO::ResultSheet::Type::Real},
+	{"rank", BE::IO::ResultSheet::Type::Integer}
+};
+
+static void
+writeSheet(
+    const std::string &pathname,
+    bool compress)
+{
+	BE::IO::ResultSheet sheet(pathname, schema, "Comparison scores",
+	    rowsPerBlock, compress);
+	for (uint32_t i = 0; i < numRows; i++) {
+		sheet.appendString("probe" + std::to_string(i / 100));
+		sheet.appendString("gallery" + std::to_string(i % 100));
+		sheet.appendReal(i / 1000.0);
+		sheet.appendInteger(-(int64_t)i);
+		sheet.endRow();
+	}
+	/* Destructor writes the final partial block */
+}
+
+static bool
+readSheet(
+    const std::string &pathname)
+{
+	BE::IO::ResultSheet sheet(pathname);
+	if ((sheet.getRowCount() != numRows) ||
+	    (sheet.getDescription() != "Comparison scores") ||
+	    (sheet.getSchema().size() != schema.size())) {
+		std::cout << "FAIL (header)" << std::endl;
+		return (false);
+	}
+
+	const uint32_t probe = sheet.getColumnIndex("probe");
+	const uint32_t gallery = sheet.getColumnIndex("gallery");
+	const uint32_t score = sheet.getColumnIndex("score");
+	const uint32_t rank = sheet.getColumnIndex("rank");
+	uint64_t row = 0;
+	for (uint64_t b = 0; b < sheet.getBlockCount(); b++) {
+		const double *scores = sheet.getRealColumn(b, score);
+		const int64_t *ranks = sheet.getIntegerColumn(b, rank);
+		const auto probes = sheet.getStringColumn(b, probe);
+		const auto galleries = sheet.getStringColumn(b, gallery);
+		for (uint64_t i = 0; i < sheet.getBlockRowCount(b); i++, row++) {
+			if ((scores[i] != row / 1000.0) ||
+			    (ranks[i] != -(int64_t)row) ||
+			    (probes[i] != "probe" + std::to_string(row / 100)) ||
+			    (galleries[i] != "gallery" +
+			    std::to_string(row % 100))) {
+				std::cout << "FAIL (row " << row << ")" <<
+				    std::endl;
+				return (false);
+			}
+		}
+	}
+	if (row != numRows) {
+		std::cout << "FAIL (read " << row << " rows)" << std::endl;
+		return (false);
+	}
+	return (true);
+}
+
+/*
+ * Write a 4-row sheet to pathname, replacing the 64-bit value at
+ * offset within its first block with value.
+ */
+static void
+writeCorruptSheet(
+    const std::string &pathname,
+    uint64_t offset,
+    uint64_t value)
+{
+	{
+		BE::IO::ResultSheet sheet(pathname, schema);
+		for (uint32_t i = 0; i < 4; i++) {
+			sheet.appendString("probe");
+			sheet.appendString("gallery");
+			sheet.appendReal(i);
+			sheet.appendInteger(i);
+			sheet.endRow();
+		}
+	}
+
+	std::ifstream in(pathname, std::ios::binary);
+	std::string contents((std::istreambuf_iterator<char>(in)),
+	    std::istreambuf_iterator<char>());
+	in.close();
+	/* Block magic, as written on a little-endian host */
+	const std::string::size_type block = contents.find("1KLB");
+	memcpy(&contents[block + offset], &value, sizeof(value));
+	std::ofstream out(pathname, std::ios::binary | std::ios::trunc);
+	out.write(contents.data(), contents.size());
+}
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	const std::string pathname = "test_resultsheet.dat";
+	const std::string compressedPathname = "test_resultsheet_gz.dat";
+	unlink(pathname.c_str());
+	unlink(compressedPathname.c_str());
+
+	int rv = EXIT_SUCCESS;
+	try {
+		std::cout << "Write " << numRows << " rows: ";
+		writeSheet(pathname, false);
+		std::cout << "success." << std::endl;
+		std::cout << "Read columns: ";
+		if (readSheet(pathname))
+			std::cout << "success." << std::endl;
+		else
+			rv = EXIT_FAILURE;
+
+		std::cout << "Write " << numRows << " compressed rows: ";
+		writeSheet(compressedPathname, true);
+		std::cout << "success." << std::endl;
+		std::cout << "Read compressed columns: ";
+		if (readSheet(compressedPathname))
+			std::cout << "success." << std::endl;
+		else
+			rv = EXIT_FAILURE;
+
+		std::cout << "Append value of wrong type: ";
+		try {
+			BE::IO::ResultSheet sheet(pathname + ".tmp", schema);
+			sheet.appendReal(0.0);
+			std::cout << "FAIL (no exception)" << std::endl;
+			rv = EXIT_FAILURE;
+		} catch (BE::Error::ParameterError &e) {
+			std::cout << "success (" << e.whatString() << ")." <<
+			    std::endl;
+		}
+		unlink((pathname + ".tmp").c_str());
+
+		std::cout << "Open sheet with incomplete final block: ";
+		{
+			const std::string truncatedPathname = pathname +
+			    ".truncated";
+			std::ifstream in(pathname, std::ios::binary);
+			const std::string contents((std::istreambuf_iterator<
+			    char>(in)), std::istreambuf_iterator<char>());
+			std::ofstream out(truncatedPathname, std::ios::binary |
+			    std::ios::trunc);
+			out.write(contents.data(), contents.size() - 8);
+			out.close();
+
+			/* Only the final, partial block is lost */
+			BE::IO::ResultSheet sheet(truncatedPathname);
+			const uint64_t completeBlocks = numRows / rowsPerBlock;
+			if ((sheet.getBlockCount() == completeBlocks) &&
+			    (sheet.getRowCount() == completeBlocks *
+			    rowsPerBlock) && (sheet.getIntegerColumn(
+			    completeBlocks - 1, sheet.getColumnIndex("rank"))[
+			    rowsPerBlock - 1] == -(int64_t)((completeBlocks *
+			    rowsPerBlock) - 1)))
+				std::cout << "success." << std::endl;
+			else {
+				std::cout << "FAIL (read " <<
+				    sheet.getRowCount() << " rows)" <<
+				    std::endl;
+				rv = EXIT_FAILURE;
+			}
+			unlink(truncatedPathname.c_str());
+		}
+
+		const std::string corruptPathname = pathname + ".corrupt";
+		std::cout << "Open sheet with empty block: ";
+		unlink(corruptPathname.c_str());
+		try {
+			/* BlockHeader::blockSize */
+			writeCorruptSheet(corruptPathname, 8, 0);
+			BE::IO::ResultSheet sheet(corruptPathname);
+			std::cout << "FAIL (no exception)" << std::endl;
+			rv = EXIT_FAILURE;
+		} catch (BE::Error::DataError &e) {
+			std::cout << "success." << std::endl;
+		}
+		unlink(corruptPathname.c_str());
+
+		std::cout << "Read column outside its block: ";
+		try {
+			/* ChunkEntry::offset of the first column */
+			writeCorruptSheet(corruptPathname, 16, 1 << 20);
+			BE::IO::ResultSheet sheet(corruptPathname);
+			sheet.getStringColumn(0, 0);
+			std::cout << "FAIL (no exception)" << std::endl;
+			rv = EXIT_FAILURE;
+		} catch (BE::Error::DataError &e) {
+			std::cout << "success." << std::endl;
+		}
+		unlink(corruptPathname.c_str());
+
+		std::cout << "Create existing sheet: ";
+		try {
+			BE::IO::ResultSheet sheet(pathname, schema);
+			std::cout << "FAIL (no exception)" << std::endl;
+			rv = EXIT_FAILURE;
+		} catch (BE::Error::ObjectExists &e) {
+			std::cout << "success." << std::endl;
+		}
+	} catch (BE::Error::Exception &e) {
+		std::cout << "FAIL (" << e.whatString() << ")" << std::endl;
+		rv = EXIT_FAILURE;
+	}
+
+	unlink(pathname.c_str());
+	unlink(compressedPathname.c_str());
+	return (rv);
+}
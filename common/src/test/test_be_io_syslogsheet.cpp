@@ -8,10 +8,17 @@
  * about its quality, reliability, or any other characteristic.
  */
 
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <stdlib.h>
+#include <vector>
 
 #include <be_error_exception.h>
 #include <be_io_syslogsheet.h>
@@ -53,11 +60,125 @@ doLogSheetTests(BE::IO::Logsheet &ls)
 	return (0);
 }
 
+/* Collects datagrams from a socket until one ends with "END" */
+struct Collector {
+	int sockFD;
+	std::vector<std::string> messages;
+	pthread_t thread;
+};
+
+static void *
+collect(void *ptr)
+{
+	Collector *collector = static_cast<Collector *>(ptr);
+	char buf[4096];
+	while (true) {
+		ssize_t sz = recv(collector->sockFD, buf, sizeof(buf), 0);
+		if (sz < 0)
+			break;
+		collector->messages.push_back(std::string(buf, sz));
+		if (collector->messages.back().rfind("END") == (size_t)sz - 3)
+			break;
+	}
+	return (nullptr);
+}
+
+/* Send to a local Unix-domain collector, which needs no server */
+static int
+doDatagramTests()
+{
+	static const uint32_t EntryCount = 1000;
+	const std::string path = "/tmp/test_be_io_syslogsheet." +
+	    std::to_string(getpid());
+	Collector collector;
+	collector.sockFD = socket(AF_UNIX, SOCK_DGRAM, 0);
+	struct sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	std::strcpy(addr.sun_path, path.c_str());
+	if ((collector.sockFD == -1) || (bind(collector.sockFD,
+	    (struct sockaddr *)&addr, sizeof(addr)) != 0)) {
+		std::cout << "Could not create collector socket" << std::endl;
+		return (-1);
+	}
+
+	int status = 0;
+	try {
+		std::cout << "Creating Unix-domain SysLogsheet: ";
+		BE::IO::SysLogsheet ls(BE::IO::Logsheet::SYSLOGURLSCHEME +
+		    "://" + path, "Datagram Log Sheet", "test_be_io_syslogsheet",
+		    "test.host.name", true, true);
+		if (ls.getTransport() != BE::IO::SysLogsheet::Transport::Unix)
+			throw BE::Error::StrategyError("wrong transport");
+		std::cout << "success." << std::endl;
+
+		std::cout << "Sending " << EntryCount << " asynchronous "
+		    "entries: ";
+		pthread_create(&collector.thread, nullptr, collect, &collector);
+		ls << "First line" << std::endl << "Second line";
+		ls.newEntry();
+		ls.setAsynchronous(true);
+		for (uint32_t i = 0; i < EntryCount; i++) {
+			ls << "Asynchronous entry " << i;
+			ls.newEntry();
+		}
+		ls.writeComment("END");
+		ls.sync();
+		pthread_join(collector.thread, nullptr);
+		if ((collector.messages.size() != EntryCount + 3) ||
+		    (ls.getSentCount() != EntryCount + 3) ||
+		    (ls.getDroppedCount() != 0))
+			throw BE::Error::StrategyError(std::to_string(
+			    collector.messages.size()) + " messages received");
+		if ((collector.messages[0].find("E 0000000001 First line") ==
+		    std::string::npos) || (collector.messages[1].find(
+		    "E 0000000001 Second line") == std::string::npos) ||
+		    (collector.messages[EntryCount + 1].find("Asynchronous "
+		    "entry " + std::to_string(EntryCount - 1)) ==
+		    std::string::npos))
+			throw BE::Error::StrategyError("messages differ");
+		std::cout << "success." << std::endl;
+
+		std::cout << "Dropping entries from a full queue: ";
+		collector.messages.clear();
+		pthread_create(&collector.thread, nullptr, collect, &collector);
+		ls.setAsynchronous(true, 256,
+		    BE::IO::SysLogsheet::OverflowPolicy::Drop);
+		for (uint32_t i = 0; i < EntryCount; i++) {
+			ls << "Entry that may be dropped " << i;
+			ls.newEntry();
+		}
+		ls.setAsynchronous(false);
+		ls.writeComment("END");
+		pthread_join(collector.thread, nullptr);
+		const uint64_t sent = ls.getSentCount() - (EntryCount + 3);
+		if ((sent + ls.getDroppedCount() != EntryCount + 1) ||
+		    (collector.messages.size() != sent))
+			throw BE::Error::StrategyError(std::to_string(sent) +
+			    " sent, " + std::to_string(ls.getDroppedCount()) +
+			    " dropped, " + std::to_string(
+			    collector.messages.size()) + " received");
+		std::cout << "success (" << ls.getDroppedCount() <<
+		    " dropped)." << std::endl;
+	} catch (BE::Error::Exception &e) {
+		std::cout << "failed (" << e.whatString() << ")." << std::endl;
+		status = -1;
+	}
+
+	close(collector.sockFD);
+	unlink(path.c_str());
+	return (status);
+}
+
 int
 main(int argc, char* argv[])
 {
 	int status = EXIT_SUCCESS;
 
+	if (doDatagramTests() != 0)
+		return (EXIT_FAILURE);
+	std::cout << std::endl;
+
 	/* Call the constructor that will create a new LogSheet. */
 	std::string url(BE::IO::Logsheet::SYSLOGURLSCHEME + "://localhost:2514");
 	std::string description("Test Log Sheet");
@@ -0,0 +1,276 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <be_finger_an2kview_fixedres.h>
+#include <be_image_netpbm.h>
+#include <be_io_archiverecstore.h>
+#include <be_io_logsheet.h>
+#include <be_memory_accounting.h>
+#include <be_memory_autoarray.h>
+#include <be_process_statistics.h>
+
+using namespace BiometricEvaluation;
+using namespace std;
+
+/* Bytes currently charged to a tag */
+static uint64_t
+current(
+    Memory::AllocationTag tag)
+{
+	return (Memory::getAllocationCounters(tag).current);
+}
+
+/* Logsheet that keeps what is written to it */
+class MemoryLogsheet : public IO::Logsheet
+{
+public:
+	void
+	write(
+	    const std::string &entry)
+	{
+		entries.push_back(entry);
+	}
+
+	void
+	writeComment(
+	    const std::string &entry)
+	{
+		comments.push_back(entry);
+	}
+
+	std::vector<std::string> entries;
+	std::vector<std::string> comments;
+};
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	bool success = true;
+
+	cout << "Allocations are not counted while disabled: ";
+	const uint64_t before = current(Memory::AllocationTag::AutoArray);
+	{
+		Memory::uint8Array untracked(1024);
+		if (current(Memory::AllocationTag::AutoArray) == before)
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	}
+
+	Memory::setAccountingEnabled(true);
+	cout << "AutoArray is charged to the AutoArray tag: ";
+	{
+		Memory::uint8Array tracked(1024);
+		if (current(Memory::AllocationTag::AutoArray) ==
+		    before + 1024)
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	}
+	if (current(Memory::AllocationTag::AutoArray) != before) {
+		cout << "AutoArray was not released." << endl;
+		success = false;
+	}
+
+	cout << "Scoped tag is kept by arrays leaving the scope: ";
+	const uint64_t decodeBefore = current(
+	    Memory::AllocationTag::ImageDecode);
+	Memory::uint8Array decoded;
+	{
+		Memory::ScopedAllocationTag tag(
+		    Memory::AllocationTag::ImageDecode);
+		decoded = Memory::uint8Array(4096);
+	}
+	if ((current(Memory::AllocationTag::ImageDecode) ==
+	    decodeBefore + 4096) &&
+	    (Memory::getAllocationTag() == Memory::AllocationTag::AutoArray))
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Charge is released after accounting is disabled: ";
+	Memory::setAccountingEnabled(false);
+	decoded = Memory::uint8Array();
+	if (current(Memory::AllocationTag::ImageDecode) == decodeBefore)
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Resized arrays are recharged: ";
+	Memory::setAccountingEnabled(true);
+	{
+		Memory::uint8Array growing(100);
+		growing.resize(10000);
+		if (current(Memory::AllocationTag::AutoArray) ==
+		    before + 10000)
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	}
+
+	cout << "Peak is kept and can be reset: ";
+	const Memory::AllocationCounters counters =
+	    Memory::getAllocationCounters(Memory::AllocationTag::AutoArray);
+	Memory::resetAllocationPeaks();
+	if ((counters.peak >= before + 10000) &&
+	    (counters.allocations == counters.deallocations) &&
+	    (Memory::getAllocationCounters(
+	    Memory::AllocationTag::AutoArray).peak == before))
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "AccountingResource wraps another resource: ";
+	{
+		Memory::PoolResource pool;
+		Memory::AccountingResource cache(
+		    Memory::AllocationTag::RecordStoreCache, &pool);
+		Memory::uint8Array pooled(512, &cache);
+		if (current(Memory::AllocationTag::RecordStoreCache) >= 512)
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	}
+	if (current(Memory::AllocationTag::RecordStoreCache) != 0) {
+		cout << "AccountingResource was not released." << endl;
+		success = false;
+	}
+
+	cout << "AN2K view is charged to the AN2KTree tag: ";
+	const uint64_t an2kBefore = current(Memory::AllocationTag::AN2KTree);
+	try {
+		uint64_t held;
+		{
+			Finger::AN2KViewFixedResolution an2kv(
+			    "test_data/type4-slaps.an2k",
+			    View::AN2KView::RecordType::Type_4, 1);
+			held = current(Memory::AllocationTag::AN2KTree);
+		}
+		if ((held > an2kBefore) &&
+		    (current(Memory::AllocationTag::AN2KTree) == an2kBefore))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "ArchiveRecordStore manifest is charged: ";
+	const std::string rsName = "test_be_memory_accounting_rs";
+	const uint64_t manifestBefore = current(
+	    Memory::AllocationTag::RecordStoreManifest);
+	try {
+		uint64_t held;
+		{
+			IO::ArchiveRecordStore rs(rsName, "Accounting");
+			const Memory::uint8Array record(16);
+			for (int i = 0; i < 100; i++)
+				rs.insert(std::to_string(i), record);
+			held = current(
+			    Memory::AllocationTag::RecordStoreManifest);
+		}
+		if ((held > manifestBefore) && (current(
+		    Memory::AllocationTag::RecordStoreManifest) ==
+		    manifestBefore))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+		IO::RecordStore::removeRecordStore(rsName);
+	} catch (Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Decoded image is charged to the ImageDecode tag: ";
+	const uint64_t imageBefore = current(
+	    Memory::AllocationTag::ImageDecode);
+	try {
+		const std::string header = "P5 8 4 255\n";
+		Memory::uint8Array pgm(header.size() + 32);
+		std::copy(header.begin(), header.end(), pgm.begin());
+		Image::NetPBM image(pgm);
+		uint64_t held;
+		{
+			const Memory::uint8Array raw = image.getRawData();
+			held = current(Memory::AllocationTag::ImageDecode);
+		}
+		if ((held == imageBefore + 32) && (current(
+		    Memory::AllocationTag::ImageDecode) == imageBefore))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Statistics logs a column for every tag: ";
+	try {
+		std::shared_ptr<MemoryLogsheet> sheet(new MemoryLogsheet());
+		Process::Statistics stats(sheet);
+		stats.logStats();
+		stats.logStats();
+		const std::string::size_type entryColumns = std::count(
+		    sheet->entries.front().begin(),
+		    sheet->entries.front().end(), ' ') + 1;
+		/* Header, then the allocation columns once */
+		if ((sheet->comments.size() == 2) &&
+		    (sheet->comments.back().find(to_string(
+		    Memory::AllocationTag::AN2KTree)) != std::string::npos) &&
+		    (sheet->entries.size() == 2) &&
+		    (entryColumns == 8 + Memory::getAllocationCounters().size()))
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	} catch (Error::Exception &e) {
+		cout << "FAILED (" << e.whatString() << ")." << endl;
+		success = false;
+	}
+
+	cout << "Counters for every tag:" << endl;
+	for (const auto &tag : Memory::getAllocationCounters())
+		cout << "\t" << to_string(tag.first) << ": " <<
+		    tag.second.current << " bytes current, " <<
+		    tag.second.peak << " peak" << endl;
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
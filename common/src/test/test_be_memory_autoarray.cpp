@@ -182,6 +182,130 @@ testComparisons()
 	}
 }
 
+void
+testResources()
+{
+	/* Recycle one large buffer through a pool */
+	Memory::PoolResource pool;
+	const uint8_t *first = nullptr;
+	for (int i = 0; i < 10; i++) {
+		Memory::uint8Array aa(3 * 1024 * 1024 + i, &pool);
+		if (first == nullptr)
+			first = aa;
+		else if (first != (const uint8_t *)aa) {
+			std::cout << "FAIL (pool did not reuse)" << std::endl;
+			return;
+		}
+	}
+	if ((pool.getReuseCount() != 9) ||
+	    (pool.getRetainedSize() != 4 * 1024 * 1024)) {
+		std::cout << "FAIL (pool counts)" << std::endl;
+		return;
+	}
+
+	/* The default resource is used by nested allocations */
+	Memory::ArenaResource arena(1024);
+	{
+		Memory::ScopedDefaultResource scope(&arena);
+		Memory::AutoArray<std::string> strings(10);
+		strings[9] = "Allocated from an arena";
+		strings.resize(100);
+		Memory::uint32Array values{1, 2, 3};
+		if ((strings.getResource() != &arena) ||
+		    (values.getResource() != &arena) ||
+		    (strings[9] != "Allocated from an arena") ||
+		    (arena.getAllocatedSize() < (110 * sizeof(std::string)))) {
+			std::cout << "FAIL (arena)" << std::endl;
+			return;
+		}
+	}
+	if (Memory::getDefaultResource() != Memory::getNewDeleteResource()) {
+		std::cout << "FAIL (default not restored)" << std::endl;
+		return;
+	}
+	arena.reset();
+	if (arena.getAllocatedSize() != 0) {
+		std::cout << "FAIL (arena reset)" << std::endl;
+		return;
+	}
+
+	/* Moving exchanges resources along with storage */
+	Memory::uint8Array pooled(64, &pool);
+	Memory::uint8Array heap(64);
+	heap = std::move(pooled);
+	if ((heap.getResource() != &pool) ||
+	    (pooled.getResource() != Memory::getNewDeleteResource())) {
+		std::cout << "FAIL (move)" << std::endl;
+		return;
+	}
+	std::cout << "PASS" << std::endl;
+}
+
+void
+testGrowth()
+{
+	/* Appends grow geometrically */
+	Memory::uint32Array aa;
+	uint32_t reallocations = 0;
+	for (uint32_t i = 0; i < 100000; i++) {
+		const Memory::uint32Array::size_type capacity = aa.capacity();
+		aa.push_back(i);
+		if (aa.capacity() != capacity)
+			reallocations++;
+	}
+	const uint32_t more[] = {100000, 100001, 100002};
+	aa.append(more, 3);
+	aa.append(&aa[0], 2);
+	if ((aa.size() != 100005) || (reallocations > 20) ||
+	    (aa[99999] != 99999) || (aa[100002] != 100002) ||
+	    (aa[100004] != 1)) {
+		std::cout << "FAIL (append)" << std::endl;
+		return;
+	}
+
+	/* reserve() keeps size; resize_uninitialized() keeps contents */
+	Memory::uint8Array bytes{1, 2, 3};
+	bytes.reserve(1024);
+	if ((bytes.size() != 3) || (bytes.capacity() < 1024)) {
+		std::cout << "FAIL (reserve)" << std::endl;
+		return;
+	}
+	bytes.resize_uninitialized(2048);
+	if ((bytes.size() != 2048) || (bytes[2] != 3)) {
+		std::cout << "FAIL (resize_uninitialized)" << std::endl;
+		return;
+	}
+
+	/* Alignment survives growth */
+	bytes.setAlignment(Memory::CacheLineAlignment);
+	if (((uintptr_t)&bytes[0] % Memory::CacheLineAlignment) != 0 ||
+	    (bytes[0] != 1)) {
+		std::cout << "FAIL (alignment)" << std::endl;
+		return;
+	}
+	bytes.resize(1024 * 1024);
+	Memory::uint8Array page;
+	page.setAlignment(Memory::getPageSize());
+	page.resize(1);
+	if (((uintptr_t)&bytes[0] % Memory::CacheLineAlignment) != 0 ||
+	    ((uintptr_t)&page[0] % Memory::getPageSize()) != 0 ||
+	    (bytes[2] != 3)) {
+		std::cout << "FAIL (alignment after resize)" << std::endl;
+		return;
+	}
+
+	/* Growth within a pool size class stays in place */
+	Memory::PoolResource pool;
+	Memory::uint8Array pooled(1000, &pool);
+	const uint8_t *before = pooled;
+	pooled.resize(1024);
+	if (before != (const uint8_t *)pooled) {
+		std::cout << "FAIL (pool growth)" << std::endl;
+		return;
+	}
+	std::cout << "PASS" << std::endl;
+}
+
 static void
 testAndPrintContents(const Memory::uint8Array &aa, size_t size)
 {
@@ -330,6 +454,12 @@ int main (int argc, char* argv[]) {
 	std::cout << "Comparison: ";
 	testComparisons();
 
+	std::cout << "Memory resources: ";
+	testResources();
+
+	std::cout << "Growth and alignment: ";
+	testGrowth();
+
 	return (0);
 }
 
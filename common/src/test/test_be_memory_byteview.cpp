@@ -0,0 +1,137 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <be_error_exception.h>
+#include <be_memory_byteview.h>
+
+using namespace BiometricEvaluation;
+using namespace std;
+
+/* Sum the bytes of a view, to show implicit conversions at a call site */
+static uint64_t
+sum(
+    const Memory::ByteView &view)
+{
+	uint64_t total = 0;
+	for (const uint8_t &byte : view)
+		total += byte;
+	return (total);
+}
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	bool success = true;
+
+	uint8_t carr[26];
+	for (uint8_t i = 0; i < 26; i++)
+		carr[i] = 'a' + i;
+
+	cout << "Viewing unmanaged memory: ";
+	Memory::ByteView view(carr, sizeof(carr));
+	if ((view.data() == carr) && (view.size() == 26) && (view[25] == 'z'))
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Viewing a uint8Array without a copy: ";
+	Memory::uint8Array aa(8);
+	for (uint8_t i = 0; i < aa.size(); i++)
+		aa[i] = i + 1;
+	Memory::ByteView aaView(aa);
+	if ((aaView.data() == &aa[0]) && (aaView.size() == aa.size()) &&
+	    (sum(aa) == 36))
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Viewing a vector without a copy: ";
+	std::vector<uint8_t> v{10, 20, 30};
+	if ((Memory::ByteView(v).data() == v.data()) && (sum(Memory::ByteView(v)) == 60))
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Empty view: ";
+	Memory::ByteView empty;
+	if (empty.empty() && (empty.begin() == empty.end()) &&
+	    (empty.to_array().size() == 0))
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Subviews: ";
+	Memory::ByteView middle = view.subview(10, 6);
+	Memory::ByteView tail = view.subview(20);
+	if ((middle.data() == carr + 10) && (middle.size() == 6) &&
+	    (middle[0] == 'k') && (tail.size() == 6) && (tail[5] == 'z') &&
+	    view.subview(26).empty())
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	cout << "Subview past the end: ";
+	try {
+		view.subview(20, 7);
+		cout << "FAILED (no exception)." << endl;
+		success = false;
+	} catch (Error::ParameterError &e) {
+		cout << "success (" << e.whatString() << ")." << endl;
+	}
+	try {
+		view.subview(27);
+		cout << "Subview beyond the end: FAILED (no exception)." << endl;
+		success = false;
+	} catch (Error::ParameterError &e) {
+		cout << "Subview beyond the end: success." << endl;
+	}
+
+	cout << "Checked access: ";
+	try {
+		(void)view.at(26);
+		cout << "FAILED (no exception)." << endl;
+		success = false;
+	} catch (Error::ParameterError &e) {
+		if (view.at(0) == 'a')
+			cout << "success." << endl;
+		else {
+			cout << "FAILED." << endl;
+			success = false;
+		}
+	}
+
+	cout << "Copying a view: ";
+	Memory::uint8Array copy = middle.to_array();
+	if ((copy.size() == 6) && (&copy[0] != middle.data()) &&
+	    (copy[0] == 'k') && (copy[5] == 'p'))
+		cout << "success." << endl;
+	else {
+		cout << "FAILED." << endl;
+		success = false;
+	}
+
+	return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
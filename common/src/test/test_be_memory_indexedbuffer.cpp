@@ -110,6 +110,105 @@ main (int argc, char* argv[])
 		cerr << "Caught " << e.what() << endl;
 	}
 
+	/* Odd counts exercise both the vector and scalar decoding paths */
+	cout << "Bulk scanning: " << endl;
+	Memory::uint8Array bulk(100);
+	for (i = 0; i < bulk.size(); i++)
+		bulk[i] = i;
+	try {
+		Memory::IndexedBuffer bulkBuf(bulk);
+		uint16_t u16[23];
+		bulkBuf.scanBeU16Vals(u16, 23);
+		for (i = 0; i < 23; i++) {
+			if (u16[i] != (((2 * i) << 8) | (2 * i + 1))) {
+				cout << "scanBeU16Vals() value " << i <<
+				    " is wrong" << endl;
+				return (EXIT_FAILURE);
+			}
+		}
+
+		bulkBuf.setIndex(0);
+		uint32_t u32[13];
+		bulkBuf.scanBeU32Vals(u32, 13);
+		for (i = 0; i < 13; i++) {
+			if (u32[i] != (uint32_t)(((4 * i) << 24) |
+			    ((4 * i + 1) << 16) | ((4 * i + 2) << 8) |
+			    (4 * i + 3))) {
+				cout << "scanBeU32Vals() value " << i <<
+				    " is wrong" << endl;
+				return (EXIT_FAILURE);
+			}
+		}
+
+		/* Host order values match the scalar scans */
+		bulkBuf.setIndex(2);
+		bulkBuf.scanU16Vals(u16, 11);
+		bulkBuf.setIndex(2);
+		for (i = 0; i < 11; i++) {
+			if (u16[i] != bulkBuf.scanU16Val()) {
+				cout << "scanU16Vals() value " << i <<
+				    " is wrong" << endl;
+				return (EXIT_FAILURE);
+			}
+		}
+		bulkBuf.setIndex(4);
+		bulkBuf.scanU32Vals(u32, 7);
+		bulkBuf.setIndex(4);
+		for (i = 0; i < 7; i++) {
+			if (u32[i] != bulkBuf.scanU32Val()) {
+				cout << "scanU32Vals() value " << i <<
+				    " is wrong" << endl;
+				return (EXIT_FAILURE);
+			}
+		}
+
+		/* Views refer to the buffer and advance the index */
+		bulkBuf.setIndex(10);
+		Memory::ByteView view = bulkBuf.scanView(20);
+		if ((view.data() != bulk + 10) || (view.size() != 20) ||
+		    (bulkBuf.getIndex() != 30)) {
+			cout << "scanView() is wrong" << endl;
+			return (EXIT_FAILURE);
+		}
+		view = bulkBuf.scanView(0);
+		if ((view.size() != 0) || (bulkBuf.getIndex() != 30)) {
+			cout << "scanView(0) is wrong" << endl;
+			return (EXIT_FAILURE);
+		}
+		Memory::IndexedBuffer viewBuf(Memory::ByteView(bulk + 10, 4));
+		if (viewBuf.scanBeU32Val() != 0x0a0b0c0d) {
+			cout << "IndexedBuffer(ByteView) is wrong" << endl;
+			return (EXIT_FAILURE);
+		}
+	} catch (Error::DataError &e) {
+		cout << "Caught " << e.what() << endl;
+		return (EXIT_FAILURE);
+	}
+	cout << "Success." << endl;
+
+	cout << "Attempt to bulk read off end of buffer: ";
+	Memory::IndexedBuffer shortBuf(bulk);
+	shortBuf.setIndex(96);
+	uint16_t overrun[3];
+	try {
+		shortBuf.scanBeU16Vals(overrun, 3);
+		cout << "Failure." << endl;
+		return (EXIT_FAILURE);
+	} catch (Error::DataError) {
+		/* Nothing is consumed by a failed scan */
+		if (shortBuf.getIndex() != 96) {
+			cout << "Failure (index moved)." << endl;
+			return (EXIT_FAILURE);
+		}
+	}
+	try {
+		shortBuf.scanView(5);
+		cout << "Failure." << endl;
+		return (EXIT_FAILURE);
+	} catch (Error::DataError) {
+		cout << "Success." << endl;
+	}
+
 	bool success = false;
 	cout << "Attempt to read off end of buffer: ";
 	try {
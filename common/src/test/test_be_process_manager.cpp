@@ -219,6 +219,69 @@ public:
 	QuickWorker(){}
 };
 
+#if defined FORKTEST
+/** Set only in the zygote, and so inherited only by its Workers */
+static bool zygoteInitialized = false;
+
+/** A Worker that succeeds only if forked from an initialized zygote */
+class ZygoteWorker : public Process::Worker
+{
+public:
+	int32_t
+	workerMain()
+	{
+		return (zygoteInitialized ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+};
+
+/** A Worker whose child outlives it, and so is adopted by the Manager */
+class OrphaningWorker : public Process::Worker
+{
+public:
+	int32_t
+	workerMain()
+	{
+		if (fork() == 0) {
+			usleep(100000);
+			_exit(EXIT_SUCCESS);
+		}
+		return (EXIT_SUCCESS);
+	}
+};
+
+/** A Worker that outlives the child of an OrphaningWorker */
+class SleepingWorker : public Process::Worker
+{
+public:
+	int32_t
+	workerMain()
+	{
+		usleep(500000);
+		return (EXIT_SUCCESS);
+	}
+};
+
+/** A Worker that runs until asked to stop */
+class StoppableWorker : public Process::Worker
+{
+public:
+	int32_t
+	workerMain()
+	{
+		while (!this->stopRequested())
+			usleep(10000);
+		return (EXIT_SUCCESS);
+	}
+};
+
+/** A Worker that always fails */
+class FailingWorker : public Process::Worker
+{
+public:
+	int32_t workerMain() { return (EXIT_FAILURE); }
+};
+#endif
+
 
 int
 main(
@@ -379,6 +442,91 @@ main(
 	quickMgr->addWorker(std::shared_ptr<QuickWorker>(new QuickWorker()));
 	quickMgr->addWorker(std::shared_ptr<QuickWorker>(new QuickWorker()));
 	quickMgr->startWorkers();
+
+#if defined FORKTEST
+	static const uint32_t respawnLimit = 2;
+	cout << ">> Testing respawn of failing Worker...";
+	Process::ForkManager respawnMgr;
+	std::shared_ptr<Process::WorkerController> failing =
+	    respawnMgr.addWorker(std::make_shared<FailingWorker>());
+	respawnMgr.setRespawnLimit(respawnLimit);
+	respawnMgr.startWorkers();
+	if (respawnMgr.getRespawnCount(failing) == respawnLimit)
+		cout << "respawned " << respawnLimit << " times (success)" <<
+		    endl;
+	else
+		cout << "respawned " << respawnMgr.getRespawnCount(failing) <<
+		    " times (FAIL)" << endl;
+
+	cout << ">> Testing Workers forked from zygote...";
+	Process::ForkManager zygoteMgr;
+	std::shared_ptr<Process::WorkerController> zygoteWorkers[numWorkers];
+	for (uint32_t i = 0; i < numWorkers; i++)
+		zygoteWorkers[i] = zygoteMgr.addWorker(
+		    std::make_shared<ZygoteWorker>());
+	try {
+		zygoteMgr.enableZygote([]() { zygoteInitialized = true; });
+		zygoteMgr.startWorkers();
+		bool success = true;
+		for (uint32_t i = 0; i < numWorkers; i++)
+			if (zygoteWorkers[i]->getExitStatus() != EXIT_SUCCESS)
+				success = false;
+		cout << (success ? "initialized (success)" :
+		    "not initialized (FAIL)") << endl;
+		zygoteMgr.disableZygote();
+	} catch (const Error::NotImplemented &) {
+		cout << "not supported on this platform" << endl;
+	} catch (Error::Exception &e) {
+		cout << "caught " << e.whatString() << " (FAIL)" << endl;
+	}
+
+	cout << ">> Testing zygote Workers that orphan children...";
+	Process::ForkManager orphanMgr;
+	std::shared_ptr<Process::WorkerController> orphaning =
+	    orphanMgr.addWorker(std::make_shared<OrphaningWorker>());
+	std::shared_ptr<Process::WorkerController> sleeping =
+	    orphanMgr.addWorker(std::make_shared<SleepingWorker>());
+	try {
+		orphanMgr.enableZygote([]() {});
+		orphanMgr.startWorkers();
+		if ((orphaning->getExitStatus() == EXIT_SUCCESS) &&
+		    (sleeping->getExitStatus() == EXIT_SUCCESS))
+			cout << "orphans ignored (success)" << endl;
+		else
+			cout << "Workers failed (FAIL)" << endl;
+		orphanMgr.disableZygote();
+	} catch (const Error::NotImplemented &) {
+		cout << "not supported on this platform" << endl;
+	} catch (Error::Exception &e) {
+		cout << "caught " << e.whatString() << " (FAIL)" << endl;
+	}
+
+	cout << ">> Testing Workers stopped when others cannot start...";
+	Process::ForkManager partialMgr;
+	std::shared_ptr<Process::WorkerController> started =
+	    partialMgr.addWorker(std::make_shared<StoppableWorker>());
+	try {
+		partialMgr.enableZygote([]() {});
+		/* Workers added after the zygote cannot be forked from it */
+		partialMgr.addWorker(std::make_shared<StoppableWorker>());
+		try {
+			partialMgr.startWorkers(false);
+			cout << "started (FAIL)" << endl;
+		} catch (const Error::StrategyError &) {
+			/* May be signaled before its handler is installed */
+			if ((partialMgr.getNumActiveWorkers() == 0) &&
+			    !started->isWorking())
+				cout << "stopped (success)" << endl;
+			else
+				cout << "still running (FAIL)" << endl;
+		}
+		partialMgr.disableZygote();
+	} catch (const Error::NotImplemented &) {
+		cout << "not supported on this platform" << endl;
+	} catch (Error::Exception &e) {
+		cout << "caught " << e.whatString() << " (FAIL)" << endl;
+	}
+#endif
 	
 	return (0);
 }
@@ -0,0 +1,160 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <be_error_exception.h>
+#include <be_io_recordstore.h>
+#include <be_memory_autoarrayutility.h>
+#include <be_process_forkmanager.h>
+#include <be_process_shareddataset.h>
+
+namespace BE = BiometricEvaluation;
+
+static const std::string rsName("test_shareddataset_rs");
+static const std::string datasetName("test_shareddataset.dat");
+static const uint32_t numRecords = 1000;
+static const uint32_t numWorkers = 4;
+
+static std::string
+valueFor(
+    const uint32_t i)
+{
+	return ("value_" + std::to_string(i) + std::string(i % 97, '*'));
+}
+
+/* Check every record of the dataset against the RecordStore contents */
+static bool
+checkDataset(
+    const BE::Process::SharedDataset &dataset)
+{
+	if (dataset.getCount() != numRecords)
+		return (false);
+	for (uint32_t i = 0; i < numRecords; i++) {
+		const std::string key = "key" + std::to_string(i);
+		const std::string value = valueFor(i);
+		if (!dataset.containsKey(key) ||
+		    (dataset.length(key) != value.size() + 1) ||
+		    (std::string((const char *)dataset.getData(key)) != value))
+			return (false);
+	}
+	return (!dataset.containsKey("key" + std::to_string(numRecords)));
+}
+
+class DatasetWorker : public BE::Process::Worker
+{
+public:
+	int32_t
+	workerMain()
+	{
+		auto dataset = std::static_pointer_cast<
+		    BE::Process::SharedDataset>(this->getParameter("dataset"));
+		return (checkDataset(*dataset) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+};
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	std::shared_ptr<BE::IO::RecordStore> rs;
+	std::cout << "Create RecordStore of " << numRecords << " records: ";
+	try {
+		rs = BE::IO::RecordStore::createRecordStore(rsName, "",
+		    BE::IO::RecordStore::Kind::Default);
+		BE::Memory::uint8Array data;
+		for (uint32_t i = 0; i < numRecords; i++) {
+			BE::Memory::AutoArrayUtility::setString(data,
+			    valueFor(i));
+			rs->insert("key" + std::to_string(i), data);
+		}
+		std::cout << "success." << std::endl;
+	} catch (BE::Error::Exception &e) {
+		std::cout << "FAIL (" << e.whatString() << ")" << std::endl;
+		return (EXIT_FAILURE);
+	}
+
+	int rv = EXIT_SUCCESS;
+	try {
+		std::cout << "Load anonymous SharedDataset: ";
+		auto dataset = std::make_shared<BE::Process::SharedDataset>(rs);
+		if (!checkDataset(*dataset))
+			throw BE::Error::DataError("contents differ");
+		std::cout << "success (" << dataset->getSegmentSize() <<
+		    " bytes)." << std::endl;
+
+		std::cout << "Share with " << numWorkers << " ForkManager "
+		    "Workers: " << std::flush;
+		BE::Process::ForkManager manager;
+		std::vector<std::shared_ptr<BE::Process::WorkerController>>
+		    workers;
+		for (uint32_t i = 0; i < numWorkers; i++) {
+			workers.push_back(manager.addWorker(
+			    std::make_shared<DatasetWorker>()));
+			workers.back()->setParameter("dataset", dataset);
+		}
+		manager.startWorkers(true);
+		for (const auto &worker : workers) {
+			if (worker->getExitStatus() != EXIT_SUCCESS)
+				throw BE::Error::DataError("Worker saw "
+				    "different contents");
+		}
+		std::cout << "success." << std::endl;
+
+		std::cout << "Write SharedDataset file: ";
+		BE::Process::SharedDataset::createFile(datasetName, rs);
+		std::cout << "success." << std::endl;
+
+		std::cout << "Open SharedDataset file: ";
+		BE::Process::SharedDataset file(datasetName);
+		if (!checkDataset(file))
+			throw BE::Error::DataError("contents differ");
+		std::cout << "success." << std::endl;
+
+		std::cout << "Keys are sorted: ";
+		for (uint64_t i = 1; i < file.getCount(); i++)
+			if (file.getKey(i - 1) >= file.getKey(i))
+				throw BE::Error::DataError(file.getKey(i));
+		std::cout << "success." << std::endl;
+
+		std::cout << "Open file with corrupt index: ";
+		{
+			/* First IndexEntry::dataLength, after the Header */
+			std::fstream corrupt(datasetName, std::ios::in |
+			    std::ios::out | std::ios::binary);
+			const uint64_t dataLength = UINT64_MAX - 16;
+			corrupt.seekp(64 + 24);
+			corrupt.write((const char *)&dataLength,
+			    sizeof(dataLength));
+		}
+		try {
+			BE::Process::SharedDataset corrupt(datasetName);
+			throw BE::Error::StrategyError("opened");
+		} catch (BE::Error::DataError&) {
+			std::cout << "success." << std::endl;
+		}
+	} catch (BE::Error::Exception &e) {
+		std::cout << "FAIL (" << e.whatString() << ")" << std::endl;
+		rv = EXIT_FAILURE;
+	}
+
+	unlink(datasetName.c_str());
+	rs.reset();
+	BE::IO::RecordStore::removeRecordStore(rsName);
+	return (rv);
+}
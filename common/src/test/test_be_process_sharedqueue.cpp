@@ -0,0 +1,226 @@
+/*
+ * This software was developed at the National Institute of Standards and
+ * Technology (NIST) by employees of the Federal Government in the course
+ * of their official duties. Pursuant to title 17 Section 105 of the
+ * United States Code, this software is not subject to copyright protection
+ * and is in the public domain. NIST assumes no responsibility whatsoever for
+ * its use by other parties, and makes no guarantees, expressed or implied,
+ * about its quality, reliability, or any other characteristic.
+ */
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <be_error.h>
+#include <be_error_exception.h>
+#include <be_process_sharedqueue.h>
+
+namespace BE = BiometricEvaluation;
+
+static const std::string queueName("/be_sharedqueue_test");
+static const uint32_t numProducers = 4;
+static const uint32_t numMessages = 10000;
+static const uint64_t maxMessageSize = 256;
+
+/*
+ * Each message is the producer number followed by a variable amount of
+ * copies of the low byte of the message number.
+ */
+static int
+producerFunction(
+    BE::Process::SharedQueue &queue,
+    uint8_t producer)
+{
+	BE::Memory::uint8Array message(maxMessageSize);
+	for (uint32_t i = 0; i < numMessages; i++) {
+		message.resize(2 + (i % (maxMessageSize - 2)));
+		message[0] = producer;
+		for (uint64_t j = 1; j < message.size(); j++)
+			message[j] = i & 0xFF;
+		if (!queue.push(message, false))
+			return (EXIT_FAILURE);
+	}
+	return (EXIT_SUCCESS);
+}
+
+static bool
+testEmpty(
+    BE::Process::SharedQueue &queue)
+{
+	BE::Memory::uint8Array message;
+	std::cout << "tryPop() on empty queue: ";
+	if (queue.tryPop(message)) {
+		std::cout << "FAIL (returned a message)" << std::endl;
+		return (false);
+	}
+	std::cout << "success." << std::endl;
+
+	std::cout << "timedPop() on empty queue: ";
+	if (queue.timedPop(message, 250000, false)) {
+		std::cout << "FAIL (returned a message)" << std::endl;
+		return (false);
+	}
+	std::cout << "success." << std::endl;
+
+	std::cout << "push() of oversized message: ";
+	try {
+		BE::Memory::uint8Array big(queue.maxMessageSize() + 1);
+		queue.push(big, false);
+		std::cout << "FAIL (no exception)" << std::endl;
+		return (false);
+	} catch (BE::Error::ParameterError &e) {
+		std::cout << "success (" << e.whatString() << ")." << std::endl;
+	}
+	return (true);
+}
+
+static bool
+testFull(
+    BE::Process::SharedQueue &queue)
+{
+	const uint8_t byte = 0;
+	std::cout << "Fill queue to capacity: ";
+	for (uint32_t i = 0; i < queue.capacity(); i++) {
+		if (!queue.tryPush(&byte, 1)) {
+			std::cout << "FAIL (full after " << i << ")" <<
+			    std::endl;
+			return (false);
+		}
+	}
+	if (queue.tryPush(&byte, 1) ||
+	    queue.timedPush(&byte, 1, 250000, false)) {
+		std::cout << "FAIL (pushed past capacity)" << std::endl;
+		return (false);
+	}
+	std::cout << "success (" << queue.size() << " messages)." << std::endl;
+
+	std::cout << "Drain queue: ";
+	BE::Memory::uint8Array message;
+	while (queue.tryPop(message));
+	if (queue.size() != 0) {
+		std::cout << "FAIL (" << queue.size() << " remaining)" <<
+		    std::endl;
+		return (false);
+	}
+	std::cout << "success." << std::endl;
+	return (true);
+}
+
+static bool
+testProducersConsumer(
+    BE::Process::SharedQueue &queue)
+{
+	std::cout << "Receive " << numProducers * numMessages << " messages "
+	    "from " << numProducers << " processes: " << std::flush;
+
+	std::vector<pid_t> children;
+	for (uint8_t p = 0; p < numProducers; p++) {
+		pid_t pid = fork();
+		switch (pid) {
+		case 0:
+			std::exit(producerFunction(queue, p));
+		case -1:
+			std::cout << "FAIL (fork: " << BE::Error::errorStr() <<
+			    ")" << std::endl;
+			return (false);
+		default:
+			children.push_back(pid);
+		}
+	}
+
+	/* Messages from each producer must arrive in order */
+	std::vector<uint32_t> expected(numProducers, 0);
+	BE::Memory::uint8Array message;
+	bool success = true;
+	for (uint32_t i = 0; i < numProducers * numMessages; i++) {
+		if (!queue.pop(message, false)) {
+			std::cout << "FAIL (pop)" << std::endl;
+			success = false;
+			break;
+		}
+		const uint8_t p = message[0];
+		if ((p >= numProducers) || (message.size() != 2 +
+		    (expected[p] % (maxMessageSize - 2)))) {
+			std::cout << "FAIL (message " << i << " malformed)" <<
+			    std::endl;
+			success = false;
+			break;
+		}
+		const uint32_t n = expected[p]++;
+		for (uint64_t j = 1; j < message.size(); j++) {
+			if (message[j] != (n & 0xFF)) {
+				std::cout << "FAIL (message " << i <<
+				    " corrupt)" << std::endl;
+				success = false;
+				break;
+			}
+		}
+		if (!success)
+			break;
+	}
+
+	int status;
+	for (const auto &pid : children) {
+		waitpid(pid, &status, 0);
+		if (!WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS))
+			success = false;
+	}
+	if (success)
+		std::cout << "success." << std::endl;
+	return (success);
+}
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+	std::cout << "Create anonymous queue: ";
+	std::unique_ptr<BE::Process::SharedQueue> queue;
+	try {
+		queue.reset(new BE::Process::SharedQueue(8, maxMessageSize));
+		std::cout << "success." << std::endl;
+	} catch (BE::Error::Exception &e) {
+		std::cout << "FAIL (" << e.whatString() << ")" << std::endl;
+		return (EXIT_FAILURE);
+	}
+	if (!testEmpty(*queue) || !testFull(*queue) ||
+	    !testProducersConsumer(*queue))
+		return (EXIT_FAILURE);
+
+	std::cout << "Create named queue: ";
+	std::unique_ptr<BE::Process::SharedQueue> named;
+	try {
+		named.reset(new BE::Process::SharedQueue(queueName,
+		    S_IRUSR | S_IWUSR, 4, 16, true));
+		std::cout << "success." << std::endl;
+	} catch (BE::Error::Exception &e) {
+		std::cout << "FAIL (" << e.whatString() << ")" << std::endl;
+		return (EXIT_FAILURE);
+	}
+	std::cout << "Open named queue: ";
+	try {
+		BE::Process::SharedQueue opened(queueName);
+		const uint8_t hello[] = "hello";
+		opened.push(hello, sizeof(hello), false);
+		BE::Memory::uint8Array message;
+		if (!named->tryPop(message) || (message.size() != sizeof(hello))
+		    || (std::string((char *)&message[0]) != "hello")) {
+			std::cout << "FAIL (message not shared)" << std::endl;
+			return (EXIT_FAILURE);
+		}
+		std::cout << "success." << std::endl;
+	} catch (BE::Error::Exception &e) {
+		std::cout << "FAIL (" << e.whatString() << ")" << std::endl;
+		return (EXIT_FAILURE);
+	}
+
+	return (EXIT_SUCCESS);
+}
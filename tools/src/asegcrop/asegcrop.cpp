@@ -174,19 +174,17 @@ cropSingleASEG(
 		    std::to_string(minX) + "," + std::to_string(minY) + ") (" +
 		    std::to_string(maxX) + "," + std::to_string(maxY) + ")]");
 
-	const auto originalRawData = capture.getImage()->getRawData();
-	BE::Memory::uint8Array data((maxY - minY) * (maxX - minX));
+	/* Decode only the bounding box */
+	BE::Memory::uint8Array data = capture.getImage()->getRawData(
+	    {minX, minY}, {maxX - minX, maxY - minY});
 
-	/* Extract raw pixels */
+	/* Whiten pixels outside of the segment */
 	uint64_t croppedOffset = 0;
 	for (uint32_t row = minY; row < maxY; ++row) {
 		for (uint32_t col = minX; col < maxX; ++col) {
-			if (pointInPolygon({col, row}, segs))
-				data[croppedOffset++] =
-				    originalRawData[col +
-				    (row * dimensions.xSize)];
-			else
-				data[croppedOffset++] = 0xFF;
+			if (!pointInPolygon({col, row}, segs))
+				data[croppedOffset] = 0xFF;
+			croppedOffset++;
 		}
 	}
 